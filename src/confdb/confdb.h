@@ -54,6 +54,8 @@
 #define CONFDB_SERVICE_DEBUG_TIMESTAMPS "debug_timestamps"
 #define CONFDB_SERVICE_DEBUG_MICROSECONDS "debug_microseconds"
 #define CONFDB_SERVICE_DEBUG_TO_FILES "debug_to_files"
+#define CONFDB_SERVICE_DEBUG_BUFFER_SIZE "debug_buffer_size"
+#define CONFDB_SERVICE_DEBUG_BUFFER_LEVEL "debug_buffer_level"
 #define CONFDB_SERVICE_TIMEOUT "timeout"
 #define CONFDB_SERVICE_FORCE_TIMEOUT "force_timeout"
 #define CONFDB_SERVICE_RECON_RETRIES "reconnection_retries"
@@ -81,6 +83,10 @@
 #define CONFDB_RESPONDER_GET_DOMAINS_TIMEOUT "get_domains_timeout"
 #define CONFDB_RESPONDER_CLI_IDLE_TIMEOUT "client_idle_timeout"
 #define CONFDB_RESPONDER_CLI_IDLE_DEFAULT_TIMEOUT 60
+#define CONFDB_RESPONDER_LRU_SIZE "responder_lru_size"
+#define CONFDB_RESPONDER_LRU_DEFAULT_SIZE 1000
+#define CONFDB_RESPONDER_LRU_TIMEOUT "responder_lru_timeout"
+#define CONFDB_RESPONDER_LRU_DEFAULT_TIMEOUT 5
 
 /* NSS */
 #define CONFDB_NSS_CONF_ENTRY "config/nss"
@@ -99,7 +105,12 @@
 #define CONFDB_NSS_SHELL_FALLBACK "shell_fallback"
 #define CONFDB_NSS_DEFAULT_SHELL "default_shell"
 #define CONFDB_MEMCACHE_TIMEOUT "memcache_timeout"
+#define CONFDB_NSS_MEMCACHE_SIZE_PASSWD "memcache_size_passwd"
+#define CONFDB_NSS_MEMCACHE_SIZE_GROUP "memcache_size_group"
+#define CONFDB_NSS_MEMCACHE_SIZE_SID "memcache_size_sid"
 #define CONFDB_NSS_HOMEDIR_SUBSTRING "homedir_substring"
+#define CONFDB_NSS_WORKERS "workers"
+#define CONFDB_NSS_DEFAULT_WORKERS 1
 #define CONFDB_DEFAULT_HOMEDIR_SUBSTRING "/home"
 
 /* PAM */
@@ -109,6 +120,8 @@
 #define CONFDB_DEFAULT_PAM_FAILED_LOGIN_ATTEMPTS 0
 #define CONFDB_PAM_FAILED_LOGIN_DELAY "offline_failed_login_delay"
 #define CONFDB_DEFAULT_PAM_FAILED_LOGIN_DELAY 5
+#define CONFDB_PAM_VERIFIER_TIMEOUT "offline_auth_verifier_timeout"
+#define CONFDB_DEFAULT_PAM_VERIFIER_TIMEOUT 0
 #define CONFDB_PAM_VERBOSITY "pam_verbosity"
 #define CONFDB_PAM_ID_TIMEOUT "pam_id_timeout"
 #define CONFDB_PAM_PWD_EXPIRATION_WARNING "pam_pwd_expiration_warning"
@@ -162,6 +175,8 @@
 #define CONFDB_DOMAIN_MINID "min_id"
 #define CONFDB_DOMAIN_MAXID "max_id"
 #define CONFDB_DOMAIN_CACHE_CREDS "cache_credentials"
+#define CONFDB_DOMAIN_CACHE_CREDS_ROUNDS "cache_credentials_hash_rounds"
+#define CONFDB_DEFAULT_CACHE_CREDS_ROUNDS 5000
 #define CONFDB_DOMAIN_LEGACY_PASS "store_legacy_passwords"
 #define CONFDB_DOMAIN_MPG "magic_private_groups"
 #define CONFDB_DOMAIN_FQ "use_fully_qualified_names"
@@ -185,6 +200,8 @@
 #define CONFDB_DOMAIN_REFRESH_EXPIRED_INTERVAL "refresh_expired_interval"
 #define CONFDB_DOMAIN_OFFLINE_TIMEOUT "offline_timeout"
 #define CONFDB_DOMAIN_SUBDOMAIN_INHERIT "subdomain_inherit"
+#define CONFDB_DOMAIN_DP_FAST_PATH "dp_fast_path"
+#define CONFDB_DOMAIN_CACHE_SNAPSHOT_INTERVAL "cache_snapshot_interval"
 
 /* Local Provider */
 #define CONFDB_LOCAL_DEFAULT_SHELL   "default_shell"
@@ -222,6 +239,7 @@ struct sss_domain_info {
     uint32_t id_max;
 
     bool cache_credentials;
+    uint32_t cache_credentials_rounds;
     bool legacy_passwords;
     bool case_sensitive;
     bool case_preserve;
@@ -286,10 +286,14 @@ class SSSDConfigTestSSSDService(unittest.TestCase):
             'debug_timestamps',
             'debug_microseconds',
             'debug_to_files',
+            'debug_buffer_size',
+            'debug_buffer_level',
             'command',
             'reconnection_retries',
             'fd_limit',
             'client_idle_timeout',
+            'responder_lru_size',
+            'responder_lru_timeout',
             'description']
 
         self.assertTrue(type(options) == dict,
@@ -494,6 +498,7 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'command',
             'enumerate',
             'cache_credentials',
+            'cache_credentials_hash_rounds',
             'store_legacy_passwords',
             'use_fully_qualified_names',
             'ignore_group_members',
@@ -508,10 +513,14 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'entry_cache_sudo_timeout',
             'entry_cache_ssh_host_timeout',
             'refresh_expired_interval',
+            'dp_fast_path',
+            'cache_snapshot_interval',
             'lookup_family_order',
             'account_cache_expiration',
             'dns_resolver_timeout',
             'dns_discovery_domain',
+            'failover_policy',
+            'failover_probe_interval',
             'dyndns_update',
             'dyndns_ttl',
             'dyndns_iface',
@@ -856,6 +865,7 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'command',
             'enumerate',
             'cache_credentials',
+            'cache_credentials_hash_rounds',
             'store_legacy_passwords',
             'use_fully_qualified_names',
             'ignore_group_members',
@@ -870,10 +880,14 @@ class SSSDConfigTestSSSDDomain(unittest.TestCase):
             'entry_cache_sudo_timeout',
             'entry_cache_ssh_host_timeout',
             'refresh_expired_interval',
+            'dp_fast_path',
+            'cache_snapshot_interval',
             'account_cache_expiration',
             'lookup_family_order',
             'dns_resolver_timeout',
             'dns_discovery_domain',
+            'failover_policy',
+            'failover_probe_interval',
             'dyndns_update',
             'dyndns_ttl',
             'dyndns_iface',
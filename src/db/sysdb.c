@@ -23,9 +23,11 @@
 #include "util/util.h"
 #include "util/strtonum.h"
 #include "util/sss_utf8.h"
+#include "util/sss_stats.h"
 #include "db/sysdb_private.h"
 #include "confdb/confdb.h"
 #include <time.h>
+#include <sys/time.h>
 
 #define LDB_MODULES_PATH "LDB_MODULES_PATH"
 
@@ -886,6 +888,11 @@ int sysdb_transaction_start(struct sysdb_ctx *sysdb)
     if (ret != LDB_SUCCESS) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Failed to start ldb transaction! (%d)\n", ret);
+    } else {
+        sysdb->transaction_nesting++;
+        if (sysdb->transaction_nesting == 1) {
+            sysdb_snapshot_begin(sysdb);
+        }
     }
     return sysdb_error_to_errno(ret);
 }
@@ -894,10 +901,32 @@ int sysdb_transaction_commit(struct sysdb_ctx *sysdb)
 {
     int ret;
 
+    /* ldb finishes the transaction even if the commit fails */
+    sysdb->transaction_nesting--;
+
+    if (sysdb->transaction_nesting == 0) {
+        ret = sysdb_members_index_commit(sysdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to record the change of the groups, "
+                  "cancelling the transaction\n");
+            ldb_transaction_cancel(sysdb->ldb);
+            sysdb_snapshot_finish(sysdb, false);
+            return ret;
+        }
+
+        sysdb_snapshot_commit(sysdb);
+    }
+
     ret = ldb_transaction_commit(sysdb->ldb);
     if (ret != LDB_SUCCESS) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Failed to commit ldb transaction! (%d)\n", ret);
+        sysdb_members_index_invalidate(sysdb);
+    }
+
+    if (sysdb->transaction_nesting == 0) {
+        sysdb_snapshot_finish(sysdb, ret == LDB_SUCCESS);
     }
     return sysdb_error_to_errno(ret);
 }
@@ -906,14 +935,340 @@ int sysdb_transaction_cancel(struct sysdb_ctx *sysdb)
 {
     int ret;
 
+    sysdb->transaction_nesting--;
+
+    sysdb_members_index_cancel(sysdb);
+
     ret = ldb_transaction_cancel(sysdb->ldb);
     if (ret != LDB_SUCCESS) {
         DEBUG(SSSDBG_CRIT_FAILURE,
               "Failed to cancel ldb transaction! (%d)\n", ret);
     }
+
+    if (sysdb->transaction_nesting == 0) {
+        sysdb_snapshot_finish(sysdb, false);
+    }
     return sysdb_error_to_errno(ret);
 }
 
+/* =Write-batches========================================================= */
+
+#define SYSDB_BATCH_MIN_SIZE 16
+#define SYSDB_BATCH_MAX_SIZE 8192
+#define SYSDB_BATCH_INITIAL_SIZE 64
+
+struct sysdb_batch {
+    struct sysdb_ctx *sysdb;
+    uint32_t max_msec;
+
+    /* a transaction of the caller is open, do not commit in between */
+    bool nested;
+    bool in_transaction;
+    struct timeval start;
+
+    size_t size;
+    size_t pending;
+    size_t written;
+};
+
+static int sysdb_batch_destructor(struct sysdb_batch *batch)
+{
+    if (batch->in_transaction) {
+        sysdb_transaction_cancel(batch->sysdb);
+        batch->in_transaction = false;
+    }
+
+    return 0;
+}
+
+errno_t sysdb_batch_create(TALLOC_CTX *mem_ctx,
+                           struct sysdb_ctx *sysdb,
+                           uint32_t max_msec,
+                           struct sysdb_batch **_batch)
+{
+    struct sysdb_batch *batch;
+
+    batch = talloc_zero(mem_ctx, struct sysdb_batch);
+    if (batch == NULL) {
+        return ENOMEM;
+    }
+
+    batch->sysdb = sysdb;
+    batch->max_msec = max_msec;
+    batch->nested = sysdb->transaction_nesting > 0;
+    batch->size = SYSDB_BATCH_INITIAL_SIZE;
+
+    talloc_set_destructor(batch, sysdb_batch_destructor);
+
+    *_batch = batch;
+    return EOK;
+}
+
+static uint64_t sysdb_batch_elapsed_usec(struct sysdb_batch *batch)
+{
+    struct timeval now;
+    int64_t usec;
+
+    gettimeofday(&now, NULL);
+    usec = (now.tv_sec - batch->start.tv_sec) * 1000000LL
+           + (now.tv_usec - batch->start.tv_usec);
+
+    /* the clock was set back */
+    return usec < 0 ? 0 : usec;
+}
+
+errno_t sysdb_batch_begin(struct sysdb_batch *batch)
+{
+    errno_t ret;
+
+    if (batch->in_transaction) {
+        return EOK;
+    }
+
+    ret = sysdb_transaction_start(batch->sysdb);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    batch->in_transaction = true;
+    batch->pending = 0;
+    gettimeofday(&batch->start, NULL);
+
+    return EOK;
+}
+
+/* Sizes the next transaction so that it takes about max_msec, based on the
+ * time per entry measured in the last one. The change is damped to
+ * smooth out single slow commits. */
+static void sysdb_batch_resize(struct sysdb_batch *batch, uint64_t usec)
+{
+    uint64_t per_entry;
+    uint64_t size;
+
+    if (batch->pending == 0) {
+        return;
+    }
+
+    per_entry = usec / batch->pending;
+    if (per_entry == 0) {
+        per_entry = 1;
+    }
+
+    size = (batch->max_msec * 1000ULL) / per_entry;
+    size = (size + batch->size) / 2;
+
+    if (size < SYSDB_BATCH_MIN_SIZE) {
+        size = SYSDB_BATCH_MIN_SIZE;
+    } else if (size > SYSDB_BATCH_MAX_SIZE) {
+        size = SYSDB_BATCH_MAX_SIZE;
+    }
+
+    batch->size = size;
+}
+
+errno_t sysdb_batch_commit(struct sysdb_batch *batch)
+{
+    uint64_t usec;
+    errno_t ret;
+
+    if (!batch->in_transaction) {
+        return EOK;
+    }
+
+    batch->in_transaction = false;
+    ret = sysdb_transaction_commit(batch->sysdb);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    usec = sysdb_batch_elapsed_usec(batch);
+    sss_stats_record("sysdb.batch.transaction", usec);
+
+    DEBUG(SSSDBG_TRACE_INTERNAL,
+          "Committed %zu entries in %"PRIu64" us\n", batch->pending, usec);
+
+    sysdb_batch_resize(batch, usec);
+    batch->written += batch->pending;
+    batch->pending = 0;
+
+    return EOK;
+}
+
+errno_t sysdb_batch_next(struct sysdb_batch *batch, bool *_committed)
+{
+    errno_t ret;
+    bool full;
+
+    if (_committed != NULL) {
+        *_committed = false;
+    }
+
+    batch->pending++;
+
+    if (batch->nested || batch->max_msec == 0) {
+        return EOK;
+    }
+
+    full = batch->pending >= batch->size
+            || sysdb_batch_elapsed_usec(batch) >= batch->max_msec * 1000ULL;
+    if (!full) {
+        return EOK;
+    }
+
+    ret = sysdb_batch_commit(batch);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (_committed != NULL) {
+        *_committed = true;
+    }
+
+    return EOK;
+}
+
+size_t sysdb_batch_written(struct sysdb_batch *batch)
+{
+    return batch->written;
+}
+
+size_t sysdb_batch_size(struct sysdb_batch *batch)
+{
+    return batch->size;
+}
+
+errno_t sysdb_batch_write(struct sysdb_batch *batch, size_t count,
+                          sysdb_batch_write_fn fn, void *pvt)
+{
+    errno_t ret;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        ret = sysdb_batch_begin(batch);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        ret = fn(i, pvt);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        ret = sysdb_batch_next(batch, NULL);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return sysdb_batch_commit(batch);
+}
+
+struct sysdb_batch_write_state {
+    struct tevent_context *ev;
+    struct sysdb_batch *batch;
+    size_t count;
+    size_t next;
+    sysdb_batch_write_fn fn;
+    void *pvt;
+};
+
+static void sysdb_batch_write_step(struct tevent_context *ev,
+                                   struct tevent_timer *te,
+                                   struct timeval tv,
+                                   void *pvt);
+
+struct tevent_req *sysdb_batch_write_send(TALLOC_CTX *mem_ctx,
+                                          struct tevent_context *ev,
+                                          struct sysdb_batch *batch,
+                                          size_t count,
+                                          sysdb_batch_write_fn fn,
+                                          void *pvt)
+{
+    struct sysdb_batch_write_state *state;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state, struct sysdb_batch_write_state);
+    if (req == NULL) {
+        return NULL;
+    }
+
+    state->ev = ev;
+    state->batch = batch;
+    state->count = count;
+    state->fn = fn;
+    state->pvt = pvt;
+
+    /* the first transaction is written right away */
+    sysdb_batch_write_step(ev, NULL, tevent_timeval_zero(), req);
+    if (tevent_req_is_in_progress(req) == false) {
+        tevent_req_post(req, ev);
+    }
+
+    return req;
+}
+
+static void sysdb_batch_write_step(struct tevent_context *ev,
+                                   struct tevent_timer *te,
+                                   struct timeval tv,
+                                   void *pvt)
+{
+    struct sysdb_batch_write_state *state;
+    struct tevent_req *req;
+    struct tevent_timer *timer;
+    bool committed = false;
+    errno_t ret;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct sysdb_batch_write_state);
+
+    while (state->next < state->count && !committed) {
+        ret = sysdb_batch_begin(state->batch);
+        if (ret != EOK) {
+            goto fail;
+        }
+
+        ret = state->fn(state->next, state->pvt);
+        if (ret != EOK) {
+            goto fail;
+        }
+        state->next++;
+
+        ret = sysdb_batch_next(state->batch, &committed);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
+    if (state->next < state->count) {
+        /* let the other requests run before the next transaction */
+        timer = tevent_add_timer(state->ev, state, tevent_timeval_zero(),
+                                 sysdb_batch_write_step, req);
+        if (timer == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+        return;
+    }
+
+    ret = sysdb_batch_commit(state->batch);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    tevent_req_done(req);
+    return;
+
+fail:
+    tevent_req_error(req, ret);
+}
+
+errno_t sysdb_batch_write_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
 /* =Initialization======================================================== */
 
 int sysdb_get_db_file(TALLOC_CTX *mem_ctx,
@@ -421,6 +421,76 @@ int sysdb_transaction_start(struct sysdb_ctx *sysdb);
 int sysdb_transaction_commit(struct sysdb_ctx *sysdb);
 int sysdb_transaction_cancel(struct sysdb_ctx *sysdb);
 
+/* Write batches
+ *
+ * Storing a large result in one transaction holds the cache write lock for
+ * the whole time, storing each entry in its own transaction pays for a
+ * commit per entry. A write batch commits after as many entries as can be
+ * written within max_msec milliseconds, the number is adjusted after every
+ * commit according to the measured time. If max_msec is 0 or a transaction
+ * was already started by the caller, nothing is committed until
+ * sysdb_batch_commit(). Freeing the batch cancels the open transaction. */
+struct sysdb_batch;
+
+errno_t sysdb_batch_create(TALLOC_CTX *mem_ctx,
+                           struct sysdb_ctx *sysdb,
+                           uint32_t max_msec,
+                           struct sysdb_batch **_batch);
+
+/* Starts a transaction if none is open */
+errno_t sysdb_batch_begin(struct sysdb_batch *batch);
+
+/* Counts an entry written within the batch and commits the transaction if
+ * the batch is full. */
+errno_t sysdb_batch_next(struct sysdb_batch *batch, bool *_committed);
+
+errno_t sysdb_batch_commit(struct sysdb_batch *batch);
+
+/* Number of entries written in the transactions committed so far */
+size_t sysdb_batch_written(struct sysdb_batch *batch);
+
+/* Number of entries the next transaction may contain */
+size_t sysdb_batch_size(struct sysdb_batch *batch);
+
+/* Writes one entry, errors returned from the function abort the batch */
+typedef errno_t (*sysdb_batch_write_fn)(size_t idx, void *pvt);
+
+/* Calls fn for the entries 0..count-1 and commits at the end */
+errno_t sysdb_batch_write(struct sysdb_batch *batch, size_t count,
+                          sysdb_batch_write_fn fn, void *pvt);
+
+/* The same as sysdb_batch_write() but returns to the main loop after
+ * every commit */
+struct tevent_req *sysdb_batch_write_send(TALLOC_CTX *mem_ctx,
+                                          struct tevent_context *ev,
+                                          struct sysdb_batch *batch,
+                                          size_t count,
+                                          sysdb_batch_write_fn fn,
+                                          void *pvt);
+
+errno_t sysdb_batch_write_recv(struct tevent_req *req);
+
+/* Read-only snapshot of the cache
+ *
+ * The back end writes the users and groups of the cache into a snapshot
+ * file which the responders map into memory. sysdb_getpwnam(),
+ * sysdb_getpwuid(), sysdb_getgrnam(), sysdb_getgrgid() and
+ * sysdb_initgroups() answer from the snapshot for the entries which were
+ * not modified since it was written. */
+
+/* Writes a new snapshot if the cache changed since the last one. Returns
+ * EAGAIN if the cache was modified while it was read. */
+errno_t sysdb_snapshot_update(struct sysdb_ctx *sysdb, bool *_written);
+
+errno_t sysdb_snapshot_remove(struct sysdb_ctx *sysdb);
+
+/* Called after this process committed a transaction which modified the
+ * cache, so that the snapshot can be rewritten. fn may be NULL. */
+typedef void (*sysdb_snapshot_changed_fn)(void *pvt);
+errno_t sysdb_snapshot_set_changed_cb(struct sysdb_ctx *sysdb,
+                                      sysdb_snapshot_changed_fn fn,
+                                      void *pvt);
+
 /* functions related to subdomains */
 errno_t sysdb_domain_create(struct sysdb_ctx *sysdb, const char *domain_name);
 
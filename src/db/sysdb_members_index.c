@@ -0,0 +1,978 @@
+/*
+    SSSD
+
+    System Database - index of the transitive group memberships
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dhash.h>
+
+#include "util/util.h"
+#include "util/dlinklist.h"
+#include "util/sss_stats.h"
+#include "db/sysdb_private.h"
+
+/* sysdb_initgroups() reads the memberOf attribute of the user, which the
+ * memberof plugin keeps up to date on every write, and looks up every
+ * group listed there.
+ *
+ * The index is a read-side cache for sysdb_initgroups() only. It does not
+ * replace memberOf: the memberof plugin still walks the ancestors and
+ * descendants of a group on every write, and the other readers of
+ * memberOf, memberuid and ghost are unchanged. Keeping the index current
+ * adds a little to the writes, see below.
+ *
+ * The index keeps the graph of the direct memberships of all groups in
+ * the cache in memory instead: the groups every group is a direct member
+ * of and the groups every user is a direct member of, both taken from the
+ * member attribute of the groups. The transitive closure of the groups of
+ * a user is computed the first time it is needed and kept as a bitset
+ * over the groups, for the most recently used users only, up to
+ * MI_CLOSURE_BUDGET bytes. The groups are kept with the attributes
+ * returned by sysdb_initgroups(), so a lookup does not need to read them
+ * from ldb. The timestamps of the groups are not tracked, they may be
+ * older than the ones in the cache.
+ *
+ * Every transaction which adds, deletes or changes a group, or deletes a
+ * user, increments the MI_GROUPS_SEQ attribute of the cache base entry,
+ * see sysdb_members_index_changed(). This one modification per
+ * transaction, and a transaction of its own for such a write done outside
+ * of one, is what the index costs the writers. The index belongs to the
+ * value it was built from, other writes do not make it out of date.
+ * Members added or removed with sysdb_mod_group_member() in this process
+ * are applied to the graph and to the computed closures as they are
+ * written. Any other change of the groups makes the index out of date, it
+ * is then built again by the next lookup, but not more often than every
+ * MI_REBUILD_INTERVAL seconds. Until then the lookups use memberOf.
+ */
+
+#define MI_REBUILD_INTERVAL 5
+#define MI_CLOSURE_BUDGET (16 * 1024 * 1024)
+
+#define MI_GROUPS_SEQ "groupsSequence"
+
+#define MI_WORD_BITS 64
+#define MI_WORDS(bits) (((bits) + MI_WORD_BITS - 1) / MI_WORD_BITS)
+
+struct mi_group {
+    struct ldb_message *msg;
+
+    /* groups this group is a direct member of */
+    size_t *parents;
+    size_t num_parents;
+};
+
+struct mi_user {
+    struct mi_user *prev;
+    struct mi_user *next;
+
+    /* groups this user is a direct member of */
+    size_t *groups;
+    size_t num_groups;
+
+    /* all groups of the user, NULL if not computed yet */
+    uint64_t *closure;
+};
+
+struct mi_graph {
+    struct mi_group *groups;
+    size_t num_groups;
+
+    /* casefolded DN of a group -> index of the group */
+    hash_table_t *group_idx;
+    /* casefolded DN of a user -> struct mi_user */
+    hash_table_t *users;
+
+    /* users with a computed closure, the most recently used first */
+    struct mi_user *closures;
+    struct mi_user *closures_tail;
+    size_t num_closures;
+
+    /* scratch space for walking the graph */
+    size_t *stack;
+};
+
+struct sysdb_members_index {
+    struct mi_graph *graph;
+    uint64_t seqnum;
+    uint64_t groups_seq;
+    time_t last_build;
+
+    /* the groups were changed in the current transaction */
+    bool changed;
+    /* the graph contains changes of the current transaction */
+    bool applied;
+};
+
+/* Attributes of the groups the index depends on */
+static const char *mi_group_attrs[] = { SYSDB_MEMBER, SYSDB_NAME,
+                                        SYSDB_GIDNUM, SYSDB_POSIX,
+                                        SYSDB_OBJECTCLASS, SYSDB_ORIG_DN,
+                                        SYSDB_SID_STR, SYSDB_OVERRIDE_DN,
+                                        NULL };
+
+static inline bool mi_bit_test(const uint64_t *set, size_t bit)
+{
+    return (set[bit / MI_WORD_BITS] & (UINT64_C(1) << (bit % MI_WORD_BITS)))
+            != 0;
+}
+
+static inline void mi_bit_set(uint64_t *set, size_t bit)
+{
+    set[bit / MI_WORD_BITS] |= UINT64_C(1) << (bit % MI_WORD_BITS);
+}
+
+static const char *mi_dn_key(struct ldb_dn *dn)
+{
+    if (dn == NULL) {
+        return NULL;
+    }
+
+    return ldb_dn_get_casefold(dn);
+}
+
+static bool mi_group_idx(struct mi_graph *graph, const char *key,
+                         size_t *_idx)
+{
+    hash_key_t hkey;
+    hash_value_t value;
+
+    if (key == NULL) {
+        return false;
+    }
+
+    hkey.type = HASH_KEY_STRING;
+    hkey.str = discard_const(key);
+    if (hash_lookup(graph->group_idx, &hkey, &value) != HASH_SUCCESS) {
+        return false;
+    }
+
+    *_idx = value.ul;
+    return true;
+}
+
+static errno_t mi_user_get(struct mi_graph *graph, const char *key,
+                           bool create, struct mi_user **_user)
+{
+    struct mi_user *user;
+    hash_key_t hkey;
+    hash_value_t value;
+    int hret;
+
+    if (key == NULL) {
+        return EINVAL;
+    }
+
+    hkey.type = HASH_KEY_STRING;
+    hkey.str = discard_const(key);
+    hret = hash_lookup(graph->users, &hkey, &value);
+    if (hret == HASH_SUCCESS) {
+        *_user = talloc_get_type(value.ptr, struct mi_user);
+        return EOK;
+    } else if (hret != HASH_ERROR_KEY_NOT_FOUND) {
+        return EIO;
+    }
+
+    if (!create) {
+        return ENOENT;
+    }
+
+    user = talloc_zero(graph, struct mi_user);
+    if (user == NULL) {
+        return ENOMEM;
+    }
+
+    value.type = HASH_VALUE_PTR;
+    value.ptr = user;
+    if (hash_enter(graph->users, &hkey, &value) != HASH_SUCCESS) {
+        talloc_free(user);
+        return ENOMEM;
+    }
+
+    *_user = user;
+    return EOK;
+}
+
+static errno_t mi_idx_add(TALLOC_CTX *mem_ctx, size_t **_list, size_t *_num,
+                          size_t idx)
+{
+    size_t *list;
+    size_t i;
+
+    for (i = 0; i < *_num; i++) {
+        if ((*_list)[i] == idx) {
+            return EOK;
+        }
+    }
+
+    list = talloc_realloc(mem_ctx, *_list, size_t, *_num + 1);
+    if (list == NULL) {
+        return ENOMEM;
+    }
+
+    list[*_num] = idx;
+    *_list = list;
+    (*_num)++;
+    return EOK;
+}
+
+static void mi_idx_del(size_t *list, size_t *_num, size_t idx)
+{
+    size_t i;
+
+    for (i = 0; i < *_num; i++) {
+        if (list[i] == idx) {
+            list[i] = list[*_num - 1];
+            (*_num)--;
+            return;
+        }
+    }
+}
+
+/* Add the group and all groups it is a member of to the closure */
+static void mi_closure_add(struct mi_graph *graph, uint64_t *closure,
+                           size_t idx)
+{
+    struct mi_group *group;
+    size_t top = 0;
+    size_t i;
+
+    if (mi_bit_test(closure, idx)) {
+        return;
+    }
+
+    /* every group is pushed at most once, so the stack cannot overflow */
+    mi_bit_set(closure, idx);
+    graph->stack[top++] = idx;
+
+    while (top > 0) {
+        group = &graph->groups[graph->stack[--top]];
+
+        for (i = 0; i < group->num_parents; i++) {
+            if (!mi_bit_test(closure, group->parents[i])) {
+                mi_bit_set(closure, group->parents[i]);
+                graph->stack[top++] = group->parents[i];
+            }
+        }
+    }
+}
+
+static void mi_closure_unlink(struct mi_graph *graph, struct mi_user *user)
+{
+    if (graph->closures_tail == user) {
+        graph->closures_tail = user->prev;
+    }
+
+    DLIST_REMOVE(graph->closures, user);
+}
+
+static void mi_closure_link(struct mi_graph *graph, struct mi_user *user)
+{
+    DLIST_ADD(graph->closures, user);
+
+    if (graph->closures_tail == NULL) {
+        graph->closures_tail = user;
+    }
+}
+
+static void mi_user_drop_closure(struct mi_graph *graph, struct mi_user *user)
+{
+    if (user->closure == NULL) {
+        return;
+    }
+
+    mi_closure_unlink(graph, user);
+    graph->num_closures--;
+    talloc_zfree(user->closure);
+}
+
+static errno_t mi_user_closure(struct mi_graph *graph, struct mi_user *user)
+{
+    size_t max_closures;
+    size_t i;
+
+    if (user->closure != NULL) {
+        mi_closure_unlink(graph, user);
+        mi_closure_link(graph, user);
+        return EOK;
+    }
+
+    /* keep at least the closure which is being returned */
+    max_closures = MI_CLOSURE_BUDGET
+                   / (MI_WORDS(graph->num_groups) * sizeof(uint64_t) + 1);
+    while (graph->num_closures > 0 && graph->num_closures >= max_closures) {
+        mi_user_drop_closure(graph, graph->closures_tail);
+    }
+
+    user->closure = talloc_zero_array(user, uint64_t,
+                                      MI_WORDS(graph->num_groups));
+    if (user->closure == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < user->num_groups; i++) {
+        mi_closure_add(graph, user->closure, user->groups[i]);
+    }
+
+    mi_closure_link(graph, user);
+    graph->num_closures++;
+    return EOK;
+}
+
+static errno_t mi_add_member(struct mi_graph *graph, size_t idx,
+                             const char *member_key)
+{
+    struct mi_user *user;
+    size_t member_idx;
+    errno_t ret;
+
+    if (mi_group_idx(graph, member_key, &member_idx)) {
+        ret = mi_idx_add(graph, &graph->groups[member_idx].parents,
+                         &graph->groups[member_idx].num_parents, idx);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        /* users of the nested group are now members of the group and of
+         * all its parents as well */
+        for (user = graph->closures; user != NULL; user = user->next) {
+            if (mi_bit_test(user->closure, member_idx)) {
+                mi_closure_add(graph, user->closure, idx);
+            }
+        }
+
+        return EOK;
+    }
+
+    ret = mi_user_get(graph, member_key, true, &user);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = mi_idx_add(user, &user->groups, &user->num_groups, idx);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (user->closure != NULL) {
+        mi_closure_add(graph, user->closure, idx);
+    }
+
+    return EOK;
+}
+
+static errno_t mi_del_member(struct mi_graph *graph, size_t idx,
+                             const char *member_key)
+{
+    struct mi_user *user;
+    struct mi_user *next;
+    size_t member_idx;
+    errno_t ret;
+
+    /* The group may still be reachable on another path, the affected
+     * closures are computed again when they are needed */
+    if (mi_group_idx(graph, member_key, &member_idx)) {
+        mi_idx_del(graph->groups[member_idx].parents,
+                   &graph->groups[member_idx].num_parents, idx);
+
+        for (user = graph->closures; user != NULL; user = next) {
+            next = user->next;
+            if (mi_bit_test(user->closure, member_idx)) {
+                mi_user_drop_closure(graph, user);
+            }
+        }
+
+        return EOK;
+    }
+
+    ret = mi_user_get(graph, member_key, false, &user);
+    if (ret == ENOENT) {
+        return EOK;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
+    mi_idx_del(user->groups, &user->num_groups, idx);
+    mi_user_drop_closure(graph, user);
+
+    return EOK;
+}
+
+static errno_t mi_seqnum(struct sysdb_ctx *sysdb, uint64_t *_seqnum)
+{
+    int ret;
+
+    ret = ldb_sequence_number(sysdb->ldb, LDB_SEQ_HIGHEST_SEQ, _seqnum);
+    if (ret != LDB_SUCCESS) {
+        return sysdb_error_to_errno(ret);
+    }
+
+    return EOK;
+}
+
+static errno_t mi_groups_seq(struct sysdb_ctx *sysdb, uint64_t *_groups_seq)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { MI_GROUPS_SEQ, NULL };
+    struct ldb_result *res;
+    struct ldb_dn *dn;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    dn = ldb_dn_new(tmp_ctx, sysdb->ldb, SYSDB_BASE);
+    if (dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_search(sysdb->ldb, tmp_ctx, &res, dn, LDB_SCOPE_BASE,
+                     attrs, NULL);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    if (res->count != 1) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    *_groups_seq = ldb_msg_find_attr_as_uint64(res->msgs[0], MI_GROUPS_SEQ, 0);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Must be called in a transaction */
+static errno_t mi_groups_seq_set(struct sysdb_ctx *sysdb, uint64_t groups_seq)
+{
+    struct ldb_message *msg;
+    errno_t ret;
+
+    msg = ldb_msg_new(NULL);
+    if (msg == NULL) {
+        return ENOMEM;
+    }
+
+    msg->dn = ldb_dn_new(msg, sysdb->ldb, SYSDB_BASE);
+    if (msg->dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_msg_add_empty(msg, MI_GROUPS_SEQ, LDB_FLAG_MOD_REPLACE, NULL);
+    if (ret == LDB_SUCCESS) {
+        ret = ldb_msg_add_fmt(msg, MI_GROUPS_SEQ, "%llu",
+                              (unsigned long long) groups_seq);
+    }
+    if (ret == LDB_SUCCESS) {
+        ret = ldb_modify(sysdb->ldb, msg);
+    }
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldb_modify failed: [%s](%d)[%s]\n",
+              ldb_strerror(ret), ret, ldb_errstring(sysdb->ldb));
+    }
+    ret = sysdb_error_to_errno(ret);
+
+done:
+    talloc_free(msg);
+    return ret;
+}
+
+static errno_t mi_build(TALLOC_CTX *mem_ctx,
+                        struct sysdb_ctx *sysdb,
+                        uint64_t *_seqnum,
+                        uint64_t *_groups_seq,
+                        struct mi_graph **_graph)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *initgr_attrs[] = SYSDB_INITGR_ATTRS;
+    const char **attrs;
+    struct ldb_result *res;
+    struct ldb_message_element *el;
+    struct ldb_dn *base_dn;
+    struct ldb_dn *dn;
+    struct mi_graph *graph;
+    hash_key_t key;
+    hash_value_t value;
+    uint64_t seqnum;
+    uint64_t seqnum_after;
+    uint64_t groups_seq;
+    size_t num_attrs;
+    size_t i;
+    size_t j;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    for (num_attrs = 0; initgr_attrs[num_attrs] != NULL; num_attrs++);
+
+    attrs = talloc_array(tmp_ctx, const char *, num_attrs + 2);
+    if (attrs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    memcpy(attrs, initgr_attrs, num_attrs * sizeof(const char *));
+    attrs[num_attrs] = SYSDB_MEMBER;
+    attrs[num_attrs + 1] = NULL;
+
+    base_dn = ldb_dn_new(tmp_ctx, sysdb->ldb, SYSDB_BASE);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = mi_seqnum(sysdb, &seqnum);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = mi_groups_seq(sysdb, &groups_seq);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = ldb_search(sysdb->ldb, tmp_ctx, &res, base_dn, LDB_SCOPE_SUBTREE,
+                     attrs, "("SYSDB_GC")");
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    ret = mi_seqnum(sysdb, &seqnum_after);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (seqnum != seqnum_after) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Cache changed while reading the groups\n");
+        ret = EAGAIN;
+        goto done;
+    }
+
+    graph = talloc_zero(tmp_ctx, struct mi_graph);
+    if (graph == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    graph->num_groups = res->count;
+    graph->groups = talloc_zero_array(graph, struct mi_group,
+                                      res->count + 1);
+    graph->stack = talloc_array(graph, size_t, res->count + 1);
+    if (graph->groups == NULL || graph->stack == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_hash_create(graph, res->count, &graph->group_idx);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_hash_create(graph, res->count, &graph->users);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    for (i = 0; i < res->count; i++) {
+        key.type = HASH_KEY_STRING;
+        key.str = discard_const(mi_dn_key(res->msgs[i]->dn));
+        value.type = HASH_VALUE_ULONG;
+        value.ul = i;
+        if (key.str == NULL
+                || hash_enter(graph->group_idx, &key, &value) != HASH_SUCCESS) {
+            ret = ENOMEM;
+            goto done;
+        }
+    }
+
+    for (i = 0; i < res->count; i++) {
+        el = ldb_msg_find_element(res->msgs[i], SYSDB_MEMBER);
+        for (j = 0; el != NULL && j < el->num_values; j++) {
+            dn = ldb_dn_from_ldb_val(tmp_ctx, sysdb->ldb, &el->values[j]);
+            ret = mi_add_member(graph, i, mi_dn_key(dn));
+            talloc_free(dn);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+
+        ldb_msg_remove_attr(res->msgs[i], SYSDB_MEMBER);
+        graph->groups[i].msg = talloc_steal(graph, res->msgs[i]);
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Built membership index of %zu groups\n",
+          graph->num_groups);
+
+    *_seqnum = seqnum;
+    *_groups_seq = groups_seq;
+    *_graph = talloc_steal(mem_ctx, graph);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static struct sysdb_members_index *sysdb_members_index_ctx(
+                                                    struct sysdb_ctx *sysdb)
+{
+    if (sysdb->members_index == NULL) {
+        sysdb->members_index = talloc_zero(sysdb,
+                                           struct sysdb_members_index);
+    }
+
+    return sysdb->members_index;
+}
+
+static struct mi_graph *sysdb_members_index_get(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_members_index *mi;
+    struct mi_graph *graph;
+    uint64_t seqnum;
+    uint64_t groups_seq;
+    time_t now;
+    errno_t ret;
+
+    mi = sysdb_members_index_ctx(sysdb);
+    if (mi == NULL) {
+        return NULL;
+    }
+
+    ret = mi_seqnum(sysdb, &seqnum);
+    if (ret != EOK) {
+        return NULL;
+    }
+
+    if (mi->graph != NULL && mi->seqnum == seqnum) {
+        return mi->graph;
+    }
+
+    /* only a change of the groups makes the index out of date */
+    if (mi->graph != NULL) {
+        ret = mi_groups_seq(sysdb, &groups_seq);
+        if (ret == EOK && groups_seq == mi->groups_seq) {
+            mi->seqnum = seqnum;
+            return mi->graph;
+        }
+    }
+
+    now = time(NULL);
+    if (mi->last_build != 0 && mi->last_build <= now
+            && now < mi->last_build + MI_REBUILD_INTERVAL) {
+        return NULL;
+    }
+    mi->last_build = now;
+
+    talloc_zfree(mi->graph);
+
+    ret = mi_build(mi, sysdb, &seqnum, &groups_seq, &graph);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot build the membership index [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return NULL;
+    }
+
+    sss_stats_count("sysdb.members_index.builds", 1);
+
+    mi->graph = graph;
+    mi->seqnum = seqnum;
+    mi->groups_seq = groups_seq;
+    return graph;
+}
+
+/* Users and groups are stored as name=...,cn=users|groups,cn=<domain>,
+ * cn=sysdb */
+static bool mi_dn_is(struct ldb_dn *dn, const char *container)
+{
+    const struct ldb_val *val;
+    const char *name;
+
+    if (ldb_dn_get_comp_num(dn) != 4) {
+        return false;
+    }
+
+    name = ldb_dn_get_component_name(dn, 1);
+    val = ldb_dn_get_component_val(dn, 1);
+    if (name == NULL || val == NULL || strcasecmp(name, "cn") != 0) {
+        return false;
+    }
+
+    return val->length == strlen(container)
+            && strncasecmp((const char *) val->data, container,
+                           val->length) == 0;
+}
+
+static bool mi_msg_changes_group(const struct ldb_message *msg)
+{
+    unsigned int i;
+    size_t j;
+
+    for (i = 0; i < msg->num_elements; i++) {
+        for (j = 0; mi_group_attrs[j] != NULL; j++) {
+            if (strcasecmp(msg->elements[i].name, mi_group_attrs[j]) == 0) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void sysdb_members_index_changed(struct sysdb_ctx *sysdb,
+                                 struct ldb_dn *dn,
+                                 const struct ldb_message *msg)
+{
+    struct sysdb_members_index *mi;
+    errno_t ret;
+
+    if (dn == NULL) {
+        return;
+    }
+
+    if (mi_dn_is(dn, "groups")) {
+        if (msg != NULL && !mi_msg_changes_group(msg)) {
+            return;
+        }
+    } else if (!mi_dn_is(dn, "users") || msg != NULL) {
+        /* only the deletion of a user removes its memberships */
+        return;
+    }
+
+    mi = sysdb_members_index_ctx(sysdb);
+    if (mi == NULL) {
+        return;
+    }
+
+    talloc_zfree(mi->graph);
+    mi->changed = true;
+
+    if (sysdb->transaction_nesting > 0) {
+        /* recorded when the transaction is committed */
+        return;
+    }
+
+    ret = sysdb_transaction_start(sysdb);
+    if (ret == EOK) {
+        ret = sysdb_transaction_commit(sysdb);
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot record the change of the groups [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+}
+
+errno_t sysdb_members_index_commit(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_members_index *mi = sysdb->members_index;
+    uint64_t groups_seq;
+    errno_t ret;
+
+    if (mi == NULL || !mi->changed) {
+        return EOK;
+    }
+
+    mi->changed = false;
+    mi->applied = false;
+
+    ret = mi_groups_seq(sysdb, &groups_seq);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    ret = mi_groups_seq_set(sysdb, groups_seq + 1);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    /* The graph survived the transaction only if all changes were applied
+     * to it, it is still current unless another process changed the groups
+     * before */
+    if (mi->graph != NULL) {
+        if (mi->groups_seq == groups_seq) {
+            mi->groups_seq = groups_seq + 1;
+        } else {
+            talloc_zfree(mi->graph);
+        }
+    }
+
+    return EOK;
+
+fail:
+    talloc_zfree(mi->graph);
+    return ret;
+}
+
+void sysdb_members_index_cancel(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_members_index *mi = sysdb->members_index;
+
+    if (mi == NULL) {
+        return;
+    }
+
+    /* the graph may contain changes which are rolled back now */
+    if (mi->changed || mi->applied) {
+        talloc_zfree(mi->graph);
+    }
+
+    /* ldb rolls back the changes of a nested transaction only together
+     * with the outermost one */
+    if (sysdb->transaction_nesting == 0) {
+        mi->changed = false;
+        mi->applied = false;
+    }
+}
+
+void sysdb_members_index_invalidate(struct sysdb_ctx *sysdb)
+{
+    if (sysdb->members_index != NULL) {
+        talloc_zfree(sysdb->members_index->graph);
+    }
+}
+
+void sysdb_members_index_mod_member(struct sysdb_ctx *sysdb,
+                                    struct ldb_dn *group_dn,
+                                    struct ldb_dn *member_dn,
+                                    int mod_op)
+{
+    struct sysdb_members_index *mi;
+    size_t idx;
+    errno_t ret;
+
+    mi = sysdb_members_index_ctx(sysdb);
+    if (mi == NULL) {
+        return;
+    }
+
+    mi->changed = true;
+    if (mi->graph == NULL) {
+        return;
+    }
+
+    if (!mi_group_idx(mi->graph, mi_dn_key(group_dn), &idx)) {
+        ret = ENOENT;
+        goto fail;
+    }
+
+    switch (mod_op) {
+    case SYSDB_MOD_ADD:
+        ret = mi_add_member(mi->graph, idx, mi_dn_key(member_dn));
+        break;
+    case SYSDB_MOD_DEL:
+        ret = mi_del_member(mi->graph, idx, mi_dn_key(member_dn));
+        break;
+    default:
+        ret = EINVAL;
+        break;
+    }
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    mi->applied = true;
+    return;
+
+fail:
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Cannot update the membership index [%d]: %s\n",
+          ret, sss_strerror(ret));
+    talloc_zfree(mi->graph);
+}
+
+errno_t sysdb_members_index_initgroups(struct sysdb_ctx *sysdb,
+                                       struct ldb_dn *user_dn,
+                                       struct ldb_result *res)
+{
+    struct ldb_message **msgs;
+    struct mi_graph *graph;
+    struct mi_user *user;
+    size_t count;
+    size_t i;
+    errno_t ret;
+
+    graph = sysdb_members_index_get(sysdb);
+    if (graph == NULL) {
+        return EAGAIN;
+    }
+
+    ret = mi_user_get(graph, mi_dn_key(user_dn), false, &user);
+    if (ret == ENOENT) {
+        /* not a direct member of any group */
+        sss_stats_count("sysdb.members_index.hits", 1);
+        return EOK;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
+    ret = mi_user_closure(graph, user);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    count = 0;
+    for (i = 0; i < graph->num_groups; i++) {
+        if (mi_bit_test(user->closure, i)) {
+            count++;
+        }
+    }
+
+    msgs = talloc_realloc(res, res->msgs, struct ldb_message *,
+                          res->count + count + 1);
+    if (msgs == NULL) {
+        return ENOMEM;
+    }
+    res->msgs = msgs;
+
+    count = res->count;
+    for (i = 0; i < graph->num_groups; i++) {
+        if (!mi_bit_test(user->closure, i)
+                || ldb_msg_find_element(graph->groups[i].msg,
+                                        SYSDB_GIDNUM) == NULL) {
+            continue;
+        }
+
+        msgs[count] = ldb_msg_copy(msgs, graph->groups[i].msg);
+        if (msgs[count] == NULL) {
+            /* leave the result as it was */
+            while (count > res->count) {
+                talloc_zfree(msgs[--count]);
+            }
+            msgs[res->count] = NULL;
+            return ENOMEM;
+        }
+        count++;
+    }
+
+    res->count = count;
+    res->msgs[res->count] = NULL;
+
+    sss_stats_count("sysdb.members_index.hits", 1);
+    return EOK;
+}
@@ -24,6 +24,7 @@
 #include "db/sysdb_services.h"
 #include "db/sysdb_autofs.h"
 #include "util/crypto/sss_crypto.h"
+#include "util/auth_verifier.h"
 #include <time.h>
 
 int add_string(struct ldb_message *msg, int flags,
@@ -131,6 +132,8 @@ int sysdb_delete_entry(struct sysdb_ctx *sysdb,
     ret = ldb_delete(sysdb->ldb, dn);
     switch (ret) {
     case LDB_SUCCESS:
+        sysdb_members_index_changed(sysdb, dn, NULL);
+        sysdb_snapshot_changed(sysdb, dn, NULL);
         return EOK;
     case LDB_ERR_NO_SUCH_OBJECT:
         if (ignore_not_found) {
@@ -162,10 +165,10 @@ int sysdb_delete_recursive(struct sysdb_ctx *sysdb,
         return ENOMEM;
     }
 
-    ret = ldb_transaction_start(sysdb->ldb);
+    ret = sysdb_transaction_start(sysdb);
     if (ret) {
-        ret = sysdb_error_to_errno(ret);
-        goto done;
+        talloc_free(tmp_ctx);
+        return ret;
     }
 
     ret = sysdb_search_entry(tmp_ctx, sysdb, dn,
@@ -199,10 +202,9 @@ int sysdb_delete_recursive(struct sysdb_ctx *sysdb,
 
 done:
     if (ret == EOK) {
-        ret = ldb_transaction_commit(sysdb->ldb);
-        ret = sysdb_error_to_errno(ret);
+        ret = sysdb_transaction_commit(sysdb);
     } else {
-        ldb_transaction_cancel(sysdb->ldb);
+        sysdb_transaction_cancel(sysdb);
     }
     talloc_free(tmp_ctx);
     return ret;
@@ -671,6 +673,7 @@ int sysdb_set_entry_attr(struct sysdb_ctx *sysdb,
     struct ldb_message *msg;
     int i, ret;
     int lret;
+    bool in_transaction = false;
     TALLOC_CTX *tmp_ctx;
 
     tmp_ctx = talloc_new(NULL);
@@ -704,15 +707,36 @@ int sysdb_set_entry_attr(struct sysdb_ctx *sysdb,
 
     msg->num_elements = attrs->num;
 
+    /* ldb runs a single modify in a transaction of its own anyway, an
+     * explicit one lets the change be logged for the snapshot */
+    if (sysdb->transaction_nesting == 0) {
+        ret = sysdb_transaction_start(sysdb);
+        if (ret != EOK) {
+            goto done;
+        }
+        in_transaction = true;
+    }
+
     lret = ldb_modify(sysdb->ldb, msg);
     if (lret != LDB_SUCCESS) {
         DEBUG(SSSDBG_MINOR_FAILURE,
               "ldb_modify failed: [%s](%d)[%s]\n",
               ldb_strerror(lret), lret, ldb_errstring(sysdb->ldb));
+    } else {
+        sysdb_members_index_changed(sysdb, entry_dn, msg);
+        sysdb_snapshot_changed(sysdb, entry_dn, msg);
     }
 
     ret = sysdb_error_to_errno(lret);
 
+    if (in_transaction) {
+        if (ret == EOK) {
+            ret = sysdb_transaction_commit(sysdb);
+        } else {
+            sysdb_transaction_cancel(sysdb);
+        }
+    }
+
 done:
     if (ret == ENOENT) {
         DEBUG(SSSDBG_TRACE_FUNC, "No such entry\n");
@@ -851,10 +875,9 @@ int sysdb_get_new_id(struct sss_domain_info *domain,
         return ENOMEM;
     }
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
+    ret = sysdb_transaction_start(domain->sysdb);
     if (ret) {
         talloc_zfree(tmp_ctx);
-        ret = sysdb_error_to_errno(ret);
         return ret;
     }
 
@@ -981,10 +1004,9 @@ int sysdb_get_new_id(struct sss_domain_info *domain,
 
 done:
     if (ret == EOK) {
-        ret = ldb_transaction_commit(domain->sysdb->ldb);
-        ret = sysdb_error_to_errno(ret);
+        ret = sysdb_transaction_commit(domain->sysdb);
     } else {
-        ldb_transaction_cancel(domain->sysdb->ldb);
+        sysdb_transaction_cancel(domain->sysdb);
     }
     if (ret) {
         DEBUG(SSSDBG_TRACE_FUNC, "Error: %d (%s)\n", ret, strerror(ret));
@@ -1149,6 +1171,9 @@ sysdb_remove_ghost_from_group(struct sss_domain_info *dom,
         DEBUG(SSSDBG_MINOR_FAILURE,
               "sss_ldb_modify_permissive failed: [%s](%d)[%s]\n",
               ldb_strerror(ret), ret, ldb_errstring(dom->sysdb->ldb));
+    } else {
+        sysdb_members_index_changed(dom->sysdb, msg->dn, msg);
+        sysdb_snapshot_changed(dom->sysdb, msg->dn, msg);
     }
 
     ret = sysdb_error_to_errno(ret);
@@ -1311,9 +1336,8 @@ int sysdb_add_user(struct sss_domain_info *domain,
         return ENOMEM;
     }
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
+    ret = sysdb_transaction_start(domain->sysdb);
     if (ret) {
-        ret = sysdb_error_to_errno(ret);
         talloc_free(tmp_ctx);
         return ret;
     }
@@ -1403,11 +1427,10 @@ int sysdb_add_user(struct sss_domain_info *domain,
 
 done:
     if (ret == EOK) {
-        ret = ldb_transaction_commit(domain->sysdb->ldb);
-        ret = sysdb_error_to_errno(ret);
+        ret = sysdb_transaction_commit(domain->sysdb);
     } else {
         DEBUG(SSSDBG_TRACE_FUNC, "Error: %d (%s)\n", ret, strerror(ret));
-        ldb_transaction_cancel(domain->sysdb->ldb);
+        sysdb_transaction_cancel(domain->sysdb);
     }
     talloc_zfree(tmp_ctx);
     return ret;
@@ -1454,6 +1477,10 @@ int sysdb_add_basic_group(struct sss_domain_info *domain,
     if (ret) goto done;
 
     ret = ldb_add(domain->sysdb->ldb, msg);
+    if (ret == LDB_SUCCESS) {
+        sysdb_members_index_changed(domain->sysdb, msg->dn, msg);
+        sysdb_snapshot_changed(domain->sysdb, msg->dn, msg);
+    }
     ret = sysdb_error_to_errno(ret);
 
 done:
@@ -1492,9 +1519,8 @@ int sysdb_add_group(struct sss_domain_info *domain,
         return ENOMEM;
     }
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
+    ret = sysdb_transaction_start(domain->sysdb);
     if (ret) {
-        ret = sysdb_error_to_errno(ret);
         talloc_free(tmp_ctx);
         return ret;
     }
@@ -1607,11 +1633,10 @@ int sysdb_add_group(struct sss_domain_info *domain,
 
 done:
     if (ret == EOK) {
-        ret = ldb_transaction_commit(domain->sysdb->ldb);
-        ret = sysdb_error_to_errno(ret);
+        ret = sysdb_transaction_commit(domain->sysdb);
     } else {
         DEBUG(SSSDBG_TRACE_FUNC, "Error: %d (%s)\n", ret, strerror(ret));
-        ldb_transaction_cancel(domain->sysdb->ldb);
+        sysdb_transaction_cancel(domain->sysdb);
     }
     talloc_zfree(tmp_ctx);
     return ret;
@@ -1692,8 +1717,10 @@ int sysdb_mod_group_member(struct sss_domain_info *domain,
                            struct ldb_dn *group_dn,
                            int mod_op)
 {
+    struct sysdb_ctx *sysdb = domain->sysdb;
     struct ldb_message *msg;
     const char *dn;
+    bool in_transaction = false;
     int ret;
 
     msg = ldb_msg_new(NULL);
@@ -1717,18 +1744,43 @@ int sysdb_mod_group_member(struct sss_domain_info *domain,
         ERROR_OUT(ret, EINVAL, fail);
     }
 
-    ret = ldb_modify(domain->sysdb->ldb, msg);
+    /* The change of the groups is recorded when the transaction is
+     * committed. A failed modify, e.g. of a member which is already there,
+     * writes nothing and leaves the membership index alone. */
+    if (sysdb->transaction_nesting == 0) {
+        ret = sysdb_transaction_start(sysdb);
+        if (ret != EOK) {
+            goto fail;
+        }
+        in_transaction = true;
+    }
+
+    ret = ldb_modify(sysdb->ldb, msg);
     if (ret != LDB_SUCCESS) {
         DEBUG(SSSDBG_MINOR_FAILURE,
               "ldb_modify failed: [%s](%d)[%s]\n",
-              ldb_strerror(ret), ret, ldb_errstring(domain->sysdb->ldb));
+              ldb_strerror(ret), ret, ldb_errstring(sysdb->ldb));
     }
     ret = sysdb_error_to_errno(ret);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    sysdb_members_index_mod_member(sysdb, group_dn, member_dn, mod_op);
+    sysdb_snapshot_changed(sysdb, group_dn, msg);
+
+    if (in_transaction) {
+        ret = sysdb_transaction_commit(sysdb);
+        in_transaction = false;
+    }
 
 fail:
     if (ret) {
         DEBUG(SSSDBG_TRACE_FUNC, "Error: %d (%s)\n", ret, strerror(ret));
     }
+    if (in_transaction) {
+        sysdb_transaction_cancel(sysdb);
+    }
     talloc_zfree(msg);
     return ret;
 }
@@ -1800,9 +1852,8 @@ int sysdb_add_netgroup(struct sss_domain_info *domain,
         return ENOMEM;
     }
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
+    ret = sysdb_transaction_start(domain->sysdb);
     if (ret) {
-        ret = sysdb_error_to_errno(ret);
         talloc_free(tmp_ctx);
         return ret;
     }
@@ -1844,13 +1895,13 @@ int sysdb_add_netgroup(struct sss_domain_info *domain,
 
 done:
     if (ret == EOK) {
-        ret = ldb_transaction_commit(domain->sysdb->ldb);
-        ret = sysdb_error_to_errno(ret);
+        ret = sysdb_transaction_commit(domain->sysdb);
+    } else {
+        sysdb_transaction_cancel(domain->sysdb);
     }
 
     if (ret != EOK) {
         DEBUG(SSSDBG_TRACE_FUNC, "Error: %d (%s)\n", ret, strerror(ret));
-        ldb_transaction_cancel(domain->sysdb->ldb);
     }
     talloc_zfree(tmp_ctx);
     return ret;
@@ -2247,6 +2298,16 @@ int sysdb_cache_password(struct sss_domain_info *domain,
         goto fail;
     }
 
+    if (domain->cache_credentials_rounds != 0 &&
+        domain->cache_credentials_rounds != CONFDB_DEFAULT_CACHE_CREDS_ROUNDS) {
+        /* the number of rounds is stored as part of the hash */
+        salt = talloc_asprintf(tmp_ctx, "rounds=%"PRIu32"$%s",
+                               domain->cache_credentials_rounds, salt);
+        if (salt == NULL) {
+            ERROR_OUT(ret, ENOMEM, fail);
+        }
+    }
+
     ret = s3crypt_sha512(tmp_ctx, password, salt, &hash);
     if (ret) {
         DEBUG(SSSDBG_CONF_SETTINGS, "Failed to create password hash.\n");
@@ -2407,9 +2468,9 @@ int sysdb_store_custom(struct sss_domain_info *domain,
         return EINVAL;
     }
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
+    ret = sysdb_transaction_start(domain->sysdb);
     if (ret) {
-        return sysdb_error_to_errno(ret);
+        return ret;
     }
 
     tmp_ctx = talloc_new(NULL);
@@ -2477,10 +2538,9 @@ int sysdb_store_custom(struct sss_domain_info *domain,
 done:
     if (ret) {
         DEBUG(SSSDBG_TRACE_FUNC, "Error: %d (%s)\n", ret, strerror(ret));
-        ldb_transaction_cancel(domain->sysdb->ldb);
+        sysdb_transaction_cancel(domain->sysdb);
     } else {
-        ret = ldb_transaction_commit(domain->sysdb->ldb);
-        ret = sysdb_error_to_errno(ret);
+        ret = sysdb_transaction_commit(domain->sysdb);
     }
     talloc_zfree(tmp_ctx);
     return ret;
@@ -2777,6 +2837,7 @@ int sysdb_delete_user(struct sss_domain_info *domain,
             if (ret != EOK) {
                 goto fail;
             }
+            sysdb_snapshot_changed(domain->sysdb, msg->dn, msg);
 
             talloc_zfree(msg);
         }
@@ -3155,6 +3216,8 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
     char *comphash;
     uint64_t lastLogin = 0;
     int cred_expiration;
+    int verifier_timeout;
+    bool password_ok;
     uint32_t failed_login_attempts = 0;
     struct sysdb_attrs *update_attrs;
     bool authentication_successful = false;
@@ -3187,10 +3250,9 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
         return ENOMEM;
     }
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
+    ret = sysdb_transaction_start(domain->sysdb);
     if (ret) {
         talloc_zfree(tmp_ctx);
-        ret = sysdb_error_to_errno(ret);
         return ret;
     }
 
@@ -3246,11 +3308,35 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
         goto done;
     }
 
-    ret = s3crypt_sha512(tmp_ctx, password, userhash, &comphash);
-    if (ret) {
-        DEBUG(SSSDBG_CONF_SETTINGS, "Failed to create password hash.\n");
-        ret = ERR_INTERNAL;
-        goto done;
+    ret = confdb_get_int(cdb, CONFDB_PAM_CONF_ENTRY,
+                         CONFDB_PAM_VERIFIER_TIMEOUT,
+                         CONFDB_DEFAULT_PAM_VERIFIER_TIMEOUT,
+                         &verifier_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to read the verifier cache timeout, not fatal.\n");
+        verifier_timeout = 0;
+    }
+
+    if (verifier_timeout > 0
+            && sss_auth_verifier_check(domain->name, name,
+                                       userhash, password)) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Password matched the in-memory verifier cache.\n");
+        password_ok = true;
+    } else {
+        ret = s3crypt_sha512(tmp_ctx, password, userhash, &comphash);
+        if (ret) {
+            DEBUG(SSSDBG_CONF_SETTINGS, "Failed to create password hash.\n");
+            ret = ERR_INTERNAL;
+            goto done;
+        }
+
+        password_ok = (strcmp(userhash, comphash) == 0);
+        if (password_ok && verifier_timeout > 0) {
+            sss_auth_verifier_add(domain->name, name, userhash, password,
+                                  verifier_timeout);
+        }
     }
 
     update_attrs = sysdb_new_attrs(tmp_ctx);
@@ -3260,7 +3346,7 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
         goto done;
     }
 
-    if (strcmp(userhash, comphash) == 0) {
+    if (password_ok) {
         /* TODO: probable good point for audit logging */
         DEBUG(SSSDBG_CONF_SETTINGS, "Hashes do match!\n");
         authentication_successful = true;
@@ -3292,6 +3378,7 @@ int sysdb_cache_auth(struct sss_domain_info *domain,
     } else {
         DEBUG(SSSDBG_CONF_SETTINGS, "Authentication failed.\n");
         authentication_successful = false;
+        sss_auth_verifier_remove(domain->name, name);
 
         ret = sysdb_attrs_add_time_t(update_attrs,
                                      SYSDB_LAST_FAILED_LOGIN,
@@ -3325,10 +3412,9 @@ done:
         *_delayed_until = delayed_until;
     }
     if (ret) {
-        ldb_transaction_cancel(domain->sysdb->ldb);
+        sysdb_transaction_cancel(domain->sysdb);
     } else {
-        ret = ldb_transaction_commit(domain->sysdb->ldb);
-        ret = sysdb_error_to_errno(ret);
+        ret = sysdb_transaction_commit(domain->sysdb);
         if (ret) {
             DEBUG(SSSDBG_OP_FAILURE, "Failed to commit transaction!\n");
         }
@@ -3508,6 +3594,10 @@ errno_t sysdb_remove_attrs(struct sss_domain_info *domain,
             ret = sysdb_error_to_errno(lret);
             goto done;
         }
+        if (lret == LDB_SUCCESS) {
+            sysdb_members_index_changed(domain->sysdb, msg->dn, msg);
+            sysdb_snapshot_changed(domain->sysdb, msg->dn, msg);
+        }
 
         /* Remove this attribute and move on to the next one */
         ldb_msg_remove_attr(msg, remove_attrs[i]);
@@ -84,9 +84,27 @@
 
 #include "db/sysdb.h"
 
+struct sysdb_override_map;
+struct sysdb_snapshot;
+struct sysdb_members_index;
+
 struct sysdb_ctx {
     struct ldb_context *ldb;
     char *ldb_file;
+
+    /* transactions started with sysdb_transaction_start() and not yet
+     * finished */
+    int transaction_nesting;
+
+    /* names of the user overrides of the view, see sysdb_views.c */
+    struct sysdb_override_map *override_map;
+
+    /* read-only snapshot of the users and groups, see sysdb_snapshot.c */
+    struct sysdb_snapshot *snapshot;
+
+    /* read-side cache of the transitive group memberships used by
+     * sysdb_initgroups(), see sysdb_members_index.c */
+    struct sysdb_members_index *members_index;
 };
 
 /* Internal utility functions */
@@ -101,6 +119,76 @@ int sysdb_domain_init_internal(TALLOC_CTX *mem_ctx,
                                bool allow_upgrade,
                                struct sysdb_ctx **_ctx);
 
+void sysdb_override_map_reset(struct sysdb_ctx *sysdb);
+
+/* Log of the changes since the snapshot was written. The outermost
+ * transaction is reported with sysdb_snapshot_begin() once it started,
+ * sysdb_snapshot_commit() right before it is committed and
+ * sysdb_snapshot_finish() once it is committed or cancelled. Every write
+ * of a user or group in a transaction must be reported with
+ * sysdb_snapshot_changed(), msg is the added or modified message or NULL
+ * if the entry was deleted. */
+void sysdb_snapshot_begin(struct sysdb_ctx *sysdb);
+void sysdb_snapshot_changed(struct sysdb_ctx *sysdb,
+                            struct ldb_dn *dn,
+                            const struct ldb_message *msg);
+void sysdb_snapshot_commit(struct sysdb_ctx *sysdb);
+void sysdb_snapshot_finish(struct sysdb_ctx *sysdb, bool committed);
+
+/* Lookups in the snapshot of the cache. They return ENOENT if the snapshot
+ * is missing, out of date or cannot answer the lookup, the cache has to be
+ * searched then. */
+errno_t sysdb_snapshot_getpwnam(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                const char *name,
+                                const char **attrs,
+                                struct ldb_result **_res);
+errno_t sysdb_snapshot_getpwuid(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                uid_t uid,
+                                const char **attrs,
+                                struct ldb_result **_res);
+errno_t sysdb_snapshot_getgrnam(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                const char *name,
+                                const char **attrs,
+                                struct ldb_result **_res);
+errno_t sysdb_snapshot_getgrgid(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                gid_t gid,
+                                const char **attrs,
+                                struct ldb_result **_res);
+errno_t sysdb_snapshot_initgroups(TALLOC_CTX *mem_ctx,
+                                  struct sss_domain_info *domain,
+                                  const char *name,
+                                  const char **pw_attrs,
+                                  const char **gr_attrs,
+                                  struct ldb_result **_res);
+
+/* Read-side cache of the transitive group memberships, memberOf is still
+ * maintained by the memberof plugin. Every write which adds,
+ * changes or deletes a group or deletes a user must be reported with
+ * sysdb_members_index_changed(), msg is the added or modified message or
+ * NULL if the entry was deleted. A change of the direct members of a
+ * group written in a transaction is applied to the index of this process
+ * with sysdb_members_index_mod_member() instead. */
+void sysdb_members_index_changed(struct sysdb_ctx *sysdb,
+                                 struct ldb_dn *dn,
+                                 const struct ldb_message *msg);
+void sysdb_members_index_mod_member(struct sysdb_ctx *sysdb,
+                                    struct ldb_dn *group_dn,
+                                    struct ldb_dn *member_dn,
+                                    int mod_op);
+/* Called when the outermost transaction is committed or cancelled */
+errno_t sysdb_members_index_commit(struct sysdb_ctx *sysdb);
+void sysdb_members_index_cancel(struct sysdb_ctx *sysdb);
+void sysdb_members_index_invalidate(struct sysdb_ctx *sysdb);
+/* Appends the groups of the user to res, returns EAGAIN if the index is
+ * out of date and memberOf has to be used. */
+errno_t sysdb_members_index_initgroups(struct sysdb_ctx *sysdb,
+                                       struct ldb_dn *user_dn,
+                                       struct ldb_result *res);
+
 /* Upgrade routines */
 int sysdb_upgrade_01(struct ldb_context *ldb, const char **ver);
 int sysdb_check_upgrade_02(struct sss_domain_info *domains,
@@ -61,6 +61,12 @@ int sysdb_getpwnam(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    ret = sysdb_snapshot_getpwnam(tmp_ctx, domain, src_name, attrs, &res);
+    if (ret == EOK) {
+        *_res = talloc_steal(mem_ctx, res);
+        goto done;
+    }
+
     ret = sss_filter_sanitize_for_dom(tmp_ctx, src_name, domain,
                                       &sanitized_name, &lc_sanitized_name);
     if (ret != EOK) {
@@ -168,6 +174,12 @@ int sysdb_getpwuid(TALLOC_CTX *mem_ctx,
         return ENOMEM;
     }
 
+    ret = sysdb_snapshot_getpwuid(tmp_ctx, domain, uid, attrs, &res);
+    if (ret == EOK) {
+        *_res = talloc_steal(mem_ctx, res);
+        goto done;
+    }
+
     base_dn = ldb_dn_new_fmt(tmp_ctx, domain->sysdb->ldb,
                              SYSDB_TMPL_USER_BASE, domain->name);
     if (!base_dn) {
@@ -505,6 +517,12 @@ int sysdb_getgrnam(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
+    ret = sysdb_snapshot_getgrnam(tmp_ctx, domain, src_name, attrs, &res);
+    if (ret == EOK) {
+        *_res = talloc_steal(mem_ctx, res);
+        goto done;
+    }
+
     ret = sss_filter_sanitize_for_dom(tmp_ctx, src_name, domain,
                                       &sanitized_name, &lc_sanitized_name);
     if (ret != EOK) {
@@ -634,6 +652,12 @@ int sysdb_getgrgid(TALLOC_CTX *mem_ctx,
         return ENOMEM;
     }
 
+    ret = sysdb_snapshot_getgrgid(tmp_ctx, domain, gid, attrs, &res);
+    if (ret == EOK) {
+        *_res = talloc_steal(mem_ctx, res);
+        goto done;
+    }
+
     if (domain->mpg) {
         fmt_filter = SYSDB_GRGID_MPG_FILTER;
         base_dn = ldb_dn_new_fmt(tmp_ctx, domain->sysdb->ldb,
@@ -765,48 +789,23 @@ done:
     return ret;
 }
 
-int sysdb_initgroups(TALLOC_CTX *mem_ctx,
-                     struct sss_domain_info *domain,
-                     const char *name,
-                     struct ldb_result **_res)
+/* Appends the groups listed in the memberOf attribute of the user to res */
+static errno_t sysdb_initgroups_memberof(struct sss_domain_info *domain,
+                                         struct ldb_dn *user_dn,
+                                         struct ldb_result *res)
 {
     TALLOC_CTX *tmp_ctx;
-    struct ldb_result *res;
-    struct ldb_dn *user_dn;
     struct ldb_request *req;
     struct ldb_control **ctrl;
     struct ldb_asq_control *control;
     static const char *attrs[] = SYSDB_INITGR_ATTRS;
-    int ret;
+    errno_t ret;
 
     tmp_ctx = talloc_new(NULL);
     if (!tmp_ctx) {
         return ENOMEM;
     }
 
-    ret = sysdb_getpwnam(tmp_ctx, domain, name, &res);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_getpwnam failed: [%d][%s]\n",
-                  ret, strerror(ret));
-        goto done;
-    }
-
-    if (res->count == 0) {
-        /* User is not cached yet */
-        *_res = talloc_steal(mem_ctx, res);
-        ret = EOK;
-        goto done;
-
-    } else if (res->count != 1) {
-        ret = EIO;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "sysdb_getpwnam returned count: [%d]\n", res->count);
-        goto done;
-    }
-
-    /* no need to steal the dn, we are not freeing the result */
-    user_dn = res->msgs[0]->dn;
-
     /* note we count on the fact that the default search callback
      * will just keep appending values. This is by design and can't
      * change so it is ok to already have a result (from the getpwnam)
@@ -858,34 +857,45 @@ int sysdb_initgroups(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    *_res = talloc_steal(mem_ctx, res);
+    ret = EOK;
 
 done:
-    talloc_zfree(tmp_ctx);
+    talloc_free(tmp_ctx);
     return ret;
 }
 
-int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
-                                struct sss_domain_info *domain,
-                                const char *name,
-                                struct ldb_result **_res)
+int sysdb_initgroups(TALLOC_CTX *mem_ctx,
+                     struct sss_domain_info *domain,
+                     const char *name,
+                     struct ldb_result **_res)
 {
     TALLOC_CTX *tmp_ctx;
     struct ldb_result *res;
     struct ldb_dn *user_dn;
-    struct ldb_request *req;
-    struct ldb_control **ctrl;
-    struct ldb_asq_control *control;
     static const char *attrs[] = SYSDB_INITGR_ATTRS;
+    static const char *pw_attrs[] = SYSDB_PW_ATTRS;
+    const char *src_name;
     int ret;
-    size_t c;
 
     tmp_ctx = talloc_new(NULL);
     if (!tmp_ctx) {
         return ENOMEM;
     }
 
-    ret = sysdb_getpwnam_with_views(tmp_ctx, domain, name, &res);
+    src_name = sss_get_domain_name(tmp_ctx, name, domain);
+    if (!src_name) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sysdb_snapshot_initgroups(tmp_ctx, domain, src_name, pw_attrs, attrs,
+                                    &res);
+    if (ret == EOK) {
+        *_res = talloc_steal(mem_ctx, res);
+        goto done;
+    }
+
+    ret = sysdb_getpwnam(tmp_ctx, domain, name, &res);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_getpwnam failed: [%d][%s]\n",
                   ret, strerror(ret));
@@ -908,55 +918,66 @@ int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
     /* no need to steal the dn, we are not freeing the result */
     user_dn = res->msgs[0]->dn;
 
-    /* note we count on the fact that the default search callback
-     * will just keep appending values. This is by design and can't
-     * change so it is ok to already have a result (from the getpwnam)
-     * even before we call the next search */
-
-    ctrl = talloc_array(tmp_ctx, struct ldb_control *, 2);
-    if (!ctrl) {
-        ret = ENOMEM;
-        goto done;
+    ret = sysdb_members_index_initgroups(domain->sysdb, user_dn, res);
+    if (ret != EOK) {
+        ret = sysdb_initgroups_memberof(domain, user_dn, res);
+        if (ret != EOK) {
+            goto done;
+        }
     }
-    ctrl[1] = NULL;
-    ctrl[0] = talloc(ctrl, struct ldb_control);
-    if (!ctrl[0]) {
-        ret = ENOMEM;
-        goto done;
+
+    *_res = talloc_steal(mem_ctx, res);
+
+done:
+    talloc_zfree(tmp_ctx);
+    return ret;
+}
+
+int sysdb_initgroups_with_views(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                const char *name,
+                                struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *res;
+    struct ldb_dn *user_dn;
+    int ret;
+    size_t c;
+
+    tmp_ctx = talloc_new(NULL);
+    if (!tmp_ctx) {
+        return ENOMEM;
     }
-    ctrl[0]->oid = LDB_CONTROL_ASQ_OID;
-    ctrl[0]->critical = 1;
-    control = talloc(ctrl[0], struct ldb_asq_control);
-    if (!control) {
-        ret = ENOMEM;
+
+    ret = sysdb_getpwnam_with_views(tmp_ctx, domain, name, &res);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sysdb_getpwnam failed: [%d][%s]\n",
+                  ret, strerror(ret));
         goto done;
     }
-    control->request = 1;
-    control->source_attribute = talloc_strdup(control, SYSDB_INITGR_ATTR);
-    if (!control->source_attribute) {
-        ret = ENOMEM;
+
+    if (res->count == 0) {
+        /* User is not cached yet */
+        *_res = talloc_steal(mem_ctx, res);
+        ret = EOK;
         goto done;
-    }
-    control->src_attr_len = strlen(control->source_attribute);
-    ctrl[0]->data = control;
 
-    ret = ldb_build_search_req(&req, domain->sysdb->ldb, tmp_ctx,
-                               user_dn, LDB_SCOPE_BASE,
-                               SYSDB_INITGR_FILTER, attrs, ctrl,
-                               res, ldb_search_default_callback,
-                               NULL);
-    if (ret != LDB_SUCCESS) {
-        ret = sysdb_error_to_errno(ret);
+    } else if (res->count != 1) {
+        ret = EIO;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "sysdb_getpwnam returned count: [%d]\n", res->count);
         goto done;
     }
 
-    ret = ldb_request(domain->sysdb->ldb, req);
-    if (ret == LDB_SUCCESS) {
-        ret = ldb_wait(req->handle, LDB_WAIT_ALL);
-    }
-    if (ret != LDB_SUCCESS) {
-        ret = sysdb_error_to_errno(ret);
-        goto done;
+    /* no need to steal the dn, we are not freeing the result */
+    user_dn = res->msgs[0]->dn;
+
+    ret = sysdb_members_index_initgroups(domain->sysdb, user_dn, res);
+    if (ret != EOK) {
+        ret = sysdb_initgroups_memberof(domain, user_dn, res);
+        if (ret != EOK) {
+            goto done;
+        }
     }
 
     if (DOM_HAS_VIEWS(domain)) {
@@ -35,6 +35,8 @@
 #define SYSDB_SELINUX_DEFAULT_USER "user"
 #define SYSDB_SELINUX_DEFAULT_ORDER "order"
 #define SYSDB_SELINUX_HOST_PRIORITY "hostPriority"
+/* Stored in the user entry, the mapping set up by the last login */
+#define SYSDB_SELINUX_APPLIED "selinuxAppliedUser"
 
 errno_t sysdb_store_selinux_usermap(struct sss_domain_info *domain,
                                     struct sysdb_attrs *attrs);
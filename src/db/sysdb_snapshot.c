@@ -0,0 +1,2140 @@
+/*
+    SSSD
+
+    System Database - read-only snapshot of the users and groups
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dhash.h>
+
+#include "util/util.h"
+#include "util/murmurhash3.h"
+#include "util/sss_stats.h"
+#include "util/sss_utf8.h"
+#include "db/sysdb_private.h"
+
+/* The snapshot is a file next to the cache which contains the users and
+ * groups of the cache with the attributes returned by sysdb_getpwnam(),
+ * sysdb_getgrnam() and sysdb_initgroups(), and hash tables to find them by
+ * name and by ID. It is written by the back end into a temporary file and
+ * renamed over the previous one, so the responders always map a complete
+ * snapshot and never need to lock it.
+ *
+ * The snapshot records the sequence number of the cache it was built
+ * from. While the cache still has the same sequence number, all entries
+ * of the snapshot are current. Every transaction which modifies the cache
+ * after that appends the hashes of the DNs of the users and groups it
+ * changed to the log next to the snapshot, see sysdb_snapshot_changed().
+ * A reader then uses only the entries whose DN is not in the log, as long
+ * as the log accounts for every change of the sequence number since the
+ * snapshot was written. A write done outside of a logged transaction
+ * leaves a gap in the log and makes the readers fall back to ldb until
+ * the back end writes a new snapshot. The back end is told about the
+ * transactions it commits, see sysdb_snapshot_set_changed_cb(), and
+ * rewrites the snapshot shortly after them.
+ *
+ * All integers are stored in host byte order, all data is aligned to 4
+ * bytes. A string is stored as its length, the bytes and a terminating
+ * zero. An entry is stored as:
+ *
+ *   type, flags, id, hash of the DN, domain, DN,
+ *   number of names, names (the name first, then the aliases),
+ *   number of groups, indexes of the groups the user is a member of,
+ *   number of attributes, for each attribute:
+ *     name, number of values, values
+ *
+ * The log starts with struct snap_log_header, followed by the records of
+ * the transactions in the order they were committed. Each record is
+ * struct snap_log_record followed by the hashes of the changed DNs. A
+ * record is appended as pending while the transaction still holds the
+ * cache locked and marked done or aborted when it is finished.
+ */
+
+#define SNAP_MAGIC 0x504e5353 /* "SSNP" */
+#define SNAP_VERSION 2
+
+#define SNAP_USER 1
+#define SNAP_GROUP 2
+
+#define SNAP_FLAG_HAS_ID 0x0001
+/* some memberOf values do not point to a group in the snapshot */
+#define SNAP_FLAG_INCOMPLETE 0x0002
+
+enum snap_table {
+    SNAP_HT_USER_NAME = 0,
+    SNAP_HT_UID,
+    SNAP_HT_GROUP_NAME,
+    SNAP_HT_GID,
+
+    SNAP_HT_NUM
+};
+
+struct snap_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t seqnum;
+    uint32_t size;
+    uint32_t num_entries;
+    /* offset of the table with the offsets of the entries */
+    uint32_t entries;
+    /* number of slots of each hash table, a power of two */
+    uint32_t ht_size;
+    uint32_t ht[SNAP_HT_NUM];
+};
+
+#define SNAP_ALIGN(size) (((size) + 3) & ~3)
+
+#define SNAP_LOG_MAGIC 0x4c4e5353 /* "SSNL" */
+#define SNAP_LOG_VERSION 1
+
+#define SNAP_LOG_PENDING 1
+#define SNAP_LOG_DONE 2
+#define SNAP_LOG_ABORTED 3
+
+/* a group was changed or a user deleted, the memberof plugin may have
+ * changed any group and the memberships of any user */
+#define SNAP_LOG_GROUPS 0x0001
+/* too many entries were changed to list them */
+#define SNAP_LOG_ALL 0x0002
+
+#define SNAP_LOG_MAX_DNS 1024
+/* a larger log is not worth reading, the snapshot is rewritten soon */
+#define SNAP_LOG_MAX_SIZE (1024 * 1024)
+
+struct snap_log_header {
+    uint32_t magic;
+    uint32_t version;
+    /* sequence number of the snapshot the log belongs to */
+    uint64_t base_seqnum;
+};
+
+struct snap_log_record {
+    uint32_t state;
+    uint32_t flags;
+    /* sequence number of the cache before and after the transaction */
+    uint64_t seq_start;
+    uint64_t seq_end;
+    uint32_t num_hashes;
+    uint32_t reserved;
+};
+
+/* Do not look for the snapshot more than once per second if it is
+ * missing or out of date */
+#define SNAP_RECHECK_INTERVAL 1
+
+struct sysdb_snapshot {
+    char *file;
+    char *log_file;
+
+    /* reader */
+    uint8_t *base;
+    size_t size;
+    dev_t dev;
+    ino_t ino;
+    time_t last_check;
+    /* the cache did not change since the mapped snapshot was written */
+    bool exact;
+
+    /* reader, the changes logged since the mapped snapshot was written,
+     * valid for the sequence number log_seqnum of the cache */
+    uint64_t log_base;
+    uint64_t log_seqnum;
+    time_t log_read;
+    bool log_valid;
+    uint32_t log_flags;
+    uint32_t *log_hashes;
+    size_t log_num_hashes;
+
+    /* writer */
+    bool written;
+    uint64_t written_seqnum;
+
+    /* writer, the changes of the current transaction */
+    bool in_transaction;
+    bool logging;
+    bool changed;
+    uint64_t seq_start;
+    uint32_t pending_flags;
+    uint32_t *pending;
+    size_t num_pending;
+    int log_fd;
+    off_t log_record;
+    time_t log_check;
+    bool log_exists;
+
+    sysdb_snapshot_changed_fn changed_fn;
+    void *changed_pvt;
+};
+
+static uint32_t snap_hash_name(const char *name)
+{
+    return murmurhash3(name, strlen(name), 0);
+}
+
+static uint32_t snap_hash_id(uint32_t id)
+{
+    return murmurhash3((const char *) &id, sizeof(id), 0);
+}
+
+static uint32_t snap_hash_dn(struct ldb_dn *dn)
+{
+    const char *casefold;
+
+    casefold = ldb_dn_get_casefold(dn);
+    if (casefold == NULL) {
+        return 0;
+    }
+
+    return snap_hash_name(casefold);
+}
+
+static int snap_hash_cmp(const void *a, const void *b)
+{
+    uint32_t ha = *(const uint32_t *) a;
+    uint32_t hb = *(const uint32_t *) b;
+
+    return ha < hb ? -1 : (ha > hb ? 1 : 0);
+}
+
+static int sysdb_snapshot_destructor(struct sysdb_snapshot *snap)
+{
+    if (snap->base != NULL) {
+        munmap(snap->base, snap->size);
+        snap->base = NULL;
+    }
+
+    if (snap->log_fd != -1) {
+        close(snap->log_fd);
+        snap->log_fd = -1;
+    }
+
+    return 0;
+}
+
+static struct sysdb_snapshot *sysdb_snapshot_ctx(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_snapshot *snap;
+
+    if (sysdb->snapshot != NULL) {
+        return sysdb->snapshot;
+    }
+
+    snap = talloc_zero(sysdb, struct sysdb_snapshot);
+    if (snap == NULL) {
+        return NULL;
+    }
+
+    snap->file = talloc_asprintf(snap, "%s.snapshot", sysdb->ldb_file);
+    snap->log_file = talloc_asprintf(snap, "%s.snapshot.log",
+                                     sysdb->ldb_file);
+    if (snap->file == NULL || snap->log_file == NULL) {
+        talloc_free(snap);
+        return NULL;
+    }
+
+    snap->log_fd = -1;
+    talloc_set_destructor(snap, sysdb_snapshot_destructor);
+
+    sysdb->snapshot = snap;
+    return snap;
+}
+
+static errno_t sysdb_snapshot_seqnum(struct sysdb_ctx *sysdb,
+                                     uint64_t *_seqnum)
+{
+    int ret;
+
+    ret = ldb_sequence_number(sysdb->ldb, LDB_SEQ_HIGHEST_SEQ, _seqnum);
+    if (ret != LDB_SUCCESS) {
+        return sysdb_error_to_errno(ret);
+    }
+
+    return EOK;
+}
+
+static errno_t snap_log_lock(int fd, short type)
+{
+    struct flock lock;
+    int ret;
+
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = 0;
+    lock.l_len = 0;
+    lock.l_pid = 0;
+
+    do {
+        ret = fcntl(fd, F_SETLKW, &lock);
+    } while (ret == -1 && errno == EINTR);
+
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to %s the snapshot log: %d(%s)\n",
+              type == F_UNLCK ? "unlock" : "lock", ret, sss_strerror(ret));
+        return ret;
+    }
+
+    return EOK;
+}
+
+/* Opens and locks the log, the back end may replace it meanwhile */
+static int snap_log_open(struct sysdb_snapshot *snap, int flags, short type)
+{
+    struct stat st_fd;
+    struct stat st_path;
+    int fd;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        fd = open(snap->log_file, flags);
+        if (fd == -1) {
+            return -1;
+        }
+
+        if (snap_log_lock(fd, type) == EOK
+                && fstat(fd, &st_fd) == 0
+                && stat(snap->log_file, &st_path) == 0
+                && st_fd.st_dev == st_path.st_dev
+                && st_fd.st_ino == st_path.st_ino) {
+            return fd;
+        }
+
+        close(fd);
+    }
+
+    return -1;
+}
+
+static errno_t snap_log_read(TALLOC_CTX *mem_ctx, int fd,
+                             uint8_t **_data, size_t *_len)
+{
+    struct stat st;
+    uint8_t *data;
+
+    if (fstat(fd, &st) == -1) {
+        return errno;
+    }
+
+    if (st.st_size < (off_t) sizeof(struct snap_log_header)
+            || st.st_size > 2 * SNAP_LOG_MAX_SIZE) {
+        return EINVAL;
+    }
+
+    data = talloc_size(mem_ctx, st.st_size);
+    if (data == NULL) {
+        return ENOMEM;
+    }
+
+    if (lseek(fd, 0, SEEK_SET) == -1
+            || sss_atomic_read_s(fd, data, st.st_size) != st.st_size) {
+        talloc_free(data);
+        return EIO;
+    }
+
+    *_data = data;
+    *_len = st.st_size;
+    return EOK;
+}
+
+/* =Writer================================================================= */
+
+struct snap_buf {
+    uint8_t *data;
+    size_t len;
+    size_t alloc;
+};
+
+static errno_t snap_buf_reserve(struct snap_buf *buf, size_t len)
+{
+    uint8_t *data;
+    size_t alloc;
+
+    if (buf->len + len <= buf->alloc) {
+        return EOK;
+    }
+
+    alloc = buf->alloc ? buf->alloc : 4096;
+    while (alloc < buf->len + len) {
+        alloc *= 2;
+    }
+
+    /* the size is stored in 32 bits */
+    if (alloc > UINT32_MAX) {
+        return EFBIG;
+    }
+
+    data = talloc_realloc(NULL, buf->data, uint8_t, alloc);
+    if (data == NULL) {
+        return ENOMEM;
+    }
+
+    buf->data = data;
+    buf->alloc = alloc;
+    return EOK;
+}
+
+static errno_t snap_put_u32(struct snap_buf *buf, uint32_t val)
+{
+    errno_t ret;
+
+    ret = snap_buf_reserve(buf, sizeof(uint32_t));
+    if (ret != EOK) {
+        return ret;
+    }
+
+    memcpy(buf->data + buf->len, &val, sizeof(uint32_t));
+    buf->len += sizeof(uint32_t);
+    return EOK;
+}
+
+static errno_t snap_put_data(struct snap_buf *buf,
+                             const uint8_t *data, size_t len)
+{
+    size_t padded;
+    errno_t ret;
+
+    if (len > UINT32_MAX - 4) {
+        return EFBIG;
+    }
+
+    padded = SNAP_ALIGN(len + 1);
+
+    ret = snap_put_u32(buf, len);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = snap_buf_reserve(buf, padded);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    memcpy(buf->data + buf->len, data, len);
+    memset(buf->data + buf->len + len, 0, padded - len);
+    buf->len += padded;
+    return EOK;
+}
+
+static errno_t snap_put_str(struct snap_buf *buf, const char *str)
+{
+    return snap_put_data(buf, (const uint8_t *) str, strlen(str));
+}
+
+static const char *snap_entry_domain(struct ldb_dn *dn, uint32_t *_type)
+{
+    const struct ldb_val *val;
+
+    /* name=<name>,cn=users|groups,cn=<domain>,cn=sysdb */
+    if (ldb_dn_get_comp_num(dn) != 4) {
+        return NULL;
+    }
+
+    val = ldb_dn_get_component_val(dn, 1);
+    if (val == NULL) {
+        return NULL;
+    }
+
+    if (strncasecmp((const char *) val->data, "users", val->length) == 0
+            && val->length == 5) {
+        *_type = SNAP_USER;
+    } else if (strncasecmp((const char *) val->data, "groups",
+                           val->length) == 0 && val->length == 6) {
+        *_type = SNAP_GROUP;
+    } else {
+        return NULL;
+    }
+
+    val = ldb_dn_get_component_val(dn, 2);
+    if (val == NULL) {
+        return NULL;
+    }
+
+    return (const char *) val->data;
+}
+
+static errno_t snap_put_entry(struct snap_buf *buf,
+                              struct ldb_context *ldb,
+                              struct ldb_message *msg,
+                              uint32_t type,
+                              const char *domain,
+                              hash_table_t *groups)
+{
+    struct ldb_message_element *el;
+    struct ldb_message_element *memberof;
+    struct ldb_message_element *alias;
+    struct ldb_dn *dn;
+    const char *name;
+    const char *id_attr;
+    hash_key_t key;
+    hash_value_t value;
+    uint32_t flags = 0;
+    uint32_t num;
+    uint32_t id = 0;
+    size_t count_pos;
+    unsigned int i;
+    unsigned int j;
+    errno_t ret;
+
+    name = ldb_msg_find_attr_as_string(msg, SYSDB_NAME, NULL);
+    if (name == NULL) {
+        return EINVAL;
+    }
+
+    id_attr = type == SNAP_USER ? SYSDB_UIDNUM : SYSDB_GIDNUM;
+    if (ldb_msg_find_element(msg, id_attr) != NULL) {
+        id = ldb_msg_find_attr_as_uint(msg, id_attr, 0);
+        flags |= SNAP_FLAG_HAS_ID;
+    }
+
+    memberof = NULL;
+    if (type == SNAP_USER) {
+        memberof = ldb_msg_find_element(msg, SYSDB_MEMBEROF);
+    }
+
+    ret = snap_put_u32(buf, type);
+    if (ret != EOK) return ret;
+
+    /* the flags are filled in once the groups are resolved */
+    count_pos = buf->len;
+    ret = snap_put_u32(buf, flags);
+    if (ret != EOK) return ret;
+
+    ret = snap_put_u32(buf, id);
+    if (ret != EOK) return ret;
+
+    ret = snap_put_u32(buf, snap_hash_dn(msg->dn));
+    if (ret != EOK) return ret;
+
+    ret = snap_put_str(buf, domain);
+    if (ret != EOK) return ret;
+
+    ret = snap_put_str(buf, ldb_dn_get_linearized(msg->dn));
+    if (ret != EOK) return ret;
+
+    alias = ldb_msg_find_element(msg, SYSDB_NAME_ALIAS);
+    ret = snap_put_u32(buf, 1 + (alias ? alias->num_values : 0));
+    if (ret != EOK) return ret;
+
+    ret = snap_put_str(buf, name);
+    if (ret != EOK) return ret;
+
+    for (i = 0; alias != NULL && i < alias->num_values; i++) {
+        ret = snap_put_data(buf, alias->values[i].data,
+                            alias->values[i].length);
+        if (ret != EOK) return ret;
+    }
+
+    /* The indexes of the groups are only known after the groups were
+     * read, so the users store the memberOf values here and they are
+     * resolved by the caller. */
+    num = 0;
+    for (i = 0; memberof != NULL && i < memberof->num_values; i++) {
+        dn = ldb_dn_from_ldb_val(NULL, ldb, &memberof->values[i]);
+        key.type = HASH_KEY_STRING;
+        key.str = dn ? discard_const(ldb_dn_get_casefold(dn)) : NULL;
+        if (key.str != NULL
+                && hash_lookup(groups, &key, &value) == HASH_SUCCESS) {
+            num++;
+        } else {
+            flags |= SNAP_FLAG_INCOMPLETE;
+        }
+        talloc_free(dn);
+    }
+
+    memcpy(buf->data + count_pos, &flags, sizeof(uint32_t));
+
+    ret = snap_put_u32(buf, num);
+    if (ret != EOK) return ret;
+
+    for (i = 0; memberof != NULL && i < memberof->num_values; i++) {
+        dn = ldb_dn_from_ldb_val(NULL, ldb, &memberof->values[i]);
+        key.type = HASH_KEY_STRING;
+        key.str = dn ? discard_const(ldb_dn_get_casefold(dn)) : NULL;
+        if (key.str != NULL
+                && hash_lookup(groups, &key, &value) == HASH_SUCCESS) {
+            ret = snap_put_u32(buf, value.ul);
+        }
+        talloc_free(dn);
+        if (ret != EOK) return ret;
+    }
+
+    num = 0;
+    for (i = 0; i < msg->num_elements; i++) {
+        if (strcasecmp(msg->elements[i].name, SYSDB_MEMBEROF) != 0
+                && strcasecmp(msg->elements[i].name, SYSDB_NAME_ALIAS) != 0) {
+            num++;
+        }
+    }
+
+    ret = snap_put_u32(buf, num);
+    if (ret != EOK) return ret;
+
+    for (i = 0; i < msg->num_elements; i++) {
+        el = &msg->elements[i];
+        if (strcasecmp(el->name, SYSDB_MEMBEROF) == 0
+                || strcasecmp(el->name, SYSDB_NAME_ALIAS) == 0) {
+            continue;
+        }
+
+        ret = snap_put_str(buf, el->name);
+        if (ret != EOK) return ret;
+
+        ret = snap_put_u32(buf, el->num_values);
+        if (ret != EOK) return ret;
+
+        for (j = 0; j < el->num_values; j++) {
+            ret = snap_put_data(buf, el->values[j].data, el->values[j].length);
+            if (ret != EOK) return ret;
+        }
+    }
+
+    return EOK;
+}
+
+static void snap_ht_insert(uint32_t *ht, uint32_t ht_size,
+                           uint32_t hash, uint32_t idx)
+{
+    uint32_t slot;
+    uint32_t i;
+
+    for (i = 0; i < ht_size; i++) {
+        slot = (hash + i) & (ht_size - 1);
+        if (ht[slot] == 0) {
+            ht[slot] = idx + 1;
+            return;
+        }
+    }
+}
+
+static errno_t snap_build(struct ldb_context *ldb,
+                          struct ldb_result *res,
+                          uint64_t seqnum,
+                          struct snap_buf *buf)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct snap_header *hdr;
+    struct ldb_message_element *alias;
+    hash_table_t *groups;
+    hash_key_t key;
+    hash_value_t value;
+    const char **domains;
+    uint32_t *types;
+    uint32_t *offsets;
+    uint32_t *ht[SNAP_HT_NUM];
+    uint32_t num_entries = 0;
+    uint32_t num_keys = 0;
+    uint32_t ht_size;
+    uint32_t type;
+    const char *name;
+    size_t entries_off;
+    size_t i;
+    size_t j;
+    int t;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    domains = talloc_zero_array(tmp_ctx, const char *, res->count);
+    types = talloc_zero_array(tmp_ctx, uint32_t, res->count);
+    offsets = talloc_zero_array(tmp_ctx, uint32_t, res->count);
+    if (domains == NULL || types == NULL || offsets == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_hash_create(tmp_ctx, res->count, &groups);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    /* Number the entries, groups first so that the users can refer to
+     * them */
+    for (t = 0; t < 2; t++) {
+        for (i = 0; i < res->count; i++) {
+            domains[i] = snap_entry_domain(res->msgs[i]->dn, &type);
+            if (domains[i] == NULL
+                    || ldb_msg_find_element(res->msgs[i], SYSDB_NAME) == NULL
+                    || type != (t == 0 ? SNAP_GROUP : SNAP_USER)) {
+                continue;
+            }
+
+            types[i] = type;
+            if (type == SNAP_GROUP) {
+                key.type = HASH_KEY_STRING;
+                key.str = discard_const(ldb_dn_get_casefold(res->msgs[i]->dn));
+                value.type = HASH_VALUE_ULONG;
+                value.ul = num_entries;
+                if (key.str == NULL
+                        || hash_enter(groups, &key, &value) != HASH_SUCCESS) {
+                    ret = ENOMEM;
+                    goto done;
+                }
+            }
+
+            offsets[num_entries] = i;
+            num_entries++;
+
+            alias = ldb_msg_find_element(res->msgs[i], SYSDB_NAME_ALIAS);
+            num_keys += 2 + (alias ? alias->num_values : 0);
+        }
+    }
+
+    buf->len = 0;
+    ret = snap_buf_reserve(buf, sizeof(struct snap_header));
+    if (ret != EOK) {
+        goto done;
+    }
+    memset(buf->data, 0, sizeof(struct snap_header));
+    buf->len = sizeof(struct snap_header);
+
+    /* offsets[] holds the message of each entry until it is written */
+    for (j = 0; j < num_entries; j++) {
+        i = offsets[j];
+        offsets[j] = buf->len;
+
+        ret = snap_put_entry(buf, ldb, res->msgs[i], types[i], domains[i],
+                             groups);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ht_size = 16;
+    while (ht_size < num_keys * 2) {
+        ht_size *= 2;
+    }
+
+    entries_off = buf->len;
+    ret = snap_buf_reserve(buf, (num_entries + SNAP_HT_NUM * ht_size)
+                                 * sizeof(uint32_t));
+    if (ret != EOK) {
+        goto done;
+    }
+
+    memcpy(buf->data + entries_off, offsets, num_entries * sizeof(uint32_t));
+    buf->len += num_entries * sizeof(uint32_t);
+
+    hdr = (struct snap_header *) buf->data;
+    for (t = 0; t < SNAP_HT_NUM; t++) {
+        hdr->ht[t] = buf->len;
+        ht[t] = (uint32_t *) (buf->data + buf->len);
+        memset(ht[t], 0, ht_size * sizeof(uint32_t));
+        buf->len += ht_size * sizeof(uint32_t);
+    }
+
+    /* the entries are indexed in the same order as they were numbered */
+    j = 0;
+    for (t = 0; t < 2; t++) {
+        for (i = 0; i < res->count; i++) {
+            if (types[i] != (t == 0 ? SNAP_GROUP : SNAP_USER)) {
+                continue;
+            }
+
+            name = ldb_msg_find_attr_as_string(res->msgs[i], SYSDB_NAME, NULL);
+            snap_ht_insert(ht[types[i] == SNAP_USER ? SNAP_HT_USER_NAME
+                                                    : SNAP_HT_GROUP_NAME],
+                           ht_size, snap_hash_name(name), j);
+
+            alias = ldb_msg_find_element(res->msgs[i], SYSDB_NAME_ALIAS);
+            for (type = 0; alias != NULL && type < alias->num_values; type++) {
+                snap_ht_insert(ht[types[i] == SNAP_USER ? SNAP_HT_USER_NAME
+                                                        : SNAP_HT_GROUP_NAME],
+                               ht_size,
+                               snap_hash_name((const char *)
+                                              alias->values[type].data),
+                               j);
+            }
+
+            if (ldb_msg_find_element(res->msgs[i],
+                                     types[i] == SNAP_USER ? SYSDB_UIDNUM
+                                                           : SYSDB_GIDNUM)) {
+                snap_ht_insert(ht[types[i] == SNAP_USER ? SNAP_HT_UID
+                                                        : SNAP_HT_GID],
+                               ht_size,
+                               snap_hash_id(ldb_msg_find_attr_as_uint(
+                                        res->msgs[i],
+                                        types[i] == SNAP_USER ? SYSDB_UIDNUM
+                                                              : SYSDB_GIDNUM,
+                                        0)),
+                               j);
+            }
+
+            j++;
+        }
+    }
+
+    hdr->magic = SNAP_MAGIC;
+    hdr->version = SNAP_VERSION;
+    hdr->seqnum = seqnum;
+    hdr->size = buf->len;
+    hdr->num_entries = num_entries;
+    hdr->entries = entries_off;
+    hdr->ht_size = ht_size;
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Writes data into a temporary file which the caller renames */
+static errno_t snap_write_tmp(const char *tmp_file,
+                              const uint8_t *data, size_t len)
+{
+    int fd;
+    errno_t ret;
+
+    fd = open(tmp_file, O_CREAT | O_TRUNC | O_WRONLY, 0600);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot create %s [%d]: %s\n",
+              tmp_file, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    if (sss_atomic_write_s(fd, discard_const(data), len) != len) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot write %s [%d]: %s\n",
+              tmp_file, ret, sss_strerror(ret));
+        close(fd);
+        unlink(tmp_file);
+        return ret;
+    }
+
+    close(fd);
+    return EOK;
+}
+
+/* Builds the log of a snapshot of the cache at seqnum. The transactions
+ * committed after the cache was read are taken over from the old log. */
+static errno_t snap_log_build(TALLOC_CTX *mem_ctx,
+                              int old_fd,
+                              uint64_t seqnum,
+                              struct snap_buf *buf)
+{
+    struct snap_log_header hdr;
+    struct snap_log_record rec;
+    uint8_t *old = NULL;
+    size_t old_len = 0;
+    size_t rec_len;
+    size_t pos;
+    errno_t ret;
+
+    buf->len = 0;
+
+    hdr.magic = SNAP_LOG_MAGIC;
+    hdr.version = SNAP_LOG_VERSION;
+    hdr.base_seqnum = seqnum;
+
+    ret = snap_buf_reserve(buf, sizeof(hdr));
+    if (ret != EOK) {
+        return ret;
+    }
+    memcpy(buf->data, &hdr, sizeof(hdr));
+    buf->len = sizeof(hdr);
+
+    if (old_fd == -1 || snap_log_read(mem_ctx, old_fd, &old, &old_len) != EOK) {
+        return EOK;
+    }
+
+    for (pos = sizeof(hdr); pos + sizeof(rec) <= old_len; pos += rec_len) {
+        memcpy(&rec, old + pos, sizeof(rec));
+        if (rec.num_hashes > (old_len - pos - sizeof(rec)) / sizeof(uint32_t)) {
+            break;
+        }
+        rec_len = sizeof(rec) + rec.num_hashes * sizeof(uint32_t);
+
+        if (rec.state == SNAP_LOG_ABORTED || rec.seq_start < seqnum) {
+            continue;
+        }
+
+        ret = snap_buf_reserve(buf, rec_len);
+        if (ret != EOK) {
+            break;
+        }
+        memcpy(buf->data + buf->len, old + pos, rec_len);
+        buf->len += rec_len;
+    }
+
+    talloc_free(old);
+    return ret;
+}
+
+errno_t sysdb_snapshot_update(struct sysdb_ctx *sysdb, bool *_written)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *attrs[] = { SYSDB_NAME, SYSDB_UIDNUM, SYSDB_GIDNUM,
+                                   SYSDB_GECOS, SYSDB_HOMEDIR, SYSDB_SHELL,
+                                   SYSDB_DEFAULT_ATTRS,
+                                   SYSDB_PRIMARY_GROUP_GIDNUM,
+                                   SYSDB_SID_STR, SYSDB_UPN,
+                                   SYSDB_MEMBERUID, SYSDB_MEMBER,
+                                   SYSDB_GHOST, SYSDB_POSIX, SYSDB_ORIG_DN,
+                                   SYSDB_OVERRIDE_DN,
+                                   SYSDB_OVERRIDE_OBJECT_DN,
+                                   SYSDB_DEFAULT_OVERRIDE_NAME,
+                                   SYSDB_NAME_ALIAS, SYSDB_MEMBEROF,
+                                   NULL };
+    struct sysdb_snapshot *snap;
+    struct snap_buf buf = { NULL, 0, 0 };
+    struct snap_buf log_buf = { NULL, 0, 0 };
+    struct ldb_result *res;
+    struct ldb_dn *base_dn;
+    uint64_t seqnum;
+    uint64_t seqnum_after;
+    char *tmp_file = NULL;
+    char *tmp_log_file = NULL;
+    int log_fd = -1;
+    errno_t ret;
+
+    if (_written != NULL) {
+        *_written = false;
+    }
+
+    snap = sysdb_snapshot_ctx(sysdb);
+    if (snap == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_snapshot_seqnum(sysdb, &seqnum);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (snap->written && snap->written_seqnum == seqnum) {
+        /* nothing changed */
+        return EOK;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    base_dn = ldb_dn_new(tmp_ctx, sysdb->ldb, SYSDB_BASE);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_search(sysdb->ldb, tmp_ctx, &res, base_dn, LDB_SCOPE_SUBTREE,
+                     attrs, "(|("SYSDB_UC")("SYSDB_GC"))");
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    /* The search is not atomic with respect to the sequence number, make
+     * sure nothing was written meanwhile. */
+    ret = sysdb_snapshot_seqnum(sysdb, &seqnum_after);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (seqnum_after != seqnum) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "The cache was modified while reading it, not writing the "
+              "snapshot now\n");
+        ret = EAGAIN;
+        goto done;
+    }
+
+    ret = snap_build(sysdb->ldb, res, seqnum, &buf);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot build the snapshot [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto done;
+    }
+
+    /* The writers append to the old log until the new one is in place */
+    log_fd = snap_log_open(snap, O_RDWR, F_WRLCK);
+
+    ret = snap_log_build(tmp_ctx, log_fd, seqnum, &log_buf);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    tmp_file = talloc_asprintf(tmp_ctx, "%s.tmp", snap->file);
+    tmp_log_file = talloc_asprintf(tmp_ctx, "%s.tmp", snap->log_file);
+    if (tmp_file == NULL || tmp_log_file == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = snap_write_tmp(tmp_log_file, log_buf.data, log_buf.len);
+    if (ret != EOK) {
+        tmp_log_file = NULL;
+        goto done;
+    }
+
+    ret = snap_write_tmp(tmp_file, buf.data, buf.len);
+    if (ret != EOK) {
+        tmp_file = NULL;
+        goto done;
+    }
+
+    /* readers which still map the previous snapshot keep their copy, until
+     * the new log is in place as well they do not trust either */
+    if (rename(tmp_file, snap->file) == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot rename %s [%d]: %s\n",
+              tmp_file, ret, sss_strerror(ret));
+        goto done;
+    }
+    tmp_file = NULL;
+
+    if (rename(tmp_log_file, snap->log_file) == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot rename %s [%d]: %s\n",
+              tmp_log_file, ret, sss_strerror(ret));
+        goto done;
+    }
+    tmp_log_file = NULL;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Wrote snapshot of %u entries (%zu bytes)\n",
+          res->count, buf.len);
+
+    snap->written = true;
+    snap->written_seqnum = seqnum;
+    /* let a reader and the writers in this process pick up the new files
+     * right away */
+    snap->last_check = 0;
+    snap->log_check = 0;
+    if (_written != NULL) {
+        *_written = true;
+    }
+
+    ret = EOK;
+
+done:
+    if (log_fd != -1) {
+        close(log_fd);
+    }
+    if (tmp_file != NULL) {
+        unlink(tmp_file);
+    }
+    if (tmp_log_file != NULL) {
+        unlink(tmp_log_file);
+    }
+    talloc_free(buf.data);
+    talloc_free(log_buf.data);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t sysdb_snapshot_remove(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_snapshot *snap;
+
+    snap = sysdb_snapshot_ctx(sysdb);
+    if (snap == NULL) {
+        return ENOMEM;
+    }
+
+    snap->written = false;
+    snap->log_check = 0;
+
+    if (unlink(snap->log_file) == -1 && errno != ENOENT) {
+        return errno;
+    }
+
+    if (unlink(snap->file) == -1 && errno != ENOENT) {
+        return errno;
+    }
+
+    return EOK;
+}
+
+errno_t sysdb_snapshot_set_changed_cb(struct sysdb_ctx *sysdb,
+                                      sysdb_snapshot_changed_fn fn,
+                                      void *pvt)
+{
+    struct sysdb_snapshot *snap;
+
+    snap = sysdb_snapshot_ctx(sysdb);
+    if (snap == NULL) {
+        return ENOMEM;
+    }
+
+    snap->changed_fn = fn;
+    snap->changed_pvt = pvt;
+    return EOK;
+}
+
+/* =Change-log============================================================== */
+
+static bool snap_log_exists(struct sysdb_snapshot *snap)
+{
+    time_t now;
+
+    now = time(NULL);
+    if (snap->log_check + SNAP_RECHECK_INTERVAL <= now
+            || snap->log_check > now) {
+        snap->log_exists = access(snap->log_file, F_OK) == 0;
+        snap->log_check = now;
+    }
+
+    return snap->log_exists;
+}
+
+static void snap_pending_reset(struct sysdb_snapshot *snap)
+{
+    snap->in_transaction = false;
+    snap->logging = false;
+    snap->changed = false;
+    snap->pending_flags = 0;
+    snap->num_pending = 0;
+    talloc_zfree(snap->pending);
+}
+
+void sysdb_snapshot_begin(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_snapshot *snap;
+
+    snap = sysdb_snapshot_ctx(sysdb);
+    if (snap == NULL) {
+        return;
+    }
+
+    snap_pending_reset(snap);
+
+    /* nobody reads the log unless there is a snapshot */
+    snap->logging = snap_log_exists(snap);
+    if (!snap->logging && snap->changed_fn == NULL) {
+        return;
+    }
+
+    /* the transaction keeps the sequence number from changing */
+    if (sysdb_snapshot_seqnum(sysdb, &snap->seq_start) != EOK) {
+        snap->logging = false;
+        return;
+    }
+
+    snap->in_transaction = true;
+}
+
+static bool snap_msg_changes_members(const struct ldb_message *msg)
+{
+    const char *attrs[] = { SYSDB_MEMBER, SYSDB_MEMBEROF, SYSDB_MEMBERUID,
+                            SYSDB_GHOST, NULL };
+    unsigned int i;
+    size_t j;
+
+    for (i = 0; i < msg->num_elements; i++) {
+        for (j = 0; attrs[j] != NULL; j++) {
+            if (strcasecmp(msg->elements[i].name, attrs[j]) == 0) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void sysdb_snapshot_changed(struct sysdb_ctx *sysdb,
+                            struct ldb_dn *dn,
+                            const struct ldb_message *msg)
+{
+    struct sysdb_snapshot *snap = sysdb->snapshot;
+    uint32_t *pending;
+    uint32_t type;
+
+    if (snap == NULL || !snap->logging || dn == NULL
+            || (snap->pending_flags & SNAP_LOG_ALL)) {
+        return;
+    }
+
+    if (snap_entry_domain(dn, &type) == NULL) {
+        /* not in the snapshot */
+        return;
+    }
+
+    /* The memberof plugin updates the related users and groups as well */
+    if (type == SNAP_GROUP && (msg == NULL || snap_msg_changes_members(msg))) {
+        snap->pending_flags |= SNAP_LOG_GROUPS;
+        return;
+    }
+
+    if (type == SNAP_USER && msg == NULL) {
+        snap->pending_flags |= SNAP_LOG_GROUPS;
+    }
+
+    if (snap->num_pending == SNAP_LOG_MAX_DNS) {
+        snap->pending_flags |= SNAP_LOG_ALL;
+        snap->num_pending = 0;
+        talloc_zfree(snap->pending);
+        return;
+    }
+
+    if (snap->num_pending % 64 == 0) {
+        pending = talloc_realloc(snap, snap->pending, uint32_t,
+                                 snap->num_pending + 64);
+        if (pending == NULL) {
+            snap->pending_flags |= SNAP_LOG_ALL;
+            return;
+        }
+        snap->pending = pending;
+    }
+
+    snap->pending[snap->num_pending] = snap_hash_dn(dn);
+    snap->num_pending++;
+}
+
+void sysdb_snapshot_commit(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_snapshot *snap = sysdb->snapshot;
+    struct snap_log_record rec;
+    struct snap_buf buf = { NULL, 0, 0 };
+    uint64_t seq_end;
+    off_t off;
+    int fd;
+
+    if (snap == NULL || !snap->in_transaction) {
+        return;
+    }
+
+    if (sysdb_snapshot_seqnum(sysdb, &seq_end) != EOK) {
+        /* the transaction is not logged, the readers notice the gap */
+        snap->changed = true;
+        return;
+    }
+
+    snap->changed = (seq_end != snap->seq_start);
+    if (!snap->logging || !snap->changed) {
+        return;
+    }
+
+    fd = snap_log_open(snap, O_RDWR, F_WRLCK);
+    if (fd == -1) {
+        return;
+    }
+
+    off = lseek(fd, 0, SEEK_END);
+    if (off < (off_t) sizeof(struct snap_log_header)) {
+        close(fd);
+        return;
+    }
+
+    if (off > SNAP_LOG_MAX_SIZE) {
+        snap->pending_flags |= SNAP_LOG_ALL;
+    }
+    if (snap->pending_flags & SNAP_LOG_ALL) {
+        snap->num_pending = 0;
+    }
+
+    memset(&rec, 0, sizeof(rec));
+    rec.state = SNAP_LOG_PENDING;
+    rec.flags = snap->pending_flags;
+    rec.seq_start = snap->seq_start;
+    rec.seq_end = seq_end;
+    rec.num_hashes = snap->num_pending;
+
+    if (snap_buf_reserve(&buf, sizeof(rec)
+                               + snap->num_pending * sizeof(uint32_t)) != EOK) {
+        close(fd);
+        return;
+    }
+    memcpy(buf.data, &rec, sizeof(rec));
+    if (snap->num_pending > 0) {
+        memcpy(buf.data + sizeof(rec), snap->pending,
+               snap->num_pending * sizeof(uint32_t));
+    }
+    buf.len = sizeof(rec) + snap->num_pending * sizeof(uint32_t);
+
+    if (sss_atomic_write_s(fd, buf.data, buf.len) != buf.len) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Cannot append to the snapshot log\n");
+        /* a partial record ends the log for the readers */
+        close(fd);
+        talloc_free(buf.data);
+        return;
+    }
+    talloc_free(buf.data);
+
+    snap_log_lock(fd, F_UNLCK);
+    snap->log_fd = fd;
+    snap->log_record = off;
+}
+
+void sysdb_snapshot_finish(struct sysdb_ctx *sysdb, bool committed)
+{
+    struct sysdb_snapshot *snap = sysdb->snapshot;
+    uint32_t state;
+
+    if (snap == NULL || !snap->in_transaction) {
+        return;
+    }
+
+    if (snap->log_fd != -1) {
+        state = committed ? SNAP_LOG_DONE : SNAP_LOG_ABORTED;
+
+        if (snap_log_lock(snap->log_fd, F_WRLCK) == EOK) {
+            if (pwrite(snap->log_fd, &state, sizeof(state),
+                       snap->log_record
+                       + offsetof(struct snap_log_record, state))
+                    != sizeof(state)) {
+                DEBUG(SSSDBG_MINOR_FAILURE,
+                      "Cannot update the snapshot log\n");
+            }
+            snap_log_lock(snap->log_fd, F_UNLCK);
+        }
+
+        close(snap->log_fd);
+        snap->log_fd = -1;
+    }
+
+    if (committed && snap->changed && snap->changed_fn != NULL) {
+        snap->changed_fn(snap->changed_pvt);
+    }
+
+    snap_pending_reset(snap);
+}
+
+/* =Reader================================================================= */
+
+struct snap_cursor {
+    const uint8_t *base;
+    size_t end;
+    size_t pos;
+    bool error;
+};
+
+static uint32_t snap_get_u32(struct snap_cursor *cur)
+{
+    uint32_t val;
+
+    if (cur->error || cur->pos + sizeof(uint32_t) > cur->end) {
+        cur->error = true;
+        return 0;
+    }
+
+    memcpy(&val, cur->base + cur->pos, sizeof(uint32_t));
+    cur->pos += sizeof(uint32_t);
+    return val;
+}
+
+static const char *snap_get_data(struct snap_cursor *cur, uint32_t *_len)
+{
+    const char *data;
+    uint32_t len;
+
+    len = snap_get_u32(cur);
+    if (cur->error || len > cur->end - cur->pos
+            || SNAP_ALIGN(len + 1) > cur->end - cur->pos) {
+        cur->error = true;
+        return NULL;
+    }
+
+    data = (const char *) cur->base + cur->pos;
+    if (data[len] != '\0') {
+        cur->error = true;
+        return NULL;
+    }
+
+    cur->pos += SNAP_ALIGN(len + 1);
+    if (_len != NULL) {
+        *_len = len;
+    }
+    return data;
+}
+
+struct snap_entry {
+    uint32_t type;
+    uint32_t flags;
+    uint32_t id;
+    uint32_t dn_hash;
+    const char *domain;
+    const char *dn;
+    uint32_t num_names;
+    size_t names;
+    uint32_t num_groups;
+    size_t groups;
+    uint32_t num_elements;
+    size_t elements;
+};
+
+static bool snap_read_entry(struct snap_header *hdr, uint32_t idx,
+                            struct snap_entry *entry)
+{
+    struct snap_cursor cur;
+    uint32_t off;
+    uint32_t i;
+
+    if (idx >= hdr->num_entries) {
+        return false;
+    }
+
+    memcpy(&off, (uint8_t *) hdr + hdr->entries + idx * sizeof(uint32_t),
+           sizeof(uint32_t));
+
+    cur.base = (const uint8_t *) hdr;
+    cur.end = hdr->entries;
+    cur.pos = off;
+    cur.error = off < sizeof(struct snap_header);
+
+    entry->type = snap_get_u32(&cur);
+    entry->flags = snap_get_u32(&cur);
+    entry->id = snap_get_u32(&cur);
+    entry->dn_hash = snap_get_u32(&cur);
+    entry->domain = snap_get_data(&cur, NULL);
+    entry->dn = snap_get_data(&cur, NULL);
+
+    entry->num_names = snap_get_u32(&cur);
+    entry->names = cur.pos;
+    for (i = 0; i < entry->num_names && !cur.error; i++) {
+        snap_get_data(&cur, NULL);
+    }
+
+    entry->num_groups = snap_get_u32(&cur);
+    entry->groups = cur.pos;
+    if (entry->num_groups > (cur.end - cur.pos) / sizeof(uint32_t)) {
+        return false;
+    }
+    cur.pos += entry->num_groups * sizeof(uint32_t);
+
+    entry->num_elements = snap_get_u32(&cur);
+    entry->elements = cur.pos;
+
+    return !cur.error;
+}
+
+static bool snap_entry_has_name(struct snap_header *hdr,
+                                struct snap_entry *entry,
+                                const char *name)
+{
+    struct snap_cursor cur;
+    const char *val;
+    uint32_t i;
+
+    cur.base = (const uint8_t *) hdr;
+    cur.end = hdr->entries;
+    cur.pos = entry->names;
+    cur.error = false;
+
+    for (i = 0; i < entry->num_names; i++) {
+        val = snap_get_data(&cur, NULL);
+        if (val == NULL) {
+            return false;
+        }
+
+        if (strcmp(val, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static struct ldb_message *snap_entry_to_msg(TALLOC_CTX *mem_ctx,
+                                             struct ldb_context *ldb,
+                                             struct snap_header *hdr,
+                                             struct snap_entry *entry,
+                                             const char **attrs)
+{
+    struct ldb_message *msg;
+    struct ldb_message_element *el;
+    struct snap_cursor cur;
+    const char *name;
+    const char *val;
+    uint32_t num_values;
+    uint32_t len;
+    uint32_t i;
+    uint32_t j;
+    bool wanted;
+    int ret;
+
+    msg = ldb_msg_new(mem_ctx);
+    if (msg == NULL) {
+        return NULL;
+    }
+
+    msg->dn = ldb_dn_new(msg, ldb, entry->dn);
+    if (msg->dn == NULL) {
+        goto fail;
+    }
+
+    cur.base = (const uint8_t *) hdr;
+    cur.end = hdr->entries;
+    cur.pos = entry->elements;
+    cur.error = false;
+
+    for (i = 0; i < entry->num_elements; i++) {
+        name = snap_get_data(&cur, NULL);
+        num_values = snap_get_u32(&cur);
+        if (cur.error) {
+            goto fail;
+        }
+
+        wanted = false;
+        for (j = 0; attrs[j] != NULL; j++) {
+            if (strcasecmp(attrs[j], name) == 0) {
+                wanted = true;
+                break;
+            }
+        }
+
+        el = NULL;
+        if (wanted) {
+            ret = ldb_msg_add_empty(msg, name, 0, &el);
+            if (ret != LDB_SUCCESS) {
+                goto fail;
+            }
+
+            el->values = talloc_zero_array(msg->elements, struct ldb_val,
+                                           num_values);
+            if (el->values == NULL && num_values != 0) {
+                goto fail;
+            }
+        }
+
+        for (j = 0; j < num_values; j++) {
+            val = snap_get_data(&cur, &len);
+            if (val == NULL) {
+                goto fail;
+            }
+
+            if (el == NULL) {
+                continue;
+            }
+
+            el->values[j].data = talloc_memdup(el->values, val, len + 1);
+            if (el->values[j].data == NULL) {
+                goto fail;
+            }
+            el->values[j].length = len;
+            el->num_values++;
+        }
+    }
+
+    return msg;
+
+fail:
+    talloc_free(msg);
+    return NULL;
+}
+
+static void snap_unmap(struct sysdb_snapshot *snap)
+{
+    if (snap->base != NULL) {
+        munmap(snap->base, snap->size);
+        snap->base = NULL;
+        snap->size = 0;
+    }
+}
+
+static errno_t snap_map(struct sysdb_snapshot *snap)
+{
+    struct snap_header *hdr;
+    struct stat st;
+    void *base;
+    int fd;
+    int t;
+    errno_t ret;
+
+    fd = open(snap->file, O_RDONLY);
+    if (fd == -1) {
+        return errno;
+    }
+
+    ret = fstat(fd, &st);
+    if (ret == -1) {
+        ret = errno;
+        close(fd);
+        return ret;
+    }
+
+    if (snap->base != NULL && st.st_dev == snap->dev
+            && st.st_ino == snap->ino) {
+        /* still the same file */
+        close(fd);
+        return EOK;
+    }
+
+    snap_unmap(snap);
+
+    if (st.st_size < (off_t) sizeof(struct snap_header)
+            || st.st_size > UINT32_MAX) {
+        close(fd);
+        return EINVAL;
+    }
+
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return errno;
+    }
+
+    hdr = base;
+    if (hdr->magic != SNAP_MAGIC || hdr->version != SNAP_VERSION
+            || hdr->size != st.st_size
+            || hdr->entries < sizeof(struct snap_header)
+            || hdr->entries > hdr->size
+            || hdr->num_entries > (hdr->size - hdr->entries) / sizeof(uint32_t)
+            || hdr->ht_size == 0
+            || (hdr->ht_size & (hdr->ht_size - 1)) != 0) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Ignoring invalid snapshot %s\n",
+              snap->file);
+        munmap(base, st.st_size);
+        return EINVAL;
+    }
+
+    for (t = 0; t < SNAP_HT_NUM; t++) {
+        if (hdr->ht[t] < hdr->entries
+                || hdr->ht_size > (hdr->size - hdr->ht[t]) / sizeof(uint32_t)) {
+            munmap(base, st.st_size);
+            return EINVAL;
+        }
+    }
+
+    snap->base = base;
+    snap->size = st.st_size;
+    snap->dev = st.st_dev;
+    snap->ino = st.st_ino;
+
+    return EOK;
+}
+
+/* Reads the changes logged between the snapshot at base and the cache
+ * at seqnum */
+static void snap_log_load(struct sysdb_snapshot *snap,
+                          uint64_t base, uint64_t seqnum)
+{
+    struct snap_log_header hdr;
+    struct snap_log_record rec;
+    uint32_t *hashes;
+    uint8_t *data = NULL;
+    size_t len = 0;
+    size_t rec_len;
+    size_t pos;
+    uint64_t chain;
+    bool reached;
+    int fd;
+    errno_t ret;
+
+    snap->log_base = base;
+    snap->log_seqnum = seqnum;
+    snap->log_read = time(NULL);
+    snap->log_valid = false;
+    snap->log_flags = 0;
+    snap->log_num_hashes = 0;
+    talloc_zfree(snap->log_hashes);
+
+    fd = snap_log_open(snap, O_RDONLY, F_RDLCK);
+    if (fd == -1) {
+        return;
+    }
+
+    ret = snap_log_read(snap, fd, &data, &len);
+    close(fd);
+    if (ret != EOK) {
+        return;
+    }
+
+    memcpy(&hdr, data, sizeof(hdr));
+    if (hdr.magic != SNAP_LOG_MAGIC || hdr.version != SNAP_LOG_VERSION
+            || hdr.base_seqnum != base) {
+        goto done;
+    }
+
+    /* Every change of the sequence number since the snapshot was written
+     * must belong to a committed transaction in the log. The changes of
+     * the other transactions are taken into account as well. */
+    chain = base;
+    reached = (chain == seqnum);
+    for (pos = sizeof(hdr); pos + sizeof(rec) <= len; pos += rec_len) {
+        memcpy(&rec, data + pos, sizeof(rec));
+        if (rec.num_hashes > (len - pos - sizeof(rec)) / sizeof(uint32_t)) {
+            break;
+        }
+        rec_len = sizeof(rec) + rec.num_hashes * sizeof(uint32_t);
+
+        if (rec.state == SNAP_LOG_ABORTED) {
+            continue;
+        }
+
+        if (rec.state == SNAP_LOG_DONE && rec.seq_start == chain) {
+            chain = rec.seq_end;
+            reached = reached || (chain == seqnum);
+        }
+
+        snap->log_flags |= rec.flags;
+        if (rec.num_hashes == 0) {
+            continue;
+        }
+
+        hashes = talloc_realloc(snap, snap->log_hashes, uint32_t,
+                                snap->log_num_hashes + rec.num_hashes);
+        if (hashes == NULL) {
+            goto done;
+        }
+        memcpy(hashes + snap->log_num_hashes, data + pos + sizeof(rec),
+               rec.num_hashes * sizeof(uint32_t));
+        snap->log_hashes = hashes;
+        snap->log_num_hashes += rec.num_hashes;
+    }
+
+    if (!reached || (snap->log_flags & SNAP_LOG_ALL)) {
+        goto done;
+    }
+
+    if (snap->log_num_hashes > 0) {
+        qsort(snap->log_hashes, snap->log_num_hashes, sizeof(uint32_t),
+              snap_hash_cmp);
+    }
+    snap->log_valid = true;
+
+done:
+    talloc_free(data);
+}
+
+/* Returns the snapshot if it was built from the current content of the
+ * cache, or if the log tells which of its entries were changed since */
+static struct snap_header *sysdb_snapshot_get(struct sysdb_ctx *sysdb)
+{
+    struct sysdb_snapshot *snap;
+    struct snap_header *hdr;
+    uint64_t seqnum;
+    time_t now;
+    errno_t ret;
+
+    snap = sysdb_snapshot_ctx(sysdb);
+    if (snap == NULL) {
+        return NULL;
+    }
+
+    ret = sysdb_snapshot_seqnum(sysdb, &seqnum);
+    if (ret != EOK) {
+        return NULL;
+    }
+
+    now = time(NULL);
+
+    hdr = (struct snap_header *) snap->base;
+    if (hdr == NULL || hdr->seqnum != seqnum) {
+        if (snap->last_check + SNAP_RECHECK_INTERVAL <= now
+                || snap->last_check > now) {
+            snap->last_check = now;
+
+            ret = snap_map(snap);
+            if (ret != EOK && ret != ENOENT) {
+                DEBUG(SSSDBG_TRACE_FUNC, "Cannot map snapshot %s [%d]: %s\n",
+                      snap->file, ret, sss_strerror(ret));
+            }
+        }
+
+        hdr = (struct snap_header *) snap->base;
+        if (hdr == NULL) {
+            return NULL;
+        }
+    }
+
+    if (hdr->seqnum == seqnum) {
+        snap->exact = true;
+        return hdr;
+    }
+
+    /* A log which does not cover the changes yet may be completed by the
+     * writers meanwhile */
+    if (snap->log_base != hdr->seqnum || snap->log_seqnum != seqnum
+            || (!snap->log_valid
+                && (snap->log_read + SNAP_RECHECK_INTERVAL <= now
+                    || snap->log_read > now))) {
+        snap_log_load(snap, hdr->seqnum, seqnum);
+    }
+
+    if (!snap->log_valid) {
+        return NULL;
+    }
+
+    snap->exact = false;
+    return hdr;
+}
+
+/* Whether the entry was not changed since the snapshot was written */
+static bool snap_entry_current(struct sysdb_snapshot *snap,
+                               struct snap_entry *entry)
+{
+    if (snap->exact) {
+        return true;
+    }
+
+    if (entry->type == SNAP_GROUP && (snap->log_flags & SNAP_LOG_GROUPS)) {
+        return false;
+    }
+
+    return bsearch(&entry->dn_hash, snap->log_hashes, snap->log_num_hashes,
+                   sizeof(uint32_t), snap_hash_cmp) == NULL;
+}
+
+static errno_t snap_result_add(struct ldb_result *res,
+                               struct ldb_message *msg)
+{
+    struct ldb_message **msgs;
+
+    msgs = talloc_realloc(res, res->msgs, struct ldb_message *,
+                          res->count + 2);
+    if (msgs == NULL) {
+        return ENOMEM;
+    }
+
+    msgs[res->count] = talloc_steal(msgs, msg);
+    msgs[res->count + 1] = NULL;
+    res->msgs = msgs;
+    res->count++;
+
+    return EOK;
+}
+
+/* Collects the entries of the domain with the given key into idx[] */
+static size_t snap_lookup(struct snap_header *hdr,
+                          enum snap_table table,
+                          struct sss_domain_info *domain,
+                          uint32_t hash,
+                          const char *name,
+                          uint32_t id,
+                          uint32_t *idx,
+                          size_t max)
+{
+    struct snap_entry entry;
+    uint32_t *ht;
+    uint32_t slot;
+    uint32_t val;
+    uint32_t i;
+    size_t count = 0;
+    size_t j;
+    bool match;
+
+    ht = (uint32_t *) ((uint8_t *) hdr + hdr->ht[table]);
+
+    for (i = 0; i < hdr->ht_size && count < max; i++) {
+        slot = (hash + i) & (hdr->ht_size - 1);
+        val = ht[slot];
+        if (val == 0) {
+            break;
+        }
+
+        if (!snap_read_entry(hdr, val - 1, &entry)) {
+            continue;
+        }
+
+        if (strcasecmp(entry.domain, domain->name) != 0) {
+            continue;
+        }
+
+        if (name != NULL) {
+            match = snap_entry_has_name(hdr, &entry, name);
+        } else {
+            match = (entry.flags & SNAP_FLAG_HAS_ID) && entry.id == id;
+        }
+
+        if (!match) {
+            continue;
+        }
+
+        /* an entry can be found by its name and by an alias */
+        for (j = 0; j < count; j++) {
+            if (idx[j] == val - 1) break;
+        }
+        if (j == count) {
+            idx[count] = val - 1;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+#define SNAP_MAX_MATCHES 16
+
+/* Finds the entries the same way as the name and ID filters of the
+ * searches in sysdb_search.c. Returns ENOENT if the snapshot cannot answer
+ * the lookup, the caller then searches the cache. */
+static errno_t snap_find(struct snap_header *hdr,
+                         enum snap_table table,
+                         struct sss_domain_info *domain,
+                         const char *name,
+                         uint32_t id,
+                         uint32_t *idx,
+                         size_t *_count)
+{
+    uint32_t found[SNAP_MAX_MATCHES];
+    char *lc_name;
+    size_t count;
+    size_t num;
+    size_t i;
+    size_t j;
+
+    if (name == NULL) {
+        count = snap_lookup(hdr, table, domain, snap_hash_id(id),
+                            NULL, id, idx, SNAP_MAX_MATCHES);
+    } else {
+        count = snap_lookup(hdr, table, domain, snap_hash_name(name),
+                            name, 0, idx, SNAP_MAX_MATCHES);
+
+        /* the nameAlias=<lowercased name> part of the filter */
+        if (!domain->case_sensitive) {
+            lc_name = sss_tc_utf8_str_tolower(NULL, name);
+            if (lc_name == NULL) {
+                return ENOMEM;
+            }
+
+            num = 0;
+            if (strcmp(lc_name, name) != 0) {
+                num = snap_lookup(hdr, table, domain,
+                                  snap_hash_name(lc_name), lc_name, 0,
+                                  found, SNAP_MAX_MATCHES);
+            }
+            talloc_free(lc_name);
+
+            for (i = 0; i < num && count < SNAP_MAX_MATCHES; i++) {
+                for (j = 0; j < count; j++) {
+                    if (idx[j] == found[i]) break;
+                }
+                if (j == count) {
+                    idx[count] = found[i];
+                    count++;
+                }
+            }
+        }
+    }
+
+    /* Misses are left to the cache, the snapshot skips entries it cannot
+     * index and the negative cache of the responders keeps them rare. */
+    if (count == 0 || count == SNAP_MAX_MATCHES) {
+        return ENOENT;
+    }
+
+    *_count = count;
+    return EOK;
+}
+
+static errno_t sysdb_snapshot_search(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     enum snap_table table,
+                                     const char *name,
+                                     uint32_t id,
+                                     const char **attrs,
+                                     struct ldb_result **_res)
+{
+    struct snap_header *hdr;
+    struct snap_entry entry;
+    struct ldb_result *res;
+    struct ldb_message *msg;
+    uint32_t idx[SNAP_MAX_MATCHES];
+    size_t count;
+    size_t i;
+    errno_t ret;
+
+    hdr = sysdb_snapshot_get(domain->sysdb);
+    if (hdr == NULL) {
+        return ENOENT;
+    }
+
+    ret = snap_find(hdr, table, domain, name, id, idx, &count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    res = talloc_zero(mem_ctx, struct ldb_result);
+    if (res == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!snap_read_entry(hdr, idx[i], &entry)
+                || !snap_entry_current(domain->sysdb->snapshot, &entry)) {
+            ret = ENOENT;
+            goto fail;
+        }
+
+        msg = snap_entry_to_msg(res, domain->sysdb->ldb, hdr, &entry, attrs);
+        if (msg == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+
+        ret = snap_result_add(res, msg);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
+    sss_stats_count("sysdb.snapshot.hits", 1);
+
+    *_res = res;
+    return EOK;
+
+fail:
+    talloc_free(res);
+    return ret;
+}
+
+errno_t sysdb_snapshot_getpwnam(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                const char *name,
+                                const char **attrs,
+                                struct ldb_result **_res)
+{
+    return sysdb_snapshot_search(mem_ctx, domain, SNAP_HT_USER_NAME,
+                                 name, 0, attrs, _res);
+}
+
+errno_t sysdb_snapshot_getpwuid(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                uid_t uid,
+                                const char **attrs,
+                                struct ldb_result **_res)
+{
+    return sysdb_snapshot_search(mem_ctx, domain, SNAP_HT_UID,
+                                 NULL, uid, attrs, _res);
+}
+
+errno_t sysdb_snapshot_getgrnam(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                const char *name,
+                                const char **attrs,
+                                struct ldb_result **_res)
+{
+    /* groups of MPG domains are converted from the users */
+    if (domain->mpg) {
+        return ENOENT;
+    }
+
+    return sysdb_snapshot_search(mem_ctx, domain, SNAP_HT_GROUP_NAME,
+                                 name, 0, attrs, _res);
+}
+
+errno_t sysdb_snapshot_getgrgid(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *domain,
+                                gid_t gid,
+                                const char **attrs,
+                                struct ldb_result **_res)
+{
+    if (domain->mpg) {
+        return ENOENT;
+    }
+
+    return sysdb_snapshot_search(mem_ctx, domain, SNAP_HT_GID,
+                                 NULL, gid, attrs, _res);
+}
+
+errno_t sysdb_snapshot_initgroups(TALLOC_CTX *mem_ctx,
+                                  struct sss_domain_info *domain,
+                                  const char *name,
+                                  const char **pw_attrs,
+                                  const char **gr_attrs,
+                                  struct ldb_result **_res)
+{
+    struct sysdb_snapshot *snap;
+    struct snap_header *hdr;
+    struct snap_entry user;
+    struct snap_entry group;
+    struct ldb_result *res;
+    struct ldb_message *msg;
+    uint32_t idx[SNAP_MAX_MATCHES];
+    size_t count;
+    uint32_t gidx;
+    uint32_t i;
+    errno_t ret;
+
+    hdr = sysdb_snapshot_get(domain->sysdb);
+    if (hdr == NULL) {
+        return ENOENT;
+    }
+    snap = domain->sysdb->snapshot;
+
+    /* the memberships of the user may have changed */
+    if (!snap->exact && (snap->log_flags & SNAP_LOG_GROUPS)) {
+        return ENOENT;
+    }
+
+    ret = snap_find(hdr, SNAP_HT_USER_NAME, domain, name, 0, idx, &count);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* sysdb_initgroups() fails in this case, let it report it */
+    if (count != 1) {
+        return ENOENT;
+    }
+
+    if (!snap_read_entry(hdr, idx[0], &user)
+            || (user.flags & SNAP_FLAG_INCOMPLETE)
+            || !snap_entry_current(snap, &user)) {
+        return ENOENT;
+    }
+
+    res = talloc_zero(mem_ctx, struct ldb_result);
+    if (res == NULL) {
+        return ENOMEM;
+    }
+
+    msg = snap_entry_to_msg(res, domain->sysdb->ldb, hdr, &user, pw_attrs);
+    if (msg == NULL) {
+        ret = ENOMEM;
+        goto fail;
+    }
+
+    ret = snap_result_add(res, msg);
+    if (ret != EOK) {
+        goto fail;
+    }
+
+    for (i = 0; i < user.num_groups; i++) {
+        memcpy(&gidx, (uint8_t *) hdr + user.groups + i * sizeof(uint32_t),
+               sizeof(uint32_t));
+
+        if (!snap_read_entry(hdr, gidx, &group)
+                || !snap_entry_current(snap, &group)) {
+            ret = ENOENT;
+            goto fail;
+        }
+
+        /* the same as SYSDB_INITGR_FILTER */
+        if (group.type != SNAP_GROUP || !(group.flags & SNAP_FLAG_HAS_ID)) {
+            continue;
+        }
+
+        msg = snap_entry_to_msg(res, domain->sysdb->ldb, hdr, &group,
+                                gr_attrs);
+        if (msg == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+
+        ret = snap_result_add(res, msg);
+        if (ret != EOK) {
+            goto fail;
+        }
+    }
+
+    sss_stats_count("sysdb.snapshot.hits", 1);
+
+    *_res = res;
+    return EOK;
+
+fail:
+    talloc_free(res);
+    return ret;
+}
@@ -27,12 +27,59 @@
 #include "db/sysdb_autofs.h"
 
 struct upgrade_ctx {
+    /* NULL when the ldb is upgraded before a sysdb is set up on it */
+    struct sysdb_ctx *sysdb;
     struct ldb_context *ldb;
     const char *new_version;
 };
 
-static errno_t commence_upgrade(TALLOC_CTX *mem_ctx, struct ldb_context *ldb,
-                                const char *new_ver, struct upgrade_ctx **_ctx)
+/* The transactions on a sysdb go through sysdb_transaction_*() so that it
+ * keeps track of them */
+static errno_t upgrade_transaction_start(struct upgrade_ctx *ctx)
+{
+    int ret;
+
+    if (ctx->sysdb != NULL) {
+        return sysdb_transaction_start(ctx->sysdb);
+    }
+
+    ret = ldb_transaction_start(ctx->ldb);
+    if (ret != LDB_SUCCESS) {
+        return EIO;
+    }
+
+    return EOK;
+}
+
+static errno_t upgrade_transaction_commit(struct upgrade_ctx *ctx)
+{
+    if (ctx->sysdb != NULL) {
+        return sysdb_transaction_commit(ctx->sysdb);
+    }
+
+    return sysdb_error_to_errno(ldb_transaction_commit(ctx->ldb));
+}
+
+static void upgrade_transaction_cancel(struct upgrade_ctx *ctx)
+{
+    int lret;
+
+    if (ctx->sysdb != NULL) {
+        sysdb_transaction_cancel(ctx->sysdb);
+        return;
+    }
+
+    lret = ldb_transaction_cancel(ctx->ldb);
+    if (lret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Could not cancel transaction! [%s]\n",
+               ldb_strerror(lret));
+    }
+}
+
+static errno_t commence_upgrade(TALLOC_CTX *mem_ctx, struct sysdb_ctx *sysdb,
+                                struct ldb_context *ldb, const char *new_ver,
+                                struct upgrade_ctx **_ctx)
 {
     struct upgrade_ctx *ctx;
     int ret;
@@ -44,12 +91,12 @@ static errno_t commence_upgrade(TALLOC_CTX *mem_ctx, struct ldb_context *ldb,
         return ENOMEM;
     }
 
+    ctx->sysdb = sysdb;
     ctx->ldb = ldb;
     ctx->new_version = new_ver;
 
-    ret = ldb_transaction_start(ldb);
-    if (ret != LDB_SUCCESS) {
-        ret = EIO;
+    ret = upgrade_transaction_start(ctx);
+    if (ret != EOK) {
         goto done;
     }
 
@@ -107,27 +154,17 @@ done:
 
 static int finish_upgrade(int ret, struct upgrade_ctx **ctx, const char **ver)
 {
-    int lret;
-
     if (ret == EOK) {
-        lret = ldb_transaction_commit((*ctx)->ldb);
-        ret = sysdb_error_to_errno(lret);
+        /* a failed commit finishes the transaction as well */
+        ret = upgrade_transaction_commit(*ctx);
         if (ret == EOK) {
             *ver = (*ctx)->new_version;
         }
-    }
-
-    if (ret != EOK) {
-        lret = ldb_transaction_cancel((*ctx)->ldb);
-        if (lret != LDB_SUCCESS) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Could not cancel transaction! [%s]\n",
-                   ldb_strerror(lret));
-            /* Do not overwrite ret here, we want to return
-             * the original failure, not the failure of the
-             * transaction cancellation.
-             */
-        }
+    } else {
+        /* Failing to cancel is only logged, we want to return the
+         * original failure, not the failure of the transaction
+         * cancellation. */
+        upgrade_transaction_cancel(*ctx);
     }
 
     talloc_zfree(*ctx);
@@ -162,7 +199,7 @@ int sysdb_upgrade_01(struct ldb_context *ldb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(tmp_ctx, ldb, SYSDB_VERSION_0_2, &ctx);
+    ret = commence_upgrade(tmp_ctx, NULL, ldb, SYSDB_VERSION_0_2, &ctx);
     if (ret) {
         talloc_free(tmp_ctx);
         return ret;
@@ -415,11 +452,8 @@ int sysdb_check_upgrade_02(struct sss_domain_info *domains,
             goto done;
         }
 
-        ret = ldb_transaction_start(sysdb->ldb);
-        if (ret != LDB_SUCCESS) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Failed to start ldb transaction! (%d)\n", ret);
-            ret = EIO;
+        ret = sysdb_transaction_start(sysdb);
+        if (ret != EOK) {
             goto done;
         }
         ctx_trans = true;
@@ -523,14 +557,12 @@ int sysdb_check_upgrade_02(struct sss_domain_info *domains,
                       ret, ldb_errstring(ldb));
         }
 
-        ret = ldb_transaction_commit(sysdb->ldb);
-        if (ret != LDB_SUCCESS) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Failed to commit ldb transaction! (%d)\n", ret);
-            ret = EIO;
+        /* the transaction is over even if the commit fails */
+        ctx_trans = false;
+        ret = sysdb_transaction_commit(sysdb);
+        if (ret != EOK) {
             goto done;
         }
-        ctx_trans = false;
 
         talloc_zfree(domain_dn);
         talloc_zfree(groups_dn);
@@ -580,11 +612,7 @@ int sysdb_check_upgrade_02(struct sss_domain_info *domains,
 done:
     if (ret != EOK) {
         if (ctx_trans) {
-            ret = ldb_transaction_cancel(sysdb->ldb);
-            if (ret != LDB_SUCCESS) {
-                DEBUG(SSSDBG_CRIT_FAILURE,
-                      "Failed to cancel ldb transaction! (%d)\n", ret);
-            }
+            sysdb_transaction_cancel(sysdb);
         }
         ret = ldb_transaction_cancel(ldb);
         if (ret != LDB_SUCCESS) {
@@ -610,7 +638,7 @@ int sysdb_upgrade_03(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_4, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_4, &ctx);
     if (ret) {
         return ret;
     }
@@ -660,7 +688,7 @@ int sysdb_upgrade_04(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_5, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_5, &ctx);
     if (ret) {
         return ret;
     }
@@ -733,7 +761,7 @@ int sysdb_upgrade_05(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_6, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_6, &ctx);
     if (ret) {
         return ret;
     }
@@ -801,7 +829,7 @@ int sysdb_upgrade_06(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_7, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_7, &ctx);
     if (ret) {
         return ret;
     }
@@ -857,7 +885,7 @@ int sysdb_upgrade_07(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_8, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_8, &ctx);
     if (ret) {
         return ret;
     }
@@ -913,7 +941,7 @@ int sysdb_upgrade_08(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_9, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_9, &ctx);
     if (ret) {
         return ret;
     }
@@ -975,7 +1003,7 @@ int sysdb_upgrade_09(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_10, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_10, &ctx);
     if (ret) {
         return ret;
     }
@@ -1042,7 +1070,7 @@ int sysdb_upgrade_10(struct sysdb_ctx *sysdb, struct sss_domain_info *domain,
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_11, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_11, &ctx);
     if (ret) {
         return ret;
     }
@@ -1194,7 +1222,7 @@ int sysdb_upgrade_11(struct sysdb_ctx *sysdb, struct sss_domain_info *domain,
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_12, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_12, &ctx);
     if (ret) {
         return ret;
     }
@@ -1284,7 +1312,7 @@ int sysdb_upgrade_12(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_13, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_13, &ctx);
     if (ret) {
         return ret;
     }
@@ -1340,7 +1368,7 @@ int sysdb_upgrade_13(struct sysdb_ctx *sysdb, const char **ver)
     errno_t ret;
     int i, j, l, n;
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_14, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_14, &ctx);
     if (ret) {
         return ret;
     }
@@ -1429,7 +1457,7 @@ int sysdb_upgrade_14(struct sysdb_ctx *sysdb, const char **ver)
     errno_t ret;
     int i;
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_15, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_15, &ctx);
     if (ret) {
         return ret;
     }
@@ -1543,7 +1571,7 @@ int sysdb_upgrade_15(struct sysdb_ctx *sysdb, const char **ver)
         return ENOMEM;
     }
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_16, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_16, &ctx);
     if (ret) {
         return ret;
     }
@@ -1598,7 +1626,7 @@ int sysdb_upgrade_13(struct sysdb_ctx *sysdb, const char **ver)
     struct upgrade_ctx *ctx;
     errno_t ret;
 
-    ret = commence_upgrade(sysdb, sysdb->ldb, SYSDB_VERSION_0_14, &ctx);
+    ret = commence_upgrade(sysdb, sysdb, sysdb->ldb, SYSDB_VERSION_0_14, &ctx);
     if (ret) {
         return ret;
     }
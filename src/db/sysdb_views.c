@@ -174,6 +174,7 @@ errno_t sysdb_update_view_name(struct sysdb_ctx *sysdb,
     }
 
 done:
+    sysdb_override_map_reset(sysdb);
     talloc_free(tmp_ctx);
     return ret;
 }
@@ -290,6 +291,9 @@ errno_t sysdb_invalidate_overrides(struct sysdb_ctx *sysdb)
             ret = sysdb_error_to_errno(ret);
             goto done;
         }
+        if (ret == LDB_SUCCESS) {
+            sysdb_snapshot_changed(sysdb, msg->dn, msg);
+        }
     }
 
     talloc_free(res);
@@ -313,6 +317,10 @@ errno_t sysdb_invalidate_overrides(struct sysdb_ctx *sysdb)
             ret = sysdb_error_to_errno(ret);
             goto done;
         }
+        if (ret == LDB_SUCCESS) {
+            sysdb_members_index_changed(sysdb, msg->dn, msg);
+            sysdb_snapshot_changed(sysdb, msg->dn, msg);
+        }
     }
 
     ret = EOK;
@@ -335,6 +343,7 @@ done:
         }
     }
 
+    sysdb_override_map_reset(sysdb);
     talloc_free(tmp_ctx);
 
     return ret;
@@ -489,9 +498,9 @@ errno_t sysdb_store_override(struct sss_domain_info *domain,
         add_ref = false;
     }
 
-    ret = ldb_transaction_start(domain->sysdb->ldb);
+    ret = sysdb_transaction_start(domain->sysdb);
     if (ret != EOK) {
-        return sysdb_error_to_errno(ret);
+        goto done;
     }
     in_transaction = true;
 
@@ -626,6 +635,8 @@ errno_t sysdb_store_override(struct sss_domain_info *domain,
             ret = sysdb_error_to_errno(ret);
             goto done;
         }
+        sysdb_members_index_changed(domain->sysdb, obj_dn, msg);
+        sysdb_snapshot_changed(domain->sysdb, obj_dn, msg);
     }
 
     ret = EOK;
@@ -634,10 +645,9 @@ done:
     if (in_transaction) {
         if (ret != EOK) {
             DEBUG(SSSDBG_TRACE_FUNC, "Error: %d (%s)\n", ret, strerror(ret));
-            ldb_transaction_cancel(domain->sysdb->ldb);
+            sysdb_transaction_cancel(domain->sysdb);
         } else {
-            ret = ldb_transaction_commit(domain->sysdb->ldb);
-            ret = sysdb_error_to_errno(ret);
+            ret = sysdb_transaction_commit(domain->sysdb);
         }
     }
 
@@ -1265,38 +1275,360 @@ done:
     return ret;
 }
 
-errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
-                                         struct ldb_message *obj)
+/* For groups with fewer members the members and their overrides are read with
+ * base searches, larger groups read all user members with a single search
+ * and look up the override names in a map of all user overrides of the view */
+#define SYSDB_MEMBER_OVERRIDES_BULK_MIN 32
+
+struct sysdb_override_map {
+    uint64_t seq_num;
+    char *view_name;
+    /* casefolded DN of the override object -> overridden name */
+    hash_table_t *names;
+};
+
+void sysdb_override_map_reset(struct sysdb_ctx *sysdb)
+{
+    talloc_zfree(sysdb->override_map);
+}
+
+static errno_t sysdb_override_map_build(struct sss_domain_info *domain,
+                                        uint64_t seq_num,
+                                        struct sysdb_override_map **_map)
 {
-    int ret;
-    size_t c;
-    struct ldb_message_element *members;
     TALLOC_CTX *tmp_ctx;
-    struct ldb_dn *member_dn;
-    struct ldb_result *member_obj;
-    struct ldb_result *override_obj;
+    struct sysdb_override_map *map;
+    static const char *attrs[] = { SYSDB_NAME, NULL };
+    struct ldb_dn *base_dn;
+    struct ldb_result *res;
+    const char *name;
+    hash_key_t key;
+    hash_value_t value;
+    size_t c;
+    int hret;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    map = talloc_zero(tmp_ctx, struct sysdb_override_map);
+    if (map == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    map->seq_num = seq_num;
+
+    map->view_name = talloc_strdup(map, domain->view_name);
+    if (map->view_name == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_hash_create(map, 0, &map->names);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    base_dn = ldb_dn_new_fmt(tmp_ctx, domain->sysdb->ldb,
+                             SYSDB_TMPL_VIEW_SEARCH_BASE, domain->view_name);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = ldb_search(domain->sysdb->ldb, tmp_ctx, &res, base_dn,
+                     LDB_SCOPE_SUBTREE, attrs, "(%s=%s)", SYSDB_OBJECTCLASS,
+                     SYSDB_OVERRIDE_USER_CLASS);
+    if (ret == LDB_ERR_NO_SUCH_OBJECT) {
+        res = NULL;
+    } else if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    for (c = 0; res != NULL && c < res->count; c++) {
+        name = ldb_msg_find_attr_as_string(res->msgs[c], SYSDB_NAME, NULL);
+        if (name == NULL) {
+            continue;
+        }
+
+        key.type = HASH_KEY_STRING;
+        key.str = discard_const(ldb_dn_get_casefold(res->msgs[c]->dn));
+        if (key.str == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        value.type = HASH_VALUE_PTR;
+        value.ptr = talloc_strdup(map, name);
+        if (value.ptr == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        hret = hash_enter(map->names, &key, &value);
+        if (hret != HASH_SUCCESS) {
+            DEBUG(SSSDBG_OP_FAILURE, "hash_enter failed.\n");
+            ret = EIO;
+            goto done;
+        }
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Read [%zu] user overrides of view [%s].\n",
+          res != NULL ? (size_t) res->count : 0, domain->view_name);
+
+    *_map = talloc_steal(domain->sysdb, map);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* The map is kept until the cache is modified, responders only see the
+ * changes done by the back end through the sequence number of the cache */
+static errno_t sysdb_get_override_map(struct sss_domain_info *domain,
+                                      struct sysdb_override_map **_map)
+{
+    struct sysdb_ctx *sysdb = domain->sysdb;
+    uint64_t seq_num;
+    int ret;
+
+    ret = ldb_sequence_number(sysdb->ldb, LDB_SEQ_HIGHEST_SEQ, &seq_num);
+    if (ret != LDB_SUCCESS) {
+        return sysdb_error_to_errno(ret);
+    }
+
+    if (sysdb->override_map != NULL
+            && sysdb->override_map->seq_num == seq_num
+            && strcmp(sysdb->override_map->view_name,
+                      domain->view_name) == 0) {
+        *_map = sysdb->override_map;
+        return EOK;
+    }
+
+    sysdb_override_map_reset(sysdb);
+
+    ret = sysdb_override_map_build(domain, seq_num, &sysdb->override_map);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot read user overrides [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    *_map = sysdb->override_map;
+    return EOK;
+}
+
+/* Returns the name of the member with the view applied, if map is NULL the
+ * override object is read from the cache */
+static errno_t sysdb_member_override_name(TALLOC_CTX *mem_ctx,
+                                          struct sss_domain_info *domain,
+                                          struct ldb_message *member,
+                                          struct sysdb_override_map *map,
+                                          const char **_name)
+{
+    int ret;
     static const char *member_attrs[] = SYSDB_PW_ATTRS;
+    struct ldb_result *override_obj;
     const char *override_dn_str;
     struct ldb_dn *override_dn;
     const char *memberuid;
     const char *orig_name;
     char *orig_domain;
-    char *val;
     struct sss_domain_info *orig_dom;
+    hash_key_t key;
+    hash_value_t value;
 
-    members = ldb_msg_find_element(obj, SYSDB_MEMBER);
-    if (members == NULL || members->num_values == 0) {
-        DEBUG(SSSDBG_TRACE_ALL, "Group has no members.\n");
+    override_dn_str = ldb_msg_find_attr_as_string(member,
+                                                  SYSDB_OVERRIDE_DN, NULL);
+    if (override_dn_str == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Missing override DN for objext [%s].\n",
+              ldb_dn_get_linearized(member->dn));
+        return ENOENT;
+    }
+
+    override_dn = ldb_dn_new(mem_ctx, domain->sysdb->ldb, override_dn_str);
+    if (override_dn == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldb_dn_new failed.\n");
+        return ENOMEM;
+    }
+
+    orig_name = ldb_msg_find_attr_as_string(member, SYSDB_NAME, NULL);
+    if (orig_name == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Object [%s] has no name.\n",
+              ldb_dn_get_linearized(member->dn));
+        return EINVAL;
+    }
+
+    memberuid = NULL;
+    if (ldb_dn_compare(member->dn, override_dn) != 0) {
+        DEBUG(SSSDBG_TRACE_ALL, "Checking override for object [%s].\n",
+              ldb_dn_get_linearized(member->dn));
+
+        if (map != NULL) {
+            key.type = HASH_KEY_STRING;
+            key.str = discard_const(ldb_dn_get_casefold(override_dn));
+            if (key.str == NULL) {
+                return ENOMEM;
+            }
+
+            if (hash_lookup(map->names, &key, &value) == HASH_SUCCESS) {
+                memberuid = value.ptr;
+            }
+        } else {
+            ret = ldb_search(domain->sysdb->ldb, mem_ctx, &override_obj,
+                             override_dn, LDB_SCOPE_BASE, member_attrs, NULL);
+            if (ret != LDB_SUCCESS) {
+                return sysdb_error_to_errno(ret);
+            }
+
+            if (override_obj->count != 1) {
+                DEBUG(SSSDBG_CRIT_FAILURE,
+                     "Base search for override object returned [%d] results.\n",
+                     override_obj->count);
+                return EINVAL;
+            }
+
+            memberuid = ldb_msg_find_attr_as_string(override_obj->msgs[0],
+                                                    SYSDB_NAME,
+                                                    NULL);
+        }
+
+        if (memberuid != NULL) {
+            ret = sss_parse_name(mem_ctx, domain->names, orig_name,
+                                 &orig_domain, NULL);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_OP_FAILURE,
+                     "sss_parse_name failed to split original name [%s].\n",
+                     orig_name);
+                return ret;
+            }
+
+            if (orig_domain != NULL) {
+                orig_dom = find_domain_by_name(get_domains_head(domain),
+                                               orig_domain, true);
+                if (orig_dom == NULL) {
+                    DEBUG(SSSDBG_CRIT_FAILURE,
+                          "Cannot find domain with name [%s].\n",
+                          orig_domain);
+                    return EINVAL;
+                }
+                memberuid = sss_get_domain_name(mem_ctx, memberuid,
+                                                orig_dom);
+                if (memberuid == NULL) {
+                    DEBUG(SSSDBG_OP_FAILURE,
+                          "sss_get_domain_name failed.\n");
+                    return ENOMEM;
+                }
+            }
+        }
+    }
+
+    if (memberuid == NULL) {
+        DEBUG(SSSDBG_TRACE_ALL, "No override name available.\n");
+
+        memberuid = orig_name;
+    }
+
+    *_name = memberuid;
+    return EOK;
+}
+
+static errno_t sysdb_add_member_override_name(struct sss_domain_info *domain,
+                                              struct ldb_message *obj,
+                                              struct ldb_message *member,
+                                              struct sysdb_override_map *map)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *memberuid;
+    char *val;
+    int ret;
+
+    if (ldb_msg_find_attr_as_uint64(member, SYSDB_UIDNUM, 0) == 0) {
+        /* Skip non-POSIX-user members i.e. groups and non-POSIX users */
         return EOK;
     }
 
+    /* All temporary data of the current member is freed right away to avoid
+     * memory usage spikes */
     tmp_ctx = talloc_new(NULL);
     if (tmp_ctx == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
+        return ENOMEM;
+    }
+
+    ret = sysdb_member_override_name(tmp_ctx, domain, member, map,
+                                     &memberuid);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    val = talloc_strdup(obj, memberuid);
+    if (val == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_strdup failed.\n");
         ret = ENOMEM;
         goto done;
     }
 
+    ret = ldb_msg_add_string(obj, OVERRIDE_PREFIX SYSDB_MEMBERUID, val);
+    if (ret != LDB_SUCCESS) {
+        DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_add_string failed.\n");
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+    DEBUG(SSSDBG_TRACE_ALL, "Added [%s] to [%s].\n", memberuid,
+                            OVERRIDE_PREFIX SYSDB_MEMBERUID);
+
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+/* Reads all user members of the group with a single search on the indexed
+ * memberof attribute. Since memberof also contains the nested groups, the
+ * result is filtered by the direct members of the group. */
+static errno_t
+sysdb_add_group_member_overrides_bulk(struct sss_domain_info *domain,
+                                      struct ldb_message *obj,
+                                      struct ldb_message_element *members)
+{
+    TALLOC_CTX *tmp_ctx;
+    static const char *member_attrs[] = SYSDB_PW_ATTRS;
+    struct sysdb_override_map *map;
+    hash_table_t *direct;
+    struct ldb_dn *member_dn;
+    struct ldb_dn *base_dn;
+    struct ldb_result *res;
+    const char *group_dn;
+    char *sanitized_dn;
+    hash_key_t key;
+    hash_value_t value;
+    size_t c;
+    int hret;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_get_override_map(domain, &map);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_hash_create(tmp_ctx, members->num_values, &direct);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    value.type = HASH_VALUE_UNDEF;
+    key.type = HASH_KEY_STRING;
     for (c = 0; c < members->num_values; c++) {
         member_dn = ldb_dn_from_ldb_val(tmp_ctx, domain->sysdb->ldb,
                                         &members->values[c]);
@@ -1306,135 +1638,126 @@ errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
             goto done;
         }
 
-        ret = ldb_search(domain->sysdb->ldb, member_dn, &member_obj, member_dn,
-                         LDB_SCOPE_BASE, member_attrs, NULL);
-        if (ret != LDB_SUCCESS) {
-            ret = sysdb_error_to_errno(ret);
+        key.str = discard_const(ldb_dn_get_casefold(member_dn));
+        if (key.str == NULL) {
+            ret = ENOMEM;
             goto done;
         }
 
-        if (member_obj->count != 1) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Base search for member object returned [%d] results.\n",
-                  member_obj->count);
-            ret = EINVAL;
+        hret = hash_enter(direct, &key, &value);
+        talloc_free(member_dn);
+        if (hret != HASH_SUCCESS) {
+            DEBUG(SSSDBG_OP_FAILURE, "hash_enter failed.\n");
+            ret = EIO;
             goto done;
         }
+    }
 
-        if (ldb_msg_find_attr_as_uint64(member_obj->msgs[0],
-                                        SYSDB_UIDNUM, 0) == 0) {
-            /* Skip non-POSIX-user members i.e. groups and non-POSIX users */
-            continue;
-        }
+    group_dn = ldb_dn_get_linearized(obj->dn);
+    ret = sss_filter_sanitize(tmp_ctx, group_dn, &sanitized_dn);
+    if (ret != EOK) {
+        goto done;
+    }
 
-        override_dn_str = ldb_msg_find_attr_as_string(member_obj->msgs[0],
-                                                      SYSDB_OVERRIDE_DN, NULL);
-        if (override_dn_str == NULL) {
-            DEBUG(SSSDBG_CRIT_FAILURE,
-                  "Missing override DN for objext [%s].\n",
-                  ldb_dn_get_linearized(member_obj->msgs[0]->dn));
-            ret = ENOENT;
-            goto done;
-        }
+    base_dn = ldb_dn_new(tmp_ctx, domain->sysdb->ldb, SYSDB_BASE);
+    if (base_dn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
 
-        override_dn = ldb_dn_new(member_obj, domain->sysdb->ldb,
-                                 override_dn_str);
-        if (override_dn == NULL) {
-            DEBUG(SSSDBG_OP_FAILURE, "ldb_dn_new failed.\n");
+    ret = ldb_search(domain->sysdb->ldb, tmp_ctx, &res, base_dn,
+                     LDB_SCOPE_SUBTREE, member_attrs,
+                     "(&(%s=%s)(%s=%s))", SYSDB_OBJECTCLASS, SYSDB_USER_CLASS,
+                     SYSDB_MEMBEROF, sanitized_dn);
+    if (ret != LDB_SUCCESS) {
+        ret = sysdb_error_to_errno(ret);
+        goto done;
+    }
+
+    for (c = 0; c < res->count; c++) {
+        key.str = discard_const(ldb_dn_get_casefold(res->msgs[c]->dn));
+        if (key.str == NULL) {
             ret = ENOMEM;
             goto done;
         }
 
-        orig_name = ldb_msg_find_attr_as_string(member_obj->msgs[0],
-                                                SYSDB_NAME,
-                                                NULL);
-        if (orig_name == NULL) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Object [%s] has no name.\n",
-                  ldb_dn_get_linearized(member_obj->msgs[0]->dn));
-            ret = EINVAL;
-            goto done;
+        if (!hash_has_key(direct, &key)) {
+            /* member of a nested group */
+            continue;
         }
 
-        memberuid = NULL;
-        if (ldb_dn_compare(member_obj->msgs[0]->dn, override_dn) != 0) {
-            DEBUG(SSSDBG_TRACE_ALL, "Checking override for object [%s].\n",
-                  ldb_dn_get_linearized(member_obj->msgs[0]->dn));
-
-            ret = ldb_search(domain->sysdb->ldb, member_obj, &override_obj,
-                             override_dn, LDB_SCOPE_BASE, member_attrs, NULL);
-            if (ret != LDB_SUCCESS) {
-                ret = sysdb_error_to_errno(ret);
-                goto done;
-            }
+        ret = sysdb_add_member_override_name(domain, obj, res->msgs[c], map);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
 
-            if (override_obj->count != 1) {
-                DEBUG(SSSDBG_CRIT_FAILURE,
-                     "Base search for override object returned [%d] results.\n",
-                     member_obj->count);
-                ret = EINVAL;
-                goto done;
-            }
+    ret = EOK;
 
-            memberuid = ldb_msg_find_attr_as_string(override_obj->msgs[0],
-                                                    SYSDB_NAME,
-                                                    NULL);
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
 
-            if (memberuid != NULL) {
-                ret = sss_parse_name(tmp_ctx, domain->names, orig_name,
-                                     &orig_domain, NULL);
-                if (ret != EOK) {
-                    DEBUG(SSSDBG_OP_FAILURE,
-                         "sss_parse_name failed to split original name [%s].\n",
-                         orig_name);
-                    goto done;
-                }
+errno_t sysdb_add_group_member_overrides(struct sss_domain_info *domain,
+                                         struct ldb_message *obj)
+{
+    int ret;
+    size_t c;
+    struct ldb_message_element *members;
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_dn *member_dn;
+    struct ldb_result *member_obj;
+    static const char *member_attrs[] = SYSDB_PW_ATTRS;
 
-                if (orig_domain != NULL) {
-                    orig_dom = find_domain_by_name(get_domains_head(domain),
-                                                   orig_domain, true);
-                    if (orig_dom == NULL) {
-                        DEBUG(SSSDBG_CRIT_FAILURE,
-                              "Cannot find domain with name [%s].\n",
-                              orig_domain);
-                        ret = EINVAL;
-                        goto done;
-                    }
-                    memberuid = sss_get_domain_name(tmp_ctx, memberuid,
-                                                    orig_dom);
-                    if (memberuid == NULL) {
-                        DEBUG(SSSDBG_OP_FAILURE,
-                              "sss_get_domain_name failed.\n");
-                        ret = ENOMEM;
-                        goto done;
-                    }
-                }
-            }
-        }
+    members = ldb_msg_find_element(obj, SYSDB_MEMBER);
+    if (members == NULL || members->num_values == 0) {
+        DEBUG(SSSDBG_TRACE_ALL, "Group has no members.\n");
+        return EOK;
+    }
 
-        if (memberuid == NULL) {
-            DEBUG(SSSDBG_TRACE_ALL, "No override name available.\n");
+    if (members->num_values >= SYSDB_MEMBER_OVERRIDES_BULK_MIN
+            && domain->view_name != NULL) {
+        return sysdb_add_group_member_overrides_bulk(domain, obj, members);
+    }
 
-            memberuid = orig_name;
-        }
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_new failed.\n");
+        ret = ENOMEM;
+        goto done;
+    }
 
-        val = talloc_strdup(obj, memberuid);
-        if (val == NULL) {
-            DEBUG(SSSDBG_OP_FAILURE, "talloc_strdup failed.\n");
+    for (c = 0; c < members->num_values; c++) {
+        member_dn = ldb_dn_from_ldb_val(tmp_ctx, domain->sysdb->ldb,
+                                        &members->values[c]);
+        if (member_dn == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "ldb_dn_from_ldb_val failed.\n");
             ret = ENOMEM;
             goto done;
         }
 
-        ret = ldb_msg_add_string(obj, OVERRIDE_PREFIX SYSDB_MEMBERUID, val);
+        ret = ldb_search(domain->sysdb->ldb, member_dn, &member_obj, member_dn,
+                         LDB_SCOPE_BASE, member_attrs, NULL);
         if (ret != LDB_SUCCESS) {
-            DEBUG(SSSDBG_OP_FAILURE, "ldb_msg_add_string failed.\n");
             ret = sysdb_error_to_errno(ret);
             goto done;
         }
-        DEBUG(SSSDBG_TRACE_ALL, "Added [%s] to [%s].\n", memberuid,
-                                OVERRIDE_PREFIX SYSDB_MEMBERUID);
 
-        /* Free all temporary data of the current member to avoid memory usage
-         * spikes. All temporary data should be allocated below member_dn. */
+        if (member_obj->count != 1) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Base search for member object returned [%d] results.\n",
+                  member_obj->count);
+            ret = EINVAL;
+            goto done;
+        }
+
+        ret = sysdb_add_member_override_name(domain, obj,
+                                             member_obj->msgs[0], NULL);
+        if (ret != EOK) {
+            goto done;
+        }
+
         talloc_free(member_dn);
     }
 
@@ -212,18 +212,9 @@ static int samba_unix_sid_to_id(const char *sid, struct cifs_uxid *cuxid)
     return 0;
 }
 
-static int sss_sid_to_id(struct sssd_ctx *ctx, const char *sid,
-                         struct cifs_uxid *cuxid)
+static int sss_id_type_to_cifs_uxid(enum sss_id_type id_type, uint32_t id,
+                                    struct cifs_uxid *cuxid)
 {
-    int err;
-    enum sss_id_type id_type;
-
-    err = sss_nss_getidbysid(sid, (uint32_t *)&cuxid->id.uid, &id_type);
-    if (err != 0)  {
-        ctx_set_error(ctx, strerror(err));
-        return -1;
-    }
-
     switch (id_type) {
     case SSS_ID_TYPE_UID:
         cuxid->type = CIFS_UXID_TYPE_UID;
@@ -239,6 +230,8 @@ static int sss_sid_to_id(struct sssd_ctx *ctx, const char *sid,
         return -1;
     }
 
+    cuxid->id.uid = id;
+
     return 0;
 }
 
@@ -253,8 +246,11 @@ int cifs_idmap_sids_to_ids(void *handle, const struct cifs_sid *csid,
     struct sssd_ctx *ctx = handle;
     enum idmap_error_code err;
     int success = -1;
+    int ret;
     size_t i;
-    char *sid;
+    char **sids;
+    uint32_t *ids;
+    enum sss_id_type *id_types;
 
     debug("num: %zd", num);
 
@@ -263,25 +259,54 @@ int cifs_idmap_sids_to_ids(void *handle, const struct cifs_sid *csid,
         return EINVAL;
     }
 
+    sids = calloc(num + 1, sizeof(char *));
+    ids = calloc(num + 1, sizeof(uint32_t));
+    id_types = calloc(num + 1, sizeof(enum sss_id_type));
+    if (sids == NULL || ids == NULL || id_types == NULL) {
+        ctx_set_error(ctx, strerror(ENOMEM));
+        success = ENOMEM;
+        goto done;
+    }
+
     for (i = 0; i < num; ++i) {
+        cuxid[i].type = CIFS_UXID_TYPE_UNKNOWN;
+
         err = sss_idmap_bin_sid_to_sid(ctx->idmap, (const uint8_t *) &csid[i],
-                                       sizeof(csid[i]), &sid);
+                                       sizeof(csid[i]), &sids[i]);
         if (err != IDMAP_SUCCESS) {
             ctx_set_error(ctx, idmap_error_string(err));
-            continue;
+            sids[i] = NULL;
         }
+    }
 
-        cuxid[i].type = CIFS_UXID_TYPE_UNKNOWN;
+    /* SIDs which could not be converted are NULL and are skipped */
+    ret = sss_nss_getidsbysids((const char *const *) sids, num, ids, id_types);
+    if (ret != 0) {
+        ctx_set_error(ctx, strerror(ret));
+    }
+
+    for (i = 0; i < num; ++i) {
+        if (sids[i] == NULL) {
+            continue;
+        }
 
-        if (sss_sid_to_id(ctx, sid, &cuxid[i]) == 0 ||
-            samba_unix_sid_to_id(sid, &cuxid[i]) == 0) {
+        if (sss_id_type_to_cifs_uxid(id_types[i], ids[i], &cuxid[i]) == 0 ||
+            samba_unix_sid_to_id(sids[i], &cuxid[i]) == 0) {
 
-            debug("setting uid of %s to %d", sid, cuxid[i].id.uid);
+            debug("setting uid of %s to %d", sids[i], cuxid[i].id.uid);
             success = 0;
         }
+    }
 
-        free(sid);
+done:
+    if (sids != NULL) {
+        for (i = 0; i < num; ++i) {
+            free(sids[i]);
+        }
+        free(sids);
     }
+    free(ids);
+    free(id_types);
 
     return success;
 }
@@ -32,6 +32,8 @@
 #endif
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <popt.h>
@@ -116,6 +118,11 @@ struct mt_svc {
     char *identity;
     pid_t pid;
 
+    /* index of the process if the service runs several of them */
+    int worker;
+    /* inherits the listening socket owned by the monitor */
+    bool share_pipe;
+
     int ping_time;
     int kill_time;
 
@@ -173,6 +180,9 @@ struct mt_ctx {
     bool is_daemon;
     pid_t parent_pid;
 
+    /* listening socket shared by the NSS workers */
+    int nss_pipe_fd;
+
     /* For running unprivileged services */
     uid_t uid;
     gid_t gid;
@@ -190,12 +200,16 @@ static void set_tasks_checker(struct mt_svc *srv);
 static int monitor_kill_service (struct mt_svc *svc);
 
 static int get_service_config(struct mt_ctx *ctx, const char *name,
-                              struct mt_svc **svc_cfg);
+                              int worker, struct mt_svc **svc_cfg);
 static int get_provider_config(struct mt_ctx *ctx, const char *name,
                               struct mt_svc **svc_cfg);
 static int add_new_service(struct mt_ctx *ctx,
                            const char *name,
                            int restarts);
+static int add_new_service_worker(struct mt_ctx *ctx,
+                                  const char *name,
+                                  int worker,
+                                  int restarts);
 static int add_new_provider(struct mt_ctx *ctx,
                             const char *name,
                             int restarts);
@@ -238,6 +252,177 @@ struct mon_init_conn {
 
 static int add_svc_conn_spy(struct mt_svc *svc);
 
+/* Statistics are collected from all running services and returned as one
+ * text, the output of each service is preceded by a [name] line. */
+struct mon_stats_req {
+    struct sbus_request *dbus_req;
+    char *stats;
+    int num_pending;
+};
+
+struct mon_stats_svc {
+    struct mon_stats_req *stats_req;
+    const char *name;
+    DBusPendingCall *pending;
+};
+
+static int mon_stats_svc_destructor(struct mon_stats_svc *svc_req)
+{
+    /* the caller disconnected before all services replied */
+    if (svc_req->pending != NULL) {
+        dbus_pending_call_cancel(svc_req->pending);
+        svc_req->pending = NULL;
+    }
+
+    return 0;
+}
+
+static void get_monitor_stats_finish(struct mon_stats_req *stats_req)
+{
+    struct sbus_request *dbus_req = stats_req->dbus_req;
+    const char *stats = stats_req->stats;
+
+    /* stats_req is allocated on dbus_req and freed with it */
+    sbus_request_return_and_finish(dbus_req,
+                                   DBUS_TYPE_STRING, &stats,
+                                   DBUS_TYPE_INVALID);
+}
+
+static void get_monitor_stats_reply(DBusPendingCall *pending, void *data)
+{
+    struct mon_stats_svc *svc_req;
+    struct mon_stats_req *stats_req;
+    DBusMessage *reply;
+    DBusError dbus_error;
+    const char *stats = NULL;
+    dbus_bool_t dbret;
+
+    svc_req = talloc_get_type(data, struct mon_stats_svc);
+    stats_req = svc_req->stats_req;
+    svc_req->pending = NULL;
+
+    dbus_error_init(&dbus_error);
+
+    reply = dbus_pending_call_steal_reply(pending);
+    if (reply == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "No statistics received from [%s]\n",
+                                   svc_req->name);
+    } else if (dbus_message_get_type(reply) != DBUS_MESSAGE_TYPE_METHOD_RETURN) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Service [%s] did not return "
+                                    "statistics\n", svc_req->name);
+    } else {
+        dbret = dbus_message_get_args(reply, &dbus_error,
+                                      DBUS_TYPE_STRING, &stats,
+                                      DBUS_TYPE_INVALID);
+        if (!dbret) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to parse statistics of [%s]\n",
+                                       svc_req->name);
+            if (dbus_error_is_set(&dbus_error)) dbus_error_free(&dbus_error);
+            stats = NULL;
+        }
+    }
+
+    if (stats != NULL && stats_req->stats != NULL) {
+        stats_req->stats = talloc_asprintf_append(stats_req->stats,
+                                                  "[%s]\n%s",
+                                                  svc_req->name, stats);
+    }
+
+    if (reply != NULL) {
+        dbus_message_unref(reply);
+    }
+    dbus_pending_call_unref(pending);
+    talloc_free(svc_req);
+
+    stats_req->num_pending--;
+    if (stats_req->num_pending == 0) {
+        get_monitor_stats_finish(stats_req);
+    }
+}
+
+static int get_monitor_stats(struct sbus_request *dbus_req, void *data)
+{
+    struct mon_init_conn *mini;
+    struct mon_stats_req *stats_req;
+    struct mon_stats_svc *svc_req;
+    struct mt_svc *svc;
+    DBusMessage *msg;
+    int ret;
+
+    mini = talloc_get_type(data, struct mon_init_conn);
+    if (!mini) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Connection holds no valid init data\n");
+        return EINVAL;
+    }
+
+    stats_req = talloc_zero(dbus_req, struct mon_stats_req);
+    if (stats_req == NULL) {
+        return ENOMEM;
+    }
+    stats_req->dbus_req = dbus_req;
+
+    stats_req->stats = talloc_strdup(stats_req, "");
+    if (stats_req->stats == NULL) {
+        talloc_free(stats_req);
+        return ENOMEM;
+    }
+
+    for (svc = mini->ctx->svc_list; svc != NULL; svc = svc->next) {
+        if (svc->conn == NULL) {
+            /* not running or not registered yet */
+            continue;
+        }
+
+        svc_req = talloc_zero(stats_req, struct mon_stats_svc);
+        if (svc_req == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+        svc_req->stats_req = stats_req;
+        svc_req->name = talloc_strdup(svc_req, svc->worker > 0 ?
+                                               svc->identity : svc->name);
+        if (svc_req->name == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+
+        msg = dbus_message_new_method_call(NULL,
+                                           MONITOR_PATH,
+                                           MON_CLI_IFACE,
+                                           MON_CLI_IFACE_GETSTATS);
+        if (msg == NULL) {
+            ret = ENOMEM;
+            goto fail;
+        }
+
+        ret = sbus_conn_send(svc->conn, msg,
+                             mini->ctx->service_id_timeout,
+                             get_monitor_stats_reply, svc_req,
+                             &svc_req->pending);
+        dbus_message_unref(msg);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "Cannot query statistics of [%s]\n",
+                                        svc->name);
+            talloc_free(svc_req);
+            continue;
+        }
+
+        talloc_set_destructor(svc_req, mon_stats_svc_destructor);
+        stats_req->num_pending++;
+    }
+
+    if (stats_req->num_pending == 0) {
+        get_monitor_stats_finish(stats_req);
+    }
+
+    return EOK;
+
+fail:
+    /* cancels the calls already sent */
+    talloc_free(stats_req);
+    return ret;
+}
+
 /* registers a new client.
  * if operation is successful also sends back the Monitor version */
 static int client_registration(struct sbus_request *dbus_req, void *data)
@@ -427,7 +612,8 @@ static int mark_service_as_started(struct mt_svc *svc)
         }
     }
 
-    if (svc->type == MT_SVC_SERVICE) {
+    /* additional workers are not counted in num_services */
+    if (svc->type == MT_SVC_SERVICE && svc->worker == 0) {
         ctx->started_services++;
     }
 
@@ -503,6 +689,7 @@ struct mon_srv_iface monitor_methods = {
     { &mon_srv_iface_meta, 0 },
     .getVersion = get_monitor_version,
     .RegisterService = client_registration,
+    .getStats = get_monitor_stats,
 };
 
 /* monitor_dbus_init
@@ -1102,8 +1289,93 @@ static bool svc_supported_as_nonroot(const char *svc_name)
     return false;
 }
 
+/* UNIX sockets cannot be bound by several processes at once. If the NSS
+ * responder runs more than one process the monitor creates the socket and
+ * all of them inherit it, the kernel then hands each new connection to one
+ * of the processes waiting in accept(). */
+static errno_t get_nss_pipe_fd(struct mt_ctx *ctx)
+{
+    struct sockaddr_un addr;
+    mode_t orig_umaskval;
+    errno_t ret;
+    int fd;
+
+    if (ctx->nss_pipe_fd != -1) {
+        return EOK;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_FATAL_FAILURE, "socket() failed [%d]: %s\n",
+              ret, strerror(ret));
+        return ret;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SSS_NSS_SOCKET_NAME, sizeof(addr.sun_path) - 1);
+
+    /* make sure we have no old sockets around */
+    ret = unlink(SSS_NSS_SOCKET_NAME);
+    if (ret != 0 && errno != ENOENT) {
+        ret = errno;
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot remove old socket (errno=%d), bind might fail!\n", ret);
+    }
+
+    /* It must be readable and writable by anybody on the system */
+    orig_umaskval = umask(0111);
+    ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(orig_umaskval);
+    if (ret == -1) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Unable to bind on socket '%s'\n", SSS_NSS_SOCKET_NAME);
+        close(fd);
+        return EIO;
+    }
+
+    /* several processes accept from it, let the connections queue up */
+    if (listen(fd, SOMAXCONN) == -1) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Unable to listen on socket '%s'\n", SSS_NSS_SOCKET_NAME);
+        close(fd);
+        return EIO;
+    }
+
+    ctx->nss_pipe_fd = fd;
+    return EOK;
+}
+
+static int get_service_workers(struct mt_ctx *ctx, const char *name,
+                               int *_workers)
+{
+    int workers = 1;
+    int ret;
+
+    if (strcasecmp(name, "nss") == 0) {
+        ret = confdb_get_int(ctx->cdb, CONFDB_NSS_CONF_ENTRY,
+                             CONFDB_NSS_WORKERS, CONFDB_NSS_DEFAULT_WORKERS,
+                             &workers);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to read the number of NSS workers\n");
+            return ret;
+        }
+
+        if (workers < 1) {
+            DEBUG(SSSDBG_CONF_SETTINGS,
+                  "Invalid number of NSS workers [%d], using 1\n", workers);
+            workers = 1;
+        }
+    }
+
+    *_workers = workers;
+    return EOK;
+}
+
 static int get_service_config(struct mt_ctx *ctx, const char *name,
-                              struct mt_svc **svc_cfg)
+                              int worker, struct mt_svc **svc_cfg)
 {
     int ret;
     char *path;
@@ -1111,6 +1383,7 @@ static int get_service_config(struct mt_ctx *ctx, const char *name,
     time_t now = time(NULL);
     uid_t uid = 0;
     gid_t gid = 0;
+    int workers;
 
     *svc_cfg = NULL;
 
@@ -1129,12 +1402,36 @@ static int get_service_config(struct mt_ctx *ctx, const char *name,
         return ENOMEM;
     }
 
-    svc->identity = talloc_strdup(svc, name);
+    svc->worker = worker;
+    if (worker > 0) {
+        svc->identity = talloc_asprintf(svc, "%s_worker%d", name, worker);
+    } else {
+        svc->identity = talloc_strdup(svc, name);
+    }
     if (!svc->identity) {
         talloc_free(svc);
         return ENOMEM;
     }
 
+    ret = get_service_workers(ctx, name, &workers);
+    if (ret != EOK) {
+        talloc_free(svc);
+        return ret;
+    }
+
+    /* Keep using the shared socket once it exists even if the number of
+     * workers was lowered, the running workers still accept from it. Only
+     * the NSS responder knows the --socket-fd option. */
+    if (strcasecmp(name, "nss") == 0
+            && (workers > 1 || ctx->nss_pipe_fd != -1)) {
+        ret = get_nss_pipe_fd(ctx);
+        if (ret != EOK) {
+            talloc_free(svc);
+            return ret;
+        }
+        svc->share_pipe = true;
+    }
+
     path = talloc_asprintf(svc, CONFDB_SERVICE_PATH_TMPL, svc->name);
     if (!path) {
         talloc_free(svc);
@@ -1222,6 +1519,25 @@ static int get_service_config(struct mt_ctx *ctx, const char *name,
         }
     }
 
+    if (svc->share_pipe) {
+        svc->command = talloc_asprintf_append(svc->command,
+                                              " --socket-fd %d",
+                                              ctx->nss_pipe_fd);
+        if (!svc->command) {
+            talloc_free(svc);
+            return ENOMEM;
+        }
+    }
+
+    if (worker > 0) {
+        svc->command = talloc_asprintf_append(svc->command,
+                                              " --worker %d", worker);
+        if (!svc->command) {
+            talloc_free(svc);
+            return ENOMEM;
+        }
+    }
+
     ret = get_ping_config(ctx, path, svc);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -1241,11 +1557,35 @@ static int get_service_config(struct mt_ctx *ctx, const char *name,
 static int add_new_service(struct mt_ctx *ctx,
                            const char *name,
                            int restarts)
+{
+    int workers;
+    int ret;
+    int i;
+
+    ret = get_service_workers(ctx, name, &workers);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; i < workers; i++) {
+        ret = add_new_service_worker(ctx, name, i, restarts);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+static int add_new_service_worker(struct mt_ctx *ctx,
+                                  const char *name,
+                                  int worker,
+                                  int restarts)
 {
     int ret;
     struct mt_svc *svc;
 
-    ret = get_service_config(ctx, name, &svc);
+    ret = get_service_config(ctx, name, worker, &svc);
     if (ret != EOK) {
         return ret;
     }
@@ -1674,6 +2014,10 @@ static int monitor_ctx_destructor(void *mem)
     for (svc = mon->svc_list; svc; svc = svc->next) {
         svc->mt_ctx = NULL;
     }
+
+    if (mon->nss_pipe_fd != -1) {
+        close(mon->nss_pipe_fd);
+    }
     return 0;
 }
 
@@ -1698,6 +2042,7 @@ errno_t load_configuration(TALLOC_CTX *mem_ctx,
         return ENOMEM;
     }
 
+    ctx->nss_pipe_fd = -1;
     talloc_set_destructor((TALLOC_CTX *)ctx, monitor_ctx_destructor);
 
     cdb_file = talloc_asprintf(ctx, "%s/%s", DB_PATH, CONFDB_FILE);
@@ -2687,6 +3032,16 @@ static void service_startup_handler(struct tevent_context *ev,
 
     /* child */
 
+    if (mt_svc->share_pipe) {
+        /* the only descriptor of the monitor passed to the service */
+        ret = fcntl(mt_svc->mt_ctx->nss_pipe_fd, F_SETFD, 0);
+        if (ret == -1) {
+            DEBUG(SSSDBG_FATAL_FAILURE,
+                  "Could not pass the socket to %s\n", mt_svc->identity);
+            _exit(1);
+        }
+    }
+
     args = parse_args(mt_svc->command);
     execvp(args[0], args);
 
@@ -2716,7 +3071,8 @@ static void mt_svc_restart(struct tevent_context *ev,
                               svc->name, svc->restarts+1);
 
     if (svc->type == MT_SVC_SERVICE) {
-        add_new_service(svc->mt_ctx, svc->name, svc->restarts + 1);
+        add_new_service_worker(svc->mt_ctx, svc->name, svc->worker,
+                               svc->restarts + 1);
     } else if (svc->type == MT_SVC_PROVIDER) {
         add_new_provider(svc->mt_ctx, svc->name, svc->restarts + 1);
     } else {
@@ -2820,6 +3176,7 @@ static void monitor_restart_service(struct mt_svc *svc)
     }
 }
 
+#ifndef UNIT_TESTING
 int main(int argc, const char *argv[])
 {
     int opt;
@@ -3040,3 +3397,4 @@ int main(int argc, const char *argv[])
 
     return 0;
 }
+#endif /* UNIT_TESTING */
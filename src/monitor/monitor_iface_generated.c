@@ -5,6 +5,12 @@
 #include "sbus/sssd_dbus_meta.h"
 #include "monitor_iface_generated.h"
 
+/* arguments for org.freedesktop.sssd.monitor.getStats */
+const struct sbus_arg_meta mon_srv_iface_getStats__out[] = {
+    { "stats", "s" },
+    { NULL, }
+};
+
 /* methods for org.freedesktop.sssd.monitor */
 const struct sbus_method_meta mon_srv_iface__methods[] = {
     {
@@ -21,6 +27,13 @@ const struct sbus_method_meta mon_srv_iface__methods[] = {
         offsetof(struct mon_srv_iface, RegisterService),
         NULL, /* no invoker */
     },
+    {
+        "getStats", /* name */
+        NULL, /* no in_args */
+        mon_srv_iface_getStats__out,
+        offsetof(struct mon_srv_iface, getStats),
+        NULL, /* no invoker */
+    },
     { NULL, }
 };
 
@@ -59,6 +72,12 @@ const struct sbus_interface_meta mon_srv_iface_meta = {
     invoke_mon_srv_iface_get_all, /* GetAll invoker */
 };
 
+/* arguments for org.freedesktop.sssd.service.getStats */
+const struct sbus_arg_meta mon_cli_iface_getStats__out[] = {
+    { "stats", "s" },
+    { NULL, }
+};
+
 /* methods for org.freedesktop.sssd.service */
 const struct sbus_method_meta mon_cli_iface__methods[] = {
     {
@@ -124,6 +143,13 @@ const struct sbus_method_meta mon_cli_iface__methods[] = {
         offsetof(struct mon_cli_iface, sysbusReconnect),
         NULL, /* no invoker */
     },
+    {
+        "getStats", /* name */
+        NULL, /* no in_args */
+        mon_cli_iface_getStats__out,
+        offsetof(struct mon_cli_iface, getStats),
+        NULL, /* no invoker */
+    },
     { NULL, }
 };
 
@@ -29,6 +29,7 @@
 #include "sbus/sssd_dbus.h"
 #include "sbus/sbus_client.h"
 #include "monitor/monitor_interfaces.h"
+#include "util/sss_stats.h"
 
 int monitor_get_sbus_address(TALLOC_CTX *mem_ctx, char **address)
 {
@@ -162,6 +163,23 @@ int monitor_common_res_init(struct sbus_request *dbus_req, void *data)
     return sbus_request_return_and_finish(dbus_req, DBUS_TYPE_INVALID);
 }
 
+int monitor_common_get_stats(struct sbus_request *dbus_req, void *data)
+{
+    char *stats;
+    int ret;
+
+    ret = sss_stats_dump(dbus_req, &stats);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot format statistics [%d]: %s\n",
+                                 ret, sss_strerror(ret));
+        return ret;
+    }
+
+    return sbus_request_return_and_finish(dbus_req,
+                                          DBUS_TYPE_STRING, &stats,
+                                          DBUS_TYPE_INVALID);
+}
+
 errno_t sss_monitor_init(TALLOC_CTX *mem_ctx,
                          struct tevent_context *ev,
                          struct mon_cli_iface *mon_iface,
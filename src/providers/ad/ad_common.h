@@ -62,6 +62,7 @@ enum ad_basic_opt {
     AD_GPO_DEFAULT_RIGHT,
     AD_SITE,
     AD_KRB5_CONFD_PATH,
+    AD_SUBDOMAIN_WARMUP_LIMIT,
 
     AD_OPTS_BASIC /* opts counter */
 };
@@ -404,6 +404,16 @@ sssm_ad_access_init(struct be_ctx *bectx,
     }
     access_ctx->sdap_access_ctx->id_ctx = ad_id_ctx->sdap_id_ctx;
 
+    ret = sdap_access_cache_init(access_ctx->sdap_access_ctx,
+                                 ad_id_ctx->sdap_id_ctx->opts->basic,
+                                 &access_ctx->sdap_access_ctx->cache);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Could not initialize access decision cache: [%s]\n",
+               strerror(ret));
+        goto fail;
+    }
+
     /* If ad_access_filter is set, the value of ldap_acess_order is
      * expire, filter, otherwise only expire
      */
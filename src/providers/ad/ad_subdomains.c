@@ -67,6 +67,8 @@ struct ad_subdomains_ctx {
     time_t last_refreshed;
     struct tevent_timer *timer_event;
     struct ad_id_ctx *ad_id_ctx;
+
+    struct tevent_req *warmup_req;
 };
 
 struct ad_subdomains_req_ctx {
@@ -74,14 +76,18 @@ struct ad_subdomains_req_ctx {
     struct ad_subdomains_ctx *sd_ctx;
     struct sdap_id_op *sdap_op;
 
-    char *current_filter;
-    size_t base_iter;
-
-    struct ad_id_ctx *root_id_ctx;
-    struct sdap_id_op *root_op;
     size_t root_base_iter;
     struct sysdb_attrs *root_domain;
 
+    /* The trusted domains are read from the forest root. If the root is
+     * known from the previous refresh, the search runs in parallel with
+     * the lookup of the master domain and is restarted only if the root
+     * changed in the meantime. */
+    struct ad_id_ctx *root_id_ctx;
+    struct tevent_req *slave_req;
+    bool slaves_done;
+    bool local_done;
+
     size_t reply_count;
     struct sysdb_attrs **reply;
 
@@ -394,6 +400,10 @@ static errno_t ad_subdomains_refresh(struct ad_subdomains_ctx *ctx,
                 continue;
             }
 
+            /* The warmup might be connecting to this domain, it is
+             * started again with the new list when the refresh finishes */
+            talloc_zfree(ctx->warmup_req);
+
             /* Remove the subdomain from the list of LDAP domains */
             sdap_domain_remove(ctx->sdap_id_ctx->opts, dom);
 
@@ -497,421 +507,414 @@ static errno_t ad_subdom_reinit(struct ad_subdomains_ctx *ctx)
     return EOK;
 }
 
-static void ad_subdomains_get_conn_done(struct tevent_req *req);
-static void ad_subdomains_master_dom_done(struct tevent_req *req);
-static errno_t ad_subdomains_get_root(struct ad_subdomains_req_ctx *ctx);
-static errno_t ad_subdomains_get_slave(struct ad_subdomains_req_ctx *ctx);
+struct ad_get_slave_domains_state {
+    struct tevent_context *ev;
+    struct ad_id_ctx *root_id_ctx;
+    struct sdap_id_op *root_op;
+    size_t base_iter;
+    int dp_error;
 
-static void ad_subdomains_retrieve(struct ad_subdomains_ctx *ctx,
-                                   struct be_req *be_req)
+    size_t reply_count;
+    struct sysdb_attrs **reply;
+};
+
+static void ad_get_slave_domains_connect_done(struct tevent_req *subreq);
+static errno_t ad_get_slave_domains_next(struct tevent_req *req);
+static void ad_get_slave_domains_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+ad_get_slave_domains_send(TALLOC_CTX *mem_ctx,
+                          struct tevent_context *ev,
+                          struct ad_id_ctx *root_id_ctx)
 {
-    struct ad_subdomains_req_ctx *req_ctx = NULL;
+    struct ad_get_slave_domains_state *state;
+    struct tevent_req *subreq;
     struct tevent_req *req;
-    int dp_error = DP_ERR_FATAL;
-    int ret;
+    errno_t ret;
 
-    req_ctx = talloc(be_req, struct ad_subdomains_req_ctx);
-    if (req_ctx == NULL) {
-        ret = ENOMEM;
-        goto done;
+    req = tevent_req_create(mem_ctx, &state,
+                            struct ad_get_slave_domains_state);
+    if (req == NULL) {
+        return NULL;
     }
 
-    req_ctx->be_req = be_req;
-    req_ctx->sd_ctx = ctx;
-    req_ctx->current_filter = NULL;
-    req_ctx->base_iter = 0;
-    req_ctx->root_base_iter = 0;
-    req_ctx->root_id_ctx = NULL;
-    req_ctx->root_op = NULL;
-    req_ctx->root_domain = NULL;
-    req_ctx->reply_count = 0;
-    req_ctx->reply = NULL;
+    state->ev = ev;
+    state->root_id_ctx = root_id_ctx;
+    state->dp_error = DP_ERR_FATAL;
 
-    req_ctx->sdap_op = sdap_id_op_create(req_ctx,
-                                         ctx->ldap_ctx->conn_cache);
-    if (req_ctx->sdap_op == NULL) {
+    state->root_op = sdap_id_op_create(state,
+                                       root_id_ctx->ldap_ctx->conn_cache);
+    if (state->root_op == NULL) {
         DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_create failed.\n");
         ret = ENOMEM;
-        goto done;
+        goto immediately;
     }
 
-    req = sdap_id_op_connect_send(req_ctx->sdap_op, req_ctx, &ret);
-    if (req == NULL) {
+    subreq = sdap_id_op_connect_send(state->root_op, state, &ret);
+    if (subreq == NULL) {
         DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_connect_send failed: %d(%s).\n",
                                   ret, strerror(ret));
-        goto done;
+        goto immediately;
     }
 
-    tevent_req_set_callback(req, ad_subdomains_get_conn_done, req_ctx);
-
-    return;
+    tevent_req_set_callback(subreq, ad_get_slave_domains_connect_done, req);
+    return req;
 
-done:
-    talloc_free(req_ctx);
-    if (ret == EOK) {
-        dp_error = DP_ERR_OK;
-    }
-    be_req_terminate(be_req, dp_error, ret, NULL);
+immediately:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
 }
 
-static void ad_subdomains_get_conn_done(struct tevent_req *req)
+static void ad_get_slave_domains_connect_done(struct tevent_req *subreq)
 {
-    int ret;
-    int dp_error = DP_ERR_FATAL;
-    struct ad_subdomains_req_ctx *ctx;
+    struct ad_get_slave_domains_state *state;
+    struct tevent_req *req;
+    errno_t ret;
 
-    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ad_get_slave_domains_state);
 
-    ret = sdap_id_op_connect_recv(req, &dp_error);
-    talloc_zfree(req);
-    if (ret) {
-        if (dp_error == DP_ERR_OFFLINE) {
+    ret = sdap_id_op_connect_recv(subreq, &state->dp_error);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        if (state->dp_error == DP_ERR_OFFLINE) {
             DEBUG(SSSDBG_MINOR_FAILURE,
                   "No AD server is available, cannot get the "
-                   "subdomain list while offline\n");
+                  "subdomain list while offline\n");
         } else {
             DEBUG(SSSDBG_OP_FAILURE,
                   "Failed to connect to AD server: [%d](%s)\n",
-                   ret, strerror(ret));
+                  ret, strerror(ret));
         }
 
-        goto fail;
+        tevent_req_error(req, ret);
+        return;
     }
 
-    req = ad_master_domain_send(ctx, ctx->sd_ctx->be_ctx->ev,
-                                ctx->sd_ctx->ldap_ctx,
-                                ctx->sdap_op,
-                                ctx->sd_ctx->domain_name);
-    if (req == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "ad_master_domain_send failed.\n");
-        ret = ENOMEM;
-        goto fail;
+    ret = ad_get_slave_domains_next(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
     }
-    tevent_req_set_callback(req, ad_subdomains_master_dom_done, ctx);
-    return;
-
-fail:
-    be_req_terminate(ctx->be_req, dp_error, ret, NULL);
 }
 
-static void ad_subdomains_master_dom_done(struct tevent_req *req)
+static errno_t ad_get_slave_domains_next(struct tevent_req *req)
 {
-    struct ad_subdomains_req_ctx *ctx;
+    struct ad_get_slave_domains_state *state;
+    struct sdap_options *opts;
+    struct tevent_req *subreq;
+    struct sdap_search_base *base;
+    const char *slave_dom_attrs[] = { AD_AT_FLATNAME, AD_AT_TRUST_PARTNER,
+                                      AD_AT_SID, AD_AT_TRUST_TYPE,
+                                      AD_AT_TRUST_ATTRS, NULL };
     errno_t ret;
 
-    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
+    state = tevent_req_data(req, struct ad_get_slave_domains_state);
+    opts = state->root_id_ctx->sdap_id_ctx->opts;
 
-    ret = ad_master_domain_recv(req, ctx,
-                                &ctx->flat_name, &ctx->master_sid,
-                                &ctx->site, &ctx->forest);
-    talloc_zfree(req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "Cannot retrieve master domain info\n");
-        goto done;
+    base = opts->sdom->search_bases[state->base_iter];
+    if (base == NULL) {
+        ret = sdap_id_op_done(state->root_op, EOK, &state->dp_error);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Failed to search the AD server: [%d](%s)\n",
+                  ret, strerror(ret));
+            return ret;
+        }
+
+        return EOK;
     }
 
-    ret = sysdb_master_domain_add_info(ctx->sd_ctx->be_ctx->domain,
-                                       ctx->flat_name, ctx->master_sid,
-                                       ctx->forest);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "Cannot save master domain info\n");
-        goto done;
+    subreq = sdap_get_generic_send(state, state->ev, opts,
+                                   sdap_id_op_handle(state->root_op),
+                                   base->basedn, LDAP_SCOPE_SUBTREE,
+                                   SLAVE_DOMAIN_FILTER, slave_dom_attrs,
+                                   NULL, 0,
+                                   dp_opt_get_int(opts->basic,
+                                                  SDAP_SEARCH_TIMEOUT),
+                                   false);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send failed.\n");
+        return ENOMEM;
     }
 
-    if (ctx->forest == NULL ||
-          strcasecmp(ctx->sd_ctx->be_ctx->domain->name, ctx->forest) != 0) {
-        DEBUG(SSSDBG_TRACE_FUNC,
-              "SSSD needs to look up the forest root domain\n");
-        ret = ad_subdomains_get_root(ctx);
-    } else {
-        DEBUG(SSSDBG_TRACE_FUNC,
-              "Connected to forest root, looking up child domains..\n");
+    tevent_req_set_callback(subreq, ad_get_slave_domains_done, req);
+    return EAGAIN;
+}
 
-        ctx->root_op = ctx->sdap_op;
-        ctx->root_id_ctx = ctx->sd_ctx->ad_id_ctx;
+static void ad_get_slave_domains_done(struct tevent_req *subreq)
+{
+    struct ad_get_slave_domains_state *state;
+    struct tevent_req *req;
+    struct sysdb_attrs **reply;
+    size_t reply_count;
+    size_t i;
+    errno_t ret;
 
-        ret = ad_subdomains_get_slave(ctx);
-    }
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ad_get_slave_domains_state);
 
-    if (ret == EAGAIN) {
+    ret = sdap_get_generic_recv(subreq, state, &reply_count, &reply);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send request failed.\n");
+        tevent_req_error(req, ret);
         return;
-    } else if (ret != EOK) {
-        goto done;
     }
 
-done:
-    be_req_terminate(ctx->be_req, DP_ERR_FATAL, ret, NULL);
+    if (reply_count) {
+        state->reply = talloc_realloc(state, state->reply,
+                                      struct sysdb_attrs *,
+                                      state->reply_count + reply_count);
+        if (state->reply == NULL) {
+            tevent_req_error(req, ENOMEM);
+            return;
+        }
+
+        for (i = 0; i < reply_count; i++) {
+            state->reply[state->reply_count + i] =
+                                talloc_steal(state->reply, reply[i]);
+        }
+        state->reply_count += reply_count;
+    }
+    talloc_free(reply);
+
+    state->base_iter++;
+    ret = ad_get_slave_domains_next(req);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else if (ret != EAGAIN) {
+        tevent_req_error(req, ret);
+    }
 }
 
-static void ad_subdomains_get_root_domain_done(struct tevent_req *req);
+static errno_t ad_get_slave_domains_recv(struct tevent_req *req,
+                                         TALLOC_CTX *mem_ctx,
+                                         int *_dp_error,
+                                         size_t *_reply_count,
+                                         struct sysdb_attrs ***_reply)
+{
+    struct ad_get_slave_domains_state *state;
 
-static errno_t ad_subdomains_get_root(struct ad_subdomains_req_ctx *ctx)
+    state = tevent_req_data(req, struct ad_get_slave_domains_state);
+
+    *_dp_error = state->dp_error;
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *_reply_count = state->reply_count;
+    *_reply = talloc_steal(mem_ctx, state->reply);
+
+    return EOK;
+}
+
+/* Connects to the trusted domains in the background after they were
+ * discovered, so that the first lookup in each of them does not have to
+ * wait for the DNS SRV and site lookups and for the LDAP connection. At
+ * most limit connections are being established at the same time. */
+struct ad_subdom_warmup_state {
+    struct tevent_context *ev;
+    struct ad_id_ctx **id_ctxs;
+    const char **names;
+    size_t count;
+    size_t next;
+    size_t running;
+    size_t limit;
+};
+
+struct ad_subdom_warmup_conn {
+    struct tevent_req *req;
+    const char *name;
+    struct sdap_id_op *op;
+};
+
+static void ad_subdom_warmup_step(struct tevent_req *req);
+static void ad_subdom_warmup_conn_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+ad_subdom_warmup_send(TALLOC_CTX *mem_ctx,
+                      struct tevent_context *ev,
+                      struct ad_subdomains_ctx *sd_ctx,
+                      int limit)
 {
+    struct ad_subdom_warmup_state *state;
     struct tevent_req *req;
-    struct sdap_search_base *base;
-    struct sdap_id_ctx *sdap_id_ctx;
-    char *filter;
-    const char *forest_root_attrs[] = { AD_AT_FLATNAME, AD_AT_TRUST_PARTNER,
-                                        AD_AT_SID, AD_AT_TRUST_TYPE,
-                                        AD_AT_TRUST_ATTRS, NULL };
+    struct sdap_domain *sditer;
+    size_t count;
 
-    sdap_id_ctx = ctx->sd_ctx->sdap_id_ctx;
-    base = sdap_id_ctx->opts->sdom->search_bases[ctx->root_base_iter];
-    if (base == NULL) {
-        return EOK;
+    req = tevent_req_create(mem_ctx, &state, struct ad_subdom_warmup_state);
+    if (req == NULL) {
+        return NULL;
     }
 
-    filter = talloc_asprintf(ctx, FOREST_ROOT_FILTER_FMT, ctx->forest);
-    if (filter == NULL) {
-        return ENOMEM;
+    state->ev = ev;
+    state->limit = limit;
+
+    count = 0;
+    DLIST_FOR_EACH(sditer, sd_ctx->sdom) {
+        count++;
     }
 
-    req = sdap_get_generic_send(ctx, ctx->sd_ctx->be_ctx->ev,
-                                sdap_id_ctx->opts,
-                                sdap_id_op_handle(ctx->sdap_op),
-                                base->basedn, LDAP_SCOPE_SUBTREE,
-                                filter, forest_root_attrs,
-                                NULL, 0,
-                                dp_opt_get_int(sdap_id_ctx->opts->basic,
-                                                SDAP_SEARCH_TIMEOUT),
-                                false);
+    /* The ID contexts belong to the subdomains, ad_subdomains_refresh()
+     * cancels this request before it removes a subdomain */
+    state->id_ctxs = talloc_zero_array(state, struct ad_id_ctx *, count);
+    state->names = talloc_zero_array(state, const char *, count);
+    if (state->id_ctxs == NULL || state->names == NULL) {
+        tevent_req_error(req, ENOMEM);
+        tevent_req_post(req, ev);
+        return req;
+    }
 
-    if (req == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send failed.\n");
-        return ENOMEM;
+    DLIST_FOR_EACH(sditer, sd_ctx->sdom) {
+        if (!IS_SUBDOMAIN(sditer->dom) || sditer->pvt == NULL
+                || sditer->dom->disabled) {
+            continue;
+        }
+
+        state->names[state->count] = talloc_strdup(state->names,
+                                                   sditer->dom->name);
+        if (state->names[state->count] == NULL) {
+            tevent_req_error(req, ENOMEM);
+            tevent_req_post(req, ev);
+            return req;
+        }
+        state->id_ctxs[state->count] = talloc_get_type(sditer->pvt,
+                                                       struct ad_id_ctx);
+        state->count++;
     }
 
-    tevent_req_set_callback(req, ad_subdomains_get_root_domain_done, ctx);
-    return EAGAIN;
-}
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Connecting to %zu trusted domains, %zu at a time\n",
+          state->count, state->limit);
 
-static struct ad_id_ctx *ads_get_root_id_ctx(struct ad_subdomains_req_ctx *ctx);
-static void ad_subdomains_root_conn_done(struct tevent_req *req);
+    ad_subdom_warmup_step(req);
+    if (tevent_req_is_in_progress(req) && state->running == 0) {
+        tevent_req_done(req);
+        tevent_req_post(req, ev);
+    }
 
-static void ad_subdomains_get_root_domain_done(struct tevent_req *req)
-{
-    int ret;
-    size_t reply_count;
-    struct sysdb_attrs **reply = NULL;
-    struct ad_subdomains_req_ctx *ctx;
-    int dp_error = DP_ERR_FATAL;
-    bool has_changes = false;
+    return req;
+}
 
-    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
+static void ad_subdom_warmup_step(struct tevent_req *req)
+{
+    struct ad_subdom_warmup_state *state;
+    struct ad_subdom_warmup_conn *conn;
+    struct ad_id_ctx *subdom_id_ctx;
+    struct tevent_req *subreq;
+    errno_t ret;
 
-    ret = sdap_get_generic_recv(req, ctx, &reply_count, &reply);
-    talloc_zfree(req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send request failed.\n");
-        goto fail;
-    }
+    state = tevent_req_data(req, struct ad_subdom_warmup_state);
 
-    if (reply_count == 0) {
-        /* If no root domain was found in the default search base, try the
-         * next one, if available
-         */
-        ctx->root_base_iter++;
-        ret = ad_subdomains_get_root(ctx);
-        if (ret == EAGAIN) {
+    while (state->next < state->count && state->running < state->limit) {
+        subdom_id_ctx = state->id_ctxs[state->next];
+        conn = talloc_zero(state, struct ad_subdom_warmup_conn);
+        if (conn == NULL) {
+            tevent_req_error(req, ENOMEM);
             return;
         }
 
-        goto fail;
-    } else if (reply_count > 1) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Multiple results for root domain search, "
-              "domain list might be incomplete!\n");
-
-        ctx->root_op = ctx->sdap_op;
-        ctx->root_id_ctx = ctx->sd_ctx->ad_id_ctx;
+        conn->req = req;
+        conn->name = state->names[state->next];
+        state->next++;
 
-        ret = ad_subdomains_get_slave(ctx);
-        if (ret == EAGAIN) {
+        conn->op = sdap_id_op_create(conn,
+                                     subdom_id_ctx->ldap_ctx->conn_cache);
+        if (conn->op == NULL) {
+            talloc_free(conn);
+            tevent_req_error(req, ENOMEM);
             return;
         }
 
-        goto fail;
-    }
-    /* Exactly one result, good. */
-
-    /* We won't use the operation to the local LDAP anymore, but
-     * read from the forest root
-     */
-    ret = sdap_id_op_done(ctx->sdap_op, ret, &dp_error);
-    if (ret != EOK) {
-        if (dp_error == DP_ERR_OFFLINE) {
+        subreq = sdap_id_op_connect_send(conn->op, conn, &ret);
+        if (subreq == NULL) {
             DEBUG(SSSDBG_MINOR_FAILURE,
-                  "No AD server is available, cannot get the "
-                   "subdomain list while offline\n");
-        } else {
-            DEBUG(SSSDBG_OP_FAILURE,
-                  "Failed to search the AD server: [%d](%s)\n",
-                  ret, strerror(ret));
+                  "Cannot connect to [%s]: [%d](%s)\n",
+                  conn->name, ret, strerror(ret));
+            talloc_free(conn);
+            continue;
         }
-        goto fail;
+
+        tevent_req_set_callback(subreq, ad_subdom_warmup_conn_done, conn);
+        state->running++;
     }
+}
 
-    ret = ad_subdomains_refresh(ctx->sd_ctx, 1, true, reply, &has_changes);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "ad_subdomains_refresh failed.\n");
-        goto fail;
-    }
-
-    if (has_changes) {
-        ret = ad_subdom_reinit(ctx->sd_ctx);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "Could not reinitialize subdomains\n");
-            goto fail;
-        }
-    }
-
-    ctx->root_domain = reply[0];
-    ctx->root_id_ctx = ads_get_root_id_ctx(ctx);
-    if (ctx->root_id_ctx == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "Cannot create id ctx for the root domain\n");
-        ret = EFAULT;
-        goto fail;
-    }
-
-    ctx->root_op = sdap_id_op_create(ctx,
-                                     ctx->root_id_ctx->ldap_ctx->conn_cache);
-    if (ctx->root_op == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_create failed.\n");
-        ret = ENOMEM;
-        goto fail;
-    }
-
-    req = sdap_id_op_connect_send(ctx->root_op, ctx, &ret);
-    if (req == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_connect_send failed: %d(%s).\n",
-                                  ret, strerror(ret));
-        goto fail;
-    }
-
-    tevent_req_set_callback(req, ad_subdomains_root_conn_done, ctx);
-    return;
-
-fail:
-    if (ret == EOK) {
-        ctx->sd_ctx->last_refreshed = time(NULL);
-        dp_error = DP_ERR_OK;
-    }
-    be_req_terminate(ctx->be_req, dp_error, ret, NULL);
-}
-
-static struct ad_id_ctx *ads_get_root_id_ctx(struct ad_subdomains_req_ctx *ctx)
+static void ad_subdom_warmup_conn_done(struct tevent_req *subreq)
 {
+    struct ad_subdom_warmup_state *state;
+    struct ad_subdom_warmup_conn *conn;
+    struct tevent_req *req;
+    int dp_error;
     errno_t ret;
-    const char *name;
-    struct sss_domain_info *root;
-    struct sdap_domain *sdom;
-    struct ad_id_ctx *root_id_ctx;
 
-    ret = sysdb_attrs_get_string(ctx->root_domain, AD_AT_TRUST_PARTNER, &name);
+    conn = tevent_req_callback_data(subreq, struct ad_subdom_warmup_conn);
+    req = conn->req;
+    state = tevent_req_data(req, struct ad_subdom_warmup_state);
+
+    ret = sdap_id_op_connect_recv(subreq, &dp_error);
+    talloc_zfree(subreq);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "sysdb_attrs_get_string failed.\n");
-        return NULL;
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot connect to [%s]: [%d](%s)\n",
+              conn->name, ret, strerror(ret));
+    } else {
+        DEBUG(SSSDBG_TRACE_FUNC, "Connected to [%s]\n", conn->name);
     }
 
-    /* With a subsequent run, the root should already be known */
-    root = find_domain_by_name(ctx->sd_ctx->be_ctx->domain,
-                               name, false);
-    if (root == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "Could not find the root domain\n");
-        return NULL;
-    }
+    /* The connection stays in the connection cache of the domain */
+    talloc_free(conn);
+    state->running--;
 
-    sdom = sdap_domain_get(ctx->sd_ctx->ad_id_ctx->sdap_id_ctx->opts, root);
-    if (sdom == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE,
-              "Cannot get the sdom for %s!\n", root->name);
-        return NULL;
+    ad_subdom_warmup_step(req);
+    if (tevent_req_is_in_progress(req) && state->running == 0) {
+        tevent_req_done(req);
     }
+}
 
-    if (sdom->pvt == NULL) {
-        ret = ad_subdom_ad_ctx_new(ctx->sd_ctx->be_ctx,
-                                   ctx->sd_ctx->ad_id_ctx,
-                                   root,
-                                   &root_id_ctx);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "ad_subdom_ad_ctx_new failed.\n");
-            return NULL;
-        }
-        sdom->pvt = root_id_ctx;
-    } else {
-        root_id_ctx = sdom->pvt;
-    }
+static errno_t ad_subdom_warmup_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
 
-    return root_id_ctx;
+    return EOK;
 }
 
-static void ad_subdomains_root_conn_done(struct tevent_req *req)
+static void ad_subdom_warmup_done(struct tevent_req *req)
 {
-    int ret;
-    int dp_error = DP_ERR_FATAL;
-    struct ad_subdomains_req_ctx *ctx;
+    struct ad_subdomains_ctx *ctx;
+    errno_t ret;
 
-    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
+    ctx = tevent_req_callback_data(req, struct ad_subdomains_ctx);
 
-    ret = sdap_id_op_connect_recv(req, &dp_error);
+    ret = ad_subdom_warmup_recv(req);
     talloc_zfree(req);
-    if (ret) {
-        if (dp_error == DP_ERR_OFFLINE) {
-            DEBUG(SSSDBG_MINOR_FAILURE,
-                  "No AD server is available, cannot get the "
-                  "subdomain list while offline\n");
-        } else {
-            DEBUG(SSSDBG_OP_FAILURE,
-                  "Failed to connect to AD server: [%d](%s)\n",
-                  ret, strerror(ret));
-        }
-
-        goto fail;
-    }
-
-    ret = ad_subdomains_get_slave(ctx);
-    if (ret == EAGAIN) {
-        return;
-    } else if (ret != EOK) {
-        goto fail;
+    ctx->warmup_req = NULL;
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Connecting to the trusted domains failed [%d]: %s\n",
+              ret, sss_strerror(ret));
     }
-
-fail:
-    be_req_terminate(ctx->be_req, dp_error, ret, NULL);
 }
 
-static void ad_subdomains_get_slave_domain_done(struct tevent_req *req);
-
-static errno_t ad_subdomains_get_slave(struct ad_subdomains_req_ctx *ctx)
+static void ad_subdom_warmup(struct ad_subdomains_ctx *ctx)
 {
-    struct tevent_req *req;
-    struct sdap_search_base *base;
-    const char *slave_dom_attrs[] = { AD_AT_FLATNAME, AD_AT_TRUST_PARTNER,
-                                      AD_AT_SID, AD_AT_TRUST_TYPE,
-                                      AD_AT_TRUST_ATTRS, NULL };
+    int limit;
 
-    base = ctx->root_id_ctx->sdap_id_ctx->opts->sdom->search_bases[ctx->base_iter];
-    if (base == NULL) {
-        return EOK;
+    limit = dp_opt_get_int(ctx->ad_id_ctx->ad_options->basic,
+                           AD_SUBDOMAIN_WARMUP_LIMIT);
+    if (limit <= 0 || ctx->warmup_req != NULL) {
+        return;
     }
 
-    req = sdap_get_generic_send(ctx, ctx->sd_ctx->be_ctx->ev,
-                           ctx->root_id_ctx->sdap_id_ctx->opts,
-                           sdap_id_op_handle(ctx->root_op),
-                           base->basedn, LDAP_SCOPE_SUBTREE,
-                           SLAVE_DOMAIN_FILTER, slave_dom_attrs,
-                           NULL, 0,
-                           dp_opt_get_int(ctx->root_id_ctx->sdap_id_ctx->opts->basic,
-                                          SDAP_SEARCH_TIMEOUT),
-                           false);
-
-    if (req == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send failed.\n");
-        return ENOMEM;
+    ctx->warmup_req = ad_subdom_warmup_send(ctx, ctx->be_ctx->ev, ctx, limit);
+    if (ctx->warmup_req == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "ad_subdom_warmup_send failed.\n");
+        return;
     }
 
-    tevent_req_set_callback(req, ad_subdomains_get_slave_domain_done, ctx);
-    return EAGAIN;
+    tevent_req_set_callback(ctx->warmup_req, ad_subdom_warmup_done, ctx);
 }
 
 static errno_t ad_subdomains_process(TALLOC_CTX *mem_ctx,
@@ -976,75 +979,28 @@ fail:
     return ret;
 }
 
-static void ad_subdomains_get_slave_domain_done(struct tevent_req *req)
+static void ad_subdomains_finish(struct ad_subdomains_req_ctx *ctx)
 {
-    int ret;
-    size_t reply_count;
-    struct sysdb_attrs **reply = NULL;
-    struct ad_subdomains_req_ctx *ctx;
-    int dp_error = DP_ERR_FATAL;
+    struct ad_subdomains_ctx *sd_ctx = ctx->sd_ctx;
     bool refresh_has_changes = false;
     size_t nsubdoms;
     struct sysdb_attrs **subdoms;
-
-    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
-
-    ret = sdap_get_generic_recv(req, ctx, &reply_count, &reply);
-    talloc_zfree(req);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send request failed.\n");
-        goto done;
-    }
-
-    if (reply_count) {
-        ctx->reply = talloc_realloc(ctx, ctx->reply, struct sysdb_attrs *,
-                                    ctx->reply_count + reply_count);
-        if (ctx->reply == NULL) {
-            ret = ENOMEM;
-            goto done;
-        }
-        memcpy(ctx->reply+ctx->reply_count, reply,
-               reply_count * sizeof(struct sysdb_attrs *));
-        ctx->reply_count += reply_count;
-    }
-
-    ctx->base_iter++;
-    ret = ad_subdomains_get_slave(ctx);
-    if (ret == EAGAIN) {
-        /* Search in progress */
-        return;
-    }
-
-    ret = sdap_id_op_done(ctx->root_op, ret, &dp_error);
-    if (ret != EOK) {
-        if (dp_error == DP_ERR_OFFLINE) {
-            DEBUG(SSSDBG_MINOR_FAILURE,
-                  "No AD server is available, cannot get the "
-                   "subdomain list while offline\n");
-        } else {
-            DEBUG(SSSDBG_OP_FAILURE,
-                  "Failed to search the AD server: [%d](%s)\n",
-                  ret, strerror(ret));
-        }
-        tevent_req_error(req, ret);
-        return;
-    }
+    errno_t ret;
 
     /* Based on whether we are connected to the forest root or not, we might
      * need to exclude the subdomain we are connected to from the list of
      * subdomains
      */
-    ret = ad_subdomains_process(ctx, ctx->sd_ctx->be_ctx->domain,
+    ret = ad_subdomains_process(ctx, sd_ctx->be_ctx->domain,
                                 ctx->reply_count, ctx->reply,
                                 ctx->root_domain, &nsubdoms, &subdoms);
     if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, ("Cannot process subdomain list\n"));
-        tevent_req_error(req, ret);
-        return;
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot process subdomain list\n");
+        goto done;
     }
 
     /* Got all the subdomains, let's process them */
-    ret = ad_subdomains_refresh(ctx->sd_ctx, nsubdoms, false, subdoms,
+    ret = ad_subdomains_refresh(sd_ctx, nsubdoms, false, subdoms,
                                 &refresh_has_changes);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Failed to refresh subdomains.\n");
@@ -1055,7 +1011,7 @@ static void ad_subdomains_get_slave_domain_done(struct tevent_req *req)
                     refresh_has_changes ? "" : "no ");
 
     if (refresh_has_changes) {
-        ret = ad_subdom_reinit(ctx->sd_ctx);
+        ret = ad_subdom_reinit(sd_ctx);
         if (ret != EOK) {
             DEBUG(SSSDBG_OP_FAILURE, "Could not reinitialize subdomains\n");
             goto done;
@@ -1064,6 +1020,453 @@ static void ad_subdomains_get_slave_domain_done(struct tevent_req *req)
 
     ret = EOK;
 done:
+    if (ret == EOK) {
+        sd_ctx->last_refreshed = time(NULL);
+        ad_subdom_warmup(sd_ctx);
+        be_req_terminate(ctx->be_req, DP_ERR_OK, ret, NULL);
+        return;
+    }
+
+    be_req_terminate(ctx->be_req, DP_ERR_FATAL, ret, NULL);
+}
+
+static void ad_subdomains_slaves_done(struct tevent_req *req);
+
+/* Starts reading the trusted domains from root_id_ctx unless a search of
+ * the same root is already running or finished */
+static errno_t ad_subdomains_get_slaves(struct ad_subdomains_req_ctx *ctx,
+                                        struct ad_id_ctx *root_id_ctx)
+{
+    if (ctx->root_id_ctx == root_id_ctx
+            && (ctx->slave_req != NULL || ctx->slaves_done)) {
+        return EOK;
+    }
+
+    if (ctx->root_id_ctx != NULL) {
+        DEBUG(SSSDBG_TRACE_FUNC, "The forest root changed, "
+              "searching for the trusted domains again\n");
+    }
+
+    talloc_zfree(ctx->slave_req);
+    talloc_zfree(ctx->reply);
+    ctx->reply_count = 0;
+    ctx->slaves_done = false;
+    ctx->root_id_ctx = root_id_ctx;
+
+    ctx->slave_req = ad_get_slave_domains_send(ctx, ctx->sd_ctx->be_ctx->ev,
+                                               root_id_ctx);
+    if (ctx->slave_req == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "ad_get_slave_domains_send failed.\n");
+        ctx->root_id_ctx = NULL;
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(ctx->slave_req, ad_subdomains_slaves_done, ctx);
+    return EOK;
+}
+
+static void ad_subdomains_slaves_done(struct tevent_req *req)
+{
+    struct ad_subdomains_req_ctx *ctx;
+    int dp_error;
+    errno_t ret;
+
+    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
+
+    ret = ad_get_slave_domains_recv(req, ctx, &dp_error,
+                                    &ctx->reply_count, &ctx->reply);
+    talloc_zfree(req);
+    ctx->slave_req = NULL;
+    if (ret != EOK) {
+        if (!ctx->local_done) {
+            /* The forest root from the previous refresh might be gone, the
+             * lookup of the master domain will tell where to search */
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Cannot read the trusted domains from the cached forest "
+                  "root [%d]: %s\n", ret, sss_strerror(ret));
+            ctx->root_id_ctx = NULL;
+            return;
+        }
+
+        be_req_terminate(ctx->be_req, dp_error, ret, NULL);
+        return;
+    }
+
+    ctx->slaves_done = true;
+    if (ctx->local_done) {
+        ad_subdomains_finish(ctx);
+    }
+}
+
+/* The master domain and the forest root are known */
+static void ad_subdomains_local_done(struct ad_subdomains_req_ctx *ctx,
+                                     struct ad_id_ctx *root_id_ctx)
+{
+    errno_t ret;
+
+    ret = ad_subdomains_get_slaves(ctx, root_id_ctx);
+    if (ret != EOK) {
+        be_req_terminate(ctx->be_req, DP_ERR_FATAL, ret, NULL);
+        return;
+    }
+
+    ctx->local_done = true;
+    if (ctx->slaves_done) {
+        ad_subdomains_finish(ctx);
+    }
+}
+
+/* If the forest root is known from the previous refresh, start reading the
+ * trusted domains right away instead of after the master domain lookup */
+static void ad_subdomains_get_slaves_early(struct ad_subdomains_req_ctx *ctx)
+{
+    struct sss_domain_info *domain = ctx->sd_ctx->be_ctx->domain;
+    struct sss_domain_info *root;
+    struct sdap_domain *sdom;
+    struct ad_id_ctx *root_id_ctx;
+    errno_t ret;
+
+    if (domain->forest == NULL) {
+        return;
+    }
+
+    if (strcasecmp(domain->name, domain->forest) == 0) {
+        root_id_ctx = ctx->sd_ctx->ad_id_ctx;
+    } else {
+        root = find_domain_by_name(domain, domain->forest, false);
+        if (root == NULL) {
+            return;
+        }
+
+        sdom = sdap_domain_get(ctx->sd_ctx->ad_id_ctx->sdap_id_ctx->opts,
+                               root);
+        if (sdom == NULL || sdom->pvt == NULL) {
+            return;
+        }
+
+        root_id_ctx = talloc_get_type(sdom->pvt, struct ad_id_ctx);
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Searching for the trusted domains in the cached forest root [%s]\n",
+          domain->forest);
+
+    ret = ad_subdomains_get_slaves(ctx, root_id_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot search the cached forest root, will retry after the "
+              "master domain lookup\n");
+    }
+}
+
+static void ad_subdomains_get_conn_done(struct tevent_req *req);
+static void ad_subdomains_master_dom_done(struct tevent_req *req);
+static errno_t ad_subdomains_get_root(struct ad_subdomains_req_ctx *ctx);
+
+static void ad_subdomains_retrieve(struct ad_subdomains_ctx *ctx,
+                                   struct be_req *be_req)
+{
+    struct ad_subdomains_req_ctx *req_ctx = NULL;
+    struct tevent_req *req;
+    int dp_error = DP_ERR_FATAL;
+    int ret;
+
+    req_ctx = talloc_zero(be_req, struct ad_subdomains_req_ctx);
+    if (req_ctx == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    req_ctx->be_req = be_req;
+    req_ctx->sd_ctx = ctx;
+
+    req_ctx->sdap_op = sdap_id_op_create(req_ctx,
+                                         ctx->ldap_ctx->conn_cache);
+    if (req_ctx->sdap_op == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_create failed.\n");
+        ret = ENOMEM;
+        goto done;
+    }
+
+    req = sdap_id_op_connect_send(req_ctx->sdap_op, req_ctx, &ret);
+    if (req == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_id_op_connect_send failed: %d(%s).\n",
+                                  ret, strerror(ret));
+        goto done;
+    }
+
+    tevent_req_set_callback(req, ad_subdomains_get_conn_done, req_ctx);
+
+    ad_subdomains_get_slaves_early(req_ctx);
+
+    return;
+
+done:
+    talloc_free(req_ctx);
+    if (ret == EOK) {
+        dp_error = DP_ERR_OK;
+    }
+    be_req_terminate(be_req, dp_error, ret, NULL);
+}
+
+static void ad_subdomains_get_conn_done(struct tevent_req *req)
+{
+    int ret;
+    int dp_error = DP_ERR_FATAL;
+    struct ad_subdomains_req_ctx *ctx;
+
+    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
+
+    ret = sdap_id_op_connect_recv(req, &dp_error);
+    talloc_zfree(req);
+    if (ret) {
+        if (dp_error == DP_ERR_OFFLINE) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "No AD server is available, cannot get the "
+                   "subdomain list while offline\n");
+        } else {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Failed to connect to AD server: [%d](%s)\n",
+                   ret, strerror(ret));
+        }
+
+        goto fail;
+    }
+
+    req = ad_master_domain_send(ctx, ctx->sd_ctx->be_ctx->ev,
+                                ctx->sd_ctx->ldap_ctx,
+                                ctx->sdap_op,
+                                ctx->sd_ctx->domain_name);
+    if (req == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "ad_master_domain_send failed.\n");
+        ret = ENOMEM;
+        goto fail;
+    }
+    tevent_req_set_callback(req, ad_subdomains_master_dom_done, ctx);
+    return;
+
+fail:
+    be_req_terminate(ctx->be_req, dp_error, ret, NULL);
+}
+
+static void ad_subdomains_master_dom_done(struct tevent_req *req)
+{
+    struct ad_subdomains_req_ctx *ctx;
+    errno_t ret;
+
+    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
+
+    ret = ad_master_domain_recv(req, ctx,
+                                &ctx->flat_name, &ctx->master_sid,
+                                &ctx->site, &ctx->forest);
+    talloc_zfree(req);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot retrieve master domain info\n");
+        goto done;
+    }
+
+    ret = sysdb_master_domain_add_info(ctx->sd_ctx->be_ctx->domain,
+                                       ctx->flat_name, ctx->master_sid,
+                                       ctx->forest);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot save master domain info\n");
+        goto done;
+    }
+
+    if (ctx->forest == NULL ||
+          strcasecmp(ctx->sd_ctx->be_ctx->domain->name, ctx->forest) != 0) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "SSSD needs to look up the forest root domain\n");
+        ret = ad_subdomains_get_root(ctx);
+    } else {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Connected to forest root, looking up child domains..\n");
+
+        ad_subdomains_local_done(ctx, ctx->sd_ctx->ad_id_ctx);
+        return;
+    }
+
+    if (ret == EAGAIN) {
+        return;
+    } else if (ret != EOK) {
+        goto done;
+    }
+
+done:
+    be_req_terminate(ctx->be_req, DP_ERR_FATAL, ret, NULL);
+}
+
+static void ad_subdomains_get_root_domain_done(struct tevent_req *req);
+
+static errno_t ad_subdomains_get_root(struct ad_subdomains_req_ctx *ctx)
+{
+    struct tevent_req *req;
+    struct sdap_search_base *base;
+    struct sdap_id_ctx *sdap_id_ctx;
+    char *filter;
+    const char *forest_root_attrs[] = { AD_AT_FLATNAME, AD_AT_TRUST_PARTNER,
+                                        AD_AT_SID, AD_AT_TRUST_TYPE,
+                                        AD_AT_TRUST_ATTRS, NULL };
+
+    sdap_id_ctx = ctx->sd_ctx->sdap_id_ctx;
+    base = sdap_id_ctx->opts->sdom->search_bases[ctx->root_base_iter];
+    if (base == NULL) {
+        return EOK;
+    }
+
+    filter = talloc_asprintf(ctx, FOREST_ROOT_FILTER_FMT, ctx->forest);
+    if (filter == NULL) {
+        return ENOMEM;
+    }
+
+    req = sdap_get_generic_send(ctx, ctx->sd_ctx->be_ctx->ev,
+                                sdap_id_ctx->opts,
+                                sdap_id_op_handle(ctx->sdap_op),
+                                base->basedn, LDAP_SCOPE_SUBTREE,
+                                filter, forest_root_attrs,
+                                NULL, 0,
+                                dp_opt_get_int(sdap_id_ctx->opts->basic,
+                                                SDAP_SEARCH_TIMEOUT),
+                                false);
+
+    if (req == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send failed.\n");
+        return ENOMEM;
+    }
+
+    tevent_req_set_callback(req, ad_subdomains_get_root_domain_done, ctx);
+    return EAGAIN;
+}
+
+static struct ad_id_ctx *ads_get_root_id_ctx(struct ad_subdomains_req_ctx *ctx)
+{
+    errno_t ret;
+    const char *name;
+    struct sss_domain_info *root;
+    struct sdap_domain *sdom;
+    struct ad_id_ctx *root_id_ctx;
+
+    ret = sysdb_attrs_get_string(ctx->root_domain, AD_AT_TRUST_PARTNER, &name);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "sysdb_attrs_get_string failed.\n");
+        return NULL;
+    }
+
+    /* With a subsequent run, the root should already be known */
+    root = find_domain_by_name(ctx->sd_ctx->be_ctx->domain,
+                               name, false);
+    if (root == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Could not find the root domain\n");
+        return NULL;
+    }
+
+    sdom = sdap_domain_get(ctx->sd_ctx->ad_id_ctx->sdap_id_ctx->opts, root);
+    if (sdom == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the sdom for %s!\n", root->name);
+        return NULL;
+    }
+
+    if (sdom->pvt == NULL) {
+        ret = ad_subdom_ad_ctx_new(ctx->sd_ctx->be_ctx,
+                                   ctx->sd_ctx->ad_id_ctx,
+                                   root,
+                                   &root_id_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "ad_subdom_ad_ctx_new failed.\n");
+            return NULL;
+        }
+        sdom->pvt = root_id_ctx;
+    } else {
+        root_id_ctx = sdom->pvt;
+    }
+
+    return root_id_ctx;
+}
+
+static void ad_subdomains_get_root_domain_done(struct tevent_req *req)
+{
+    int ret;
+    size_t reply_count;
+    struct sysdb_attrs **reply = NULL;
+    struct ad_subdomains_req_ctx *ctx;
+    struct ad_id_ctx *root_id_ctx;
+    int dp_error = DP_ERR_FATAL;
+    bool has_changes = false;
+
+    ctx = tevent_req_callback_data(req, struct ad_subdomains_req_ctx);
+
+    ret = sdap_get_generic_recv(req, ctx, &reply_count, &reply);
+    talloc_zfree(req);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "sdap_get_generic_send request failed.\n");
+        goto fail;
+    }
+
+    if (reply_count == 0) {
+        /* If no root domain was found in the default search base, try the
+         * next one, if available
+         */
+        ctx->root_base_iter++;
+        ret = ad_subdomains_get_root(ctx);
+        if (ret == EAGAIN) {
+            return;
+        }
+
+        goto fail;
+    } else if (reply_count > 1) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Multiple results for root domain search, "
+              "domain list might be incomplete!\n");
+
+        ad_subdomains_local_done(ctx, ctx->sd_ctx->ad_id_ctx);
+        return;
+    }
+    /* Exactly one result, good. */
+
+    /* We won't use the operation to the local LDAP anymore, but
+     * read from the forest root
+     */
+    ret = sdap_id_op_done(ctx->sdap_op, ret, &dp_error);
+    if (ret != EOK) {
+        if (dp_error == DP_ERR_OFFLINE) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "No AD server is available, cannot get the "
+                   "subdomain list while offline\n");
+        } else {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Failed to search the AD server: [%d](%s)\n",
+                  ret, strerror(ret));
+        }
+        goto fail;
+    }
+
+    ret = ad_subdomains_refresh(ctx->sd_ctx, 1, true, reply, &has_changes);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "ad_subdomains_refresh failed.\n");
+        goto fail;
+    }
+
+    if (has_changes) {
+        ret = ad_subdom_reinit(ctx->sd_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Could not reinitialize subdomains\n");
+            goto fail;
+        }
+    }
+
+    ctx->root_domain = reply[0];
+    root_id_ctx = ads_get_root_id_ctx(ctx);
+    if (root_id_ctx == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot create id ctx for the root domain\n");
+        ret = EFAULT;
+        goto fail;
+    }
+
+    ad_subdomains_local_done(ctx, root_id_ctx);
+    return;
+
+fail:
     if (ret == EOK) {
         ctx->sd_ctx->last_refreshed = time(NULL);
         dp_error = DP_ERR_OK;
@@ -1128,6 +1531,7 @@ static void ad_subdom_offline_cb(void *pvt)
 
     if (ctx) {
         talloc_zfree(ctx->timer_event);
+        talloc_zfree(ctx->warmup_req);
     }
 }
 
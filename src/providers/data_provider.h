@@ -336,6 +336,8 @@ enum dp_res_opts {
     DP_RES_OPT_RESOLVER_TIMEOUT,
     DP_RES_OPT_RESOLVER_OP_TIMEOUT,
     DP_RES_OPT_DNS_DOMAIN,
+    DP_RES_OPT_FO_POLICY,
+    DP_RES_OPT_FO_PROBE_INTERVAL,
 
     DP_RES_OPTS /* attrs counter */
 };
@@ -44,7 +44,9 @@
 #include "providers/fail_over.h"
 #include "providers/dp_refresh.h"
 #include "providers/dp_ptask.h"
+#include "providers/dp_fastpath.h"
 #include "util/child_common.h"
+#include "util/sss_stats.h"
 #include "resolv/async_resolv.h"
 #include "monitor/monitor_interfaces.h"
 
@@ -70,10 +72,13 @@ struct mon_cli_iface monitor_be_methods = {
     .clearMemcache = NULL,
     .clearEnumCache = NULL,
     .sysbusReconnect = NULL,
+    .getStats = monitor_common_get_stats,
 };
 
 static int client_registration(struct sbus_request *dbus_req, void *data);
 static int be_get_account_info(struct sbus_request *dbus_req, void *user_data);
+static int be_get_account_info_multi(struct sbus_request *dbus_req,
+                                     void *user_data);
 static int be_pam_handler(struct sbus_request *dbus_req, void *user_data);
 static int be_sudo_handler(struct sbus_request *dbus_req, void *user_data);
 static int be_autofs_handler(struct sbus_request *dbus_req, void *user_data);
@@ -89,6 +94,7 @@ struct data_provider_iface be_methods = {
     .hostHandler = be_host_handler,
     .getDomains = be_get_subdomains,
     .getAccountInfo = be_get_account_info,
+    .getAccountInfoMulti = be_get_account_info_multi,
 };
 
 static struct bet_data bet_data[] = {
@@ -133,6 +139,9 @@ struct be_req {
      */
     int phase;
 
+    /* when the request was created */
+    struct timeval start;
+
     struct be_req *prev;
     struct be_req *next;
 };
@@ -140,6 +149,7 @@ struct be_req {
 static int be_req_destructor(struct be_req *be_req)
 {
     DLIST_REMOVE(be_req->be_ctx->active_requests, be_req);
+    sss_stats_gauge_add("backend.requests.active", -1);
 
     return 0;
 }
@@ -158,6 +168,8 @@ struct be_req *be_req_create(TALLOC_CTX *mem_ctx,
     be_req->domain = be_ctx->domain;
     be_req->fn = fn;
     be_req->pvt = pvt_fn_data;
+    gettimeofday(&be_req->start, NULL);
+    sss_stats_gauge_add("backend.requests.active", 1);
 
     /* Add this request to active request list and make sure it is
      * removed on termination. */
@@ -198,6 +210,15 @@ void be_req_terminate(struct be_req *be_req,
                       int dp_err_type, int errnum, const char *errstr)
 {
     if (be_req->fn == NULL) return;
+
+    sss_stats_record_since("backend.request", &be_req->start);
+    if (dp_err_type == DP_ERR_OFFLINE) {
+        sss_stats_count("backend.request.offline", 1);
+    } else if (dp_err_type != DP_ERR_OK) {
+        sss_stats_count("backend.request.failed", 1);
+        debug_ring_dump("back end request failed");
+    }
+
     be_req->fn(be_req, dp_err_type, errnum, errstr);
 }
 
@@ -711,6 +732,62 @@ immediate:
     return EOK;
 }
 
+static void be_invalidate_responder(struct be_client *becli,
+                                    const char *domain)
+{
+    DBusConnection *dbus_conn;
+    DBusMessage *msg;
+    dbus_bool_t dbret;
+
+    if (becli == NULL || becli->conn == NULL) {
+        return;
+    }
+
+    dbus_conn = sbus_get_connection(becli->conn);
+    if (dbus_conn == NULL) {
+        return;
+    }
+
+    msg = dbus_message_new_method_call(NULL,
+                                       DP_PATH,
+                                       DATA_PROVIDER_REV_IFACE,
+                                       DATA_PROVIDER_REV_IFACE_INVALIDATECACHE);
+    if (msg == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory?!\n");
+        return;
+    }
+
+    dbret = dbus_message_append_args(msg,
+                                     DBUS_TYPE_STRING, &domain,
+                                     DBUS_TYPE_INVALID);
+    if (!dbret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory?!\n");
+        dbus_message_unref(msg);
+        return;
+    }
+
+    /* The message is queued before the reply to the account request, so
+     * the responder drops its in-memory copies before it reads the updated
+     * entry from the cache. */
+    dbus_message_set_no_reply(msg, TRUE);
+    if (!dbus_connection_send(dbus_conn, msg, NULL)) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to send cache invalidation to the responder\n");
+    }
+
+    dbus_message_unref(msg);
+}
+
+static void be_invalidate_nss(struct be_ctx *be_ctx)
+{
+    struct be_client *iter;
+
+    be_invalidate_responder(be_ctx->nss_cli, be_ctx->domain->name);
+    for (iter = be_ctx->nss_workers; iter != NULL; iter = iter->next) {
+        be_invalidate_responder(iter, be_ctx->domain->name);
+    }
+}
+
 static void acctinfo_callback(struct be_req *req,
                               int dp_err_type,
                               int errnum,
@@ -721,6 +798,12 @@ static void acctinfo_callback(struct be_req *req,
     dbus_uint32_t err_min = 0;
     const char *err_msg = NULL;
 
+    if (dp_err_type == DP_ERR_OK) {
+        be_invalidate_nss(req->be_ctx);
+        be_invalidate_responder(req->be_ctx->pam_cli,
+                                req->be_ctx->domain->name);
+    }
+
     dbus_req = (struct sbus_request *)req->pvt;
 
     if (dbus_req) {
@@ -968,6 +1051,41 @@ split_name_extended(TALLOC_CTX *mem_ctx,
     return EOK;
 }
 
+static errno_t be_acct_req_set_filter(struct be_acct_req *req,
+                                      const char *filter)
+{
+    errno_t ret = EOK;
+
+    if (strncmp(filter, "name=", 5) == 0) {
+        req->filter_type = BE_FILTER_NAME;
+        ret = split_name_extended(req, &filter[5],
+                                  &req->filter_value,
+                                  &req->extra_value);
+    } else if (strncmp(filter, "idnumber=", 9) == 0) {
+        req->filter_type = BE_FILTER_IDNUM;
+        ret = split_name_extended(req, &filter[9],
+                                  &req->filter_value,
+                                  &req->extra_value);
+    } else if (strncmp(filter, DP_SEC_ID"=", DP_SEC_ID_LEN + 1) == 0) {
+        req->filter_type = BE_FILTER_SECID;
+        ret = split_name_extended(req, &filter[DP_SEC_ID_LEN + 1],
+                                  &req->filter_value,
+                                  &req->extra_value);
+    } else if (strcmp(filter, ENUM_INDICATOR) == 0) {
+        req->filter_type = BE_FILTER_ENUM;
+        req->filter_value = NULL;
+        req->extra_value = NULL;
+    } else {
+        return EINVAL;
+    }
+
+    if (ret != EOK) {
+        return EINVAL;
+    }
+
+    return EOK;
+}
+
 static void
 be_get_account_info_done(struct be_req *be_req,
                          int dp_err, int dp_ret,
@@ -1135,121 +1253,1056 @@ static int be_get_account_info(struct sbus_request *dbus_req, void *user_data)
          */
     }
 
-    be_req = be_req_create(becli, becli, becli->bectx,
-                           acctinfo_callback, dbus_req);
-    if (!be_req) {
+    be_req = be_req_create(becli, becli, becli->bectx,
+                           acctinfo_callback, dbus_req);
+    if (!be_req) {
+        err_maj = DP_ERR_FATAL;
+        err_min = ENOMEM;
+        err_msg = "Out of memory";
+        goto done;
+    }
+
+    ret = be_req_set_domain(be_req, domain);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set request domain [%d]: %s\n",
+                                    ret, sss_strerror(ret));
+        err_maj = DP_ERR_FATAL;
+        err_min = ret;
+        err_msg = sss_strerror(ret);
+        goto done;
+    }
+
+    req = talloc_zero(be_req, struct be_acct_req);
+    if (!req) {
+        err_maj = DP_ERR_FATAL;
+        err_min = ENOMEM;
+        err_msg = "Out of memory";
+        goto done;
+    }
+    req->entry_type = type;
+    req->attr_type = (int)attr_type;
+    req->domain = talloc_strdup(req, domain);
+    if (!req->domain) {
+        err_maj = DP_ERR_FATAL;
+        err_min = ENOMEM;
+        err_msg = "Out of memory";
+        goto done;
+    }
+
+    if ((attr_type != BE_ATTR_CORE) &&
+        (attr_type != BE_ATTR_MEM) &&
+        (attr_type != BE_ATTR_ALL)) {
+        /* Unrecognized attr type */
+        err_maj = DP_ERR_FATAL;
+        err_min = EINVAL;
+        err_msg = "Invalid Attrs Parameter";
+        goto done;
+    }
+
+    if (filter) {
+        ret = be_acct_req_set_filter(req, filter);
+        if (ret != EOK) {
+            err_maj = DP_ERR_FATAL;
+            err_min = EINVAL;
+            err_msg = "Invalid Filter";
+            goto done;
+        }
+
+    } else {
+        err_maj = DP_ERR_FATAL;
+        err_min = EINVAL;
+        err_msg = "Missing Filter Parameter";
+        goto done;
+    }
+
+    ret = be_file_account_request(be_req, req);
+    if (ret != EOK) {
+        err_maj = DP_ERR_FATAL;
+        err_min = ret;
+        err_msg = "Cannot file account request";
+        goto done;
+    }
+
+    return EOK;
+
+done:
+    if (be_req) {
+        talloc_free(be_req);
+    }
+
+    if (dbus_req) {
+        ret = sbus_request_return_and_finish(dbus_req,
+                                             DBUS_TYPE_UINT16, &err_maj,
+                                             DBUS_TYPE_UINT32, &err_min,
+                                             DBUS_TYPE_STRING, &err_msg,
+                                             DBUS_TYPE_INVALID);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        DEBUG(SSSDBG_CONF_SETTINGS, "Request processed. Returned %d,%d,%s\n",
+                  err_maj, err_min, err_msg);
+    }
+
+    return EOK;
+}
+
+/* The snapshot of the cache is rewritten BE_SNAPSHOT_DELAY seconds after
+ * the back end committed a change, a burst of changes is written at most
+ * cache_snapshot_interval seconds after it started. The periodic task
+ * picks up the changes of the other processes. Writing the snapshot reads
+ * the whole cache, so the back end spends at most a tenth of its time on
+ * it. */
+#define BE_SNAPSHOT_DELAY 2
+
+struct be_snapshot_ctx {
+    struct be_ctx *be_ctx;
+    int interval;
+    time_t next_allowed;
+
+    /* rewrite scheduled after a change */
+    struct tevent_timer *timer;
+    time_t first_change;
+    time_t when;
+};
+
+static errno_t be_snapshot_write(struct be_snapshot_ctx *snap_ctx)
+{
+    struct timeval start;
+    struct timeval end;
+    uint64_t usec;
+    bool written;
+    errno_t ret;
+
+    if (time(NULL) < snap_ctx->next_allowed) {
+        return EAGAIN;
+    }
+
+    gettimeofday(&start, NULL);
+
+    ret = sysdb_snapshot_update(snap_ctx->be_ctx->domain->sysdb, &written);
+    if (ret == EAGAIN) {
+        /* the cache is being written */
+        return EAGAIN;
+    } else if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to write cache snapshot [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    if (written) {
+        gettimeofday(&end, NULL);
+        usec = (end.tv_sec - start.tv_sec) * 1000000LL
+               + (end.tv_usec - start.tv_usec);
+        sss_stats_record("be.snapshot.write", usec);
+
+        snap_ctx->next_allowed = end.tv_sec + (usec * 10) / 1000000;
+    }
+
+    return EOK;
+}
+
+static void be_snapshot_changed(void *pvt);
+
+static void be_snapshot_timer(struct tevent_context *ev,
+                              struct tevent_timer *te,
+                              struct timeval tv, void *pvt)
+{
+    struct be_snapshot_ctx *snap_ctx;
+    errno_t ret;
+
+    snap_ctx = talloc_get_type(pvt, struct be_snapshot_ctx);
+    snap_ctx->timer = NULL;
+
+    ret = be_snapshot_write(snap_ctx);
+    if (ret == EAGAIN) {
+        be_snapshot_changed(snap_ctx);
+    }
+}
+
+static void be_snapshot_changed(void *pvt)
+{
+    struct be_snapshot_ctx *snap_ctx;
+    time_t now;
+    time_t when;
+
+    snap_ctx = talloc_get_type(pvt, struct be_snapshot_ctx);
+    now = time(NULL);
+
+    if (snap_ctx->timer == NULL) {
+        snap_ctx->first_change = now;
+    }
+
+    /* wait for the changes to settle, but not for ever */
+    when = now + BE_SNAPSHOT_DELAY;
+    if (when > snap_ctx->first_change + snap_ctx->interval) {
+        when = snap_ctx->first_change + snap_ctx->interval;
+    }
+    if (when < snap_ctx->next_allowed) {
+        when = snap_ctx->next_allowed;
+    }
+
+    if (snap_ctx->timer != NULL) {
+        if (when == snap_ctx->when) {
+            return;
+        }
+        talloc_zfree(snap_ctx->timer);
+    }
+
+    snap_ctx->timer = tevent_add_timer(snap_ctx->be_ctx->ev, snap_ctx,
+                                       tevent_timeval_set(when, 0),
+                                       be_snapshot_timer, snap_ctx);
+    if (snap_ctx->timer == NULL) {
+        /* the periodic task writes it */
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to schedule cache snapshot\n");
+        return;
+    }
+    snap_ctx->when = when;
+}
+
+static errno_t be_snapshot_task(TALLOC_CTX *mem_ctx,
+                                struct tevent_context *ev,
+                                struct be_ctx *be_ctx,
+                                struct be_ptask *be_ptask,
+                                void *pvt)
+{
+    struct be_snapshot_ctx *snap_ctx;
+    errno_t ret;
+
+    snap_ctx = talloc_get_type(pvt, struct be_snapshot_ctx);
+
+    ret = be_snapshot_write(snap_ctx);
+    if (ret == EAGAIN) {
+        /* try again the next time */
+        return EOK;
+    }
+
+    return ret;
+}
+
+static int be_snapshot_ctx_destructor(struct be_snapshot_ctx *snap_ctx)
+{
+    sysdb_snapshot_set_changed_cb(snap_ctx->be_ctx->domain->sysdb,
+                                  NULL, NULL);
+    return 0;
+}
+
+static errno_t be_snapshot_init(struct be_ctx *ctx)
+{
+    struct be_snapshot_ctx *snap_ctx;
+    int interval;
+    errno_t ret;
+
+    ret = confdb_get_int(ctx->cdb, ctx->conf_path,
+                         CONFDB_DOMAIN_CACHE_SNAPSHOT_INTERVAL, 0, &interval);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read %s [%d]: %s\n",
+              CONFDB_DOMAIN_CACHE_SNAPSHOT_INTERVAL, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    if (interval <= 0) {
+        /* a snapshot of a previous run would never be updated */
+        ret = sysdb_snapshot_remove(ctx->domain->sysdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "Unable to remove cache snapshot [%d]: %s\n",
+                  ret, sss_strerror(ret));
+        }
+        return EOK;
+    }
+
+    snap_ctx = talloc_zero(ctx, struct be_snapshot_ctx);
+    if (snap_ctx == NULL) {
+        return ENOMEM;
+    }
+    snap_ctx->be_ctx = ctx;
+    snap_ctx->interval = interval;
+
+    ret = sysdb_snapshot_set_changed_cb(ctx->domain->sysdb,
+                                        be_snapshot_changed, snap_ctx);
+    if (ret != EOK) {
+        talloc_free(snap_ctx);
+        return ret;
+    }
+    talloc_set_destructor(snap_ctx, be_snapshot_ctx_destructor);
+
+    ret = be_ptask_create_sync(ctx, ctx, interval, interval, interval, 0,
+                               interval, BE_PTASK_OFFLINE_EXECUTE, 0,
+                               be_snapshot_task, snap_ctx, "Cache snapshot",
+                               NULL);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "be_ptask_create_sync failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return ret;
+    }
+
+    return EOK;
+}
+
+/* The fast path server accepts the getAccountInfo and pamHandler calls of
+ * the responders over the binary protocol from dp_fastpath.h. The requests go through the
+ * same queue as the ones received over D-Bus. */
+struct be_fastpath_srv {
+    struct be_ctx *be_ctx;
+    int fd;
+    struct tevent_fd *fde;
+};
+
+struct be_fastpath_client {
+    struct be_fastpath_srv *srv;
+    struct be_client *becli;
+    struct dp_fastpath_conn *conn;
+};
+
+struct be_fastpath_call {
+    struct be_fastpath_client *fcli;
+    uint32_t serial;
+};
+
+static void be_fastpath_reply(struct be_fastpath_client *fcli,
+                              uint32_t serial,
+                              uint16_t err_maj,
+                              uint32_t err_min,
+                              const char *err_msg,
+                              uint16_t flags)
+{
+    struct dp_fastpath_reply reply;
+    uint8_t *frame;
+    size_t len;
+    errno_t ret;
+
+    reply.err_maj = err_maj;
+    reply.err_min = err_min;
+    reply.err_msg = err_msg;
+    reply.flags = flags;
+
+    ret = dp_fastpath_encode_reply(fcli, serial, &reply, &frame, &len);
+    if (ret == EOK) {
+        ret = dp_fastpath_conn_send(fcli->conn, frame, len);
+    }
+    if (ret != EOK) {
+        /* the responder will time out the request */
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to send reply [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Request processed. Returned %d,%d,%s\n",
+          err_maj, err_min, err_msg);
+}
+
+static void be_fastpath_acctinfo_callback(struct be_req *req,
+                                          int dp_err_type,
+                                          int errnum,
+                                          const char *errstr)
+{
+    struct be_fastpath_call *call;
+    const char *err_msg;
+    uint16_t flags = 0;
+
+    if (dp_err_type == DP_ERR_OK) {
+        /* The D-Bus invalidation may overtake the reply, the requesting
+         * responder invalidates its copies itself as told by the flag. */
+        be_invalidate_nss(req->be_ctx);
+        be_invalidate_responder(req->be_ctx->pam_cli,
+                                req->be_ctx->domain->name);
+        flags |= DP_FASTPATH_REPLY_INVALIDATE;
+    }
+
+    call = talloc_get_type(req->pvt, struct be_fastpath_call);
+    if (call != NULL) {
+        err_msg = errstr;
+        if (err_msg == NULL) {
+            err_msg = dp_pam_err_to_string(req, dp_err_type, errnum);
+        }
+        if (err_msg == NULL) {
+            err_msg = "OOM";
+        }
+
+        be_fastpath_reply(call->fcli, call->serial, dp_err_type, errnum,
+                          err_msg, flags);
+    }
+
+    talloc_free(req);
+}
+
+static void be_fastpath_account_info(struct be_fastpath_client *fcli,
+                                     uint32_t serial,
+                                     const uint8_t *body,
+                                     size_t len)
+{
+    struct be_ctx *be_ctx = fcli->srv->be_ctx;
+    struct dp_fastpath_account_req fr;
+    struct be_fastpath_call *call;
+    struct be_acct_req *req;
+    struct be_req *be_req;
+    uint16_t err_maj;
+    uint32_t err_min;
+    const char *err_msg;
+    bool replied = false;
+    errno_t ret;
+
+    be_req = be_req_create(fcli->becli, fcli->becli, be_ctx,
+                           be_fastpath_acctinfo_callback, NULL);
+    if (be_req == NULL) {
+        err_maj = DP_ERR_FATAL;
+        err_min = ENOMEM;
+        err_msg = "Out of memory";
+        goto done;
+    }
+
+    req = talloc_zero(be_req, struct be_acct_req);
+    call = talloc_zero(be_req, struct be_fastpath_call);
+    if (req == NULL || call == NULL) {
+        err_maj = DP_ERR_FATAL;
+        err_min = ENOMEM;
+        err_msg = "Out of memory";
+        goto done;
+    }
+    call->fcli = fcli;
+    call->serial = serial;
+
+    ret = dp_fastpath_decode_account_req(req, body, len, &fr);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed request [%d]: %s\n",
+              ret, sss_strerror(ret));
+        err_maj = DP_ERR_FATAL;
+        err_min = EINVAL;
+        err_msg = "Malformed request";
+        goto done;
+    }
+
+    DEBUG(SSSDBG_FUNC_DATA, "Got fast path request for [%#x][%d][%s]\n",
+          fr.entry_type, fr.attr_type, fr.filter);
+
+    /* If we are offline and fast reply was requested
+     * return offline immediately
+     */
+    if ((fr.entry_type & BE_REQ_FAST) && be_ctx->offstat.offline) {
+        be_fastpath_reply(fcli, serial, DP_ERR_OFFLINE, EAGAIN,
+                          "Fast reply - offline", 0);
+        /* Continue processing in case we are going back online. */
+        talloc_zfree(call);
+        replied = true;
+    }
+    be_req->pvt = call;
+
+    ret = be_req_set_domain(be_req, fr.domain);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set request domain [%d]: %s\n",
+                                    ret, sss_strerror(ret));
+        err_maj = DP_ERR_FATAL;
+        err_min = ret;
+        err_msg = sss_strerror(ret);
+        goto done;
+    }
+
+    req->entry_type = fr.entry_type;
+    req->attr_type = (int)fr.attr_type;
+    req->domain = fr.domain;
+
+    if ((fr.attr_type != BE_ATTR_CORE) &&
+        (fr.attr_type != BE_ATTR_MEM) &&
+        (fr.attr_type != BE_ATTR_ALL)) {
+        /* Unrecognized attr type */
+        err_maj = DP_ERR_FATAL;
+        err_min = EINVAL;
+        err_msg = "Invalid Attrs Parameter";
+        goto done;
+    }
+
+    ret = be_acct_req_set_filter(req, fr.filter);
+    if (ret != EOK) {
+        err_maj = DP_ERR_FATAL;
+        err_min = EINVAL;
+        err_msg = "Invalid Filter";
+        goto done;
+    }
+
+    ret = be_file_account_request(be_req, req);
+    if (ret != EOK) {
+        err_maj = DP_ERR_FATAL;
+        err_min = ret;
+        err_msg = "Cannot file account request";
+        goto done;
+    }
+
+    return;
+
+done:
+    /* no reply if the offline one was sent already */
+    if (!replied) {
+        be_fastpath_reply(fcli, serial, err_maj, err_min, err_msg, 0);
+    }
+    talloc_free(be_req);
+}
+
+static void be_fastpath_pam_handler(struct be_fastpath_client *fcli,
+                                    uint32_t serial,
+                                    const uint8_t *body,
+                                    size_t len);
+
+static void be_fastpath_frame(struct dp_fastpath_conn *conn,
+                              struct dp_fastpath_hdr *hdr,
+                              const uint8_t *body,
+                              void *pvt)
+{
+    struct be_fastpath_client *fcli;
+
+    fcli = talloc_get_type(pvt, struct be_fastpath_client);
+
+    switch (hdr->method) {
+    case DP_FASTPATH_GET_ACCOUNT_INFO:
+        be_fastpath_account_info(fcli, hdr->serial, body, hdr->len);
+        break;
+    case DP_FASTPATH_PAM_HANDLER:
+        be_fastpath_pam_handler(fcli, hdr->serial, body, hdr->len);
+        break;
+    default:
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unknown method %"PRIu16"\n", hdr->method);
+        be_fastpath_reply(fcli, hdr->serial, DP_ERR_FATAL, ENOTSUP,
+                          "Unknown method", 0);
+        break;
+    }
+}
+
+static void be_fastpath_close(struct dp_fastpath_conn *conn, void *pvt)
+{
+    struct be_fastpath_client *fcli;
+
+    fcli = talloc_get_type(pvt, struct be_fastpath_client);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Fast path client disconnected\n");
+
+    /* frees the running requests of the client as well */
+    talloc_free(fcli);
+}
+
+static void be_fastpath_accept(struct tevent_context *ev,
+                               struct tevent_fd *fde,
+                               uint16_t flags, void *ptr)
+{
+    struct be_fastpath_srv *srv;
+    struct be_fastpath_client *fcli;
+    int fd;
+    errno_t ret;
+
+    srv = talloc_get_type(ptr, struct be_fastpath_srv);
+
+    fd = accept4(srv->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "accept failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return;
+    }
+
+#ifdef HAVE_UCRED
+    struct ucred cred;
+    socklen_t cred_len = sizeof(cred);
+
+    /* the same peers as the D-Bus server allows */
+    ret = getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len);
+    if (ret != 0 || cred_len != sizeof(cred)
+            || (cred.uid != 0 && cred.uid != srv->be_ctx->uid)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Rejecting fast path client\n");
+        close(fd);
+        return;
+    }
+#endif
+
+    fcli = talloc_zero(srv, struct be_fastpath_client);
+    if (fcli == NULL) {
+        close(fd);
+        return;
+    }
+    fcli->srv = srv;
+
+    fcli->becli = talloc_zero(fcli, struct be_client);
+    if (fcli->becli == NULL) {
+        talloc_free(fcli);
+        close(fd);
+        return;
+    }
+    fcli->becli->bectx = srv->be_ctx;
+    fcli->becli->initialized = true;
+
+    fcli->conn = dp_fastpath_conn_create(fcli, ev, fd, be_fastpath_frame,
+                                         be_fastpath_close, fcli);
+    if (fcli->conn == NULL) {
+        talloc_free(fcli);
+        close(fd);
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Fast path client connected\n");
+}
+
+static int be_fastpath_srv_destructor(struct be_fastpath_srv *srv)
+{
+    talloc_zfree(srv->fde);
+    if (srv->fd != -1) {
+        close(srv->fd);
+    }
+
+    return 0;
+}
+
+static errno_t be_fastpath_srv_init(struct be_ctx *ctx)
+{
+    struct be_fastpath_srv *srv;
+    struct sockaddr_un addr;
+    bool enabled;
+    mode_t orig_umask;
+    char *path;
+    errno_t ret;
+
+    ret = confdb_get_bool(ctx->cdb, ctx->conf_path,
+                          CONFDB_DOMAIN_DP_FAST_PATH, false, &enabled);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to read %s [%d]: %s\n",
+              CONFDB_DOMAIN_DP_FAST_PATH, ret, sss_strerror(ret));
+        return ret;
+    }
+
+    ret = dp_fastpath_get_address(ctx, ctx->domain->name, &path);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    /* remove the socket of a previous run so that the responders do not
+     * try to use it */
+    errno = 0;
+    if (unlink(path) != 0 && errno != ENOENT) {
+        ret = errno;
+        DEBUG(SSSDBG_MINOR_FAILURE, "Unable to remove %s [%d]: %s\n",
+              path, ret, sss_strerror(ret));
+    }
+
+    if (!enabled) {
+        talloc_free(path);
+        return EOK;
+    }
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Socket path %s is too long\n", path);
+        talloc_free(path);
+        return EINVAL;
+    }
+
+    srv = talloc_zero(ctx, struct be_fastpath_srv);
+    if (srv == NULL) {
+        talloc_free(path);
+        return ENOMEM;
+    }
+    srv->be_ctx = ctx;
+    talloc_set_destructor(srv, be_fastpath_srv_destructor);
+
+    srv->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (srv->fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    orig_umask = umask(0177);
+    ret = bind(srv->fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (ret != 0) {
+        ret = errno;
+    }
+    umask(orig_umask);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (listen(srv->fd, 10) != 0) {
+        ret = errno;
+        goto done;
+    }
+
+    srv->fde = tevent_add_fd(ctx->ev, srv, srv->fd, TEVENT_FD_READ,
+                             be_fastpath_accept, srv);
+    if (srv->fde == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Listening for fast path requests on %s\n",
+          path);
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set up fast path socket %s "
+              "[%d]: %s\n", path, ret, sss_strerror(ret));
+        talloc_free(srv);
+    }
+    talloc_free(path);
+    return ret;
+}
+
+/* Number of requests of a getAccountInfoMulti call which are processed at
+ * the same time */
+#define BE_ACCT_MULTI_WINDOW 16
+
+struct be_acct_multi_ctx {
+    struct be_client *becli;
+    struct sbus_request *dbus_req;
+
+    uint32_t type;
+    uint32_t attr_type;
+    const char *domain;
+    char **filters;
+    int num_filters;
+
+    int next;
+    int running;
+    bool updated;
+
+    /* status of the request of each filter */
+    dbus_uint16_t *key_maj;
+    dbus_uint32_t *key_min;
+
+    dbus_uint16_t err_maj;
+    dbus_uint32_t err_min;
+    const char *err_msg;
+};
+
+struct be_acct_multi_item {
+    struct be_acct_multi_ctx *ctx;
+    int idx;
+};
+
+static void be_acct_multi_step(struct be_acct_multi_ctx *ctx);
+static void be_acct_multi_done(struct tevent_req *subreq);
+
+static void be_acct_multi_set_error(struct be_acct_multi_ctx *ctx, int idx,
+                                    int err_maj, int err_min,
+                                    const char *err_msg)
+{
+    ctx->key_maj[idx] = err_maj;
+    ctx->key_min[idx] = err_min;
+
+    /* the first failure is reported as the status of the whole call */
+    if (ctx->err_maj != DP_ERR_OK) {
+        return;
+    }
+
+    ctx->err_maj = err_maj;
+    ctx->err_min = err_min;
+    ctx->err_msg = talloc_strdup(ctx, err_msg ? err_msg : "");
+    if (ctx->err_msg == NULL) {
+        ctx->err_msg = "OOM";
+    }
+}
+
+static void be_acct_multi_finish(struct be_acct_multi_ctx *ctx)
+{
+    struct be_ctx *be_ctx = ctx->becli->bectx;
+    int i;
+
+    /* the filters which could not be started */
+    for (i = ctx->next; i < ctx->num_filters; i++) {
+        be_acct_multi_set_error(ctx, i, DP_ERR_FATAL, ENOMEM,
+                                "Out of memory");
+    }
+
+    /* one invalidation for the whole batch */
+    if (ctx->updated) {
+        be_invalidate_nss(be_ctx);
+        be_invalidate_responder(be_ctx->pam_cli, be_ctx->domain->name);
+    }
+
+    if (ctx->dbus_req != NULL) {
+        sbus_request_return_and_finish(ctx->dbus_req,
+                                       DBUS_TYPE_UINT16, &ctx->err_maj,
+                                       DBUS_TYPE_UINT32, &ctx->err_min,
+                                       DBUS_TYPE_STRING, &ctx->err_msg,
+                                       DBUS_TYPE_ARRAY, DBUS_TYPE_UINT16,
+                                       &ctx->key_maj, ctx->num_filters,
+                                       DBUS_TYPE_ARRAY, DBUS_TYPE_UINT32,
+                                       &ctx->key_min, ctx->num_filters,
+                                       DBUS_TYPE_INVALID);
+
+        DEBUG(SSSDBG_CONF_SETTINGS, "Request processed. Returned %d,%d,%s\n",
+              ctx->err_maj, ctx->err_min, ctx->err_msg);
+    }
+
+    talloc_free(ctx);
+}
+
+static void be_acct_multi_step(struct be_acct_multi_ctx *ctx)
+{
+    struct be_ctx *be_ctx = ctx->becli->bectx;
+    struct be_acct_multi_item *item;
+    struct be_acct_req *ar;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    while (ctx->running < BE_ACCT_MULTI_WINDOW
+            && ctx->next < ctx->num_filters) {
+        ar = talloc_zero(ctx, struct be_acct_req);
+        if (ar == NULL) {
+            break;
+        }
+
+        ar->entry_type = ctx->type;
+        ar->attr_type = (int)ctx->attr_type;
+        ar->domain = talloc_strdup(ar, ctx->domain);
+        if (ar->domain == NULL) {
+            talloc_free(ar);
+            break;
+        }
+
+        ret = be_acct_req_set_filter(ar, ctx->filters[ctx->next]);
+        if (ret != EOK || ar->filter_type == BE_FILTER_ENUM) {
+            talloc_free(ar);
+            be_acct_multi_set_error(ctx, ctx->next, DP_ERR_FATAL, EINVAL,
+                                    "Invalid Filter");
+            ctx->next++;
+            continue;
+        }
+
+        subreq = be_get_account_info_send(ctx, be_ctx->ev, ctx->becli,
+                                          be_ctx, ar);
+        if (subreq == NULL) {
+            talloc_free(ar);
+            break;
+        }
+        talloc_steal(subreq, ar);
+
+        item = talloc_zero(subreq, struct be_acct_multi_item);
+        if (item == NULL) {
+            talloc_free(subreq);
+            break;
+        }
+        item->ctx = ctx;
+        item->idx = ctx->next;
+        ctx->next++;
+
+        tevent_req_set_callback(subreq, be_acct_multi_done, item);
+        ctx->running++;
+    }
+
+    if (ctx->running == 0) {
+        be_acct_multi_finish(ctx);
+    }
+}
+
+static void be_acct_multi_done(struct tevent_req *subreq)
+{
+    struct be_acct_multi_item *item;
+    struct be_acct_multi_ctx *ctx;
+    const char *err_msg = NULL;
+    int err_maj;
+    int err_min;
+    int idx;
+    errno_t ret;
+
+    item = tevent_req_callback_data(subreq, struct be_acct_multi_item);
+    ctx = item->ctx;
+    idx = item->idx;
+
+    ret = be_get_account_info_recv(subreq, ctx, &err_maj, &err_min, &err_msg);
+    talloc_zfree(subreq);
+    ctx->running--;
+    if (ret != EOK) {
+        be_acct_multi_set_error(ctx, idx, DP_ERR_FATAL, ret,
+                                sss_strerror(ret));
+    } else if (err_maj == DP_ERR_OK) {
+        ctx->updated = true;
+    } else {
+        be_acct_multi_set_error(ctx, idx, err_maj, err_min, err_msg);
+    }
+
+    be_acct_multi_step(ctx);
+}
+
+/* Each filter is processed like a getAccountInfo request of its own. The
+ * requests share the connection of the provider and only one reply is sent
+ * once the last of them finished. */
+static int be_get_account_info_multi(struct sbus_request *dbus_req,
+                                     void *user_data)
+{
+    struct be_acct_multi_ctx *ctx;
+    struct be_client *becli;
+    uint32_t type;
+    uint32_t attr_type;
+    char **filters;
+    int num_filters;
+    char *domain;
+    int ret;
+    int i;
+    dbus_uint16_t err_maj;
+    dbus_uint32_t err_min;
+    const char *err_msg;
+
+    becli = talloc_get_type(user_data, struct be_client);
+    if (!becli) return EINVAL;
+
+    if (!sbus_request_parse_or_finish(dbus_req,
+                                      DBUS_TYPE_UINT32, &type,
+                                      DBUS_TYPE_UINT32, &attr_type,
+                                      DBUS_TYPE_ARRAY, DBUS_TYPE_STRING,
+                                      &filters, &num_filters,
+                                      DBUS_TYPE_STRING, &domain,
+                                      DBUS_TYPE_INVALID))
+        return EOK; /* handled */
+
+    DEBUG(SSSDBG_FUNC_DATA, "Got request for [%#x][%d] with %d filters\n",
+          type, attr_type, num_filters);
+
+    switch (type & 0xFF) {
+    case BE_REQ_USER:
+    case BE_REQ_GROUP:
+    case BE_REQ_BY_SECID:
+    case BE_REQ_USER_AND_GROUP:
+    case BE_REQ_BY_UUID:
+        break;
+    default:
+        /* initgroups needs the NSS check of the single request */
         err_maj = DP_ERR_FATAL;
-        err_min = ENOMEM;
-        err_msg = "Out of memory";
+        err_min = EINVAL;
+        err_msg = "Invalid Request Type";
         goto done;
     }
 
-    ret = be_req_set_domain(be_req, domain);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set request domain [%d]: %s\n",
-                                    ret, sss_strerror(ret));
+    if ((attr_type != BE_ATTR_CORE) &&
+        (attr_type != BE_ATTR_MEM) &&
+        (attr_type != BE_ATTR_ALL)) {
         err_maj = DP_ERR_FATAL;
-        err_min = ret;
-        err_msg = sss_strerror(ret);
+        err_min = EINVAL;
+        err_msg = "Invalid Attrs Parameter";
         goto done;
     }
 
-    req = talloc_zero(be_req, struct be_acct_req);
-    if (!req) {
-        err_maj = DP_ERR_FATAL;
-        err_min = ENOMEM;
-        err_msg = "Out of memory";
+    if (num_filters == 0) {
+        err_maj = DP_ERR_OK;
+        err_min = EOK;
+        err_msg = "Success";
         goto done;
     }
-    req->entry_type = type;
-    req->attr_type = (int)attr_type;
-    req->domain = talloc_strdup(req, domain);
-    if (!req->domain) {
+
+    ctx = talloc_zero(becli, struct be_acct_multi_ctx);
+    if (ctx == NULL) {
         err_maj = DP_ERR_FATAL;
         err_min = ENOMEM;
         err_msg = "Out of memory";
         goto done;
     }
 
-    if ((attr_type != BE_ATTR_CORE) &&
-        (attr_type != BE_ATTR_MEM) &&
-        (attr_type != BE_ATTR_ALL)) {
-        /* Unrecognized attr type */
+    ctx->becli = becli;
+    ctx->dbus_req = dbus_req;
+    ctx->type = type;
+    ctx->attr_type = attr_type;
+    ctx->err_maj = DP_ERR_OK;
+    ctx->err_min = EOK;
+    ctx->err_msg = "Success";
+    ctx->domain = talloc_strdup(ctx, domain);
+    ctx->num_filters = num_filters;
+    /* the arguments go away with dbus_req */
+    ctx->filters = talloc_array(ctx, char *, num_filters);
+    /* zeroed, DP_ERR_OK and EOK */
+    ctx->key_maj = talloc_zero_array(ctx, dbus_uint16_t, num_filters);
+    ctx->key_min = talloc_zero_array(ctx, dbus_uint32_t, num_filters);
+    if (ctx->domain == NULL || ctx->filters == NULL
+            || ctx->key_maj == NULL || ctx->key_min == NULL) {
+        talloc_free(ctx);
         err_maj = DP_ERR_FATAL;
-        err_min = EINVAL;
-        err_msg = "Invalid Attrs Parameter";
+        err_min = ENOMEM;
+        err_msg = "Out of memory";
         goto done;
     }
 
-    if (filter) {
-        ret = EOK;
-        if (strncmp(filter, "name=", 5) == 0) {
-            req->filter_type = BE_FILTER_NAME;
-            ret = split_name_extended(req, &filter[5],
-                                      &req->filter_value,
-                                      &req->extra_value);
-        } else if (strncmp(filter, "idnumber=", 9) == 0) {
-            req->filter_type = BE_FILTER_IDNUM;
-            ret = split_name_extended(req, &filter[9],
-                                      &req->filter_value,
-                                      &req->extra_value);
-        } else if (strncmp(filter, DP_SEC_ID"=", DP_SEC_ID_LEN + 1) == 0) {
-            req->filter_type = BE_FILTER_SECID;
-            ret = split_name_extended(req, &filter[DP_SEC_ID_LEN + 1],
-                                      &req->filter_value,
-                                      &req->extra_value);
-        } else if (strcmp(filter, ENUM_INDICATOR) == 0) {
-            req->filter_type = BE_FILTER_ENUM;
-            req->filter_value = NULL;
-            req->extra_value = NULL;
-        } else {
+    for (i = 0; i < num_filters; i++) {
+        ctx->filters[i] = talloc_strdup(ctx->filters, filters[i]);
+        if (ctx->filters[i] == NULL) {
+            talloc_free(ctx);
             err_maj = DP_ERR_FATAL;
-            err_min = EINVAL;
-            err_msg = "Invalid Filter";
+            err_min = ENOMEM;
+            err_msg = "Out of memory";
             goto done;
         }
+    }
+
+    /* If we are offline and fast reply was requested
+     * return offline immediately and continue in the background */
+    if ((type & BE_REQ_FAST) && becli->bectx->offstat.offline) {
+        err_maj = DP_ERR_OFFLINE;
+        err_min = EAGAIN;
+        err_msg = "Fast reply - offline";
 
+        ret = sbus_request_return_and_finish(dbus_req,
+                                             DBUS_TYPE_UINT16, &err_maj,
+                                             DBUS_TYPE_UINT32, &err_min,
+                                             DBUS_TYPE_STRING, &err_msg,
+                                             DBUS_TYPE_INVALID);
         if (ret != EOK) {
-            err_maj = DP_ERR_FATAL;
-            err_min = EINVAL;
-            err_msg = "Invalid Filter";
-            goto done;
+            talloc_free(ctx);
+            return ret;
         }
 
-    } else {
-        err_maj = DP_ERR_FATAL;
-        err_min = EINVAL;
-        err_msg = "Missing Filter Parameter";
-        goto done;
+        DEBUG(SSSDBG_CONF_SETTINGS, "Request processed. Returned %d,%d,%s\n",
+              err_maj, err_min, err_msg);
+        ctx->dbus_req = NULL;
     }
 
-    ret = be_file_account_request(be_req, req);
+    be_acct_multi_step(ctx);
+    return EOK;
+
+done:
+    ret = sbus_request_return_and_finish(dbus_req,
+                                         DBUS_TYPE_UINT16, &err_maj,
+                                         DBUS_TYPE_UINT32, &err_min,
+                                         DBUS_TYPE_STRING, &err_msg,
+                                         DBUS_TYPE_INVALID);
     if (ret != EOK) {
-        err_maj = DP_ERR_FATAL;
-        err_min = ret;
-        err_msg = "Cannot file account request";
-        goto done;
+        return ret;
     }
 
+    DEBUG(SSSDBG_CONF_SETTINGS, "Request processed. Returned %d,%d,%s\n",
+          err_maj, err_min, err_msg);
     return EOK;
+}
 
-done:
-    if (be_req) {
-        talloc_free(be_req);
+/* A successful access check continues with the SELinux provider. Returns
+ * EOK if the request was passed on to it and ENOENT if the result of the
+ * request is final. */
+static errno_t be_pam_selinux_phase(struct be_req *req,
+                                    struct pam_data *pd,
+                                    int dp_err_type)
+{
+    struct be_ctx *be_ctx = req->becli->bectx;
+    errno_t ret;
+
+    if (pd->cmd != SSS_PAM_ACCT_MGMT ||
+        pd->pam_status != PAM_SUCCESS ||
+        req->phase != REQ_PHASE_ACCESS ||
+        dp_err_type != DP_ERR_OK) {
+        return ENOENT;
     }
 
-    if (dbus_req) {
-        ret = sbus_request_return_and_finish(dbus_req,
-                                             DBUS_TYPE_UINT16, &err_maj,
-                                             DBUS_TYPE_UINT32, &err_min,
-                                             DBUS_TYPE_STRING, &err_msg,
-                                             DBUS_TYPE_INVALID);
-        if (ret != EOK) {
-            return ret;
-        }
+    if (!be_ctx->bet_info[BET_SELINUX].bet_ops) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "SELinux provider doesn't exist, "
+               "not sending the request to it.\n");
+        return ENOENT;
+    }
 
-        DEBUG(SSSDBG_CONF_SETTINGS, "Request processed. Returned %d,%d,%s\n",
-                  err_maj, err_min, err_msg);
+    req->phase = REQ_PHASE_SELINUX;
+
+    /* Now is the time to call SELinux provider */
+    ret = be_file_request(be_ctx->bet_info[BET_SELINUX].pvt_bet_data,
+                          req,
+                          be_ctx->bet_info[BET_SELINUX].bet_ops->handler);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "be_file_request failed.\n");
+        return ret;
     }
 
     return EOK;
@@ -1260,7 +2313,6 @@ static void be_pam_handler_callback(struct be_req *req,
                                     int errnum,
                                     const char *errstr)
 {
-    struct be_client *becli = req->becli;
     struct sbus_request *dbus_req;
     struct pam_data *pd;
     DBusMessage *reply;
@@ -1273,27 +2325,11 @@ static void be_pam_handler_callback(struct be_req *req,
 
     pd = talloc_get_type(be_req_get_data(req), struct pam_data);
 
-    if (pd->cmd == SSS_PAM_ACCT_MGMT &&
-        pd->pam_status == PAM_SUCCESS &&
-        req->phase == REQ_PHASE_ACCESS &&
-        dp_err_type == DP_ERR_OK) {
-        if (!becli->bectx->bet_info[BET_SELINUX].bet_ops) {
-            DEBUG(SSSDBG_TRACE_FUNC,
-                  "SELinux provider doesn't exist, "
-                   "not sending the request to it.\n");
-        } else {
-            req->phase = REQ_PHASE_SELINUX;
-
-            /* Now is the time to call SELinux provider */
-            ret = be_file_request(becli->bectx->bet_info[BET_SELINUX].pvt_bet_data,
-                                  req,
-                                  becli->bectx->bet_info[BET_SELINUX].bet_ops->handler);
-            if (ret != EOK) {
-                DEBUG(SSSDBG_OP_FAILURE, "be_file_request failed.\n");
-                goto done;
-            }
-            return;
-        }
+    ret = be_pam_selinux_phase(req, pd, dp_err_type);
+    if (ret == EOK) {
+        return;
+    } else if (ret != ENOENT) {
+        goto done;
     }
 
     DEBUG(SSSDBG_CONF_SETTINGS,
@@ -1323,41 +2359,19 @@ done:
     talloc_free(req);
 }
 
-static int be_pam_handler(struct sbus_request *dbus_req, void *user_data)
+/* Files the request with the target of the PAM command. Returns false if
+ * it was not filed, the result to send back is in pd->pam_status then. */
+static bool be_pam_file_request(struct be_req *be_req, struct pam_data *pd)
 {
-    DBusError dbus_error;
-    DBusMessage *reply;
-    struct be_client *becli;
-    dbus_bool_t ret;
-    struct pam_data *pd = NULL;
-    struct be_req *be_req = NULL;
+    struct be_ctx *be_ctx = be_req->becli->bectx;
     enum bet_type target = BET_NULL;
-
-    becli = talloc_get_type(user_data, struct be_client);
-    if (!becli) return EINVAL;
-
-    be_req = be_req_create(becli, becli, becli->bectx,
-                           be_pam_handler_callback, dbus_req);
-    if (!be_req) {
-        DEBUG(SSSDBG_TRACE_LIBS, "talloc_zero failed.\n");
-        return ENOMEM;
-    }
-
-    dbus_error_init(&dbus_error);
-
-    ret = dp_unpack_pam_request(dbus_req->message, be_req, &pd, &dbus_error);
-    if (!ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to parse message!\n");
-        talloc_free(be_req);
-        return EIO;
-    }
+    errno_t ret;
 
     pd->pam_status = PAM_SYSTEM_ERR;
     if (pd->domain == NULL) {
-        pd->domain = talloc_strdup(pd, becli->bectx->domain->name);
+        pd->domain = talloc_strdup(pd, be_ctx->domain->name);
         if (pd->domain == NULL) {
-            talloc_free(be_req);
-            return ENOMEM;
+            return false;
         }
     }
 
@@ -1365,8 +2379,7 @@ static int be_pam_handler(struct sbus_request *dbus_req, void *user_data)
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Unable to set request domain [%d]: %s\n",
                                     ret, sss_strerror(ret));
-        pd->pam_status = PAM_SYSTEM_ERR;
-        goto done;
+        return false;
     }
 
     DEBUG(SSSDBG_CONF_SETTINGS, "Got request with the following data\n");
@@ -1388,37 +2401,67 @@ static int be_pam_handler(struct sbus_request *dbus_req, void *user_data)
         case SSS_PAM_SETCRED:
         case SSS_PAM_CLOSE_SESSION:
             pd->pam_status = PAM_SUCCESS;
-            goto done;
-            break;
+            return false;
         default:
             DEBUG(SSSDBG_TRACE_LIBS,
                   "Unsupported PAM command [%d].\n", pd->cmd);
             pd->pam_status = PAM_MODULE_UNKNOWN;
-            goto done;
+            return false;
     }
 
     /* return PAM_MODULE_UNKNOWN if corresponding backend target is not
      * configured
      */
-    if (!becli->bectx->bet_info[target].bet_ops) {
+    if (!be_ctx->bet_info[target].bet_ops) {
         DEBUG(SSSDBG_TRACE_LIBS, "Undefined backend target.\n");
         pd->pam_status = PAM_MODULE_UNKNOWN;
-        goto done;
+        return false;
     }
 
     be_req->req_data = pd;
 
-    ret = be_file_request(becli->bectx->bet_info[target].pvt_bet_data,
+    ret = be_file_request(be_ctx->bet_info[target].pvt_bet_data,
                           be_req,
-                          becli->bectx->bet_info[target].bet_ops->handler);
+                          be_ctx->bet_info[target].bet_ops->handler);
     if (ret != EOK) {
         DEBUG(SSSDBG_TRACE_LIBS, "be_file_request failed.\n");
-        goto done;
+        return false;
     }
 
-    return EOK;
+    return true;
+}
 
-done:
+static int be_pam_handler(struct sbus_request *dbus_req, void *user_data)
+{
+    DBusError dbus_error;
+    DBusMessage *reply;
+    struct be_client *becli;
+    dbus_bool_t ret;
+    struct pam_data *pd = NULL;
+    struct be_req *be_req = NULL;
+
+    becli = talloc_get_type(user_data, struct be_client);
+    if (!becli) return EINVAL;
+
+    be_req = be_req_create(becli, becli, becli->bectx,
+                           be_pam_handler_callback, dbus_req);
+    if (!be_req) {
+        DEBUG(SSSDBG_TRACE_LIBS, "talloc_zero failed.\n");
+        return ENOMEM;
+    }
+
+    dbus_error_init(&dbus_error);
+
+    ret = dp_unpack_pam_request(dbus_req->message, be_req, &pd, &dbus_error);
+    if (!ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to parse message!\n");
+        talloc_free(be_req);
+        return EIO;
+    }
+
+    if (be_pam_file_request(be_req, pd)) {
+        return EOK;
+    }
 
     DEBUG(SSSDBG_CONF_SETTINGS, "Sending result [%d][%s]\n",
               pd->pam_status, pd->domain);
@@ -1447,6 +2490,118 @@ done:
     return EOK;
 }
 
+static void be_fastpath_pam_reply(struct be_fastpath_client *fcli,
+                                  uint32_t serial,
+                                  struct pam_data *pd)
+{
+    uint8_t *frame;
+    size_t len;
+    errno_t ret;
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "Sending result [%d][%s]\n", pd->pam_status, pd->domain);
+
+    ret = dp_fastpath_encode_pam_reply(fcli, serial, pd, &frame, &len);
+    if (ret == E2BIG) {
+        /* the responses do not fit into a frame, fail the request rather
+         * than letting it time out */
+        DEBUG(SSSDBG_CRIT_FAILURE, "PAM responses are too long\n");
+        pd->pam_status = PAM_SYSTEM_ERR;
+        pd->resp_list = NULL;
+        ret = dp_fastpath_encode_pam_reply(fcli, serial, pd, &frame, &len);
+    }
+    if (ret == EOK) {
+        ret = dp_fastpath_conn_send(fcli->conn, frame, len);
+    }
+    if (ret != EOK) {
+        /* the responder will time out the request */
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to send reply [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "Sent result [%d][%s]\n", pd->pam_status, pd->domain);
+}
+
+static void be_fastpath_pam_callback(struct be_req *req,
+                                     int dp_err_type,
+                                     int errnum,
+                                     const char *errstr)
+{
+    struct be_fastpath_call *call;
+    struct pam_data *pd;
+    errno_t ret;
+
+    DEBUG(SSSDBG_CONF_SETTINGS, "Backend returned: (%d, %d, %s) [%s]\n",
+              dp_err_type, errnum, errstr?errstr:"<NULL>",
+              dp_pam_err_to_string(req, dp_err_type, errnum));
+
+    pd = talloc_get_type(be_req_get_data(req), struct pam_data);
+
+    ret = be_pam_selinux_phase(req, pd, dp_err_type);
+    if (ret == EOK) {
+        return;
+    } else if (ret != ENOENT) {
+        /* the access check succeeded, but its result is not complete */
+        pd->pam_status = PAM_SYSTEM_ERR;
+    }
+
+    call = talloc_get_type(req->pvt, struct be_fastpath_call);
+    be_fastpath_pam_reply(call->fcli, call->serial, pd);
+
+    talloc_free(req);
+}
+
+static void be_fastpath_pam_handler(struct be_fastpath_client *fcli,
+                                    uint32_t serial,
+                                    const uint8_t *body,
+                                    size_t len)
+{
+    struct be_fastpath_call *call;
+    struct be_req *be_req;
+    struct pam_data *pd = NULL;
+    struct pam_data err_pd;
+    errno_t ret;
+
+    be_req = be_req_create(fcli->becli, fcli->becli, fcli->srv->be_ctx,
+                           be_fastpath_pam_callback, NULL);
+    if (be_req == NULL) {
+        goto fail;
+    }
+
+    call = talloc_zero(be_req, struct be_fastpath_call);
+    if (call == NULL) {
+        goto fail;
+    }
+    call->fcli = fcli;
+    call->serial = serial;
+    be_req->pvt = call;
+
+    ret = dp_fastpath_decode_pam_req(be_req, body, len, &pd);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Malformed request [%d]: %s\n",
+              ret, sss_strerror(ret));
+        goto fail;
+    }
+
+    if (be_pam_file_request(be_req, pd)) {
+        return;
+    }
+
+    /* send reply back immediately */
+    be_fastpath_pam_reply(fcli, serial, pd);
+    talloc_free(be_req);
+    return;
+
+fail:
+    memset(&err_pd, 0, sizeof(err_pd));
+    err_pd.pam_status = PAM_SYSTEM_ERR;
+    err_pd.domain = discard_const(fcli->srv->be_ctx->domain->name);
+    be_fastpath_pam_reply(fcli, serial, &err_pd);
+    talloc_free(be_req);
+}
+
 static void be_sudo_handler_reply(struct sbus_request *dbus_req,
                                   dbus_uint16_t dp_err,
                                   dbus_uint32_t dp_ret,
@@ -1992,7 +3147,10 @@ static int be_client_destructor(void *ctx)
 {
     struct be_client *becli = talloc_get_type(ctx, struct be_client);
     if (becli->bectx) {
-        if (becli->bectx->nss_cli == becli) {
+        if (becli->nss_worker) {
+            DEBUG(SSSDBG_TRACE_FUNC, "Removed NSS worker client\n");
+            DLIST_REMOVE(becli->bectx->nss_workers, becli);
+        } else if (becli->bectx->nss_cli == becli) {
             DEBUG(SSSDBG_TRACE_FUNC, "Removed NSS client\n");
             becli->bectx->nss_cli = NULL;
         } else if (becli->bectx->pam_cli == becli) {
@@ -2056,6 +3214,11 @@ static int client_registration(struct sbus_request *dbus_req, void *data)
 
     if (strcasecmp(cli_name, "NSS") == 0) {
         becli->bectx->nss_cli = becli;
+    } else if (strcasecmp(cli_name, "NSS worker") == 0) {
+        /* The workers only need the cache invalidations, the main NSS
+         * process remains the one updating the memory caches. */
+        becli->nss_worker = true;
+        DLIST_ADD(becli->bectx->nss_workers, becli);
     } else if (strcasecmp(cli_name, "PAM") == 0) {
         becli->bectx->pam_cli = becli;
     } else if (strcasecmp(cli_name, "SUDO") == 0) {
@@ -2227,7 +3390,7 @@ static int be_client_init(struct sbus_connection *conn, void *data)
     /* hang off this memory to the connection so that when the connection
      * is freed we can potentially call a destructor */
 
-    becli = talloc(conn, struct be_client);
+    becli = talloc_zero(conn, struct be_client);
     if (!becli) {
         DEBUG(SSSDBG_FATAL_FAILURE,"Out of memory?!\n");
         talloc_zfree(conn);
@@ -2634,6 +3797,12 @@ int be_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
+    ret = be_fastpath_srv_init(ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "fatal error setting up fast path\n");
+        goto fail;
+    }
+
     /* Initialize be_refresh periodic task. */
     ctx->refresh_ctx = be_refresh_ctx_init(ctx);
     if (ctx->refresh_ctx == NULL) {
@@ -2655,6 +3824,12 @@ int be_process_init(TALLOC_CTX *mem_ctx,
         }
     }
 
+    ret = be_snapshot_init(ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Unable to initialize cache snapshot\n");
+        goto fail;
+    }
+
     ret = load_backend_module(ctx, BET_ID,
                               &ctx->bet_info[BET_ID], NULL);
     if (ret != EOK) {
@@ -67,11 +67,30 @@ int be_fo_is_srv_identifier(const char *server)
 static int be_fo_get_options(struct be_ctx *ctx,
                              struct fo_options *opts)
 {
+    const char *str_policy;
+
     opts->service_resolv_timeout = dp_opt_get_int(ctx->be_res->opts,
                                                   DP_RES_OPT_RESOLVER_TIMEOUT);
     opts->retry_timeout = 30;
     opts->srv_retry_neg_timeout = 15;
     opts->family_order = ctx->be_res->family_order;
+    opts->probe_interval = dp_opt_get_int(ctx->be_res->opts,
+                                          DP_RES_OPT_FO_PROBE_INTERVAL);
+
+    str_policy = dp_opt_get_string(ctx->be_res->opts, DP_RES_OPT_FO_POLICY);
+    DEBUG(SSSDBG_CONF_SETTINGS, "Fail over policy: %s\n", str_policy);
+
+    if (strcasecmp(str_policy, "ordered") == 0) {
+        opts->policy = FO_POLICY_ORDERED;
+    } else if (strcasecmp(str_policy, "latency") == 0) {
+        opts->policy = FO_POLICY_LATENCY;
+    } else if (strcasecmp(str_policy, "power_of_two") == 0) {
+        opts->policy = FO_POLICY_POWER_OF_TWO;
+    } else {
+        DEBUG(SSSDBG_OP_FAILURE, "Unknown value for option failover_policy: "
+              "%s\n", str_policy);
+        return EINVAL;
+    }
 
     return EOK;
 }
@@ -713,6 +732,111 @@ int be_resolve_server_recv(struct tevent_req *req, struct fo_server **srv)
     return EOK;
 }
 
+struct be_resolve_standby_server_state {
+    struct be_svc_data *svc;
+    struct fo_server *srv;
+};
+
+static void be_resolve_standby_server_done(struct tevent_req *subreq);
+
+struct tevent_req *be_resolve_standby_server_send(TALLOC_CTX *memctx,
+                                                  struct tevent_context *ev,
+                                                  struct be_ctx *ctx,
+                                                  const char *service_name)
+{
+    struct tevent_req *req, *subreq;
+    struct be_resolve_standby_server_state *state;
+
+    req = tevent_req_create(memctx, &state,
+                            struct be_resolve_standby_server_state);
+    if (!req) return NULL;
+
+    state->svc = be_fo_find_svc_data(ctx, service_name);
+    if (state->svc == NULL) {
+        tevent_req_error(req, EINVAL);
+        tevent_req_post(req, ev);
+        return req;
+    }
+
+    subreq = fo_resolve_standby_service_send(state, ev,
+                                             ctx->be_fo->be_res->resolv,
+                                             ctx->be_fo->fo_ctx,
+                                             state->svc->fo_service);
+    if (!subreq) {
+        talloc_zfree(req);
+        return NULL;
+    }
+    tevent_req_set_callback(subreq, be_resolve_standby_server_done, req);
+
+    return req;
+}
+
+static void be_resolve_standby_server_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct be_resolve_standby_server_state *state = tevent_req_data(req,
+                                       struct be_resolve_standby_server_state);
+    errno_t ret;
+
+    ret = fo_resolve_service_recv(subreq, &state->srv);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "No standby server for service %s [%d]: %s\n",
+              state->svc->name, ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Standby server for service %s is %s\n",
+          state->svc->name, fo_get_server_str_name(state->srv));
+
+    /* The service callbacks are not run, they describe the active server
+     * to every user of the service. The caller builds the address of the
+     * standby server itself. */
+    tevent_req_done(req);
+}
+
+int be_resolve_standby_server_recv(struct tevent_req *req,
+                                   struct fo_server **srv)
+{
+    struct be_resolve_standby_server_state *state = tevent_req_data(req,
+                                       struct be_resolve_standby_server_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (srv) {
+        *srv = state->srv;
+    }
+
+    return EOK;
+}
+
+void be_fo_set_server_rtt(struct be_ctx *ctx,
+                          const char *service_name,
+                          struct fo_server *server,
+                          enum fo_rtt_type type,
+                          uint64_t rtt_usec)
+{
+    struct be_svc_data *be_svc;
+
+    be_svc = be_fo_find_svc_data(ctx, service_name);
+    if (be_svc == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "No service associated with name %s\n", service_name);
+        return;
+    }
+
+    if (!fo_svc_has_server(be_svc->fo_service, server)) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "The server %p is not valid anymore, cannot set its "
+              "round-trip time\n", server);
+        return;
+    }
+
+    fo_set_server_rtt(server, type, rtt_usec);
+}
+
 void be_fo_try_next_server(struct be_ctx *ctx, const char *service_name)
 {
     struct be_svc_data *svc;
@@ -780,6 +904,8 @@ static struct dp_option dp_res_default_opts[] = {
     { "dns_resolver_timeout", DP_OPT_NUMBER, { .number = 6 }, NULL_NUMBER },
     { "dns_resolver_op_timeout", DP_OPT_NUMBER, { .number = 6 }, NULL_NUMBER },
     { "dns_discovery_domain", DP_OPT_STRING, NULL_STRING, NULL_STRING },
+    { "failover_policy", DP_OPT_STRING, { "ordered" }, NULL_STRING },
+    { "failover_probe_interval", DP_OPT_NUMBER, { .number = 300 }, NULL_NUMBER },
     DP_OPTION_TERMINATOR
 };
 
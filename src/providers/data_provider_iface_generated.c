@@ -56,6 +56,13 @@ const struct sbus_method_meta data_provider_iface__methods[] = {
         offsetof(struct data_provider_iface, getAccountInfo),
         NULL, /* no invoker */
     },
+    {
+        "getAccountInfoMulti", /* name */
+        NULL, /* no in_args */
+        NULL, /* no out_args */
+        offsetof(struct data_provider_iface, getAccountInfoMulti),
+        NULL, /* no invoker */
+    },
     { NULL, }
 };
 
@@ -110,6 +117,13 @@ const struct sbus_method_meta data_provider_rev_iface__methods[] = {
         offsetof(struct data_provider_rev_iface, initgrCheck),
         NULL, /* no invoker */
     },
+    {
+        "invalidateCache", /* name */
+        NULL, /* no in_args */
+        NULL, /* no out_args */
+        offsetof(struct data_provider_rev_iface, invalidateCache),
+        NULL, /* no invoker */
+    },
     { NULL, }
 };
 
@@ -20,11 +20,13 @@
 #define DATA_PROVIDER_IFACE_HOSTHANDLER "hostHandler"
 #define DATA_PROVIDER_IFACE_GETDOMAINS "getDomains"
 #define DATA_PROVIDER_IFACE_GETACCOUNTINFO "getAccountInfo"
+#define DATA_PROVIDER_IFACE_GETACCOUNTINFOMULTI "getAccountInfoMulti"
 
 /* constants for org.freedesktop.sssd.dataprovider_rev */
 #define DATA_PROVIDER_REV_IFACE "org.freedesktop.sssd.dataprovider_rev"
 #define DATA_PROVIDER_REV_IFACE_UPDATECACHE "updateCache"
 #define DATA_PROVIDER_REV_IFACE_INITGRCHECK "initgrCheck"
+#define DATA_PROVIDER_REV_IFACE_INVALIDATECACHE "invalidateCache"
 
 /* ------------------------------------------------------------------------
  * DBus handlers
@@ -54,6 +56,7 @@ struct data_provider_iface {
     sbus_msg_handler_fn hostHandler;
     sbus_msg_handler_fn getDomains;
     sbus_msg_handler_fn getAccountInfo;
+    sbus_msg_handler_fn getAccountInfoMulti;
 };
 
 /* vtable for org.freedesktop.sssd.dataprovider_rev */
@@ -61,6 +64,7 @@ struct data_provider_rev_iface {
     struct sbus_vtable vtable; /* derive from sbus_vtable */
     sbus_msg_handler_fn updateCache;
     sbus_msg_handler_fn initgrCheck;
+    sbus_msg_handler_fn invalidateCache;
 };
 
 /* ------------------------------------------------------------------------
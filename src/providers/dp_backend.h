@@ -90,10 +90,14 @@ struct be_resolv_ctx {
 };
 
 struct be_client {
+    struct be_client *prev;
+    struct be_client *next;
+
     struct be_ctx *bectx;
     struct sbus_connection *conn;
     struct tevent_timer *timeout;
     bool initialized;
+    bool nss_worker;
 };
 
 struct be_failover_ctx;
@@ -132,6 +136,8 @@ struct be_ctx {
     struct sbus_connection *sbus_srv;
 
     struct be_client *nss_cli;
+    /* additional NSS responder processes, see the workers option */
+    struct be_client *nss_workers;
     struct be_client *pam_cli;
     struct be_client *sudo_cli;
     struct be_client *autofs_cli;
@@ -259,11 +265,30 @@ struct tevent_req *be_resolve_server_send(TALLOC_CTX *memctx,
                                           bool first_try);
 int be_resolve_server_recv(struct tevent_req *req, struct fo_server **srv);
 
+/*
+ * Resolve a working server of the service other than the active one to
+ * establish a standby connection to. The service callbacks are not run, the
+ * caller has to build the address of the standby server from the returned
+ * fo_server itself.
+ */
+struct tevent_req *be_resolve_standby_server_send(TALLOC_CTX *memctx,
+                                                  struct tevent_context *ev,
+                                                  struct be_ctx *ctx,
+                                                  const char *service_name);
+int be_resolve_standby_server_recv(struct tevent_req *req,
+                                   struct fo_server **srv);
+
 void be_fo_set_port_status(struct be_ctx *ctx,
                            const char *service_name,
                            struct fo_server *server,
                            enum port_status status);
 
+void be_fo_set_server_rtt(struct be_ctx *ctx,
+                          const char *service_name,
+                          struct fo_server *server,
+                          enum fo_rtt_type type,
+                          uint64_t rtt_usec);
+
 /*
  * Instruct fail-over to try next server on the next connect attempt.
  * Should be used after connection to service was unexpectedly dropped
@@ -0,0 +1,743 @@
+/*
+    SSSD
+
+    dp_fastpath.c - Binary protocol between the responders and the back ends
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "util/util.h"
+#include "providers/data_provider.h"
+#include "providers/dp_fastpath.h"
+
+#define DP_FASTPATH_BUF_SIZE (DP_FASTPATH_HDR_LEN + DP_FASTPATH_MAX_BODY)
+
+errno_t dp_fastpath_get_address(TALLOC_CTX *mem_ctx,
+                                const char *domain_name,
+                                char **_path)
+{
+    char *path;
+
+    path = talloc_asprintf(mem_ctx, "%s/%s_%s.fast",
+                           PIPE_PATH, DATA_PROVIDER_PIPE, domain_name);
+    if (path == NULL) {
+        return ENOMEM;
+    }
+
+    *_path = path;
+    return EOK;
+}
+
+errno_t dp_fastpath_decode_hdr(const uint8_t *buf, size_t len,
+                               struct dp_fastpath_hdr *hdr)
+{
+    size_t p = 0;
+
+    if (len < DP_FASTPATH_HDR_LEN) {
+        return EAGAIN;
+    }
+
+    SAFEALIGN_COPY_UINT32(&hdr->len, buf + p, &p);
+    SAFEALIGN_COPY_UINT16(&hdr->version, buf + p, &p);
+    SAFEALIGN_COPY_UINT16(&hdr->method, buf + p, &p);
+    SAFEALIGN_COPY_UINT32(&hdr->serial, buf + p, &p);
+
+    if (hdr->version != DP_FASTPATH_VERSION) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unsupported protocol version %"PRIu16"\n",
+              hdr->version);
+        return EBADMSG;
+    }
+
+    if (hdr->len > DP_FASTPATH_MAX_BODY) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Frame too long: %"PRIu32"\n", hdr->len);
+        return EBADMSG;
+    }
+
+    return EOK;
+}
+
+static uint8_t *dp_fastpath_frame_new(TALLOC_CTX *mem_ctx,
+                                      uint16_t method,
+                                      uint32_t serial,
+                                      size_t body_len,
+                                      size_t *_p)
+{
+    uint8_t *frame;
+    size_t p = 0;
+
+    if (body_len > DP_FASTPATH_MAX_BODY) {
+        return NULL;
+    }
+
+    frame = talloc_size(mem_ctx, DP_FASTPATH_HDR_LEN + body_len);
+    if (frame == NULL) {
+        return NULL;
+    }
+
+    SAFEALIGN_SET_UINT32(frame + p, body_len, &p);
+    SAFEALIGN_SET_UINT16(frame + p, DP_FASTPATH_VERSION, &p);
+    SAFEALIGN_SET_UINT16(frame + p, method, &p);
+    SAFEALIGN_SET_UINT32(frame + p, serial, &p);
+
+    *_p = p;
+    return frame;
+}
+
+static void dp_fastpath_set_string(uint8_t *frame, const char *str,
+                                   size_t len, size_t *_p)
+{
+    SAFEALIGN_SET_UINT32(frame + *_p, len, _p);
+    safealign_memcpy(frame + *_p, str, len, _p);
+}
+
+static errno_t dp_fastpath_get_string(TALLOC_CTX *mem_ctx,
+                                      const uint8_t *body, size_t len,
+                                      size_t *_p, const char **_str)
+{
+    uint32_t str_len;
+    char *str;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&str_len, body + *_p, len, _p);
+    if (str_len > len - *_p) {
+        return EINVAL;
+    }
+
+    /* the strings are passed on as C strings */
+    if (memchr(body + *_p, '\0', str_len) != NULL) {
+        return EINVAL;
+    }
+
+    str = talloc_strndup(mem_ctx, (const char *)body + *_p, str_len);
+    if (str == NULL) {
+        return ENOMEM;
+    }
+    *_p += str_len;
+
+    *_str = str;
+    return EOK;
+}
+
+errno_t dp_fastpath_encode_account_req(TALLOC_CTX *mem_ctx,
+                                       uint32_t serial,
+                                       struct dp_fastpath_account_req *ar,
+                                       uint8_t **_frame,
+                                       size_t *_len)
+{
+    uint8_t *frame;
+    size_t filter_len;
+    size_t domain_len;
+    size_t p;
+
+    if (ar->filter == NULL || ar->domain == NULL) {
+        return EINVAL;
+    }
+
+    filter_len = strlen(ar->filter);
+    domain_len = strlen(ar->domain);
+    if (filter_len > DP_FASTPATH_MAX_BODY
+            || domain_len > DP_FASTPATH_MAX_BODY) {
+        return E2BIG;
+    }
+
+    frame = dp_fastpath_frame_new(mem_ctx, DP_FASTPATH_GET_ACCOUNT_INFO,
+                                  serial,
+                                  4 * sizeof(uint32_t) + filter_len
+                                  + domain_len, &p);
+    if (frame == NULL) {
+        return E2BIG;
+    }
+
+    SAFEALIGN_SET_UINT32(frame + p, ar->entry_type, &p);
+    SAFEALIGN_SET_UINT32(frame + p, ar->attr_type, &p);
+    dp_fastpath_set_string(frame, ar->filter, filter_len, &p);
+    dp_fastpath_set_string(frame, ar->domain, domain_len, &p);
+
+    *_frame = frame;
+    *_len = p;
+    return EOK;
+}
+
+errno_t dp_fastpath_decode_account_req(TALLOC_CTX *mem_ctx,
+                                       const uint8_t *body,
+                                       size_t len,
+                                       struct dp_fastpath_account_req *ar)
+{
+    size_t p = 0;
+    errno_t ret;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&ar->entry_type, body + p, len, &p);
+    SAFEALIGN_COPY_UINT32_CHECK(&ar->attr_type, body + p, len, &p);
+
+    ret = dp_fastpath_get_string(mem_ctx, body, len, &p, &ar->filter);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = dp_fastpath_get_string(mem_ctx, body, len, &p, &ar->domain);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return p == len ? EOK : EINVAL;
+}
+
+errno_t dp_fastpath_encode_reply(TALLOC_CTX *mem_ctx,
+                                 uint32_t serial,
+                                 struct dp_fastpath_reply *reply,
+                                 uint8_t **_frame,
+                                 size_t *_len)
+{
+    const char *err_msg;
+    uint8_t *frame;
+    size_t msg_len;
+    size_t p;
+
+    err_msg = reply->err_msg == NULL ? "" : reply->err_msg;
+
+    /* the message is informational only, cut it rather than failing */
+    msg_len = strlen(err_msg);
+    if (msg_len > DP_FASTPATH_MAX_BODY / 2) {
+        msg_len = DP_FASTPATH_MAX_BODY / 2;
+    }
+
+    frame = dp_fastpath_frame_new(mem_ctx, DP_FASTPATH_REPLY, serial,
+                                  2 * sizeof(uint16_t) + 2 * sizeof(uint32_t)
+                                  + msg_len, &p);
+    if (frame == NULL) {
+        return ENOMEM;
+    }
+
+    SAFEALIGN_SET_UINT16(frame + p, reply->err_maj, &p);
+    SAFEALIGN_SET_UINT16(frame + p, reply->flags, &p);
+    SAFEALIGN_SET_UINT32(frame + p, reply->err_min, &p);
+    dp_fastpath_set_string(frame, err_msg, msg_len, &p);
+
+    *_frame = frame;
+    *_len = p;
+    return EOK;
+}
+
+errno_t dp_fastpath_decode_reply(TALLOC_CTX *mem_ctx,
+                                 const uint8_t *body,
+                                 size_t len,
+                                 struct dp_fastpath_reply *reply)
+{
+    size_t p = 0;
+    errno_t ret;
+
+    SAFEALIGN_COPY_UINT16_CHECK(&reply->err_maj, body + p, len, &p);
+    SAFEALIGN_COPY_UINT16_CHECK(&reply->flags, body + p, len, &p);
+    SAFEALIGN_COPY_UINT32_CHECK(&reply->err_min, body + p, len, &p);
+
+    ret = dp_fastpath_get_string(mem_ctx, body, len, &p, &reply->err_msg);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    return p == len ? EOK : EINVAL;
+}
+
+/* The authentication tokens must not linger in freed memory */
+static int dp_fastpath_wipe_frame(void *ptr)
+{
+    safezero(ptr, talloc_get_size(ptr));
+    return 0;
+}
+
+static void dp_fastpath_set_blob(uint8_t *frame, const uint8_t *data,
+                                 size_t len, size_t *_p)
+{
+    SAFEALIGN_SET_UINT32(frame + *_p, len, _p);
+    if (len > 0) {
+        safealign_memcpy(frame + *_p, data, len, _p);
+    }
+}
+
+static errno_t dp_fastpath_get_blob(const uint8_t *body, size_t len,
+                                    size_t *_p, const uint8_t **_data,
+                                    size_t *_data_len)
+{
+    uint32_t data_len;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&data_len, body + *_p, len, _p);
+    if (data_len > len - *_p) {
+        return EINVAL;
+    }
+
+    *_data = body + *_p;
+    *_data_len = data_len;
+    *_p += data_len;
+    return EOK;
+}
+
+/* The fields of struct pam_data in the order of dp_pack_pam_request() */
+#define DP_FASTPATH_PAM_STRINGS 6
+#define DP_FASTPATH_PAM_TOKENS 2
+
+errno_t dp_fastpath_encode_pam_req(TALLOC_CTX *mem_ctx,
+                                   uint32_t serial,
+                                   struct pam_data *pd,
+                                   uint8_t **_frame,
+                                   size_t *_len)
+{
+    const char *strs[DP_FASTPATH_PAM_STRINGS];
+    size_t str_lens[DP_FASTPATH_PAM_STRINGS];
+    struct sss_auth_token *toks[DP_FASTPATH_PAM_TOKENS];
+    size_t tok_lens[DP_FASTPATH_PAM_TOKENS];
+    uint8_t *frame;
+    size_t body_len;
+    size_t p;
+    int i;
+
+    if (pd->user == NULL || pd->domain == NULL) {
+        return EINVAL;
+    }
+
+    strs[0] = pd->user;
+    strs[1] = pd->domain;
+    strs[2] = pd->service ? pd->service : "";
+    strs[3] = pd->tty ? pd->tty : "";
+    strs[4] = pd->ruser ? pd->ruser : "";
+    strs[5] = pd->rhost ? pd->rhost : "";
+    toks[0] = pd->authtok;
+    toks[1] = pd->newauthtok;
+
+    /* cmd, priv, cli_pid and the types of the tokens */
+    body_len = 5 * sizeof(uint32_t);
+
+    for (i = 0; i < DP_FASTPATH_PAM_STRINGS; i++) {
+        str_lens[i] = strlen(strs[i]);
+        if (str_lens[i] > DP_FASTPATH_MAX_BODY) {
+            return E2BIG;
+        }
+        body_len += sizeof(uint32_t) + str_lens[i];
+    }
+
+    for (i = 0; i < DP_FASTPATH_PAM_TOKENS; i++) {
+        tok_lens[i] = sss_authtok_get_size(toks[i]);
+        if (tok_lens[i] > DP_FASTPATH_MAX_BODY) {
+            return E2BIG;
+        }
+        body_len += sizeof(uint32_t) + tok_lens[i];
+    }
+
+    frame = dp_fastpath_frame_new(mem_ctx, DP_FASTPATH_PAM_HANDLER, serial,
+                                  body_len, &p);
+    if (frame == NULL) {
+        return E2BIG;
+    }
+    talloc_set_destructor((TALLOC_CTX *)frame, dp_fastpath_wipe_frame);
+
+    SAFEALIGN_SET_INT32(frame + p, pd->cmd, &p);
+    SAFEALIGN_SET_INT32(frame + p, pd->priv, &p);
+    SAFEALIGN_SET_UINT32(frame + p, pd->cli_pid, &p);
+
+    for (i = 0; i < DP_FASTPATH_PAM_STRINGS; i++) {
+        dp_fastpath_set_string(frame, strs[i], str_lens[i], &p);
+    }
+
+    for (i = 0; i < DP_FASTPATH_PAM_TOKENS; i++) {
+        SAFEALIGN_SET_UINT32(frame + p, sss_authtok_get_type(toks[i]), &p);
+        dp_fastpath_set_blob(frame, sss_authtok_get_data(toks[i]),
+                             tok_lens[i], &p);
+    }
+
+    *_frame = frame;
+    *_len = p;
+    return EOK;
+}
+
+/* The strings of pd are allocated on mem_ctx, the tokens point into body */
+static errno_t dp_fastpath_parse_pam_req(TALLOC_CTX *mem_ctx,
+                                         const uint8_t *body,
+                                         size_t len,
+                                         struct pam_data *pd,
+                                         uint32_t *tok_types,
+                                         const uint8_t **tok_data,
+                                         size_t *tok_lens)
+{
+    const char *strs[DP_FASTPATH_PAM_STRINGS];
+    int32_t cmd;
+    int32_t priv;
+    size_t p = 0;
+    errno_t ret;
+    int i;
+
+    SAFEALIGN_COPY_INT32_CHECK(&cmd, body + p, len, &p);
+    SAFEALIGN_COPY_INT32_CHECK(&priv, body + p, len, &p);
+    SAFEALIGN_COPY_UINT32_CHECK(&pd->cli_pid, body + p, len, &p);
+    pd->cmd = cmd;
+    pd->priv = priv;
+
+    for (i = 0; i < DP_FASTPATH_PAM_STRINGS; i++) {
+        ret = dp_fastpath_get_string(mem_ctx, body, len, &p, &strs[i]);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    for (i = 0; i < DP_FASTPATH_PAM_TOKENS; i++) {
+        SAFEALIGN_COPY_UINT32_CHECK(&tok_types[i], body + p, len, &p);
+        ret = dp_fastpath_get_blob(body, len, &p, &tok_data[i], &tok_lens[i]);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    pd->user = discard_const(strs[0]);
+    pd->domain = discard_const(strs[1]);
+    pd->service = discard_const(strs[2]);
+    pd->tty = discard_const(strs[3]);
+    pd->ruser = discard_const(strs[4]);
+    pd->rhost = discard_const(strs[5]);
+
+    return p == len ? EOK : EINVAL;
+}
+
+errno_t dp_fastpath_decode_pam_req(TALLOC_CTX *mem_ctx,
+                                   const uint8_t *body,
+                                   size_t len,
+                                   struct pam_data **_pd)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct pam_data pd;
+    struct pam_data *new_pd = NULL;
+    uint32_t tok_types[DP_FASTPATH_PAM_TOKENS];
+    const uint8_t *tok_data[DP_FASTPATH_PAM_TOKENS];
+    size_t tok_lens[DP_FASTPATH_PAM_TOKENS];
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    memset(&pd, 0, sizeof(pd));
+
+    ret = dp_fastpath_parse_pam_req(tmp_ctx, body, len, &pd,
+                                    tok_types, tok_data, tok_lens);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = copy_pam_data(mem_ctx, &pd, &new_pd);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_authtok_set(new_pd->authtok, tok_types[0],
+                          tok_data[0], tok_lens[0]);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sss_authtok_set(new_pd->newauthtok, tok_types[1],
+                          tok_data[1], tok_lens[1]);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    *_pd = new_pd;
+    new_pd = NULL;
+    ret = EOK;
+
+done:
+    talloc_free(new_pd);
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t dp_fastpath_encode_pam_reply(TALLOC_CTX *mem_ctx,
+                                     uint32_t serial,
+                                     struct pam_data *pd,
+                                     uint8_t **_frame,
+                                     size_t *_len)
+{
+    struct response_data *resp;
+    uint32_t num_resp = 0;
+    uint8_t *frame;
+    size_t body_len;
+    size_t p;
+
+    /* the status and the number of responses */
+    body_len = 2 * sizeof(uint32_t);
+
+    for (resp = pd->resp_list; resp != NULL; resp = resp->next) {
+        if (resp->len < 0 || resp->len > DP_FASTPATH_MAX_BODY) {
+            return E2BIG;
+        }
+        body_len += 2 * sizeof(uint32_t) + resp->len;
+        num_resp++;
+    }
+
+    frame = dp_fastpath_frame_new(mem_ctx, DP_FASTPATH_PAM_REPLY, serial,
+                                  body_len, &p);
+    if (frame == NULL) {
+        return E2BIG;
+    }
+
+    SAFEALIGN_SET_UINT32(frame + p, pd->pam_status, &p);
+    SAFEALIGN_SET_UINT32(frame + p, num_resp, &p);
+
+    for (resp = pd->resp_list; resp != NULL; resp = resp->next) {
+        SAFEALIGN_SET_INT32(frame + p, resp->type, &p);
+        dp_fastpath_set_blob(frame, resp->data, resp->len, &p);
+    }
+
+    *_frame = frame;
+    *_len = p;
+    return EOK;
+}
+
+errno_t dp_fastpath_decode_pam_reply(const uint8_t *body,
+                                     size_t len,
+                                     struct pam_data *pd)
+{
+    uint32_t pam_status;
+    uint32_t num_resp;
+    int32_t type;
+    const uint8_t *data;
+    size_t data_len;
+    size_t p = 0;
+    uint32_t i;
+    errno_t ret;
+
+    SAFEALIGN_COPY_UINT32_CHECK(&pam_status, body + p, len, &p);
+    SAFEALIGN_COPY_UINT32_CHECK(&num_resp, body + p, len, &p);
+
+    /* the responses are added in the same order as by
+     * dp_unpack_pam_response() */
+    for (i = 0; i < num_resp; i++) {
+        SAFEALIGN_COPY_INT32_CHECK(&type, body + p, len, &p);
+        ret = dp_fastpath_get_blob(body, len, &p, &data, &data_len);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        ret = pam_add_response(pd, type, data_len, data);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    if (p != len) {
+        return EINVAL;
+    }
+
+    pd->pam_status = pam_status;
+    return EOK;
+}
+
+struct dp_fastpath_out {
+    struct dp_fastpath_out *prev;
+    struct dp_fastpath_out *next;
+
+    uint8_t *frame;
+    size_t len;
+    size_t written;
+};
+
+struct dp_fastpath_conn {
+    int fd;
+    struct tevent_fd *fde;
+
+    uint8_t *in;
+    size_t in_len;
+    struct dp_fastpath_out *out;
+
+    dp_fastpath_frame_fn frame_fn;
+    dp_fastpath_close_fn close_fn;
+    void *pvt;
+};
+
+static int dp_fastpath_conn_destructor(struct dp_fastpath_conn *conn)
+{
+    talloc_zfree(conn->fde);
+    if (conn->fd != -1) {
+        close(conn->fd);
+        conn->fd = -1;
+    }
+
+    return 0;
+}
+
+/* Returns false if the connection was closed */
+static bool dp_fastpath_conn_write(struct dp_fastpath_conn *conn)
+{
+    struct dp_fastpath_out *out;
+    ssize_t n;
+    errno_t ret;
+
+    while ((out = conn->out) != NULL) {
+        errno = 0;
+        n = write(conn->fd, out->frame + out->written,
+                  out->len - out->written);
+        if (n == -1) {
+            ret = errno;
+            if (ret == EAGAIN || ret == EWOULDBLOCK || ret == EINTR) {
+                return true;
+            }
+
+            DEBUG(SSSDBG_OP_FAILURE, "write failed [%d]: %s\n",
+                  ret, sss_strerror(ret));
+            conn->close_fn(conn, conn->pvt);
+            return false;
+        }
+
+        out->written += n;
+        if (out->written < out->len) {
+            return true;
+        }
+
+        DLIST_REMOVE(conn->out, out);
+        talloc_free(out);
+    }
+
+    TEVENT_FD_NOT_WRITEABLE(conn->fde);
+    return true;
+}
+
+static void dp_fastpath_conn_read(struct dp_fastpath_conn *conn)
+{
+    struct dp_fastpath_hdr hdr;
+    size_t p = 0;
+    ssize_t n;
+    errno_t ret;
+
+    errno = 0;
+    n = read(conn->fd, conn->in + conn->in_len,
+             DP_FASTPATH_BUF_SIZE - conn->in_len);
+    if (n == -1) {
+        ret = errno;
+        if (ret == EAGAIN || ret == EWOULDBLOCK || ret == EINTR) {
+            return;
+        }
+
+        DEBUG(SSSDBG_OP_FAILURE, "read failed [%d]: %s\n",
+              ret, sss_strerror(ret));
+        conn->close_fn(conn, conn->pvt);
+        return;
+    } else if (n == 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "The peer closed the connection\n");
+        conn->close_fn(conn, conn->pvt);
+        return;
+    }
+    conn->in_len += n;
+
+    while (true) {
+        ret = dp_fastpath_decode_hdr(conn->in + p, conn->in_len - p, &hdr);
+        if (ret == EAGAIN) {
+            break;
+        } else if (ret != EOK) {
+            conn->close_fn(conn, conn->pvt);
+            return;
+        }
+
+        if (conn->in_len - p < DP_FASTPATH_HDR_LEN + hdr.len) {
+            break;
+        }
+
+        conn->frame_fn(conn, &hdr, conn->in + p + DP_FASTPATH_HDR_LEN,
+                       conn->pvt);
+        p += DP_FASTPATH_HDR_LEN + hdr.len;
+    }
+
+    if (p > 0) {
+        memmove(conn->in, conn->in + p, conn->in_len - p);
+        conn->in_len -= p;
+    }
+}
+
+static void dp_fastpath_conn_handler(struct tevent_context *ev,
+                                     struct tevent_fd *fde,
+                                     uint16_t flags, void *ptr)
+{
+    struct dp_fastpath_conn *conn;
+
+    conn = talloc_get_type(ptr, struct dp_fastpath_conn);
+
+    if (flags & TEVENT_FD_WRITE) {
+        if (!dp_fastpath_conn_write(conn)) {
+            return;
+        }
+    }
+
+    if (flags & TEVENT_FD_READ) {
+        dp_fastpath_conn_read(conn);
+    }
+}
+
+struct dp_fastpath_conn *
+dp_fastpath_conn_create(TALLOC_CTX *mem_ctx,
+                        struct tevent_context *ev,
+                        int fd,
+                        dp_fastpath_frame_fn frame_fn,
+                        dp_fastpath_close_fn close_fn,
+                        void *pvt)
+{
+    struct dp_fastpath_conn *conn;
+
+    conn = talloc_zero(mem_ctx, struct dp_fastpath_conn);
+    if (conn == NULL) {
+        return NULL;
+    }
+    conn->fd = -1;
+    conn->frame_fn = frame_fn;
+    conn->close_fn = close_fn;
+    conn->pvt = pvt;
+
+    conn->in = talloc_size(conn, DP_FASTPATH_BUF_SIZE);
+    if (conn->in == NULL) {
+        talloc_free(conn);
+        return NULL;
+    }
+
+    conn->fde = tevent_add_fd(ev, conn, fd, TEVENT_FD_READ,
+                              dp_fastpath_conn_handler, conn);
+    if (conn->fde == NULL) {
+        talloc_free(conn);
+        return NULL;
+    }
+
+    conn->fd = fd;
+    talloc_set_destructor(conn, dp_fastpath_conn_destructor);
+
+    return conn;
+}
+
+errno_t dp_fastpath_conn_send(struct dp_fastpath_conn *conn,
+                              uint8_t *frame, size_t len)
+{
+    struct dp_fastpath_out *out;
+
+    out = talloc_zero(conn, struct dp_fastpath_out);
+    if (out == NULL) {
+        return ENOMEM;
+    }
+
+    out->frame = talloc_steal(out, frame);
+    out->len = len;
+
+    DLIST_ADD_END(conn->out, out, struct dp_fastpath_out *);
+    TEVENT_FD_WRITEABLE(conn->fde);
+
+    return EOK;
+}
@@ -0,0 +1,161 @@
+/*
+    SSSD
+
+    dp_fastpath.h - Binary protocol between the responders and the back ends
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _DP_FASTPATH_H_
+#define _DP_FASTPATH_H_
+
+#include <stdint.h>
+#include <talloc.h>
+#include <tevent.h>
+
+#include "util/util.h"
+
+/* The getAccountInfo calls issued by the responders on every cache miss and
+ * the pamHandler calls of the PAM responder can be sent over a plain UNIX
+ * socket next to the D-Bus socket of the back end instead of D-Bus. Each
+ * frame consists of a fixed header followed by the fields of the call in a
+ * fixed order. Strings and byte arrays are sent as their length followed by
+ * the bytes, strings without the terminating zero. Both ends run on the
+ * same host, so all integers are in host byte order. */
+
+#define DP_FASTPATH_VERSION 1
+
+/* body length, version, method, serial */
+#define DP_FASTPATH_HDR_LEN 12
+#define DP_FASTPATH_MAX_BODY 16384
+
+enum dp_fastpath_method {
+    DP_FASTPATH_GET_ACCOUNT_INFO = 1,
+    DP_FASTPATH_REPLY = 2,
+    DP_FASTPATH_PAM_HANDLER = 3,
+    DP_FASTPATH_PAM_REPLY = 4
+};
+
+/* The back end updated the cache of the domain, the responder has to drop
+ * its in-memory copies before it reads the entry from the cache again. */
+#define DP_FASTPATH_REPLY_INVALIDATE 0x0001
+
+struct dp_fastpath_hdr {
+    uint32_t len;
+    uint16_t version;
+    uint16_t method;
+    uint32_t serial;
+};
+
+struct dp_fastpath_account_req {
+    uint32_t entry_type;
+    uint32_t attr_type;
+    const char *filter;
+    const char *domain;
+};
+
+struct dp_fastpath_reply {
+    uint16_t err_maj;
+    uint16_t flags;
+    uint32_t err_min;
+    const char *err_msg;
+};
+
+struct pam_data;
+
+errno_t dp_fastpath_get_address(TALLOC_CTX *mem_ctx,
+                                const char *domain_name,
+                                char **_path);
+
+/* Returns EAGAIN if buf does not contain the whole header yet */
+errno_t dp_fastpath_decode_hdr(const uint8_t *buf, size_t len,
+                               struct dp_fastpath_hdr *hdr);
+
+errno_t dp_fastpath_encode_account_req(TALLOC_CTX *mem_ctx,
+                                       uint32_t serial,
+                                       struct dp_fastpath_account_req *ar,
+                                       uint8_t **_frame,
+                                       size_t *_len);
+
+errno_t dp_fastpath_decode_account_req(TALLOC_CTX *mem_ctx,
+                                       const uint8_t *body,
+                                       size_t len,
+                                       struct dp_fastpath_account_req *ar);
+
+errno_t dp_fastpath_encode_reply(TALLOC_CTX *mem_ctx,
+                                 uint32_t serial,
+                                 struct dp_fastpath_reply *reply,
+                                 uint8_t **_frame,
+                                 size_t *_len);
+
+errno_t dp_fastpath_decode_reply(TALLOC_CTX *mem_ctx,
+                                 const uint8_t *body,
+                                 size_t len,
+                                 struct dp_fastpath_reply *reply);
+
+/* The same fields as dp_pack_pam_request(), the frame wipes the
+ * authentication tokens when it is freed */
+errno_t dp_fastpath_encode_pam_req(TALLOC_CTX *mem_ctx,
+                                   uint32_t serial,
+                                   struct pam_data *pd,
+                                   uint8_t **_frame,
+                                   size_t *_len);
+
+errno_t dp_fastpath_decode_pam_req(TALLOC_CTX *mem_ctx,
+                                   const uint8_t *body,
+                                   size_t len,
+                                   struct pam_data **_pd);
+
+/* The same fields as dp_pack_pam_response() */
+errno_t dp_fastpath_encode_pam_reply(TALLOC_CTX *mem_ctx,
+                                     uint32_t serial,
+                                     struct pam_data *pd,
+                                     uint8_t **_frame,
+                                     size_t *_len);
+
+/* Sets the status of pd and adds the responses to it */
+errno_t dp_fastpath_decode_pam_reply(const uint8_t *body,
+                                     size_t len,
+                                     struct pam_data *pd);
+
+/* A connection hands every complete frame it reads to frame_fn and writes
+ * the queued frames when the socket is writable. If the peer closes the
+ * connection or sends garbage, close_fn is called and it is expected to
+ * free the connection. */
+struct dp_fastpath_conn;
+
+typedef void (*dp_fastpath_frame_fn)(struct dp_fastpath_conn *conn,
+                                     struct dp_fastpath_hdr *hdr,
+                                     const uint8_t *body,
+                                     void *pvt);
+
+typedef void (*dp_fastpath_close_fn)(struct dp_fastpath_conn *conn,
+                                     void *pvt);
+
+/* The connection takes over fd and closes it when it is freed */
+struct dp_fastpath_conn *
+dp_fastpath_conn_create(TALLOC_CTX *mem_ctx,
+                        struct tevent_context *ev,
+                        int fd,
+                        dp_fastpath_frame_fn frame_fn,
+                        dp_fastpath_close_fn close_fn,
+                        void *pvt);
+
+/* Queues the frame, which is stolen by the connection */
+errno_t dp_fastpath_conn_send(struct dp_fastpath_conn *conn,
+                              uint8_t *frame, size_t len);
+
+#endif /* _DP_FASTPATH_H_ */
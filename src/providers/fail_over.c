@@ -26,6 +26,7 @@
 #include <sys/time.h>
 
 #include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <strings.h>
 #include <talloc.h>
@@ -43,6 +44,16 @@
 #define DEFAULT_SERVER_STATUS SERVER_NAME_NOT_RESOLVED
 #define DEFAULT_SRV_STATUS SRV_NEUTRAL
 
+/* Weight of a new round-trip time sample in the moving average is
+ * 1/(2^FO_RTT_EWMA_SHIFT), the same smoothing factor TCP uses for SRTT. */
+#define FO_RTT_EWMA_SHIFT 3
+/* With the latency policy, the current server is only abandoned when it is
+ * slower than the fastest one by this factor to prevent flapping. */
+#define FO_LATENCY_SWITCH_FACTOR 2
+/* Round-trip times are only compared once a server has at least this many
+ * samples, a single probe is too noisy to select a server on. */
+#define FO_LATENCY_MIN_SAMPLES 3
+
 enum srv_lookup_status {
     SRV_NEUTRAL,        /* We didn't try this SRV lookup yet */
     SRV_RESOLVED,       /* This SRV lookup is resolved       */
@@ -59,6 +70,8 @@ struct fo_ctx {
     fo_srv_lookup_plugin_send_t srv_send_fn;
     fo_srv_lookup_plugin_recv_t srv_recv_fn;
     void *srv_pvt;
+
+    unsigned int seed;
 };
 
 struct fo_service {
@@ -76,6 +89,13 @@ struct fo_service {
      * is needed in fail over duplicate servers detection.
      */
     datacmp_fn user_data_cmp;
+
+    /* When did the latency policy last probe a server other than
+     * the fastest one */
+    time_t last_probe;
+    /* The server returned by the last probe, it does not become the active
+     * server when it works */
+    struct fo_server *probe_server;
 };
 
 struct fo_server {
@@ -90,6 +110,17 @@ struct fo_server {
     struct fo_service *service;
     struct timeval last_status_change;
     struct server_common *common;
+
+    /* SRV priority, servers with the same priority are interchangeable */
+    unsigned short priority;
+    struct fo_latency {
+        /* smoothed round-trip times in microseconds */
+        uint64_t connect_rtt;
+        uint64_t op_rtt;
+        unsigned int connect_samples;
+        unsigned int op_samples;
+        time_t last_sample;
+    } latency;
 };
 
 struct server_common {
@@ -134,6 +165,8 @@ struct status {
     struct timeval last_change;
 };
 
+static const char *str_fo_policy(enum fo_policy policy);
+
 struct fo_ctx *
 fo_context_init(TALLOC_CTX *mem_ctx, struct fo_options *opts)
 {
@@ -154,13 +187,33 @@ fo_context_init(TALLOC_CTX *mem_ctx, struct fo_options *opts)
     ctx->opts->retry_timeout = opts->retry_timeout;
     ctx->opts->family_order  = opts->family_order;
     ctx->opts->service_resolv_timeout = opts->service_resolv_timeout;
+    ctx->opts->policy = opts->policy;
+    ctx->opts->probe_interval = opts->probe_interval;
+
+    ctx->seed = time(NULL) * getpid();
 
     DEBUG(SSSDBG_TRACE_FUNC,
-          "Created new fail over context, retry timeout is %ld\n",
-           ctx->opts->retry_timeout);
+          "Created new fail over context, retry timeout is %ld, "
+          "policy is %s\n", ctx->opts->retry_timeout,
+          str_fo_policy(ctx->opts->policy));
     return ctx;
 }
 
+static const char *
+str_fo_policy(enum fo_policy policy)
+{
+    switch (policy) {
+    case FO_POLICY_ORDERED:
+        return "ordered";
+    case FO_POLICY_LATENCY:
+        return "latency";
+    case FO_POLICY_POWER_OF_TWO:
+        return "power of two choices";
+    }
+
+    return "unknown policy";
+}
+
 static const char *
 str_port_status(enum port_status status)
 {
@@ -242,6 +295,9 @@ collapse_srv_lookup(struct fo_server **_server)
         if (server == server->service->active_server) {
             server->service->active_server = NULL;
         }
+        if (server == server->service->probe_server) {
+            server->service->probe_server = NULL;
+        }
         if (server == server->service->last_tried_server) {
             server->service->last_tried_server = meta;
         }
@@ -435,6 +491,7 @@ fo_new_service(struct fo_ctx *ctx, const char *name,
     }
 
     service->user_data_cmp = user_data_cmp;
+    service->last_probe = time(NULL);
 
     service->ctx = ctx;
     DLIST_ADD(ctx->service_list, service);
@@ -766,6 +823,7 @@ static errno_t fo_add_server_list(struct fo_service *service,
         }
 
         server->srv_data = srv_data;
+        server->priority = servers[i].priority;
 
         ret = fo_add_server_to_list(&srv_list, service->server_list,
                                     server, service->name);
@@ -810,6 +868,138 @@ fo_add_server(struct fo_service *service, const char *name, int port,
     return ret;
 }
 
+static bool
+is_srv_meta_server(struct fo_server *server)
+{
+    return server->srv_data != NULL && server->srv_data->meta == server;
+}
+
+/*
+ * Servers are interchangeable for the latency based policies only if they
+ * come from the same source and have the same SRV priority.
+ */
+static bool
+same_priority_group(struct fo_server *s1, struct fo_server *s2)
+{
+    return s1->primary == s2->primary
+           && s1->srv_data == s2->srv_data
+           && s1->priority == s2->priority;
+}
+
+/*
+ * Returns true if 'server' is known to be faster than 'other' at least by
+ * 'factor'. Operation round-trip times are compared if both servers have
+ * enough of them, connect round-trip times otherwise.
+ */
+static bool
+server_is_faster(struct fo_server *server, struct fo_server *other,
+                 unsigned int factor)
+{
+    if (server->latency.op_samples >= FO_LATENCY_MIN_SAMPLES
+            && other->latency.op_samples >= FO_LATENCY_MIN_SAMPLES) {
+        return server->latency.op_rtt * factor < other->latency.op_rtt;
+    }
+
+    if (server->latency.connect_samples >= FO_LATENCY_MIN_SAMPLES
+            && other->latency.connect_samples >= FO_LATENCY_MIN_SAMPLES) {
+        return server->latency.connect_rtt * factor
+                    < other->latency.connect_rtt;
+    }
+
+    return false;
+}
+
+/*
+ * Given the server selected by the ordered algorithm, pick a working server
+ * from the same priority group according to the latency based policy.
+ */
+static struct fo_server *
+latency_select_server(struct fo_service *service, struct fo_server *current)
+{
+    struct fo_options *opts = service->ctx->opts;
+    struct fo_server *server;
+    struct fo_server *probe = NULL;
+    struct fo_server *best = current;
+    struct fo_server *choice[2] = { current, NULL };
+    unsigned int count = 1;
+    unsigned int i;
+    time_t now;
+
+    if (opts->policy == FO_POLICY_ORDERED
+            || current->common == NULL
+            || is_srv_meta_server(current)) {
+        return current;
+    }
+
+    DLIST_FOR_EACH(server, service->server_list) {
+        if (server == current
+                || server->common == NULL
+                || is_srv_meta_server(server)
+                || !same_priority_group(server, current)
+                || !service_works(server)) {
+            continue;
+        }
+
+        if (probe == NULL
+                || server->latency.last_sample < probe->latency.last_sample) {
+            probe = server;
+        }
+
+        if (server_is_faster(server, best, 1)) {
+            best = server;
+        }
+
+        /* Reservoir sampling of two random servers of the group */
+        count++;
+        if (count == 2) {
+            choice[1] = server;
+        } else {
+            i = rand_r(&service->ctx->seed) % count;
+            if (i < 2) {
+                choice[i] = server;
+            }
+        }
+    }
+
+    if (count == 1) {
+        /* No alternative */
+        return current;
+    }
+
+    now = time(NULL);
+    if (opts->probe_interval > 0
+            && now - service->last_probe >= opts->probe_interval) {
+        service->last_probe = now;
+        service->probe_server = probe;
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Probing server '%s' of service '%s'\n",
+              SERVER_NAME(probe), service->name);
+        return probe;
+    }
+
+    switch (opts->policy) {
+    case FO_POLICY_LATENCY:
+        if (best != current
+                && server_is_faster(best, current, FO_LATENCY_SWITCH_FACTOR)) {
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "Server '%s' is faster than '%s' [%"PRIu64" < %"PRIu64" us]\n",
+                  SERVER_NAME(best), SERVER_NAME(current),
+                  fo_get_server_rtt(best), fo_get_server_rtt(current));
+            return best;
+        }
+        break;
+    case FO_POLICY_POWER_OF_TWO:
+        if (server_is_faster(choice[1], choice[0], 1)) {
+            return choice[1];
+        }
+        return choice[0];
+    case FO_POLICY_ORDERED:
+        break;
+    }
+
+    return current;
+}
+
 static int
 get_first_server_entity(struct fo_service *service, struct fo_server **_server)
 {
@@ -875,11 +1065,50 @@ get_first_server_entity(struct fo_service *service, struct fo_server **_server)
     return ENOENT;
 
 done:
+    server = latency_select_server(service, server);
     service->last_tried_server = server;
     *_server = server;
     return EOK;
 }
 
+/*
+ * Find a working server other than the active one, primary servers first.
+ * SRV lookups are not expanded, only servers that are already known are
+ * considered.
+ */
+static int
+get_standby_server_entity(struct fo_service *service,
+                          struct fo_server **_server)
+{
+    struct fo_server *active = service->active_server;
+    struct fo_server *server;
+    int i;
+
+    if (active == NULL) {
+        return ENOENT;
+    }
+
+    /* First iterate over primary servers, then over backup ones */
+    for (i = 0; i < 2; i++) {
+        DLIST_FOR_EACH(server, service->server_list) {
+            if (server->primary != (i == 0)
+                    || server == active
+                    || server->common == NULL
+                    || is_srv_meta_server(server)
+                    || fo_server_cmp(server, active)) {
+                continue;
+            }
+
+            if (service_works(server)) {
+                *_server = server;
+                return EOK;
+            }
+        }
+    }
+
+    return ENOENT;
+}
+
 static int
 resolve_service_request_destructor(struct resolve_service_request *request)
 {
@@ -1006,6 +1235,55 @@ done:
     return req;
 }
 
+struct tevent_req *
+fo_resolve_standby_service_send(TALLOC_CTX *mem_ctx, struct tevent_context *ev,
+                                struct resolv_ctx *resolv, struct fo_ctx *ctx,
+                                struct fo_service *service)
+{
+    int ret;
+    struct fo_server *server;
+    struct tevent_req *req;
+    struct resolve_service_state *state;
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "Trying to resolve standby server of service '%s'\n", service->name);
+    req = tevent_req_create(mem_ctx, &state, struct resolve_service_state);
+    if (req == NULL)
+        return NULL;
+
+    state->resolv = resolv;
+    state->ev = ev;
+    state->fo_ctx = ctx;
+
+    ret = get_standby_server_entity(service, &server);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "No standby server available for service '%s'\n",
+              service->name);
+        goto done;
+    }
+
+    ret = fo_resolve_service_activate_timeout(req, ev,
+                                        ctx->opts->service_resolv_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Could not set service timeout\n");
+        goto done;
+    }
+
+    state->server = server;
+    if (fo_resolve_service_server(req)) {
+        tevent_req_post(req, ev);
+    }
+
+    ret = EOK;
+done:
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        tevent_req_post(req, ev);
+    }
+    return req;
+}
+
 static void set_server_common_status(struct server_common *common,
                                      enum server_status status);
 
@@ -1437,7 +1715,13 @@ fo_set_port_status(struct fo_server *server, enum port_status status)
     gettimeofday(&server->last_status_change, NULL);
     if (status == PORT_WORKING) {
         fo_set_server_status(server, SERVER_WORKING);
-        server->service->active_server = server;
+        if (server == server->service->probe_server) {
+            /* A probed server is only switched to once it has enough
+             * samples to be found faster, see latency_select_server() */
+            server->service->probe_server = NULL;
+        } else {
+            server->service->active_server = server;
+        }
     }
 
     if (!server->common || !server->common->name) return;
@@ -1457,6 +1741,63 @@ fo_set_port_status(struct fo_server *server, enum port_status status)
     }
 }
 
+static void
+update_rtt_ewma(uint64_t *rtt, unsigned int *samples, uint64_t sample)
+{
+    if (*samples == 0) {
+        *rtt = sample;
+    } else if (sample >= *rtt) {
+        *rtt += (sample - *rtt) >> FO_RTT_EWMA_SHIFT;
+    } else {
+        *rtt -= (*rtt - sample) >> FO_RTT_EWMA_SHIFT;
+    }
+
+    if (*samples < UINT_MAX) {
+        (*samples)++;
+    }
+}
+
+void fo_set_server_rtt(struct fo_server *server,
+                       enum fo_rtt_type type,
+                       uint64_t rtt_usec)
+{
+    if (server == NULL) {
+        return;
+    }
+
+    switch (type) {
+    case FO_RTT_CONNECT:
+        update_rtt_ewma(&server->latency.connect_rtt,
+                        &server->latency.connect_samples, rtt_usec);
+        break;
+    case FO_RTT_OPERATION:
+        update_rtt_ewma(&server->latency.op_rtt,
+                        &server->latency.op_samples, rtt_usec);
+        break;
+    }
+
+    server->latency.last_sample = time(NULL);
+
+    DEBUG(SSSDBG_TRACE_INTERNAL,
+          "Round-trip time of server '%s' is %"PRIu64" us "
+          "[connect %"PRIu64" us, operation %"PRIu64" us]\n",
+          SERVER_NAME(server), rtt_usec,
+          server->latency.connect_rtt, server->latency.op_rtt);
+}
+
+uint64_t fo_get_server_rtt(struct fo_server *server)
+{
+    if (server->latency.op_samples > 0) {
+        return server->latency.op_rtt;
+    }
+
+    if (server->latency.connect_samples > 0) {
+        return server->latency.connect_rtt;
+    }
+
+    return 0;
+}
+
 void fo_try_next_server(struct fo_service *service)
 {
     struct fo_server *server;
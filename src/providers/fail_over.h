@@ -26,6 +26,7 @@
 #define __FAIL_OVER_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <talloc.h>
 
 #include "resolv/async_resolv.h"
@@ -53,6 +54,17 @@ enum server_status {
     SERVER_NOT_WORKING        /* We tried and failed to connect to the server. */
 };
 
+enum fo_policy {
+    FO_POLICY_ORDERED,      /* Stick to the first working server. */
+    FO_POLICY_LATENCY,      /* Prefer the fastest server of a priority group. */
+    FO_POLICY_POWER_OF_TWO  /* Pick the faster one of two random servers. */
+};
+
+enum fo_rtt_type {
+    FO_RTT_CONNECT,         /* Time it took to establish a connection. */
+    FO_RTT_OPERATION        /* Time it took the server to answer a request. */
+};
+
 struct fo_ctx;
 struct fo_service;
 struct fo_server;
@@ -76,12 +88,19 @@ struct fo_server;
  *
  * The family_order member specifies the order of address families to
  * try when looking up the service.
+ *
+ * The 'policy' member specifies how a server is selected among working
+ * servers of the same priority. With the latency based policies, the
+ * 'probe_interval' member specifies how often (in seconds) a server other
+ * than the fastest one is tried so that its round-trip time stays current.
  */
 struct fo_options {
     time_t srv_retry_neg_timeout;
     time_t retry_timeout;
     int service_resolv_timeout;
     enum restrict_family family_order;
+    enum fo_policy policy;
+    time_t probe_interval;
 };
 
 /*
@@ -150,6 +169,19 @@ struct tevent_req *fo_resolve_service_send(TALLOC_CTX *mem_ctx,
 int fo_resolve_service_recv(struct tevent_req *req,
                             struct fo_server **server);
 
+/*
+ * Request a working server of the service other than the active one so that
+ * a standby connection can be established to it. The active server and the
+ * fail over state of the service are not changed. Returns ENOENT if there is
+ * no active server or no other working server. The result is received with
+ * fo_resolve_service_recv().
+ */
+struct tevent_req *fo_resolve_standby_service_send(TALLOC_CTX *mem_ctx,
+                                                   struct tevent_context *ev,
+                                                   struct resolv_ctx *resolv,
+                                                   struct fo_ctx *ctx,
+                                                   struct fo_service *service);
+
 /*
  * Set feedback about 'server'. Caller should use this to indicate a problem
  * with the server itself, not only with the service on that server. This
@@ -171,6 +203,22 @@ void fo_set_server_status(struct fo_server *server,
 void fo_set_port_status(struct fo_server *server,
                         enum port_status status);
 
+/*
+ * Feed a measured round-trip time (in microseconds) of 'server' back to the
+ * fail over code. The values are smoothed with an exponentially weighted
+ * moving average and used by the latency based selection policies.
+ */
+void fo_set_server_rtt(struct fo_server *server,
+                       enum fo_rtt_type type,
+                       uint64_t rtt_usec);
+
+/*
+ * Returns the smoothed round-trip time of 'server' in microseconds or 0
+ * if no value was measured yet. Operation round-trip times are preferred
+ * over connect round-trip times.
+ */
+uint64_t fo_get_server_rtt(struct fo_server *server);
+
 /*
  * Instruct fail-over to try next server on the next connect attempt.
  * Should be used after connection to service was unexpectedly dropped
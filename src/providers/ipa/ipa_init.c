@@ -568,6 +568,12 @@ int sssm_ipa_selinux_init(struct be_ctx *bectx,
     selinux_ctx->host_search_bases = opts->host_search_bases;
     selinux_ctx->selinux_search_bases = opts->selinux_search_bases;
 
+    ret = ipa_selinux_refresh_init(bectx, selinux_ctx);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "ipa_selinux_refresh_init failed.\n");
+        goto done;
+    }
+
     *ops = &ipa_selinux_ops;
     *pvt_data = selinux_ctx;
 
@@ -60,7 +60,8 @@ ipa_get_selinux_send(TALLOC_CTX *mem_ctx,
                      struct be_ctx *be_ctx,
                      struct sysdb_attrs *user,
                      struct sysdb_attrs *host,
-                     struct ipa_selinux_ctx *selinux_ctx);
+                     struct ipa_selinux_ctx *selinux_ctx,
+                     bool force);
 static errno_t ipa_get_selinux_recv(struct tevent_req *req,
                                     TALLOC_CTX *mem_ctx,
                                     size_t *count,
@@ -68,7 +69,8 @@ static errno_t ipa_get_selinux_recv(struct tevent_req *req,
                                     size_t *hbac_count,
                                     struct sysdb_attrs ***hbac_rules,
                                     char **default_user,
-                                    char **map_order);
+                                    char **map_order,
+                                    bool *_from_server);
 
 static struct ipa_selinux_op_ctx *
 ipa_selinux_create_op_ctx(TALLOC_CTX *mem_ctx, struct sysdb_ctx *sysdb,
@@ -102,6 +104,8 @@ struct ipa_selinux_op_ctx {
 
     struct sysdb_attrs *user;
     struct sysdb_attrs *host;
+
+    const char *applied;
 };
 
 void ipa_selinux_handler(struct be_req *be_req)
@@ -158,7 +162,7 @@ void ipa_selinux_handler(struct be_req *be_req)
     }
 
     req = ipa_get_selinux_send(be_req, be_ctx,
-                               op_ctx->user, op_ctx->host, selinux_ctx);
+                               op_ctx->user, op_ctx->host, selinux_ctx, false);
     if (req == NULL) {
         DEBUG(SSSDBG_OP_FAILURE, "Cannot initiate the search\n");
         goto fail;
@@ -217,6 +221,61 @@ done:
     return ret;
 }
 
+static errno_t
+ipa_selinux_store_config(struct sss_domain_info *ipa_domain,
+                         size_t map_count,
+                         struct sysdb_attrs **maps,
+                         const char *default_user,
+                         const char *map_order)
+{
+    struct sysdb_ctx *sysdb = ipa_domain->sysdb;
+    bool in_transaction = false;
+    errno_t ret;
+    errno_t sret;
+
+    ret = sysdb_transaction_start(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = sysdb_delete_usermaps(ipa_domain);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot delete existing maps from sysdb\n");
+        goto done;
+    }
+
+    ret = sysdb_store_selinux_config(ipa_domain, default_user, map_order);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (map_count > 0) {
+        ret = ipa_save_user_maps(sysdb, ipa_domain, map_count, maps);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = sysdb_transaction_commit(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Could not commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+    return ret;
+}
+
 static struct ipa_selinux_op_ctx *
 ipa_selinux_create_op_ctx(TALLOC_CTX *mem_ctx, struct sysdb_ctx *sysdb,
                           struct sss_domain_info *ipa_domain,
@@ -312,16 +371,79 @@ static errno_t selinux_child_recv(struct tevent_req *req);
 
 static void ipa_selinux_child_done(struct tevent_req *child_req);
 
+static const char *ipa_selinux_applied_str(TALLOC_CTX *mem_ctx,
+                                           struct selinux_child_input *sci)
+{
+    return talloc_asprintf(mem_ctx, "%s:%s:%s",
+                           sci->username, sci->seuser, sci->mls_range);
+}
+
+/* Returns ENOENT if no mapping was applied for the user yet */
+static errno_t ipa_selinux_applied_get(TALLOC_CTX *mem_ctx,
+                                       struct sss_domain_info *user_domain,
+                                       const char *username,
+                                       const char **_applied)
+{
+    const char *attrs[] = { SYSDB_SELINUX_APPLIED, NULL };
+    struct ldb_message *msg;
+    const char *applied;
+    errno_t ret;
+
+    ret = sysdb_search_user_by_name(mem_ctx, user_domain, username, attrs,
+                                    &msg);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    applied = ldb_msg_find_attr_as_string(msg, SYSDB_SELINUX_APPLIED, NULL);
+    if (applied == NULL) {
+        talloc_free(msg);
+        return ENOENT;
+    }
+
+    *_applied = talloc_strdup(mem_ctx, applied);
+    talloc_free(msg);
+    if (*_applied == NULL) {
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static errno_t ipa_selinux_applied_set(struct sss_domain_info *user_domain,
+                                       const char *username,
+                                       const char *applied)
+{
+    struct sysdb_attrs *attrs;
+    errno_t ret;
+
+    attrs = sysdb_new_attrs(NULL);
+    if (attrs == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_attrs_add_string(attrs, SYSDB_SELINUX_APPLIED, applied);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_set_user_attr(user_domain, username, attrs, SYSDB_MOD_REP);
+
+done:
+    talloc_free(attrs);
+    return ret;
+}
+
 static void ipa_selinux_handler_done(struct tevent_req *req)
 {
     struct ipa_selinux_op_ctx *op_ctx = tevent_req_callback_data(req, struct ipa_selinux_op_ctx);
     struct be_req *breq = op_ctx->be_req;
     struct be_ctx *be_ctx = be_req_get_be_ctx(breq);
-    struct sysdb_ctx *sysdb = op_ctx->ipa_domain->sysdb;
-    errno_t ret, sret;
+    errno_t ret;
     size_t map_count = 0;
     struct sysdb_attrs **maps = NULL;
-    bool in_transaction = false;
+    bool from_server = false;
+    const char *applied = NULL;
     char *default_user = NULL;
     struct pam_data *pd =
                     talloc_get_type(be_req_get_data(breq), struct pam_data);
@@ -335,44 +457,21 @@ static void ipa_selinux_handler_done(struct tevent_req *req)
 
     ret = ipa_get_selinux_recv(req, breq, &map_count, &maps,
                                &hbac_count, &hbac_rules,
-                               &default_user, &map_order);
+                               &default_user, &map_order, &from_server);
     if (ret != EOK) {
         goto fail;
     }
 
-    ret = sysdb_transaction_start(sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
-        goto fail;
-    }
-    in_transaction = true;
-
-    ret = sysdb_delete_usermaps(op_ctx->ipa_domain);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Cannot delete existing maps from sysdb\n");
-        goto fail;
-    }
-
-    ret = sysdb_store_selinux_config(op_ctx->ipa_domain,
-                                     default_user, map_order);
-    if (ret != EOK) {
-        goto fail;
-    }
-
-    if (map_count > 0) {
-        ret = ipa_save_user_maps(sysdb, op_ctx->ipa_domain, map_count, maps);
+    /* The maps read from the cache do not need to be written back */
+    if (from_server) {
+        ret = ipa_selinux_store_config(op_ctx->ipa_domain, map_count, maps,
+                                       default_user, map_order);
         if (ret != EOK) {
             goto fail;
         }
-    }
 
-    ret = sysdb_transaction_commit(sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "Could not commit transaction\n");
-        goto fail;
+        op_ctx->selinux_ctx->last_update = time(NULL);
     }
-    in_transaction = false;
 
     /* Process the maps and return list of best matches (maps with
      * highest priority). The input maps are also parent memory
@@ -402,6 +501,29 @@ static void ipa_selinux_handler_done(struct tevent_req *req)
         goto fail;
     }
 
+    op_ctx->applied = ipa_selinux_applied_str(op_ctx, sci);
+    if (op_ctx->applied == NULL) {
+        ret = ENOMEM;
+        goto fail;
+    }
+
+    /* Running the child means a semanage transaction, skip it if the
+     * user was already set up with the same mapping */
+    ret = ipa_selinux_applied_get(op_ctx, op_ctx->user_domain, pd->user,
+                                  &applied);
+    if (ret == EOK && strcmp(applied, op_ctx->applied) == 0) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "SELinux mapping of [%s] did not change, not running "
+              "selinux_child\n", pd->user);
+        pd->pam_status = PAM_SUCCESS;
+        be_req_terminate(breq, DP_ERR_OK, EOK, "Success");
+        return;
+    } else if (ret != EOK && ret != ENOENT) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot read the applied SELinux mapping [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
     /* Update the SELinux context in a privileged child as the back end is
      * running unprivileged
      */
@@ -415,12 +537,6 @@ static void ipa_selinux_handler_done(struct tevent_req *req)
     return;
 
 fail:
-    if (in_transaction) {
-        sret = sysdb_transaction_cancel(sysdb);
-        if (sret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "Could not cancel transaction\n");
-        }
-    }
     if (ret == EAGAIN) {
         be_req_terminate(breq, DP_ERR_OFFLINE, EAGAIN, "Offline");
     } else {
@@ -434,12 +550,10 @@ static void ipa_selinux_child_done(struct tevent_req *child_req)
     struct ipa_selinux_op_ctx *op_ctx;
     struct be_req *breq;
     struct pam_data *pd;
-    struct be_ctx *be_ctx;
 
     op_ctx = tevent_req_callback_data(child_req, struct ipa_selinux_op_ctx);
     breq = op_ctx->be_req;
     pd = talloc_get_type(be_req_get_data(breq), struct pam_data);
-    be_ctx = be_req_get_be_ctx(breq);
 
     ret = selinux_child_recv(child_req);
     talloc_free(child_req);
@@ -448,9 +562,13 @@ static void ipa_selinux_child_done(struct tevent_req *child_req)
         return;
     }
 
-    /* If we got here in online mode, set last_update to current time */
-    if (!be_is_offline(be_ctx)) {
-        op_ctx->selinux_ctx->last_update = time(NULL);
+    ret = ipa_selinux_applied_set(op_ctx->user_domain, pd->user,
+                                  op_ctx->applied);
+    if (ret != EOK) {
+        /* Not fatal, the child is just run again on the next login */
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot store the applied SELinux mapping [%d]: %s\n",
+              ret, sss_strerror(ret));
     }
 
     pd->pam_status = PAM_SUCCESS;
@@ -1183,6 +1301,8 @@ struct ipa_get_selinux_state {
 
     struct sysdb_attrs **hbac_rules;
     size_t hbac_rule_count;
+
+    bool from_cache;
 };
 
 static errno_t
@@ -1193,7 +1313,8 @@ ipa_get_selinux_send(TALLOC_CTX *mem_ctx,
                      struct be_ctx *be_ctx,
                      struct sysdb_attrs *user,
                      struct sysdb_attrs *host,
-                     struct ipa_selinux_ctx *selinux_ctx)
+                     struct ipa_selinux_ctx *selinux_ctx,
+                     bool force)
 {
     struct tevent_req *req;
     struct tevent_req *subreq;
@@ -1202,6 +1323,7 @@ ipa_get_selinux_send(TALLOC_CTX *mem_ctx,
     int ret = EOK;
     time_t now;
     time_t refresh_interval;
+    time_t task_period;
     struct ipa_options *ipa_options = selinux_ctx->id_ctx->ipa_options;
 
     DEBUG(SSSDBG_TRACE_FUNC, "Retrieving SELinux user mapping\n");
@@ -1219,9 +1341,16 @@ ipa_get_selinux_send(TALLOC_CTX *mem_ctx,
     DEBUG(SSSDBG_TRACE_INTERNAL, "Connection status is [%s].\n",
                                   offline ? "offline" : "online");
 
-    if (!offline) {
+    if (!offline && !force) {
         refresh_interval = dp_opt_get_int(ipa_options->basic,
                                           IPA_SELINUX_REFRESH);
+        if (selinux_ctx->refresh_task != NULL) {
+            /* The maps are kept up to date in the background */
+            task_period = be_ptask_get_period(selinux_ctx->refresh_task);
+            if (task_period > refresh_interval) {
+                refresh_interval = task_period;
+            }
+        }
         now = time(NULL);
         if (now < selinux_ctx->last_update + refresh_interval) {
             /* SELinux maps were recently updated -> force offline */
@@ -1353,6 +1482,8 @@ ipa_get_selinux_maps_offline(struct tevent_req *req)
     struct ipa_get_selinux_state *state = tevent_req_data(req,
                                                   struct ipa_get_selinux_state);
 
+    state->from_cache = true;
+
     /* read the config entry */
     ret = sysdb_search_selinux_config(state, state->be_ctx->domain,
                                       NULL, &defaults);
@@ -1609,7 +1740,8 @@ ipa_get_selinux_recv(struct tevent_req *req,
                      size_t *hbac_count,
                      struct sysdb_attrs ***hbac_rules,
                      char **default_user,
-                     char **map_order)
+                     char **map_order,
+                     bool *_from_server)
 {
     struct ipa_get_selinux_state *state =
             tevent_req_data(req, struct ipa_get_selinux_state);
@@ -1650,6 +1782,131 @@ ipa_get_selinux_recv(struct tevent_req *req,
     *hbac_count = state->hbac_rule_count;
     *hbac_rules = talloc_steal(mem_ctx, state->hbac_rules);
 
+    *_from_server = !state->from_cache;
+
+    return EOK;
+}
+
+struct ipa_selinux_refresh_state {
+    struct sss_domain_info *ipa_domain;
+    struct ipa_selinux_ctx *selinux_ctx;
+};
+
+static void ipa_selinux_refresh_done(struct tevent_req *subreq);
+
+static struct tevent_req *
+ipa_selinux_refresh_send(TALLOC_CTX *mem_ctx,
+                         struct tevent_context *ev,
+                         struct be_ctx *be_ctx,
+                         struct be_ptask *be_ptask,
+                         void *pvt)
+{
+    struct ipa_selinux_refresh_state *state;
+    struct tevent_req *subreq;
+    struct tevent_req *req;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct ipa_selinux_refresh_state);
+    if (req == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "tevent_req_create() failed\n");
+        return NULL;
+    }
+
+    state->ipa_domain = be_ctx->domain;
+    state->selinux_ctx = talloc_get_type(pvt, struct ipa_selinux_ctx);
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Refreshing SELinux maps\n");
+
+    subreq = ipa_get_selinux_send(state, be_ctx, NULL, NULL,
+                                  state->selinux_ctx, true);
+    if (subreq == NULL) {
+        tevent_req_error(req, ENOMEM);
+        tevent_req_post(req, ev);
+        return req;
+    }
+
+    tevent_req_set_callback(subreq, ipa_selinux_refresh_done, req);
+    return req;
+}
+
+static void ipa_selinux_refresh_done(struct tevent_req *subreq)
+{
+    struct ipa_selinux_refresh_state *state;
+    struct tevent_req *req;
+    size_t map_count = 0;
+    struct sysdb_attrs **maps = NULL;
+    size_t hbac_count = 0;
+    struct sysdb_attrs **hbac_rules = NULL;
+    char *default_user = NULL;
+    char *map_order = NULL;
+    bool from_server = false;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct ipa_selinux_refresh_state);
+
+    ret = ipa_get_selinux_recv(subreq, state, &map_count, &maps,
+                               &hbac_count, &hbac_rules,
+                               &default_user, &map_order, &from_server);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to refresh SELinux maps [%d]: %s\n",
+              ret, sss_strerror(ret));
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    if (from_server) {
+        ret = ipa_selinux_store_config(state->ipa_domain, map_count, maps,
+                                       default_user, map_order);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+
+        state->selinux_ctx->last_update = time(NULL);
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t ipa_selinux_refresh_recv(struct tevent_req *req)
+{
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+errno_t ipa_selinux_refresh_init(struct be_ctx *be_ctx,
+                                 struct ipa_selinux_ctx *selinux_ctx)
+{
+    time_t period;
+    errno_t ret;
+
+    period = dp_opt_get_int(selinux_ctx->id_ctx->ipa_options->basic,
+                            IPA_SELINUX_PERIODIC_REFRESH);
+    if (period <= 0) {
+        return EOK;
+    }
+
+    ret = be_ptask_create(selinux_ctx, be_ctx,
+                          period,                   /* period */
+                          0,                        /* first_delay */
+                          5,                        /* enabled delay */
+                          0,                        /* random offset */
+                          period,                   /* timeout */
+                          BE_PTASK_OFFLINE_DISABLE,
+                          0,                        /* max_backoff */
+                          ipa_selinux_refresh_send,
+                          ipa_selinux_refresh_recv,
+                          selinux_ctx, "SELinux maps refresh",
+                          &selinux_ctx->refresh_task);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Unable to initialize SELinux maps refresh periodic task\n");
+        return ret;
+    }
+
     return EOK;
 }
 
@@ -1665,4 +1922,10 @@ void ipa_selinux_handler(struct be_req *be_req)
     pd->pam_status = PAM_SUCCESS;
     be_req_terminate(be_req, DP_ERR_OK, EOK, "Success");
 }
+
+errno_t ipa_selinux_refresh_init(struct be_ctx *be_ctx,
+                                 struct ipa_selinux_ctx *selinux_ctx)
+{
+    return EOK;
+}
 #endif
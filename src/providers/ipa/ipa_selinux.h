@@ -37,6 +37,7 @@
 struct ipa_selinux_ctx {
     struct ipa_id_ctx *id_ctx;
     time_t last_update;
+    struct be_ptask *refresh_task;
 
     struct sdap_search_base **selinux_search_bases;
     struct sdap_search_base **host_search_bases;
@@ -45,4 +46,8 @@ struct ipa_selinux_ctx {
 
 void ipa_selinux_handler(struct be_req *be_req);
 
+/* Starts the background refresh of the SELinux maps if it is enabled */
+errno_t ipa_selinux_refresh_init(struct be_ctx *be_ctx,
+                                 struct ipa_selinux_ctx *selinux_ctx);
+
 #endif
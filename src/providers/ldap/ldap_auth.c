@@ -617,6 +617,274 @@ done:
     return ret;
 }
 
+/* ==Authentication-Connection-Pool======================================= */
+
+/* Each authentication needs a connection, including the StartTLS or SSL
+ * handshake, before the user can be bound. The pool keeps a few of them
+ * around. A connection is bound anonymously again before it becomes idle,
+ * so the next user starts with a connection in the same state as a new
+ * one. */
+
+struct sdap_auth_pool_conn {
+    struct sdap_auth_pool_conn *prev;
+    struct sdap_auth_pool_conn *next;
+
+    struct sdap_auth_pool *pool;
+    struct sdap_handle *sh;
+    char *uri;
+    time_t expire;
+    int uses;
+    bool is_idle;
+    bool is_busy;
+};
+
+struct sdap_auth_pool {
+    struct sdap_auth_ctx *ctx;
+    int size;
+    int max_uses;
+    int expire_timeout;
+
+    struct sdap_auth_pool_conn *idle;
+    int num_idle;
+    /* connections being established or bound anonymously */
+    int num_pending;
+    /* connections used by a running authentication */
+    int num_busy;
+};
+
+errno_t sdap_auth_pool_init(struct sdap_auth_ctx *ctx)
+{
+    struct sdap_auth_pool *pool;
+    int size;
+
+    size = dp_opt_get_int(ctx->opts->basic, SDAP_AUTH_POOL_SIZE);
+    if (size <= 0) {
+        ctx->pool = NULL;
+        return EOK;
+    }
+
+    pool = talloc_zero(ctx, struct sdap_auth_pool);
+    if (pool == NULL) {
+        return ENOMEM;
+    }
+
+    pool->ctx = ctx;
+    pool->size = size;
+    pool->max_uses = dp_opt_get_int(ctx->opts->basic,
+                                    SDAP_AUTH_POOL_MAX_USES);
+    pool->expire_timeout = dp_opt_get_int(ctx->opts->basic,
+                                          SDAP_EXPIRE_TIMEOUT);
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "Keeping up to %d connections for authentication\n", size);
+
+    ctx->pool = pool;
+    return EOK;
+}
+
+static int sdap_auth_pool_conn_destructor(struct sdap_auth_pool_conn *pconn)
+{
+    if (pconn->is_idle) {
+        DLIST_REMOVE(pconn->pool->idle, pconn);
+        pconn->pool->num_idle--;
+    }
+
+    if (pconn->is_busy) {
+        pconn->pool->num_busy--;
+    }
+
+    return 0;
+}
+
+static struct sdap_auth_pool_conn *
+sdap_auth_pool_conn_new(TALLOC_CTX *mem_ctx,
+                        struct sdap_auth_pool *pool,
+                        const char *uri)
+{
+    struct sdap_auth_pool_conn *pconn;
+
+    pconn = talloc_zero(mem_ctx, struct sdap_auth_pool_conn);
+    if (pconn == NULL) {
+        return NULL;
+    }
+
+    pconn->uri = talloc_strdup(pconn, uri);
+    if (pconn->uri == NULL) {
+        talloc_free(pconn);
+        return NULL;
+    }
+
+    pconn->pool = pool;
+    pconn->expire = time(NULL) + pool->expire_timeout;
+    talloc_set_destructor(pconn, sdap_auth_pool_conn_destructor);
+
+    return pconn;
+}
+
+static void sdap_auth_pool_add_idle(struct sdap_auth_pool_conn *pconn)
+{
+    struct sdap_auth_pool *pool = pconn->pool;
+
+    if (pool->num_idle >= pool->size || !pconn->sh->connected) {
+        talloc_free(pconn);
+        return;
+    }
+
+    talloc_steal(pool, pconn);
+    DLIST_ADD(pool->idle, pconn);
+    pconn->is_idle = true;
+    pool->num_idle++;
+}
+
+static void sdap_auth_pool_flush(struct sdap_auth_pool *pool)
+{
+    DEBUG(SSSDBG_TRACE_FUNC, "Dropping %d pooled connections\n",
+          pool->num_idle);
+
+    while (pool->idle != NULL) {
+        talloc_free(pool->idle);
+    }
+}
+
+/* Returns an idle connection to uri or NULL if there is none */
+static struct sdap_auth_pool_conn *
+sdap_auth_pool_get(struct sdap_auth_pool *pool, const char *uri)
+{
+    struct sdap_auth_pool_conn *pconn;
+    struct sdap_auth_pool_conn *next;
+    time_t now = time(NULL);
+
+    for (pconn = pool->idle; pconn != NULL; pconn = next) {
+        next = pconn->next;
+
+        /* the server closed it, it is too old or the server changed */
+        if (!pconn->sh->connected || pconn->expire <= now
+                || strcmp(pconn->uri, uri) != 0) {
+            talloc_free(pconn);
+            continue;
+        }
+
+        DLIST_REMOVE(pool->idle, pconn);
+        pconn->is_idle = false;
+        pool->num_idle--;
+        pconn->is_busy = true;
+        pool->num_busy++;
+        return pconn;
+    }
+
+    return NULL;
+}
+
+static void sdap_auth_pool_connect_done(struct tevent_req *subreq);
+
+static void sdap_auth_pool_fill(struct sdap_auth_pool *pool,
+                                struct sdap_service *service,
+                                bool use_tls)
+{
+    struct sdap_auth_pool_conn *pconn;
+    struct tevent_req *subreq;
+
+    while (pool->num_idle + pool->num_pending + pool->num_busy < pool->size) {
+        pconn = sdap_auth_pool_conn_new(pool, pool, service->uri);
+        if (pconn == NULL) {
+            return;
+        }
+
+        subreq = sdap_connect_send(pconn, pool->ctx->be->ev,
+                                   pool->ctx->opts, service->uri,
+                                   service->sockaddr, use_tls);
+        if (subreq == NULL) {
+            talloc_free(pconn);
+            return;
+        }
+
+        tevent_req_set_callback(subreq, sdap_auth_pool_connect_done, pconn);
+        pool->num_pending++;
+    }
+}
+
+static void sdap_auth_pool_connect_done(struct tevent_req *subreq)
+{
+    struct sdap_auth_pool_conn *pconn;
+    errno_t ret;
+
+    pconn = tevent_req_callback_data(subreq, struct sdap_auth_pool_conn);
+    pconn->pool->num_pending--;
+
+    ret = sdap_connect_recv(subreq, pconn, &pconn->sh);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to establish a pooled connection to [%s]\n",
+              pconn->uri);
+        talloc_free(pconn);
+        return;
+    }
+
+    /* Without StartTLS the handle is not marked as connected until the
+     * first bind, make sure a closed connection is noticed */
+    if (!pconn->sh->connected) {
+        ret = sdap_set_connected(pconn->sh, pconn->pool->ctx->be->ev);
+        if (ret != EOK) {
+            talloc_free(pconn);
+            return;
+        }
+    }
+
+    sdap_auth_pool_add_idle(pconn);
+}
+
+static void sdap_auth_pool_rebind_done(struct tevent_req *subreq);
+
+/* Takes over pconn after the user bind finished */
+static void sdap_auth_pool_put(struct sdap_auth_pool *pool,
+                               struct sdap_auth_pool_conn *pconn)
+{
+    struct tevent_req *subreq;
+
+    talloc_steal(pool, pconn);
+    pconn->is_busy = false;
+    pool->num_busy--;
+    pconn->uses++;
+
+    if ((pool->max_uses > 0 && pconn->uses >= pool->max_uses)
+            || !pconn->sh->connected
+            || pconn->expire <= time(NULL)
+            || pool->num_idle + pool->num_pending >= pool->size) {
+        talloc_free(pconn);
+        return;
+    }
+
+    subreq = sdap_anon_bind_send(pconn, pool->ctx->be->ev, pconn->sh);
+    if (subreq == NULL) {
+        talloc_free(pconn);
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sdap_auth_pool_rebind_done, pconn);
+    pool->num_pending++;
+}
+
+static void sdap_auth_pool_rebind_done(struct tevent_req *subreq)
+{
+    struct sdap_auth_pool_conn *pconn;
+    errno_t ret;
+
+    pconn = tevent_req_callback_data(subreq, struct sdap_auth_pool_conn);
+    pconn->pool->num_pending--;
+
+    ret = sdap_anon_bind_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Anonymous bind failed, dropping the connection\n");
+        talloc_free(pconn);
+        return;
+    }
+
+    sdap_auth_pool_add_idle(pconn);
+}
+
 /* ==Authenticate-User==================================================== */
 
 struct auth_state {
@@ -627,6 +895,9 @@ struct auth_state {
     struct sdap_service *sdap_service;
 
     struct sdap_handle *sh;
+    /* set if the connection is returned to the pool when done */
+    struct sdap_auth_pool_conn *pconn;
+    bool use_pool;
 
     char *dn;
     enum pwexpire pw_expire_type;
@@ -640,6 +911,7 @@ static void auth_get_dn_done(struct tevent_req *subreq);
 static void auth_do_bind(struct tevent_req *req);
 static void auth_resolve_done(struct tevent_req *subreq);
 static void auth_connect_done(struct tevent_req *subreq);
+static void auth_connected(struct tevent_req *req);
 static void auth_bind_user_done(struct tevent_req *subreq);
 
 static struct tevent_req *auth_send(TALLOC_CTX *memctx,
@@ -673,6 +945,10 @@ static struct tevent_req *auth_send(TALLOC_CTX *memctx,
         state->sdap_service = ctx->service;
     }
 
+    /* A password change needs the bound handle after the request
+     * finished, only plain authentications return it to the pool */
+    state->use_pool = (ctx->pool != NULL && !try_chpass_service);
+
     if (!auth_get_server(req)) goto fail;
 
     return req;
@@ -742,6 +1018,25 @@ static void auth_resolve_done(struct tevent_req *subreq)
         }
     }
 
+    if (state->use_pool) {
+        state->pconn = sdap_auth_pool_get(state->ctx->pool,
+                                          state->sdap_service->uri);
+        sdap_auth_pool_fill(state->ctx->pool, state->sdap_service, use_tls);
+
+        if (state->pconn != NULL) {
+            DEBUG(SSSDBG_TRACE_INTERNAL, "Using a pooled connection\n");
+            if (state->srv) {
+                be_fo_set_port_status(state->ctx->be,
+                                      state->sdap_service->name,
+                                      state->srv, PORT_WORKING);
+            }
+            talloc_steal(state, state->pconn);
+            state->sh = state->pconn->sh;
+            auth_connected(req);
+            return;
+        }
+    }
+
     subreq = sdap_connect_send(state, state->ev, state->ctx->opts,
                                state->sdap_service->uri,
                                state->sdap_service->sockaddr, use_tls);
@@ -780,6 +1075,27 @@ static void auth_connect_done(struct tevent_req *subreq)
                               state->srv, PORT_WORKING);
     }
 
+    if (state->use_pool) {
+        state->pconn = sdap_auth_pool_conn_new(state, state->ctx->pool,
+                                               state->sdap_service->uri);
+        if (state->pconn == NULL) {
+            tevent_req_error(req, ENOMEM);
+            return;
+        }
+        state->pconn->sh = talloc_steal(state->pconn, state->sh);
+        state->pconn->is_busy = true;
+        state->ctx->pool->num_busy++;
+    }
+
+    auth_connected(req);
+}
+
+static void auth_connected(struct tevent_req *req)
+{
+    struct auth_state *state = tevent_req_data(req, struct auth_state);
+    struct tevent_req *subreq;
+    int ret;
+
     ret = get_user_dn(state, state->ctx->be->domain,
                       state->ctx->opts, state->username, &state->dn,
                       &state->pw_expire_type, &state->pw_expire_data);
@@ -858,15 +1174,30 @@ static void auth_bind_user_done(struct tevent_req *subreq)
         state->pw_expire_data = ppolicy;
     }
     switch (ret) {
-    case EOK:
-        break;
     case ETIMEDOUT:
     case ERR_NETWORK_IO:
+        if (state->pconn != NULL) {
+            /* the server probably dropped all the idle connections */
+            sdap_auth_pool_flush(state->ctx->pool);
+            talloc_zfree(state->pconn);
+            state->sh = NULL;
+        }
+
         if (auth_get_server(req) == NULL) {
             tevent_req_error(req, ENOMEM);
         }
         return;
     default:
+        break;
+    }
+
+    if (state->pconn != NULL) {
+        sdap_auth_pool_put(state->ctx->pool, state->pconn);
+        state->pconn = NULL;
+        state->sh = NULL;
+    }
+
+    if (ret != EOK) {
         tevent_req_error(req, ret);
         return;
     }
@@ -68,11 +68,15 @@ struct sdap_id_ctx {
     struct sdap_server_opts *srv_opts;
 };
 
+struct sdap_auth_pool;
+
 struct sdap_auth_ctx {
     struct be_ctx *be;
     struct sdap_options *opts;
     struct sdap_service *service;
     struct sdap_service *chpass_service;
+    /* idle connections for user binds, NULL if disabled */
+    struct sdap_auth_pool *pool;
 };
 
 int sssm_ldap_id_init(struct be_ctx *bectx,
@@ -121,6 +125,8 @@ sdap_handle_acct_req_recv(struct tevent_req *req,
 /* auth */
 void sdap_pam_auth_handler(struct be_req *breq);
 
+errno_t sdap_auth_pool_init(struct sdap_auth_ctx *ctx);
+
 /* chpass */
 void sdap_pam_chpass_handler(struct be_req *breq);
 
@@ -243,7 +243,7 @@ int sssm_ldap_auth_init(struct be_ctx *bectx,
     if (ret == EOK) {
         id_ctx = talloc_get_type(data, struct sdap_id_ctx);
 
-        ctx = talloc(bectx, struct sdap_auth_ctx);
+        ctx = talloc_zero(bectx, struct sdap_auth_ctx);
         if (!ctx) return ENOMEM;
 
         ctx->be = bectx;
@@ -251,6 +251,13 @@ int sssm_ldap_auth_init(struct be_ctx *bectx,
         ctx->service = id_ctx->conn->service;
         ctx->chpass_service = NULL;
 
+        ret = sdap_auth_pool_init(ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to set up the authentication connection pool\n");
+            return ret;
+        }
+
         *ops = &sdap_auth_ops;
         *pvt_data = ctx;
     }
@@ -339,6 +346,13 @@ int sssm_ldap_access_init(struct be_ctx *bectx,
         goto done;
     }
 
+    ret = sdap_access_cache_init(access_ctx, access_ctx->id_ctx->opts->basic,
+                                 &access_ctx->cache);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sdap_access_cache_init failed.\n");
+        goto done;
+    }
+
     order = dp_opt_get_cstring(access_ctx->id_ctx->opts->basic,
                                SDAP_ACCESS_ORDER);
     if (order == NULL) {
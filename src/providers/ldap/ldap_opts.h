@@ -122,6 +122,14 @@ struct dp_option default_basic_opts[] = {
     { "ldap_min_id", DP_OPT_NUMBER, NULL_NUMBER, NULL_NUMBER},
     { "ldap_max_id", DP_OPT_NUMBER, NULL_NUMBER, NULL_NUMBER},
     { "ldap_pwdlockout_dn", DP_OPT_STRING, NULL_STRING, NULL_STRING },
+    { "ldap_connection_standby", DP_OPT_BOOL, BOOL_FALSE, BOOL_FALSE },
+    { "ldap_connection_standby_keepalive", DP_OPT_NUMBER, { .number = 60 }, NULL_NUMBER },
+    { "ldap_rootdse_cache_timeout", DP_OPT_NUMBER, { .number = 86400 }, NULL_NUMBER },
+    { "ldap_auth_pool_size", DP_OPT_NUMBER, { .number = 0 }, NULL_NUMBER },
+    { "ldap_auth_pool_max_uses", DP_OPT_NUMBER, { .number = 100 }, NULL_NUMBER },
+    { "ldap_access_cache_timeout", DP_OPT_NUMBER, { .number = 0 }, NULL_NUMBER },
+    { "ldap_access_lockout_cache_timeout", DP_OPT_NUMBER, { .number = 0 }, NULL_NUMBER },
+    { "ldap_cache_write_batch_time", DP_OPT_NUMBER, { .number = 250 }, NULL_NUMBER },
     DP_OPTION_TERMINATOR
 };
 
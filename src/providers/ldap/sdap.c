@@ -1364,6 +1364,297 @@ void sdap_steal_server_opts(struct sdap_id_ctx *id_ctx,
     id_ctx->srv_opts = talloc_move(id_ctx, srv_opts);
 }
 
+/* The USN of a server going backwards means that its database was
+ * re-initialized and all cached USN values are invalid */
+bool sdap_server_reinitialized(struct sdap_server_opts *current,
+                               struct sdap_server_opts *srv_opts)
+{
+    if (current == NULL || srv_opts == NULL) {
+        return false;
+    }
+
+    return strcmp(srv_opts->server_id, current->server_id) == 0
+            && srv_opts->supports_usn
+            && !srv_opts->last_usn_cached
+            && current->last_usn > srv_opts->last_usn;
+}
+
+/* rootDSE attributes describing what the server supports, a change of any
+ * of them requires to reconnect */
+static const char *sdap_rootdse_capability_attrs[] = {
+    SDAP_ROOTDSE_ATTR_NAMING_CONTEXTS,
+    SDAP_ROOTDSE_ATTR_DEFAULT_NAMING_CONTEXT,
+    SDAP_ROOTDSE_ATTR_AD_VERSION,
+    "supportedControl",
+    "supportedExtension",
+    "supportedFeatures",
+    "supportedLDAPVersion",
+    "supportedSASLMechanisms",
+    NULL
+};
+
+static errno_t sdap_rootdse_copy_attr(struct sysdb_attrs *src,
+                                      struct sysdb_attrs *dst,
+                                      const char *name)
+{
+    struct ldb_message_element *el;
+    errno_t ret;
+    int i;
+
+    ret = sysdb_attrs_get_el_ext(src, name, false, &el);
+    if (ret == ENOENT) {
+        return EOK;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
+    for (i = 0; i < el->num_values; i++) {
+        ret = sysdb_attrs_add_val(dst, name, &el->values[i]);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    return EOK;
+}
+
+errno_t sdap_rootdse_cache_store(struct sss_domain_info *domain,
+                                 const char *server,
+                                 struct sdap_options *opts,
+                                 struct sysdb_attrs *rootdse)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs *attrs;
+    const char *last_usn_name;
+    bool in_transaction = false;
+    errno_t sret;
+    errno_t ret;
+    int i;
+
+    if (domain == NULL || server == NULL || rootdse == NULL) {
+        return EINVAL;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    attrs = sysdb_new_attrs(tmp_ctx);
+    if (attrs == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; sdap_rootdse_capability_attrs[i] != NULL; i++) {
+        ret = sdap_rootdse_copy_attr(rootdse, attrs,
+                                     sdap_rootdse_capability_attrs[i]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    /* The last USN is needed to detect the USN scheme of the server, the
+     * cached value itself is never compared with the known one */
+    ret = sdap_rootdse_copy_attr(rootdse, attrs, SDAP_IPA_LAST_USN);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sdap_rootdse_copy_attr(rootdse, attrs, SDAP_AD_LAST_USN);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    last_usn_name = opts->gen_map[SDAP_AT_LAST_USN].name;
+    if (last_usn_name != NULL
+            && strcasecmp(last_usn_name, SDAP_IPA_LAST_USN) != 0
+            && strcasecmp(last_usn_name, SDAP_AD_LAST_USN) != 0) {
+        ret = sdap_rootdse_copy_attr(rootdse, attrs, last_usn_name);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    ret = sysdb_attrs_add_time_t(attrs, SYSDB_LAST_UPDATE, time(NULL));
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_transaction_start(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    /* replace the whole entry so that removed attributes do not linger */
+    ret = sysdb_delete_custom(domain, server, SDAP_ROOTDSE_CACHE_SUBDIR);
+    if (ret != EOK && ret != ENOENT) {
+        goto done;
+    }
+
+    ret = sysdb_store_custom(domain, server, SDAP_ROOTDSE_CACHE_SUBDIR, attrs);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_transaction_commit(domain->sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Cached rootDSE of server %s\n", server);
+
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(domain->sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
+        }
+    }
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to cache rootDSE of server %s "
+              "[%d]: %s\n", server, ret, sss_strerror(ret));
+    }
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t sdap_rootdse_cache_get(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               const char *server,
+                               uint32_t timeout,
+                               struct sysdb_attrs **_rootdse)
+{
+    TALLOC_CTX *tmp_ctx;
+    const char *attrs[] = { "*", NULL };
+    struct ldb_message **msgs;
+    struct sysdb_attrs *rootdse;
+    struct ldb_message_element *el;
+    size_t count;
+    time_t last_update;
+    errno_t ret;
+    int i;
+    int j;
+
+    if (domain == NULL || server == NULL || timeout == 0) {
+        return ENOENT;
+    }
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_search_custom_by_name(tmp_ctx, domain, server,
+                                      SDAP_ROOTDSE_CACHE_SUBDIR, attrs,
+                                      &count, &msgs);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    last_update = ldb_msg_find_attr_as_uint64(msgs[0], SYSDB_LAST_UPDATE, 0);
+    if (last_update + timeout < time(NULL)) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Cached rootDSE of server %s is expired\n", server);
+        ret = ENOENT;
+        goto done;
+    }
+
+    rootdse = sysdb_new_attrs(tmp_ctx);
+    if (rootdse == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < msgs[0]->num_elements; i++) {
+        el = &msgs[0]->elements[i];
+        if (strcasecmp(el->name, SYSDB_LAST_UPDATE) == 0) {
+            continue;
+        }
+
+        for (j = 0; j < el->num_values; j++) {
+            ret = sysdb_attrs_add_val(rootdse, el->name, &el->values[j]);
+            if (ret != EOK) {
+                goto done;
+            }
+        }
+    }
+
+    *_rootdse = talloc_steal(mem_ctx, rootdse);
+    ret = EOK;
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+static bool sdap_rootdse_el_equal(struct ldb_message_element *a,
+                                  struct ldb_message_element *b)
+{
+    int i;
+
+    if (a == NULL || a->num_values == 0) {
+        return b == NULL || b->num_values == 0;
+    }
+
+    if (b == NULL) {
+        return false;
+    }
+
+    if (a->num_values != b->num_values) {
+        return false;
+    }
+
+    for (i = 0; i < a->num_values; i++) {
+        if (ldb_msg_find_val(b, &a->values[i]) == NULL) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool sdap_rootdse_capabilities_changed(struct sysdb_attrs *old_rootdse,
+                                       struct sysdb_attrs *new_rootdse)
+{
+    struct ldb_message_element *old_el;
+    struct ldb_message_element *new_el;
+    errno_t ret;
+    int i;
+
+    if (old_rootdse == NULL || new_rootdse == NULL) {
+        return old_rootdse != new_rootdse;
+    }
+
+    for (i = 0; sdap_rootdse_capability_attrs[i] != NULL; i++) {
+        ret = sysdb_attrs_get_el_ext(old_rootdse,
+                                     sdap_rootdse_capability_attrs[i],
+                                     false, &old_el);
+        if (ret != EOK) {
+            old_el = NULL;
+        }
+
+        ret = sysdb_attrs_get_el_ext(new_rootdse,
+                                     sdap_rootdse_capability_attrs[i],
+                                     false, &new_el);
+        if (ret != EOK) {
+            new_el = NULL;
+        }
+
+        if (!sdap_rootdse_el_equal(old_el, new_el)) {
+            DEBUG(SSSDBG_TRACE_FUNC, "rootDSE attribute %s changed\n",
+                  sdap_rootdse_capability_attrs[i]);
+            return true;
+        }
+    }
+
+    return false;
+}
+
 static bool attr_is_filtered(const char *attr, const char **filter)
 {
     int i;
@@ -51,6 +51,10 @@ struct sdap_op {
     struct tevent_context *ev;
     struct sdap_msg *list;
     struct sdap_msg *last;
+
+    /* when the operation was sent, used to measure the round-trip time */
+    struct timeval start;
+    bool answered;
 };
 
 struct fd_event_item {
@@ -88,6 +92,11 @@ struct sdap_handle {
 
     struct sdap_op *ops;
 
+    /* fail over server this handle is connected to */
+    struct fo_server *srv;
+    /* round-trip time of the last answered operation in microseconds */
+    uint64_t last_op_rtt;
+
     /* during release we need to lock access to the handler
      * from the destructor to avoid recursion */
     bool destructor_lock;
@@ -231,6 +240,14 @@ enum sdap_basic_opt {
     SDAP_MIN_ID,
     SDAP_MAX_ID,
     SDAP_PWDLOCKOUT_DN,
+    SDAP_STANDBY_CONNECTION,
+    SDAP_STANDBY_KEEPALIVE,
+    SDAP_ROOTDSE_CACHE_TIMEOUT,
+    SDAP_AUTH_POOL_SIZE,
+    SDAP_AUTH_POOL_MAX_USES,
+    SDAP_ACCESS_CACHE_TIMEOUT,
+    SDAP_ACCESS_LOCKOUT_CACHE_TIMEOUT,
+    SDAP_CACHE_WRITE_BATCH_TIME,
 
     SDAP_OPTS_BASIC /* opts counter */
 };
@@ -448,6 +465,9 @@ struct sdap_server_opts {
     char *server_id;
     bool supports_usn;
     unsigned long last_usn;
+    /* last_usn comes from a cached rootDSE and may be older than the value
+     * already known, it must not be used to detect a re-initialized server */
+    bool last_usn_cached;
     char *max_user_value;
     char *max_group_value;
     char *max_service_value;
@@ -569,6 +589,25 @@ int sdap_get_server_opts_from_rootdse(TALLOC_CTX *memctx,
                                       struct sdap_server_opts **srv_opts);
 void sdap_steal_server_opts(struct sdap_id_ctx *id_ctx,
                             struct sdap_server_opts **srv_opts);
+bool sdap_server_reinitialized(struct sdap_server_opts *current,
+                               struct sdap_server_opts *srv_opts);
+
+/* Server capabilities read from the rootDSE are cached per server in sysdb
+ * so that new connections do not have to wait for the rootDSE search. */
+#define SDAP_ROOTDSE_CACHE_SUBDIR "rootdse"
+
+errno_t sdap_rootdse_cache_store(struct sss_domain_info *domain,
+                                 const char *server,
+                                 struct sdap_options *opts,
+                                 struct sysdb_attrs *rootdse);
+/* Returns ENOENT if there is no cached rootDSE or it is older than timeout */
+errno_t sdap_rootdse_cache_get(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               const char *server,
+                               uint32_t timeout,
+                               struct sysdb_attrs **_rootdse);
+bool sdap_rootdse_capabilities_changed(struct sysdb_attrs *old_rootdse,
+                                       struct sysdb_attrs *new_rootdse);
 
 char *sdap_make_oc_list(TALLOC_CTX *mem_ctx, struct sdap_attr_map *map);
 #endif /* _SDAP_H_ */
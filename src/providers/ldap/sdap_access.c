@@ -111,6 +111,8 @@ struct sdap_access_req_ctx {
     struct be_ctx *be_ctx;
     struct sss_domain_info *domain;
     struct ldb_message *user_entry;
+    /* name of the cached user entry, the key of cached decisions */
+    const char *cache_name;
     size_t current_rule;
     enum sdap_access_control_type ac_type;
 };
@@ -184,6 +186,8 @@ sdap_access_send(TALLOC_CTX *mem_ctx,
     }
 
     state->user_entry = res->msgs[0];
+    state->cache_name = ldb_msg_find_attr_as_string(state->user_entry,
+                                                    SYSDB_NAME, pd->user);
 
     ret = sdap_access_check_next_rule(state, req);
     if (ret == EAGAIN) {
@@ -219,6 +223,13 @@ static errno_t sdap_access_check_next_rule(struct sdap_access_req_ctx *state,
                   "a future release. Please migrate to %s option instead.\n",
                   LDAP_ACCESS_LOCK_NAME, LDAP_ACCESS_PPOLICY_NAME);
 
+            ret = sdap_access_cache_lookup(state->access_ctx->cache,
+                                           state->be_ctx, state->domain,
+                                           state->cache_name, LDAP_ACCESS_LOCKOUT);
+            if (ret != ENOENT) {
+                break;
+            }
+
             subreq = sdap_access_ppolicy_send(state, state->ev, state->be_ctx,
                                               state->domain,
                                               state->access_ctx,
@@ -238,6 +249,13 @@ static errno_t sdap_access_check_next_rule(struct sdap_access_req_ctx *state,
             return EAGAIN;
 
         case LDAP_ACCESS_PPOLICY:
+            ret = sdap_access_cache_lookup(state->access_ctx->cache,
+                                           state->be_ctx, state->domain,
+                                           state->cache_name, LDAP_ACCESS_PPOLICY);
+            if (ret != ENOENT) {
+                break;
+            }
+
             subreq = sdap_access_ppolicy_send(state, state->ev, state->be_ctx,
                                               state->domain,
                                               state->access_ctx,
@@ -257,6 +275,13 @@ static errno_t sdap_access_check_next_rule(struct sdap_access_req_ctx *state,
             return EAGAIN;
 
         case LDAP_ACCESS_FILTER:
+            ret = sdap_access_cache_lookup(state->access_ctx->cache,
+                                           state->be_ctx, state->domain,
+                                           state->cache_name, LDAP_ACCESS_FILTER);
+            if (ret != ENOENT) {
+                break;
+            }
+
             subreq = sdap_access_filter_send(state, state->ev, state->be_ctx,
                                              state->domain,
                                              state->access_ctx,
@@ -347,6 +372,12 @@ static void sdap_access_done(struct tevent_req *subreq)
     }
 
     talloc_zfree(subreq);
+
+    sdap_access_cache_store(state->access_ctx->cache, state->be_ctx,
+                            state->domain, state->cache_name,
+                            state->access_ctx->access_rule[state->current_rule],
+                            ret);
+
     if (ret != EOK) {
         if (ret == ERR_ACCESS_DENIED) {
             DEBUG(SSSDBG_TRACE_FUNC, "Access was denied.\n");
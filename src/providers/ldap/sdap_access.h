@@ -69,12 +69,39 @@ enum ldap_access_rule {
     LDAP_ACCESS_LAST
 };
 
+/* Online results of the rules which need a round trip to the server, kept
+ * in memory of the back end */
+struct sdap_access_cache;
+
 struct sdap_access_ctx {
     struct sdap_id_ctx *id_ctx;
     const char *filter;
     int access_rule[LDAP_ACCESS_LAST + 1];
+    struct sdap_access_cache *cache;
 };
 
+/* Sets *_cache to NULL if caching is disabled in the options */
+errno_t sdap_access_cache_init(TALLOC_CTX *mem_ctx,
+                               struct dp_option *opts,
+                               struct sdap_access_cache **_cache);
+
+/* Returns EOK or ERR_ACCESS_DENIED if a valid decision of the rule for the
+ * user is cached and ENOENT otherwise. The cache is not used offline. name
+ * is the name of the user entry in the cache. */
+errno_t sdap_access_cache_lookup(struct sdap_access_cache *cache,
+                                 struct be_ctx *be_ctx,
+                                 struct sss_domain_info *domain,
+                                 const char *name,
+                                 int rule);
+
+/* Keeps result if it is a decision made while online */
+void sdap_access_cache_store(struct sdap_access_cache *cache,
+                             struct be_ctx *be_ctx,
+                             struct sss_domain_info *domain,
+                             const char *name,
+                             int rule,
+                             errno_t result);
+
 struct tevent_req *
 sdap_access_send(TALLOC_CTX *mem_ctx,
                  struct tevent_context *ev,
@@ -0,0 +1,259 @@
+/*
+    SSSD
+
+    sdap_access_cache.c - In-memory cache of LDAP access control decisions
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <time.h>
+#include <talloc.h>
+#include <errno.h>
+
+#include "util/util.h"
+#include "providers/ldap/sdap.h"
+#include "providers/ldap/sdap_access.h"
+#include "providers/dp_backend.h"
+
+/* Expired entries are only removed once the table grows beyond this size */
+#define SDAP_ACCESS_CACHE_PURGE_COUNT 4096
+
+struct sdap_access_cache {
+    hash_table_t *table;
+    int timeout;
+    int lockout_timeout;
+};
+
+struct sdap_access_cache_entry {
+    time_t expire;
+    bool allowed;
+};
+
+errno_t sdap_access_cache_init(TALLOC_CTX *mem_ctx,
+                               struct dp_option *opts,
+                               struct sdap_access_cache **_cache)
+{
+    struct sdap_access_cache *cache;
+    int timeout;
+    int lockout_timeout;
+    errno_t ret;
+
+    timeout = dp_opt_get_int(opts, SDAP_ACCESS_CACHE_TIMEOUT);
+    lockout_timeout = dp_opt_get_int(opts, SDAP_ACCESS_LOCKOUT_CACHE_TIMEOUT);
+    if (timeout <= 0 && lockout_timeout <= 0) {
+        *_cache = NULL;
+        return EOK;
+    }
+
+    cache = talloc_zero(mem_ctx, struct sdap_access_cache);
+    if (cache == NULL) {
+        return ENOMEM;
+    }
+
+    cache->timeout = timeout > 0 ? timeout : 0;
+    cache->lockout_timeout = lockout_timeout > 0 ? lockout_timeout : 0;
+
+    ret = sss_hash_create(cache, 0, &cache->table);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sss_hash_create failed.\n");
+        talloc_free(cache);
+        return ret;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "Caching access decisions for [%d] seconds, "
+          "lockout decisions for [%d] seconds.\n",
+          cache->timeout, cache->lockout_timeout);
+
+    *_cache = cache;
+    return EOK;
+}
+
+static int sdap_access_cache_timeout(struct sdap_access_cache *cache,
+                                     int rule)
+{
+    switch (rule) {
+    case LDAP_ACCESS_FILTER:
+        return cache->timeout;
+    case LDAP_ACCESS_LOCKOUT:
+    case LDAP_ACCESS_PPOLICY:
+        return cache->lockout_timeout;
+    default:
+        return 0;
+    }
+}
+
+/* The same user may log in as "Alice" or "alice" in case-insensitive
+ * domains, both must share their decisions */
+static char *sdap_access_cache_key(TALLOC_CTX *mem_ctx,
+                                   struct sss_domain_info *domain,
+                                   const char *name,
+                                   int rule)
+{
+    char *cased_name;
+    char *key;
+
+    cased_name = sss_get_cased_name(mem_ctx, name, domain->case_sensitive);
+    if (cased_name == NULL) {
+        return NULL;
+    }
+
+    key = talloc_asprintf(mem_ctx, "%d:%s:%s", rule, domain->name,
+                          cased_name);
+    talloc_free(cased_name);
+    return key;
+}
+
+static void sdap_access_cache_purge(struct sdap_access_cache *cache,
+                                    time_t now)
+{
+    struct sdap_access_cache_entry *entry;
+    hash_entry_t *entries;
+    unsigned long count;
+    unsigned long c;
+    int hret;
+
+    hret = hash_entries(cache->table, &count, &entries);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "hash_entries failed.\n");
+        return;
+    }
+
+    for (c = 0; c < count; c++) {
+        entry = talloc_get_type(entries[c].value.ptr,
+                                struct sdap_access_cache_entry);
+        if (entry->expire > now) {
+            continue;
+        }
+
+        hret = hash_delete(cache->table, &entries[c].key);
+        if (hret != HASH_SUCCESS) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "hash_delete failed.\n");
+            continue;
+        }
+        talloc_free(entry);
+    }
+
+    talloc_free(entries);
+}
+
+errno_t sdap_access_cache_lookup(struct sdap_access_cache *cache,
+                                 struct be_ctx *be_ctx,
+                                 struct sss_domain_info *domain,
+                                 const char *name,
+                                 int rule)
+{
+    struct sdap_access_cache_entry *entry;
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+    errno_t ret;
+
+    if (cache == NULL || sdap_access_cache_timeout(cache, rule) == 0
+            || be_is_offline(be_ctx)) {
+        return ENOENT;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = sdap_access_cache_key(cache, domain, name, rule);
+    if (key.str == NULL) {
+        return ENOENT;
+    }
+
+    hret = hash_lookup(cache->table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    entry = talloc_get_type(value.ptr, struct sdap_access_cache_entry);
+    if (entry->expire <= time(NULL)) {
+        hret = hash_delete(cache->table, &key);
+        if (hret == HASH_SUCCESS) {
+            talloc_free(entry);
+        }
+        ret = ENOENT;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Using cached access decision [%s] for [%s].\n",
+          entry->allowed ? "allow" : "deny", key.str);
+    ret = entry->allowed ? EOK : ERR_ACCESS_DENIED;
+
+done:
+    talloc_free(key.str);
+    return ret;
+}
+
+void sdap_access_cache_store(struct sdap_access_cache *cache,
+                             struct be_ctx *be_ctx,
+                             struct sss_domain_info *domain,
+                             const char *name,
+                             int rule,
+                             errno_t result)
+{
+    struct sdap_access_cache_entry *entry;
+    hash_key_t key;
+    hash_value_t value;
+    time_t now;
+    int timeout;
+    int hret;
+
+    if (cache == NULL || (result != EOK && result != ERR_ACCESS_DENIED)) {
+        return;
+    }
+
+    timeout = sdap_access_cache_timeout(cache, rule);
+    if (timeout == 0 || be_is_offline(be_ctx)) {
+        /* Offline the decision comes from the sysdb cache, do not keep it */
+        return;
+    }
+
+    now = time(NULL);
+    if (hash_count(cache->table) >= SDAP_ACCESS_CACHE_PURGE_COUNT) {
+        sdap_access_cache_purge(cache, now);
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = sdap_access_cache_key(cache, domain, name, rule);
+    if (key.str == NULL) {
+        return;
+    }
+
+    if (hash_lookup(cache->table, &key, &value) == HASH_SUCCESS) {
+        entry = talloc_get_type(value.ptr, struct sdap_access_cache_entry);
+    } else {
+        entry = talloc(cache, struct sdap_access_cache_entry);
+        if (entry == NULL) {
+            goto done;
+        }
+
+        value.type = HASH_VALUE_PTR;
+        value.ptr = entry;
+        hret = hash_enter(cache->table, &key, &value);
+        if (hret != HASH_SUCCESS) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "hash_enter failed.\n");
+            talloc_free(entry);
+            goto done;
+        }
+    }
+
+    entry->expire = now + timeout;
+    entry->allowed = (result == EOK);
+
+done:
+    talloc_free(key.str);
+}
@@ -23,6 +23,7 @@
 #include <ctype.h>
 #include "util/util.h"
 #include "util/strtonum.h"
+#include "util/sss_stats.h"
 #include "providers/ldap/sdap_async_private.h"
 
 #define REPLY_REALLOC_INCREMENT 10
@@ -297,6 +298,14 @@ static void sdap_process_message(struct tevent_context *ev,
     DEBUG(SSSDBG_TRACE_ALL,
           "Message type: [%s]\n", sdap_ldap_result_str(msgtype));
 
+    if (!op->answered) {
+        struct timeval now = tevent_timeval_current();
+
+        op->answered = true;
+        sh->last_op_rtt = (now.tv_sec - op->start.tv_sec) * 1000000
+                          + now.tv_usec - op->start.tv_usec;
+    }
+
     switch (msgtype) {
     case LDAP_RES_SEARCH_ENTRY:
         /* go and process entry */
@@ -449,6 +458,7 @@ int sdap_op_add(TALLOC_CTX *memctx, struct tevent_context *ev,
     op->callback = callback;
     op->data = data;
     op->ev = ev;
+    op->start = tevent_timeval_current();
 
     /* check if we need to set a timeout */
     if (timeout) {
@@ -1152,6 +1162,9 @@ struct sdap_get_generic_ext_state {
     void *cb_data;
 
     bool allow_paging;
+
+    struct timeval start;
+    size_t num_entries;
 };
 
 static errno_t sdap_get_generic_ext_step(struct tevent_req *req);
@@ -1203,6 +1216,7 @@ sdap_get_generic_ext_send(TALLOC_CTX *memctx,
     state->parse_cb = parse_cb;
     state->cb_data = cb_data;
     state->clientctrls = clientctrls;
+    gettimeofday(&state->start, NULL);
 
     if (state->sh == NULL || state->sh->ldap == NULL) {
         DEBUG(SSSDBG_CRIT_FAILURE,
@@ -1408,6 +1422,7 @@ static void sdap_get_generic_op_finished(struct sdap_op *op,
             tevent_req_error(req, ret);
             return;
         }
+        state->num_entries++;
 
         sdap_unlock_next_reply(state->op);
         break;
@@ -1528,6 +1543,12 @@ static void sdap_get_generic_op_finished(struct sdap_op *op,
 static int
 sdap_get_generic_ext_recv(struct tevent_req *req)
 {
+    struct sdap_get_generic_ext_state *state =
+                tevent_req_data(req, struct sdap_get_generic_ext_state);
+
+    sss_stats_record_since("ldap.search", &state->start);
+    sss_stats_count("ldap.search.entries", state->num_entries);
+
     TEVENT_REQ_RETURN_ON_ERROR(req);
     return EOK;
 }
@@ -128,6 +128,12 @@ errno_t sdap_auth_recv(struct tevent_req *req,
                        TALLOC_CTX *memctx,
                        struct sdap_ppolicy_data **ppolicy);
 
+struct tevent_req *sdap_anon_bind_send(TALLOC_CTX *memctx,
+                                       struct tevent_context *ev,
+                                       struct sdap_handle *sh);
+
+errno_t sdap_anon_bind_recv(struct tevent_req *req);
+
 struct tevent_req *sdap_get_initgr_send(TALLOC_CTX *memctx,
                                         struct tevent_context *ev,
                                         struct sdap_domain *sdom,
@@ -173,6 +179,14 @@ struct tevent_req *sdap_cli_connect_send(TALLOC_CTX *memctx,
                                          bool skip_rootdse,
                                          enum connect_tls force_tls,
                                          bool skip_auth);
+/* Connect to a working server other than the active one of the service.
+ * The result is received with sdap_cli_connect_recv(). The server is not
+ * marked as working in the fail over code. */
+struct tevent_req *sdap_cli_standby_connect_send(TALLOC_CTX *memctx,
+                                                 struct tevent_context *ev,
+                                                 struct sdap_options *opts,
+                                                 struct be_ctx *be,
+                                                 struct sdap_service *service);
 int sdap_cli_connect_recv(struct tevent_req *req,
                           TALLOC_CTX *memctx,
                           bool *can_retry,
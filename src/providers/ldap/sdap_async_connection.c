@@ -1381,6 +1381,24 @@ errno_t sdap_auth_recv(struct tevent_req *req,
     return EOK;
 }
 
+/* ==Anonymous-Bind======================================================= */
+
+/* Drops the identity of the last bind on the connection, it can be used
+ * afterwards as if it was just established. */
+struct tevent_req *sdap_anon_bind_send(TALLOC_CTX *memctx,
+                                       struct tevent_context *ev,
+                                       struct sdap_handle *sh)
+{
+    static struct berval empty_pw = { 0, NULL };
+
+    return simple_bind_send(memctx, ev, sh, "", &empty_pw);
+}
+
+errno_t sdap_anon_bind_recv(struct tevent_req *req)
+{
+    return simple_bind_recv(req, NULL, NULL);
+}
+
 /* ==Client connect============================================ */
 
 struct sdap_cli_connect_state {
@@ -1391,23 +1409,36 @@ struct sdap_cli_connect_state {
 
     bool use_rootdse;
     struct sysdb_attrs *rootdse;
+    /* rootdse was read from the cache and needs to be revalidated */
+    bool rootdse_cached;
 
     struct sdap_handle *sh;
 
     struct fo_server *srv;
+    struct timeval connect_start;
+
+    /* address of the server being connected to, the service values for
+     * the active server or a locally built copy for a standby server */
+    const char *uri;
+    struct sockaddr_storage *sockaddr;
 
     struct sdap_server_opts *srv_opts;
 
     enum connect_tls force_tls;
     bool do_auth;
     bool use_tls;
+    /* connect to a server other than the active one and keep
+     * the fail over state of the service unchanged */
+    bool standby;
 };
 
 static int sdap_cli_resolve_next(struct tevent_req *req);
 static void sdap_cli_resolve_done(struct tevent_req *subreq);
 static void sdap_cli_connect_done(struct tevent_req *subreq);
 static void sdap_cli_rootdse_step(struct tevent_req *req);
+static void sdap_cli_rootdse_search(struct tevent_req *req);
 static void sdap_cli_rootdse_done(struct tevent_req *subreq);
+static void sdap_cli_rootdse_process(struct tevent_req *req);
 static errno_t sdap_cli_use_rootdse(struct sdap_cli_connect_state *state);
 static void sdap_cli_kinit_step(struct tevent_req *req);
 static void sdap_cli_kinit_done(struct tevent_req *subreq);
@@ -1416,6 +1447,7 @@ static void sdap_cli_auth_done(struct tevent_req *subreq);
 static errno_t sdap_cli_auth_reconnect(struct tevent_req *subreq);
 static void sdap_cli_auth_reconnect_done(struct tevent_req *subreq);
 static void sdap_cli_rootdse_auth_done(struct tevent_req *subreq);
+static void sdap_cli_finish(struct tevent_req *req);
 
 static errno_t
 decide_tls_usage(enum connect_tls force_tls, struct dp_option *basic,
@@ -1448,14 +1480,16 @@ decide_tls_usage(enum connect_tls force_tls, struct dp_option *basic,
     return EOK;
 }
 
-struct tevent_req *sdap_cli_connect_send(TALLOC_CTX *memctx,
-                                         struct tevent_context *ev,
-                                         struct sdap_options *opts,
-                                         struct be_ctx *be,
-                                         struct sdap_service *service,
-                                         bool skip_rootdse,
-                                         enum connect_tls force_tls,
-                                         bool skip_auth)
+static struct tevent_req *
+sdap_cli_connect_send_internal(TALLOC_CTX *memctx,
+                               struct tevent_context *ev,
+                               struct sdap_options *opts,
+                               struct be_ctx *be,
+                               struct sdap_service *service,
+                               bool skip_rootdse,
+                               enum connect_tls force_tls,
+                               bool skip_auth,
+                               bool standby)
 {
     struct sdap_cli_connect_state *state;
     struct tevent_req *req;
@@ -1473,6 +1507,7 @@ struct tevent_req *sdap_cli_connect_send(TALLOC_CTX *memctx,
     state->use_rootdse = !skip_rootdse;
     state->force_tls = force_tls;
     state->do_auth = !skip_auth;
+    state->standby = standby;
 
     ret = sdap_cli_resolve_next(req);
     if (ret) {
@@ -1482,6 +1517,101 @@ struct tevent_req *sdap_cli_connect_send(TALLOC_CTX *memctx,
     return req;
 }
 
+struct tevent_req *sdap_cli_connect_send(TALLOC_CTX *memctx,
+                                         struct tevent_context *ev,
+                                         struct sdap_options *opts,
+                                         struct be_ctx *be,
+                                         struct sdap_service *service,
+                                         bool skip_rootdse,
+                                         enum connect_tls force_tls,
+                                         bool skip_auth)
+{
+    return sdap_cli_connect_send_internal(memctx, ev, opts, be, service,
+                                          skip_rootdse, force_tls, skip_auth,
+                                          false);
+}
+
+struct tevent_req *sdap_cli_standby_connect_send(TALLOC_CTX *memctx,
+                                                 struct tevent_context *ev,
+                                                 struct sdap_options *opts,
+                                                 struct be_ctx *be,
+                                                 struct sdap_service *service)
+{
+    return sdap_cli_connect_send_internal(memctx, ev, opts, be, service,
+                                          false, CON_TLS_DFL, false, true);
+}
+
+/* The service callbacks only describe the active server, build the URI and
+ * address of a standby server here so that the service is left untouched.
+ * The scheme and default port are taken over from the active URI. */
+static errno_t sdap_cli_standby_address(TALLOC_CTX *mem_ctx,
+                                        struct sdap_service *service,
+                                        struct fo_server *srv,
+                                        const char **_uri,
+                                        struct sockaddr_storage **_sockaddr)
+{
+    LDAPURLDesc *lud = NULL;
+    struct resolv_hostent *srvaddr;
+    struct sockaddr_storage *sockaddr;
+    const char *scheme = "ldap";
+    const char *name;
+    char *uri;
+    int port;
+    int ret;
+
+    name = fo_get_server_name(srv);
+    srvaddr = fo_get_server_hostent(srv);
+    if (name == NULL || srvaddr == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "No host name or address available for server (%s)\n",
+              fo_get_server_str_name(srv));
+        return EINVAL;
+    }
+
+    port = fo_get_server_port(srv);
+
+    if (service->uri != NULL) {
+        ret = ldap_url_parse(service->uri, &lud);
+        if (ret != LDAP_SUCCESS) {
+            DEBUG(SSSDBG_OP_FAILURE,
+                  "Failed to parse ldap URI (%s)!\n", service->uri);
+            return EINVAL;
+        }
+
+        if (lud->lud_scheme != NULL && strcasecmp(lud->lud_scheme, "ldaps") == 0) {
+            scheme = "ldaps";
+        }
+        if (port == 0) {
+            port = lud->lud_port;
+        }
+        ldap_free_urldesc(lud);
+    }
+
+    if (port == 0) {
+        port = strcmp(scheme, "ldaps") == 0 ? LDAPS_PORT : LDAP_PORT;
+    }
+
+    uri = talloc_asprintf(mem_ctx, strchr(name, ':') != NULL ? "%s://[%s]:%d"
+                                                             : "%s://%s:%d",
+                          scheme, name, port);
+    if (uri == NULL) {
+        return ENOMEM;
+    }
+
+    sockaddr = resolv_get_sockaddr_address(mem_ctx, srvaddr, port);
+    if (sockaddr == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "resolv_get_sockaddr_address failed.\n");
+        talloc_free(uri);
+        return ENOMEM;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Constructed standby uri '%s'\n", uri);
+
+    *_uri = uri;
+    *_sockaddr = sockaddr;
+    return EOK;
+}
+
 static int sdap_cli_resolve_next(struct tevent_req *req)
 {
     struct sdap_cli_connect_state *state = tevent_req_data(req,
@@ -1493,9 +1623,14 @@ static int sdap_cli_resolve_next(struct tevent_req *req)
 
     /* NOTE: this call may cause service->uri to be refreshed
      * with a new valid server. Do not use service->uri before */
-    subreq = be_resolve_server_send(state, state->ev,
-                                    state->be, state->service->name,
-                                    state->srv == NULL ? true : false);
+    if (state->standby) {
+        subreq = be_resolve_standby_server_send(state, state->ev, state->be,
+                                                state->service->name);
+    } else {
+        subreq = be_resolve_server_send(state, state->ev,
+                                        state->be, state->service->name,
+                                        state->srv == NULL ? true : false);
+    }
     if (!subreq) {
         return ENOMEM;
     }
@@ -1512,7 +1647,11 @@ static void sdap_cli_resolve_done(struct tevent_req *subreq)
                                              struct sdap_cli_connect_state);
     int ret;
 
-    ret = be_resolve_server_recv(subreq, &state->srv);
+    if (state->standby) {
+        ret = be_resolve_standby_server_recv(subreq, &state->srv);
+    } else {
+        ret = be_resolve_server_recv(subreq, &state->srv);
+    }
     talloc_zfree(subreq);
     if (ret) {
         state->srv = NULL;
@@ -1522,17 +1661,36 @@ static void sdap_cli_resolve_done(struct tevent_req *subreq)
         return;
     }
 
+    if (state->standby) {
+        ret = sdap_cli_standby_address(state, state->service, state->srv,
+                                       &state->uri, &state->sockaddr);
+        if (ret != EOK) {
+            tevent_req_error(req, ret);
+            return;
+        }
+    } else {
+        /* keep a copy, the service values are replaced on every resolve */
+        state->uri = talloc_strdup(state, state->service->uri);
+        state->sockaddr = talloc_memdup(state, state->service->sockaddr,
+                                        sizeof(struct sockaddr_storage));
+        if (state->uri == NULL || state->sockaddr == NULL) {
+            tevent_req_error(req, ENOMEM);
+            return;
+        }
+    }
+
     ret = decide_tls_usage(state->force_tls, state->opts->basic,
-                           state->service->uri, &state->use_tls);
+                           state->uri, &state->use_tls);
 
     if (ret != EOK) {
         tevent_req_error(req, EINVAL);
         return;
     }
 
+    state->connect_start = tevent_timeval_current();
     subreq = sdap_connect_send(state, state->ev, state->opts,
-                               state->service->uri,
-                               state->service->sockaddr,
+                               state->uri,
+                               state->sockaddr,
                                state->use_tls);
     if (!subreq) {
         tevent_req_error(req, ENOMEM);
@@ -1548,6 +1706,7 @@ static void sdap_cli_connect_done(struct tevent_req *subreq)
     struct sdap_cli_connect_state *state = tevent_req_data(req,
                                              struct sdap_cli_connect_state);
     const char *sasl_mech;
+    struct timeval now;
     int ret;
 
     talloc_zfree(state->sh);
@@ -1564,6 +1723,12 @@ static void sdap_cli_connect_done(struct tevent_req *subreq)
         return;
     }
 
+    now = tevent_timeval_current();
+    be_fo_set_server_rtt(state->be, state->service->name, state->srv,
+                         FO_RTT_CONNECT,
+                         (now.tv_sec - state->connect_start.tv_sec) * 1000000
+                         + now.tv_usec - state->connect_start.tv_usec);
+
     if (state->use_rootdse) {
         /* fetch the rootDSE this time */
         sdap_cli_rootdse_step(req);
@@ -1591,6 +1756,40 @@ static void sdap_cli_connect_done(struct tevent_req *subreq)
 }
 
 static void sdap_cli_rootdse_step(struct tevent_req *req)
+{
+    struct sdap_cli_connect_state *state = tevent_req_data(req,
+                                             struct sdap_cli_connect_state);
+    int ret;
+
+    ret = sdap_rootdse_cache_get(state, state->be->domain, state->uri,
+                                 dp_opt_get_int(state->opts->basic,
+                                                SDAP_ROOTDSE_CACHE_TIMEOUT),
+                                 &state->rootdse);
+    if (ret == EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Using cached rootDSE of server %s\n",
+              state->uri);
+        state->rootdse_cached = true;
+
+        if (!state->sh->connected) {
+            ret = sdap_set_connected(state->sh, state->ev);
+            if (ret) {
+                tevent_req_error(req, ret);
+                return;
+            }
+        }
+
+        sdap_cli_rootdse_process(req);
+        return;
+    } else if (ret != ENOENT) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to read cached rootDSE [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+
+    sdap_cli_rootdse_search(req);
+}
+
+static void sdap_cli_rootdse_search(struct tevent_req *req)
 {
     struct sdap_cli_connect_state *state = tevent_req_data(req,
                                              struct sdap_cli_connect_state);
@@ -1616,13 +1815,25 @@ static void sdap_cli_rootdse_step(struct tevent_req *req)
     }
 }
 
+static void sdap_cli_rootdse_cache_store(struct sdap_cli_connect_state *state)
+{
+    if (state->rootdse == NULL
+            || dp_opt_get_int(state->opts->basic,
+                              SDAP_ROOTDSE_CACHE_TIMEOUT) == 0) {
+        return;
+    }
+
+    /* failing to cache the rootDSE is not fatal */
+    (void) sdap_rootdse_cache_store(state->be->domain, state->uri,
+                                    state->opts, state->rootdse);
+}
+
 static void sdap_cli_rootdse_done(struct tevent_req *subreq)
 {
     struct tevent_req *req = tevent_req_callback_data(subreq,
                                                       struct tevent_req);
     struct sdap_cli_connect_state *state = tevent_req_data(req,
                                              struct sdap_cli_connect_state);
-    const char *sasl_mech;
     int ret;
 
     ret = sdap_get_rootdse_recv(subreq, state, &state->rootdse);
@@ -1647,6 +1858,16 @@ static void sdap_cli_rootdse_done(struct tevent_req *subreq)
         state->rootdse = NULL;
     }
 
+    sdap_cli_rootdse_cache_store(state);
+    sdap_cli_rootdse_process(req);
+}
+
+static void sdap_cli_rootdse_process(struct tevent_req *req)
+{
+    struct sdap_cli_connect_state *state = tevent_req_data(req,
+                                             struct sdap_cli_connect_state);
+    const char *sasl_mech;
+    int ret;
 
     ret = sdap_cli_use_rootdse(state);
     if (ret != EOK) {
@@ -1660,6 +1881,15 @@ static void sdap_cli_rootdse_done(struct tevent_req *subreq)
     if (state->do_auth && sasl_mech && state->rootdse) {
         /* check if server claims to support GSSAPI */
         if (!sdap_is_sasl_mech_supported(state->sh, sasl_mech)) {
+            if (state->rootdse_cached) {
+                /* the cached data may be outdated, ask the server */
+                DEBUG(SSSDBG_TRACE_FUNC, "Cached rootDSE does not list "
+                      "SASL mechanism %s, reading rootDSE\n", sasl_mech);
+                state->rootdse_cached = false;
+                talloc_zfree(state->rootdse);
+                sdap_cli_rootdse_search(req);
+                return;
+            }
             tevent_req_error(req, ENOTSUP);
             return;
         }
@@ -1699,7 +1929,7 @@ static errno_t sdap_cli_use_rootdse(struct sdap_cli_connect_state *state)
     }
 
     ret = sdap_get_server_opts_from_rootdse(state,
-                                            state->service->uri,
+                                            state->uri,
                                             state->rootdse,
                                             state->opts, &state->srv_opts);
     if (ret) {
@@ -1708,6 +1938,9 @@ static errno_t sdap_cli_use_rootdse(struct sdap_cli_connect_state *state)
         return ret;
     }
 
+    /* the USN known in memory is newer than the cached one */
+    state->srv_opts->last_usn_cached = state->rootdse_cached;
+
     return EOK;
 }
 
@@ -1817,7 +2050,7 @@ static void sdap_cli_auth_step(struct tevent_req *req)
         (sasl_mech == NULL && user_dn == NULL)) {
         DEBUG(SSSDBG_TRACE_LIBS,
               "No authentication requested or SASL auth forced off\n");
-        tevent_req_done(req);
+        sdap_cli_finish(req);
         return;
     }
 
@@ -1870,14 +2103,14 @@ static errno_t sdap_cli_auth_reconnect(struct tevent_req *req)
     state = tevent_req_data(req, struct sdap_cli_connect_state);
 
     ret = decide_tls_usage(state->force_tls, state->opts->basic,
-                           state->service->uri, &state->use_tls);
+                           state->uri, &state->use_tls);
     if (ret != EOK) {
         goto done;
     }
 
     subreq = sdap_connect_send(state, state->ev, state->opts,
-                               state->service->uri,
-                               state->service->sockaddr,
+                               state->uri,
+                               state->sockaddr,
                                state->use_tls);
 
     if (subreq == NULL) {
@@ -1965,7 +2198,7 @@ static void sdap_cli_auth_done(struct tevent_req *subreq)
         return;
     }
 
-    tevent_req_done(req);
+    sdap_cli_finish(req);
 }
 
 static void sdap_cli_rootdse_auth_done(struct tevent_req *subreq)
@@ -2004,6 +2237,8 @@ static void sdap_cli_rootdse_auth_done(struct tevent_req *subreq)
     }
 
     /* We were able to get rootDSE after authentication */
+    sdap_cli_rootdse_cache_store(state);
+
     ret = sdap_cli_use_rootdse(state);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "sdap_cli_use_rootdse failed\n");
@@ -2014,6 +2249,98 @@ static void sdap_cli_rootdse_auth_done(struct tevent_req *subreq)
     tevent_req_done(req);
 }
 
+/* Background revalidation of a cached rootDSE. It is bound to the lifetime
+ * of the connection. If the capabilities of the server changed the
+ * connection is expired so that the next operation reconnects and uses the
+ * new capabilities. */
+struct sdap_rootdse_revalidate_ctx {
+    struct sdap_options *opts;
+    struct sss_domain_info *domain;
+    struct sdap_handle *sh;
+    const char *server;
+    struct sysdb_attrs *cached;
+};
+
+static void sdap_cli_rootdse_revalidate_done(struct tevent_req *subreq);
+
+static void sdap_cli_rootdse_revalidate(struct sdap_cli_connect_state *state)
+{
+    struct sdap_rootdse_revalidate_ctx *rv_ctx;
+    struct tevent_req *subreq;
+
+    rv_ctx = talloc_zero(state->sh, struct sdap_rootdse_revalidate_ctx);
+    if (rv_ctx == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc_zero() failed\n");
+        return;
+    }
+
+    rv_ctx->opts = state->opts;
+    rv_ctx->domain = state->be->domain;
+    rv_ctx->sh = state->sh;
+    rv_ctx->server = talloc_strdup(rv_ctx, state->uri);
+    rv_ctx->cached = talloc_steal(rv_ctx, state->rootdse);
+    if (rv_ctx->server == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc_strdup() failed\n");
+        talloc_free(rv_ctx);
+        return;
+    }
+
+    subreq = sdap_get_rootdse_send(rv_ctx, state->ev, state->opts, state->sh);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sdap_get_rootdse_send() failed\n");
+        talloc_free(rv_ctx);
+        return;
+    }
+    tevent_req_set_callback(subreq, sdap_cli_rootdse_revalidate_done, rv_ctx);
+}
+
+static void sdap_cli_rootdse_revalidate_done(struct tevent_req *subreq)
+{
+    struct sdap_rootdse_revalidate_ctx *rv_ctx;
+    struct sysdb_attrs *rootdse = NULL;
+    errno_t ret;
+
+    rv_ctx = tevent_req_callback_data(subreq,
+                                      struct sdap_rootdse_revalidate_ctx);
+
+    ret = sdap_get_rootdse_recv(subreq, rv_ctx, &rootdse);
+    talloc_zfree(subreq);
+    if (ret != EOK || rootdse == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to revalidate cached rootDSE of server %s\n",
+              rv_ctx->server);
+        goto done;
+    }
+
+    (void) sdap_rootdse_cache_store(rv_ctx->domain, rv_ctx->server,
+                                    rv_ctx->opts, rootdse);
+
+    if (sdap_rootdse_capabilities_changed(rv_ctx->cached, rootdse)) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "Capabilities of server %s changed, the connection will be "
+              "re-established\n", rv_ctx->server);
+        rv_ctx->sh->expire_time = time(NULL);
+    } else {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Cached rootDSE of server %s is up to date\n", rv_ctx->server);
+    }
+
+done:
+    talloc_free(rv_ctx);
+}
+
+static void sdap_cli_finish(struct tevent_req *req)
+{
+    struct sdap_cli_connect_state *state = tevent_req_data(req,
+                                             struct sdap_cli_connect_state);
+
+    if (state->rootdse_cached) {
+        sdap_cli_rootdse_revalidate(state);
+    }
+
+    tevent_req_done(req);
+}
+
 int sdap_cli_connect_recv(struct tevent_req *req,
                           TALLOC_CTX *memctx,
                           bool *can_retry,
@@ -2044,8 +2371,16 @@ int sdap_cli_connect_recv(struct tevent_req *req,
         }
         return EIO;
     } else if (state->srv) {
-        be_fo_set_port_status(state->be, state->service->name,
-                              state->srv, PORT_WORKING);
+        /* A standby server is marked as working only once the standby
+         * connection is promoted, otherwise it would become the active
+         * server of the service */
+        if (!state->standby) {
+            be_fo_set_port_status(state->be, state->service->name,
+                                  state->srv, PORT_WORKING);
+        }
+        if (state->sh != NULL) {
+            state->sh->srv = state->srv;
+        }
     }
 
     if (gsh) {
@@ -971,144 +971,336 @@ fail:
 
 /* ==Generic-Function-to-save-multiple-groups============================= */
 
-static int sdap_save_groups(TALLOC_CTX *memctx,
-                            struct sysdb_ctx *sysdb,
-                            struct sss_domain_info *dom,
-                            struct sdap_options *opts,
-                            struct sysdb_attrs **groups,
-                            int num_groups,
-                            bool populate_members,
-                            hash_table_t *ghosts,
-                            bool save_orig_member,
-                            char **_usn_value)
-{
-    TALLOC_CTX *tmpctx;
-    char *higher_usn = NULL;
-    char *usn_value;
+struct sdap_save_groups_state {
+    struct tevent_context *ev;
+    struct sysdb_ctx *sysdb;
+    struct sss_domain_info *dom;
+    struct sdap_options *opts;
+    struct sysdb_attrs **groups;
+    int num_groups;
+    bool populate_members;
+    hash_table_t *ghosts;
+    bool save_orig_member;
+
     bool twopass;
-    bool has_nesting = false;
-    int ret;
-    errno_t sret;
-    int i;
-    struct sysdb_attrs **saved_groups = NULL;
-    int nsaved_groups = 0;
+    bool has_nesting;
+    struct sysdb_attrs **saved_groups;
+    int nsaved_groups;
+    char *higher_usn;
     time_t now;
-    bool in_transaction = false;
+
+    struct sysdb_batch *batch;
+};
+
+static errno_t
+sdap_save_groups_setup(TALLOC_CTX *memctx,
+                       struct sysdb_ctx *sysdb,
+                       struct sss_domain_info *dom,
+                       struct sdap_options *opts,
+                       struct sysdb_attrs **groups,
+                       int num_groups,
+                       bool populate_members,
+                       hash_table_t *ghosts,
+                       bool save_orig_member,
+                       struct sdap_save_groups_state *state)
+{
+    errno_t ret;
 
     switch (opts->schema_type) {
     case SDAP_SCHEMA_RFC2307:
-        twopass = false;
+        state->twopass = false;
         break;
 
     case SDAP_SCHEMA_RFC2307BIS:
     case SDAP_SCHEMA_IPA_V1:
     case SDAP_SCHEMA_AD:
-        twopass = true;
-        has_nesting = true;
+        state->twopass = true;
+        state->has_nesting = true;
         break;
 
     default:
         return EINVAL;
     }
 
-    tmpctx = talloc_new(memctx);
-    if (!tmpctx) {
-        return ENOMEM;
+    state->sysdb = sysdb;
+    state->dom = dom;
+    state->opts = opts;
+    state->groups = groups;
+    state->num_groups = num_groups;
+    state->populate_members = populate_members;
+    state->ghosts = ghosts;
+    state->save_orig_member = save_orig_member;
+    state->now = time(NULL);
+
+    if (state->twopass && !populate_members) {
+        state->saved_groups = talloc_array(memctx, struct sysdb_attrs *,
+                                           num_groups);
+        if (!state->saved_groups) {
+            return ENOMEM;
+        }
     }
 
-    ret = sysdb_transaction_start(sysdb);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
-        goto done;
+    ret = sysdb_batch_create(memctx, sysdb,
+                             dp_opt_get_int(opts->basic,
+                                            SDAP_CACHE_WRITE_BATCH_TIME),
+                             &state->batch);
+    if (ret != EOK) {
+        return ret;
     }
-    in_transaction = true;
 
-    if (twopass && !populate_members) {
-        saved_groups = talloc_array(tmpctx, struct sysdb_attrs *,
-                                    num_groups);
-        if (!saved_groups) {
-            ret = ENOMEM;
-            goto done;
-        }
-    }
+    return EOK;
+}
 
-    now = time(NULL);
-    for (i = 0; i < num_groups; i++) {
-        usn_value = NULL;
+static errno_t sdap_save_groups_step(size_t idx, void *pvt)
+{
+    struct sdap_save_groups_state *state;
+    TALLOC_CTX *tmpctx;
+    char *usn_value = NULL;
+    int ret;
 
-        /* if 2 pass savemembers = false */
-        ret = sdap_save_group(tmpctx, opts, dom, groups[i],
-                              populate_members,
-                              has_nesting && save_orig_member,
-                              ghosts, &usn_value, now);
+    state = talloc_get_type(pvt, struct sdap_save_groups_state);
 
-        /* Do not fail completely on errors.
-         * Just report the failure to save and go on */
-        if (ret) {
-            DEBUG(SSSDBG_OP_FAILURE,
-                  "Failed to store group %d. Ignoring.\n", i);
-        } else {
-            DEBUG(SSSDBG_TRACE_ALL, "Group %d processed!\n", i);
-            if (twopass && !populate_members) {
-                saved_groups[nsaved_groups] = groups[i];
-                nsaved_groups++;
-            }
+    tmpctx = talloc_new(NULL);
+    if (tmpctx == NULL) {
+        return ENOMEM;
+    }
+
+    /* if 2 pass savemembers = false */
+    ret = sdap_save_group(tmpctx, state->opts, state->dom, state->groups[idx],
+                          state->populate_members,
+                          state->has_nesting && state->save_orig_member,
+                          state->ghosts, &usn_value, state->now);
+
+    /* Do not fail completely on errors.
+     * Just report the failure to save and go on */
+    if (ret) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Failed to store group %zu. Ignoring.\n", idx);
+    } else {
+        DEBUG(SSSDBG_TRACE_ALL, "Group %zu processed!\n", idx);
+        if (state->twopass && !state->populate_members) {
+            state->saved_groups[state->nsaved_groups] = state->groups[idx];
+            state->nsaved_groups++;
         }
+    }
 
-        if (usn_value) {
-            if (higher_usn) {
-                if ((strlen(usn_value) > strlen(higher_usn)) ||
-                    (strcmp(usn_value, higher_usn) > 0)) {
-                    talloc_zfree(higher_usn);
-                    higher_usn = usn_value;
-                } else {
-                    talloc_zfree(usn_value);
-                }
-            } else {
-                higher_usn = usn_value;
+    if (usn_value) {
+        if (state->higher_usn) {
+            if ((strlen(usn_value) > strlen(state->higher_usn)) ||
+                (strcmp(usn_value, state->higher_usn) > 0)) {
+                talloc_zfree(state->higher_usn);
+                state->higher_usn = talloc_steal(state, usn_value);
             }
+        } else {
+            state->higher_usn = talloc_steal(state, usn_value);
         }
     }
 
-    if (twopass && !populate_members) {
+    talloc_free(tmpctx);
+    return EOK;
+}
+
+static errno_t sdap_save_groups_grpmem_step(size_t idx, void *pvt)
+{
+    struct sdap_save_groups_state *state;
+    TALLOC_CTX *tmpctx;
+    int ret;
 
-        for (i = 0; i < nsaved_groups; i++) {
+    state = talloc_get_type(pvt, struct sdap_save_groups_state);
 
-            ret = sdap_save_grpmem(tmpctx, sysdb, opts, dom, saved_groups[i],
-                                   ghosts, now);
-            /* Do not fail completely on errors.
-             * Just report the failure to save and go on */
-            if (ret) {
-                DEBUG(SSSDBG_OP_FAILURE,
-                      "Failed to store group %d members.\n", i);
-            } else {
-                DEBUG(SSSDBG_TRACE_ALL, "Group %d members processed!\n", i);
-            }
-        }
+    tmpctx = talloc_new(NULL);
+    if (tmpctx == NULL) {
+        return ENOMEM;
     }
 
-    ret = sysdb_transaction_commit(sysdb);
+    ret = sdap_save_grpmem(tmpctx, state->sysdb, state->opts, state->dom,
+                           state->saved_groups[idx], state->ghosts,
+                           state->now);
+    /* Do not fail completely on errors.
+     * Just report the failure to save and go on */
     if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction!\n");
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Failed to store group %zu members.\n", idx);
+    } else {
+        DEBUG(SSSDBG_TRACE_ALL, "Group %zu members processed!\n", idx);
+    }
+
+    talloc_free(tmpctx);
+    return EOK;
+}
+
+/* Stores the groups in batches of transactions, see
+ * ldap_cache_write_batch_time. The members of nested groups are stored
+ * in a second pass, after all the groups exist. */
+static int sdap_save_groups(TALLOC_CTX *memctx,
+                            struct sysdb_ctx *sysdb,
+                            struct sss_domain_info *dom,
+                            struct sdap_options *opts,
+                            struct sysdb_attrs **groups,
+                            int num_groups,
+                            bool populate_members,
+                            hash_table_t *ghosts,
+                            bool save_orig_member,
+                            char **_usn_value)
+{
+    struct sdap_save_groups_state *state;
+    int ret;
+
+    state = talloc_zero(memctx, struct sdap_save_groups_state);
+    if (!state) {
+        return ENOMEM;
+    }
+
+    ret = sdap_save_groups_setup(state, sysdb, dom, opts, groups, num_groups,
+                                 populate_members, ghosts, save_orig_member,
+                                 state);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = sysdb_batch_write(state->batch, num_groups,
+                            sdap_save_groups_step, state);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to store groups!\n");
+        goto done;
+    }
+
+    ret = sysdb_batch_write(state->batch, state->nsaved_groups,
+                            sdap_save_groups_grpmem_step, state);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to store group members!\n");
         goto done;
     }
-    in_transaction = false;
 
     if (_usn_value) {
-        *_usn_value = talloc_steal(memctx, higher_usn);
+        *_usn_value = talloc_steal(memctx, state->higher_usn);
     }
 
 done:
-    if (in_transaction) {
-        sret = sysdb_transaction_cancel(sysdb);
-        if (sret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to cancel transaction\n");
-        }
-    }
-    talloc_zfree(tmpctx);
+    /* cancels the open transaction, if any */
+    talloc_free(state);
     return ret;
 }
 
+static void sdap_save_groups_written(struct tevent_req *subreq);
+static void sdap_save_groups_grpmem_written(struct tevent_req *subreq);
+
+/* The same as sdap_save_groups() but returns to the main loop between the
+ * transactions, used for enumeration */
+static struct tevent_req *
+sdap_save_groups_send(TALLOC_CTX *memctx,
+                      struct tevent_context *ev,
+                      struct sysdb_ctx *sysdb,
+                      struct sss_domain_info *dom,
+                      struct sdap_options *opts,
+                      struct sysdb_attrs **groups,
+                      int num_groups,
+                      bool populate_members,
+                      hash_table_t *ghosts,
+                      bool save_orig_member)
+{
+    struct sdap_save_groups_state *state;
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    req = tevent_req_create(memctx, &state, struct sdap_save_groups_state);
+    if (req == NULL) return NULL;
+
+    ret = sdap_save_groups_setup(state, sysdb, dom, opts, groups, num_groups,
+                                 populate_members, ghosts, save_orig_member,
+                                 state);
+    if (ret != EOK) {
+        goto fail;
+    }
+    state->ev = ev;
+
+    subreq = sysdb_batch_write_send(state, ev, state->batch, num_groups,
+                                    sdap_save_groups_step, state);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto fail;
+    }
+    tevent_req_set_callback(subreq, sdap_save_groups_written, req);
+
+    return req;
+
+fail:
+    tevent_req_error(req, ret);
+    tevent_req_post(req, ev);
+    return req;
+}
+
+static void sdap_save_groups_written(struct tevent_req *subreq)
+{
+    struct tevent_req *req;
+    struct sdap_save_groups_state *state;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_save_groups_state);
+
+    ret = sysdb_batch_write_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to store groups!\n");
+        goto fail;
+    }
+
+    subreq = sysdb_batch_write_send(state, state->ev, state->batch,
+                                    state->nsaved_groups,
+                                    sdap_save_groups_grpmem_step, state);
+    if (subreq == NULL) {
+        ret = ENOMEM;
+        goto fail;
+    }
+    tevent_req_set_callback(subreq, sdap_save_groups_grpmem_written, req);
+    return;
+
+fail:
+    /* cancels the open transaction, if any */
+    talloc_zfree(state->batch);
+    tevent_req_error(req, ret);
+}
+
+static void sdap_save_groups_grpmem_written(struct tevent_req *subreq)
+{
+    struct tevent_req *req;
+    struct sdap_save_groups_state *state;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_save_groups_state);
+
+    ret = sysdb_batch_write_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to store group members!\n");
+        talloc_zfree(state->batch);
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static int sdap_save_groups_recv(struct tevent_req *req,
+                                 TALLOC_CTX *mem_ctx,
+                                 char **_usn_value)
+{
+    struct sdap_save_groups_state *state;
+
+    state = tevent_req_data(req, struct sdap_save_groups_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    if (_usn_value) {
+        *_usn_value = talloc_steal(mem_ctx, state->higher_usn);
+    }
+
+    return EOK;
+}
+
 
 /* ==Process-Groups======================================================= */
 
@@ -1737,12 +1929,17 @@ struct sdap_get_groups_state {
 
     struct sdap_handle *ldap_sh;
     struct sdap_id_op *op;
+
+    bool in_transaction;
 };
 
 static errno_t sdap_get_groups_next_base(struct tevent_req *req);
 static void sdap_get_groups_ldap_connect_done(struct tevent_req *subreq);
 static void sdap_get_groups_process(struct tevent_req *subreq);
+static void sdap_get_groups_first_pass_done(struct tevent_req *subreq);
+static errno_t sdap_get_groups_process_members(struct tevent_req *req);
 static void sdap_get_groups_done(struct tevent_req *subreq);
+static void sdap_get_groups_saved(struct tevent_req *subreq);
 
 struct tevent_req *sdap_get_groups_send(TALLOC_CTX *memctx,
                                        struct tevent_context *ev,
@@ -2043,26 +2240,67 @@ static void sdap_get_groups_process(struct tevent_req *subreq)
         return;
     }
 
-    ret = sysdb_transaction_start(state->sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_FATAL_FAILURE, "Failed to start transaction\n");
-        tevent_req_error(req, ret);
-        return;
-    }
-
     if (state->enumeration
             && state->opts->schema_type != SDAP_SCHEMA_RFC2307
             && dp_opt_get_int(state->opts->basic, SDAP_NESTING_LEVEL) != 0) {
         DEBUG(SSSDBG_TRACE_ALL, "Saving groups without members first "
                   "to allow unrolling of nested groups.\n");
-        ret = sdap_save_groups(state, state->sysdb, state->dom, state->opts,
-                               state->groups, state->count, false,
-                               NULL, true, NULL);
-        if (ret) {
-            DEBUG(SSSDBG_OP_FAILURE, "Failed to store groups.\n");
-            tevent_req_error(req, ret);
+        subreq = sdap_save_groups_send(state, state->ev, state->sysdb,
+                                       state->dom, state->opts,
+                                       state->groups, state->count, false,
+                                       NULL, true);
+        if (!subreq) {
+            tevent_req_error(req, ENOMEM);
             return;
         }
+        tevent_req_set_callback(subreq, sdap_get_groups_first_pass_done, req);
+        return;
+    }
+
+    ret = sdap_get_groups_process_members(req);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void sdap_get_groups_first_pass_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req =
+                        tevent_req_callback_data(subreq, struct tevent_req);
+    int ret;
+
+    ret = sdap_save_groups_recv(subreq, NULL, NULL);
+    talloc_zfree(subreq);
+    if (ret) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to store groups.\n");
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = sdap_get_groups_process_members(req);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+    }
+}
+
+static errno_t sdap_get_groups_process_members(struct tevent_req *req)
+{
+    struct sdap_get_groups_state *state =
+                        tevent_req_data(req, struct sdap_get_groups_state);
+    struct tevent_req *subreq;
+    errno_t ret;
+    size_t i;
+
+    /* An enumeration stores the groups in batches of transactions at the
+     * end, a lookup of a single group is stored in one transaction because
+     * the missing members are looked up in LDAP meanwhile. */
+    if (!state->enumeration) {
+        ret = sysdb_transaction_start(state->sysdb);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Failed to start transaction\n");
+            return ret;
+        }
+        state->in_transaction = true;
     }
 
     for (i = 0; i < state->count; i++) {
@@ -2072,11 +2310,22 @@ static void sdap_get_groups_process(struct tevent_req *subreq)
                                          state->enumeration);
 
         if (!subreq) {
-            tevent_req_error(req, ENOMEM);
-            return;
+            ret = ENOMEM;
+            goto fail;
         }
         tevent_req_set_callback(subreq, sdap_get_groups_done, req);
     }
+
+    return EOK;
+
+fail:
+    if (state->in_transaction) {
+        if (sysdb_transaction_cancel(state->sysdb) != EOK) {
+            DEBUG(SSSDBG_FATAL_FAILURE, "Could not cancel sysdb transaction\n");
+        }
+        state->in_transaction = false;
+    }
+    return ret;
 }
 
 static void sdap_get_groups_done(struct tevent_req *subreq)
@@ -2092,9 +2341,13 @@ static void sdap_get_groups_done(struct tevent_req *subreq)
     ret = sdap_process_group_recv(subreq);
     talloc_zfree(subreq);
     if (ret) {
-        sysret = sysdb_transaction_cancel(state->sysdb);
-        if (sysret != EOK) {
-            DEBUG(SSSDBG_FATAL_FAILURE, "Could not cancel sysdb transaction\n");
+        if (state->in_transaction) {
+            sysret = sysdb_transaction_cancel(state->sysdb);
+            if (sysret != EOK) {
+                DEBUG(SSSDBG_FATAL_FAILURE,
+                      "Could not cancel sysdb transaction\n");
+            }
+            state->in_transaction = false;
         }
         tevent_req_error(req, ret);
         return;
@@ -2113,17 +2366,37 @@ static void sdap_get_groups_done(struct tevent_req *subreq)
          * If enumeration is on, don't overwrite orig_members as they've been
          * saved earlier.
          */
+        if (state->enumeration) {
+            subreq = sdap_save_groups_send(state, state->ev, state->sysdb,
+                                           state->dom, state->opts,
+                                           state->groups, state->count,
+                                           !state->dom->ignore_group_members,
+                                           NULL, false);
+            if (!subreq) {
+                tevent_req_error(req, ENOMEM);
+                return;
+            }
+            tevent_req_set_callback(subreq, sdap_get_groups_saved, req);
+            return;
+        }
+
         ret = sdap_save_groups(state, state->sysdb, state->dom, state->opts,
                                state->groups, state->count,
                                !state->dom->ignore_group_members, NULL,
-                               !state->enumeration,
-                               &state->higher_usn);
+                               true, &state->higher_usn);
         if (ret) {
             DEBUG(SSSDBG_OP_FAILURE, "Failed to store groups.\n");
+            sysret = sysdb_transaction_cancel(state->sysdb);
+            if (sysret != EOK) {
+                DEBUG(SSSDBG_FATAL_FAILURE,
+                      "Could not cancel sysdb transaction\n");
+            }
+            state->in_transaction = false;
             tevent_req_error(req, ret);
             return;
         }
         DEBUG(SSSDBG_TRACE_ALL, "Saving %zu Groups - Done\n", state->count);
+        state->in_transaction = false;
         sysret = sysdb_transaction_commit(state->sysdb);
         if (sysret != EOK) {
             DEBUG(SSSDBG_FATAL_FAILURE, "Couldn't commit transaction\n");
@@ -2134,6 +2407,26 @@ static void sdap_get_groups_done(struct tevent_req *subreq)
     }
 }
 
+static void sdap_get_groups_saved(struct tevent_req *subreq)
+{
+    struct tevent_req *req =
+                        tevent_req_callback_data(subreq, struct tevent_req);
+    struct sdap_get_groups_state *state =
+                        tevent_req_data(req, struct sdap_get_groups_state);
+    int ret;
+
+    ret = sdap_save_groups_recv(subreq, state, &state->higher_usn);
+    talloc_zfree(subreq);
+    if (ret) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to store groups.\n");
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_ALL, "Saving %zu Groups - Done\n", state->count);
+    tevent_req_done(req);
+}
+
 static errno_t sdap_nested_group_populate_users(TALLOC_CTX *mem_ctx,
                                                 struct sysdb_ctx *sysdb,
                                                 struct sss_domain_info *domain,
@@ -2277,10 +2570,9 @@ int sdap_get_groups_recv(struct tevent_req *req,
 
 static void sdap_nested_done(struct tevent_req *subreq)
 {
-    errno_t ret, tret;
+    errno_t ret;
     unsigned long user_count;
     unsigned long group_count;
-    bool in_transaction = false;
     struct sysdb_attrs **users = NULL;
     struct sysdb_attrs **groups = NULL;
     hash_table_t *ghosts;
@@ -2299,15 +2591,10 @@ static void sdap_nested_done(struct tevent_req *subreq)
     }
 
     /* Save all of the users first so that they are in
-     * place for the groups to add them.
+     * place for the groups to add them. Both are written in batches
+     * of transactions, the nested groups of a large group can contain
+     * many thousands of members.
      */
-    ret = sysdb_transaction_start(state->sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
-        goto fail;
-    }
-    in_transaction = true;
-
     ret = sdap_nested_group_populate_users(state, state->sysdb,
                                            state->dom, state->opts,
                                            users, user_count, &ghosts);
@@ -2322,24 +2609,11 @@ static void sdap_nested_done(struct tevent_req *subreq)
         goto fail;
     }
 
-    ret = sysdb_transaction_commit(state->sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction\n");
-        goto fail;
-    }
-    in_transaction = false;
-
     /* Processing complete */
     tevent_req_done(req);
     return;
 
 fail:
-    if (in_transaction) {
-        tret = sysdb_transaction_cancel(state->sysdb);
-        if (tret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to cancel transaction\n");
-        }
-    }
     tevent_req_error(req, ret);
 }
 
@@ -2352,7 +2626,7 @@ static errno_t sdap_nested_group_populate_users(TALLOC_CTX *mem_ctx,
                                                 hash_table_t **_ghosts)
 {
     int i;
-    errno_t ret, sret;
+    errno_t ret;
     struct ldb_message_element *el;
     const char *username;
     char *clean_orig_dn;
@@ -2370,7 +2644,7 @@ static errno_t sdap_nested_group_populate_users(TALLOC_CTX *mem_ctx,
     hash_key_t key;
     hash_value_t value;
     size_t count;
-    bool in_transaction = false;
+    struct sysdb_batch *batch;
 
     if (_ghosts == NULL) {
         return EINVAL;
@@ -2391,14 +2665,31 @@ static errno_t sdap_nested_group_populate_users(TALLOC_CTX *mem_ctx,
         goto done;
     }
 
-    ret = sysdb_transaction_start(sysdb);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction!\n");
+    ret = sysdb_batch_create(tmp_ctx, sysdb,
+                             dp_opt_get_int(opts->basic,
+                                            SDAP_CACHE_WRITE_BATCH_TIME),
+                             &batch);
+    if (ret != EOK) {
         goto done;
     }
-    in_transaction = true;
 
     for (i = 0; i < num_users; i++) {
+        /* The previous user is counted here because the loop body
+         * skips the rest of the iteration in several places. */
+        if (i > 0) {
+            ret = sysdb_batch_next(batch, NULL);
+            if (ret != EOK) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction!\n");
+                goto done;
+            }
+        }
+
+        ret = sysdb_batch_begin(batch);
+        if (ret) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction!\n");
+            goto done;
+        }
+
         ret = sysdb_attrs_get_el(users[i], SYSDB_ORIG_DN, &el);
         if (el->num_values == 0) {
             ret = EINVAL;
@@ -2485,22 +2776,18 @@ static errno_t sdap_nested_group_populate_users(TALLOC_CTX *mem_ctx,
         }
     }
 
-    ret = sysdb_transaction_commit(sysdb);
+    ret = sysdb_batch_next(batch, NULL);
+    if (ret == EOK) {
+        ret = sysdb_batch_commit(batch);
+    }
     if (ret) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction!\n");
         goto done;
     }
-    in_transaction = false;
 
     ret = EOK;
 done:
-    if (in_transaction) {
-        sret = sysdb_transaction_cancel(sysdb);
-        if (sret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Could not cancel transaction\n");
-        }
-    }
-
+    /* freeing tmp_ctx cancels the open transaction, if any */
     if (ret != EOK) {
         *_ghosts = NULL;
     } else {
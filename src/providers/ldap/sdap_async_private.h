@@ -88,13 +88,19 @@ int sdap_get_tgt_recv(struct tevent_req *req,
                       char **ccname,
                       time_t *expire_time_out);
 
-int sdap_save_users(TALLOC_CTX *memctx,
-                    struct sysdb_ctx *sysdb,
-                    struct sss_domain_info *dom,
-                    struct sdap_options *opts,
-                    struct sysdb_attrs **users,
-                    int num_users,
-                    char **_usn_value);
+/* Stores the users in batches of transactions, see
+ * ldap_cache_write_batch_time */
+struct tevent_req *sdap_save_users_send(TALLOC_CTX *memctx,
+                                        struct tevent_context *ev,
+                                        struct sysdb_ctx *sysdb,
+                                        struct sss_domain_info *dom,
+                                        struct sdap_options *opts,
+                                        struct sysdb_attrs **users,
+                                        int num_users);
+
+int sdap_save_users_recv(struct tevent_req *req,
+                         TALLOC_CTX *mem_ctx,
+                         char **_usn_value);
 
 int sdap_initgr_common_store(struct sysdb_ctx *sysdb,
                              struct sss_domain_info *domain,
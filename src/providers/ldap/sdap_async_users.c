@@ -508,89 +508,156 @@ done:
 
 /* ==Generic-Function-to-save-multiple-users============================= */
 
-int sdap_save_users(TALLOC_CTX *memctx,
-                    struct sysdb_ctx *sysdb,
-                    struct sss_domain_info *dom,
-                    struct sdap_options *opts,
-                    struct sysdb_attrs **users,
-                    int num_users,
-                    char **_usn_value)
-{
-    TALLOC_CTX *tmpctx;
-    char *higher_usn = NULL;
-    char *usn_value;
-    int ret;
-    errno_t sret;
-    int i;
+struct sdap_save_users_state {
+    struct sss_domain_info *dom;
+    struct sdap_options *opts;
+    struct sysdb_attrs **users;
+    struct sysdb_batch *batch;
+
+    char *higher_usn;
     time_t now;
-    bool in_transaction = false;
+};
+
+static errno_t sdap_save_users_step(size_t idx, void *pvt);
+static void sdap_save_users_done(struct tevent_req *subreq);
+
+struct tevent_req *sdap_save_users_send(TALLOC_CTX *memctx,
+                                        struct tevent_context *ev,
+                                        struct sysdb_ctx *sysdb,
+                                        struct sss_domain_info *dom,
+                                        struct sdap_options *opts,
+                                        struct sysdb_attrs **users,
+                                        int num_users)
+{
+    struct sdap_save_users_state *state;
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    errno_t ret;
+
+    req = tevent_req_create(memctx, &state, struct sdap_save_users_state);
+    if (req == NULL) return NULL;
+
+    state->dom = dom;
+    state->opts = opts;
+    state->users = users;
+    state->now = time(NULL);
 
     if (num_users == 0) {
         /* Nothing to do if there are no users */
-        return EOK;
+        ret = EOK;
+        goto done;
     }
 
-    tmpctx = talloc_new(memctx);
-    if (!tmpctx) {
-        return ENOMEM;
+    ret = sysdb_batch_create(state, sysdb,
+                             dp_opt_get_int(opts->basic,
+                                            SDAP_CACHE_WRITE_BATCH_TIME),
+                             &state->batch);
+    if (ret != EOK) {
+        goto done;
     }
 
-    ret = sysdb_transaction_start(sysdb);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to start transaction\n");
+    subreq = sysdb_batch_write_send(state, ev, state->batch, num_users,
+                                    sdap_save_users_step, state);
+    if (subreq == NULL) {
+        ret = ENOMEM;
         goto done;
     }
-    in_transaction = true;
+    tevent_req_set_callback(subreq, sdap_save_users_done, req);
 
-    now = time(NULL);
-    for (i = 0; i < num_users; i++) {
-        usn_value = NULL;
+    return req;
 
-        ret = sdap_save_user(tmpctx, opts, dom, users[i], &usn_value, now);
+done:
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, ev);
+    return req;
+}
 
-        /* Do not fail completely on errors.
-         * Just report the failure to save and go on */
-        if (ret) {
-            DEBUG(SSSDBG_OP_FAILURE, "Failed to store user %d. Ignoring.\n", i);
-        } else {
-            DEBUG(SSSDBG_TRACE_ALL, "User %d processed!\n", i);
-        }
+static errno_t sdap_save_users_step(size_t idx, void *pvt)
+{
+    struct sdap_save_users_state *state;
+    TALLOC_CTX *tmpctx;
+    char *usn_value = NULL;
+    int ret;
+
+    state = talloc_get_type(pvt, struct sdap_save_users_state);
+
+    tmpctx = talloc_new(state);
+    if (tmpctx == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sdap_save_user(tmpctx, state->opts, state->dom, state->users[idx],
+                         &usn_value, state->now);
+
+    /* Do not fail completely on errors.
+     * Just report the failure to save and go on */
+    if (ret) {
+        DEBUG(SSSDBG_OP_FAILURE, "Failed to store user %zu. Ignoring.\n", idx);
+    } else {
+        DEBUG(SSSDBG_TRACE_ALL, "User %zu processed!\n", idx);
+    }
 
-        if (usn_value) {
-            if (higher_usn) {
-                if ((strlen(usn_value) > strlen(higher_usn)) ||
-                    (strcmp(usn_value, higher_usn) > 0)) {
-                    talloc_zfree(higher_usn);
-                    higher_usn = usn_value;
-                } else {
-                    talloc_zfree(usn_value);
-                }
-            } else {
-                higher_usn = usn_value;
+    if (usn_value) {
+        if (state->higher_usn) {
+            if ((strlen(usn_value) > strlen(state->higher_usn)) ||
+                (strcmp(usn_value, state->higher_usn) > 0)) {
+                talloc_zfree(state->higher_usn);
+                state->higher_usn = usn_value;
             }
+        } else {
+            state->higher_usn = usn_value;
         }
     }
 
-    ret = sysdb_transaction_commit(sysdb);
-    if (ret) {
+    talloc_steal(state, state->higher_usn);
+    talloc_free(tmpctx);
+    return EOK;
+}
+
+static void sdap_save_users_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req;
+    struct sdap_save_users_state *state;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sdap_save_users_state);
+
+    ret = sysdb_batch_write_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to commit transaction!\n");
-        goto done;
+        /* cancels the open transaction, if any */
+        talloc_zfree(state->batch);
+        tevent_req_error(req, ret);
+        return;
     }
-    in_transaction = false;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Stored %zu users\n",
+          sysdb_batch_written(state->batch));
+
+    tevent_req_done(req);
+}
+
+int sdap_save_users_recv(struct tevent_req *req,
+                         TALLOC_CTX *mem_ctx,
+                         char **_usn_value)
+{
+    struct sdap_save_users_state *state;
+
+    state = tevent_req_data(req, struct sdap_save_users_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
 
     if (_usn_value) {
-        *_usn_value = talloc_steal(memctx, higher_usn);
+        *_usn_value = talloc_steal(mem_ctx, state->higher_usn);
     }
 
-done:
-    if (in_transaction) {
-        sret = sysdb_transaction_cancel(sysdb);
-        if (sret != EOK) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Failed to cancel transaction\n");
-        }
-    }
-    talloc_zfree(tmpctx);
-    return ret;
+    return EOK;
 }
 
 
@@ -806,6 +873,7 @@ int sdap_search_user_recv(TALLOC_CTX *memctx, struct tevent_req *req,
 
 /* ==Search-And-Save-Users-with-filter============================================= */
 struct sdap_get_users_state {
+    struct tevent_context *ev;
     struct sysdb_ctx *sysdb;
     struct sdap_options *opts;
     struct sss_domain_info *dom;
@@ -816,6 +884,7 @@ struct sdap_get_users_state {
 };
 
 static void sdap_get_users_done(struct tevent_req *subreq);
+static void sdap_get_users_saved(struct tevent_req *subreq);
 
 struct tevent_req *sdap_get_users_send(TALLOC_CTX *memctx,
                                        struct tevent_context *ev,
@@ -837,6 +906,7 @@ struct tevent_req *sdap_get_users_send(TALLOC_CTX *memctx,
     req = tevent_req_create(memctx, &state, struct sdap_get_users_state);
     if (!req) return NULL;
 
+    state->ev = ev;
     state->sysdb = sysdb;
     state->opts = opts;
     state->dom = dom;
@@ -875,16 +945,40 @@ static void sdap_get_users_done(struct tevent_req *subreq)
         return;
     }
 
-    ret = sdap_save_users(state, state->sysdb,
-                          state->dom, state->opts,
-                          state->users, state->count,
-                          &state->higher_usn);
+    talloc_zfree(subreq);
+
+    subreq = sdap_save_users_send(state, state->ev, state->sysdb,
+                                  state->dom, state->opts,
+                                  state->users, state->count);
+    if (subreq == NULL) {
+        tevent_req_error(req, ENOMEM);
+        return;
+    }
+    tevent_req_set_callback(subreq, sdap_get_users_saved, req);
+}
+
+static void sdap_get_users_saved(struct tevent_req *subreq)
+{
+    struct tevent_req *req = tevent_req_callback_data(subreq,
+                                                      struct tevent_req);
+    struct sdap_get_users_state *state = tevent_req_data(req,
+                                            struct sdap_get_users_state);
+    char *higher_usn = NULL;
+    int ret;
+
+    ret = sdap_save_users_recv(subreq, state, &higher_usn);
+    talloc_zfree(subreq);
     if (ret) {
         DEBUG(SSSDBG_OP_FAILURE, "Failed to store users.\n");
         tevent_req_error(req, ret);
         return;
     }
 
+    if (higher_usn != NULL) {
+        talloc_free(state->higher_usn);
+        state->higher_usn = higher_usn;
+    }
+
     DEBUG(SSSDBG_TRACE_ALL, "Saving %zu Users - Done\n", state->count);
 
     tevent_req_done(req);
@@ -34,6 +34,13 @@ struct sdap_id_conn_cache {
     struct sdap_id_conn_data *connections;
     /* cached (current) connection */
     struct sdap_id_conn_data *cached_connection;
+
+    /* pre-established connection to the next fail over server */
+    struct sdap_id_conn_data *standby_connection;
+    /* timer to establish or check the standby connection */
+    struct tevent_timer *standby_timer;
+    /* the cached connection failed, switch to the standby one */
+    bool promote_standby;
 };
 
 /* LDAP async operation tracker:
@@ -76,6 +83,8 @@ struct sdap_id_conn_data {
      * connection will be disconnected and should
      * not be used any more */
     bool disconnecting;
+    /* server options of a standby connection, used once it is promoted */
+    struct sdap_server_opts *srv_opts;
 };
 
 static void sdap_id_conn_cache_be_offline_cb(void *pvt);
@@ -100,6 +109,10 @@ static int sdap_id_op_connect_state_destroy(void *pvt);
 static int sdap_id_op_connect_step(struct tevent_req *req);
 static void sdap_id_op_connect_done(struct tevent_req *subreq);
 
+static void sdap_id_conn_cache_standby_start(struct sdap_id_conn_cache *conn_cache);
+static void sdap_id_conn_cache_standby_release(struct sdap_id_conn_cache *conn_cache);
+static bool sdap_id_conn_cache_promote_standby(struct sdap_id_conn_cache *conn_cache);
+
 /* Create a connection cache */
 int sdap_id_conn_cache_create(TALLOC_CTX *memctx,
                               struct sdap_id_ctx *id_ctx,
@@ -152,6 +165,8 @@ static void sdap_id_conn_cache_be_offline_cb(void *pvt)
         conn_cache->cached_connection = NULL;
         sdap_id_release_conn_data(cached_connection);
     }
+
+    sdap_id_conn_cache_standby_release(conn_cache);
 }
 
 /* Callback for attempt to reconnect to primary server */
@@ -288,6 +303,267 @@ static void sdap_id_conn_data_expire_handler(struct tevent_context *ev,
     }
 }
 
+/* Standby connection handling
+ *
+ * If enabled, a second connection to the next fail over candidate is kept
+ * established and checked with a cheap rootDSE search every
+ * ldap_connection_standby_keepalive seconds. When the cached connection
+ * fails, the standby connection is promoted to be the cached one instead of
+ * going through resolving, connecting, TLS and binding again, and a new
+ * standby connection is established in the background.
+ */
+static void sdap_id_conn_cache_standby_connect(struct sdap_id_conn_cache *conn_cache);
+static void sdap_id_conn_cache_standby_connect_done(struct tevent_req *subreq);
+static void sdap_id_conn_cache_standby_keepalive(struct sdap_id_conn_cache *conn_cache);
+static void sdap_id_conn_cache_standby_keepalive_done(struct tevent_req *subreq);
+
+static bool sdap_id_conn_cache_standby_enabled(struct sdap_id_conn_cache *conn_cache)
+{
+    return dp_opt_get_bool(conn_cache->id_conn->id_ctx->opts->basic,
+                           SDAP_STANDBY_CONNECTION);
+}
+
+static void sdap_id_conn_cache_standby_handler(struct tevent_context *ev,
+                                               struct tevent_timer *te,
+                                               struct timeval current_time,
+                                               void *pvt)
+{
+    struct sdap_id_conn_cache *conn_cache = talloc_get_type(pvt,
+                                                struct sdap_id_conn_cache);
+
+    conn_cache->standby_timer = NULL;
+
+    if (be_is_offline(conn_cache->id_conn->id_ctx->be)) {
+        return;
+    }
+
+    if (conn_cache->standby_connection == NULL) {
+        sdap_id_conn_cache_standby_connect(conn_cache);
+    } else if (conn_cache->standby_connection->connect_req == NULL) {
+        sdap_id_conn_cache_standby_keepalive(conn_cache);
+    }
+}
+
+static void sdap_id_conn_cache_standby_schedule(struct sdap_id_conn_cache *conn_cache,
+                                                int delay)
+{
+    struct timeval tv;
+
+    talloc_zfree(conn_cache->standby_timer);
+
+    tv = tevent_timeval_current_ofs(delay, 0);
+    conn_cache->standby_timer =
+              tevent_add_timer(conn_cache->id_conn->id_ctx->be->ev,
+                               conn_cache, tv,
+                               sdap_id_conn_cache_standby_handler,
+                               conn_cache);
+    if (conn_cache->standby_timer == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to schedule standby connection\n");
+    }
+}
+
+/* Start maintaining the standby connection if enabled and not running yet */
+static void sdap_id_conn_cache_standby_start(struct sdap_id_conn_cache *conn_cache)
+{
+    if (!sdap_id_conn_cache_standby_enabled(conn_cache)
+            || conn_cache->standby_connection != NULL
+            || conn_cache->standby_timer != NULL) {
+        return;
+    }
+
+    sdap_id_conn_cache_standby_schedule(conn_cache, 0);
+}
+
+static void sdap_id_conn_cache_standby_release(struct sdap_id_conn_cache *conn_cache)
+{
+    talloc_zfree(conn_cache->standby_timer);
+
+    if (conn_cache->standby_connection != NULL) {
+        DEBUG(SSSDBG_TRACE_ALL, "releasing standby connection\n");
+        talloc_zfree(conn_cache->standby_connection);
+    }
+}
+
+static void sdap_id_conn_cache_standby_connect(struct sdap_id_conn_cache *conn_cache)
+{
+    struct sdap_id_ctx *id_ctx = conn_cache->id_conn->id_ctx;
+    struct sdap_id_conn_data *conn_data;
+    struct tevent_req *subreq;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Establishing standby connection\n");
+
+    conn_data = talloc_zero(conn_cache, struct sdap_id_conn_data);
+    if (conn_data == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc_zero() failed\n");
+        return;
+    }
+
+    talloc_set_destructor(conn_data, sdap_id_conn_data_destroy);
+    conn_data->conn_cache = conn_cache;
+
+    subreq = sdap_cli_standby_connect_send(conn_data, id_ctx->be->ev,
+                                           id_ctx->opts, id_ctx->be,
+                                           conn_cache->id_conn->service);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sdap_cli_standby_connect_send() failed\n");
+        talloc_free(conn_data);
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sdap_id_conn_cache_standby_connect_done,
+                            conn_data);
+    conn_data->connect_req = subreq;
+    conn_cache->standby_connection = conn_data;
+}
+
+static void sdap_id_conn_cache_standby_connect_done(struct tevent_req *subreq)
+{
+    struct sdap_id_conn_data *conn_data =
+                tevent_req_callback_data(subreq, struct sdap_id_conn_data);
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    int keepalive;
+    int ret;
+
+    ret = sdap_cli_connect_recv(subreq, conn_data, NULL,
+                                &conn_data->sh, &conn_data->srv_opts);
+    conn_data->connect_req = NULL;
+    talloc_zfree(subreq);
+
+    if (ret == EOK && (!conn_data->sh || !conn_data->sh->connected)) {
+        ret = EFAULT;
+    }
+
+    keepalive = dp_opt_get_int(conn_cache->id_conn->id_ctx->opts->basic,
+                               SDAP_STANDBY_KEEPALIVE);
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "No standby connection available [%d]: %s\n",
+              ret, sss_strerror(ret));
+        conn_cache->standby_connection = NULL;
+        talloc_free(conn_data);
+    } else {
+        DEBUG(SSSDBG_TRACE_FUNC, "Standby connection established\n");
+    }
+
+    sdap_id_conn_cache_standby_schedule(conn_cache, keepalive);
+}
+
+static void sdap_id_conn_cache_standby_keepalive(struct sdap_id_conn_cache *conn_cache)
+{
+    struct sdap_id_conn_data *conn_data = conn_cache->standby_connection;
+    struct sdap_options *opts = conn_cache->id_conn->id_ctx->opts;
+    struct tevent_req *subreq;
+    const char *attrs[] = { "supportedLDAPVersion", NULL };
+    int timeout;
+
+    timeout = dp_opt_get_int(opts->basic, SDAP_OPT_TIMEOUT)
+              + dp_opt_get_int(opts->basic, SDAP_STANDBY_KEEPALIVE);
+    if (conn_data->disconnecting
+            || sdap_is_connection_expired(conn_data, timeout)) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Standby connection is about to expire, re-establishing\n");
+        talloc_zfree(conn_cache->standby_connection);
+        sdap_id_conn_cache_standby_connect(conn_cache);
+        return;
+    }
+
+    subreq = sdap_get_generic_send(conn_data,
+                                   conn_cache->id_conn->id_ctx->be->ev,
+                                   opts, conn_data->sh,
+                                   "", LDAP_SCOPE_BASE, "(objectclass=*)",
+                                   attrs, NULL, 0,
+                                   dp_opt_get_int(opts->basic,
+                                                  SDAP_SEARCH_TIMEOUT),
+                                   false);
+    if (subreq == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "sdap_get_generic_send() failed\n");
+        return;
+    }
+
+    tevent_req_set_callback(subreq, sdap_id_conn_cache_standby_keepalive_done,
+                            conn_data);
+}
+
+static void sdap_id_conn_cache_standby_keepalive_done(struct tevent_req *subreq)
+{
+    struct sdap_id_conn_data *conn_data =
+                tevent_req_callback_data(subreq, struct sdap_id_conn_data);
+    struct sdap_id_conn_cache *conn_cache = conn_data->conn_cache;
+    struct sysdb_attrs **reply = NULL;
+    size_t reply_count;
+    int ret;
+
+    ret = sdap_get_generic_recv(subreq, conn_data, &reply_count, &reply);
+    talloc_zfree(subreq);
+    talloc_free(reply);
+
+    if (conn_cache->standby_connection != conn_data) {
+        /* promoted in the meantime */
+        return;
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Standby connection is broken [%d]: %s, re-establishing\n",
+              ret, sss_strerror(ret));
+        talloc_zfree(conn_cache->standby_connection);
+        sdap_id_conn_cache_standby_schedule(conn_cache, 0);
+        return;
+    }
+
+    sdap_id_conn_cache_standby_schedule(conn_cache,
+                        dp_opt_get_int(conn_cache->id_conn->id_ctx->opts->basic,
+                                       SDAP_STANDBY_KEEPALIVE));
+}
+
+/* Replace the failed cached connection with the standby one */
+static bool sdap_id_conn_cache_promote_standby(struct sdap_id_conn_cache *conn_cache)
+{
+    struct sdap_id_conn_data *conn_data = conn_cache->standby_connection;
+    struct sdap_id_ctx *id_ctx = conn_cache->id_conn->id_ctx;
+    int ret;
+
+    if (!conn_cache->promote_standby) {
+        return false;
+    }
+    conn_cache->promote_standby = false;
+
+    if (conn_data == NULL || conn_data->connect_req != NULL
+            || !sdap_can_reuse_connection(conn_data)) {
+        return false;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Promoting standby connection to server %s\n",
+          conn_data->sh->srv ? fo_get_server_str_name(conn_data->sh->srv)
+                             : "(unknown)");
+
+    conn_cache->standby_connection = NULL;
+    DLIST_ADD(conn_cache->connections, conn_data);
+    conn_cache->cached_connection = conn_data;
+
+    /* Make the standby server the active server of the service */
+    if (conn_data->sh->srv != NULL) {
+        be_fo_set_port_status(id_ctx->be, conn_cache->id_conn->service->name,
+                              conn_data->sh->srv, PORT_WORKING);
+    }
+
+    if (conn_data->srv_opts != NULL) {
+        sdap_steal_server_opts(id_ctx, &conn_data->srv_opts);
+    }
+
+    ret = sdap_id_conn_data_set_expire_timer(conn_data);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to set expiration timer of promoted connection\n");
+    }
+
+    /* Prepare a new standby connection */
+    sdap_id_conn_cache_standby_schedule(conn_cache, 0);
+
+    return true;
+}
+
 /* Create an operation object */
 struct sdap_id_op *sdap_id_op_create(TALLOC_CTX *memctx, struct sdap_id_conn_cache *conn_cache)
 {
@@ -481,6 +757,12 @@ static int sdap_id_op_connect_step(struct tevent_req *req)
         sdap_id_release_conn_data(conn_data);
     }
 
+    if (sdap_id_conn_cache_promote_standby(conn_cache)) {
+        DEBUG(SSSDBG_TRACE_ALL, "using promoted standby connection\n");
+        sdap_id_op_hook_conn_data(op, conn_cache->cached_connection);
+        goto done;
+    }
+
     DEBUG(SSSDBG_TRACE_ALL, "beginning to connect\n");
 
     conn_data = talloc_zero(conn_cache, struct sdap_id_conn_data);
@@ -557,6 +839,9 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
         ret = EFAULT;
     }
 
+    /* Retries may use the standby connection */
+    conn_cache->promote_standby = (ret != EOK);
+
     if (ret != EOK && !can_retry) {
         if (conn_cache->id_conn->ignore_mark_offline) {
             DEBUG(SSSDBG_TRACE_FUNC,
@@ -578,9 +863,7 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
             DEBUG(SSSDBG_TRACE_INTERNAL,
                   "Old USN: %lu, New USN: %lu\n", current_srv_opts->last_usn, srv_opts->last_usn);
 
-            if (strcmp(srv_opts->server_id, current_srv_opts->server_id) == 0 &&
-                srv_opts->supports_usn &&
-                current_srv_opts->last_usn > srv_opts->last_usn) {
+            if (sdap_server_reinitialized(current_srv_opts, srv_opts)) {
                 DEBUG(SSSDBG_FUNC_DATA, "Server was probably re-initialized\n");
 
                 current_srv_opts->max_user_value = 0;
@@ -679,6 +962,10 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
                 if (retry_ret != EOK) {
                     can_retry = false;
                     sdap_id_op_connect_req_complete(op, DP_ERR_FATAL, retry_ret);
+                } else if (op->conn_data && !op->conn_data->connect_req) {
+                    /* reused an established (e.g. promoted standby)
+                     * connection, nothing else will notify the op */
+                    sdap_id_op_connect_req_complete(op, DP_ERR_OK, EOK);
                 }
 
                 continue;
@@ -715,6 +1002,8 @@ static void sdap_id_op_connect_done(struct tevent_req *subreq)
         be_run_unconditional_online_cb(conn_cache->id_conn->id_ctx->be);
         be_run_online_cb(conn_cache->id_conn->id_ctx->be);
 
+        sdap_id_conn_cache_standby_start(conn_cache);
+
     } else {
         if (conn_cache->cached_connection == conn_data) {
             conn_cache->cached_connection = NULL;
@@ -824,6 +1113,7 @@ int sdap_id_op_done(struct sdap_id_op *op, int retval, int *dp_err_out)
             && current_conn == op->conn_cache->cached_connection) {
         /* do not reuse failed connection */
         op->conn_cache->cached_connection = NULL;
+        op->conn_cache->promote_standby = true;
 
         DEBUG(SSSDBG_FUNC_DATA,
               "communication error on cached connection, moving to next server\n");
@@ -864,6 +1154,16 @@ int sdap_id_op_done(struct sdap_id_op *op, int retval, int *dp_err_out)
         op->reconnect_retry_count = 0;
     }
 
+    if (retval == EOK && current_conn != NULL && current_conn->sh != NULL
+            && current_conn->sh->srv != NULL
+            && current_conn->sh->last_op_rtt != 0) {
+        be_fo_set_server_rtt(op->conn_cache->id_conn->id_ctx->be,
+                             op->conn_cache->id_conn->service->name,
+                             current_conn->sh->srv, FO_RTT_OPERATION,
+                             current_conn->sh->last_op_rtt);
+        current_conn->sh->last_op_rtt = 0;
+    }
+
     if (current_conn) {
         DEBUG(SSSDBG_TRACE_ALL, "releasing operation connection\n");
         sdap_id_op_hook_conn_data(op, NULL);
@@ -58,6 +58,7 @@ struct data_provider_iface pc_methods = {
     .hostHandler = NULL,
     .getDomains = NULL,
     .getAccountInfo = NULL,
+    .getAccountInfoMulti = NULL,
 };
 
 struct pc_ctx {
@@ -38,6 +38,7 @@ static struct data_provider_iface proxy_methods = {
     .hostHandler = NULL,
     .getDomains = NULL,
     .getAccountInfo = NULL,
+    .getAccountInfoMulti = NULL,
 };
 
 static void proxy_shutdown(struct be_req *req)
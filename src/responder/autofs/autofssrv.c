@@ -42,6 +42,7 @@ struct mon_cli_iface monitor_autofs_methods = {
     .clearMemcache = NULL,
     .clearEnumCache = autofs_clean_hash_table,
     .sysbusReconnect = NULL,
+    .getStats = monitor_common_get_stats,
 };
 
 static struct data_provider_iface autofs_dp_methods = {
@@ -53,6 +54,7 @@ static struct data_provider_iface autofs_dp_methods = {
     .hostHandler = NULL,
     .getDomains = NULL,
     .getAccountInfo = NULL,
+    .getAccountInfoMulti = NULL,
 };
 
 static errno_t
@@ -20,6 +20,7 @@
 */
 
 #include "util/util.h"
+#include "util/sss_stats.h"
 #include "confdb/confdb.h"
 #include "responder/common/responder.h"
 #include "responder/common/negcache.h"
@@ -131,6 +132,12 @@ done:
         ret = ENOENT;
     }
 
+    if (ret == EEXIST) {
+        sss_stats_count("negcache.hits", 1);
+    } else if (ret == ENOENT) {
+        sss_stats_count("negcache.misses", 1);
+    }
+
     free(data.dptr);
     return ret;
 }
@@ -140,9 +147,12 @@ static int sss_ncache_set_str(struct sss_nc_ctx *ctx,
 {
     TDB_DATA key;
     TDB_DATA data;
+    struct timeval start;
     char *timest;
     int ret;
 
+    gettimeofday(&start, NULL);
+
     ret = string_to_tdb_data(str, &key);
     if (ret != EOK) return ret;
 
@@ -167,6 +177,8 @@ static int sss_ncache_set_str(struct sss_nc_ctx *ctx,
         ret = EFAULT;
     }
 
+    sss_stats_record_since("negcache.store", &start);
+
 done:
     talloc_free(timest);
     return ret;
@@ -35,6 +35,7 @@
 
 #include "sbus/sssd_dbus.h"
 #include "sss_client/sss_cli.h"
+#include "responder/common/responder_lru.h"
 
 extern hash_table_t *dp_requests;
 
@@ -54,6 +55,9 @@ struct cli_request {
 
     /* reply data */
     struct sss_packet *out;
+
+    /* when the command started to be executed */
+    struct timeval start;
 };
 
 struct cli_protocol_version {
@@ -75,6 +79,12 @@ struct be_conn {
 
     char *sbus_address;
     struct sbus_connection *conn;
+
+    /* binary fast path to the back end, see providers/dp_fastpath.h */
+    struct dp_fastpath_conn *fast_conn;
+    struct sss_dp_fastpath_call *fast_calls;
+    uint32_t fast_serial;
+    time_t fast_retry;
 };
 
 struct resp_ctx {
@@ -99,6 +109,7 @@ struct resp_ctx {
     const char *confdb_service_path;
 
     hash_table_t *dp_request_table;
+    struct resp_lru *lru;
 
     struct timeval get_domains_last_call;
 
@@ -226,6 +237,10 @@ void handle_requests_after_reconnect(struct resp_ctx *rctx);
 
 int responder_logrotate(struct sbus_request *dbus_req, void *data);
 
+/* sbus handler of the invalidateCache call sent by the back end after it
+ * updated the cache of a domain */
+int responder_invalidate_lru(struct sbus_request *dbus_req, void *data);
+
 /* Each responder-specific request must create a constructor
  * function that creates a DBus Message that would be sent to
  * the back end
@@ -246,6 +261,34 @@ sss_dp_issue_request(TALLOC_CTX *mem_ctx, struct resp_ctx *rctx,
                      dbus_msg_constructor msg_create, void *pvt,
                      struct tevent_req *nreq);
 
+/* Builds the binary request of the fast path, the counterpart of
+ * dbus_msg_constructor */
+typedef uint8_t *(fastpath_msg_constructor)(TALLOC_CTX *mem_ctx, void *pvt,
+                                            uint32_t serial, size_t *_len);
+
+struct dp_fastpath_hdr;
+
+/* Gets the reply frame of a fast path request, or hdr set to NULL and the
+ * error if there is no reply */
+typedef void (*sss_dp_fastpath_reply_fn)(struct be_conn *be_conn,
+                                         struct dp_fastpath_hdr *hdr,
+                                         const uint8_t *body,
+                                         errno_t ret,
+                                         void *pvt);
+
+/* Sends the request built by fast_create over the fast path of the back end
+ * of dom, see providers/dp_fastpath.h. The timeout is in milliseconds.
+ * Freeing mem_ctx cancels the notification. Returns ENOTCONN if the back
+ * end does not accept the fast path, the caller uses D-Bus then. */
+errno_t sss_dp_fastpath_issue(TALLOC_CTX *mem_ctx,
+                              struct resp_ctx *rctx,
+                              struct sss_domain_info *dom,
+                              int timeout,
+                              fastpath_msg_constructor fast_create,
+                              void *create_pvt,
+                              sss_dp_fastpath_reply_fn reply_fn,
+                              void *reply_pvt);
+
 /* Every provider specific request uses this structure as the tevent_req
  * "state" structure.
  */
@@ -299,6 +342,29 @@ sss_dp_get_account_recv(TALLOC_CTX *mem_ctx,
                         dbus_uint32_t *err_min,
                         char **err_msg);
 
+/* Same as sss_dp_get_account_send() for many objects of one type with a
+ * single round trip to the back end. Either opt_names or opt_ids must be
+ * set, both have num elements. Only users, groups and SIDs are supported.
+ * The back end reports the status of each object, requests waiting for a
+ * single one of them only get its status. The first error reported for any
+ * of the objects is returned. */
+struct tevent_req *
+sss_dp_get_account_multi_send(TALLOC_CTX *mem_ctx,
+                              struct resp_ctx *rctx,
+                              struct sss_domain_info *dom,
+                              bool fast_reply,
+                              enum sss_dp_acct_type type,
+                              const char **opt_names,
+                              const uint32_t *opt_ids,
+                              size_t num,
+                              const char *extra);
+errno_t
+sss_dp_get_account_multi_recv(TALLOC_CTX *mem_ctx,
+                              struct tevent_req *req,
+                              dbus_uint16_t *err_maj,
+                              dbus_uint32_t *err_min,
+                              char **err_msg);
+
 bool sss_utf8_check(const uint8_t *s, size_t n);
 
 void responder_set_fd_limit(rlim_t fd_limit);
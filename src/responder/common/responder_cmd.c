@@ -23,11 +23,15 @@
 #include "util/util.h"
 #include "responder/common/responder.h"
 #include "responder/common/responder_packet.h"
+#include "util/sss_stats.h"
 
 int sss_cmd_send_error(struct cli_ctx *cctx, int err)
 {
     int ret;
 
+    debug_ring_dump("request failed");
+    sss_stats_count("responder.cmd.errors", 1);
+
     /* create response packet */
     ret = sss_packet_new(cctx->creq, 0,
                          sss_packet_get_cmd(cctx->creq->in),
@@ -156,6 +160,8 @@ int sss_cmd_execute(struct cli_ctx *cctx,
 {
     int i;
 
+    gettimeofday(&cctx->creq->start, NULL);
+
     for (i = 0; sss_cmds[i].cmd != SSS_CLI_NULL; i++) {
         if (cmd == sss_cmds[i].cmd) {
             return sss_cmds[i].fn(cctx);
@@ -36,6 +36,7 @@
 
 #include "util/util.h"
 #include "util/strtonum.h"
+#include "util/sss_stats.h"
 #include "db/sysdb.h"
 #include "confdb/confdb.h"
 #include "sbus/sssd_dbus.h"
@@ -243,6 +244,7 @@ done:
 
 static void client_send(struct cli_ctx *cctx)
 {
+    char name[sizeof("responder.cmd.0x") + 8];
     int ret;
 
     ret = sss_packet_send(cctx->creq->out, cctx->cfd);
@@ -257,6 +259,10 @@ static void client_send(struct cli_ctx *cctx)
     }
 
     /* ok all sent */
+    snprintf(name, sizeof(name), "responder.cmd.0x%04x",
+             sss_packet_get_cmd(cctx->creq->out));
+    sss_stats_record_since(name, &cctx->creq->start);
+
     TEVENT_FD_NOT_WRITEABLE(cctx->cfde);
     TEVENT_FD_READABLE(cctx->cfde);
     talloc_free(cctx->creq);
@@ -427,6 +433,12 @@ static void accept_fd_handler(struct tevent_context *ev,
     len = sizeof(cctx->addr);
     cctx->cfd = accept(fd, (struct sockaddr *)&cctx->addr, &len);
     if (cctx->cfd == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            /* another process sharing the socket was faster */
+            DEBUG(SSSDBG_TRACE_ALL, "No connection to accept\n");
+            talloc_free(cctx);
+            return;
+        }
         DEBUG(SSSDBG_CRIT_FAILURE, "Accept failed [%s]\n", strerror(errno));
         talloc_free(cctx);
         return;
@@ -780,6 +792,8 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
     struct sss_domain_info *dom;
     int ret;
     char *tmp = NULL;
+    int lru_size;
+    int lru_timeout;
 
     rctx = talloc_zero(mem_ctx, struct resp_ctx);
     if (!rctx) {
@@ -829,6 +843,37 @@ int sss_process_init(TALLOC_CTX *mem_ctx,
         rctx->domains_timeout = GET_DOMAINS_DEFAULT_TIMEOUT;
     }
 
+    ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
+                         CONFDB_RESPONDER_LRU_SIZE,
+                         CONFDB_RESPONDER_LRU_DEFAULT_SIZE, &lru_size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the LRU size [%d]: %s\n", ret, strerror(ret));
+        goto fail;
+    }
+
+    ret = confdb_get_int(rctx->cdb, rctx->confdb_service_path,
+                         CONFDB_RESPONDER_LRU_TIMEOUT,
+                         CONFDB_RESPONDER_LRU_DEFAULT_TIMEOUT, &lru_timeout);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Cannot get the LRU timeout [%d]: %s\n", ret, strerror(ret));
+        goto fail;
+    }
+
+    if (lru_size < 0 || lru_timeout < 0) {
+        DEBUG(SSSDBG_CONF_SETTINGS,
+              "LRU size and timeout can't be negative, disabling the LRU\n");
+        lru_size = 0;
+    }
+
+    ret = resp_lru_init(rctx, lru_size, lru_timeout, &rctx->lru);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Cannot initialize the LRU [%d]: %s\n",
+              ret, strerror(ret));
+        goto fail;
+    }
+
     ret = confdb_get_domains(rctx->cdb, &rctx->domains);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "fatal error setting up domain map\n");
@@ -1031,6 +1076,22 @@ int responder_logrotate(struct sbus_request *dbus_req, void *data)
     return sbus_request_return_and_finish(dbus_req, DBUS_TYPE_INVALID);
 }
 
+int responder_invalidate_lru(struct sbus_request *dbus_req, void *data)
+{
+    struct resp_ctx *rctx = talloc_get_type(data, struct resp_ctx);
+    char *domain;
+
+    if (!sbus_request_parse_or_finish(dbus_req,
+                                      DBUS_TYPE_STRING, &domain,
+                                      DBUS_TYPE_INVALID)) {
+        return EOK; /* handled */
+    }
+
+    resp_lru_invalidate(rctx->lru, domain);
+
+    return sbus_request_return_and_finish(dbus_req, DBUS_TYPE_INVALID);
+}
+
 void responder_set_fd_limit(rlim_t fd_limit)
 {
     struct rlimit current_limit, new_limit;
@@ -21,13 +21,22 @@
 
 
 #include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
 #include <time.h>
 #include "util/util.h"
+#include "util/sss_stats.h"
 #include "responder/common/responder_packet.h"
 #include "responder/common/responder.h"
 #include "providers/data_provider.h"
+#include "providers/dp_fastpath.h"
 #include "sbus/sbus_client.h"
 
+/* How long to wait before trying to connect to the fast path of a back end
+ * again if it is not available */
+#define SSS_DP_FASTPATH_RETRY 30
+
 struct sss_dp_req;
 
 struct sss_dp_callback {
@@ -42,6 +51,7 @@ struct sss_dp_req {
     struct resp_ctx *rctx;
     struct tevent_context *ev;
     DBusPendingCall *pending_reply;
+    struct sss_dp_fastpath_call *fast_call;
 
     hash_key_t *key;
 
@@ -74,6 +84,7 @@ static int sss_dp_req_destructor(void *ptr)
         dbus_pending_call_cancel(sdp_req->pending_reply);
         sdp_req->pending_reply = NULL;
     }
+    talloc_zfree(sdp_req->fast_call);
 
     /* Do not call callbacks if the responder is shutting down, because
      * the top level responder context (pam_ctx, sudo_ctx, ...) may be
@@ -161,19 +172,95 @@ void handle_requests_after_reconnect(struct resp_ctx *rctx)
     }
 }
 
-static int sss_dp_get_reply(DBusPendingCall *pending,
+/* A getAccountInfoMulti reply carries the status of each of its num_keys
+ * keys after the common one. Replies without it (errors detected before the
+ * keys were processed, fast replies) apply to all keys. */
+static errno_t sss_dp_parse_reply(TALLOC_CTX *mem_ctx,
+                                  DBusMessage *reply,
+                                  size_t num_keys,
+                                  dbus_uint16_t *dp_err,
+                                  dbus_uint32_t *dp_ret,
+                                  char **err_msg,
+                                  dbus_uint16_t **_key_errs,
+                                  dbus_uint32_t **_key_rets)
+{
+    DBusError dbus_error;
+    dbus_bool_t ret;
+    const char *msg;
+    dbus_uint16_t *key_errs;
+    dbus_uint32_t *key_rets;
+    int num_errs;
+    int num_rets;
+
+    dbus_error_init(&dbus_error);
+
+    ret = dbus_message_get_args(reply, &dbus_error,
+                                DBUS_TYPE_UINT16, dp_err,
+                                DBUS_TYPE_UINT32, dp_ret,
+                                DBUS_TYPE_STRING, &msg,
+                                DBUS_TYPE_INVALID);
+    if (!ret) {
+        DEBUG(SSSDBG_CRIT_FAILURE,"Failed to parse message\n");
+        if (dbus_error_is_set(&dbus_error)) dbus_error_free(&dbus_error);
+        return EIO;
+    }
+
+    /* the strings are owned by the reply */
+    *err_msg = talloc_strdup(mem_ctx, msg);
+    if (*err_msg == NULL) {
+        return ENOMEM;
+    }
+
+    if (num_keys < 2 || _key_errs == NULL || _key_rets == NULL) {
+        return EOK;
+    }
+
+    ret = dbus_message_get_args(reply, NULL,
+                                DBUS_TYPE_UINT16, dp_err,
+                                DBUS_TYPE_UINT32, dp_ret,
+                                DBUS_TYPE_STRING, &msg,
+                                DBUS_TYPE_ARRAY, DBUS_TYPE_UINT16,
+                                &key_errs, &num_errs,
+                                DBUS_TYPE_ARRAY, DBUS_TYPE_UINT32,
+                                &key_rets, &num_rets,
+                                DBUS_TYPE_INVALID);
+    if (!ret) {
+        return EOK;
+    }
+
+    if ((size_t)num_errs != num_keys || (size_t)num_rets != num_keys) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Reply has status of %d/%d keys, expected %zu\n",
+              num_errs, num_rets, num_keys);
+        return EOK;
+    }
+
+    *_key_errs = talloc_memdup(mem_ctx, key_errs,
+                               num_keys * sizeof(dbus_uint16_t));
+    *_key_rets = talloc_memdup(mem_ctx, key_rets,
+                               num_keys * sizeof(dbus_uint32_t));
+    if (*_key_errs == NULL || *_key_rets == NULL) {
+        talloc_zfree(*_key_errs);
+        talloc_zfree(*_key_rets);
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+static int sss_dp_get_reply(TALLOC_CTX *mem_ctx,
+                            DBusPendingCall *pending,
+                            size_t num_keys,
                             dbus_uint16_t *dp_err,
                             dbus_uint32_t *dp_ret,
-                            char **err_msg)
+                            char **err_msg,
+                            dbus_uint16_t **key_errs,
+                            dbus_uint32_t **key_rets)
 {
     DBusMessage *reply;
-    DBusError dbus_error;
-    dbus_bool_t ret;
     int type;
     int err = EOK;
 
-    dbus_error_init(&dbus_error);
-
     reply = dbus_pending_call_steal_reply(pending);
     if (!reply) {
         /* reply should never be null. This function shouldn't be called
@@ -192,15 +279,11 @@ static int sss_dp_get_reply(DBusPendingCall *pending,
     type = dbus_message_get_type(reply);
     switch (type) {
     case DBUS_MESSAGE_TYPE_METHOD_RETURN:
-        ret = dbus_message_get_args(reply, &dbus_error,
-                                    DBUS_TYPE_UINT16, dp_err,
-                                    DBUS_TYPE_UINT32, dp_ret,
-                                    DBUS_TYPE_STRING, err_msg,
-                                    DBUS_TYPE_INVALID);
-        if (!ret) {
-            DEBUG(SSSDBG_CRIT_FAILURE,"Failed to parse message\n");
+        err = sss_dp_parse_reply(mem_ctx, reply, num_keys,
+                                 dp_err, dp_ret, err_msg,
+                                 key_errs, key_rets);
+        if (err != EOK) {
             /* FIXME: Destroy this connection ? */
-            if (dbus_error_is_set(&dbus_error)) dbus_error_free(&dbus_error);
             err = EIO;
             goto done;
         }
@@ -235,34 +318,130 @@ static int sss_dp_get_reply(DBusPendingCall *pending,
 
 done:
     dbus_pending_call_unref(pending);
-    dbus_message_unref(reply);
+    if (reply) {
+        dbus_message_unref(reply);
+    }
 
     return err;
 }
 
 static struct tevent_req *
 sss_dp_internal_get_send(struct resp_ctx *rctx,
-                         hash_key_t *key,
+                         hash_key_t **keys,
+                         size_t num_keys,
                          struct sss_domain_info *dom,
-                         DBusMessage *msg);
+                         DBusMessage *msg,
+                         fastpath_msg_constructor fast_create,
+                         void *pvt);
+
+static bool sss_dp_fastpath_available(struct resp_ctx *rctx,
+                                      struct sss_domain_info *dom);
 
 static void
 sss_dp_req_done(struct tevent_req *sidereq);
 
-errno_t
-sss_dp_issue_request(TALLOC_CTX *mem_ctx, struct resp_ctx *rctx,
-                     const char *strkey, struct sss_domain_info *dom,
-                     dbus_msg_constructor msg_create, void *pvt,
-                     struct tevent_req *nreq)
+static hash_key_t *sss_dp_req_key(TALLOC_CTX *mem_ctx,
+                                  dbus_msg_constructor msg_create,
+                                  const char *strkey)
 {
-    int hret;
-    hash_value_t value;
     hash_key_t *key;
+
+    key = talloc(mem_ctx, hash_key_t);
+    if (key == NULL) {
+        return NULL;
+    }
+
+    key->type = HASH_KEY_STRING;
+    key->str = talloc_asprintf(key, "%p:%s", msg_create, strkey);
+    if (key->str == NULL) {
+        talloc_free(key);
+        return NULL;
+    }
+
+    return key;
+}
+
+/* Sends the message, or the fast path request built by fast_create if msg
+ * is NULL, and adds a timeout so we do not hang forever should something go
+ * wrong in the provider. */
+static errno_t sss_dp_send_internal(struct resp_ctx *rctx,
+                                    hash_key_t **keys,
+                                    size_t num_keys,
+                                    struct sss_domain_info *dom,
+                                    DBusMessage *msg,
+                                    fastpath_msg_constructor fast_create,
+                                    void *pvt)
+{
     struct tevent_req *sidereq;
-    struct sss_dp_req *sdp_req;
-    struct sss_dp_callback *cb;
     struct tevent_timer *te;
     struct timeval tv;
+
+    sidereq = sss_dp_internal_get_send(rctx, keys, num_keys, dom, msg,
+                                       fast_create, pvt);
+    if (!sidereq) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Cannot send D-Bus message\n");
+        return EIO;
+    }
+    tevent_req_set_callback(sidereq, sss_dp_req_done, NULL);
+
+    /* Use 2 sec less than the idle timeout to give it a chance to reply
+     * to the client before closing the connection. */
+    tv = tevent_timeval_current_ofs(rctx->client_idle_timeout - 2, 0);
+    te = tevent_add_timer(rctx->ev, sidereq, tv,
+                          sss_dp_req_timeout, sidereq);
+    if (!te) {
+        /* Nothing much we can do */
+        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory?!\n");
+        return ENOMEM;
+    }
+
+    return EOK;
+}
+
+/* Register nreq for the results of sdp_req */
+static errno_t sss_dp_req_add_callback(TALLOC_CTX *mem_ctx,
+                                       hash_value_t *value,
+                                       struct tevent_req *nreq)
+{
+    struct sss_dp_req *sdp_req;
+    struct sss_dp_callback *cb;
+
+    sdp_req = talloc_get_type(value->ptr, struct sss_dp_req);
+    if (!sdp_req) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not retrieve DP request context\n");
+        return EIO;
+    }
+
+    cb = talloc_zero(mem_ctx, struct sss_dp_callback);
+    if (!cb) {
+        return ENOMEM;
+    }
+
+    cb->req = nreq;
+    cb->sdp_req = sdp_req;
+
+    /* Add it to the list of requests to call */
+    DLIST_ADD_END(sdp_req->cb_list, cb,
+                  struct sss_dp_callback *);
+    talloc_set_destructor((TALLOC_CTX *)cb,
+                          sss_dp_callback_destructor);
+
+    return EOK;
+}
+
+/* If fast_create is set and the back end accepts the fast path, the
+ * request is sent over it instead of D-Bus. The key is the same in both
+ * cases, so the requests are joined no matter how they were sent. */
+static errno_t
+sss_dp_issue_request_int(TALLOC_CTX *mem_ctx, struct resp_ctx *rctx,
+                         const char *strkey, struct sss_domain_info *dom,
+                         dbus_msg_constructor msg_create,
+                         fastpath_msg_constructor fast_create,
+                         void *pvt, struct tevent_req *nreq)
+{
+    int hret;
+    hash_value_t value;
+    hash_key_t *key;
     DBusMessage *msg;
     TALLOC_CTX *tmp_ctx = NULL;
     errno_t ret;
@@ -272,19 +451,12 @@ sss_dp_issue_request(TALLOC_CTX *mem_ctx, struct resp_ctx *rctx,
         return ENOMEM;
     }
 
-    key = talloc(tmp_ctx, hash_key_t);
+    key = sss_dp_req_key(tmp_ctx, msg_create, strkey);
     if (!key) {
         ret = ENOMEM;
         goto fail;
     }
 
-    key->type = HASH_KEY_STRING;
-    key->str = talloc_asprintf(key, "%p:%s", msg_create, strkey);
-    if (!key->str) {
-        ret = ENOMEM;
-        goto fail;
-    }
-
     DEBUG(SSSDBG_TRACE_FUNC, "Issuing request for [%s]\n", key->str);
 
     /* Check the hash for existing references to this request */
@@ -294,40 +466,29 @@ sss_dp_issue_request(TALLOC_CTX *mem_ctx, struct resp_ctx *rctx,
         /* Request already in progress */
         DEBUG(SSSDBG_TRACE_FUNC,
               "Identical request in progress: [%s]\n", key->str);
+        sss_stats_count("responder.dp.joined", 1);
         break;
 
     case HASH_ERROR_KEY_NOT_FOUND:
         /* No such request in progress
          * Create a new request
          */
-        msg = msg_create(pvt);
-        if (!msg) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Cannot create D-Bus message\n");
-            ret = EIO;
-            goto fail;
-        }
-
         value.type = HASH_VALUE_PTR;
-        sidereq = sss_dp_internal_get_send(rctx, key, dom, msg);
-        dbus_message_unref(msg);
-        if (!sidereq) {
-            DEBUG(SSSDBG_CRIT_FAILURE, "Cannot send D-Bus message\n");
-            ret = EIO;
-            goto fail;
+        if (fast_create != NULL && sss_dp_fastpath_available(rctx, dom)) {
+            ret = sss_dp_send_internal(rctx, &key, 1, dom, NULL,
+                                       fast_create, pvt);
+        } else {
+            msg = msg_create(pvt);
+            if (!msg) {
+                DEBUG(SSSDBG_CRIT_FAILURE, "Cannot create D-Bus message\n");
+                ret = EIO;
+                goto fail;
+            }
+
+            ret = sss_dp_send_internal(rctx, &key, 1, dom, msg, NULL, NULL);
+            dbus_message_unref(msg);
         }
-        tevent_req_set_callback(sidereq, sss_dp_req_done, NULL);
-
-        /* add timeout handling so we do not hang forever should something
-         * go worng in the provider. Use 2 sec less than the idle timeout to
-         * give it a chance to reply to the client before closing the
-         * connection. */
-        tv = tevent_timeval_current_ofs(rctx->client_idle_timeout - 2, 0);
-        te = tevent_add_timer(rctx->ev, sidereq, tv,
-                              sss_dp_req_timeout, sidereq);
-        if (!te) {
-            /* Nothing much we can do */
-            DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory?!\n");
-            ret = ENOMEM;
+        if (ret != EOK) {
             goto fail;
         }
 
@@ -350,34 +511,23 @@ sss_dp_issue_request(TALLOC_CTX *mem_ctx, struct resp_ctx *rctx,
     }
 
     /* Register this request for results */
-    sdp_req = talloc_get_type(value.ptr, struct sss_dp_req);
-    if (!sdp_req) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "Could not retrieve DP request context\n");
-        ret = EIO;
-        goto fail;
-    }
-
-    cb = talloc_zero(mem_ctx, struct sss_dp_callback);
-    if (!cb) {
-        ret = ENOMEM;
-        goto fail;
-    }
-
-    cb->req = nreq;
-    cb->sdp_req = sdp_req;
-
-    /* Add it to the list of requests to call */
-    DLIST_ADD_END(sdp_req->cb_list, cb,
-                  struct sss_dp_callback *);
-    talloc_set_destructor((TALLOC_CTX *)cb,
-                          sss_dp_callback_destructor);
+    ret = sss_dp_req_add_callback(mem_ctx, &value, nreq);
 
-    ret = EOK;
 fail:
     talloc_free(tmp_ctx);
     return ret;
 }
 
+errno_t
+sss_dp_issue_request(TALLOC_CTX *mem_ctx, struct resp_ctx *rctx,
+                     const char *strkey, struct sss_domain_info *dom,
+                     dbus_msg_constructor msg_create, void *pvt,
+                     struct tevent_req *nreq)
+{
+    return sss_dp_issue_request_int(mem_ctx, rctx, strkey, dom, msg_create,
+                                    NULL, pvt, nreq);
+}
+
 static void
 sss_dp_req_done(struct tevent_req *sidereq)
 {
@@ -422,6 +572,9 @@ sss_dp_req_recv(TALLOC_CTX *mem_ctx,
  * the data provider action.
  */
 static DBusMessage *sss_dp_get_account_msg(void *pvt);
+static uint8_t *sss_dp_get_account_fastpath_msg(TALLOC_CTX *mem_ctx,
+                                                void *pvt, uint32_t serial,
+                                                size_t *_len);
 
 struct sss_dp_account_info {
     struct sss_domain_info *dom;
@@ -433,6 +586,115 @@ struct sss_dp_account_info {
     uint32_t opt_id;
 };
 
+/* Requests for the same object share the key whether they are sent alone
+ * or as a part of a getAccountInfoMulti call */
+static char *sss_dp_account_key(TALLOC_CTX *mem_ctx,
+                                struct sss_domain_info *dom,
+                                enum sss_dp_acct_type type,
+                                const char *opt_name,
+                                uint32_t opt_id,
+                                const char *extra)
+{
+    char *key;
+
+    if (opt_name) {
+        if (extra) {
+            key = talloc_asprintf(mem_ctx, "%d:%s:%s@%s",
+                                  type, opt_name, extra, dom->name);
+        } else {
+            key = talloc_asprintf(mem_ctx, "%d:%s@%s",
+                                  type, opt_name, dom->name);
+        }
+    } else if (opt_id) {
+        if (extra) {
+            key = talloc_asprintf(mem_ctx, "%d:%d:%s@%s",
+                                  type, opt_id, extra, dom->name);
+        } else {
+            key = talloc_asprintf(mem_ctx, "%d:%d@%s",
+                                  type, opt_id, dom->name);
+        }
+    } else {
+        key = talloc_asprintf(mem_ctx, "%d:*@%s", type, dom->name);
+    }
+
+    return key;
+}
+
+static uint32_t sss_dp_account_be_type(enum sss_dp_acct_type type,
+                                       bool fast_reply)
+{
+    uint32_t be_type = 0;
+
+    switch (type) {
+        case SSS_DP_USER:
+            be_type = BE_REQ_USER;
+            break;
+        case SSS_DP_GROUP:
+            be_type = BE_REQ_GROUP;
+            break;
+        case SSS_DP_INITGROUPS:
+            be_type = BE_REQ_INITGROUPS;
+            break;
+        case SSS_DP_NETGR:
+            be_type = BE_REQ_NETGROUP;
+            break;
+        case SSS_DP_SERVICES:
+            be_type = BE_REQ_SERVICES;
+            break;
+        case SSS_DP_SECID:
+            be_type = BE_REQ_BY_SECID;
+            break;
+        case SSS_DP_USER_AND_GROUP:
+            be_type = BE_REQ_USER_AND_GROUP;
+            break;
+    }
+
+    if (fast_reply) {
+        be_type |= BE_REQ_FAST;
+    }
+
+    return be_type;
+}
+
+static char *sss_dp_account_filter(TALLOC_CTX *mem_ctx,
+                                   enum sss_dp_acct_type type,
+                                   const char *opt_name,
+                                   uint32_t opt_id,
+                                   const char *extra)
+{
+    char *filter;
+
+    if (opt_name) {
+        if (type == SSS_DP_SECID) {
+            if (extra) {
+                filter = talloc_asprintf(mem_ctx, "%s=%s:%s", DP_SEC_ID,
+                                               opt_name, extra);
+            } else {
+                filter = talloc_asprintf(mem_ctx, "%s=%s", DP_SEC_ID,
+                                               opt_name);
+            }
+        } else {
+            if (extra) {
+                filter = talloc_asprintf(mem_ctx, "name=%s:%s",
+                                         opt_name, extra);
+            } else {
+                filter = talloc_asprintf(mem_ctx, "name=%s", opt_name);
+            }
+        }
+    } else if (opt_id) {
+        if (extra) {
+            filter = talloc_asprintf(mem_ctx, "idnumber=%u:%s",
+                                     opt_id, extra);
+        } else {
+            filter = talloc_asprintf(mem_ctx, "idnumber=%u", opt_id);
+        }
+    } else {
+        filter = talloc_strdup(mem_ctx, ENUM_INDICATOR);
+    }
+
+    return filter;
+}
+
 struct tevent_req *
 sss_dp_get_account_send(TALLOC_CTX *mem_ctx,
                         struct resp_ctx *rctx,
@@ -473,31 +735,16 @@ sss_dp_get_account_send(TALLOC_CTX *mem_ctx,
     info->extra = extra;
     info->dom = dom;
 
-    if (opt_name) {
-        if (extra) {
-            key = talloc_asprintf(state, "%d:%s:%s@%s",
-                                  type, opt_name, extra, dom->name);
-        } else {
-            key = talloc_asprintf(state, "%d:%s@%s",
-                                  type, opt_name, dom->name);
-        }
-    } else if (opt_id) {
-        if (extra) {
-            key = talloc_asprintf(state, "%d:%d:%s@%s",
-                                  type, opt_id, extra, dom->name);
-        } else {
-            key = talloc_asprintf(state, "%d:%d@%s", type, opt_id, dom->name);
-        }
-    } else {
-        key = talloc_asprintf(state, "%d:*@%s", type, dom->name);
-    }
+    key = sss_dp_account_key(state, dom, type, opt_name, opt_id, extra);
     if (!key) {
         ret = ENOMEM;
         goto error;
     }
 
-    ret = sss_dp_issue_request(state, rctx, key, dom, sss_dp_get_account_msg,
-                               info, req);
+    ret = sss_dp_issue_request_int(state, rctx, key, dom,
+                                   sss_dp_get_account_msg,
+                                   sss_dp_get_account_fastpath_msg,
+                                   info, req);
     talloc_free(key);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE,
@@ -526,61 +773,10 @@ sss_dp_get_account_msg(void *pvt)
 
     info = talloc_get_type(pvt, struct sss_dp_account_info);
 
-    switch (info->type) {
-        case SSS_DP_USER:
-            be_type = BE_REQ_USER;
-            break;
-        case SSS_DP_GROUP:
-            be_type = BE_REQ_GROUP;
-            break;
-        case SSS_DP_INITGROUPS:
-            be_type = BE_REQ_INITGROUPS;
-            break;
-        case SSS_DP_NETGR:
-            be_type = BE_REQ_NETGROUP;
-            break;
-        case SSS_DP_SERVICES:
-            be_type = BE_REQ_SERVICES;
-            break;
-        case SSS_DP_SECID:
-            be_type = BE_REQ_BY_SECID;
-            break;
-        case SSS_DP_USER_AND_GROUP:
-            be_type = BE_REQ_USER_AND_GROUP;
-            break;
-    }
-
-    if (info->fast_reply) {
-        be_type |= BE_REQ_FAST;
-    }
+    be_type = sss_dp_account_be_type(info->type, info->fast_reply);
 
-    if (info->opt_name) {
-        if (info->type == SSS_DP_SECID) {
-            if (info->extra) {
-                filter = talloc_asprintf(info, "%s=%s:%s", DP_SEC_ID,
-                                               info->opt_name, info->extra);
-            } else {
-                filter = talloc_asprintf(info, "%s=%s", DP_SEC_ID,
-                                               info->opt_name);
-            }
-        } else {
-            if (info->extra) {
-                filter = talloc_asprintf(info, "name=%s:%s",
-                                         info->opt_name, info->extra);
-            } else {
-                filter = talloc_asprintf(info, "name=%s", info->opt_name);
-            }
-        }
-    } else if (info->opt_id) {
-        if (info->extra) {
-            filter = talloc_asprintf(info, "idnumber=%u:%s",
-                                     info->opt_id, info->extra);
-        } else {
-            filter = talloc_asprintf(info, "idnumber=%u", info->opt_id);
-        }
-    } else {
-        filter = talloc_strdup(info, ENUM_INDICATOR);
-    }
+    filter = sss_dp_account_filter(info, info->type, info->opt_name,
+                                   info->opt_id, info->extra);
     if (!filter) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory?!\n");
         return NULL;
@@ -617,8 +813,47 @@ sss_dp_get_account_msg(void *pvt)
     return msg;
 }
 
-errno_t
-sss_dp_get_account_recv(TALLOC_CTX *mem_ctx,
+static uint8_t *
+sss_dp_get_account_fastpath_msg(TALLOC_CTX *mem_ctx, void *pvt,
+                                uint32_t serial, size_t *_len)
+{
+    struct sss_dp_account_info *info;
+    struct dp_fastpath_account_req ar;
+    uint8_t *frame;
+    char *filter;
+    errno_t ret;
+
+    info = talloc_get_type(pvt, struct sss_dp_account_info);
+
+    filter = sss_dp_account_filter(mem_ctx, info->type, info->opt_name,
+                                   info->opt_id, info->extra);
+    if (!filter) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory?!\n");
+        return NULL;
+    }
+
+    ar.entry_type = sss_dp_account_be_type(info->type, info->fast_reply);
+    ar.attr_type = BE_ATTR_CORE;
+    ar.filter = filter;
+    ar.domain = info->dom->name;
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Creating fast path request for [%s][%u][%d][%s]\n",
+           ar.domain, ar.entry_type, ar.attr_type, filter);
+
+    ret = dp_fastpath_encode_account_req(mem_ctx, serial, &ar, &frame, _len);
+    talloc_free(filter);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to build request [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return NULL;
+    }
+
+    return frame;
+}
+
+errno_t
+sss_dp_get_account_recv(TALLOC_CTX *mem_ctx,
                         struct tevent_req *req,
                         dbus_uint16_t *dp_err,
                         dbus_uint32_t *dp_ret,
@@ -627,28 +862,714 @@ sss_dp_get_account_recv(TALLOC_CTX *mem_ctx,
     return sss_dp_req_recv(mem_ctx, req, dp_err, dp_ret, err_msg);
 }
 
+static DBusMessage *sss_dp_get_account_multi_msg(void *pvt);
+
+struct sss_dp_account_multi_info {
+    struct sss_domain_info *dom;
+
+    bool fast_reply;
+    enum sss_dp_acct_type type;
+    const char **filters;
+    size_t num_filters;
+};
+
+struct sss_dp_get_account_multi_state {
+    size_t pending;
+
+    dbus_uint16_t dp_err;
+    dbus_uint32_t dp_ret;
+    char *err_msg;
+};
+
+static void sss_dp_get_account_multi_done(struct tevent_req *subreq);
+
+/* Requests all objects at once. Objects which are already requested by
+ * someone else are not requested again, the request waits for the
+ * running ones instead. */
+struct tevent_req *
+sss_dp_get_account_multi_send(TALLOC_CTX *mem_ctx,
+                              struct resp_ctx *rctx,
+                              struct sss_domain_info *dom,
+                              bool fast_reply,
+                              enum sss_dp_acct_type type,
+                              const char **opt_names,
+                              const uint32_t *opt_ids,
+                              size_t num,
+                              const char *extra)
+{
+    errno_t ret;
+    int hret;
+    struct tevent_req *req;
+    struct tevent_req *subreq;
+    struct sss_dp_get_account_multi_state *state;
+    struct sss_dp_account_multi_info *info;
+    struct sss_dp_req_state *subreq_state;
+    hash_key_t **keys;
+    hash_key_t **new_keys;
+    hash_value_t value;
+    struct tevent_req **waiting;
+    size_t num_new = 0;
+    const char *opt_name;
+    uint32_t opt_id;
+    DBusMessage *msg;
+    TALLOC_CTX *tmp_ctx;
+    char *strkey;
+    bool known;
+    size_t i;
+    size_t j;
+
+    req = tevent_req_create(mem_ctx, &state,
+                            struct sss_dp_get_account_multi_state);
+    if (!req) {
+        return NULL;
+    }
+    state->dp_err = DP_ERR_OK;
+    state->dp_ret = EOK;
+
+    tmp_ctx = talloc_new(NULL);
+    if (!tmp_ctx) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    /* either, or, not both */
+    if (!dom || (opt_names == NULL) == (opt_ids == NULL)) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    switch (type) {
+    case SSS_DP_USER:
+    case SSS_DP_GROUP:
+    case SSS_DP_SECID:
+    case SSS_DP_USER_AND_GROUP:
+        break;
+    default:
+        ret = EINVAL;
+        goto done;
+    }
+
+    info = talloc_zero(state, struct sss_dp_account_multi_info);
+    keys = talloc_zero_array(tmp_ctx, hash_key_t *, num);
+    new_keys = talloc_zero_array(tmp_ctx, hash_key_t *, num);
+    waiting = talloc_zero_array(tmp_ctx, struct tevent_req *, num);
+    if (!info || !keys || !new_keys || !waiting) {
+        ret = ENOMEM;
+        goto done;
+    }
+    info->dom = dom;
+    info->fast_reply = fast_reply;
+    info->type = type;
+    info->filters = talloc_zero_array(info, const char *, num);
+    if (!info->filters) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num; i++) {
+        opt_name = opt_names ? opt_names[i] : NULL;
+        opt_id = opt_ids ? opt_ids[i] : 0;
+        if (opt_name == NULL && opt_id == 0) {
+            continue;
+        }
+
+        strkey = sss_dp_account_key(tmp_ctx, dom, type, opt_name, opt_id,
+                                    extra);
+        if (!strkey) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        /* the same key as sss_dp_get_account_send() uses */
+        keys[i] = sss_dp_req_key(tmp_ctx, sss_dp_get_account_msg, strkey);
+        if (!keys[i]) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        subreq = tevent_req_create(state, &subreq_state,
+                                   struct sss_dp_req_state);
+        if (!subreq) {
+            ret = ENOMEM;
+            goto done;
+        }
+        tevent_req_set_callback(subreq, sss_dp_get_account_multi_done, req);
+        state->pending++;
+
+        hret = hash_lookup(rctx->dp_request_table, keys[i], &value);
+        if (hret == HASH_SUCCESS) {
+            DEBUG(SSSDBG_TRACE_FUNC,
+                  "Identical request in progress: [%s]\n", keys[i]->str);
+            sss_stats_count("responder.dp.joined", 1);
+            ret = sss_dp_req_add_callback(subreq, &value, subreq);
+            if (ret != EOK) {
+                goto done;
+            }
+            continue;
+        } else if (hret != HASH_ERROR_KEY_NOT_FOUND) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Could not query request list (%s)\n",
+                   hash_error_string(hret));
+            ret = EIO;
+            goto done;
+        }
+
+        waiting[i] = subreq;
+
+        known = false;
+        for (j = 0; j < num_new; j++) {
+            if (strcmp(new_keys[j]->str, keys[i]->str) == 0) {
+                known = true;
+                break;
+            }
+        }
+        if (known) {
+            continue;
+        }
+
+        info->filters[num_new] = sss_dp_account_filter(info->filters, type,
+                                                       opt_name, opt_id,
+                                                       extra);
+        if (!info->filters[num_new]) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        /* the key is stolen by the request, keep the one for the lookup */
+        new_keys[num_new] = sss_dp_req_key(tmp_ctx, sss_dp_get_account_msg,
+                                           strkey);
+        if (!new_keys[num_new]) {
+            ret = ENOMEM;
+            goto done;
+        }
+        num_new++;
+    }
+    info->num_filters = num_new;
+
+    if (num_new > 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Issuing request for %zu objects of %s\n",
+              num_new, dom->name);
+
+        msg = sss_dp_get_account_multi_msg(info);
+        if (!msg) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "Cannot create D-Bus message\n");
+            ret = EIO;
+            goto done;
+        }
+
+        ret = sss_dp_send_internal(rctx, new_keys, num_new, dom, msg,
+                                   NULL, NULL);
+        dbus_message_unref(msg);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    for (i = 0; i < num; i++) {
+        if (waiting[i] == NULL) {
+            continue;
+        }
+
+        hret = hash_lookup(rctx->dp_request_table, keys[i], &value);
+        if (hret != HASH_SUCCESS) {
+            /* Something must have gone wrong with creating the request */
+            DEBUG(SSSDBG_CRIT_FAILURE, "The request has disappeared?\n");
+            ret = EIO;
+            goto done;
+        }
+
+        ret = sss_dp_req_add_callback(waiting[i], &value, waiting[i]);
+        if (ret != EOK) {
+            goto done;
+        }
+    }
+
+    if (state->pending == 0) {
+        ret = EOK;
+        goto done;
+    }
+
+    talloc_free(tmp_ctx);
+    return req;
+
+done:
+    talloc_free(tmp_ctx);
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        DEBUG(SSSDBG_OP_FAILURE,
+              "Could not issue DP request [%d]: %s\n",
+               ret, strerror(ret));
+        tevent_req_error(req, ret);
+    }
+    tevent_req_post(req, rctx->ev);
+    return req;
+}
+
+static void sss_dp_get_account_multi_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req;
+    struct sss_dp_get_account_multi_state *state;
+    dbus_uint16_t dp_err;
+    dbus_uint32_t dp_ret;
+    char *err_msg;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct sss_dp_get_account_multi_state);
+
+    ret = sss_dp_req_recv(state, subreq, &dp_err, &dp_ret, &err_msg);
+    /* frees the callback and removes it from its sdp_req */
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        dp_err = DP_ERR_FATAL;
+        dp_ret = ret;
+    }
+
+    /* the first failure is reported */
+    if (dp_err != DP_ERR_OK && state->dp_err == DP_ERR_OK) {
+        state->dp_err = dp_err;
+        state->dp_ret = dp_ret;
+        state->err_msg = err_msg;
+    } else {
+        talloc_free(err_msg);
+    }
+
+    state->pending--;
+    if (state->pending == 0) {
+        tevent_req_done(req);
+    }
+}
+
+errno_t
+sss_dp_get_account_multi_recv(TALLOC_CTX *mem_ctx,
+                              struct tevent_req *req,
+                              dbus_uint16_t *dp_err,
+                              dbus_uint32_t *dp_ret,
+                              char **err_msg)
+{
+    struct sss_dp_get_account_multi_state *state;
+
+    state = tevent_req_data(req, struct sss_dp_get_account_multi_state);
+
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    *dp_err = state->dp_err;
+    *dp_ret = state->dp_ret;
+    *err_msg = talloc_steal(mem_ctx, state->err_msg);
+
+    return EOK;
+}
+
+static DBusMessage *
+sss_dp_get_account_multi_msg(void *pvt)
+{
+    DBusMessage *msg;
+    dbus_bool_t dbret;
+    struct sss_dp_account_multi_info *info;
+    uint32_t be_type;
+    uint32_t attrs = BE_ATTR_CORE;
+    int num;
+
+    info = talloc_get_type(pvt, struct sss_dp_account_multi_info);
+
+    be_type = sss_dp_account_be_type(info->type, info->fast_reply);
+
+    msg = dbus_message_new_method_call(NULL,
+                                       DP_PATH,
+                                       DATA_PROVIDER_IFACE,
+                                       DATA_PROVIDER_IFACE_GETACCOUNTINFOMULTI);
+    if (msg == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Out of memory?!\n");
+        return NULL;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Creating request for [%s][%u][%d] with %zu filters\n",
+           info->dom->name, be_type, attrs, info->num_filters);
+
+    num = info->num_filters;
+    dbret = dbus_message_append_args(msg,
+                                     DBUS_TYPE_UINT32, &be_type,
+                                     DBUS_TYPE_UINT32, &attrs,
+                                     DBUS_TYPE_ARRAY, DBUS_TYPE_STRING,
+                                     &info->filters, num,
+                                     DBUS_TYPE_STRING, &info->dom->name,
+                                     DBUS_TYPE_INVALID);
+    if (!dbret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to build message\n");
+        dbus_message_unref(msg);
+        return NULL;
+    }
+
+    return msg;
+}
+
 struct dp_internal_get_state {
     struct resp_ctx *rctx;
     struct sss_domain_info *dom;
 
-    struct sss_dp_req *sdp_req;
+    /* one per key, the first one owns the pending reply */
+    struct sss_dp_req **sdp_reqs;
+    size_t num_reqs;
     DBusPendingCall *pending_reply;
+    /* status of each key of a getAccountInfoMulti reply, NULL if the reply
+     * has a single status for all keys */
+    dbus_uint16_t *key_errs;
+    dbus_uint32_t *key_rets;
+
+    struct timeval start;
+};
+
+/* A request sent over the fast path waiting for its reply */
+struct sss_dp_fastpath_call {
+    struct sss_dp_fastpath_call *prev;
+    struct sss_dp_fastpath_call *next;
+
+    struct be_conn *be_conn;
+    uint32_t serial;
+    sss_dp_fastpath_reply_fn reply_fn;
+    void *pvt;
 };
 
 static void sss_dp_internal_get_done(DBusPendingCall *pending, void *ptr);
+static void sss_dp_internal_get_finish(struct tevent_req *req, errno_t ret);
+
+static int sss_dp_fastpath_call_destructor(struct sss_dp_fastpath_call *call)
+{
+    DLIST_REMOVE(call->be_conn->fast_calls, call);
+    return 0;
+}
+
+/* Frees the call and passes the reply, or the error if there is none, to
+ * its owner */
+static void sss_dp_fastpath_call_done(struct sss_dp_fastpath_call *call,
+                                      struct dp_fastpath_hdr *hdr,
+                                      const uint8_t *body,
+                                      errno_t ret)
+{
+    struct be_conn *be_conn = call->be_conn;
+    sss_dp_fastpath_reply_fn reply_fn = call->reply_fn;
+    void *pvt = call->pvt;
+
+    talloc_free(call);
+    reply_fn(be_conn, hdr, body, ret, pvt);
+}
+
+static void sss_dp_internal_fastpath_done(struct be_conn *be_conn,
+                                          struct dp_fastpath_hdr *hdr,
+                                          const uint8_t *body,
+                                          errno_t ret,
+                                          void *pvt)
+{
+    struct dp_internal_get_state *state;
+    struct dp_fastpath_reply reply;
+    struct tevent_req *req;
+    struct sss_dp_req *first;
+
+    req = talloc_get_type(pvt, struct tevent_req);
+    state = tevent_req_data(req, struct dp_internal_get_state);
+    first = state->sdp_reqs[0];
+
+    /* the call was freed already */
+    first->fast_call = NULL;
+
+    if (ret != EOK) {
+        sss_dp_internal_get_finish(req, ret);
+        return;
+    }
+
+    if (hdr->method != DP_FASTPATH_REPLY) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Unexpected method %"PRIu16"\n", hdr->method);
+        sss_dp_internal_get_finish(req, EIO);
+        return;
+    }
+
+    ret = dp_fastpath_decode_reply(first, body, hdr->len, &reply);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to parse reply [%d]: %s\n",
+              ret, sss_strerror(ret));
+        sss_dp_internal_get_finish(req, EIO);
+        return;
+    }
+
+    first->dp_err = reply.err_maj;
+    first->dp_ret = reply.err_min;
+    first->err_msg = discard_const(reply.err_msg);
+
+    DEBUG(SSSDBG_TRACE_LIBS,
+          "Got fast path reply from Data Provider - "
+          "DP error code: %u errno: %u error message: %s\n",
+          (unsigned int)first->dp_err, (unsigned int)first->dp_ret,
+          first->err_msg);
+
+    /* The back end sends the invalidation over D-Bus as well, but that one
+     * may arrive only after the reply. */
+    if (reply.flags & DP_FASTPATH_REPLY_INVALIDATE) {
+        resp_lru_invalidate(be_conn->rctx->lru, be_conn->domain->name);
+    }
+
+    sss_dp_internal_get_finish(req, EOK);
+}
+
+static void sss_dp_fastpath_frame(struct dp_fastpath_conn *conn,
+                                  struct dp_fastpath_hdr *hdr,
+                                  const uint8_t *body,
+                                  void *pvt)
+{
+    struct be_conn *be_conn;
+    struct sss_dp_fastpath_call *call;
+
+    be_conn = talloc_get_type(pvt, struct be_conn);
+
+    for (call = be_conn->fast_calls; call != NULL; call = call->next) {
+        if (call->serial == hdr->serial) {
+            break;
+        }
+    }
+
+    if (call == NULL) {
+        /* the request timed out or was freed already */
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Reply to unknown request %"PRIu32"\n", hdr->serial);
+        return;
+    }
+
+    sss_dp_fastpath_call_done(call, hdr, body, EOK);
+}
+
+static void sss_dp_fastpath_close(struct dp_fastpath_conn *conn, void *pvt)
+{
+    struct be_conn *be_conn;
+
+    be_conn = talloc_get_type(pvt, struct be_conn);
+
+    DEBUG(SSSDBG_MINOR_FAILURE, "Fast path to [%s] was closed\n",
+          be_conn->domain->name);
+
+    talloc_zfree(be_conn->fast_conn);
+
+    /* the callbacks may issue new requests, keep them on D-Bus until all
+     * the pending ones are failed */
+    be_conn->fast_retry = time(NULL) + SSS_DP_FASTPATH_RETRY;
+    while (be_conn->fast_calls != NULL) {
+        sss_dp_fastpath_call_done(be_conn->fast_calls, NULL, NULL, EIO);
+    }
+
+    /* the back end was probably restarted, try again on the next request */
+    be_conn->fast_retry = 0;
+}
+
+/* Connects to the fast path socket of the back end if it is not connected
+ * yet. Returns NULL if the back end does not accept the fast path. */
+static struct dp_fastpath_conn *sss_dp_fastpath_conn(struct be_conn *be_conn)
+{
+    struct sockaddr_un addr;
+    char *path;
+    errno_t ret;
+    int fd = -1;
+
+    if (be_conn->fast_conn != NULL) {
+        return be_conn->fast_conn;
+    }
+
+    if (time(NULL) < be_conn->fast_retry) {
+        return NULL;
+    }
+    be_conn->fast_retry = time(NULL) + SSS_DP_FASTPATH_RETRY;
+
+    ret = dp_fastpath_get_address(be_conn, be_conn->domain->name, &path);
+    if (ret != EOK) {
+        return NULL;
+    }
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        ret = errno;
+        goto done;
+    }
+
+    /* connecting to a listening UNIX socket does not block */
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ret = errno;
+        goto done;
+    }
+
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) != 0) {
+        ret = errno;
+        goto done;
+    }
+
+    be_conn->fast_conn = dp_fastpath_conn_create(be_conn, be_conn->rctx->ev,
+                                                 fd, sss_dp_fastpath_frame,
+                                                 sss_dp_fastpath_close,
+                                                 be_conn);
+    if (be_conn->fast_conn == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    fd = -1;
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Connected to the fast path of [%s]\n",
+          be_conn->domain->name);
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Fast path of [%s] is not available [%d]: %s\n",
+              be_conn->domain->name, ret, sss_strerror(ret));
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+    talloc_free(path);
+    return be_conn->fast_conn;
+}
+
+static bool sss_dp_fastpath_available(struct resp_ctx *rctx,
+                                      struct sss_domain_info *dom)
+{
+    struct be_conn *be_conn;
+    errno_t ret;
+
+    ret = sss_dp_get_domain_conn(rctx, dom->conn_name, &be_conn);
+    if (ret != EOK) {
+        return false;
+    }
+
+    return sss_dp_fastpath_conn(be_conn) != NULL;
+}
+
+static void sss_dp_fastpath_timeout(struct tevent_context *ev,
+                                    struct tevent_timer *te,
+                                    struct timeval tv, void *pvt)
+{
+    struct sss_dp_fastpath_call *call;
+
+    call = talloc_get_type(pvt, struct sss_dp_fastpath_call);
+
+    DEBUG(SSSDBG_MINOR_FAILURE,
+          "Fast path request %"PRIu32" timed out\n", call->serial);
+
+    sss_dp_fastpath_call_done(call, NULL, NULL, ETIME);
+}
+
+static errno_t sss_dp_fastpath_send(TALLOC_CTX *mem_ctx,
+                                    struct be_conn *be_conn,
+                                    int timeout,
+                                    fastpath_msg_constructor fast_create,
+                                    void *create_pvt,
+                                    sss_dp_fastpath_reply_fn reply_fn,
+                                    void *reply_pvt,
+                                    struct sss_dp_fastpath_call **_call)
+{
+    struct sss_dp_fastpath_call *call;
+    struct tevent_timer *te;
+    uint8_t *frame;
+    size_t len;
+    errno_t ret;
+
+    if (be_conn->fast_conn == NULL) {
+        return EIO;
+    }
+
+    call = talloc_zero(mem_ctx, struct sss_dp_fastpath_call);
+    if (call == NULL) {
+        return ENOMEM;
+    }
+    call->be_conn = be_conn;
+    call->reply_fn = reply_fn;
+    call->pvt = reply_pvt;
+    call->serial = ++be_conn->fast_serial;
+    DLIST_ADD(be_conn->fast_calls, call);
+    talloc_set_destructor(call, sss_dp_fastpath_call_destructor);
+
+    te = tevent_add_timer(be_conn->rctx->ev, call,
+                          tevent_timeval_current_ofs(timeout / 1000,
+                                                     (timeout % 1000) * 1000),
+                          sss_dp_fastpath_timeout, call);
+    if (te == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    frame = fast_create(call, create_pvt, call->serial, &len);
+    if (frame == NULL) {
+        ret = EIO;
+        goto done;
+    }
+
+    ret = dp_fastpath_conn_send(be_conn->fast_conn, frame, len);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    sss_stats_count("responder.dp.fastpath", 1);
+    if (_call != NULL) {
+        *_call = call;
+    }
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        talloc_free(call);
+    }
+    return ret;
+}
+
+errno_t sss_dp_fastpath_issue(TALLOC_CTX *mem_ctx,
+                              struct resp_ctx *rctx,
+                              struct sss_domain_info *dom,
+                              int timeout,
+                              fastpath_msg_constructor fast_create,
+                              void *create_pvt,
+                              sss_dp_fastpath_reply_fn reply_fn,
+                              void *reply_pvt)
+{
+    struct be_conn *be_conn;
+    errno_t ret;
+
+    ret = sss_dp_get_domain_conn(rctx, dom->conn_name, &be_conn);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (sss_dp_fastpath_conn(be_conn) == NULL) {
+        return ENOTCONN;
+    }
+
+    return sss_dp_fastpath_send(mem_ctx, be_conn, timeout, fast_create,
+                                create_pvt, reply_fn, reply_pvt, NULL);
+}
 
 static struct tevent_req *
 sss_dp_internal_get_send(struct resp_ctx *rctx,
-                         hash_key_t *key,
+                         hash_key_t **keys,
+                         size_t num_keys,
                          struct sss_domain_info *dom,
-                         DBusMessage *msg)
+                         DBusMessage *msg,
+                         fastpath_msg_constructor fast_create,
+                         void *pvt)
 {
     errno_t ret;
     int hret;
     struct tevent_req *req;
     struct dp_internal_get_state *state;
+    struct sss_dp_req *sdp_req;
     struct be_conn *be_conn;
     hash_value_t value;
+    size_t i;
 
     /* Internal requests need to be allocated on the responder context
      * so that they don't go away if a client disconnects. The worst-
@@ -662,20 +1583,31 @@ sss_dp_internal_get_send(struct resp_ctx *rctx,
 
     state->rctx = rctx;
     state->dom = dom;
+    gettimeofday(&state->start, NULL);
 
-    state->sdp_req = talloc_zero(state, struct sss_dp_req);
-    if (!state->sdp_req) {
+    state->sdp_reqs = talloc_zero_array(state, struct sss_dp_req *, num_keys);
+    if (!state->sdp_reqs || num_keys == 0) {
         ret = ENOMEM;
         goto error;
     }
-    state->sdp_req->rctx = rctx;
-    state->sdp_req->ev = rctx->ev;
 
-    /* Copy the key to use when calling the destructor
-     * It needs to be a copy because the original request
-     * might be freed if it no longer cares about the reply.
-     */
-    state->sdp_req->key = talloc_steal(state->sdp_req, key);
+    for (i = 0; i < num_keys; i++) {
+        sdp_req = talloc_zero(state, struct sss_dp_req);
+        if (!sdp_req) {
+            ret = ENOMEM;
+            goto error;
+        }
+        sdp_req->rctx = rctx;
+        sdp_req->ev = rctx->ev;
+
+        /* Copy the key to use when calling the destructor
+         * It needs to be a copy because the original request
+         * might be freed if it no longer cares about the reply.
+         */
+        sdp_req->key = talloc_steal(sdp_req, keys[i]);
+        state->sdp_reqs[i] = sdp_req;
+    }
+    state->num_reqs = num_keys;
 
     /* double check dp_ctx has actually been initialized.
      * in some pathological cases it may happen that nss starts up before
@@ -690,37 +1622,54 @@ sss_dp_internal_get_send(struct resp_ctx *rctx,
         goto error;
     }
 
-    ret = sbus_conn_send(be_conn->conn, msg,
-                         SSS_CLI_SOCKET_TIMEOUT / 2,
-                         sss_dp_internal_get_done,
-                         req,
-                         &state->sdp_req->pending_reply);
-    if (ret != EOK) {
-        /*
-         * Critical Failure
-         * We can't communicate on this connection
-         */
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "D-BUS send failed.\n");
-        ret = EIO;
-        goto error;
+    if (msg == NULL) {
+        ret = sss_dp_fastpath_send(state->sdp_reqs[0], be_conn,
+                                   SSS_CLI_SOCKET_TIMEOUT / 2,
+                                   fast_create, pvt,
+                                   sss_dp_internal_fastpath_done, req,
+                                   &state->sdp_reqs[0]->fast_call);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Fast path send failed [%d]: %s\n", ret, sss_strerror(ret));
+            ret = EIO;
+            goto error;
+        }
+    } else {
+        ret = sbus_conn_send(be_conn->conn, msg,
+                             SSS_CLI_SOCKET_TIMEOUT / 2,
+                             sss_dp_internal_get_done,
+                             req,
+                             &state->sdp_reqs[0]->pending_reply);
+        if (ret != EOK) {
+            /*
+             * Critical Failure
+             * We can't communicate on this connection
+             */
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "D-BUS send failed.\n");
+            ret = EIO;
+            goto error;
+        }
     }
 
-    /* Add this sdp_req to the hash table */
-    value.type = HASH_VALUE_PTR;
-    value.ptr = state->sdp_req;
+    /* Add the sdp_reqs to the hash table */
+    for (i = 0; i < state->num_reqs; i++) {
+        sdp_req = state->sdp_reqs[i];
+        value.type = HASH_VALUE_PTR;
+        value.ptr = sdp_req;
 
-    DEBUG(SSSDBG_TRACE_FUNC, "Entering request [%s]\n", key->str);
-    hret = hash_enter(rctx->dp_request_table, key, &value);
-    if (hret != HASH_SUCCESS) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Could not store request query (%s)\n",
-               hash_error_string(hret));
-        ret = EIO;
-        goto error;
+        DEBUG(SSSDBG_TRACE_FUNC, "Entering request [%s]\n", sdp_req->key->str);
+        hret = hash_enter(rctx->dp_request_table, sdp_req->key, &value);
+        if (hret != HASH_SUCCESS) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Could not store request query (%s)\n",
+                   hash_error_string(hret));
+            ret = EIO;
+            goto error;
+        }
+        talloc_set_destructor((TALLOC_CTX *)sdp_req,
+                              sss_dp_req_destructor);
     }
-    talloc_set_destructor((TALLOC_CTX *)state->sdp_req,
-                          sss_dp_req_destructor);
 
     return req;
 
@@ -734,74 +1683,139 @@ static void sss_dp_internal_get_done(DBusPendingCall *pending, void *ptr)
 {
     int ret;
     struct tevent_req *req;
-    struct sss_dp_req *sdp_req;
-    struct sss_dp_callback *cb;
+    struct sss_dp_req *first;
     struct dp_internal_get_state *state;
-    struct sss_dp_req_state *cb_state;
 
     req = talloc_get_type(ptr, struct tevent_req);
     state = tevent_req_data(req, struct dp_internal_get_state);
-    sdp_req = state->sdp_req;
+    first = state->sdp_reqs[0];
 
     /* prevent trying to cancel a reply that we already received */
-    sdp_req->pending_reply = NULL;
+    first->pending_reply = NULL;
+
+    ret = sss_dp_get_reply(first, pending, state->num_reqs,
+                           &first->dp_err,
+                           &first->dp_ret,
+                           &first->err_msg,
+                           &state->key_errs,
+                           &state->key_rets);
+
+    sss_dp_internal_get_finish(req, ret);
+}
+
+/* The message of the reply describes the common status, keys with a
+ * different one get a generic message */
+static const char *sss_dp_req_err_msg(dbus_uint16_t dp_err,
+                                      dbus_uint32_t dp_ret,
+                                      const char *msg,
+                                      struct sss_dp_req *sdp_req)
+{
+    if (sdp_req->dp_err == dp_err && sdp_req->dp_ret == dp_ret) {
+        return msg;
+    }
+
+    if (sdp_req->dp_err == DP_ERR_OK) {
+        return "Success";
+    }
+
+    return sss_strerror(sdp_req->dp_ret);
+}
+
+/* Passes the result stored in the first sdp_req, or the status of each
+ * key of a getAccountInfoMulti reply, to the callbacks of the keys */
+static void sss_dp_internal_get_finish(struct tevent_req *req, errno_t ret)
+{
+    struct sss_dp_req *sdp_req;
+    struct sss_dp_req *first;
+    struct sss_dp_callback *cb;
+    struct dp_internal_get_state *state;
+    struct sss_dp_req_state *cb_state;
+    dbus_uint16_t dp_err;
+    dbus_uint32_t dp_ret;
+    const char *err_msg;
+    size_t i;
+
+    state = tevent_req_data(req, struct dp_internal_get_state);
+    first = state->sdp_reqs[0];
 
-    ret = sss_dp_get_reply(pending,
-                           &sdp_req->dp_err,
-                           &sdp_req->dp_ret,
-                           &sdp_req->err_msg);
     if (ret != EOK) {
         if (ret == ETIME) {
-            sdp_req->dp_err = DP_ERR_TIMEOUT;
-            sdp_req->dp_ret = ret;
-            sdp_req->err_msg = talloc_strdup(sdp_req, "Request timed out");
+            first->dp_err = DP_ERR_TIMEOUT;
+            first->dp_ret = ret;
+            first->err_msg = talloc_strdup(first, "Request timed out");
         }
         else {
-            sdp_req->dp_err = DP_ERR_FATAL;
-            sdp_req->dp_ret = ret;
-            sdp_req->err_msg =
-                talloc_strdup(sdp_req,
+            first->dp_err = DP_ERR_FATAL;
+            first->dp_ret = ret;
+            first->err_msg =
+                talloc_strdup(first,
                               "Failed to get reply from Data Provider");
         }
     }
 
-    /* Check whether we need to issue any callbacks */
-    while ((cb = sdp_req->cb_list) != NULL) {
-        cb_state = tevent_req_data(cb->req, struct sss_dp_req_state);
-        cb_state->dp_err = sdp_req->dp_err;
-        cb_state->dp_ret = sdp_req->dp_ret;
-        cb_state->err_msg = talloc_strdup(cb_state, sdp_req->err_msg);
-        /* Don't bother checking for NULL. If it fails due to ENOMEM,
-         * we can't really handle it anyway.
-         */
+    sss_stats_record_since("responder.dp.request", &state->start);
+    sss_stats_count("responder.dp.keys", state->num_reqs);
+    if (ret != EOK || first->dp_err != DP_ERR_OK) {
+        sss_stats_count("responder.dp.failed", 1);
+    }
 
-        /* tevent_req_done/error will free cb */
-        if (ret == EOK) {
-            tevent_req_done(cb->req);
+    /* the first sdp_req gets the status of its own key below */
+    dp_err = first->dp_err;
+    dp_ret = first->dp_ret;
+
+    for (i = 0; i < state->num_reqs; i++) {
+        sdp_req = state->sdp_reqs[i];
+
+        if (ret == EOK && state->key_errs != NULL) {
+            sdp_req->dp_err = state->key_errs[i];
+            sdp_req->dp_ret = state->key_rets[i];
         } else {
-            tevent_req_error(cb->req, ret);
+            sdp_req->dp_err = dp_err;
+            sdp_req->dp_ret = dp_ret;
         }
+        err_msg = sss_dp_req_err_msg(dp_err, dp_ret, first->err_msg, sdp_req);
+
+        /* Check whether we need to issue any callbacks */
+        while ((cb = sdp_req->cb_list) != NULL) {
+            cb_state = tevent_req_data(cb->req, struct sss_dp_req_state);
+            cb_state->dp_err = sdp_req->dp_err;
+            cb_state->dp_ret = sdp_req->dp_ret;
+            cb_state->err_msg = talloc_strdup(cb_state, err_msg);
+            /* Don't bother checking for NULL. If it fails due to ENOMEM,
+             * we can't really handle it anyway.
+             */
+
+            /* tevent_req_done/error will free cb */
+            if (ret == EOK) {
+                tevent_req_done(cb->req);
+            } else {
+                tevent_req_error(cb->req, ret);
+            }
 
-        /* Freeing the cb removes it from the cb_list.
-         * Therefore, the cb_list should now be pointing
-         * at a new callback. If it's not, it means the
-         * callback handler didn't free cb and may leak
-         * memory. Be paranoid and protect against this
-         * situation.
-         */
-        if (cb == sdp_req->cb_list) {
-            DEBUG(SSSDBG_FATAL_FAILURE,
-                  "BUG: a callback did not free its request. "
-                   "May leak memory\n");
-            /* Skip to the next since a memory leak is non-fatal */
-            sdp_req->cb_list = sdp_req->cb_list->next;
+            /* Freeing the cb removes it from the cb_list.
+             * Therefore, the cb_list should now be pointing
+             * at a new callback. If it's not, it means the
+             * callback handler didn't free cb and may leak
+             * memory. Be paranoid and protect against this
+             * situation.
+             */
+            if (cb == sdp_req->cb_list) {
+                DEBUG(SSSDBG_FATAL_FAILURE,
+                      "BUG: a callback did not free its request. "
+                       "May leak memory\n");
+                /* Skip to the next since a memory leak is non-fatal */
+                sdp_req->cb_list = sdp_req->cb_list->next;
+            }
         }
     }
 
-    /* We're done with this request. Free the sdp_req
-     * This will clean up the hash table entry as well
+    /* We're done with this request. Free the sdp_reqs
+     * This will clean up the hash table entries as well
      */
-    talloc_zfree(sdp_req);
+    for (i = state->num_reqs; i > 0; i--) {
+        talloc_zfree(state->sdp_reqs[i - 1]);
+    }
+    state->num_reqs = 0;
 
     /* Free the sidereq to free the rest of the memory allocated with the
      * internal dp request. */
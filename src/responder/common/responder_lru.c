@@ -0,0 +1,448 @@
+/*
+    SSSD
+
+    responder_lru.c - In-memory LRU of recently used cache entries
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dhash.h>
+
+#include "util/util.h"
+#include "db/sysdb.h"
+#include "responder/common/responder_lru.h"
+
+enum resp_lru_type {
+    RESP_LRU_PWNAM,
+    RESP_LRU_PWUID,
+    RESP_LRU_GRNAM,
+    RESP_LRU_GRGID,
+    RESP_LRU_SID,
+};
+
+struct resp_lru_entry {
+    struct resp_lru_entry *prev;
+    struct resp_lru_entry *next;
+
+    char *key;
+    /* name of the domain which owns the backend, subdomain entries are
+     * invalidated together with their parent */
+    char *domain;
+    struct ldb_result *res;
+    time_t expire;
+};
+
+struct resp_lru {
+    hash_table_t *table;
+    /* most recently used entry first */
+    struct resp_lru_entry *entries;
+    struct resp_lru_entry *last;
+
+    size_t count;
+    size_t max_entries;
+    time_t timeout;
+
+    uint64_t hits;
+    uint64_t misses;
+};
+
+errno_t resp_lru_init(TALLOC_CTX *mem_ctx, size_t max_entries,
+                      time_t timeout, struct resp_lru **_lru)
+{
+    struct resp_lru *lru;
+    errno_t ret;
+
+    if (max_entries == 0 || timeout <= 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "Responder LRU is disabled\n");
+        *_lru = NULL;
+        return EOK;
+    }
+
+    lru = talloc_zero(mem_ctx, struct resp_lru);
+    if (lru == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_hash_create(lru, max_entries, &lru->table);
+    if (ret != EOK) {
+        talloc_free(lru);
+        return ret;
+    }
+
+    lru->max_entries = max_entries;
+    lru->timeout = timeout;
+
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "Responder LRU initialized with %zu entries and timeout %ld\n",
+          max_entries, (long) timeout);
+
+    *_lru = lru;
+    return EOK;
+}
+
+static const char *resp_lru_domain_name(struct sss_domain_info *domain)
+{
+    return IS_SUBDOMAIN(domain) ? domain->parent->name : domain->name;
+}
+
+static void resp_lru_remove(struct resp_lru *lru, struct resp_lru_entry *entry)
+{
+    hash_key_t key;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = entry->key;
+
+    hret = hash_delete(lru->table, &key);
+    if (hret != HASH_SUCCESS && hret != HASH_ERROR_KEY_NOT_FOUND) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to remove [%s] from the LRU [%d]: %s\n",
+              entry->key, hret, hash_error_string(hret));
+    }
+
+    if (lru->last == entry) {
+        lru->last = entry->prev;
+    }
+    DLIST_REMOVE(lru->entries, entry);
+    lru->count--;
+
+    talloc_free(entry);
+}
+
+static struct ldb_result *resp_lru_copy_result(TALLOC_CTX *mem_ctx,
+                                               struct ldb_result *res)
+{
+    struct ldb_result *copy;
+    unsigned int i;
+
+    copy = talloc_zero(mem_ctx, struct ldb_result);
+    if (copy == NULL) {
+        return NULL;
+    }
+
+    copy->msgs = talloc_array(copy, struct ldb_message *, res->count + 1);
+    if (copy->msgs == NULL) {
+        goto fail;
+    }
+
+    for (i = 0; i < res->count; i++) {
+        copy->msgs[i] = ldb_msg_copy(copy->msgs, res->msgs[i]);
+        if (copy->msgs[i] == NULL) {
+            goto fail;
+        }
+    }
+    copy->msgs[i] = NULL;
+    copy->count = res->count;
+
+    return copy;
+
+fail:
+    talloc_free(copy);
+    return NULL;
+}
+
+static char *resp_lru_key(TALLOC_CTX *mem_ctx, enum resp_lru_type type,
+                          struct sss_domain_info *domain, const char *key)
+{
+    return talloc_asprintf(mem_ctx, "%d:%s:%s", type, domain->name, key);
+}
+
+/* Returns a copy of the cached result or NULL */
+static struct ldb_result *resp_lru_get(TALLOC_CTX *mem_ctx,
+                                       struct resp_lru *lru,
+                                       const char *keystr)
+{
+    struct resp_lru_entry *entry;
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(keystr);
+
+    hret = hash_lookup(lru->table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        return NULL;
+    }
+
+    entry = talloc_get_type(value.ptr, struct resp_lru_entry);
+    if (entry->expire <= time(NULL)) {
+        DEBUG(SSSDBG_TRACE_INTERNAL, "LRU entry [%s] expired\n", keystr);
+        resp_lru_remove(lru, entry);
+        return NULL;
+    }
+
+    if (lru->entries != entry) {
+        if (lru->last == entry) {
+            lru->last = entry->prev;
+        }
+        DLIST_REMOVE(lru->entries, entry);
+        DLIST_ADD(lru->entries, entry);
+    }
+
+    return resp_lru_copy_result(mem_ctx, entry->res);
+}
+
+static void resp_lru_put(struct resp_lru *lru,
+                         struct sss_domain_info *domain,
+                         const char *keystr,
+                         struct ldb_result *res)
+{
+    struct resp_lru_entry *entry;
+    hash_key_t key;
+    hash_value_t value;
+    uint64_t cache_expire;
+    time_t now;
+    int hret;
+
+    if (res->count == 0) {
+        /* misses are handled by the negative cache */
+        return;
+    }
+
+    /* An entry which is already expired in sysdb will be refreshed by the
+     * caller, do not keep it so that the updated version is read after the
+     * refresh. Entries without expiration (e.g. in the local domain) are
+     * only limited by the timeout. */
+    now = time(NULL);
+    cache_expire = ldb_msg_find_attr_as_uint64(res->msgs[0],
+                                               SYSDB_CACHE_EXPIRE, 0);
+    if (cache_expire != 0 && cache_expire <= now) {
+        return;
+    }
+
+    while (lru->count >= lru->max_entries && lru->last != NULL) {
+        resp_lru_remove(lru, lru->last);
+    }
+
+    entry = talloc_zero(lru, struct resp_lru_entry);
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->key = talloc_strdup(entry, keystr);
+    entry->domain = talloc_strdup(entry, resp_lru_domain_name(domain));
+    entry->res = resp_lru_copy_result(entry, res);
+    if (entry->key == NULL || entry->domain == NULL || entry->res == NULL) {
+        talloc_free(entry);
+        return;
+    }
+    entry->expire = now + lru->timeout;
+    if (cache_expire != 0 && cache_expire < entry->expire) {
+        entry->expire = cache_expire;
+    }
+
+    key.type = HASH_KEY_STRING;
+    key.str = entry->key;
+    value.type = HASH_VALUE_PTR;
+    value.ptr = entry;
+
+    hret = hash_enter(lru->table, &key, &value);
+    if (hret != HASH_SUCCESS) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to add [%s] to the LRU [%d]: %s\n",
+              keystr, hret, hash_error_string(hret));
+        talloc_free(entry);
+        return;
+    }
+
+    DLIST_ADD(lru->entries, entry);
+    if (lru->last == NULL) {
+        lru->last = entry;
+    }
+    lru->count++;
+}
+
+/* Removes an existing entry with the same key, e.g. an expired one which
+ * was looked up again */
+static void resp_lru_drop(struct resp_lru *lru, const char *keystr)
+{
+    hash_key_t key;
+    hash_value_t value;
+    int hret;
+
+    key.type = HASH_KEY_STRING;
+    key.str = discard_const(keystr);
+
+    hret = hash_lookup(lru->table, &key, &value);
+    if (hret == HASH_SUCCESS) {
+        resp_lru_remove(lru, talloc_get_type(value.ptr,
+                                             struct resp_lru_entry));
+    }
+}
+
+static errno_t resp_lru_search(TALLOC_CTX *mem_ctx,
+                               struct resp_lru *lru,
+                               enum resp_lru_type type,
+                               struct sss_domain_info *domain,
+                               const char *name,
+                               uint32_t id,
+                               struct ldb_result **_res)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct ldb_result *res = NULL;
+    char *keystr = NULL;
+    char *idstr;
+    errno_t ret;
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        return ENOMEM;
+    }
+
+    if (lru != NULL) {
+        if (name != NULL) {
+            keystr = resp_lru_key(tmp_ctx, type, domain, name);
+        } else {
+            idstr = talloc_asprintf(tmp_ctx, "%"PRIu32, id);
+            if (idstr == NULL) {
+                ret = ENOMEM;
+                goto done;
+            }
+            keystr = resp_lru_key(tmp_ctx, type, domain, idstr);
+        }
+        if (keystr == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+
+        res = resp_lru_get(mem_ctx, lru, keystr);
+        if (res != NULL) {
+            lru->hits++;
+            DEBUG(SSSDBG_TRACE_INTERNAL, "LRU hit for [%s]\n", keystr);
+            *_res = res;
+            ret = EOK;
+            goto done;
+        }
+
+        lru->misses++;
+    }
+
+    switch (type) {
+    case RESP_LRU_PWNAM:
+        ret = sysdb_getpwnam_with_views(tmp_ctx, domain, name, &res);
+        break;
+    case RESP_LRU_PWUID:
+        ret = sysdb_getpwuid_with_views(tmp_ctx, domain, id, &res);
+        break;
+    case RESP_LRU_GRNAM:
+        ret = sysdb_getgrnam_with_views(tmp_ctx, domain, name, &res);
+        break;
+    case RESP_LRU_GRGID:
+        ret = sysdb_getgrgid_with_views(tmp_ctx, domain, id, &res);
+        break;
+    case RESP_LRU_SID:
+        ret = sysdb_search_object_by_sid(tmp_ctx, domain, name, NULL, &res);
+        break;
+    default:
+        ret = EINVAL;
+        break;
+    }
+    if (ret != EOK) {
+        goto done;
+    }
+
+    if (lru != NULL) {
+        resp_lru_drop(lru, keystr);
+        resp_lru_put(lru, domain, keystr, res);
+    }
+
+    *_res = talloc_steal(mem_ctx, res);
+
+done:
+    talloc_free(tmp_ctx);
+    return ret;
+}
+
+errno_t resp_lru_getpwnam(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                          struct sss_domain_info *domain, const char *name,
+                          struct ldb_result **_res)
+{
+    return resp_lru_search(mem_ctx, lru, RESP_LRU_PWNAM, domain, name, 0,
+                           _res);
+}
+
+errno_t resp_lru_getpwuid(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                          struct sss_domain_info *domain, uid_t uid,
+                          struct ldb_result **_res)
+{
+    return resp_lru_search(mem_ctx, lru, RESP_LRU_PWUID, domain, NULL, uid,
+                           _res);
+}
+
+errno_t resp_lru_getgrnam(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                          struct sss_domain_info *domain, const char *name,
+                          struct ldb_result **_res)
+{
+    return resp_lru_search(mem_ctx, lru, RESP_LRU_GRNAM, domain, name, 0,
+                           _res);
+}
+
+errno_t resp_lru_getgrgid(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                          struct sss_domain_info *domain, gid_t gid,
+                          struct ldb_result **_res)
+{
+    return resp_lru_search(mem_ctx, lru, RESP_LRU_GRGID, domain, NULL, gid,
+                           _res);
+}
+
+errno_t resp_lru_search_by_sid(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                               struct sss_domain_info *domain,
+                               const char *sid_str, const char **attrs,
+                               struct ldb_result **_res)
+{
+    if (attrs != NULL) {
+        return sysdb_search_object_by_sid(mem_ctx, domain, sid_str, attrs,
+                                          _res);
+    }
+
+    return resp_lru_search(mem_ctx, lru, RESP_LRU_SID, domain, sid_str, 0,
+                           _res);
+}
+
+void resp_lru_invalidate(struct resp_lru *lru, const char *domain_name)
+{
+    struct resp_lru_entry *entry;
+    struct resp_lru_entry *next;
+
+    if (lru == NULL) {
+        return;
+    }
+
+    DEBUG(SSSDBG_TRACE_FUNC, "Invalidating LRU entries of [%s]\n",
+          domain_name ? domain_name : "all domains");
+
+    for (entry = lru->entries; entry != NULL; entry = next) {
+        next = entry->next;
+
+        if (domain_name == NULL
+                || strcasecmp(entry->domain, domain_name) == 0) {
+            resp_lru_remove(lru, entry);
+        }
+    }
+}
+
+void resp_lru_get_stats(struct resp_lru *lru, struct resp_lru_stats *stats)
+{
+    if (lru == NULL) {
+        memset(stats, 0, sizeof(struct resp_lru_stats));
+        return;
+    }
+
+    stats->hits = lru->hits;
+    stats->misses = lru->misses;
+    stats->count = lru->count;
+}
@@ -0,0 +1,76 @@
+/*
+    SSSD
+
+    responder_lru.h - In-memory LRU of recently used cache entries
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RESPONDER_LRU_H_
+#define _RESPONDER_LRU_H_
+
+#include "util/util.h"
+#include "db/sysdb.h"
+
+/* The LRU keeps a parsed copy of the sysdb search results for the most
+ * recently requested users and groups so that repeated lookups of hot
+ * entries do not have to go through ldb. An entry is dropped when its
+ * sysdb cache expiration passes, when it is older than the configured
+ * timeout, or when the backend reports that it updated the domain.
+ *
+ * All lookup functions fall back to a plain sysdb search if lru is NULL.
+ * Results are always allocated on mem_ctx and may be modified by the
+ * caller. */
+
+struct resp_lru;
+
+struct resp_lru_stats {
+    uint64_t hits;
+    uint64_t misses;
+    size_t count;
+};
+
+errno_t resp_lru_init(TALLOC_CTX *mem_ctx, size_t max_entries,
+                      time_t timeout, struct resp_lru **_lru);
+
+errno_t resp_lru_getpwnam(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                          struct sss_domain_info *domain, const char *name,
+                          struct ldb_result **_res);
+
+errno_t resp_lru_getpwuid(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                          struct sss_domain_info *domain, uid_t uid,
+                          struct ldb_result **_res);
+
+errno_t resp_lru_getgrnam(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                          struct sss_domain_info *domain, const char *name,
+                          struct ldb_result **_res);
+
+errno_t resp_lru_getgrgid(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                          struct sss_domain_info *domain, gid_t gid,
+                          struct ldb_result **_res);
+
+/* Only lookups requesting all attributes (attrs == NULL) are cached */
+errno_t resp_lru_search_by_sid(TALLOC_CTX *mem_ctx, struct resp_lru *lru,
+                               struct sss_domain_info *domain,
+                               const char *sid_str, const char **attrs,
+                               struct ldb_result **_res);
+
+/* Drop all entries of the domain, or all entries if domain_name is NULL */
+void resp_lru_invalidate(struct resp_lru *lru, const char *domain_name);
+
+void resp_lru_get_stats(struct resp_lru *lru, struct resp_lru_stats *stats);
+
+#endif /* _RESPONDER_LRU_H_ */
@@ -55,6 +55,7 @@ struct mon_cli_iface monitor_ifp_methods = {
     .resetOffline = NULL,
     .rotateLogs = responder_logrotate,
     .sysbusReconnect = ifp_sysbus_reconnect,
+    .getStats = monitor_common_get_stats,
 };
 
 static struct data_provider_iface ifp_dp_methods = {
@@ -66,6 +67,7 @@ static struct data_provider_iface ifp_dp_methods = {
     .hostHandler = NULL,
     .getDomains = NULL,
     .getAccountInfo = NULL,
+    .getAccountInfoMulti = NULL,
 };
 
 struct infopipe_iface ifp_iface = {
@@ -69,6 +69,7 @@ struct mon_cli_iface monitor_nss_methods = {
     .clearMemcache = nss_clear_memcache,
     .clearEnumCache = nss_clear_netgroup_hash_table,
     .sysbusReconnect = NULL,
+    .getStats = monitor_common_get_stats,
 };
 
 static int nss_clear_memcache(struct sbus_request *dbus_req, void *data)
@@ -78,6 +79,17 @@ static int nss_clear_memcache(struct sbus_request *dbus_req, void *data)
     struct resp_ctx *rctx = talloc_get_type(data, struct resp_ctx);
     struct nss_ctx *nctx = (struct nss_ctx*) rctx->pvt_ctx;
 
+    if (nctx->worker > 0) {
+        /* The flag belongs to the main process which re-creates the
+         * memory caches, the workers map the new files on their next
+         * change. The monitor signals all processes at once, so the main
+         * process might already have removed the flag, the workers drop
+         * their in-memory copies unconditionally. */
+        DEBUG(SSSDBG_TRACE_FUNC, "Clearing in-memory lookup tables.\n");
+        resp_lru_invalidate(rctx->lru, NULL);
+        goto done;
+    }
+
     ret = unlink(SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG);
     if (ret != 0) {
         ret = errno;
@@ -104,24 +116,38 @@ static int nss_clear_memcache(struct sbus_request *dbus_req, void *data)
         return ret;
     }
 
-    /* TODO: read cache sizes from configuration */
+    /* The caches keep their current, possibly grown, size */
     DEBUG(SSSDBG_TRACE_FUNC, "Clearing memory caches.\n");
-    ret = sss_mmap_cache_reinit(nctx, SSS_MC_CACHE_ELEMENTS,
-                                (time_t) memcache_timeout,
-                                &nctx->pwd_mc_ctx);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "passwd mmap cache invalidation failed\n");
-        return ret;
+    resp_lru_invalidate(rctx->lru, NULL);
+
+    if (nctx->pwd_mc_ctx != NULL) {
+        ret = sss_mmap_cache_reinit(nctx, -1, -1, (time_t) memcache_timeout,
+                                    &nctx->pwd_mc_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "passwd mmap cache invalidation failed\n");
+            return ret;
+        }
     }
 
-    ret = sss_mmap_cache_reinit(nctx, SSS_MC_CACHE_ELEMENTS,
-                                (time_t) memcache_timeout,
-                                &nctx->grp_mc_ctx);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "group mmap cache invalidation failed\n");
-        return ret;
+    if (nctx->grp_mc_ctx != NULL) {
+        ret = sss_mmap_cache_reinit(nctx, -1, -1, (time_t) memcache_timeout,
+                                    &nctx->grp_mc_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "group mmap cache invalidation failed\n");
+            return ret;
+        }
+    }
+
+    if (nctx->sid_mc_ctx != NULL) {
+        ret = sss_mmap_cache_reinit(nctx, -1, -1, (time_t) memcache_timeout,
+                                    &nctx->sid_mc_ctx);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "sid mmap cache invalidation failed\n");
+            return ret;
+        }
     }
 
 done:
@@ -330,6 +356,7 @@ static int nss_update_memcache(struct sbus_request *dbus_req, void *data)
 
     nss_update_pw_memcache(nctx);
     nss_update_gr_memcache(nctx);
+    resp_lru_invalidate(rctx->lru, NULL);
 
     return EOK;
 }
@@ -362,7 +389,8 @@ static int nss_memcache_initgr_check(struct sbus_request *dbus_req, void *data)
 static struct data_provider_rev_iface nss_dp_methods = {
     { &data_provider_rev_iface_meta, 0 },
     .updateCache = nss_update_memcache,
-    .initgrCheck = nss_memcache_initgr_check
+    .initgrCheck = nss_memcache_initgr_check,
+    .invalidateCache = responder_invalidate_lru,
 };
 
 static void nss_dp_reconnect_init(struct sbus_connection *conn,
@@ -394,30 +422,65 @@ static void nss_dp_reconnect_init(struct sbus_connection *conn,
     /* nss_shutdown(rctx); */
 }
 
+/* The main process creates the memory cache files, the workers store into
+ * the same files */
+static errno_t nss_mmap_cache_open(struct nss_ctx *nctx, const char *name,
+                                   enum sss_mc_type type, int n_elem,
+                                   time_t timeout, struct sss_mc_ctx **_mcc)
+{
+    if (nctx->worker > 0) {
+        return sss_mmap_cache_attach(nctx, name, type,
+                                     n_elem * SSS_MC_CACHE_MAX_GROWTH,
+                                     timeout, _mcc);
+    }
+
+    return sss_mmap_cache_init(nctx, name, type, n_elem,
+                               n_elem * SSS_MC_CACHE_MAX_GROWTH,
+                               timeout, _mcc);
+}
+
 int nss_process_init(TALLOC_CTX *mem_ctx,
                      struct tevent_context *ev,
-                     struct confdb_ctx *cdb)
+                     struct confdb_ctx *cdb,
+                     int pipe_fd,
+                     int worker)
 {
     struct resp_ctx *rctx;
     struct sss_cmd_table *nss_cmds;
     struct be_conn *iter;
     struct nss_ctx *nctx;
     int memcache_timeout;
+    int mc_size_passwd;
+    int mc_size_group;
+    int mc_size_sid;
     int ret, max_retries;
     enum idmap_error_code err;
     int hret;
     int fd_limit;
+    const char *svc_name = NSS_SBUS_SERVICE_NAME;
+    const char *cli_name = "NSS";
 
     nss_cmds = get_nss_cmds();
 
+    if (worker > 0) {
+        /* The monitor and the back ends tell the workers apart from the
+         * main process by their names */
+        svc_name = talloc_asprintf(mem_ctx, "%s_worker%d",
+                                   NSS_SBUS_SERVICE_NAME, worker);
+        if (svc_name == NULL) {
+            return ENOMEM;
+        }
+        cli_name = "NSS worker";
+    }
+
     ret = sss_process_init(mem_ctx, ev, cdb,
                            nss_cmds,
-                           SSS_NSS_SOCKET_NAME, -1, NULL, -1,
+                           SSS_NSS_SOCKET_NAME, pipe_fd, NULL, -1,
                            CONFDB_NSS_CONF_ENTRY,
-                           NSS_SBUS_SERVICE_NAME,
+                           svc_name,
                            NSS_SBUS_SERVICE_VERSION,
                            &monitor_nss_methods,
-                           "NSS", &nss_dp_methods.vtable,
+                           cli_name, &nss_dp_methods.vtable,
                            &rctx);
     if (ret != EOK) {
         DEBUG(SSSDBG_FATAL_FAILURE, "sss_process_init() failed\n");
@@ -440,6 +503,7 @@ int nss_process_init(TALLOC_CTX *mem_ctx,
 
     nctx->rctx = rctx;
     nctx->rctx->pvt_ctx = nctx;
+    nctx->worker = worker;
 
     ret = nss_get_config(nctx, cdb);
     if (ret != EOK) {
@@ -482,14 +546,18 @@ int nss_process_init(TALLOC_CTX *mem_ctx,
     }
 
     /* create mmap caches */
-    /* Remove the CLEAR_MC_FLAG file if exists. */
-    ret = unlink(SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG);
-    if (ret != 0 && errno != ENOENT) {
-        ret = errno;
-        DEBUG(SSSDBG_CRIT_FAILURE,
-              "Failed to unlink file [%s]. This can cause memory cache to "
-               "be purged when next log rotation is requested. %d: %s\n",
-               SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG, ret, strerror(ret));
+    /* Remove the CLEAR_MC_FLAG file if exists. The flag is handled by the
+     * main process, which is the one re-creating the caches. */
+    if (worker == 0) {
+        ret = unlink(SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG);
+        if (ret != 0 && errno != ENOENT) {
+            ret = errno;
+            DEBUG(SSSDBG_CRIT_FAILURE,
+                  "Failed to unlink file [%s]. This can cause memory cache "
+                  "to be purged when next log rotation is requested. "
+                  "%d: %s\n",
+                  SSS_NSS_MCACHE_DIR"/"CLEAR_MC_FLAG, ret, strerror(ret));
+        }
     }
 
     ret = confdb_get_int(nctx->rctx->cdb,
@@ -502,19 +570,67 @@ int nss_process_init(TALLOC_CTX *mem_ctx,
         goto fail;
     }
 
-    /* TODO: read cache sizes from configuration */
-    ret = sss_mmap_cache_init(nctx, "passwd", SSS_MC_PASSWD,
-                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
-                              &nctx->pwd_mc_ctx);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "passwd mmap cache is DISABLED\n");
+    ret = confdb_get_int(nctx->rctx->cdb,
+                         CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_MEMCACHE_SIZE_PASSWD,
+                         SSS_MC_CACHE_ELEMENTS, &mc_size_passwd);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_size_passwd' option from confdb.\n");
+        goto fail;
+    }
+
+    ret = confdb_get_int(nctx->rctx->cdb,
+                         CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_MEMCACHE_SIZE_GROUP,
+                         SSS_MC_CACHE_ELEMENTS, &mc_size_group);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_size_group' option from confdb.\n");
+        goto fail;
+    }
+
+    ret = confdb_get_int(nctx->rctx->cdb,
+                         CONFDB_NSS_CONF_ENTRY,
+                         CONFDB_NSS_MEMCACHE_SIZE_SID,
+                         SSS_MC_CACHE_ELEMENTS, &mc_size_sid);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Failed to get 'memcache_size_sid' option from confdb.\n");
+        goto fail;
+    }
+
+    if (mc_size_passwd > 0) {
+        ret = nss_mmap_cache_open(nctx, "passwd", SSS_MC_PASSWD, mc_size_passwd,
+                                  (time_t)memcache_timeout,
+                                  &nctx->pwd_mc_ctx);
+        if (ret) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "passwd mmap cache is DISABLED\n");
+        }
+    } else {
+        DEBUG(SSSDBG_CONF_SETTINGS, "passwd mmap cache is disabled\n");
     }
 
-    ret = sss_mmap_cache_init(nctx, "group", SSS_MC_GROUP,
-                              SSS_MC_CACHE_ELEMENTS, (time_t)memcache_timeout,
-                              &nctx->grp_mc_ctx);
-    if (ret) {
-        DEBUG(SSSDBG_CRIT_FAILURE, "group mmap cache is DISABLED\n");
+    if (mc_size_group > 0) {
+        ret = nss_mmap_cache_open(nctx, "group", SSS_MC_GROUP, mc_size_group,
+                                  (time_t)memcache_timeout,
+                                  &nctx->grp_mc_ctx);
+        if (ret) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "group mmap cache is DISABLED\n");
+        }
+    } else {
+        DEBUG(SSSDBG_CONF_SETTINGS, "group mmap cache is disabled\n");
+    }
+
+    if (mc_size_sid > 0) {
+        ret = nss_mmap_cache_open(nctx, "sid", SSS_MC_SID, mc_size_sid,
+                                  (time_t)memcache_timeout,
+                                  &nctx->sid_mc_ctx);
+        if (ret) {
+            DEBUG(SSSDBG_CRIT_FAILURE, "sid mmap cache is DISABLED\n");
+        }
+    } else {
+        DEBUG(SSSDBG_CONF_SETTINGS, "sid mmap cache is disabled\n");
     }
 
     /* Set up file descriptor limits */
@@ -559,11 +675,18 @@ int main(int argc, const char *argv[])
     int ret;
     uid_t uid;
     gid_t gid;
+    int pipe_fd = -1;
+    int worker = 0;
+    const char *prg_name = "sssd[nss]";
 
     struct poptOption long_options[] = {
         POPT_AUTOHELP
         SSSD_MAIN_OPTS
         SSSD_SERVER_OPTS(uid, gid)
+        {"socket-fd", 0, POPT_ARG_INT, &pipe_fd, 0,
+          _("Listening socket inherited from the monitor"), NULL},
+        {"worker", 0, POPT_ARG_INT, &worker, 0,
+          _("Index of the NSS worker process"), NULL},
         POPT_TABLEEND
     };
 
@@ -589,8 +712,15 @@ int main(int argc, const char *argv[])
 
     /* set up things like debug, signals, daemonization, etc... */
     debug_log_file = "sssd_nss";
+    if (worker > 0) {
+        debug_log_file = talloc_asprintf(NULL, "sssd_nss_worker%d", worker);
+        prg_name = talloc_asprintf(NULL, "sssd[nss_worker%d]", worker);
+        if (debug_log_file == NULL || prg_name == NULL) {
+            return 2;
+        }
+    }
 
-    ret = server_setup("sssd[nss]", 0, uid, gid, CONFDB_NSS_CONF_ENTRY,
+    ret = server_setup(prg_name, 0, uid, gid, CONFDB_NSS_CONF_ENTRY,
                        &main_ctx);
     if (ret != EOK) return 2;
 
@@ -603,7 +733,8 @@ int main(int argc, const char *argv[])
 
     ret = nss_process_init(main_ctx,
                            main_ctx->event_ctx,
-                           main_ctx->confdb_ctx);
+                           main_ctx->confdb_ctx,
+                           pipe_fd, worker);
     if (ret != EOK) return 3;
 
     /* loop on main */
@@ -70,8 +70,12 @@ struct nss_ctx {
     char *shell_fallback;
     char *default_shell;
 
+    /* Worker 0 creates the memory caches, the other workers attach to
+     * them */
+    int worker;
     struct sss_mc_ctx *pwd_mc_ctx;
     struct sss_mc_ctx *grp_mc_ctx;
+    struct sss_mc_ctx *sid_mc_ctx;
 
     struct sss_idmap_ctx *idmap_ctx;
     struct sss_names_ctx *global_names;
@@ -44,6 +44,75 @@ static int nss_cmd_send_empty(struct nss_cmd_ctx *cmdctx)
     return sss_cmd_send_empty(cctx, cmdctx);
 }
 
+/* The lookup failed in all domains, remember that in the memory cache so
+ * that the clients do not have to ask again until the negative cache
+ * entry would expire */
+static void nss_store_negative_memcache(struct nss_cmd_ctx *cmdctx)
+{
+    struct nss_ctx *nctx;
+    struct sized_string key;
+    uint8_t *body;
+    size_t blen;
+    errno_t ret;
+
+    nctx = talloc_get_type(cmdctx->cctx->rctx->pvt_ctx, struct nss_ctx);
+    if (nctx->neg_timeout <= 0) {
+        return;
+    }
+
+    switch (cmdctx->cmd) {
+    case SSS_NSS_GETPWNAM:
+    case SSS_NSS_GETGRNAM:
+        if ((cmdctx->cmd == SSS_NSS_GETPWNAM && nctx->pwd_mc_ctx == NULL)
+                || (cmdctx->cmd == SSS_NSS_GETGRNAM
+                        && nctx->grp_mc_ctx == NULL)) {
+            return;
+        }
+
+        /* the clients look up the name exactly as they sent it */
+        sss_packet_get_body(cmdctx->cctx->creq->in, &body, &blen);
+        if (blen == 0 || body[blen - 1] != '\0') {
+            return;
+        }
+        to_sized_string(&key, (const char *)body);
+
+        if (cmdctx->cmd == SSS_NSS_GETPWNAM) {
+            ret = sss_mmap_cache_pw_store_negative(&nctx->pwd_mc_ctx, &key,
+                                                   nctx->neg_timeout);
+        } else {
+            ret = sss_mmap_cache_gr_store_negative(&nctx->grp_mc_ctx, &key,
+                                                   nctx->neg_timeout);
+        }
+        break;
+    case SSS_NSS_GETPWUID:
+        if (nctx->pwd_mc_ctx == NULL) {
+            return;
+        }
+
+        ret = sss_mmap_cache_pw_store_negative_uid(&nctx->pwd_mc_ctx,
+                                                   cmdctx->id,
+                                                   nctx->neg_timeout);
+        break;
+    case SSS_NSS_GETGRGID:
+        if (nctx->grp_mc_ctx == NULL) {
+            return;
+        }
+
+        ret = sss_mmap_cache_gr_store_negative_gid(&nctx->grp_mc_ctx,
+                                                   cmdctx->id,
+                                                   nctx->neg_timeout);
+        break;
+    default:
+        return;
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to store negative entry in the memory cache [%d]: %s\n",
+              ret, sss_strerror(ret));
+    }
+}
+
 int nss_cmd_done(struct nss_cmd_ctx *cmdctx, int ret)
 {
     switch (ret) {
@@ -52,6 +121,7 @@ int nss_cmd_done(struct nss_cmd_ctx *cmdctx, int ret)
         break;
 
     case ENOENT:
+        nss_store_negative_memcache(cmdctx);
         ret = nss_cmd_send_empty(cmdctx);
         if (ret) {
             return EFAULT;
@@ -896,7 +966,8 @@ static int nss_cmd_getpwnam_search(struct nss_dom_ctx *dctx)
                 dctx->res->msgs[0] = talloc_steal(dctx->res->msgs, msg);
             }
         } else {
-            ret = sysdb_getpwnam_with_views(cmdctx, dom, name, &dctx->res);
+            ret = resp_lru_getpwnam(cmdctx, cctx->rctx->lru, dom, name,
+                                    &dctx->res);
         }
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE,
@@ -1575,7 +1646,8 @@ static int nss_cmd_getpwuid_search(struct nss_dom_ctx *dctx)
             goto done;
         }
 
-        ret = sysdb_getpwuid_with_views(cmdctx, dom, cmdctx->id, &dctx->res);
+        ret = resp_lru_getpwuid(cmdctx, cctx->rctx->lru, dom, cmdctx->id,
+                                &dctx->res);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE,
                   "Failed to make request to our cache!\n");
@@ -3005,7 +3077,8 @@ static int nss_cmd_getgrnam_search(struct nss_dom_ctx *dctx)
             return EIO;
         }
 
-        ret = sysdb_getgrnam_with_views(cmdctx, dom, name, &dctx->res);
+        ret = resp_lru_getgrnam(cmdctx, cctx->rctx->lru, dom, name,
+                                &dctx->res);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE,
                   "Failed to make request to our cache!\n");
@@ -3146,7 +3219,8 @@ static int nss_cmd_getgrgid_search(struct nss_dom_ctx *dctx)
             goto done;
         }
 
-        ret = sysdb_getgrgid_with_views(cmdctx, dom, cmdctx->id, &dctx->res);
+        ret = resp_lru_getgrgid(cmdctx, cctx->rctx->lru, dom, cmdctx->id,
+                                &dctx->res);
         if (ret != EOK) {
             DEBUG(SSSDBG_CRIT_FAILURE,
                   "Failed to make request to our cache!\n");
@@ -4529,8 +4603,8 @@ static errno_t nss_cmd_getbysid_search(struct nss_dom_ctx *dctx)
         return EIO;
     }
 
-    ret = sysdb_search_object_by_sid(cmdctx, dom, cmdctx->secid, NULL,
-                                     &dctx->res);
+    ret = resp_lru_search_by_sid(cmdctx, cctx->rctx->lru, dom, cmdctx->secid,
+                                 NULL, &dctx->res);
     if (ret == ENOENT) {
         if (!dctx->check_provider) {
             DEBUG(SSSDBG_OP_FAILURE, "No results for getbysid call.\n");
@@ -4935,6 +5009,63 @@ static errno_t fill_id(struct sss_packet *packet,
     return EOK;
 }
 
+/* Remember the SID in the memory cache so that the clients can map it
+ * without asking the responder */
+static void nss_update_sid_memcache(struct nss_cmd_ctx *cmdctx,
+                                    enum sss_id_type id_type,
+                                    struct ldb_message *msg)
+{
+    struct nss_ctx *nctx;
+    struct sized_string sid;
+    struct sized_string name;
+    struct sized_string *pname = NULL;
+    const char *sid_str;
+    uint64_t tmp_id;
+    uint8_t *body;
+    size_t blen;
+    errno_t ret;
+
+    nctx = talloc_get_type(cmdctx->cctx->rctx->pvt_ctx, struct nss_ctx);
+    if (nctx->sid_mc_ctx == NULL) {
+        return;
+    }
+
+    sid_str = ldb_msg_find_attr_as_string(msg, SYSDB_SID_STR, NULL);
+    if (sid_str == NULL) {
+        return;
+    }
+    to_sized_string(&sid, sid_str);
+
+    if (id_type == SSS_ID_TYPE_GID) {
+        tmp_id = ldb_msg_find_attr_as_uint64(msg, SYSDB_GIDNUM, 0);
+    } else {
+        tmp_id = ldb_msg_find_attr_as_uint64(msg, SYSDB_UIDNUM, 0);
+    }
+
+    if (tmp_id == 0 || tmp_id >= UINT32_MAX) {
+        return;
+    }
+
+    if (cmdctx->cmd == SSS_NSS_GETNAMEBYSID) {
+        /* store exactly the name which was sent to the client */
+        sss_packet_get_body(cmdctx->cctx->creq->out, &body, &blen);
+        if (blen > 3 * sizeof(uint32_t) && body[blen - 1] == '\0') {
+            to_sized_string(&name, (const char *)body + 3 * sizeof(uint32_t));
+            pname = &name;
+        }
+    }
+
+    ret = sss_mmap_cache_sid_store(&nctx->sid_mc_ctx, &sid, pname,
+                                   (uint32_t)tmp_id, id_type,
+                                   cmdctx->cmd == SSS_NSS_GETSIDBYID
+                                        && cmdctx->id == tmp_id);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Failed to store SID [%s] in the memory cache [%d]: %s\n",
+              sid_str, ret, sss_strerror(ret));
+    }
+}
+
 static errno_t nss_cmd_getbysid_send_reply(struct nss_dom_ctx *dctx)
 {
     struct nss_cmd_ctx *cmdctx = dctx->cmdctx;
@@ -4988,6 +5119,8 @@ static errno_t nss_cmd_getbysid_send_reply(struct nss_dom_ctx *dctx)
         return ret;
     }
 
+    nss_update_sid_memcache(cmdctx, id_type, dctx->res->msgs[0]);
+
     sss_packet_set_error(cctx->creq->out, EOK);
     sss_cmd_done(cctx, cmdctx);
     return EOK;
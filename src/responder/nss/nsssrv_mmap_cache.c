@@ -20,8 +20,10 @@
 */
 
 #include "util/util.h"
+#include "util/sss_stats.h"
 #include "confdb/confdb.h"
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include "util/mmap_cache.h"
 #include "responder/nss/nsssrv.h"
@@ -31,6 +33,8 @@
 #define SSS_AVG_PASSWD_PAYLOAD (MC_SLOT_SIZE * 4)
 /* short group name and no gids (private user group */
 #define SSS_AVG_GROUP_PAYLOAD (MC_SLOT_SIZE * 3)
+/* domain SID with a RID and a short fully qualified name */
+#define SSS_AVG_SID_PAYLOAD (MC_SLOT_SIZE * 3)
 
 #define MC_NEXT_BARRIER(val) ((((val) + 1) & 0x00ffffff) | 0xf0000000)
 
@@ -49,6 +53,11 @@
     __sync_synchronize(); \
 } while (0)
 
+/* The first byte of the file is locked by the process which created it for
+ * as long as it uses the file. The second one is locked by whichever NSS
+ * process is modifying the cache. */
+#define MC_WRITER_LOCK_OFFSET 1
+
 struct sss_mc_ctx {
     char *name;             /* mmap cache name */
     enum sss_mc_type type;  /* mmap cache type */
@@ -70,6 +79,12 @@ struct sss_mc_ctx {
 
     uint8_t *data_table;    /* data table address (in mmap) */
     uint32_t dt_size;       /* size of data table */
+
+    size_t n_elem;          /* number of elements the cache was sized for */
+    size_t max_elem;        /* number of elements the cache may grow to */
+    uint32_t live_evictions; /* unexpired records recycled to make room */
+
+    int lock_depth;         /* nesting of sss_mc_lock() calls */
 };
 
 #define MC_FIND_BIT(base, num) \
@@ -315,6 +330,7 @@ static void sss_mc_invalidate_rec(struct sss_mc_ctx *mcc,
     rec->next2 = MC_INVALID_VAL32;
     rec->hash1 = MC_INVALID_VAL32;
     rec->hash2 = MC_INVALID_VAL32;
+    rec->flags = MC_INVALID_VAL32;
     MC_LOWER_BARRIER(rec);
 }
 
@@ -372,97 +388,274 @@ static bool sss_mc_is_valid_rec(struct sss_mc_ctx *mcc, struct sss_mc_rec *rec)
     return true;
 }
 
-/* FIXME: This is a very simplistic, inefficient, memory allocator,
- * it will just free the oldest entries regardless of expiration if it
- * cycled the whole freebits map and found no empty slot */
-static errno_t sss_mc_find_free_slots(struct sss_mc_ctx *mcc,
-                                      int num_slots, uint32_t *free_slot)
+/* Returns 64 entries of the free table starting at slot word * 64, the
+ * first slot in the most significant bit. Slots past the end of the table
+ * are reported as used. */
+static inline uint64_t sss_mc_ft_used_word(struct sss_mc_ctx *mcc,
+                                           uint32_t word)
 {
-    struct sss_mc_rec *rec;
-    uint32_t tot_slots;
-    uint32_t cur;
+    uint32_t first = word * 8;
+    uint64_t used = 0;
     uint32_t i;
-    uint32_t t;
-    bool used;
 
-    tot_slots = mcc->ft_size * 8;
+    for (i = 0; i < 8; i++) {
+        used <<= 8;
+        if (first + i < mcc->ft_size) {
+            used |= mcc->free_table[first + i];
+        } else {
+            used |= 0xff;
+        }
+    }
 
-    /* Try to find a free slot w/o removing anything first */
-    /* FIXME: is it really worth it ? May be it is easier to
-     * just recycle the next set of slots ? */
-    if ((mcc->next_slot + num_slots) > tot_slots) {
-        cur = 0;
-    } else {
-        cur = mcc->next_slot;
+    return used;
+}
+
+static inline uint32_t sss_mc_clz64(uint64_t val)
+{
+    return val == 0 ? 64 : __builtin_clzll(val);
+}
+
+/* Number of slots currently in use */
+static uint32_t sss_mc_used_slots(struct sss_mc_ctx *mcc)
+{
+    uint32_t words = (mcc->ft_size + 7) / 8;
+    uint32_t used = 0;
+    uint32_t i;
+
+    for (i = 0; i < words; i++) {
+        used += __builtin_popcountll(sss_mc_ft_used_word(mcc, i));
     }
 
-    /* search for enough (num_slots) consecutive zero bits, indicating
-     * consecutive empty slots */
-    for (i = 0; i < mcc->ft_size; i++) {
-        t = cur / 8;
-        /* if all full in this byte skip directly to the next */
-        if (mcc->free_table[t] == 0xff) {
-            cur = ((cur + 8) & ~7);
-            if (cur >= tot_slots) {
-                cur = 0;
+    /* do not count the padding after the end of the table */
+    return used - (words * 64 - mcc->ft_size * 8);
+}
+
+/* Look for num_slots consecutive free slots, a word of the free table at a
+ * time, starting at the slot 'from'. Once the search wraps around the end
+ * of the table runs may start anywhere. */
+static bool sss_mc_find_free_run(struct sss_mc_ctx *mcc, uint32_t num_slots,
+                                 uint32_t from, uint32_t *free_slot)
+{
+    uint32_t words = (mcc->ft_size + 7) / 8;
+    uint32_t run = 0;
+    uint32_t run_start = 0;
+    uint64_t free_bits;
+    uint64_t bits;
+    uint32_t word;
+    uint32_t pos;
+    uint32_t n;
+    uint32_t i;
+
+    word = from / 64;
+    for (i = 0; i <= words; i++, word++) {
+        if (word >= words) {
+            /* runs do not wrap around the end of the table */
+            word = 0;
+            run = 0;
+        }
+
+        free_bits = ~sss_mc_ft_used_word(mcc, word);
+        if (i == 0) {
+            /* the slots before 'from' may belong to the record which ends
+             * at 'from' */
+            free_bits &= (uint64_t) -1 >> (from % 64);
+        }
+        if (free_bits == 0) {
+            run = 0;
+            continue;
+        }
+
+        if (free_bits == (uint64_t) -1) {
+            if (run == 0) {
+                run_start = word * 64;
+            }
+            run += 64;
+            if (run >= num_slots) {
+                *free_slot = run_start;
+                return true;
             }
             continue;
         }
 
-        /* at least one bit in this byte is marked as empty */
-        for (t = ((cur + 8) & ~7) ; cur < t; cur++) {
-            MC_PROBE_BIT(mcc->free_table, cur, used);
-            if (!used) break;
+        pos = 0;
+        while (pos < 64) {
+            bits = free_bits << pos;
+            if (run == 0) {
+                /* skip the used slots */
+                n = sss_mc_clz64(bits);
+                if (n >= 64 - pos) {
+                    break;
+                }
+                pos += n;
+                run_start = word * 64 + pos;
+                bits = free_bits << pos;
+            }
+
+            /* length of the free run at pos, the bits shifted in are
+             * zero so the run never extends past the word */
+            n = sss_mc_clz64(~bits);
+            if (n > 64 - pos) {
+                n = 64 - pos;
+            }
+            run += n;
+            pos += n;
+
+            if (run >= num_slots) {
+                *free_slot = run_start;
+                return true;
+            }
+
+            if (pos < 64) {
+                /* interrupted by a used slot */
+                run = 0;
+            }
         }
-        /* check if we have enough slots before hitting the table end */
-        if ((cur + num_slots) > tot_slots) {
-            cur = 0;
+    }
+
+    return false;
+}
+
+/* Walks the records which occupy the num_slots slots starting at 'start'
+ * and returns the latest expiration time among them in 'cost' and the slot
+ * after the last of them in 'end'. */
+static errno_t sss_mc_eviction_cost(struct sss_mc_ctx *mcc,
+                                    uint32_t start, uint32_t num_slots,
+                                    uint64_t *cost, uint32_t *end)
+{
+    struct sss_mc_rec *rec;
+    uint32_t cur;
+    bool used;
+
+    *cost = 0;
+    for (cur = start; cur < start + num_slots; ) {
+        MC_PROBE_BIT(mcc->free_table, cur, used);
+        if (!used) {
+            cur++;
             continue;
         }
 
-        /* check if we have at least num_slots empty starting from the first
-         * we found in the previous steps */
-        for (t = cur + num_slots; cur < t; cur++) {
-            MC_PROBE_BIT(mcc->free_table, cur, used);
-            if (used) break;
+        /* the first used slot should be a record header, however we
+         * carefully check it is a valid header and hardfail if not */
+        rec = MC_SLOT_TO_PTR(mcc->data_table, cur, struct sss_mc_rec);
+        if (!sss_mc_is_valid_rec(mcc, rec)) {
+            return EFAULT;
         }
-        if (cur == t) {
-            /* ok found num_slots consecutive free bits */
-            *free_slot = cur - num_slots;
-            return EOK;
+
+        if (rec->expire > *cost) {
+            *cost = rec->expire;
         }
+        cur += MC_SIZE_TO_SLOTS(rec->len);
     }
 
-    /* no free slots found, free occupied slots after next_slot */
-    if ((mcc->next_slot + num_slots) > tot_slots) {
-        cur = 0;
-    } else {
-        cur = mcc->next_slot;
+    *end = cur;
+    return EOK;
+}
+
+/* Number of windows compared before evicting records */
+#define MC_EVICT_CANDIDATES 8
+
+/* Frees the slots of a window of num_slots slots. A few windows following
+ * the last allocation are compared and the one whose records all expired,
+ * or otherwise expire the soonest, is recycled. */
+static errno_t sss_mc_evict_slots(struct sss_mc_ctx *mcc,
+                                  uint32_t num_slots, uint32_t *free_slot)
+{
+    struct sss_mc_rec *rec;
+    uint32_t tot_slots;
+    uint32_t best = 0;
+    uint64_t best_cost = MC_INVALID_VAL64;
+    uint64_t cost;
+    uint32_t cur;
+    uint32_t end;
+    time_t now;
+    errno_t ret;
+    bool used;
+    int i;
+
+    tot_slots = mcc->ft_size * 8;
+    now = time(NULL);
+
+    /* next_slot is always the end of a record or the start of the table,
+     * so it is a valid place to start walking the records from. Unless
+     * another NSS process stored a record over it in the meantime, the
+     * start of the table is always good. */
+    cur = mcc->next_slot;
+    if (cur < tot_slots) {
+        MC_PROBE_BIT(mcc->free_table, cur, used);
+        rec = MC_SLOT_TO_PTR(mcc->data_table, cur, struct sss_mc_rec);
+        if (used && !sss_mc_is_valid_rec(mcc, rec)) {
+            cur = 0;
+        }
     }
-    for (i = 0; i < num_slots; i++) {
-        MC_PROBE_BIT(mcc->free_table, cur + i, used);
-        if (used) {
-            /* the first used slot should be a record header, however we
-             * carefully check it is a valid header and hardfail if not */
-            rec = MC_SLOT_TO_PTR(mcc->data_table, cur + i, struct sss_mc_rec);
-            if (!sss_mc_is_valid_rec(mcc, rec)) {
-                /* this is a fatal error, the caller should probaly just
-                 * invalidate the whole cache */
-                return EFAULT;
+    for (i = 0; i < MC_EVICT_CANDIDATES; i++) {
+        if (cur + num_slots > tot_slots) {
+            cur = 0;
+        }
+
+        ret = sss_mc_eviction_cost(mcc, cur, num_slots, &cost, &end);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        if (cost < best_cost) {
+            best = cur;
+            best_cost = cost;
+            if (cost < (uint64_t) now) {
+                /* nothing alive in this window */
+                break;
             }
+        }
+
+        cur = end;
+    }
+
+    if (best_cost >= (uint64_t) now) {
+        mcc->live_evictions++;
+    }
+
+    for (cur = best; cur < best + num_slots; cur++) {
+        MC_PROBE_BIT(mcc->free_table, cur, used);
+        if (used) {
+            rec = MC_SLOT_TO_PTR(mcc->data_table, cur, struct sss_mc_rec);
             /* next loop skip the whole record */
-            i += MC_SIZE_TO_SLOTS(rec->len) - 1;
+            cur += MC_SIZE_TO_SLOTS(rec->len) - 1;
 
             /* finally invalidate record completely */
             sss_mc_invalidate_rec(mcc, rec);
         }
     }
 
-    mcc->next_slot = cur + num_slots;
-    *free_slot = cur;
+    mcc->next_slot = best + num_slots;
+    *free_slot = best;
     return EOK;
 }
 
+static errno_t sss_mc_find_free_slots(struct sss_mc_ctx *mcc,
+                                      int num_slots, uint32_t *free_slot)
+{
+    uint32_t tot_slots;
+    uint32_t cur;
+
+    tot_slots = mcc->ft_size * 8;
+
+    /* Try to find a free slot w/o removing anything first */
+    if ((mcc->next_slot + num_slots) > tot_slots) {
+        cur = 0;
+    } else {
+        cur = mcc->next_slot;
+    }
+
+    if (sss_mc_find_free_run(mcc, num_slots, cur, free_slot)) {
+        /* keep next_slot at the end of a record for the eviction */
+        mcc->next_slot = *free_slot + num_slots;
+        return EOK;
+    }
+
+    /* no free slots found, recycle some */
+    sss_stats_count("nss.mmap.evictions", 1);
+    return sss_mc_evict_slots(mcc, num_slots, free_slot);
+}
+
 static errno_t sss_mc_get_strs_offset(struct sss_mc_ctx *mcc,
                                       size_t *_offset)
 {
@@ -473,6 +666,9 @@ static errno_t sss_mc_get_strs_offset(struct sss_mc_ctx *mcc,
     case SSS_MC_GROUP:
         *_offset = offsetof(struct sss_mc_grp_data, strs);
         return EOK;
+    case SSS_MC_SID:
+        *_offset = offsetof(struct sss_mc_sid_data, strs);
+        return EOK;
     default:
         DEBUG(SSSDBG_FATAL_FAILURE, "Unknown memory cache type.\n");
         return EINVAL;
@@ -490,6 +686,9 @@ static errno_t sss_mc_get_strs_len(struct sss_mc_ctx *mcc,
     case SSS_MC_GROUP:
         *_len = ((struct sss_mc_grp_data *)&rec->data)->strs_len;
         return EOK;
+    case SSS_MC_SID:
+        *_len = ((struct sss_mc_sid_data *)&rec->data)->strs_len;
+        return EOK;
     default:
         DEBUG(SSSDBG_FATAL_FAILURE, "Unknown memory cache type.\n");
         return EINVAL;
@@ -534,6 +733,12 @@ static struct sss_mc_rec *sss_mc_find_record(struct sss_mc_ctx *mcc,
         }
 
         rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
+        if (rec->flags & SSS_MC_REC_NEG_ID) {
+            /* negative id records have no name */
+            slot = sss_mc_next_slot_with_hash(rec, hash);
+            continue;
+        }
+
         ret = sss_mc_get_strs_len(mcc, rec, &strs_len);
         if (ret != EOK) {
             return NULL;
@@ -565,10 +770,229 @@ static struct sss_mc_rec *sss_mc_find_record(struct sss_mc_ctx *mcc,
     return rec;
 }
 
-static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
-                                 size_t rec_len,
-                                 struct sized_string *key,
-                                 struct sss_mc_rec **_rec)
+/***************************************************************************
+ * concurrent writers
+ ***************************************************************************/
+
+static errno_t sss_mc_set_writer_lock(int fd, short type)
+{
+    struct flock lock;
+    int ret;
+
+    lock.l_type = type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = MC_WRITER_LOCK_OFFSET;
+    lock.l_len = 1;
+    lock.l_pid = 0;
+
+    do {
+        ret = fcntl(fd, F_SETLKW, &lock);
+    } while (ret == -1 && errno == EINTR);
+
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Failed to %s the memory cache file: %d(%s)\n",
+              type == F_UNLCK ? "unlock" : "lock", ret, strerror(ret));
+        return ret;
+    }
+
+    return EOK;
+}
+
+/* Maps the current cache file, which might have been created by another
+ * NSS process. On success the writer lock of the file is held. */
+static errno_t sss_mc_attach(struct sss_mc_ctx *mcc)
+{
+    struct sss_mc_header *h;
+    struct stat st;
+    void *base = MAP_FAILED;
+    int fd;
+    errno_t ret;
+
+    if (mcc->mmap_base != NULL) {
+        munmap(mcc->mmap_base, mcc->mmap_size);
+        mcc->mmap_base = NULL;
+    }
+    if (mcc->fd != -1) {
+        close(mcc->fd);
+        mcc->fd = -1;
+    }
+
+    fd = open(mcc->file, O_RDWR);
+    if (fd == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Failed to open memory cache file %s: %d(%s)\n",
+              mcc->file, ret, strerror(ret));
+        return ret;
+    }
+
+    /* the creator of the file holds the lock until the file is set up */
+    ret = sss_mc_set_writer_lock(fd, F_WRLCK);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    ret = fstat(fd, &st);
+    if (ret == -1) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Failed to stat memory cache file %s: %d(%s)\n",
+              mcc->file, ret, strerror(ret));
+        goto done;
+    }
+
+    if (st.st_size < MC_HEADER_SIZE) {
+        ret = EAGAIN;
+        goto done;
+    }
+
+    base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ret = errno;
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to mmap file %s(%zu): %d(%s)\n",
+              mcc->file, (size_t) st.st_size, ret, strerror(ret));
+        goto done;
+    }
+
+    h = (struct sss_mc_header *) base;
+    if (h->status != SSS_MC_HEADER_ALIVE
+            || h->b1 != h->b2
+            || h->major_vno != SSS_MC_MAJOR_VNO
+            || h->minor_vno != SSS_MC_MINOR_VNO
+            || MC_HEADER_SIZE + MC_ALIGN64(h->dt_size)
+                    + MC_ALIGN64(h->ft_size)
+                    + MC_ALIGN64(h->ht_size) > st.st_size) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "Memory cache file %s is not ready\n", mcc->file);
+        ret = EAGAIN;
+        goto done;
+    }
+
+    mcc->fd = fd;
+    mcc->mmap_base = base;
+    mcc->mmap_size = st.st_size;
+    mcc->data_table = MC_PTR_ADD(base, h->data_table);
+    mcc->free_table = MC_PTR_ADD(base, h->free_table);
+    mcc->hash_table = MC_PTR_ADD(base, h->hash_table);
+    mcc->dt_size = h->dt_size;
+    mcc->ft_size = h->ft_size;
+    mcc->ht_size = h->ht_size;
+    mcc->seed = h->seed;
+    /* the hash table holds two entries per element */
+    mcc->n_elem = MC_HT_ELEMS(h->ht_size) / 2;
+    mcc->next_slot = 0;
+    mcc->live_evictions = 0;
+
+    ret = EOK;
+
+done:
+    if (ret != EOK) {
+        if (base != MAP_FAILED) {
+            munmap(base, st.st_size);
+        }
+        /* closing the file also releases the lock */
+        close(fd);
+    }
+    return ret;
+}
+
+/* Every change of the cache is done with the writer lock held, so that all
+ * NSS processes can store into the same files. If another process replaced
+ * the file in the meantime the new one is mapped first. Calls may nest. */
+static errno_t sss_mc_lock(struct sss_mc_ctx *mcc)
+{
+    struct sss_mc_header *h;
+    errno_t ret;
+
+    if (mcc == NULL) {
+        /* cache not initialized ? */
+        return EINVAL;
+    }
+
+    if (mcc->lock_depth > 0) {
+        mcc->lock_depth++;
+        return EOK;
+    }
+
+    if (mcc->fd != -1) {
+        ret = sss_mc_set_writer_lock(mcc->fd, F_WRLCK);
+        if (ret != EOK) {
+            return ret;
+        }
+
+        h = (struct sss_mc_header *) mcc->mmap_base;
+        if (h->status == SSS_MC_HEADER_ALIVE) {
+            mcc->lock_depth = 1;
+            return EOK;
+        }
+
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "The %s memory cache was re-created\n", mcc->name);
+    }
+
+    ret = sss_mc_attach(mcc);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    mcc->lock_depth = 1;
+    return EOK;
+}
+
+static void sss_mc_unlock(struct sss_mc_ctx *mcc)
+{
+    if (mcc == NULL || mcc->lock_depth == 0) {
+        return;
+    }
+
+    mcc->lock_depth--;
+    if (mcc->lock_depth == 0 && mcc->fd != -1) {
+        (void) sss_mc_set_writer_lock(mcc->fd, F_UNLCK);
+    }
+}
+
+/* The cache is thrashing if a quarter of its capacity worth of records
+ * had to be recycled before they expired */
+static bool sss_mc_needs_growth(struct sss_mc_ctx *mcc)
+{
+    if (mcc->n_elem >= mcc->max_elem) {
+        return false;
+    }
+
+    return mcc->live_evictions >= mcc->n_elem / 4;
+}
+
+static errno_t sss_mc_grow(struct sss_mc_ctx **_mcc)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    size_t n_elem;
+    errno_t ret;
+
+    n_elem = MIN(mcc->n_elem * 2, mcc->max_elem);
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "The %s memory cache is full (%"PRIu32" of %"PRIu32" slots used), "
+          "growing it to %zu elements\n", mcc->name, sss_mc_used_slots(mcc),
+          mcc->ft_size * 8, n_elem);
+
+    /* The new file replaces the old one which is marked as recycled, so
+     * the clients reopen the cache. */
+    ret = sss_mmap_cache_reinit(talloc_parent(mcc), n_elem, -1, -1, _mcc);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Failed to grow the memory cache\n");
+    }
+
+    return ret;
+}
+
+/* Returns the record stored under key if it has the right size, otherwise
+ * allocates a new one. A NULL key always allocates a new record. */
+static errno_t sss_mc_get_record_int(struct sss_mc_ctx **_mcc,
+                                     size_t rec_len,
+                                     struct sized_string *key,
+                                     struct sss_mc_rec **_rec)
 {
     struct sss_mc_ctx *mcc = *_mcc;
     struct sss_mc_rec *old_rec = NULL;
@@ -581,11 +1005,29 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
 
     num_slots = MC_SIZE_TO_SLOTS(rec_len);
 
-    old_rec = sss_mc_find_record(mcc, key);
+    if (sss_mc_needs_growth(mcc)) {
+        ret = sss_mc_grow(_mcc);
+        if (ret != EOK) {
+            return ret;
+        }
+        mcc = *_mcc;
+
+        /* the caller releases the lock of the new file */
+        ret = sss_mc_lock(mcc);
+        if (ret != EOK) {
+            return ret;
+        }
+    }
+
+    if (key != NULL) {
+        old_rec = sss_mc_find_record(mcc, key);
+    }
     if (old_rec) {
         old_slots = MC_SIZE_TO_SLOTS(old_rec->len);
 
-        if (old_slots == num_slots) {
+        /* negative records are chained differently, never reuse them */
+        if (old_slots == num_slots
+                && (old_rec->flags & SSS_MC_REC_NEGATIVE) == 0) {
             *_rec = old_rec;
             return EOK;
         }
@@ -601,7 +1043,7 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
         if (ret == EFAULT) {
             DEBUG(SSSDBG_CRIT_FAILURE,
                   "Fatal internal mmap cache error, invalidating cache!\n");
-            (void)sss_mmap_cache_reinit(talloc_parent(mcc), -1, -1, _mcc);
+            (void)sss_mmap_cache_reinit(talloc_parent(mcc), -1, -1, -1, _mcc);
         }
         return ret;
     }
@@ -613,7 +1055,7 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
     rec->len = rec_len;
     rec->next1 = MC_INVALID_VAL;
     rec->next2 = MC_INVALID_VAL;
-    rec->padding = MC_INVALID_VAL;
+    rec->flags = 0;
     MC_LOWER_BARRIER(rec);
 
     /* and now mark slots as used */
@@ -625,6 +1067,26 @@ static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
     return EOK;
 }
 
+/* Finding a record to store the data into is the part of the store whose
+ * cost depends on the state of the cache, so it is the one measured */
+static errno_t sss_mc_get_record(struct sss_mc_ctx **_mcc,
+                                 size_t rec_len,
+                                 struct sized_string *key,
+                                 struct sss_mc_rec **_rec)
+{
+    char name[64];
+    struct timeval start;
+    errno_t ret;
+
+    snprintf(name, sizeof(name), "nss.mmap.%s.store", (*_mcc)->name);
+    gettimeofday(&start, NULL);
+
+    ret = sss_mc_get_record_int(_mcc, rec_len, key, _rec);
+
+    sss_stats_record_since(name, &start);
+    return ret;
+}
+
 static inline void sss_mmap_set_rec_header(struct sss_mc_ctx *mcc,
                                            struct sss_mc_rec *rec,
                                            size_t len, int ttl,
@@ -650,25 +1112,177 @@ static inline void sss_mmap_chain_in_rec(struct sss_mc_ctx *mcc,
  * generic invalidation
  ***************************************************************************/
 
-static errno_t sss_mmap_cache_invalidate(struct sss_mc_ctx *mcc,
-                                         struct sized_string *key)
-{
-    struct sss_mc_rec *rec;
+static errno_t sss_mmap_cache_invalidate(struct sss_mc_ctx *mcc,
+                                         struct sized_string *key)
+{
+    struct sss_mc_rec *rec;
+    errno_t ret;
+
+    ret = sss_mc_lock(mcc);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    rec = sss_mc_find_record(mcc, key);
+    if (rec == NULL) {
+        /* nothing to invalidate */
+        ret = ENOENT;
+        goto done;
+    }
+
+    sss_mc_invalidate_rec(mcc, rec);
+
+    ret = EOK;
+
+done:
+    sss_mc_unlock(mcc);
+    return ret;
+}
+
+/***************************************************************************
+ * negative records
+ ***************************************************************************/
+
+static uint32_t sss_mc_get_rec_id(struct sss_mc_ctx *mcc,
+                                  struct sss_mc_rec *rec)
+{
+    switch (mcc->type) {
+    case SSS_MC_PASSWD:
+        return ((struct sss_mc_pwd_data *)&rec->data)->uid;
+    case SSS_MC_GROUP:
+        return ((struct sss_mc_grp_data *)&rec->data)->gid;
+    case SSS_MC_SID:
+        return ((struct sss_mc_sid_data *)&rec->data)->id;
+    default:
+        return MC_INVALID_VAL32;
+    }
+}
+
+/* A regular record is about to be stored for the id, the negative record
+ * must go or the clients would keep finding it first */
+static void sss_mc_invalidate_negative_id(struct sss_mc_ctx *mcc,
+                                          struct sized_string *idkey,
+                                          uint32_t id)
+{
+    struct sss_mc_rec *rec;
+    uint32_t hash;
+    uint32_t slot;
+
+    hash = sss_mc_hash(mcc, idkey->str, idkey->len);
+
+    slot = mcc->hash_table[hash];
+    while (MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
+        rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
+        if ((rec->flags & SSS_MC_REC_NEG_ID)
+                && rec->hash1 == hash
+                && sss_mc_get_rec_id(mcc, rec) == id) {
+            sss_mc_invalidate_rec(mcc, rec);
+            return;
+        }
+
+        slot = sss_mc_next_slot_with_hash(rec, hash);
+    }
+}
+
+/* Stores a negative record for name, or for id if name is NULL. Whatever
+ * was cached for the key before is dropped. */
+static errno_t sss_mc_store_negative(struct sss_mc_ctx **_mcc,
+                                     struct sized_string *name,
+                                     uint32_t id, time_t ttl)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_pwd_data *pwd_data;
+    struct sss_mc_grp_data *grp_data;
+    struct sized_string key;
+    struct sized_string strs;
+    char idstr[11];
+    uint32_t flags;
+    size_t strs_offset;
+    size_t rec_len;
+    int ret;
+
+    ret = sss_mc_lock(mcc);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    if (name != NULL) {
+        key = *name;
+        strs = *name;
+        id = MC_INVALID_VAL32;
+        flags = SSS_MC_REC_NEG_NAME;
+
+        (void)sss_mmap_cache_invalidate(mcc, name);
+    } else {
+        ret = snprintf(idstr, 11, "%"PRIu32, id);
+        if (ret > 10) {
+            ret = EINVAL;
+            goto done;
+        }
+        to_sized_string(&key, idstr);
+        to_sized_string(&strs, "");
+        flags = SSS_MC_REC_NEG_ID;
+
+        if (mcc->type == SSS_MC_PASSWD) {
+            (void)sss_mmap_cache_pw_invalidate_uid(mcc, id);
+        } else {
+            (void)sss_mmap_cache_gr_invalidate_gid(mcc, id);
+        }
+    }
+
+    ret = sss_mc_get_strs_offset(mcc, &strs_offset);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    rec_len = sizeof(struct sss_mc_rec) + strs_offset + strs.len;
+    if (rec_len > mcc->dt_size) {
+        ret = ENOMEM;
+        goto done;
+    }
 
-    if (mcc == NULL) {
-        /* cache not initialized ? */
-        return EINVAL;
+    ret = sss_mc_get_record(_mcc, rec_len, NULL, &rec);
+    if (ret != EOK) {
+        goto done;
     }
+    /* the cache might have been re-created */
+    mcc = *_mcc;
 
-    rec = sss_mc_find_record(mcc, key);
-    if (rec == NULL) {
-        /* nothing to invalidate */
-        return ENOENT;
+    MC_RAISE_BARRIER(rec);
+
+    /* header, both hash chains point to the only key */
+    rec->len = rec_len;
+    rec->expire = time(NULL) + ttl;
+    rec->hash1 = sss_mc_hash(mcc, key.str, key.len);
+    rec->hash2 = rec->hash1;
+    rec->flags = flags;
+
+    if (mcc->type == SSS_MC_PASSWD) {
+        pwd_data = (struct sss_mc_pwd_data *)rec->data;
+        pwd_data->name = MC_PTR_DIFF(pwd_data->strs, pwd_data);
+        pwd_data->uid = id;
+        pwd_data->gid = MC_INVALID_VAL32;
+        pwd_data->strs_len = strs.len;
+        memcpy(pwd_data->strs, strs.str, strs.len);
+    } else {
+        grp_data = (struct sss_mc_grp_data *)rec->data;
+        grp_data->name = MC_PTR_DIFF(grp_data->strs, grp_data);
+        grp_data->gid = id;
+        grp_data->members = 0;
+        grp_data->strs_len = strs.len;
+        memcpy(grp_data->strs, strs.str, strs.len);
     }
 
-    sss_mc_invalidate_rec(mcc, rec);
+    MC_LOWER_BARRIER(rec);
 
-    return EOK;
+    sss_mmap_chain_in_rec(mcc, rec);
+
+    ret = EOK;
+
+done:
+    sss_mc_unlock(*_mcc);
+    return ret;
 }
 
 /***************************************************************************
@@ -693,29 +1307,35 @@ errno_t sss_mmap_cache_pw_store(struct sss_mc_ctx **_mcc,
     size_t pos;
     int ret;
 
-    if (mcc == NULL) {
-        /* cache not initialized ? */
-        return EINVAL;
+    ret = sss_mc_lock(mcc);
+    if (ret != EOK) {
+        return ret;
     }
 
     ret = snprintf(uidstr, 11, "%ld", (long)uid);
     if (ret > 10) {
-        return EINVAL;
+        ret = EINVAL;
+        goto done;
     }
     to_sized_string(&uidkey, uidstr);
 
+    sss_mc_invalidate_negative_id(mcc, &uidkey, uid);
+
     data_len = name->len + pw->len + gecos->len + homedir->len + shell->len;
     rec_len = sizeof(struct sss_mc_rec) +
               sizeof(struct sss_mc_pwd_data) +
               data_len;
     if (rec_len > mcc->dt_size) {
-        return ENOMEM;
+        ret = ENOMEM;
+        goto done;
     }
 
     ret = sss_mc_get_record(_mcc, rec_len, name, &rec);
     if (ret != EOK) {
-        return ret;
+        goto done;
     }
+    /* the cache might have been re-created */
+    mcc = *_mcc;
 
     data = (struct sss_mc_pwd_data *)rec->data;
     pos = 0;
@@ -747,7 +1367,11 @@ errno_t sss_mmap_cache_pw_store(struct sss_mc_ctx **_mcc,
     /* finally chain the rec in the hash table */
     sss_mmap_chain_in_rec(mcc, rec);
 
-    return EOK;
+    ret = EOK;
+
+done:
+    sss_mc_unlock(*_mcc);
+    return ret;
 }
 
 errno_t sss_mmap_cache_pw_invalidate(struct sss_mc_ctx *mcc,
@@ -765,14 +1389,15 @@ errno_t sss_mmap_cache_pw_invalidate_uid(struct sss_mc_ctx *mcc, uid_t uid)
     char *uidstr;
     errno_t ret;
 
-    if (mcc == NULL) {
-        /* cache not initialized ? */
-        return EINVAL;
+    ret = sss_mc_lock(mcc);
+    if (ret != EOK) {
+        return ret;
     }
 
     uidstr = talloc_asprintf(NULL, "%ld", (long)uid);
     if (!uidstr) {
-        return ENOMEM;
+        ret = ENOMEM;
+        goto done;
     }
 
     hash = sss_mc_hash(mcc, uidstr, strlen(uidstr) + 1);
@@ -795,7 +1420,7 @@ errno_t sss_mmap_cache_pw_invalidate_uid(struct sss_mc_ctx *mcc, uid_t uid)
         rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
         data = (struct sss_mc_pwd_data *)(&rec->data);
 
-        if (uid == data->uid) {
+        if (uid == data->uid && (rec->flags & SSS_MC_REC_NEG_NAME) == 0) {
             break;
         }
 
@@ -813,9 +1438,23 @@ errno_t sss_mmap_cache_pw_invalidate_uid(struct sss_mc_ctx *mcc, uid_t uid)
 
 done:
     talloc_zfree(uidstr);
+    sss_mc_unlock(mcc);
     return ret;
 }
 
+errno_t sss_mmap_cache_pw_store_negative(struct sss_mc_ctx **_mcc,
+                                         struct sized_string *name,
+                                         time_t ttl)
+{
+    return sss_mc_store_negative(_mcc, name, 0, ttl);
+}
+
+errno_t sss_mmap_cache_pw_store_negative_uid(struct sss_mc_ctx **_mcc,
+                                             uid_t uid, time_t ttl)
+{
+    return sss_mc_store_negative(_mcc, NULL, uid, ttl);
+}
+
 /***************************************************************************
  * group map
  ***************************************************************************/
@@ -836,29 +1475,35 @@ int sss_mmap_cache_gr_store(struct sss_mc_ctx **_mcc,
     size_t pos;
     int ret;
 
-    if (mcc == NULL) {
-        /* cache not initialized ? */
-        return EINVAL;
+    ret = sss_mc_lock(mcc);
+    if (ret != EOK) {
+        return ret;
     }
 
     ret = snprintf(gidstr, 11, "%ld", (long)gid);
     if (ret > 10) {
-        return EINVAL;
+        ret = EINVAL;
+        goto done;
     }
     to_sized_string(&gidkey, gidstr);
 
+    sss_mc_invalidate_negative_id(mcc, &gidkey, gid);
+
     data_len = name->len + pw->len + memsize;
     rec_len = sizeof(struct sss_mc_rec) +
               sizeof(struct sss_mc_grp_data) +
               data_len;
     if (rec_len > mcc->dt_size) {
-        return ENOMEM;
+        ret = ENOMEM;
+        goto done;
     }
 
     ret = sss_mc_get_record(_mcc, rec_len, name, &rec);
     if (ret != EOK) {
-        return ret;
+        goto done;
     }
+    /* the cache might have been re-created */
+    mcc = *_mcc;
 
     data = (struct sss_mc_grp_data *)rec->data;
     pos = 0;
@@ -886,7 +1531,11 @@ int sss_mmap_cache_gr_store(struct sss_mc_ctx **_mcc,
     /* finally chain the rec in the hash table */
     sss_mmap_chain_in_rec(mcc, rec);
 
-    return EOK;
+    ret = EOK;
+
+done:
+    sss_mc_unlock(*_mcc);
+    return ret;
 }
 
 errno_t sss_mmap_cache_gr_invalidate(struct sss_mc_ctx *mcc,
@@ -904,14 +1553,15 @@ errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid)
     char *gidstr;
     errno_t ret;
 
-    if (mcc == NULL) {
-        /* cache not initialized ? */
-        return EINVAL;
+    ret = sss_mc_lock(mcc);
+    if (ret != EOK) {
+        return ret;
     }
 
     gidstr = talloc_asprintf(NULL, "%ld", (long)gid);
     if (!gidstr) {
-        return ENOMEM;
+        ret = ENOMEM;
+        goto done;
     }
 
     hash = sss_mc_hash(mcc, gidstr, strlen(gidstr) + 1);
@@ -934,7 +1584,7 @@ errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid)
         rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
         data = (struct sss_mc_grp_data *)(&rec->data);
 
-        if (gid == data->gid) {
+        if (gid == data->gid && (rec->flags & SSS_MC_REC_NEG_NAME) == 0) {
             break;
         }
 
@@ -952,9 +1602,171 @@ errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid)
 
 done:
     talloc_zfree(gidstr);
+    sss_mc_unlock(mcc);
     return ret;
 }
 
+errno_t sss_mmap_cache_gr_store_negative(struct sss_mc_ctx **_mcc,
+                                         struct sized_string *name,
+                                         time_t ttl)
+{
+    return sss_mc_store_negative(_mcc, name, 0, ttl);
+}
+
+errno_t sss_mmap_cache_gr_store_negative_gid(struct sss_mc_ctx **_mcc,
+                                             gid_t gid, time_t ttl)
+{
+    return sss_mc_store_negative(_mcc, NULL, gid, ttl);
+}
+
+/***************************************************************************
+ * sid map
+ ***************************************************************************/
+
+/* Only one record may answer the lookup by id, drop all but keep */
+static void sss_mc_invalidate_sid_by_id(struct sss_mc_ctx *mcc,
+                                        struct sized_string *idkey,
+                                        uint32_t id,
+                                        struct sss_mc_rec *keep)
+{
+    struct sss_mc_rec *rec;
+    uint32_t hash;
+    uint32_t slot;
+    uint32_t next;
+
+    hash = sss_mc_hash(mcc, idkey->str, idkey->len);
+
+    slot = mcc->hash_table[hash];
+    while (MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
+        rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
+        next = sss_mc_next_slot_with_hash(rec, hash);
+
+        if (rec != keep
+                && (rec->flags & SSS_MC_REC_SID_BY_ID)
+                && rec->hash2 == hash
+                && sss_mc_get_rec_id(mcc, rec) == id) {
+            sss_mc_invalidate_rec(mcc, rec);
+        }
+
+        slot = next;
+    }
+}
+
+errno_t sss_mmap_cache_sid_store(struct sss_mc_ctx **_mcc,
+                                 struct sized_string *sid,
+                                 struct sized_string *name,
+                                 uint32_t id, uint32_t type,
+                                 bool by_id)
+{
+    struct sss_mc_ctx *mcc = *_mcc;
+    struct sss_mc_rec *rec;
+    struct sss_mc_sid_data *data;
+    struct sized_string idkey;
+    struct sized_string empty;
+    char idstr[11];
+    uint32_t flags = 0;
+    size_t data_len;
+    size_t rec_len;
+    size_t pos;
+    char *old_name = NULL;
+    int ret;
+
+    ret = sss_mc_lock(mcc);
+    if (ret != EOK) {
+        return ret;
+    }
+
+    ret = snprintf(idstr, 11, "%"PRIu32, id);
+    if (ret > 10) {
+        ret = EINVAL;
+        goto done;
+    }
+    to_sized_string(&idkey, idstr);
+
+    /* Each reply only tells a part of what is known about the SID. Keep
+     * the name and the id flag of the record which is replaced if the id
+     * did not change. */
+    rec = sss_mc_find_record(mcc, sid);
+    if (rec != NULL) {
+        data = (struct sss_mc_sid_data *)rec->data;
+        if (data->id != id || data->type != type) {
+            sss_mc_invalidate_rec(mcc, rec);
+            rec = NULL;
+        } else {
+            flags = rec->flags & SSS_MC_REC_SID_BY_ID;
+            if (name == NULL && data->strs_len > sid->len + 1) {
+                old_name = talloc_strndup(NULL, &data->strs[sid->len],
+                                          data->strs_len - sid->len - 1);
+                if (old_name == NULL) {
+                    ret = ENOMEM;
+                    goto done;
+                }
+            }
+        }
+    }
+
+    if (by_id) {
+        sss_mc_invalidate_sid_by_id(mcc, &idkey, id, rec);
+        flags |= SSS_MC_REC_SID_BY_ID;
+    }
+
+    if (name == NULL) {
+        if (old_name != NULL) {
+            to_sized_string(&empty, old_name);
+        } else {
+            to_sized_string(&empty, "");
+        }
+        name = &empty;
+    }
+
+    data_len = sid->len + name->len;
+    rec_len = sizeof(struct sss_mc_rec) +
+              sizeof(struct sss_mc_sid_data) +
+              data_len;
+    if (rec_len > mcc->dt_size) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_mc_get_record(_mcc, rec_len, sid, &rec);
+    if (ret != EOK) {
+        goto done;
+    }
+    /* the cache might have been re-created */
+    mcc = *_mcc;
+
+    data = (struct sss_mc_sid_data *)rec->data;
+    pos = 0;
+
+    MC_RAISE_BARRIER(rec);
+
+    /* header */
+    sss_mmap_set_rec_header(mcc, rec, rec_len, mcc->valid_time_slot,
+                            sid->str, sid->len, idkey.str, idkey.len);
+    rec->flags = flags;
+
+    /* sid struct */
+    data->sid = MC_PTR_DIFF(data->strs, data);
+    data->id = id;
+    data->type = type;
+    data->strs_len = data_len;
+    memcpy(&data->strs[pos], sid->str, sid->len);
+    pos += sid->len;
+    memcpy(&data->strs[pos], name->str, name->len);
+    pos += name->len;
+
+    MC_LOWER_BARRIER(rec);
+
+    /* finally chain the rec in the hash table */
+    sss_mmap_chain_in_rec(mcc, rec);
+
+    ret = EOK;
+
+done:
+    talloc_free(old_name);
+    sss_mc_unlock(*_mcc);
+    return ret;
+}
 
 /***************************************************************************
  * initialization
@@ -1071,7 +1883,16 @@ static errno_t sss_mc_create_file(struct sss_mc_ctx *mc_ctx)
         return ret;
     }
 
-    return ret;
+    /* keep the other NSS processes out until the file is set up */
+    ret = sss_mc_set_writer_lock(mc_ctx->fd, F_WRLCK);
+    if (ret != EOK) {
+        close(mc_ctx->fd);
+        mc_ctx->fd = -1;
+        unlink(mc_ctx->file);
+        return ret;
+    }
+
+    return EOK;
 }
 
 static void sss_mc_header_update(struct sss_mc_ctx *mc_ctx, int status)
@@ -1129,25 +1950,11 @@ static int mc_ctx_destructor(struct sss_mc_ctx *mc_ctx)
     return 0;
 }
 
-errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
-                            enum sss_mc_type type, size_t n_elem,
-                            time_t timeout, struct sss_mc_ctx **mcc)
+static errno_t sss_mc_ctx_new(TALLOC_CTX *mem_ctx, const char *name,
+                              enum sss_mc_type type, time_t timeout,
+                              struct sss_mc_ctx **_mc_ctx)
 {
-    struct sss_mc_ctx *mc_ctx = NULL;
-    unsigned int rseed;
-    int payload;
-    int ret, dret;
-
-    switch (type) {
-    case SSS_MC_PASSWD:
-        payload = SSS_AVG_PASSWD_PAYLOAD;
-        break;
-    case SSS_MC_GROUP:
-        payload = SSS_AVG_GROUP_PAYLOAD;
-        break;
-    default:
-        return EINVAL;
-    }
+    struct sss_mc_ctx *mc_ctx;
 
     mc_ctx = talloc_zero(mem_ctx, struct sss_mc_ctx);
     if (!mc_ctx) {
@@ -1158,8 +1965,8 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
 
     mc_ctx->name = talloc_strdup(mc_ctx, name);
     if (!mc_ctx->name) {
-        ret = ENOMEM;
-        goto done;
+        talloc_free(mc_ctx);
+        return ENOMEM;
     }
 
     mc_ctx->type = type;
@@ -1169,20 +1976,56 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
     mc_ctx->file = talloc_asprintf(mc_ctx, "%s/%s",
                                    SSS_NSS_MCACHE_DIR, name);
     if (!mc_ctx->file) {
-        ret = ENOMEM;
-        goto done;
+        talloc_free(mc_ctx);
+        return ENOMEM;
+    }
+
+    *_mc_ctx = mc_ctx;
+    return EOK;
+}
+
+errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
+                            enum sss_mc_type type, size_t n_elem,
+                            size_t max_elem, time_t timeout,
+                            struct sss_mc_ctx **mcc)
+{
+    struct sss_mc_ctx *mc_ctx = NULL;
+    unsigned int rseed;
+    int payload;
+    int ret, dret;
+
+    switch (type) {
+    case SSS_MC_PASSWD:
+        payload = SSS_AVG_PASSWD_PAYLOAD;
+        break;
+    case SSS_MC_GROUP:
+        payload = SSS_AVG_GROUP_PAYLOAD;
+        break;
+    case SSS_MC_SID:
+        payload = SSS_AVG_SID_PAYLOAD;
+        break;
+    default:
+        return EINVAL;
+    }
+
+    ret = sss_mc_ctx_new(mem_ctx, name, type, timeout, &mc_ctx);
+    if (ret != EOK) {
+        return ret;
     }
 
     /* elements must always be multiple of 8 to make things easier to handle,
      * so we increase by the necessary amount if they are not a multiple */
     /* We can use MC_ALIGN64 for this */
     n_elem = MC_ALIGN64(n_elem);
+    mc_ctx->n_elem = n_elem;
+    mc_ctx->max_elem = max_elem;
 
     /* hash table is double the size because it will store both forward and
      * reverse keys (name/uid, name/gid, ..) */
     mc_ctx->ht_size = MC_HT_SIZE(n_elem * 2);
     mc_ctx->dt_size = MC_DT_SIZE(n_elem, payload);
-    mc_ctx->ft_size = MC_FT_SIZE(n_elem);
+    /* one bit for each slot of the data table */
+    mc_ctx->ft_size = MC_FT_SIZE(mc_ctx->dt_size / MC_SLOT_SIZE);
     mc_ctx->mmap_size = MC_HEADER_SIZE +
                         MC_ALIGN64(mc_ctx->dt_size) +
                         MC_ALIGN64(mc_ctx->ft_size) +
@@ -1232,7 +2075,8 @@ errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
 
     sss_mc_header_update(mc_ctx, SSS_MC_HEADER_ALIVE);
 
-    ret = EOK;
+    /* let the other NSS processes in */
+    ret = sss_mc_set_writer_lock(mc_ctx->fd, F_UNLCK);
 
 done:
     if (ret) {
@@ -1255,8 +2099,35 @@ done:
     return ret;
 }
 
+errno_t sss_mmap_cache_attach(TALLOC_CTX *mem_ctx, const char *name,
+                              enum sss_mc_type type, size_t max_elem,
+                              time_t timeout, struct sss_mc_ctx **mcc)
+{
+    struct sss_mc_ctx *mc_ctx;
+    errno_t ret;
+
+    ret = sss_mc_ctx_new(mem_ctx, name, type, timeout, &mc_ctx);
+    if (ret != EOK) {
+        return ret;
+    }
+    mc_ctx->max_elem = max_elem;
+
+    /* If the file is not there yet it is mapped by the first change */
+    ret = sss_mc_attach(mc_ctx);
+    if (ret == EOK) {
+        (void) sss_mc_set_writer_lock(mc_ctx->fd, F_UNLCK);
+    } else {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "The %s memory cache is not available yet\n", name);
+    }
+
+    *mcc = mc_ctx;
+    return EOK;
+}
+
 errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx, size_t n_elem,
-                              time_t timeout, struct sss_mc_ctx **mc_ctx)
+                              size_t max_elem, time_t timeout,
+                              struct sss_mc_ctx **mc_ctx)
 {
     errno_t ret;
     TALLOC_CTX* tmp_ctx = NULL;
@@ -1285,7 +2156,11 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx, size_t n_elem,
     type = (*mc_ctx)->type;
 
     if (n_elem == (size_t)-1) {
-        n_elem = (*mc_ctx)->ft_size * 8;
+        n_elem = (*mc_ctx)->n_elem;
+    }
+
+    if (max_elem == (size_t)-1) {
+        max_elem = (*mc_ctx)->max_elem;
     }
 
     if (timeout == (time_t)-1) {
@@ -1297,7 +2172,8 @@ errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx, size_t n_elem,
     /* make sure we do not leave a potentially freed pointer around */
     *mc_ctx = NULL;
 
-    ret = sss_mmap_cache_init(mem_ctx, name, type, n_elem, timeout, mc_ctx);
+    ret = sss_mmap_cache_init(mem_ctx, name, type, n_elem, max_elem, timeout,
+                              mc_ctx);
     if (ret != EOK) {
         DEBUG(SSSDBG_CRIT_FAILURE, "Failed to re-initialize mmap cache.\n");
         goto done;
@@ -1318,12 +2194,19 @@ void sss_mmap_cache_reset(struct sss_mc_ctx *mc_ctx)
         return;
     }
 
+    if (sss_mc_lock(mc_ctx) != EOK) {
+        return;
+    }
+
     sss_mc_header_update(mc_ctx, SSS_MC_HEADER_UNINIT);
 
     /* Reset the mmaped area */
     memset(mc_ctx->data_table, 0xff, mc_ctx->dt_size);
     memset(mc_ctx->free_table, 0x00, mc_ctx->ft_size);
     memset(mc_ctx->hash_table, 0xff, mc_ctx->ht_size);
+    mc_ctx->next_slot = 0;
 
     sss_mc_header_update(mc_ctx, SSS_MC_HEADER_ALIVE);
+
+    sss_mc_unlock(mc_ctx);
 }
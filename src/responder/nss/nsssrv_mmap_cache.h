@@ -23,6 +23,8 @@
 #define _NSSSRV_MMAP_CACHE_H_
 
 #define SSS_MC_CACHE_ELEMENTS 50000
+/* The caches grow up to this many times the configured size */
+#define SSS_MC_CACHE_MAX_GROWTH 8
 
 struct sss_mc_ctx;
 
@@ -30,11 +32,22 @@ enum sss_mc_type {
     SSS_MC_NONE = 0,
     SSS_MC_PASSWD,
     SSS_MC_GROUP,
+    SSS_MC_SID,
 };
 
+/* The cache is created with n_elem elements and re-created with twice
+ * as many, up to max_elem, when it keeps evicting unexpired records. */
 errno_t sss_mmap_cache_init(TALLOC_CTX *mem_ctx, const char *name,
                             enum sss_mc_type type, size_t n_elem,
-                            time_t valid_time, struct sss_mc_ctx **mcc);
+                            size_t max_elem, time_t valid_time,
+                            struct sss_mc_ctx **mcc);
+
+/* Used by the NSS workers to store into the cache files created by the main
+ * NSS process. The changes of all processes are serialized with a lock on
+ * the file, a file which was re-created is mapped again on the next change. */
+errno_t sss_mmap_cache_attach(TALLOC_CTX *mem_ctx, const char *name,
+                              enum sss_mc_type type, size_t max_elem,
+                              time_t valid_time, struct sss_mc_ctx **mcc);
 
 errno_t sss_mmap_cache_pw_store(struct sss_mc_ctx **_mcc,
                                 struct sized_string *name,
@@ -50,6 +63,30 @@ errno_t sss_mmap_cache_gr_store(struct sss_mc_ctx **_mcc,
                                 gid_t gid, size_t memnum,
                                 char *membuf, size_t memsize);
 
+/* Negative records let the clients answer "not found" on their own until
+ * ttl seconds pass */
+errno_t sss_mmap_cache_pw_store_negative(struct sss_mc_ctx **_mcc,
+                                         struct sized_string *name,
+                                         time_t ttl);
+
+errno_t sss_mmap_cache_pw_store_negative_uid(struct sss_mc_ctx **_mcc,
+                                             uid_t uid, time_t ttl);
+
+errno_t sss_mmap_cache_gr_store_negative(struct sss_mc_ctx **_mcc,
+                                         struct sized_string *name,
+                                         time_t ttl);
+
+errno_t sss_mmap_cache_gr_store_negative_gid(struct sss_mc_ctx **_mcc,
+                                             gid_t gid, time_t ttl);
+
+/* Stores the id and, if name is not NULL, the fully qualified name of a
+ * SID. If by_id is true the record also answers lookups by the id. */
+errno_t sss_mmap_cache_sid_store(struct sss_mc_ctx **_mcc,
+                                 struct sized_string *sid,
+                                 struct sized_string *name,
+                                 uint32_t id, uint32_t type,
+                                 bool by_id);
+
 errno_t sss_mmap_cache_pw_invalidate(struct sss_mc_ctx *mcc,
                                      struct sized_string *name);
 
@@ -60,8 +97,10 @@ errno_t sss_mmap_cache_gr_invalidate(struct sss_mc_ctx *mcc,
 
 errno_t sss_mmap_cache_gr_invalidate_gid(struct sss_mc_ctx *mcc, gid_t gid);
 
+/* Passing -1 as n_elem, max_elem or timeout keeps the current value */
 errno_t sss_mmap_cache_reinit(TALLOC_CTX *mem_ctx, size_t n_elem,
-                              time_t timeout, struct sss_mc_ctx **mc_ctx);
+                              size_t max_elem, time_t timeout,
+                              struct sss_mc_ctx **mc_ctx);
 
 void sss_mmap_cache_reset(struct sss_mc_ctx *mc_ctx);
 
@@ -59,6 +59,7 @@ struct mon_cli_iface monitor_pac_methods = {
     .clearMemcache = NULL,
     .clearEnumCache = NULL,
     .sysbusReconnect = NULL,
+    .getStats = monitor_common_get_stats,
 };
 
 static struct data_provider_iface pac_dp_methods = {
@@ -70,6 +71,7 @@ static struct data_provider_iface pac_dp_methods = {
     .hostHandler = NULL,
     .getDomains = NULL,
     .getAccountInfo = NULL,
+    .getAccountInfoMulti = NULL,
 };
 
 /* TODO: check if this can be made generic for all responders */
@@ -68,6 +68,9 @@ struct pac_req_ctx {
     char *user_sid_str;
     char *user_dom_sid_str;
     char *primary_group_sid_str;
+
+    struct timeval start;
+    size_t lookup_count;
 };
 
 static errno_t pac_resolve_sids_next(struct pac_req_ctx *pr_ctx);
@@ -75,8 +78,8 @@ static void pac_lookup_sids_done(struct tevent_req *req);
 static struct tevent_req *pac_lookup_sids_send(TALLOC_CTX *mem_ctx,
                                                struct tevent_context *ev,
                                                struct pac_req_ctx *pr_ctx,
-                                               struct pac_ctx *pac_ctx,
-                                               hash_table_t *sid_table);
+                                               const char **sids,
+                                               size_t num_sids);
 static errno_t pac_lookup_sids_recv(struct tevent_req *req);
 static void pac_add_user_next(struct pac_req_ctx *pr_ctx);
 static void pac_get_domains_done(struct tevent_req *req);
@@ -87,8 +90,6 @@ static errno_t pac_user_get_grp_info(TALLOC_CTX *mem_ctx,
                                      size_t *_add_sid_count,
                                      char ***_add_sids);
 static errno_t save_pac_user(struct pac_req_ctx *pr_ctx);
-static void pac_get_group_done(struct tevent_req *subreq);
-static errno_t pac_save_memberships_next(struct tevent_req *req);
 static errno_t pac_store_membership(struct pac_req_ctx *pr_ctx,
                                     struct ldb_dn *user_dn,
                                     const char *grp_sid_str,
@@ -115,6 +116,7 @@ static errno_t pac_add_pac_user(struct cli_ctx *cctx)
     }
 
     pr_ctx->cctx = cctx;
+    pr_ctx->start = tevent_timeval_current();
 
     pr_ctx->pac_ctx = talloc_get_type(cctx->rctx->pvt_ctx,  struct pac_ctx);
     if (pr_ctx->pac_ctx == NULL) {
@@ -224,6 +226,10 @@ static errno_t pac_resolve_sids_next(struct pac_req_ctx *pr_ctx)
 {
     int ret;
     struct tevent_req *req;
+    struct hash_iter_context_t *iter;
+    hash_entry_t *entry;
+    const char **sids;
+    size_t num_sids = 0;
 
     ret = get_sids_from_pac(pr_ctx, pr_ctx->pac_ctx, pr_ctx->logon_info,
                             &pr_ctx->user_sid_str,
@@ -234,8 +240,32 @@ static errno_t pac_resolve_sids_next(struct pac_req_ctx *pr_ctx)
         return ret;
     }
 
+    /* SIDs which could not be mapped algorithmically have to be looked up */
+    sids = talloc_array(pr_ctx, const char *,
+                        hash_count(pr_ctx->sid_table));
+    if (sids == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "talloc_array failed.\n");
+        return ENOMEM;
+    }
+
+    iter = new_hash_iter_context(pr_ctx->sid_table);
+    if (iter == NULL) {
+        DEBUG(SSSDBG_OP_FAILURE, "new_hash_iter_context failed.\n");
+        talloc_free(sids);
+        return EINVAL;
+    }
+
+    while ((entry = iter->next(iter)) != NULL) {
+        if (entry->value.ul == 0) {
+            sids[num_sids] = entry->key.str;
+            num_sids++;
+        }
+    }
+    talloc_free(iter);
+
     req = pac_lookup_sids_send(pr_ctx, pr_ctx->cctx->ev, pr_ctx,
-                               pr_ctx->pac_ctx, pr_ctx->sid_table);
+                               sids, num_sids);
+    talloc_free(sids);
     if (req == NULL) {
         DEBUG(SSSDBG_OP_FAILURE, "pac_lookup_sids_send failed.\n");
         return ENOMEM;
@@ -618,31 +648,42 @@ done:
 }
 
 struct pac_save_memberships_state {
-    size_t sid_iter;
     struct ldb_dn *user_dn;
+    struct sss_domain_info **grp_doms;
 
     struct pac_req_ctx *pr_ctx;
 };
 
 static errno_t
 pac_save_memberships_delete(struct pac_save_memberships_state *state);
+static errno_t
+pac_save_memberships_store(struct pac_save_memberships_state *state);
+static void pac_save_memberships_lookup_done(struct tevent_req *subreq);
 
+/* Groups which are not in the cache yet are looked up all at once before
+ * the memberships are written, so that all changes can be done in a single
+ * sysdb transaction. */
 struct tevent_req *pac_save_memberships_send(struct pac_req_ctx *pr_ctx)
 {
     struct pac_save_memberships_state *state;
     struct sss_domain_info *dom = pr_ctx->dom;
     struct tevent_req *req;
+    struct tevent_req *subreq;
     errno_t ret;
     char *dom_name = NULL;
     struct ldb_message *msg;
+    struct ldb_result *res;
+    const char *attrs[] = { SYSDB_OBJECTCLASS, NULL };
+    const char **missing = NULL;
+    size_t missing_count = 0;
+    char *sid;
+    size_t c;
 
     req = tevent_req_create(pr_ctx, &state, struct pac_save_memberships_state);
     if (req == NULL) {
         return NULL;
     }
 
-    state->sid_iter = 0;
-
     dom_name = sss_get_domain_name(state, pr_ctx->user_name, dom);
     if (dom_name == NULL) {
         DEBUG(SSSDBG_OP_FAILURE, "talloc_sprintf failed.\n");
@@ -660,21 +701,74 @@ struct tevent_req *pac_save_memberships_send(struct pac_req_ctx *pr_ctx)
     state->user_dn = msg->dn;
     state->pr_ctx = pr_ctx;
 
-    ret = pac_save_memberships_delete(state);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "pac_save_memberships_delete failed.\n");
-        goto done;
+    if (pr_ctx->add_sid_count > 0) {
+        if (pr_ctx->add_sids == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "Missing list of SIDs.\n");
+            ret = EINVAL;
+            goto done;
+        }
+
+        state->grp_doms = talloc_zero_array(state, struct sss_domain_info *,
+                                            pr_ctx->add_sid_count);
+        missing = talloc_array(state, const char *, pr_ctx->add_sid_count);
+        if (state->grp_doms == NULL || missing == NULL) {
+            DEBUG(SSSDBG_OP_FAILURE, "talloc_array failed.\n");
+            ret = ENOMEM;
+            goto done;
+        }
     }
 
-    ret = pac_save_memberships_next(req);
-    if (ret == EOK) {
-        tevent_req_done(req);
-        tevent_req_post(req, pr_ctx->cctx->ev);
+    for (c = 0; c < pr_ctx->add_sid_count; c++) {
+        sid = pr_ctx->add_sids[c];
+        ret = responder_get_domain_by_id(pr_ctx->pac_ctx->rctx, sid,
+                                         &state->grp_doms[c]);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_MINOR_FAILURE, "responder_get_domain_by_id failed, " \
+                                         "will try next group\n");
+            state->grp_doms[c] = NULL;
+            continue;
+        }
+
+        ret = sysdb_search_object_by_sid(state, state->grp_doms[c], sid,
+                                         attrs, &res);
+        if (ret == ENOENT) {
+            missing[missing_count] = sid;
+            missing_count++;
+        } else if (ret == EOK) {
+            talloc_free(res);
+        } else {
+            DEBUG(SSSDBG_MINOR_FAILURE,
+                  "sysdb_search_object_by_sid for SID [%s] failed [%d][%s].\n",
+                  sid, ret, strerror(ret));
+        }
+    }
+
+    if (missing_count > 0) {
+        DEBUG(SSSDBG_TRACE_FUNC, "%zu groups of user [%s] are not cached.\n",
+                                  missing_count, pr_ctx->user_name);
+
+        subreq = pac_lookup_sids_send(state, pr_ctx->cctx->ev, pr_ctx,
+                                      missing, missing_count);
+        if (subreq == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        tevent_req_set_callback(subreq, pac_save_memberships_lookup_done,
+                                req);
+
+        ret = EAGAIN;
+        goto done;
     }
 
+    ret = pac_save_memberships_store(state);
+
 done:
     talloc_free(dom_name);
-    if (ret != EOK && ret != EAGAIN) {
+    talloc_free(missing);
+    if (ret == EOK) {
+        tevent_req_done(req);
+        tevent_req_post(req, pr_ctx->cctx->ev);
+    } else if (ret != EAGAIN) {
         tevent_req_error(req, ret);
         tevent_req_post(req, pr_ctx->cctx->ev);
     }
@@ -682,14 +776,95 @@ done:
     return req;
 }
 
+static void pac_save_memberships_lookup_done(struct tevent_req *subreq)
+{
+    struct tevent_req *req;
+    struct pac_save_memberships_state *state;
+    errno_t ret;
+
+    req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct pac_save_memberships_state);
+
+    ret = pac_lookup_sids_recv(subreq);
+    talloc_zfree(subreq);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    ret = pac_save_memberships_store(state);
+    if (ret != EOK) {
+        tevent_req_error(req, ret);
+        return;
+    }
+
+    tevent_req_done(req);
+}
+
+static errno_t
+pac_save_memberships_store(struct pac_save_memberships_state *state)
+{
+    struct pac_req_ctx *pr_ctx = state->pr_ctx;
+    struct sysdb_ctx *sysdb = pr_ctx->dom->sysdb;
+    bool in_transaction = false;
+    errno_t ret;
+    errno_t sret;
+    size_t c;
+
+    ret = sysdb_transaction_start(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "sysdb_transaction_start failed.\n");
+        goto done;
+    }
+    in_transaction = true;
+
+    ret = pac_save_memberships_delete(state);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "pac_save_memberships_delete failed.\n");
+        goto done;
+    }
+
+    for (c = 0; c < pr_ctx->add_sid_count; c++) {
+        if (state->grp_doms[c] == NULL) {
+            continue;
+        }
+
+        /* If there is a failure for one group we still try to add the
+         * remaining groups. */
+        ret = pac_store_membership(pr_ctx, state->user_dn,
+                                   pr_ctx->add_sids[c], state->grp_doms[c]);
+        if (ret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "pac_store_membership failed, "
+                                      "trying next group.\n");
+        }
+    }
+
+    ret = sysdb_transaction_commit(sysdb);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "sysdb_transaction_commit failed.\n");
+        goto done;
+    }
+    in_transaction = false;
+
+    ret = EOK;
+done:
+    if (in_transaction) {
+        sret = sysdb_transaction_cancel(sysdb);
+        if (sret != EOK) {
+            DEBUG(SSSDBG_OP_FAILURE, "sysdb_transaction_cancel failed.\n");
+        }
+    }
+
+    return ret;
+}
+
+/* Must be called inside a transaction */
 static errno_t
 pac_save_memberships_delete(struct pac_save_memberships_state *state)
 {
     int ret;
-    int sret;
     size_t c;
     struct pac_req_ctx *pr_ctx;
-    bool in_transaction = false;
     TALLOC_CTX *tmp_ctx;
     struct sysdb_attrs *user_attrs = NULL;
 
@@ -710,13 +885,6 @@ pac_save_memberships_delete(struct pac_save_memberships_state *state)
         return ENOMEM;
     }
 
-    ret = sysdb_transaction_start(pr_ctx->dom->sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "sysdb_transaction_start failed.\n");
-        goto done;
-    }
-    in_transaction = true;
-
     for (c = 0; c < pr_ctx->del_grp_count; c++) {
         /* If there is a failure for one group we still try to remove the
          * remaining groups. */
@@ -756,136 +924,9 @@ pac_save_memberships_delete(struct pac_save_memberships_state *state)
         }
     }
 
-    ret = sysdb_transaction_commit(pr_ctx->dom->sysdb);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "sysdb_transaction_commit failed.\n");
-        goto done;
-    }
-    in_transaction = false;
-
-    ret = EOK;
-done:
-    if (in_transaction) {
-        sret = sysdb_transaction_cancel(pr_ctx->dom->sysdb);
-        if (sret != EOK) {
-            DEBUG(SSSDBG_OP_FAILURE, "sysdb_transaction_cancel failed.\n");
-        }
-    }
-
     talloc_free(tmp_ctx);
 
-    return ret;
-}
-
-static errno_t pac_save_memberships_next(struct tevent_req *req)
-{
-    errno_t ret;
-    char *sid;
-    struct sss_domain_info *grp_dom;
-    struct tevent_req *subreq;
-    struct pac_save_memberships_state *state;
-    struct pac_req_ctx *pr_ctx;
-
-    state = tevent_req_data(req, struct pac_save_memberships_state);
-    pr_ctx = state->pr_ctx;
-
-    if (pr_ctx->add_sid_count == 0) {
-        return EOK;
-    }
-
-    if (pr_ctx->add_sids == NULL) {
-        DEBUG(SSSDBG_OP_FAILURE, "Missing list of SIDs.\n");
-        return EINVAL;
-    }
-
-    while (state->sid_iter < pr_ctx->add_sid_count) {
-        sid = pr_ctx->add_sids[state->sid_iter];
-        ret = responder_get_domain_by_id(pr_ctx->pac_ctx->rctx, sid, &grp_dom);
-        if (ret != EOK) {
-            DEBUG(SSSDBG_MINOR_FAILURE, "responder_get_domain_by_id failed, " \
-                                         "will try next group\n");
-            state->sid_iter++;
-            continue;
-        }
-
-        ret = pac_store_membership(state->pr_ctx, state->user_dn, sid, grp_dom);
-        if (ret == EOK) {
-            state->sid_iter++;
-            continue;
-        } else if (ret == ENOENT) {
-            subreq = sss_dp_get_account_send(state, pr_ctx->cctx->rctx,
-                                             grp_dom, true,
-                                             SSS_DP_SECID, sid, 0, NULL);
-            if (subreq == NULL) {
-                ret = ENOMEM;
-                goto done;
-            }
-            tevent_req_set_callback(subreq, pac_get_group_done, req);
-
-            return EAGAIN;
-        } else  {
-            DEBUG(SSSDBG_OP_FAILURE, "pac_store_membership failed, "
-                                      "trying next group.\n");
-            state->sid_iter++;
-            continue;
-        }
-    }
-
-    ret = EOK;
-done:
-    return ret;
-}
-
-static void pac_get_group_done(struct tevent_req *subreq)
-{
-    struct tevent_req *req;
-    struct pac_save_memberships_state *state;
-
-    req = tevent_req_callback_data(subreq, struct tevent_req);
-    state = tevent_req_data(req, struct pac_save_memberships_state);
-
-    errno_t ret;
-    dbus_uint16_t err_maj;
-    dbus_uint32_t err_min;
-    char *err_msg;
-    char *sid;
-    struct sss_domain_info *grp_dom;
-    struct pac_req_ctx *pr_ctx = state->pr_ctx;
-
-    ret = sss_dp_get_account_recv(req, subreq,
-                                  &err_maj, &err_min,
-                                  &err_msg);
-    talloc_zfree(subreq);
-    talloc_zfree(err_msg);
-    if (ret != EOK) {
-        goto error;
-    }
-
-    sid = pr_ctx->add_sids[state->sid_iter];
-    ret = responder_get_domain_by_id(pr_ctx->pac_ctx->rctx,sid, &grp_dom);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "responder_get_domain_by_id failed.\n");
-        goto error;
-    }
-
-    ret = pac_store_membership(state->pr_ctx, state->user_dn, sid, grp_dom);
-    if (ret != EOK) {
-        DEBUG(SSSDBG_OP_FAILURE, "pac_store_membership failed, "
-                                  "trying next group.\n");
-    }
-    state->sid_iter++;
-
-    ret = pac_save_memberships_next(req);
-    if (ret == EOK) {
-        tevent_req_done(req);
-    } else if (ret != EAGAIN) {
-        goto error;
-    }
-
-    return;
-
-error:
-    tevent_req_error(req, ret);
+    return EOK;
 }
 
 static errno_t
@@ -994,33 +1035,73 @@ static void pac_save_memberships_done(struct tevent_req *req)
 {
     struct pac_req_ctx *pr_ctx = tevent_req_callback_data(req, struct pac_req_ctx);
     struct cli_ctx *cctx = pr_ctx->cctx;
+    struct timeval now;
     errno_t ret;
 
     ret = pac_save_memberships_recv(req);
     talloc_zfree(req);
 
+    now = tevent_timeval_current();
+    DEBUG(SSSDBG_TRACE_FUNC,
+          "PAC of user [%s] processed in %lu ms, %zu SIDs looked up, "
+          "%zu memberships added, %zu removed [%d].\n",
+          pr_ctx->user_name,
+          (unsigned long)((now.tv_sec - pr_ctx->start.tv_sec) * 1000
+                          + (now.tv_usec - pr_ctx->start.tv_usec) / 1000),
+          pr_ctx->lookup_count, pr_ctx->add_sid_count,
+          pr_ctx->del_grp_count, ret);
+
     talloc_free(pr_ctx);
     pac_cmd_done(cctx, ret);
 }
 
+/* Number of Data Provider requests for unknown SIDs running at the same time
+ * and the maximal number of SIDs of one domain sent with each of them */
+#define PAC_LOOKUP_WINDOW 4
+#define PAC_LOOKUP_BATCH_SIZE 64
+
+struct pac_sid_lookup {
+    const char *sid;
+    struct sss_domain_info *dom;
+};
+
 struct pac_lookup_sids_state {
     struct pac_ctx *pac_ctx;
     struct pac_req_ctx *pr_ctx;
-    hash_table_t *sid_table;
-    struct hash_iter_context_t *iter;
+
+    struct pac_sid_lookup *lookups;
+    size_t count;
+    size_t next;
+    size_t running;
 };
 
+static int pac_sid_lookup_cmp(const void *a, const void *b)
+{
+    const struct pac_sid_lookup *la = (const struct pac_sid_lookup *)a;
+    const struct pac_sid_lookup *lb = (const struct pac_sid_lookup *)b;
+
+    if ((uintptr_t)la->dom < (uintptr_t)lb->dom) {
+        return -1;
+    } else if ((uintptr_t)la->dom > (uintptr_t)lb->dom) {
+        return 1;
+    }
+
+    return 0;
+}
+
 static errno_t pac_lookup_sids_next(struct tevent_req *req);
 static void pac_lookup_sids_next_done(struct tevent_req *subreq);
 
 static struct tevent_req *pac_lookup_sids_send(TALLOC_CTX *mem_ctx,
                                                struct tevent_context *ev,
                                                struct pac_req_ctx *pr_ctx,
-                                               struct pac_ctx *pac_ctx,
-                                               hash_table_t *sid_table)
+                                               const char **sids,
+                                               size_t num_sids)
 {
     struct tevent_req *req;
     struct pac_lookup_sids_state *state;
+    struct sss_domain_info *dom;
+    size_t c;
     int ret;
 
     req = tevent_req_create(mem_ctx, &state, struct pac_lookup_sids_state);
@@ -1028,13 +1109,39 @@ static struct tevent_req *pac_lookup_sids_send(TALLOC_CTX *mem_ctx,
         return NULL;
     }
 
-    state->pac_ctx = pac_ctx;
+    state->pac_ctx = pr_ctx->pac_ctx;
     state->pr_ctx = pr_ctx;
-    state->sid_table = sid_table;
-    state->iter = talloc_steal(state, new_hash_iter_context(state->sid_table));
+
+    state->lookups = talloc_array(state, struct pac_sid_lookup, num_sids);
+    if (state->lookups == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    for (c = 0; c < num_sids; c++) {
+        ret = responder_get_domain_by_id(state->pac_ctx->rctx, sids[c], &dom);
+        if (ret != EOK || dom == NULL) {
+            continue;
+        }
+
+        state->lookups[state->count].sid = talloc_strdup(state->lookups,
+                                                         sids[c]);
+        if (state->lookups[state->count].sid == NULL) {
+            ret = ENOMEM;
+            goto done;
+        }
+        state->lookups[state->count].dom = dom;
+        state->count++;
+    }
+    pr_ctx->lookup_count += state->count;
+
+    /* SIDs of the same domain are sent together */
+    qsort(state->lookups, state->count, sizeof(struct pac_sid_lookup),
+          pac_sid_lookup_cmp);
 
     ret = pac_lookup_sids_next(req);
 
+done:
     if (ret != EAGAIN) {
         if (ret == EOK) {
             tevent_req_done(req);
@@ -1047,53 +1154,59 @@ static struct tevent_req *pac_lookup_sids_send(TALLOC_CTX *mem_ctx,
     return req;
 }
 
-
 static errno_t pac_lookup_sids_next(struct tevent_req *req)
 {
     struct pac_lookup_sids_state *state;
     state = tevent_req_data(req, struct pac_lookup_sids_state);
-    hash_entry_t *entry;
+    const char *batch[PAC_LOOKUP_BATCH_SIZE];
     struct tevent_req *subreq;
     struct sss_domain_info *dom;
-    int ret;
+    size_t num;
+
+    while (state->running < PAC_LOOKUP_WINDOW && state->next < state->count) {
+        dom = state->lookups[state->next].dom;
+        num = 0;
+        while (num < PAC_LOOKUP_BATCH_SIZE && state->next < state->count
+                && state->lookups[state->next].dom == dom) {
+            batch[num] = state->lookups[state->next].sid;
+            num++;
+            state->next++;
+        }
 
-    while ((entry = state->iter->next(state->iter)) != NULL) {
-        if (entry->value.ul == 0) {
-            ret = responder_get_domain_by_id(state->pac_ctx->rctx,
-                                             entry->key.str, &dom);
-            if (ret == EOK && dom != NULL) {
-                subreq = sss_dp_get_account_send(state,
-                                                 state->pr_ctx->cctx->rctx,
-                                                 dom, true,
-                                                 SSS_DP_SECID, entry->key.str,
-                                                 0, NULL);
-                if (subreq == NULL) {
-                    return ENOMEM;
-                }
-                tevent_req_set_callback(subreq, pac_lookup_sids_next_done, req);
-                return EAGAIN;
-            }
+        DEBUG(SSSDBG_TRACE_INTERNAL, "Looking up %zu SIDs of domain [%s].\n",
+                                      num, dom->name);
+
+        subreq = sss_dp_get_account_multi_send(state,
+                                               state->pr_ctx->cctx->rctx,
+                                               dom, true, SSS_DP_SECID,
+                                               batch, NULL, num, NULL);
+        if (subreq == NULL) {
+            return ENOMEM;
         }
+        tevent_req_set_callback(subreq, pac_lookup_sids_next_done, req);
+        state->running++;
     }
 
-    return EOK;
+    return state->running == 0 ? EOK : EAGAIN;
 }
 
 static void pac_lookup_sids_next_done(struct tevent_req *subreq)
 {
     struct tevent_req *req;
+    struct pac_lookup_sids_state *state;
 
     req = tevent_req_callback_data(subreq, struct tevent_req);
+    state = tevent_req_data(req, struct pac_lookup_sids_state);
 
     errno_t ret;
-    dbus_uint16_t err_maj;
-    dbus_uint32_t err_min;
-    char *err_msg;
-
-    ret = sss_dp_get_account_recv(req, subreq,
-                                  &err_maj, &err_min,
-                                  &err_msg);
-    if (ret != EOK) {
+    dbus_uint16_t err_maj = 0;
+    dbus_uint32_t err_min = 0;
+    char *err_msg = NULL;
+
+    ret = sss_dp_get_account_multi_recv(req, subreq,
+                                        &err_maj, &err_min,
+                                        &err_msg);
+    if (ret != EOK || err_maj != DP_ERR_OK) {
         DEBUG(SSSDBG_OP_FAILURE,
               "Unable to get information from Data Provider\n"
               "dp_error: [%u], errno: [%u], error_msg: [%s]\n",
@@ -1103,6 +1216,7 @@ static void pac_lookup_sids_next_done(struct tevent_req *subreq)
 
     talloc_zfree(subreq);
     talloc_zfree(err_msg);
+    state->running--;
     /* Errors during individual lookups are ignored. */
 
     ret = pac_lookup_sids_next(req);
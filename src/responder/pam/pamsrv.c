@@ -62,17 +62,14 @@ struct mon_cli_iface monitor_pam_methods = {
     .clearMemcache = NULL,
     .clearEnumCache = NULL,
     .sysbusReconnect = NULL,
+    .getStats = monitor_common_get_stats,
 };
 
-static struct data_provider_iface pam_dp_methods = {
-    { &data_provider_iface_meta, 0 },
-    .RegisterService = NULL,
-    .pamHandler = NULL,
-    .sudoHandler = NULL,
-    .autofsHandler = NULL,
-    .hostHandler = NULL,
-    .getDomains = NULL,
-    .getAccountInfo = NULL,
+static struct data_provider_rev_iface pam_dp_methods = {
+    { &data_provider_rev_iface_meta, 0 },
+    .updateCache = NULL,
+    .initgrCheck = NULL,
+    .invalidateCache = responder_invalidate_lru,
 };
 
 static void pam_dp_reconnect_init(struct sbus_connection *conn, int status, void *pvt)
@@ -662,6 +662,12 @@ static void pam_reply(struct pam_auth_req *preq)
         return;
     }
 
+    if (pd->pam_status != PAM_SUCCESS
+            && pd->pam_status != PAM_USER_UNKNOWN
+            && pd->pam_status != PAM_IGNORE) {
+        debug_ring_dump("PAM request failed");
+    }
+
     ret = sss_packet_new(cctx->creq, 0, sss_packet_get_cmd(cctx->creq->in),
                          &cctx->creq->out);
     if (ret != EOK) {
@@ -1167,7 +1173,8 @@ static int pam_check_user_search(struct pam_auth_req *preq)
         if (preq->pd->name_is_upn) {
             ret = sysdb_search_user_by_upn(preq, dom, name, user_attrs, &msg);
         } else {
-            ret = sysdb_getpwnam_with_views(preq, dom, name, &res);
+            ret = resp_lru_getpwnam(preq, preq->cctx->rctx->lru, dom, name,
+                                    &res);
             if (res->count > 1) {
                 DEBUG(SSSDBG_FATAL_FAILURE,
                       "getpwnam call returned more than one result !?!\n");
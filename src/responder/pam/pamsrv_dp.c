@@ -28,6 +28,7 @@
 #include "util/util.h"
 #include "responder/common/responder_packet.h"
 #include "providers/data_provider.h"
+#include "providers/dp_fastpath.h"
 #include "sbus/sbus_client.h"
 #include "responder/pam/pamsrv.h"
 
@@ -103,6 +104,74 @@ static int pdp_req_destructor(struct pam_auth_dp_req *pdp_req)
     return 0;
 }
 
+static uint8_t *pam_dp_fastpath_msg(TALLOC_CTX *mem_ctx, void *pvt,
+                                    uint32_t serial, size_t *_len)
+{
+    struct pam_data *pd;
+    uint8_t *frame;
+    errno_t ret;
+
+    pd = talloc_get_type(pvt, struct pam_data);
+
+    ret = dp_fastpath_encode_pam_req(mem_ctx, serial, pd, &frame, _len);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot build fast path request [%d]: %s\n",
+              ret, sss_strerror(ret));
+        return NULL;
+    }
+
+    return frame;
+}
+
+static void pam_dp_fastpath_reply(struct be_conn *be_conn,
+                                  struct dp_fastpath_hdr *hdr,
+                                  const uint8_t *body,
+                                  errno_t ret,
+                                  void *pvt)
+{
+    struct pam_auth_req *preq = NULL;
+    struct pam_auth_dp_req *pdp_req;
+
+    pdp_req = talloc_get_type(pvt, struct pam_auth_dp_req);
+    preq = pdp_req->preq;
+    talloc_free(pdp_req);
+
+    /* Check if the client still exists. If not, simply free all the resources
+     * and quit */
+    if (preq == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE, "Client already disconnected\n");
+        return;
+    }
+
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "No reply from the fast path [%d]: %s\n",
+              ret, sss_strerror(ret));
+        preq->pd->pam_status = PAM_SYSTEM_ERR;
+        goto done;
+    }
+
+    if (hdr->method != DP_FASTPATH_PAM_REPLY) {
+        DEBUG(SSSDBG_FATAL_FAILURE,
+              "Unexpected method %"PRIu16"\n", hdr->method);
+        preq->pd->pam_status = PAM_SYSTEM_ERR;
+        goto done;
+    }
+
+    ret = dp_fastpath_decode_pam_reply(body, hdr->len, preq->pd);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Failed to parse reply.\n");
+        preq->pd->pam_status = PAM_SYSTEM_ERR;
+        goto done;
+    }
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "received: [%d][%s]\n", preq->pd->pam_status, preq->pd->domain);
+
+done:
+    preq->callback(preq);
+}
+
 int pam_dp_send_req(struct pam_auth_req *preq, int timeout)
 {
     struct pam_data *pd = preq->pd;
@@ -126,33 +195,47 @@ int pam_dp_send_req(struct pam_auth_req *preq, int timeout)
         return EIO;
     }
 
+    DEBUG(SSSDBG_CONF_SETTINGS, "Sending request with the following data:\n");
+    DEBUG_PAM_DATA(SSSDBG_CONF_SETTINGS, pd);
+
+    pdp_req = talloc(preq->cctx->rctx, struct pam_auth_dp_req);
+    if (pdp_req == NULL) {
+        return ENOMEM;
+    }
+    pdp_req->preq = preq;
+    preq->dpreq_spy = pdp_req;
+    talloc_set_destructor(pdp_req, pdp_req_destructor);
+
+    /* Use the fast path if the back end accepts it */
+    res = sss_dp_fastpath_issue(pdp_req, preq->cctx->rctx, preq->domain,
+                                timeout, pam_dp_fastpath_msg, pd,
+                                pam_dp_fastpath_reply, pdp_req);
+    if (res == EOK) {
+        return EOK;
+    } else if (res != ENOTCONN) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Fast path send failed [%d]: %s, using D-Bus\n",
+              res, sss_strerror(res));
+    }
+
     msg = dbus_message_new_method_call(NULL,
                                        DP_PATH,
                                        DATA_PROVIDER_IFACE,
                                        DATA_PROVIDER_IFACE_PAMHANDLER);
     if (msg == NULL) {
         DEBUG(SSSDBG_FATAL_FAILURE,"Out of memory?!\n");
+        talloc_free(pdp_req);
         return ENOMEM;
     }
 
-
-    DEBUG(SSSDBG_CONF_SETTINGS, "Sending request with the following data:\n");
-    DEBUG_PAM_DATA(SSSDBG_CONF_SETTINGS, pd);
-
     ret = dp_pack_pam_request(msg, pd);
     if (!ret) {
         DEBUG(SSSDBG_CRIT_FAILURE,"Failed to build message\n");
+        dbus_message_unref(msg);
+        talloc_free(pdp_req);
         return EIO;
     }
 
-    pdp_req = talloc(preq->cctx->rctx, struct pam_auth_dp_req);
-    if (pdp_req == NULL) {
-        return ENOMEM;
-    }
-    pdp_req->preq = preq;
-    preq->dpreq_spy = pdp_req;
-    talloc_set_destructor(pdp_req, pdp_req_destructor);
-
     res = sbus_conn_send(be_conn->conn, msg,
                          timeout, pam_dp_process_reply,
                          pdp_req, NULL);
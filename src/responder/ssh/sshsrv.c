@@ -39,6 +39,7 @@ struct mon_cli_iface monitor_ssh_methods = {
     .clearMemcache = NULL,
     .clearEnumCache = NULL,
     .sysbusReconnect = NULL,
+    .getStats = monitor_common_get_stats,
 };
 
 static struct data_provider_iface ssh_dp_methods = {
@@ -50,6 +51,7 @@ static struct data_provider_iface ssh_dp_methods = {
     .hostHandler = NULL,
     .getDomains = NULL,
     .getAccountInfo = NULL,
+    .getAccountInfoMulti = NULL,
 };
 
 static void ssh_dp_reconnect_init(struct sbus_connection *conn,
@@ -40,6 +40,7 @@ struct mon_cli_iface monitor_sudo_methods = {
     .clearMemcache = NULL,
     .clearEnumCache = NULL,
     .sysbusReconnect = NULL,
+    .getStats = monitor_common_get_stats,
 };
 
 static struct data_provider_iface sudo_dp_methods = {
@@ -51,6 +52,7 @@ static struct data_provider_iface sudo_dp_methods = {
     .hostHandler = NULL,
     .getDomains = NULL,
     .getAccountInfo = NULL,
+    .getAccountInfoMulti = NULL,
 };
 
 static void sudo_dp_reconnect_init(struct sbus_connection *conn,
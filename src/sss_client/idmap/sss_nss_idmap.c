@@ -27,6 +27,7 @@
 #include <nss.h>
 
 #include "sss_client/sss_cli.h"
+#include "sss_client/nss_mc.h"
 #include "sss_client/idmap/sss_nss_idmap.h"
 #include "util/strtonum.h"
 
@@ -138,8 +139,10 @@ done:
     return ret;
 }
 
-static int sss_nss_getyyybyxxx(union input inp, enum sss_cli_command cmd ,
-                               struct output *out)
+/* The caller must hold the nss lock */
+static int sss_nss_getyyybyxxx_unlocked(union input inp,
+                                        enum sss_cli_command cmd,
+                                        struct output *out)
 {
     int ret;
     size_t inp_len;
@@ -177,8 +180,6 @@ static int sss_nss_getyyybyxxx(union input inp, enum sss_cli_command cmd ,
         return EINVAL;
     }
 
-    sss_nss_lock();
-
     nret = sss_nss_make_request(cmd, &rd, &repbuf, &replen, &errnop);
     if (nret != NSS_STATUS_SUCCESS) {
         ret = nss_status_to_errno(nret);
@@ -252,7 +253,6 @@ static int sss_nss_getyyybyxxx(union input inp, enum sss_cli_command cmd ,
     ret = EOK;
 
 done:
-    sss_nss_unlock();
     free(repbuf);
     if (ret != EOK) {
         free(str);
@@ -261,6 +261,18 @@ done:
     return ret;
 }
 
+static int sss_nss_getyyybyxxx(union input inp, enum sss_cli_command cmd,
+                               struct output *out)
+{
+    int ret;
+
+    sss_nss_lock();
+    ret = sss_nss_getyyybyxxx_unlocked(inp, cmd, out);
+    sss_nss_unlock();
+
+    return ret;
+}
+
 int sss_nss_getsidbyname(const char *fq_name, char **sid,
                          enum sss_id_type *type)
 {
@@ -286,6 +298,7 @@ int sss_nss_getsidbyname(const char *fq_name, char **sid,
 int sss_nss_getsidbyid(uint32_t id, char **sid, enum sss_id_type *type)
 {
     int ret;
+    uint32_t mc_type;
     union input inp;
     struct output out;
 
@@ -293,6 +306,12 @@ int sss_nss_getsidbyid(uint32_t id, char **sid, enum sss_id_type *type)
         return EINVAL;
     }
 
+    ret = sss_nss_mc_getsidbyid(id, sid, &mc_type);
+    if (ret == EOK) {
+        *type = mc_type;
+        return EOK;
+    }
+
     inp.id = id;
 
     ret = sss_nss_getyyybyxxx(inp, SSS_NSS_GETSIDBYID, &out);
@@ -308,6 +327,7 @@ int sss_nss_getnamebysid(const char *sid, char **fq_name,
                          enum sss_id_type *type)
 {
     int ret;
+    uint32_t mc_type;
     union input inp;
     struct output out;
 
@@ -315,6 +335,12 @@ int sss_nss_getnamebysid(const char *sid, char **fq_name,
         return EINVAL;
     }
 
+    ret = sss_nss_mc_getnamebysid(sid, fq_name, &mc_type);
+    if (ret == EOK) {
+        *type = mc_type;
+        return EOK;
+    }
+
     inp.str = sid;
 
     ret = sss_nss_getyyybyxxx(inp, SSS_NSS_GETNAMEBYSID, &out);
@@ -329,6 +355,7 @@ int sss_nss_getnamebysid(const char *sid, char **fq_name,
 int sss_nss_getidbysid(const char *sid, uint32_t *id, enum sss_id_type *id_type)
 {
     int ret;
+    uint32_t mc_type;
     union input inp;
     struct output out;
 
@@ -336,6 +363,12 @@ int sss_nss_getidbysid(const char *sid, uint32_t *id, enum sss_id_type *id_type)
         return EINVAL;
     }
 
+    ret = sss_nss_mc_getidbysid(sid, id, &mc_type);
+    if (ret == EOK) {
+        *id_type = mc_type;
+        return EOK;
+    }
+
     inp.str = sid;
 
     ret = sss_nss_getyyybyxxx(inp, SSS_NSS_GETIDBYSID, &out);
@@ -368,3 +401,129 @@ int sss_nss_getorigbyname(const char *fq_name, struct sss_nss_kv **kv_list,
 
     return ret;
 }
+
+/* Resolves the SIDs found in the memory cache first and sends the requests
+ * for the remaining ones under a single lock. */
+static int sss_nss_getyyybysids(const char *const *sids, size_t num,
+                                enum sss_cli_command cmd,
+                                struct output *out)
+{
+    int ret;
+    int err = EOK;
+    size_t c;
+    size_t missing = 0;
+    union input inp;
+    uint32_t mc_type;
+
+    for (c = 0; c < num; c++) {
+        out[c].type = SSS_ID_TYPE_NOT_SPECIFIED;
+        if (sids[c] == NULL || *sids[c] == '\0') {
+            continue;
+        }
+
+        if (cmd == SSS_NSS_GETIDBYSID) {
+            ret = sss_nss_mc_getidbysid(sids[c], &out[c].d.id, &mc_type);
+        } else {
+            ret = sss_nss_mc_getnamebysid(sids[c], &out[c].d.str, &mc_type);
+        }
+        if (ret == EOK) {
+            out[c].type = mc_type;
+        } else {
+            missing++;
+        }
+    }
+
+    if (missing == 0) {
+        return EOK;
+    }
+
+    sss_nss_lock();
+
+    for (c = 0; c < num; c++) {
+        if (out[c].type != SSS_ID_TYPE_NOT_SPECIFIED
+                || sids[c] == NULL || *sids[c] == '\0') {
+            continue;
+        }
+
+        inp.str = sids[c];
+        ret = sss_nss_getyyybyxxx_unlocked(inp, cmd, &out[c]);
+        if (ret != EOK) {
+            out[c].type = SSS_ID_TYPE_NOT_SPECIFIED;
+            if (ret != ENOENT && err == EOK) {
+                err = ret;
+            }
+        }
+    }
+
+    sss_nss_unlock();
+
+    return err;
+}
+
+int sss_nss_getidsbysids(const char *const *sids, size_t num,
+                         uint32_t *ids, enum sss_id_type *types)
+{
+    int ret;
+    size_t c;
+    struct output *out;
+
+    if (sids == NULL || ids == NULL || types == NULL) {
+        return EINVAL;
+    }
+
+    if (num == 0) {
+        return EOK;
+    }
+
+    out = calloc(num, sizeof(struct output));
+    if (out == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_nss_getyyybysids(sids, num, SSS_NSS_GETIDBYSID, out);
+
+    for (c = 0; c < num; c++) {
+        types[c] = out[c].type;
+        ids[c] = (out[c].type == SSS_ID_TYPE_NOT_SPECIFIED) ? 0 : out[c].d.id;
+    }
+
+    free(out);
+
+    return ret;
+}
+
+int sss_nss_getnamesbysids(const char *const *sids, size_t num,
+                           char **fq_names, enum sss_id_type *types)
+{
+    int ret;
+    size_t c;
+    struct output *out;
+
+    if (sids == NULL || fq_names == NULL || types == NULL) {
+        return EINVAL;
+    }
+
+    if (num == 0) {
+        return EOK;
+    }
+
+    out = calloc(num, sizeof(struct output));
+    if (out == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_nss_getyyybysids(sids, num, SSS_NSS_GETNAMEBYSID, out);
+
+    for (c = 0; c < num; c++) {
+        types[c] = out[c].type;
+        if (out[c].type == SSS_ID_TYPE_NOT_SPECIFIED) {
+            fq_names[c] = NULL;
+        } else {
+            fq_names[c] = out[c].d.str;
+        }
+    }
+
+    free(out);
+
+    return ret;
+}
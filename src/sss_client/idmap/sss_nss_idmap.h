@@ -102,6 +102,46 @@ int sss_nss_getnamebysid(const char *sid, char **fq_name,
 int sss_nss_getidbysid(const char *sid, uint32_t *id,
                        enum sss_id_type *id_type);
 
+/**
+ * @brief Return the POSIX IDs for a list of SIDs
+ *
+ * The SIDs found in the in-memory cache of SSSD are resolved without
+ * contacting SSSD, the remaining ones are sent in a row.
+ *
+ * @param[in] sids     Array of string representations of the SIDs
+ * @param[in] num      Number of elements in sids
+ * @param[out] ids     Array of num elements, the POSIX IDs of the SIDs
+ * @param[out] types   Array of num elements, the types of the objects,
+ *                     SSS_ID_TYPE_NOT_SPECIFIED if the SID could not be
+ *                     resolved
+ *
+ * @return
+ *  - 0 (EOK): all lookups were done, SIDs which are not known have the
+ *             type SSS_ID_TYPE_NOT_SPECIFIED
+ *  - EINVAL: invalid input
+ *  - ENOMEM: memory allocation failed
+ *  - any other error of #sss_nss_getsidbyname: at least one lookup failed,
+ *    the results of the other SIDs are filled in nevertheless
+ */
+int sss_nss_getidsbysids(const char *const *sids, size_t num,
+                         uint32_t *ids, enum sss_id_type *types);
+
+/**
+ * @brief Return the fully qualified names for a list of SIDs
+ *
+ * @param[in] sids     Array of string representations of the SIDs
+ * @param[in] num      Number of elements in sids
+ * @param[out] fq_names Array of num elements, the fully qualified names or
+ *                     NULL if the SID could not be resolved, each name
+ *                     must be freed by the caller
+ * @param[out] types   Array of num elements, the types of the objects
+ *
+ * @return
+ *  - see #sss_nss_getidsbysids
+ */
+int sss_nss_getnamesbysids(const char *const *sids, size_t num,
+                           char **fq_names, enum sss_id_type *types);
+
 /**
  * @brief Find original data by fully qualified name
  *
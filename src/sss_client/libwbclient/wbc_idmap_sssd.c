@@ -21,6 +21,8 @@
 
 /* Required Headers */
 
+#include <errno.h>
+
 #include "sss_client/idmap/sss_nss_idmap.h"
 
 #include "libwbclient.h"
@@ -165,41 +167,70 @@ wbcErr wbcSidsToUnixIds(const struct wbcDomainSid *sids, uint32_t num_sids,
             struct wbcUnixId *ids)
 {
     int ret;
-    char *sid_str;
-    uint32_t id;
-    enum sss_id_type type;
+    char **sid_strs = NULL;
+    uint32_t *sss_ids = NULL;
+    enum sss_id_type *types = NULL;
     size_t c;
     wbcErr wbc_status;
 
+    if (num_sids == 0) {
+        return WBC_ERR_SUCCESS;
+    }
+
+    sid_strs = calloc(num_sids, sizeof(char *));
+    sss_ids = calloc(num_sids, sizeof(uint32_t));
+    types = calloc(num_sids, sizeof(enum sss_id_type));
+    if (sid_strs == NULL || sss_ids == NULL || types == NULL) {
+        wbc_status = WBC_ERR_NO_MEMORY;
+        goto done;
+    }
+
     for (c = 0; c < num_sids; c++) {
-        wbc_status = wbcSidToString(&sids[c], &sid_str);
+        wbc_status = wbcSidToString(&sids[c], &sid_strs[c]);
         if (!WBC_ERROR_IS_OK(wbc_status)) {
-            return wbc_status;
+            goto done;
         }
+    }
 
-        ret = sss_nss_getidbysid(sid_str, &id, &type);
-        wbcFreeMemory(sid_str);
-        if (ret != 0) {
-            return WBC_ERR_UNKNOWN_FAILURE;
-        }
+    /* SIDs which cannot be mapped are returned as WBC_ID_TYPE_NOT_SPECIFIED
+     * like winbind does */
+    ret = sss_nss_getidsbysids((const char *const *) sid_strs, num_sids,
+                               sss_ids, types);
+    if (ret != 0 && ret != ENOENT) {
+        wbc_status = WBC_ERR_UNKNOWN_FAILURE;
+        goto done;
+    }
 
-        switch (type) {
+    for (c = 0; c < num_sids; c++) {
+        switch (types[c]) {
         case SSS_ID_TYPE_UID:
             ids[c].type = WBC_ID_TYPE_UID;
-            ids[c].id.uid = (uid_t) id;
+            ids[c].id.uid = (uid_t) sss_ids[c];
             break;
         case SSS_ID_TYPE_GID:
             ids[c].type = WBC_ID_TYPE_GID;
-            ids[c].id.gid = (gid_t) id;
+            ids[c].id.gid = (gid_t) sss_ids[c];
             break;
         case SSS_ID_TYPE_BOTH:
             ids[c].type = WBC_ID_TYPE_BOTH;
-            ids[c].id.uid = (uid_t) id;
+            ids[c].id.uid = (uid_t) sss_ids[c];
             break;
         default:
             ids[c].type = WBC_ID_TYPE_NOT_SPECIFIED;
         }
     }
 
-    return WBC_ERR_SUCCESS;
+    wbc_status = WBC_ERR_SUCCESS;
+
+done:
+    if (sid_strs != NULL) {
+        for (c = 0; c < num_sids; c++) {
+            wbcFreeMemory(sid_strs[c]);
+        }
+        free(sid_strs);
+    }
+    free(sss_ids);
+    free(types);
+
+    return wbc_status;
 }
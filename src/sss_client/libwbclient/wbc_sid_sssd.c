@@ -155,11 +155,171 @@ done:
     return wbc_status;
 }
 
+static void wbcDomainInfosDestructor(void *ptr)
+{
+    struct wbcDomainInfo *i = (struct wbcDomainInfo *)ptr;
+
+    while (i->short_name != NULL) {
+        free(i->short_name);
+        free(i->dns_name);
+        i += 1;
+    }
+}
+
+static void wbcTranslatedNamesDestructor(void *ptr)
+{
+    struct wbcTranslatedName *n = (struct wbcTranslatedName *)ptr;
+
+    while (n->name != NULL) {
+        free(n->name);
+        n += 1;
+    }
+}
+
+/* Returns the index of the domain of the SID in domains, adds it if it is
+ * not there yet */
+static wbcErr wbc_lookup_sids_domain(const struct wbcDomainSid *sid,
+                                     const char *domain_name,
+                                     struct wbcDomainInfo *domains,
+                                     int *num_domains, int *idx)
+{
+    int c;
+
+    for (c = 0; c < *num_domains; c++) {
+        if (strcasecmp(domains[c].dns_name, domain_name) == 0) {
+            *idx = c;
+            return WBC_ERR_SUCCESS;
+        }
+    }
+
+    domains[c].dns_name = strdup(domain_name);
+    domains[c].short_name = strdup(domain_name);
+    if (domains[c].dns_name == NULL || domains[c].short_name == NULL) {
+        free(domains[c].dns_name);
+        free(domains[c].short_name);
+        domains[c].dns_name = NULL;
+        domains[c].short_name = NULL;
+        return WBC_ERR_NO_MEMORY;
+    }
+
+    /* the domain SID is the object SID without the RID */
+    domains[c].sid = *sid;
+    if (domains[c].sid.num_auths > 0) {
+        domains[c].sid.num_auths--;
+        domains[c].sid.sub_auths[domains[c].sid.num_auths] = 0;
+    }
+
+    *idx = c;
+    (*num_domains)++;
+
+    return WBC_ERR_SUCCESS;
+}
+
 wbcErr wbcLookupSids(const struct wbcDomainSid *sids, int num_sids,
              struct wbcDomainInfo **pdomains, int *pnum_domains,
              struct wbcTranslatedName **pnames)
 {
-    WBC_SSSD_NOT_IMPLEMENTED;
+    char **str_sids = NULL;
+    char **fq_names = NULL;
+    enum sss_id_type *sss_types = NULL;
+    struct wbcDomainInfo *domains = NULL;
+    struct wbcTranslatedName *names = NULL;
+    int num_domains = 0;
+    char *p;
+    int c;
+    int ret;
+    wbcErr wbc_status;
+
+    if (num_sids < 0 || (num_sids > 0 && sids == NULL)
+            || pdomains == NULL || pnum_domains == NULL || pnames == NULL) {
+        return WBC_ERR_INVALID_PARAM;
+    }
+
+    str_sids = calloc(num_sids + 1, sizeof(char *));
+    fq_names = calloc(num_sids + 1, sizeof(char *));
+    sss_types = calloc(num_sids + 1, sizeof(enum sss_id_type));
+    domains = wbcAllocateMemory(num_sids + 1, sizeof(struct wbcDomainInfo),
+                                wbcDomainInfosDestructor);
+    names = wbcAllocateMemory(num_sids + 1, sizeof(struct wbcTranslatedName),
+                              wbcTranslatedNamesDestructor);
+    if (str_sids == NULL || fq_names == NULL || sss_types == NULL
+            || domains == NULL || names == NULL) {
+        wbc_status = WBC_ERR_NO_MEMORY;
+        goto done;
+    }
+
+    for (c = 0; c < num_sids; c++) {
+        wbc_status = wbcSidToString(&sids[c], &str_sids[c]);
+        if (!WBC_ERROR_IS_OK(wbc_status)) {
+            goto done;
+        }
+    }
+
+    /* all SIDs are resolved with a single lock of the client connection */
+    ret = sss_nss_getnamesbysids((const char *const *) str_sids, num_sids,
+                                 fq_names, sss_types);
+    if (ret != 0 && ret != ENOENT) {
+        wbc_status = WBC_ERR_UNKNOWN_FAILURE;
+        goto done;
+    }
+
+    for (c = 0; c < num_sids; c++) {
+        names[c].domain_index = -1;
+
+        p = (fq_names[c] == NULL) ? NULL : strrchr(fq_names[c], '@');
+        if (p == NULL
+                || sss_id_type_to_wbcSidType(sss_types[c],
+                                             &names[c].type) != 0) {
+            names[c].type = WBC_SID_NAME_UNKNOWN;
+            names[c].name = strdup("");
+            if (names[c].name == NULL) {
+                wbc_status = WBC_ERR_NO_MEMORY;
+                goto done;
+            }
+            continue;
+        }
+
+        *p = '\0';
+        names[c].name = strdup(fq_names[c]);
+        if (names[c].name == NULL) {
+            wbc_status = WBC_ERR_NO_MEMORY;
+            goto done;
+        }
+
+        wbc_status = wbc_lookup_sids_domain(&sids[c], p + 1, domains,
+                                            &num_domains,
+                                            &names[c].domain_index);
+        if (!WBC_ERROR_IS_OK(wbc_status)) {
+            goto done;
+        }
+    }
+
+    *pdomains = domains;
+    *pnum_domains = num_domains;
+    *pnames = names;
+    domains = NULL;
+    names = NULL;
+
+    wbc_status = WBC_ERR_SUCCESS;
+
+done:
+    if (str_sids != NULL) {
+        for (c = 0; c < num_sids; c++) {
+            wbcFreeMemory(str_sids[c]);
+        }
+        free(str_sids);
+    }
+    if (fq_names != NULL) {
+        for (c = 0; c < num_sids; c++) {
+            free(fq_names[c]);
+        }
+        free(fq_names);
+    }
+    free(sss_types);
+    wbcFreeMemory(domains);
+    wbcFreeMemory(names);
+
+    return wbc_status;
 }
 
 /* Translate a collection of RIDs within a domain to names */
@@ -376,6 +376,10 @@ enum nss_status _nss_sss_getgrnam_r(const char *name, struct group *result,
     case ERANGE:
         *errnop = ERANGE;
         return NSS_STATUS_TRYAGAIN;
+    case ENODATA:
+        /* negative entry, sssd already told us there is no such entry */
+        *errnop = 0;
+        return NSS_STATUS_NOTFOUND;
     case ENOENT:
         /* fall through, we need to actively ask the parent
          * if no entry is found */
@@ -466,6 +470,10 @@ enum nss_status _nss_sss_getgrgid_r(gid_t gid, struct group *result,
     case ERANGE:
         *errnop = ERANGE;
         return NSS_STATUS_TRYAGAIN;
+    case ENODATA:
+        /* negative entry, sssd already told us there is no such entry */
+        *errnop = 0;
+        return NSS_STATUS_NOTFOUND;
     case ENOENT:
         /* fall through, we need to actively ask the parent
          * if no entry is found */
@@ -68,6 +68,10 @@ errno_t sss_nss_str_ptr_from_buffer(char **str, void **cookie,
                                     char *buf, size_t len);
 uint32_t sss_nss_mc_next_slot_with_hash(struct sss_mc_rec *rec,
                                         uint32_t hash);
+errno_t sss_nss_mc_negative_result(struct sss_mc_rec *rec);
+
+/* The lookup functions return 0 if the entry was found, ENODATA if sssd
+ * knows that it does not exist and ENOENT if the cache cannot tell. */
 
 /* passwd db */
 errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
@@ -85,4 +89,9 @@ errno_t sss_nss_mc_getgrgid(gid_t gid,
                             struct group *result,
                             char *buffer, size_t buflen);
 
+/* sid map, returned strings must be freed by the caller */
+errno_t sss_nss_mc_getidbysid(const char *sid, uint32_t *id, uint32_t *type);
+errno_t sss_nss_mc_getnamebysid(const char *sid, char **name, uint32_t *type);
+errno_t sss_nss_mc_getsidbyid(uint32_t id, char **sid, uint32_t *type);
+
 #endif /* _NSS_MC_H_ */
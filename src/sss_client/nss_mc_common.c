@@ -30,6 +30,7 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 #include "nss_mc.h"
 #include "sss_cli.h"
 #include "util/io.h"
@@ -351,6 +352,20 @@ errno_t sss_nss_str_ptr_from_buffer(char **str, void **cookie,
     return 0;
 }
 
+/* A valid negative record answers the lookup, an expired one does not
+ * tell anything */
+errno_t sss_nss_mc_negative_result(struct sss_mc_rec *rec)
+{
+    time_t expire;
+
+    expire = rec->expire;
+    if (expire < time(NULL)) {
+        return ENOENT;
+    }
+
+    return ENODATA;
+}
+
 uint32_t sss_nss_mc_next_slot_with_hash(struct sss_mc_rec *rec,
                                         uint32_t hash)
 {
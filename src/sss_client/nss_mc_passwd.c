@@ -134,7 +134,7 @@ errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
         }
 
         /* check record matches what we are searching for */
-        if (hash != rec->hash1) {
+        if (hash != rec->hash1 || (rec->flags & SSS_MC_REC_NEG_ID)) {
             /* if name hash does not match we can skip this immediately */
             slot = sss_nss_mc_next_slot_with_hash(rec, hash);
             continue;
@@ -167,6 +167,11 @@ errno_t sss_nss_mc_getpwnam(const char *name, size_t name_len,
         goto done;
     }
 
+    if (rec->flags & SSS_MC_REC_NEGATIVE) {
+        ret = sss_nss_mc_negative_result(rec);
+        goto done;
+    }
+
     ret = sss_nss_mc_parse_result(rec, result, buffer, buflen);
 
 done:
@@ -216,7 +221,7 @@ errno_t sss_nss_mc_getpwuid(uid_t uid,
         }
 
         /* check record matches what we are searching for */
-        if (hash != rec->hash2) {
+        if (hash != rec->hash2 || (rec->flags & SSS_MC_REC_NEG_NAME)) {
             /* if uid hash does not match we can skip this immediately */
             slot = sss_nss_mc_next_slot_with_hash(rec, hash);
             continue;
@@ -235,6 +240,11 @@ errno_t sss_nss_mc_getpwuid(uid_t uid,
         goto done;
     }
 
+    if (rec->flags & SSS_MC_REC_NEGATIVE) {
+        ret = sss_nss_mc_negative_result(rec);
+        goto done;
+    }
+
     ret = sss_nss_mc_parse_result(rec, result, buffer, buflen);
 
 done:
@@ -0,0 +1,265 @@
+/*
+ * System Security Services Daemon. NSS client interface
+ *
+ * Copyright (C) 2026 Red Hat
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* SID to ID and name mapping using mmap cache */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include "nss_mc.h"
+
+struct sss_cli_mc_ctx sid_mc_ctx = { UNINITIALIZED, -1, 0, NULL, 0, NULL, 0,
+                                     NULL, 0, 0 };
+
+/* Returns a copy of the valid record of the SID, the caller must free it */
+static errno_t sss_nss_mc_get_sid_record(const char *sid,
+                                         struct sss_mc_rec **_rec)
+{
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_sid_data *data;
+    char *rec_sid;
+    size_t sid_len;
+    size_t strs_offset;
+    uint8_t *max_addr;
+    uint32_t hash;
+    uint32_t slot;
+    time_t expire;
+    int ret;
+
+    sid_len = strlen(sid);
+
+    /* Get max address of data table. */
+    max_addr = sid_mc_ctx.data_table + sid_mc_ctx.dt_size;
+
+    /* hashes are calculated including the NULL terminator */
+    hash = sss_nss_mc_hash(&sid_mc_ctx, sid, sid_len + 1);
+    slot = sid_mc_ctx.hash_table[hash];
+
+    while (MC_SLOT_WITHIN_BOUNDS(slot, sid_mc_ctx.dt_size)) {
+        /* free record from previous iteration */
+        free(rec);
+        rec = NULL;
+
+        ret = sss_nss_mc_get_record(&sid_mc_ctx, slot, &rec);
+        if (ret) {
+            return ret;
+        }
+
+        if (hash != rec->hash1) {
+            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            continue;
+        }
+
+        strs_offset = offsetof(struct sss_mc_sid_data, strs);
+        data = (struct sss_mc_sid_data *)rec->data;
+        /* Integrity check
+         * - sid_len cannot be longer than all strings
+         * - data->sid cannot point outside strings
+         * - all strings must be within data_table */
+        if (sid_len > data->strs_len
+            || (data->sid + sid_len) > (strs_offset + data->strs_len)
+            || (uint8_t *)data->strs + data->strs_len > max_addr) {
+            free(rec);
+            return ENOENT;
+        }
+
+        rec_sid = (char *)data + data->sid;
+        if (strcmp(sid, rec_sid) == 0) {
+            break;
+        }
+
+        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+    }
+
+    if (!MC_SLOT_WITHIN_BOUNDS(slot, sid_mc_ctx.dt_size)) {
+        free(rec);
+        return ENOENT;
+    }
+
+    expire = rec->expire;
+    if (expire < time(NULL)) {
+        free(rec);
+        return ENOENT;
+    }
+
+    *_rec = rec;
+    return 0;
+}
+
+errno_t sss_nss_mc_getidbysid(const char *sid, uint32_t *id, uint32_t *type)
+{
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_sid_data *data;
+    int ret;
+
+    ret = sss_nss_mc_get_ctx("sid", &sid_mc_ctx);
+    if (ret) {
+        return ret;
+    }
+
+    ret = sss_nss_mc_get_sid_record(sid, &rec);
+    if (ret) {
+        goto done;
+    }
+
+    data = (struct sss_mc_sid_data *)rec->data;
+    *id = data->id;
+    *type = data->type;
+
+done:
+    free(rec);
+    __sync_sub_and_fetch(&sid_mc_ctx.active_threads, 1);
+    return ret;
+}
+
+errno_t sss_nss_mc_getnamebysid(const char *sid, char **name, uint32_t *type)
+{
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_sid_data *data;
+    size_t sid_len;
+    size_t name_len;
+    int ret;
+
+    ret = sss_nss_mc_get_ctx("sid", &sid_mc_ctx);
+    if (ret) {
+        return ret;
+    }
+
+    ret = sss_nss_mc_get_sid_record(sid, &rec);
+    if (ret) {
+        goto done;
+    }
+
+    data = (struct sss_mc_sid_data *)rec->data;
+    sid_len = strlen(sid) + 1;
+    if (data->strs_len <= sid_len + 1
+            || data->strs[data->strs_len - 1] != '\0') {
+        /* the name was never looked up */
+        ret = ENOENT;
+        goto done;
+    }
+
+    name_len = data->strs_len - sid_len;
+    *name = malloc(name_len);
+    if (*name == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    memcpy(*name, &data->strs[sid_len], name_len);
+    *type = data->type;
+
+done:
+    free(rec);
+    __sync_sub_and_fetch(&sid_mc_ctx.active_threads, 1);
+    return ret;
+}
+
+errno_t sss_nss_mc_getsidbyid(uint32_t id, char **sid, uint32_t *type)
+{
+    struct sss_mc_rec *rec = NULL;
+    struct sss_mc_sid_data *data;
+    char idstr[11];
+    size_t sid_len;
+    time_t expire;
+    uint32_t hash;
+    uint32_t slot;
+    int len;
+    int ret;
+
+    ret = sss_nss_mc_get_ctx("sid", &sid_mc_ctx);
+    if (ret) {
+        return ret;
+    }
+
+    len = snprintf(idstr, 11, "%lu", (unsigned long)id);
+    if (len > 10) {
+        ret = EINVAL;
+        goto done;
+    }
+
+    /* hashes are calculated including the NULL terminator */
+    hash = sss_nss_mc_hash(&sid_mc_ctx, idstr, len + 1);
+    slot = sid_mc_ctx.hash_table[hash];
+
+    while (MC_SLOT_WITHIN_BOUNDS(slot, sid_mc_ctx.dt_size)) {
+        /* free record from previous iteration */
+        free(rec);
+        rec = NULL;
+
+        ret = sss_nss_mc_get_record(&sid_mc_ctx, slot, &rec);
+        if (ret) {
+            goto done;
+        }
+
+        /* a uid and a gid with the same value may belong to different
+         * SIDs, only records stored by an id lookup can answer it */
+        if (hash != rec->hash2 || !(rec->flags & SSS_MC_REC_SID_BY_ID)) {
+            slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+            continue;
+        }
+
+        data = (struct sss_mc_sid_data *)rec->data;
+        if (id == data->id) {
+            break;
+        }
+
+        slot = sss_nss_mc_next_slot_with_hash(rec, hash);
+    }
+
+    if (!MC_SLOT_WITHIN_BOUNDS(slot, sid_mc_ctx.dt_size)) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    expire = rec->expire;
+    if (expire < time(NULL)) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    data = (struct sss_mc_sid_data *)rec->data;
+    if (sizeof(struct sss_mc_rec) + offsetof(struct sss_mc_sid_data, strs)
+            + data->strs_len > rec->len) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    sid_len = strnlen(data->strs, data->strs_len);
+    if (sid_len == 0 || sid_len == data->strs_len) {
+        ret = ENOENT;
+        goto done;
+    }
+
+    *sid = strndup(data->strs, sid_len);
+    if (*sid == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+    *type = data->type;
+
+    ret = 0;
+
+done:
+    free(rec);
+    __sync_sub_and_fetch(&sid_mc_ctx.active_threads, 1);
+    return ret;
+}
@@ -163,6 +163,10 @@ enum nss_status _nss_sss_getpwnam_r(const char *name, struct passwd *result,
     case ERANGE:
         *errnop = ERANGE;
         return NSS_STATUS_TRYAGAIN;
+    case ENODATA:
+        /* negative entry, sssd already told us there is no such entry */
+        *errnop = 0;
+        return NSS_STATUS_NOTFOUND;
     case ENOENT:
         /* fall through, we need to actively ask the parent
          * if no entry is found */
@@ -245,6 +249,10 @@ enum nss_status _nss_sss_getpwuid_r(uid_t uid, struct passwd *result,
     case ERANGE:
         *errnop = ERANGE;
         return NSS_STATUS_TRYAGAIN;
+    case ENODATA:
+        /* negative entry, sssd already told us there is no such entry */
+        *errnop = 0;
+        return NSS_STATUS_NOTFOUND;
     case ENOENT:
         /* fall through, we need to actively ask the parent
          * if no entry is found */
@@ -0,0 +1,590 @@
+/*
+    SSSD
+
+    AD subdomains tests
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "providers/ad/ad_opts.h"
+
+/* static functions are tested */
+#include "providers/ad/ad_subdomains.c"
+
+#define DOMNAME "child.example.com"
+#define BASEDN "dc=example,dc=com"
+
+struct be_req {
+    int unused;
+};
+
+struct sdap_id_op {
+    struct sdap_id_conn_cache *conn_cache;
+};
+
+struct subdom_test_ctx {
+    struct tevent_context *ev;
+    struct be_ctx *be_ctx;
+    struct ad_subdomains_ctx *sd_ctx;
+    struct ad_subdomains_req_ctx *req_ctx;
+
+    /* the domain SSSD is joined to and the real forest root */
+    struct ad_id_ctx *child_ctx;
+    struct ad_id_ctx *root_ctx;
+
+    /* the connection to the server that is being established */
+    struct tevent_req *connect_req;
+    struct sdap_id_conn_cache *connect_cache;
+    int num_connects;
+    int num_cancelled;
+
+    struct sdap_options *searched_opts;
+    int num_searches;
+
+    bool done;
+    int dp_err;
+    int dp_ret;
+};
+
+static struct subdom_test_ctx *test_ctx;
+
+/* Only the search for the trusted domains is run, the rest of the back end
+ * is not used */
+struct ad_options *ad_create_default_options(TALLOC_CTX *mem_ctx,
+                                             const char *realm,
+                                             const char *hostname)
+{
+    return NULL;
+}
+
+errno_t
+ad_failover_init(TALLOC_CTX *mem_ctx, struct be_ctx *ctx,
+                 const char *primary_servers,
+                 const char *backup_servers,
+                 const char *krb5_realm,
+                 const char *ad_service,
+                 const char *ad_gc_service,
+                 const char *ad_domain,
+                 struct ad_service **_service)
+{
+    return ENOSYS;
+}
+
+struct ad_id_ctx *
+ad_id_ctx_init(struct ad_options *ad_opts, struct be_ctx *bectx)
+{
+    return NULL;
+}
+
+struct tevent_req *
+ad_master_domain_send(TALLOC_CTX *mem_ctx,
+                      struct tevent_context *ev,
+                      struct sdap_id_conn_ctx *conn,
+                      struct sdap_id_op *op,
+                      const char *dom_name)
+{
+    return NULL;
+}
+
+errno_t
+ad_master_domain_recv(struct tevent_req *req,
+                      TALLOC_CTX *mem_ctx,
+                      char **_flat,
+                      char **_id,
+                      char **_site,
+                      char **_forest)
+{
+    return ENOSYS;
+}
+
+struct ad_srv_plugin_ctx *
+ad_srv_plugin_ctx_init(TALLOC_CTX *mem_ctx,
+                       struct be_resolv_ctx *be_res,
+                       enum host_database *host_dbs,
+                       struct sdap_options *opts,
+                       const char *hostname,
+                       const char *ad_domain,
+                       const char *ad_site_override)
+{
+    return NULL;
+}
+
+struct tevent_req *ad_srv_plugin_send(TALLOC_CTX *mem_ctx,
+                                       struct tevent_context *ev,
+                                       const char *service,
+                                       const char *protocol,
+                                       const char *discovery_domain,
+                                       void *pvt)
+{
+    return NULL;
+}
+
+errno_t ad_srv_plugin_recv(TALLOC_CTX *mem_ctx,
+                            struct tevent_req *req,
+                            char **_dns_domain,
+                            uint32_t *_ttl,
+                            struct fo_server_info **_primary_servers,
+                            size_t *_num_primary_servers,
+                            struct fo_server_info **_backup_servers,
+                            size_t *_num_backup_servers)
+{
+    return ENOSYS;
+}
+
+int be_add_online_cb(TALLOC_CTX *mem_ctx,
+                     struct be_ctx *ctx,
+                     be_callback_t cb,
+                     void *pvt,
+                     struct be_cb **online_cb)
+{
+    return EOK;
+}
+
+int be_add_offline_cb(TALLOC_CTX *mem_ctx,
+                      struct be_ctx *ctx,
+                      be_callback_t cb,
+                      void *pvt,
+                      struct be_cb **online_cb)
+{
+    return EOK;
+}
+
+void be_fo_set_srv_lookup_plugin(struct be_ctx *ctx,
+                                 fo_srv_lookup_plugin_send_t send_fn,
+                                 fo_srv_lookup_plugin_recv_t recv_fn,
+                                 void *pvt,
+                                 const char *plugin_name)
+{
+    return;
+}
+
+void be_ptask_destroy(struct be_ptask **task)
+{
+    return;
+}
+
+struct be_req *be_req_create(TALLOC_CTX *mem_ctx,
+                             struct be_client *becli, struct be_ctx *be_ctx,
+                             be_async_callback_t fn, void *pvt_fn_data)
+{
+    return NULL;
+}
+
+struct be_ctx *be_req_get_be_ctx(struct be_req *be_req)
+{
+    return test_ctx->be_ctx;
+}
+
+void be_req_terminate(struct be_req *be_req,
+                      int dp_err_type, int errnum, const char *errstr)
+{
+    test_ctx->done = true;
+    test_ctx->dp_err = dp_err_type;
+    test_ctx->dp_ret = errnum;
+}
+
+void be_terminate_domain_requests(struct be_ctx *be_ctx,
+                                  const char *domain)
+{
+    return;
+}
+
+struct sdap_domain *sdap_domain_get(struct sdap_options *opts,
+                                    struct sss_domain_info *dom)
+{
+    return NULL;
+}
+
+void
+sdap_domain_remove(struct sdap_options *opts,
+                   struct sss_domain_info *dom)
+{
+    return;
+}
+
+errno_t
+sdap_domain_subdom_add(struct sdap_id_ctx *sdap_id_ctx,
+                       struct sdap_domain *sdom_list,
+                       struct sss_domain_info *parent)
+{
+    return ENOSYS;
+}
+
+void sdap_inherit_options(char **inherit_opt_list,
+                          struct sdap_options *parent_sdap_opts,
+                          struct sdap_options *child_sdap_opts)
+{
+    return;
+}
+
+bool sdap_idmap_domain_has_algorithmic_mapping(struct sdap_idmap_ctx *ctx,
+                                               const char *name,
+                                               const char *dom_sid)
+{
+    return true;
+}
+
+struct sdap_id_op *sdap_id_op_create(TALLOC_CTX *memctx,
+                                     struct sdap_id_conn_cache *cache)
+{
+    struct sdap_id_op *op;
+
+    op = talloc_zero(memctx, struct sdap_id_op);
+    assert_non_null(op);
+    op->conn_cache = cache;
+
+    return op;
+}
+
+struct connect_state {
+    bool finished;
+    int dp_error;
+};
+
+static int connect_state_destructor(struct connect_state *state)
+{
+    struct tevent_req *req = talloc_parent(state);
+
+    if (!state->finished) {
+        test_ctx->num_cancelled++;
+    }
+
+    if (test_ctx->connect_req == req) {
+        test_ctx->connect_req = NULL;
+    }
+
+    return 0;
+}
+
+/* The connection is established when the test decides so */
+struct tevent_req *sdap_id_op_connect_send(struct sdap_id_op *op,
+                                           TALLOC_CTX *memctx,
+                                           int *ret_out)
+{
+    struct connect_state *state;
+    struct tevent_req *req;
+
+    assert_null(test_ctx->connect_req);
+
+    req = tevent_req_create(memctx, &state, struct connect_state);
+    assert_non_null(req);
+    talloc_set_destructor(state, connect_state_destructor);
+
+    test_ctx->connect_req = req;
+    test_ctx->connect_cache = op->conn_cache;
+    test_ctx->num_connects++;
+
+    *ret_out = EOK;
+    return req;
+}
+
+int sdap_id_op_connect_recv(struct tevent_req *req, int *dp_error)
+{
+    struct connect_state *state = tevent_req_data(req, struct connect_state);
+
+    *dp_error = state->dp_error;
+    TEVENT_REQ_RETURN_ON_ERROR(req);
+
+    return EOK;
+}
+
+int sdap_id_op_done(struct sdap_id_op *op, int ret, int *dp_error)
+{
+    *dp_error = DP_ERR_OK;
+    return ret;
+}
+
+struct sdap_handle *sdap_id_op_handle(struct sdap_id_op *op)
+{
+    return NULL;
+}
+
+/* No trusted domains are found */
+struct tevent_req *sdap_get_generic_send(TALLOC_CTX *memctx,
+                                         struct tevent_context *ev,
+                                         struct sdap_options *opts,
+                                         struct sdap_handle *sh,
+                                         const char *search_base,
+                                         const char *filter,
+                                         int scope,
+                                         const char **attrs,
+                                         struct sdap_attr_map *map,
+                                         int map_num_attrs,
+                                         int timeout,
+                                         bool allow_paging)
+{
+    test_ctx->searched_opts = opts;
+    test_ctx->num_searches++;
+    return test_req_succeed_send(memctx, ev);
+}
+
+int sdap_get_generic_recv(struct tevent_req *req,
+                          TALLOC_CTX *mem_ctx, size_t *reply_count,
+                          struct sysdb_attrs ***reply_list)
+{
+    *reply_count = 0;
+    *reply_list = NULL;
+    return test_request_recv(req);
+}
+
+static struct ad_id_ctx *subdom_test_id_ctx(TALLOC_CTX *mem_ctx,
+                                            struct ad_options *ad_options)
+{
+    struct ad_id_ctx *id_ctx;
+    struct sdap_options *opts;
+
+    id_ctx = talloc_zero(mem_ctx, struct ad_id_ctx);
+    assert_non_null(id_ctx);
+    id_ctx->ad_options = ad_options;
+
+    id_ctx->ldap_ctx = talloc_zero(id_ctx, struct sdap_id_conn_ctx);
+    assert_non_null(id_ctx->ldap_ctx);
+    /* only used to tell the connections apart */
+    id_ctx->ldap_ctx->conn_cache =
+            (struct sdap_id_conn_cache *) talloc_new(id_ctx->ldap_ctx);
+    assert_non_null(id_ctx->ldap_ctx->conn_cache);
+
+    opts = talloc_zero(id_ctx, struct sdap_options);
+    assert_non_null(opts);
+    assert_int_equal(dp_copy_defaults(opts, ad_def_ldap_opts,
+                                      SDAP_OPTS_BASIC, &opts->basic), EOK);
+
+    opts->sdom = talloc_zero(opts, struct sdap_domain);
+    assert_non_null(opts->sdom);
+    opts->sdom->search_bases = talloc_zero_array(opts->sdom,
+                                                 struct sdap_search_base *, 2);
+    assert_non_null(opts->sdom->search_bases);
+    opts->sdom->search_bases[0] = talloc_zero(opts->sdom->search_bases,
+                                              struct sdap_search_base);
+    assert_non_null(opts->sdom->search_bases[0]);
+    opts->sdom->search_bases[0]->basedn = BASEDN;
+
+    id_ctx->sdap_id_ctx = talloc_zero(id_ctx, struct sdap_id_ctx);
+    assert_non_null(id_ctx->sdap_id_ctx);
+    id_ctx->sdap_id_ctx->opts = opts;
+
+    return id_ctx;
+}
+
+static int subdom_test_setup(void **state)
+{
+    struct ad_options *ad_options;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct subdom_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    test_ctx->be_ctx = talloc_zero(test_ctx, struct be_ctx);
+    assert_non_null(test_ctx->be_ctx);
+    test_ctx->be_ctx->ev = test_ctx->ev;
+    test_ctx->be_ctx->domain = talloc_zero(test_ctx->be_ctx,
+                                           struct sss_domain_info);
+    assert_non_null(test_ctx->be_ctx->domain);
+    test_ctx->be_ctx->domain->name = talloc_strdup(test_ctx->be_ctx->domain,
+                                                   DOMNAME);
+    assert_non_null(test_ctx->be_ctx->domain->name);
+
+    ad_options = talloc_zero(test_ctx, struct ad_options);
+    assert_non_null(ad_options);
+    assert_int_equal(dp_copy_defaults(ad_options, ad_basic_opts,
+                                      AD_OPTS_BASIC, &ad_options->basic), EOK);
+
+    test_ctx->child_ctx = subdom_test_id_ctx(test_ctx, ad_options);
+    test_ctx->root_ctx = subdom_test_id_ctx(test_ctx, ad_options);
+
+    test_ctx->sd_ctx = talloc_zero(test_ctx, struct ad_subdomains_ctx);
+    assert_non_null(test_ctx->sd_ctx);
+    test_ctx->sd_ctx->be_ctx = test_ctx->be_ctx;
+    test_ctx->sd_ctx->ad_id_ctx = test_ctx->child_ctx;
+    test_ctx->sd_ctx->sdap_id_ctx = test_ctx->child_ctx->sdap_id_ctx;
+    test_ctx->sd_ctx->ldap_ctx = test_ctx->child_ctx->ldap_ctx;
+
+    test_ctx->req_ctx = talloc_zero(test_ctx, struct ad_subdomains_req_ctx);
+    assert_non_null(test_ctx->req_ctx);
+    test_ctx->req_ctx->sd_ctx = test_ctx->sd_ctx;
+    test_ctx->req_ctx->be_req = talloc_zero(test_ctx->req_ctx, struct be_req);
+    assert_non_null(test_ctx->req_ctx->be_req);
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int subdom_test_teardown(void **state)
+{
+    assert_true(check_leaks_pop(test_ctx));
+    talloc_zfree(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void subdom_test_connected(errno_t ret)
+{
+    struct tevent_req *req = test_ctx->connect_req;
+    struct connect_state *state;
+
+    assert_non_null(req);
+    test_ctx->connect_req = NULL;
+
+    state = tevent_req_data(req, struct connect_state);
+    state->finished = true;
+
+    if (ret == EOK) {
+        tevent_req_done(req);
+    } else {
+        tevent_req_error(req, ret);
+    }
+}
+
+static void subdom_test_wait(void)
+{
+    while (!test_ctx->done) {
+        tevent_loop_once(test_ctx->ev);
+    }
+}
+
+/* The cached forest root is still right, the trusted domains are read only
+ * once, while the master domain is being looked up */
+void test_subdom_cached_root(void **state)
+{
+    test_ctx->be_ctx->domain->forest = discard_const(DOMNAME);
+
+    ad_subdomains_get_slaves_early(test_ctx->req_ctx);
+    assert_int_equal(test_ctx->num_connects, 1);
+    assert_ptr_equal(test_ctx->connect_cache,
+                     test_ctx->child_ctx->ldap_ctx->conn_cache);
+
+    ad_subdomains_local_done(test_ctx->req_ctx, test_ctx->child_ctx);
+    assert_int_equal(test_ctx->num_connects, 1);
+    assert_int_equal(test_ctx->num_cancelled, 0);
+    assert_false(test_ctx->done);
+
+    subdom_test_connected(EOK);
+    subdom_test_wait();
+
+    assert_int_equal(test_ctx->dp_err, DP_ERR_OK);
+    assert_int_equal(test_ctx->dp_ret, EOK);
+    assert_int_equal(test_ctx->num_searches, 1);
+    assert_ptr_equal(test_ctx->searched_opts,
+                     test_ctx->child_ctx->sdap_id_ctx->opts);
+}
+
+/* The master domain lookup found another forest root than the one cached
+ * from the previous refresh, the search is restarted in the right one */
+void test_subdom_wrong_cached_root(void **state)
+{
+    test_ctx->be_ctx->domain->forest = discard_const(DOMNAME);
+
+    ad_subdomains_get_slaves_early(test_ctx->req_ctx);
+    assert_int_equal(test_ctx->num_connects, 1);
+    assert_ptr_equal(test_ctx->connect_cache,
+                     test_ctx->child_ctx->ldap_ctx->conn_cache);
+
+    ad_subdomains_local_done(test_ctx->req_ctx, test_ctx->root_ctx);
+    assert_int_equal(test_ctx->num_cancelled, 1);
+    assert_int_equal(test_ctx->num_connects, 2);
+    assert_ptr_equal(test_ctx->connect_cache,
+                     test_ctx->root_ctx->ldap_ctx->conn_cache);
+    assert_false(test_ctx->done);
+
+    subdom_test_connected(EOK);
+    subdom_test_wait();
+
+    assert_int_equal(test_ctx->dp_err, DP_ERR_OK);
+    assert_int_equal(test_ctx->dp_ret, EOK);
+    assert_int_equal(test_ctx->num_searches, 1);
+    assert_ptr_equal(test_ctx->searched_opts,
+                     test_ctx->root_ctx->sdap_id_ctx->opts);
+}
+
+/* The cached forest root cannot be reached, the search is started again
+ * once the master domain lookup finished instead of failing the request */
+void test_subdom_cached_root_unreachable(void **state)
+{
+    test_ctx->be_ctx->domain->forest = discard_const(DOMNAME);
+
+    ad_subdomains_get_slaves_early(test_ctx->req_ctx);
+    assert_int_equal(test_ctx->num_connects, 1);
+
+    subdom_test_connected(ETIMEDOUT);
+    assert_false(test_ctx->done);
+    assert_null(test_ctx->req_ctx->root_id_ctx);
+
+    ad_subdomains_local_done(test_ctx->req_ctx, test_ctx->child_ctx);
+    assert_int_equal(test_ctx->num_connects, 2);
+    assert_ptr_equal(test_ctx->connect_cache,
+                     test_ctx->child_ctx->ldap_ctx->conn_cache);
+
+    subdom_test_connected(EOK);
+    subdom_test_wait();
+
+    assert_int_equal(test_ctx->dp_err, DP_ERR_OK);
+    assert_int_equal(test_ctx->dp_ret, EOK);
+    assert_int_equal(test_ctx->num_searches, 1);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_subdom_cached_root,
+                                        subdom_test_setup,
+                                        subdom_test_teardown),
+        cmocka_unit_test_setup_teardown(test_subdom_wrong_cached_root,
+                                        subdom_test_setup,
+                                        subdom_test_teardown),
+        cmocka_unit_test_setup_teardown(test_subdom_cached_root_unreachable,
+                                        subdom_test_setup,
+                                        subdom_test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can deside if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -38,6 +38,20 @@
 #define SUBDOMNAME    "subdomname"
 #define SUBFLATNAME   "subflatname"
 
+#define DEFAULT_RE    "(?P<name>[^@]+)@?(?P<domain>[^@]*$)"
+#define IPA_AD_RE     "(((?P<domain>[^\\\\]+)\\\\(?P<name>.+$))|" \
+                      "((?P<name>[^@]+)@(?P<domain>.+$))|" \
+                      "(^(?P<name>[^@\\\\]+)$))"
+
+/* The same expressions with a space, which is ignored by PCRE_EXTENDED but
+ * makes sss_parse_name() use pcre instead of the built-in splitter */
+#define DEFAULT_RE_PCRE "(?P<name>[^@]+) @?(?P<domain>[^@]*$)"
+#define IPA_AD_RE_PCRE  "(((?P<domain>[^\\\\]+)\\\\(?P<name>.+$))|" \
+                        "((?P<name>[^@]+)@(?P<domain>.+$))|" \
+                        "(^(?P<name>[^@\\\\]+) $))"
+
+#define BENCH_NAMES 100000
+
 static struct sss_domain_info *create_test_domain(TALLOC_CTX *mem_ctx,
                                                   const char *name,
                                                   const char *flatname,
@@ -507,13 +521,218 @@ void test_sss_get_domain_name(void **state)
     }
 }
 
+static void check_same_parse(struct sss_names_ctx *fast,
+                             struct sss_names_ctx *slow,
+                             const char *input)
+{
+    TALLOC_CTX *tmp_ctx;
+    char *fast_name = NULL;
+    char *fast_domain = NULL;
+    char *slow_name = NULL;
+    char *slow_domain = NULL;
+    errno_t fast_ret;
+    errno_t slow_ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    fast_ret = sss_parse_name(tmp_ctx, fast, input, &fast_domain, &fast_name);
+    slow_ret = sss_parse_name(tmp_ctx, slow, input, &slow_domain, &slow_name);
+    assert_int_equal(fast_ret, slow_ret);
+
+    if (fast_ret == EOK) {
+        assert_string_equal(fast_name, slow_name);
+        if (slow_domain == NULL) {
+            assert_null(fast_domain);
+        } else {
+            assert_non_null(fast_domain);
+            assert_string_equal(fast_domain, slow_domain);
+        }
+    }
+
+    talloc_free(tmp_ctx);
+}
+
+void test_parse_name_builtin(void **state)
+{
+    struct fqdn_test_ctx *test_ctx = talloc_get_type(*state,
+                                                     struct fqdn_test_ctx);
+    struct sss_names_ctx *fast;
+    struct sss_names_ctx *slow;
+    const char *inputs[] = { "", "@", "\\", "@@", "\\\\", "name", "name@",
+                             "@name", "name@dom", "name@dom@dom2", "@name@dom",
+                             "name@@dom", "dom\\name", "\\name", "name\\",
+                             "dom\\name@dom2", "name@dom\\x", "dom\\\\name",
+                             "dom\\name\\x", "a@b", "a\\b", "name with space",
+                             "n\xc3\xa1me@d\xc3\xb3m", "name@dom\n",
+                             "dom\\na\nme", NULL };
+    errno_t ret;
+    int i;
+
+    ret = sss_names_init_from_args(test_ctx, DEFAULT_RE, "%1$s@%2$s", &fast);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(fast->builtin_re, SSS_NAMES_RE_DEFAULT);
+    ret = sss_names_init_from_args(test_ctx, DEFAULT_RE_PCRE, "%1$s@%2$s",
+                                   &slow);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(slow->builtin_re, SSS_NAMES_RE_CUSTOM);
+
+    for (i = 0; inputs[i] != NULL; i++) {
+        check_same_parse(fast, slow, inputs[i]);
+    }
+    talloc_free(fast);
+    talloc_free(slow);
+
+    ret = sss_names_init_from_args(test_ctx, IPA_AD_RE, "%1$s@%2$s", &fast);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(fast->builtin_re, SSS_NAMES_RE_IPA_AD);
+    ret = sss_names_init_from_args(test_ctx, IPA_AD_RE_PCRE, "%1$s@%2$s",
+                                   &slow);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(slow->builtin_re, SSS_NAMES_RE_CUSTOM);
+
+    for (i = 0; inputs[i] != NULL; i++) {
+        check_same_parse(fast, slow, inputs[i]);
+    }
+    talloc_free(fast);
+    talloc_free(slow);
+}
+
+void test_fqname_plan(void **state)
+{
+    struct fqdn_test_ctx *test_ctx = talloc_get_type(*state,
+                                                     struct fqdn_test_ctx);
+    char fqdn_s[8];
+    char *fqdn;
+    int ret;
+
+    ret = sss_names_init_from_args(test_ctx, DEFAULT_RE,
+                                   "%%%3$s%%%1$s%%", &test_ctx->nctx);
+    assert_int_equal(ret, EOK);
+    assert_non_null(test_ctx->nctx->fq_plan);
+
+    fqdn = sss_tc_fqname(test_ctx, test_ctx->nctx, test_ctx->dom, NAME);
+    assert_non_null(fqdn);
+    assert_string_equal(fqdn, "%"FLATNAME"%"NAME"%");
+    talloc_free(fqdn);
+
+    /* snprintf() semantics */
+    ret = sss_fqname(NULL, 0, test_ctx->nctx, test_ctx->dom, NAME);
+    assert_int_equal(ret + 1, sizeof("%"FLATNAME"%"NAME"%"));
+
+    ret = sss_fqname(fqdn_s, sizeof(fqdn_s), test_ctx->nctx,
+                     test_ctx->dom, NAME);
+    assert_int_equal(ret + 1, sizeof("%"FLATNAME"%"NAME"%"));
+    assert_string_equal(fqdn_s, "%flatna");
+    talloc_free(test_ctx->nctx);
+
+    /* widths and flags are left to the full formatter */
+    ret = sss_names_init_from_args(test_ctx, DEFAULT_RE,
+                                   "%1$.2s@%2$s", &test_ctx->nctx);
+    assert_int_equal(ret, EOK);
+    assert_null(test_ctx->nctx->fq_plan);
+
+    fqdn = sss_tc_fqname(test_ctx, test_ctx->nctx, test_ctx->dom, NAME);
+    assert_non_null(fqdn);
+    assert_string_equal(fqdn, "na@"DOMNAME);
+    talloc_free(fqdn);
+    talloc_free(test_ctx->nctx);
+}
+
+static double run_parse(struct sss_names_ctx *nctx, const char *input)
+{
+    struct timeval start;
+    struct timeval end;
+    TALLOC_CTX *tmp_ctx;
+    char *domain;
+    char *name;
+    errno_t ret;
+    int i;
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < BENCH_NAMES; i++) {
+        tmp_ctx = talloc_new(NULL);
+        assert_non_null(tmp_ctx);
+
+        ret = sss_parse_name(tmp_ctx, nctx, input, &domain, &name);
+        assert_int_equal(ret, EOK);
+
+        talloc_free(tmp_ctx);
+    }
+    gettimeofday(&end, NULL);
+
+    return (end.tv_sec - start.tv_sec) * 1000.0
+                + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+static double run_format(struct sss_names_ctx *nctx,
+                         struct sss_domain_info *dom)
+{
+    struct timeval start;
+    struct timeval end;
+    char fqdn_s[256];
+    char *fqdn;
+    int ret;
+    int i;
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < BENCH_NAMES; i++) {
+        ret = sss_fqname(fqdn_s, sizeof(fqdn_s), nctx, dom, NAME);
+        assert_true(ret > 0);
+
+        fqdn = sss_tc_fqname(NULL, nctx, dom, NAME);
+        assert_non_null(fqdn);
+        talloc_free(fqdn);
+    }
+    gettimeofday(&end, NULL);
+
+    return (end.tv_sec - start.tv_sec) * 1000.0
+                + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+void test_names_benchmark(void **state)
+{
+    struct fqdn_test_ctx *test_ctx = talloc_get_type(*state,
+                                                     struct fqdn_test_ctx);
+    struct sss_names_ctx *fast;
+    struct sss_names_ctx *slow;
+    double msec;
+    errno_t ret;
+
+    ret = sss_names_init_from_args(test_ctx, DEFAULT_RE, "%1$s@%2$s", &fast);
+    assert_int_equal(ret, EOK);
+    ret = sss_names_init_from_args(test_ctx, DEFAULT_RE_PCRE,
+                                   "%1$.255s@%2$s", &slow);
+    assert_int_equal(ret, EOK);
+
+    msec = run_parse(slow, NAME"@"DOMNAME);
+    printf("%d names parsed with pcre: %.2f ms\n", BENCH_NAMES, msec);
+    msec = run_parse(fast, NAME"@"DOMNAME);
+    printf("%d names parsed with the built-in splitter: %.2f ms\n",
+           BENCH_NAMES, msec);
+
+    msec = run_format(slow, test_ctx->dom);
+    printf("%d names formatted with safe_format_string: %.2f ms\n",
+           BENCH_NAMES, msec);
+    msec = run_format(fast, test_ctx->dom);
+    printf("%d names formatted with the precompiled format: %.2f ms\n",
+           BENCH_NAMES, msec);
+
+    talloc_free(fast);
+    talloc_free(slow);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
     int opt;
+    int rv;
+    int benchmark = 0;
     struct poptOption long_options[] = {
         POPT_AUTOHELP
         SSSD_DEBUG_OPTS
+        {"benchmark", 'b', POPT_ARG_NONE, &benchmark, 0,
+         _("Also time the parsing and formatting of names"), NULL },
         POPT_TABLEEND
     };
 
@@ -528,6 +747,10 @@ int main(int argc, const char *argv[])
                                         fqdn_test_setup, fqdn_test_teardown),
         cmocka_unit_test_setup_teardown(test_init_nouser,
                                         fqdn_test_setup, fqdn_test_teardown),
+        cmocka_unit_test_setup_teardown(test_parse_name_builtin,
+                                        fqdn_test_setup, fqdn_test_teardown),
+        cmocka_unit_test_setup_teardown(test_fqname_plan,
+                                        fqdn_test_setup, fqdn_test_teardown),
 
         cmocka_unit_test_setup_teardown(parse_name_plain,
                                         parse_name_test_setup,
@@ -553,6 +776,12 @@ int main(int argc, const char *argv[])
                                         parse_name_test_teardown),
     };
 
+    /* too slow and too noisy for every make check */
+    const struct CMUnitTest bench_tests[] = {
+        cmocka_unit_test_setup_teardown(test_names_benchmark,
+                                        fqdn_test_setup, fqdn_test_teardown),
+    };
+
     /* Set debug level to invalid value so we can deside if -d 0 was used. */
     debug_level = SSSDBG_INVALID;
 
@@ -574,5 +803,10 @@ int main(int argc, const char *argv[])
      * they might not after a failed run. Remove the old db to be sure */
     tests_set_cwd();
 
-    return cmocka_run_group_tests(tests, NULL, NULL);
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && benchmark) {
+        rv = cmocka_run_group_tests(bench_tests, NULL, NULL);
+    }
+
+    return rv;
 }
@@ -0,0 +1,466 @@
+/*
+    SSSD
+
+    LDAP authentication connection pool tests
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "providers/ldap/ldap_opts.h"
+
+/* static functions are tested */
+#include "providers/ldap/ldap_auth.c"
+
+#define TEST_URI "ldap://ldap.example.com"
+#define TEST_USER "user"
+#define TEST_USER_DN "uid=user,dc=example,dc=com"
+
+struct be_req {
+    struct be_ctx *be_ctx;
+    void *req_data;
+};
+
+struct ldap_auth_test_ctx {
+    struct tevent_context *ev;
+    struct be_ctx *be_ctx;
+    struct sdap_auth_ctx *auth_ctx;
+
+    int num_connects;
+    int num_port_working;
+    int num_passwd_changes;
+
+    bool done;
+    int dp_err;
+    int pam_status;
+};
+
+static struct ldap_auth_test_ctx *test_ctx;
+static int test_srv;
+
+/* The back end and the LDAP operations are mocked, they all succeed */
+struct be_ctx *be_req_get_be_ctx(struct be_req *be_req)
+{
+    return be_req->be_ctx;
+}
+
+void *be_req_get_data(struct be_req *be_req)
+{
+    return be_req->req_data;
+}
+
+void be_req_terminate(struct be_req *be_req,
+                      int dp_err_type, int errnum, const char *errstr)
+{
+    test_ctx->done = true;
+    test_ctx->dp_err = dp_err_type;
+    test_ctx->pam_status = errnum;
+}
+
+bool be_is_offline(struct be_ctx *ctx)
+{
+    return false;
+}
+
+void be_mark_offline(struct be_ctx *ctx)
+{
+    return;
+}
+
+struct tevent_req *be_resolve_server_send(TALLOC_CTX *memctx,
+                                          struct tevent_context *ev,
+                                          struct be_ctx *ctx,
+                                          const char *service_name,
+                                          bool first_try)
+{
+    return test_req_succeed_send(memctx, ev);
+}
+
+int be_resolve_server_recv(struct tevent_req *req, struct fo_server **srv)
+{
+    *srv = (struct fo_server *) &test_srv;
+    return test_request_recv(req);
+}
+
+void be_fo_set_port_status(struct be_ctx *ctx,
+                           const char *service_name,
+                           struct fo_server *server,
+                           enum port_status status)
+{
+    assert_ptr_equal(server, &test_srv);
+    if (status == PORT_WORKING) {
+        test_ctx->num_port_working++;
+    }
+}
+
+bool sdap_is_secure_uri(const char *uri)
+{
+    return false;
+}
+
+errno_t string_to_shadowpw_days(const char *s, long *d)
+{
+    return EINVAL;
+}
+
+struct tevent_req *sdap_connect_send(TALLOC_CTX *memctx,
+                                     struct tevent_context *ev,
+                                     struct sdap_options *opts,
+                                     const char *uri,
+                                     struct sockaddr_storage *sockaddr,
+                                     bool use_start_tls)
+{
+    assert_string_equal(uri, TEST_URI);
+    test_ctx->num_connects++;
+    return test_req_succeed_send(memctx, ev);
+}
+
+int sdap_connect_recv(struct tevent_req *req,
+                      TALLOC_CTX *memctx,
+                      struct sdap_handle **sh)
+{
+    *sh = talloc_zero(memctx, struct sdap_handle);
+    assert_non_null(*sh);
+    (*sh)->connected = true;
+
+    return test_request_recv(req);
+}
+
+errno_t sdap_set_connected(struct sdap_handle *sh, struct tevent_context *ev)
+{
+    sh->connected = true;
+    return EOK;
+}
+
+struct tevent_req *sdap_auth_send(TALLOC_CTX *memctx,
+                                  struct tevent_context *ev,
+                                  struct sdap_handle *sh,
+                                  const char *sasl_mech,
+                                  const char *sasl_user,
+                                  const char *user_dn,
+                                  struct sss_auth_token *authtok)
+{
+    assert_non_null(sh);
+    assert_string_equal(user_dn, TEST_USER_DN);
+    return test_req_succeed_send(memctx, ev);
+}
+
+errno_t sdap_auth_recv(struct tevent_req *req,
+                       TALLOC_CTX *memctx,
+                       struct sdap_ppolicy_data **ppolicy)
+{
+    *ppolicy = NULL;
+    return test_request_recv(req);
+}
+
+struct tevent_req *sdap_anon_bind_send(TALLOC_CTX *memctx,
+                                       struct tevent_context *ev,
+                                       struct sdap_handle *sh)
+{
+    return test_req_succeed_send(memctx, ev);
+}
+
+errno_t sdap_anon_bind_recv(struct tevent_req *req)
+{
+    return test_request_recv(req);
+}
+
+struct tevent_req *sdap_exop_modify_passwd_send(TALLOC_CTX *memctx,
+                                                struct tevent_context *ev,
+                                                struct sdap_handle *sh,
+                                                char *user_dn,
+                                                const char *password,
+                                                const char *new_password)
+{
+    /* the handle the user was bound on */
+    assert_non_null(sh);
+    assert_true(sh->connected);
+    assert_string_equal(user_dn, TEST_USER_DN);
+    test_ctx->num_passwd_changes++;
+    return test_req_succeed_send(memctx, ev);
+}
+
+errno_t sdap_exop_modify_passwd_recv(struct tevent_req *req,
+                                     TALLOC_CTX *mem_ctx,
+                                     char **user_error_msg)
+{
+    *user_error_msg = NULL;
+    return test_request_recv(req);
+}
+
+struct tevent_req *
+sdap_modify_shadow_lastchange_send(TALLOC_CTX *mem_ctx,
+                                   struct tevent_context *ev,
+                                   struct sdap_handle *sh,
+                                   const char *dn,
+                                   char *lastchanged_name)
+{
+    return test_req_succeed_send(mem_ctx, ev);
+}
+
+errno_t sdap_modify_shadow_lastchange_recv(struct tevent_req *req)
+{
+    return test_request_recv(req);
+}
+
+struct tevent_req *sdap_search_user_send(TALLOC_CTX *memctx,
+                                         struct tevent_context *ev,
+                                         struct sss_domain_info *dom,
+                                         struct sdap_options *opts,
+                                         struct sdap_search_base **search_bases,
+                                         struct sdap_handle *sh,
+                                         const char **attrs,
+                                         const char *filter,
+                                         int timeout,
+                                         bool enumeration)
+{
+    /* the DN of the user is always cached */
+    fail();
+    return NULL;
+}
+
+int sdap_search_user_recv(TALLOC_CTX *memctx, struct tevent_req *req,
+                          char **higher_usn, struct sysdb_attrs ***users,
+                          size_t *count)
+{
+    return EINVAL;
+}
+
+int __wrap_sysdb_get_user_attr(TALLOC_CTX *mem_ctx,
+                               struct sss_domain_info *domain,
+                               const char *name,
+                               const char **attributes,
+                               struct ldb_result **_res)
+{
+    struct ldb_result *res;
+    int ret;
+
+    res = talloc_zero(mem_ctx, struct ldb_result);
+    assert_non_null(res);
+
+    res->msgs = talloc_array(res, struct ldb_message *, 1);
+    assert_non_null(res->msgs);
+    res->msgs[0] = ldb_msg_new(res->msgs);
+    assert_non_null(res->msgs[0]);
+    res->count = 1;
+
+    ret = ldb_msg_add_string(res->msgs[0], SYSDB_ORIG_DN, TEST_USER_DN);
+    assert_int_equal(ret, LDB_SUCCESS);
+
+    *_res = res;
+    return EOK;
+}
+
+static int ldap_auth_test_setup(void **state)
+{
+    struct sdap_options *opts;
+    struct sdap_service *service;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct ldap_auth_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    test_ctx->be_ctx = talloc_zero(test_ctx, struct be_ctx);
+    assert_non_null(test_ctx->be_ctx);
+    test_ctx->be_ctx->ev = test_ctx->ev;
+    test_ctx->be_ctx->domain = talloc_zero(test_ctx->be_ctx,
+                                           struct sss_domain_info);
+    assert_non_null(test_ctx->be_ctx->domain);
+
+    opts = talloc_zero(test_ctx, struct sdap_options);
+    assert_non_null(opts);
+    ret = dp_copy_defaults(opts, default_basic_opts,
+                           SDAP_OPTS_BASIC, &opts->basic);
+    assert_int_equal(ret, EOK);
+    ret = dp_opt_set_int(opts->basic, SDAP_AUTH_POOL_SIZE, 1);
+    assert_int_equal(ret, EOK);
+
+    service = talloc_zero(test_ctx, struct sdap_service);
+    assert_non_null(service);
+    service->name = talloc_strdup(service, "LDAP");
+    service->uri = talloc_strdup(service, TEST_URI);
+    assert_non_null(service->name);
+    assert_non_null(service->uri);
+
+    test_ctx->auth_ctx = talloc_zero(test_ctx, struct sdap_auth_ctx);
+    assert_non_null(test_ctx->auth_ctx);
+    test_ctx->auth_ctx->be = test_ctx->be_ctx;
+    test_ctx->auth_ctx->opts = opts;
+    test_ctx->auth_ctx->service = service;
+
+    ret = sdap_auth_pool_init(test_ctx->auth_ctx);
+    assert_int_equal(ret, EOK);
+    assert_non_null(test_ctx->auth_ctx->pool);
+
+    test_ctx->be_ctx->bet_info[BET_AUTH].pvt_bet_data = test_ctx->auth_ctx;
+    test_ctx->be_ctx->bet_info[BET_CHPASS].pvt_bet_data = test_ctx->auth_ctx;
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int ldap_auth_test_teardown(void **state)
+{
+    sdap_auth_pool_flush(test_ctx->auth_ctx->pool);
+    assert_true(check_leaks_pop(test_ctx));
+    talloc_zfree(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static struct be_req *ldap_auth_test_req(TALLOC_CTX *mem_ctx, int cmd)
+{
+    struct be_req *breq;
+    struct pam_data *pd;
+    errno_t ret;
+
+    breq = talloc_zero(mem_ctx, struct be_req);
+    assert_non_null(breq);
+    breq->be_ctx = test_ctx->be_ctx;
+
+    pd = create_pam_data(breq);
+    assert_non_null(pd);
+    pd->cmd = cmd;
+    pd->user = talloc_strdup(pd, TEST_USER);
+    assert_non_null(pd->user);
+
+    ret = sss_authtok_set_password(pd->authtok, "password", 0);
+    assert_int_equal(ret, EOK);
+    ret = sss_authtok_set_password(pd->newauthtok, "new_password", 0);
+    assert_int_equal(ret, EOK);
+
+    breq->req_data = pd;
+    return breq;
+}
+
+static void ldap_auth_test_run(void (*handler)(struct be_req *),
+                               struct be_req *breq)
+{
+    struct sdap_auth_pool *pool = test_ctx->auth_ctx->pool;
+
+    test_ctx->done = false;
+    handler(breq);
+
+    /* also wait for the connections returned to the pool */
+    while (!test_ctx->done || pool->num_pending > 0) {
+        tevent_loop_once(test_ctx->ev);
+    }
+}
+
+void test_ldap_auth_pool(void **state)
+{
+    struct sdap_auth_pool *pool = test_ctx->auth_ctx->pool;
+    struct be_req *breq;
+
+    breq = ldap_auth_test_req(test_ctx, SSS_PAM_AUTHENTICATE);
+
+    /* a new connection for the user, the pool is filled in the background */
+    ldap_auth_test_run(sdap_pam_auth_handler, breq);
+    assert_int_equal(test_ctx->dp_err, DP_ERR_OK);
+    assert_int_equal(test_ctx->pam_status, PAM_SUCCESS);
+    assert_int_equal(test_ctx->num_connects, 2);
+    assert_int_equal(test_ctx->num_port_working, 1);
+    assert_int_equal(pool->num_idle, 1);
+    assert_int_equal(pool->num_busy, 0);
+
+    /* the pooled connection is used and the server marked as working */
+    ldap_auth_test_run(sdap_pam_auth_handler, breq);
+    assert_int_equal(test_ctx->dp_err, DP_ERR_OK);
+    assert_int_equal(test_ctx->pam_status, PAM_SUCCESS);
+    assert_int_equal(test_ctx->num_connects, 2);
+    assert_int_equal(test_ctx->num_port_working, 2);
+    assert_int_equal(pool->num_idle, 1);
+    assert_int_equal(pool->num_busy, 0);
+
+    talloc_free(breq);
+}
+
+void test_ldap_auth_pool_chpass(void **state)
+{
+    struct sdap_auth_pool *pool = test_ctx->auth_ctx->pool;
+    struct be_req *breq;
+
+    /* fill the pool */
+    breq = ldap_auth_test_req(test_ctx, SSS_PAM_AUTHENTICATE);
+    ldap_auth_test_run(sdap_pam_auth_handler, breq);
+    assert_int_equal(test_ctx->pam_status, PAM_SUCCESS);
+    assert_int_equal(pool->num_idle, 1);
+    talloc_free(breq);
+
+    /* without ldap_chpass_uri the password is changed on a connection to
+     * the authentication server, it must not be taken from the pool or
+     * returned to it */
+    breq = ldap_auth_test_req(test_ctx, SSS_PAM_CHAUTHTOK);
+    ldap_auth_test_run(sdap_pam_chpass_handler, breq);
+    assert_int_equal(test_ctx->dp_err, DP_ERR_OK);
+    assert_int_equal(test_ctx->pam_status, PAM_SUCCESS);
+    assert_int_equal(test_ctx->num_passwd_changes, 1);
+    assert_int_equal(test_ctx->num_connects, 3);
+    assert_int_equal(pool->num_idle, 1);
+    assert_int_equal(pool->num_busy, 0);
+    talloc_free(breq);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_ldap_auth_pool,
+                                        ldap_auth_test_setup,
+                                        ldap_auth_test_teardown),
+        cmocka_unit_test_setup_teardown(test_ldap_auth_pool_chpass,
+                                        ldap_auth_test_setup,
+                                        ldap_auth_test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can deside if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
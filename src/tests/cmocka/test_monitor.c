@@ -0,0 +1,184 @@
+/*
+    SSSD
+
+    Unit tests for the monitor service configuration
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+
+/* Include the monitor itself to reach the static service helpers */
+#include "monitor/monitor.c"
+
+#define TESTS_PATH "tests_monitor"
+#define TEST_CONF_DB "test_monitor_conf.ldb"
+#define TEST_SYSDB_FILE "cache_monitor_test.ldb"
+
+struct monitor_test_ctx {
+    struct mt_ctx *mt_ctx;
+    int pipefd[2];
+};
+
+static int monitor_test_setup(void **state)
+{
+    struct monitor_test_ctx *test_ctx;
+    char *conf_db;
+    const char *val[2] = { NULL, NULL };
+    int ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct monitor_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->mt_ctx = talloc_zero(test_ctx, struct mt_ctx);
+    assert_non_null(test_ctx->mt_ctx);
+    test_ctx->mt_ctx->is_daemon = true;
+
+    conf_db = talloc_asprintf(test_ctx, "%s/%s", TESTS_PATH, TEST_CONF_DB);
+    assert_non_null(conf_db);
+
+    ret = confdb_init(test_ctx, &test_ctx->mt_ctx->cdb, conf_db);
+    assert_int_equal(ret, EOK);
+    talloc_free(conf_db);
+
+    val[0] = "2";
+    ret = confdb_add_param(test_ctx->mt_ctx->cdb, true,
+                           CONFDB_NSS_CONF_ENTRY, CONFDB_NSS_WORKERS, val);
+    assert_int_equal(ret, EOK);
+
+    /* Pretend the NSS responder already created the shared socket so that
+     * the tests do not bind the real pipe. */
+    ret = pipe(test_ctx->pipefd);
+    assert_int_equal(ret, 0);
+    test_ctx->mt_ctx->nss_pipe_fd = test_ctx->pipefd[0];
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int monitor_test_teardown(void **state)
+{
+    struct monitor_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct monitor_test_ctx);
+
+    assert_true(check_leaks_pop(test_ctx));
+
+    close(test_ctx->pipefd[0]);
+    close(test_ctx->pipefd[1]);
+    talloc_free(test_ctx);
+
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static void test_service_config_nss_socket_fd(void **state)
+{
+    struct monitor_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct monitor_test_ctx);
+    struct mt_svc *svc;
+    char *opt;
+    int ret;
+
+    ret = get_service_config(test_ctx->mt_ctx, "nss", 1, &svc);
+    assert_int_equal(ret, EOK);
+    assert_non_null(svc);
+
+    assert_true(svc->share_pipe);
+    opt = talloc_asprintf(svc, " --socket-fd %d", test_ctx->pipefd[0]);
+    assert_non_null(opt);
+    assert_non_null(strstr(svc->command, opt));
+    assert_non_null(strstr(svc->command, " --worker 1"));
+
+    talloc_free(svc);
+}
+
+static void test_service_config_no_socket_fd(void **state)
+{
+    struct monitor_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct monitor_test_ctx);
+    const char *services[] = { "pam", "sudo", "ifp", "ssh", "pac", "autofs",
+                               NULL };
+    struct mt_svc *svc;
+    int ret;
+    int i;
+
+    /* The NSS socket exists, the other responders must not be told about
+     * it since they do not know the --socket-fd option. */
+    for (i = 0; services[i] != NULL; i++) {
+        ret = get_service_config(test_ctx->mt_ctx, services[i], 0, &svc);
+        assert_int_equal(ret, EOK);
+        assert_non_null(svc);
+
+        assert_false(svc->share_pipe);
+        assert_null(strstr(svc->command, "--socket-fd"));
+        assert_null(strstr(svc->command, "--worker"));
+
+        talloc_free(svc);
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_service_config_nss_socket_fd,
+                                        monitor_test_setup,
+                                        monitor_test_teardown),
+        cmocka_unit_test_setup_teardown(test_service_config_no_socket_fd,
+                                        monitor_test_setup,
+                                        monitor_test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can deside if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old db to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_SYSDB_FILE);
+    test_dom_suite_setup(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_SYSDB_FILE);
+    }
+    return rv;
+}
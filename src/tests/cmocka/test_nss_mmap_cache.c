@@ -0,0 +1,783 @@
+/*
+    SSSD
+
+    NSS Responder - Mmap Cache allocator tests
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+/* In order to access opaque types */
+#include "responder/nss/nsssrv_mmap_cache.c"
+
+#include "tests/cmocka/common_mock.h"
+
+/* SSS_NSS_MCACHE_DIR is redefined to this directory for the test */
+#define TESTS_PATH "tests_mmap_cache"
+
+/* 64 elements give 256 slots in the passwd cache, each test record takes
+ * 3 of them */
+#define TEST_ELEMS 64
+#define TEST_REC_SLOTS 3
+#define TEST_RECS ((TEST_ELEMS * SSS_AVG_PASSWD_PAYLOAD / MC_SLOT_SIZE) \
+                   / TEST_REC_SLOTS)
+
+#define BENCH_ELEMS 50000
+
+struct mc_test_ctx {
+    struct sss_mc_ctx *mcc;
+};
+
+static errno_t store_user(struct sss_mc_ctx **mcc, int idx)
+{
+    struct sized_string name;
+    struct sized_string pw;
+    struct sized_string gecos;
+    struct sized_string homedir;
+    struct sized_string shell;
+    char namebuf[16];
+
+    snprintf(namebuf, sizeof(namebuf), "user%05d", idx);
+    to_sized_string(&name, namebuf);
+    to_sized_string(&pw, "x");
+    to_sized_string(&gecos, "");
+    to_sized_string(&homedir, "/home");
+    to_sized_string(&shell, "/bin/sh");
+
+    return sss_mmap_cache_pw_store(mcc, &name, &pw, 10000 + idx, 10000,
+                                   &gecos, &homedir, &shell);
+}
+
+static struct sss_mc_rec *find_user(struct sss_mc_ctx *mcc, int idx)
+{
+    struct sized_string name;
+    char namebuf[16];
+
+    snprintf(namebuf, sizeof(namebuf), "user%05d", idx);
+    to_sized_string(&name, namebuf);
+
+    return sss_mc_find_record(mcc, &name);
+}
+
+static int mc_test_setup(void **state)
+{
+    struct mc_test_ctx *test_ctx;
+    errno_t ret;
+
+    ret = mkdir(TESTS_PATH, 0775);
+    assert_true(ret == 0 || errno == EEXIST);
+
+    test_ctx = talloc_zero(NULL, struct mc_test_ctx);
+    assert_non_null(test_ctx);
+
+    ret = sss_mmap_cache_init(test_ctx, "passwd", SSS_MC_PASSWD,
+                              TEST_ELEMS, TEST_ELEMS, 1000, &test_ctx->mcc);
+    assert_int_equal(ret, EOK);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int mc_test_teardown(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+
+    unlink(TESTS_PATH"/passwd");
+    talloc_free(test_ctx);
+    return 0;
+}
+
+static void set_used(struct sss_mc_ctx *mcc, uint32_t from, uint32_t to)
+{
+    uint32_t i;
+
+    for (i = from; i < to; i++) {
+        MC_SET_BIT(mcc->free_table, i);
+    }
+}
+
+static void test_mc_find_free_run(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+    struct sss_mc_ctx *mcc = test_ctx->mcc;
+    uint32_t tot_slots = mcc->ft_size * 8;
+    uint32_t slot;
+
+    assert_int_equal(tot_slots, 256);
+
+    /* empty table */
+    assert_true(sss_mc_find_free_run(mcc, 256, 0, &slot));
+    assert_int_equal(slot, 0);
+    assert_false(sss_mc_find_free_run(mcc, 257, 0, &slot));
+
+    set_used(mcc, 0, 10);
+    set_used(mcc, 12, 61);
+    set_used(mcc, 70, 200);
+    assert_int_equal(sss_mc_used_slots(mcc), 10 + 49 + 130);
+
+    assert_true(sss_mc_find_free_run(mcc, 2, 0, &slot));
+    assert_int_equal(slot, 10);
+
+    /* the run spans two words of the free table */
+    assert_true(sss_mc_find_free_run(mcc, 9, 0, &slot));
+    assert_int_equal(slot, 61);
+
+    assert_true(sss_mc_find_free_run(mcc, 10, 0, &slot));
+    assert_int_equal(slot, 200);
+
+    /* runs do not start before the given slot */
+    assert_true(sss_mc_find_free_run(mcc, 2, 210, &slot));
+    assert_int_equal(slot, 210);
+    assert_true(sss_mc_find_free_run(mcc, 2, 63, &slot));
+    assert_int_equal(slot, 63);
+
+    /* the search wraps around the end of the table */
+    set_used(mcc, 200, 256);
+    assert_false(sss_mc_find_free_run(mcc, 10, 0, &slot));
+    assert_true(sss_mc_find_free_run(mcc, 2, 210, &slot));
+    assert_int_equal(slot, 10);
+    assert_true(sss_mc_find_free_run(mcc, 9, 128, &slot));
+    assert_int_equal(slot, 61);
+}
+
+static void test_mc_find_free_run_tail(void **state)
+{
+    struct sss_mc_ctx *mcc;
+    uint32_t slot;
+    errno_t ret;
+
+    /* 8 elements make a free table which does not fill a whole word */
+    ret = sss_mmap_cache_init(*state, "group", SSS_MC_GROUP, 8, 8, 1000, &mcc);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(mcc->ft_size * 8, 24);
+
+    assert_true(sss_mc_find_free_run(mcc, 24, 0, &slot));
+    assert_int_equal(slot, 0);
+    assert_false(sss_mc_find_free_run(mcc, 25, 0, &slot));
+    assert_int_equal(sss_mc_used_slots(mcc), 0);
+
+    talloc_free(mcc);
+    unlink(TESTS_PATH"/group");
+}
+
+static void fill_cache(struct sss_mc_ctx **mcc)
+{
+    errno_t ret;
+    int i;
+
+    for (i = 0; i < TEST_RECS; i++) {
+        ret = store_user(mcc, i);
+        assert_int_equal(ret, EOK);
+    }
+
+    assert_int_equal(MC_SIZE_TO_SLOTS(find_user(*mcc, 0)->len),
+                     TEST_REC_SLOTS);
+    assert_int_equal((*mcc)->live_evictions, 0);
+}
+
+static void test_mc_evict_expired(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+    time_t now = time(NULL);
+    errno_t ret;
+    int i;
+
+    fill_cache(&test_ctx->mcc);
+
+    for (i = 0; i < TEST_RECS; i++) {
+        find_user(test_ctx->mcc, i)->expire = now + 1000 + i;
+    }
+
+    /* an expired record is preferred over the one at next_slot */
+    find_user(test_ctx->mcc, 2)->expire = now - 10;
+
+    ret = store_user(&test_ctx->mcc, 1000);
+    assert_int_equal(ret, EOK);
+
+    assert_null(find_user(test_ctx->mcc, 2));
+    assert_non_null(find_user(test_ctx->mcc, 0));
+    assert_non_null(find_user(test_ctx->mcc, 1));
+    assert_non_null(find_user(test_ctx->mcc, 1000));
+    assert_int_equal(test_ctx->mcc->live_evictions, 0);
+
+    /* without expired records the one expiring soonest goes */
+    find_user(test_ctx->mcc, 5)->expire = now + 100;
+
+    ret = store_user(&test_ctx->mcc, 1001);
+    assert_int_equal(ret, EOK);
+
+    assert_null(find_user(test_ctx->mcc, 5));
+    assert_non_null(find_user(test_ctx->mcc, 3));
+    assert_non_null(find_user(test_ctx->mcc, 4));
+    assert_int_equal(test_ctx->mcc->live_evictions, 1);
+}
+
+static errno_t store_negative_user(struct sss_mc_ctx **mcc, int idx)
+{
+    struct sized_string name;
+    char namebuf[16];
+
+    snprintf(namebuf, sizeof(namebuf), "user%05d", idx);
+    to_sized_string(&name, namebuf);
+
+    return sss_mmap_cache_pw_store_negative(mcc, &name, 1000);
+}
+
+static errno_t invalidate_user(struct sss_mc_ctx *mcc, int idx)
+{
+    struct sized_string name;
+    char namebuf[16];
+
+    snprintf(namebuf, sizeof(namebuf), "user%05d", idx);
+    to_sized_string(&name, namebuf);
+
+    return sss_mmap_cache_pw_invalidate(mcc, &name);
+}
+
+static void test_mc_free_run_after_evict(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+    struct sss_mc_ctx *old_mcc;
+    time_t now = time(NULL);
+    errno_t ret;
+    int i;
+
+    fill_cache(&test_ctx->mcc);
+    old_mcc = test_ctx->mcc;
+
+    for (i = 0; i < TEST_RECS; i++) {
+        find_user(test_ctx->mcc, i)->expire = now + 1000 + i;
+    }
+
+    /* evicts user 0, the new record ends where user 1 starts */
+    ret = store_user(&test_ctx->mcc, 1000);
+    assert_int_equal(ret, EOK);
+    assert_null(find_user(test_ctx->mcc, 0));
+    assert_int_equal(test_ctx->mcc->next_slot, TEST_REC_SLOTS);
+
+    /* free the records on both sides of next_slot, the negative records
+     * take fewer slots so a run starting before next_slot would leave
+     * next_slot in the middle of a record */
+    ret = invalidate_user(test_ctx->mcc, 1000);
+    assert_int_equal(ret, EOK);
+    ret = invalidate_user(test_ctx->mcc, 1);
+    assert_int_equal(ret, EOK);
+
+    ret = store_negative_user(&test_ctx->mcc, 2000);
+    assert_int_equal(ret, EOK);
+    ret = store_negative_user(&test_ctx->mcc, 2001);
+    assert_int_equal(ret, EOK);
+
+    /* no free run is left, so this evicts starting at next_slot */
+    ret = store_user(&test_ctx->mcc, 3000);
+    assert_int_equal(ret, EOK);
+    assert_ptr_equal(test_ctx->mcc, old_mcc);
+    assert_non_null(find_user(test_ctx->mcc, 3000));
+    assert_non_null(find_user(test_ctx->mcc, TEST_RECS - 1));
+
+    /* keep mixing records of different sizes, which alternates between
+     * allocations from free runs and evictions */
+    for (i = 0; i < TEST_RECS * 4; i++) {
+        if (i % 3 == 0) {
+            ret = store_negative_user(&test_ctx->mcc, 4000 + i);
+        } else {
+            ret = store_user(&test_ctx->mcc, 4000 + i);
+        }
+        assert_int_equal(ret, EOK);
+        assert_ptr_equal(test_ctx->mcc, old_mcc);
+        assert_non_null(find_user(test_ctx->mcc, 4000 + i));
+
+        if (i % 5 == 0) {
+            ret = invalidate_user(test_ctx->mcc, 4000 + i);
+            assert_int_equal(ret, EOK);
+        }
+    }
+}
+
+static void test_mc_grow(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+    struct sss_mc_ctx *old_mcc;
+    struct sss_mc_header *h;
+    errno_t ret;
+    int i;
+
+    talloc_zfree(test_ctx->mcc);
+    ret = sss_mmap_cache_init(test_ctx, "passwd", SSS_MC_PASSWD,
+                              TEST_ELEMS, TEST_ELEMS * 2, 1000,
+                              &test_ctx->mcc);
+    assert_int_equal(ret, EOK);
+
+    fill_cache(&test_ctx->mcc);
+    old_mcc = test_ctx->mcc;
+
+    /* every further store evicts a live record */
+    for (i = 0; i < TEST_ELEMS / 4; i++) {
+        ret = store_user(&test_ctx->mcc, 1000 + i);
+        assert_int_equal(ret, EOK);
+        assert_ptr_equal(test_ctx->mcc, old_mcc);
+    }
+    assert_int_equal(test_ctx->mcc->live_evictions, TEST_ELEMS / 4);
+
+    ret = store_user(&test_ctx->mcc, 2000);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(test_ctx->mcc->n_elem, TEST_ELEMS * 2);
+    assert_int_equal(test_ctx->mcc->live_evictions, 0);
+    assert_non_null(find_user(test_ctx->mcc, 2000));
+
+    h = (struct sss_mc_header *) test_ctx->mcc->mmap_base;
+    assert_int_equal(h->status, SSS_MC_HEADER_ALIVE);
+    assert_int_equal(h->dt_size, test_ctx->mcc->dt_size);
+
+    /* never beyond the maximum */
+    assert_false(sss_mc_needs_growth(test_ctx->mcc));
+    test_ctx->mcc->live_evictions = TEST_ELEMS;
+    assert_false(sss_mc_needs_growth(test_ctx->mcc));
+}
+
+/* A worker maps the file of the main process and both see the changes of
+ * the other one */
+static void test_mc_attach(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+    struct sss_mc_ctx *worker;
+    struct sss_mc_ctx *grp_worker;
+    struct sss_mc_ctx *grp_mcc;
+    struct sized_string name;
+    errno_t ret;
+
+    ret = sss_mmap_cache_attach(test_ctx, "passwd", SSS_MC_PASSWD,
+                                TEST_ELEMS, 1000, &worker);
+    assert_int_equal(ret, EOK);
+    assert_int_not_equal(worker->fd, -1);
+    assert_int_equal(worker->dt_size, test_ctx->mcc->dt_size);
+    assert_int_equal(worker->seed, test_ctx->mcc->seed);
+    assert_int_equal(worker->n_elem, TEST_ELEMS);
+
+    ret = store_user(&worker, 1);
+    assert_int_equal(ret, EOK);
+    assert_non_null(find_user(test_ctx->mcc, 1));
+
+    ret = store_user(&test_ctx->mcc, 2);
+    assert_int_equal(ret, EOK);
+    assert_non_null(find_user(worker, 2));
+
+    ret = invalidate_user(worker, 2);
+    assert_int_equal(ret, EOK);
+    assert_null(find_user(test_ctx->mcc, 2));
+    assert_int_equal(worker->lock_depth, 0);
+
+    /* the main process re-creates the file, the worker follows */
+    ret = sss_mmap_cache_reinit(test_ctx, -1, -1, -1, &test_ctx->mcc);
+    assert_int_equal(ret, EOK);
+
+    ret = store_user(&worker, 3);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(worker->seed, test_ctx->mcc->seed);
+    assert_non_null(find_user(test_ctx->mcc, 3));
+    assert_null(find_user(test_ctx->mcc, 1));
+
+    /* a worker may start before the main process created the file */
+    to_sized_string(&name, "group1");
+    ret = sss_mmap_cache_attach(test_ctx, "group", SSS_MC_GROUP,
+                                TEST_ELEMS, 1000, &grp_worker);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(grp_worker->fd, -1);
+
+    ret = sss_mmap_cache_gr_store_negative(&grp_worker, &name, 15);
+    assert_int_equal(ret, ENOENT);
+
+    ret = sss_mmap_cache_init(test_ctx, "group", SSS_MC_GROUP,
+                              TEST_ELEMS, TEST_ELEMS, 1000, &grp_mcc);
+    assert_int_equal(ret, EOK);
+
+    ret = sss_mmap_cache_gr_store_negative(&grp_worker, &name, 15);
+    assert_int_equal(ret, EOK);
+    assert_non_null(sss_mc_find_record(grp_mcc, &name));
+
+    talloc_free(grp_worker);
+    talloc_free(grp_mcc);
+    talloc_free(worker);
+    unlink(TESTS_PATH"/group");
+}
+
+/* Walks the uid chain the way the clients do */
+static struct sss_mc_rec *find_uid(struct sss_mc_ctx *mcc, uid_t uid)
+{
+    struct sss_mc_rec *rec;
+    char uidstr[11];
+    uint32_t hash;
+    uint32_t slot;
+
+    snprintf(uidstr, sizeof(uidstr), "%"PRIu32, (uint32_t) uid);
+    hash = sss_mc_hash(mcc, uidstr, strlen(uidstr) + 1);
+
+    slot = mcc->hash_table[hash];
+    while (MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
+        rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
+        if (rec->hash2 == hash
+                && (rec->flags & SSS_MC_REC_NEG_NAME) == 0
+                && ((struct sss_mc_pwd_data *)rec->data)->uid == uid) {
+            return rec;
+        }
+        slot = sss_mc_next_slot_with_hash(rec, hash);
+    }
+
+    return NULL;
+}
+
+static void test_mc_negative(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+    struct sss_mc_rec *rec;
+    struct sized_string name;
+    char namebuf[16];
+    time_t now = time(NULL);
+    uint32_t name_slots;
+    uint32_t uid_slots;
+    errno_t ret;
+
+    snprintf(namebuf, sizeof(namebuf), "user%05d", 1);
+    to_sized_string(&name, namebuf);
+
+    /* negative name record */
+    ret = sss_mmap_cache_pw_store_negative(&test_ctx->mcc, &name, 15);
+    assert_int_equal(ret, EOK);
+
+    rec = find_user(test_ctx->mcc, 1);
+    assert_non_null(rec);
+    assert_int_equal(rec->flags, SSS_MC_REC_NEG_NAME);
+    assert_int_equal(rec->hash1, rec->hash2);
+    assert_true(rec->expire >= now + 15);
+    assert_true(sss_mc_is_valid_rec(test_ctx->mcc, rec));
+    name_slots = MC_SIZE_TO_SLOTS(rec->len);
+
+    /* it does not answer uid lookups */
+    assert_null(find_uid(test_ctx->mcc, MC_INVALID_VAL32));
+
+    /* negative uid record */
+    ret = sss_mmap_cache_pw_store_negative_uid(&test_ctx->mcc, 10001, 15);
+    assert_int_equal(ret, EOK);
+
+    rec = find_uid(test_ctx->mcc, 10001);
+    assert_non_null(rec);
+    assert_int_equal(rec->flags, SSS_MC_REC_NEG_ID);
+    assert_true(sss_mc_is_valid_rec(test_ctx->mcc, rec));
+    uid_slots = MC_SIZE_TO_SLOTS(rec->len);
+
+    /* storing it again replaces the record */
+    ret = sss_mmap_cache_pw_store_negative_uid(&test_ctx->mcc, 10001, 15);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(sss_mc_used_slots(test_ctx->mcc),
+                     name_slots + uid_slots);
+
+    /* the user shows up, both negative records are replaced */
+    ret = store_user(&test_ctx->mcc, 1);
+    assert_int_equal(ret, EOK);
+
+    rec = find_user(test_ctx->mcc, 1);
+    assert_non_null(rec);
+    assert_int_equal(rec->flags, 0);
+    assert_ptr_equal(find_uid(test_ctx->mcc, 10001), rec);
+    assert_int_equal(sss_mc_used_slots(test_ctx->mcc),
+                     MC_SIZE_TO_SLOTS(rec->len));
+
+    /* and disappears again */
+    ret = sss_mmap_cache_pw_store_negative(&test_ctx->mcc, &name, 15);
+    assert_int_equal(ret, EOK);
+    rec = find_user(test_ctx->mcc, 1);
+    assert_non_null(rec);
+    assert_int_equal(rec->flags, SSS_MC_REC_NEG_NAME);
+    assert_null(find_uid(test_ctx->mcc, 10001));
+
+    ret = sss_mmap_cache_pw_invalidate(test_ctx->mcc, &name);
+    assert_int_equal(ret, EOK);
+    assert_null(find_user(test_ctx->mcc, 1));
+    assert_int_equal(sss_mc_used_slots(test_ctx->mcc), 0);
+}
+
+static int mc_sid_test_setup(void **state)
+{
+    struct mc_test_ctx *test_ctx;
+    errno_t ret;
+
+    ret = mkdir(TESTS_PATH, 0775);
+    assert_true(ret == 0 || errno == EEXIST);
+
+    test_ctx = talloc_zero(NULL, struct mc_test_ctx);
+    assert_non_null(test_ctx);
+
+    ret = sss_mmap_cache_init(test_ctx, "sid", SSS_MC_SID,
+                              TEST_ELEMS, TEST_ELEMS, 1000, &test_ctx->mcc);
+    assert_int_equal(ret, EOK);
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int mc_sid_test_teardown(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+
+    unlink(TESTS_PATH"/sid");
+    talloc_free(test_ctx);
+    return 0;
+}
+
+static const char *rec_sid_name(struct sss_mc_rec *rec)
+{
+    struct sss_mc_sid_data *data = (struct sss_mc_sid_data *)rec->data;
+
+    return data->strs + strlen(data->strs) + 1;
+}
+
+/* Same lookup as the client does */
+static int count_sid_by_id(struct sss_mc_ctx *mcc, uint32_t id,
+                           struct sss_mc_rec **_rec)
+{
+    struct sss_mc_rec *rec;
+    char idstr[11];
+    uint32_t hash;
+    uint32_t slot;
+    int count = 0;
+
+    snprintf(idstr, sizeof(idstr), "%"PRIu32, id);
+    hash = sss_mc_hash(mcc, idstr, strlen(idstr) + 1);
+
+    slot = mcc->hash_table[hash];
+    while (MC_SLOT_WITHIN_BOUNDS(slot, mcc->dt_size)) {
+        rec = MC_SLOT_TO_PTR(mcc->data_table, slot, struct sss_mc_rec);
+        if (rec->hash2 == hash && (rec->flags & SSS_MC_REC_SID_BY_ID)
+                && sss_mc_get_rec_id(mcc, rec) == id) {
+            *_rec = rec;
+            count++;
+        }
+        slot = sss_mc_next_slot_with_hash(rec, hash);
+    }
+
+    return count;
+}
+
+static void test_mc_sid(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+    struct sss_mc_rec *rec;
+    struct sss_mc_sid_data *data;
+    struct sized_string sid1;
+    struct sized_string sid2;
+    struct sized_string name;
+    errno_t ret;
+
+    to_sized_string(&sid1, "S-1-5-21-1-2-3-1000");
+    to_sized_string(&sid2, "S-1-5-21-1-2-3-2000");
+    to_sized_string(&name, "user1@test");
+
+    /* name lookup */
+    ret = sss_mmap_cache_sid_store(&test_ctx->mcc, &sid1, &name, 10000,
+                                   SSS_ID_TYPE_UID, false);
+    assert_int_equal(ret, EOK);
+
+    rec = sss_mc_find_record(test_ctx->mcc, &sid1);
+    assert_non_null(rec);
+    data = (struct sss_mc_sid_data *)rec->data;
+    assert_int_equal(data->id, 10000);
+    assert_int_equal(data->type, SSS_ID_TYPE_UID);
+    assert_int_equal(rec->flags, 0);
+    assert_string_equal(rec_sid_name(rec), "user1@test");
+    assert_int_equal(count_sid_by_id(test_ctx->mcc, 10000, &rec), 0);
+
+    /* id lookup keeps the name and answers lookups by id now */
+    ret = sss_mmap_cache_sid_store(&test_ctx->mcc, &sid1, NULL, 10000,
+                                   SSS_ID_TYPE_UID, true);
+    assert_int_equal(ret, EOK);
+
+    assert_int_equal(count_sid_by_id(test_ctx->mcc, 10000, &rec), 1);
+    assert_ptr_equal(rec, sss_mc_find_record(test_ctx->mcc, &sid1));
+    assert_string_equal(rec_sid_name(rec), "user1@test");
+
+    /* a lookup by SID does not drop the id flag */
+    ret = sss_mmap_cache_sid_store(&test_ctx->mcc, &sid1, NULL, 10000,
+                                   SSS_ID_TYPE_UID, false);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(count_sid_by_id(test_ctx->mcc, 10000, &rec), 1);
+
+    /* another SID of the same id, e.g. the group with the same number,
+     * only answers by SID */
+    ret = sss_mmap_cache_sid_store(&test_ctx->mcc, &sid2, NULL, 10000,
+                                   SSS_ID_TYPE_GID, false);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(count_sid_by_id(test_ctx->mcc, 10000, &rec), 1);
+    data = (struct sss_mc_sid_data *)rec->data;
+    assert_string_equal(data->strs, "S-1-5-21-1-2-3-1000");
+
+    /* until it was the result of a lookup by id */
+    ret = sss_mmap_cache_sid_store(&test_ctx->mcc, &sid2, NULL, 10000,
+                                   SSS_ID_TYPE_GID, true);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(count_sid_by_id(test_ctx->mcc, 10000, &rec), 1);
+    data = (struct sss_mc_sid_data *)rec->data;
+    assert_string_equal(data->strs, "S-1-5-21-1-2-3-2000");
+    assert_string_equal(rec_sid_name(rec), "");
+
+    /* the old record was dropped entirely */
+    assert_null(sss_mc_find_record(test_ctx->mcc, &sid1));
+
+    /* a changed id replaces the record and forgets the name */
+    ret = sss_mmap_cache_sid_store(&test_ctx->mcc, &sid1, &name, 10000,
+                                   SSS_ID_TYPE_UID, false);
+    assert_int_equal(ret, EOK);
+    ret = sss_mmap_cache_sid_store(&test_ctx->mcc, &sid1, NULL, 10001,
+                                   SSS_ID_TYPE_UID, false);
+    assert_int_equal(ret, EOK);
+    rec = sss_mc_find_record(test_ctx->mcc, &sid1);
+    assert_non_null(rec);
+    data = (struct sss_mc_sid_data *)rec->data;
+    assert_int_equal(data->id, 10001);
+    assert_string_equal(rec_sid_name(rec), "");
+}
+
+static double store_users(struct sss_mc_ctx **mcc, int first, int count)
+{
+    struct timeval start;
+    struct timeval end;
+    errno_t ret;
+    int i;
+
+    gettimeofday(&start, NULL);
+    for (i = first; i < first + count; i++) {
+        ret = store_user(mcc, i);
+        assert_int_equal(ret, EOK);
+    }
+    gettimeofday(&end, NULL);
+
+    return count / ((end.tv_sec - start.tv_sec)
+                        + (end.tv_usec - start.tv_usec) / 1000000.0);
+}
+
+/* Not a functional test, prints the insert throughput as the cache fills
+ * up and once it has to recycle records */
+static void test_mc_insert_benchmark(void **state)
+{
+    struct mc_test_ctx *test_ctx = talloc_get_type(*state,
+                                                   struct mc_test_ctx);
+    int recs = (BENCH_ELEMS * SSS_AVG_PASSWD_PAYLOAD / MC_SLOT_SIZE)
+                    / TEST_REC_SLOTS;
+    double rate;
+    errno_t ret;
+
+    talloc_zfree(test_ctx->mcc);
+    ret = sss_mmap_cache_init(test_ctx, "passwd", SSS_MC_PASSWD,
+                              BENCH_ELEMS, BENCH_ELEMS, 1000,
+                              &test_ctx->mcc);
+    assert_int_equal(ret, EOK);
+
+    rate = store_users(&test_ctx->mcc, 0, recs / 2);
+    printf("0-50%% fill: %.0f inserts/s\n", rate);
+
+    rate = store_users(&test_ctx->mcc, recs / 2, recs * 4 / 10);
+    printf("50-90%% fill: %.0f inserts/s\n", rate);
+
+    rate = store_users(&test_ctx->mcc, recs * 9 / 10, recs / 10);
+    printf("90-100%% fill: %.0f inserts/s\n", rate);
+
+    rate = store_users(&test_ctx->mcc, recs, recs);
+    printf("full cache: %.0f inserts/s, %u slots used of %u\n",
+           rate, sss_mc_used_slots(test_ctx->mcc),
+           test_ctx->mcc->ft_size * 8);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    poptContext pc;
+    int opt;
+    int benchmark = 0;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"benchmark", 'b', POPT_ARG_NONE, &benchmark, 0,
+         _("Also time the inserts into a large cache"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_mc_find_free_run,
+                                        mc_test_setup, mc_test_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_find_free_run_tail,
+                                        mc_test_setup, mc_test_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_evict_expired,
+                                        mc_test_setup, mc_test_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_free_run_after_evict,
+                                        mc_test_setup, mc_test_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_grow,
+                                        mc_test_setup, mc_test_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_attach,
+                                        mc_test_setup, mc_test_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_negative,
+                                        mc_test_setup, mc_test_teardown),
+        cmocka_unit_test_setup_teardown(test_mc_sid,
+                                        mc_sid_test_setup,
+                                        mc_sid_test_teardown),
+    };
+
+    /* too slow and too noisy for every make check */
+    const struct CMUnitTest bench_tests[] = {
+        cmocka_unit_test_setup_teardown(test_mc_insert_benchmark,
+                                        mc_test_setup, mc_test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can deside if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    tests_set_cwd();
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && benchmark) {
+        rv = cmocka_run_group_tests(bench_tests, NULL, NULL);
+    }
+    rmdir(TESTS_PATH);
+
+    return rv;
+}
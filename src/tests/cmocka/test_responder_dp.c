@@ -0,0 +1,390 @@
+/*
+    SSSD
+
+    Responder Data Provider request tests
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+
+/* static functions are tested */
+#include "responder/common/responder_dp.c"
+
+#define NUM_KEYS 3
+
+/* The requests are not sent, only the reply processing is tested */
+int sss_dp_get_domain_conn(struct resp_ctx *rctx, const char *domain,
+                           struct be_conn **_conn)
+{
+    return ENOENT;
+}
+
+void resp_lru_invalidate(struct resp_lru *lru, const char *domain_name)
+{
+    return;
+}
+
+struct dp_test_ctx {
+    struct tevent_context *ev;
+    struct resp_ctx *rctx;
+
+    /* the status the waiter of each key was called with */
+    dbus_uint16_t dp_err[NUM_KEYS];
+    dbus_uint32_t dp_ret[NUM_KEYS];
+    char *err_msg[NUM_KEYS];
+    int done;
+};
+
+struct dp_test_waiter {
+    struct dp_test_ctx *test_ctx;
+    int idx;
+};
+
+static int dp_test_setup(void **state)
+{
+    struct dp_test_ctx *test_ctx;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context, struct dp_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->ev = tevent_context_init(test_ctx);
+    assert_non_null(test_ctx->ev);
+
+    test_ctx->rctx = talloc_zero(test_ctx, struct resp_ctx);
+    assert_non_null(test_ctx->rctx);
+    test_ctx->rctx->ev = test_ctx->ev;
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int dp_test_teardown(void **state)
+{
+    struct dp_test_ctx *test_ctx = talloc_get_type(*state, struct dp_test_ctx);
+
+    assert_true(check_leaks_pop(test_ctx));
+    talloc_free(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+static DBusMessage *dp_test_reply(dbus_uint16_t dp_err, dbus_uint32_t dp_ret,
+                                  const char *err_msg,
+                                  dbus_uint16_t *key_errs,
+                                  dbus_uint32_t *key_rets,
+                                  int num_keys)
+{
+    DBusMessage *reply;
+    dbus_bool_t dbret;
+
+    reply = dbus_message_new(DBUS_MESSAGE_TYPE_METHOD_RETURN);
+    assert_non_null(reply);
+
+    if (key_errs == NULL) {
+        dbret = dbus_message_append_args(reply,
+                                         DBUS_TYPE_UINT16, &dp_err,
+                                         DBUS_TYPE_UINT32, &dp_ret,
+                                         DBUS_TYPE_STRING, &err_msg,
+                                         DBUS_TYPE_INVALID);
+    } else {
+        dbret = dbus_message_append_args(reply,
+                                         DBUS_TYPE_UINT16, &dp_err,
+                                         DBUS_TYPE_UINT32, &dp_ret,
+                                         DBUS_TYPE_STRING, &err_msg,
+                                         DBUS_TYPE_ARRAY, DBUS_TYPE_UINT16,
+                                         &key_errs, num_keys,
+                                         DBUS_TYPE_ARRAY, DBUS_TYPE_UINT32,
+                                         &key_rets, num_keys,
+                                         DBUS_TYPE_INVALID);
+    }
+    assert_true(dbret);
+
+    return reply;
+}
+
+static void test_sss_dp_parse_reply_per_key(void **state)
+{
+    struct dp_test_ctx *test_ctx = talloc_get_type(*state, struct dp_test_ctx);
+    dbus_uint16_t key_errs[NUM_KEYS] = { DP_ERR_OK, DP_ERR_FATAL, DP_ERR_OK };
+    dbus_uint32_t key_rets[NUM_KEYS] = { EOK, EINVAL, EOK };
+    dbus_uint16_t *parsed_errs = NULL;
+    dbus_uint32_t *parsed_rets = NULL;
+    dbus_uint16_t dp_err;
+    dbus_uint32_t dp_ret;
+    char *err_msg = NULL;
+    DBusMessage *reply;
+    errno_t ret;
+    int i;
+
+    reply = dp_test_reply(DP_ERR_FATAL, EINVAL, "Invalid Filter",
+                          key_errs, key_rets, NUM_KEYS);
+
+    ret = sss_dp_parse_reply(test_ctx, reply, NUM_KEYS,
+                             &dp_err, &dp_ret, &err_msg,
+                             &parsed_errs, &parsed_rets);
+    dbus_message_unref(reply);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(dp_err, DP_ERR_FATAL);
+    assert_int_equal(dp_ret, EINVAL);
+    assert_string_equal(err_msg, "Invalid Filter");
+    assert_non_null(parsed_errs);
+    assert_non_null(parsed_rets);
+    for (i = 0; i < NUM_KEYS; i++) {
+        assert_int_equal(parsed_errs[i], key_errs[i]);
+        assert_int_equal(parsed_rets[i], key_rets[i]);
+    }
+
+    talloc_free(err_msg);
+    talloc_free(parsed_errs);
+    talloc_free(parsed_rets);
+}
+
+static void test_sss_dp_parse_reply_common(void **state)
+{
+    struct dp_test_ctx *test_ctx = talloc_get_type(*state, struct dp_test_ctx);
+    dbus_uint16_t key_errs[2] = { DP_ERR_OK, DP_ERR_OK };
+    dbus_uint32_t key_rets[2] = { EOK, EOK };
+    dbus_uint16_t *parsed_errs = NULL;
+    dbus_uint32_t *parsed_rets = NULL;
+    dbus_uint16_t dp_err;
+    dbus_uint32_t dp_ret;
+    char *err_msg = NULL;
+    DBusMessage *reply;
+    errno_t ret;
+
+    /* a fast reply has no per-key status */
+    reply = dp_test_reply(DP_ERR_OFFLINE, EAGAIN, "Fast reply - offline",
+                          NULL, NULL, 0);
+    ret = sss_dp_parse_reply(test_ctx, reply, NUM_KEYS,
+                             &dp_err, &dp_ret, &err_msg,
+                             &parsed_errs, &parsed_rets);
+    dbus_message_unref(reply);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(dp_err, DP_ERR_OFFLINE);
+    assert_int_equal(dp_ret, EAGAIN);
+    assert_null(parsed_errs);
+    assert_null(parsed_rets);
+    talloc_zfree(err_msg);
+
+    /* the status of a different number of keys is ignored */
+    reply = dp_test_reply(DP_ERR_OK, EOK, "Success",
+                          key_errs, key_rets, 2);
+    ret = sss_dp_parse_reply(test_ctx, reply, NUM_KEYS,
+                             &dp_err, &dp_ret, &err_msg,
+                             &parsed_errs, &parsed_rets);
+    dbus_message_unref(reply);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(dp_err, DP_ERR_OK);
+    assert_null(parsed_errs);
+    assert_null(parsed_rets);
+    talloc_zfree(err_msg);
+}
+
+static void dp_test_waiter_done(struct tevent_req *req)
+{
+    struct dp_test_waiter *waiter;
+    struct dp_test_ctx *test_ctx;
+    errno_t ret;
+
+    waiter = tevent_req_callback_data(req, struct dp_test_waiter);
+    test_ctx = waiter->test_ctx;
+
+    ret = sss_dp_req_recv(test_ctx, req,
+                          &test_ctx->dp_err[waiter->idx],
+                          &test_ctx->dp_ret[waiter->idx],
+                          &test_ctx->err_msg[waiter->idx]);
+    assert_int_equal(ret, EOK);
+    test_ctx->done++;
+
+    /* frees the callback of the sdp_req */
+    talloc_free(req);
+}
+
+/* Sets up an internal request with NUM_KEYS keys, each of them with a
+ * single-key request waiting for it */
+static struct tevent_req *dp_test_internal_req(struct dp_test_ctx *test_ctx)
+{
+    struct dp_internal_get_state *state;
+    struct sss_dp_req_state *cb_state;
+    struct dp_test_waiter *waiter;
+    struct tevent_req *nreq;
+    struct tevent_req *req;
+    hash_value_t value;
+    errno_t ret;
+    int i;
+
+    req = tevent_req_create(test_ctx, &state, struct dp_internal_get_state);
+    assert_non_null(req);
+    state->rctx = test_ctx->rctx;
+
+    state->sdp_reqs = talloc_zero_array(state, struct sss_dp_req *, NUM_KEYS);
+    assert_non_null(state->sdp_reqs);
+    state->num_reqs = NUM_KEYS;
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        state->sdp_reqs[i] = talloc_zero(state, struct sss_dp_req);
+        assert_non_null(state->sdp_reqs[i]);
+        state->sdp_reqs[i]->rctx = test_ctx->rctx;
+        state->sdp_reqs[i]->ev = test_ctx->ev;
+
+        nreq = tevent_req_create(test_ctx, &cb_state, struct sss_dp_req_state);
+        assert_non_null(nreq);
+
+        waiter = talloc_zero(nreq, struct dp_test_waiter);
+        assert_non_null(waiter);
+        waiter->test_ctx = test_ctx;
+        waiter->idx = i;
+        tevent_req_set_callback(nreq, dp_test_waiter_done, waiter);
+
+        value.type = HASH_VALUE_PTR;
+        value.ptr = state->sdp_reqs[i];
+        ret = sss_dp_req_add_callback(nreq, &value, nreq);
+        assert_int_equal(ret, EOK);
+    }
+
+    return req;
+}
+
+static void test_sss_dp_finish_per_key(void **state)
+{
+    struct dp_test_ctx *test_ctx = talloc_get_type(*state, struct dp_test_ctx);
+    struct dp_internal_get_state *get_state;
+    struct sss_dp_req *first;
+    struct tevent_req *req;
+    int i;
+
+    req = dp_test_internal_req(test_ctx);
+    get_state = tevent_req_data(req, struct dp_internal_get_state);
+    first = get_state->sdp_reqs[0];
+
+    /* the reply reports the failure of the second key */
+    first->dp_err = DP_ERR_FATAL;
+    first->dp_ret = EINVAL;
+    first->err_msg = talloc_strdup(first, "Invalid Filter");
+    assert_non_null(first->err_msg);
+
+    get_state->key_errs = talloc_zero_array(get_state, dbus_uint16_t,
+                                            NUM_KEYS);
+    get_state->key_rets = talloc_zero_array(get_state, dbus_uint32_t,
+                                            NUM_KEYS);
+    assert_non_null(get_state->key_errs);
+    assert_non_null(get_state->key_rets);
+    get_state->key_errs[1] = DP_ERR_FATAL;
+    get_state->key_rets[1] = EINVAL;
+    get_state->key_errs[2] = DP_ERR_OFFLINE;
+    get_state->key_rets[2] = EAGAIN;
+
+    sss_dp_internal_get_finish(req, EOK);
+    assert_int_equal(test_ctx->done, NUM_KEYS);
+
+    /* the other keys are not failed by the first error */
+    assert_int_equal(test_ctx->dp_err[0], DP_ERR_OK);
+    assert_int_equal(test_ctx->dp_ret[0], EOK);
+    assert_string_equal(test_ctx->err_msg[0], "Success");
+
+    assert_int_equal(test_ctx->dp_err[1], DP_ERR_FATAL);
+    assert_int_equal(test_ctx->dp_ret[1], EINVAL);
+    assert_string_equal(test_ctx->err_msg[1], "Invalid Filter");
+
+    assert_int_equal(test_ctx->dp_err[2], DP_ERR_OFFLINE);
+    assert_int_equal(test_ctx->dp_ret[2], EAGAIN);
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        talloc_free(test_ctx->err_msg[i]);
+    }
+    talloc_free(req);
+}
+
+static void test_sss_dp_finish_common(void **state)
+{
+    struct dp_test_ctx *test_ctx = talloc_get_type(*state, struct dp_test_ctx);
+    struct dp_internal_get_state *get_state;
+    struct sss_dp_req *first;
+    struct tevent_req *req;
+    int i;
+
+    req = dp_test_internal_req(test_ctx);
+    get_state = tevent_req_data(req, struct dp_internal_get_state);
+    first = get_state->sdp_reqs[0];
+
+    /* a reply without per-key status applies to all keys */
+    first->dp_err = DP_ERR_OFFLINE;
+    first->dp_ret = EAGAIN;
+    first->err_msg = talloc_strdup(first, "Fast reply - offline");
+    assert_non_null(first->err_msg);
+
+    sss_dp_internal_get_finish(req, EOK);
+    assert_int_equal(test_ctx->done, NUM_KEYS);
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        assert_int_equal(test_ctx->dp_err[i], DP_ERR_OFFLINE);
+        assert_int_equal(test_ctx->dp_ret[i], EAGAIN);
+        assert_string_equal(test_ctx->err_msg[i], "Fast reply - offline");
+        talloc_free(test_ctx->err_msg[i]);
+    }
+    talloc_free(req);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sss_dp_parse_reply_per_key,
+                                        dp_test_setup, dp_test_teardown),
+        cmocka_unit_test_setup_teardown(test_sss_dp_parse_reply_common,
+                                        dp_test_setup, dp_test_teardown),
+        cmocka_unit_test_setup_teardown(test_sss_dp_finish_per_key,
+                                        dp_test_setup, dp_test_teardown),
+        cmocka_unit_test_setup_teardown(test_sss_dp_finish_common,
+                                        dp_test_setup, dp_test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can deside if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,459 @@
+/*
+    SSSD
+
+    Responder LRU tests
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <popt.h>
+#include <sys/time.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "responder/common/responder_lru.h"
+
+#define TESTS_PATH "tests_responder_lru"
+#define TEST_CONF_DB "test_responder_lru_conf.ldb"
+#define TEST_DOM_NAME "lru_test"
+#define TEST_SYSDB_FILE "cache_"TEST_DOM_NAME".ldb"
+#define TEST_ID_PROVIDER "ldap"
+
+#define TEST_USERS 100
+#define TEST_UID_BASE 10000
+#define TEST_GID 20000
+#define BENCH_LOOKUPS 10000
+
+/* Number of searches which reached the cache database */
+static int sysdb_searches;
+
+errno_t __real_sysdb_getpwnam_with_views(TALLOC_CTX *mem_ctx,
+                                         struct sss_domain_info *domain,
+                                         const char *name,
+                                         struct ldb_result **res);
+
+errno_t __wrap_sysdb_getpwnam_with_views(TALLOC_CTX *mem_ctx,
+                                         struct sss_domain_info *domain,
+                                         const char *name,
+                                         struct ldb_result **res)
+{
+    sysdb_searches++;
+    return __real_sysdb_getpwnam_with_views(mem_ctx, domain, name, res);
+}
+
+errno_t __real_sysdb_getpwuid_with_views(TALLOC_CTX *mem_ctx,
+                                         struct sss_domain_info *domain,
+                                         uid_t uid,
+                                         struct ldb_result **res);
+
+errno_t __wrap_sysdb_getpwuid_with_views(TALLOC_CTX *mem_ctx,
+                                         struct sss_domain_info *domain,
+                                         uid_t uid,
+                                         struct ldb_result **res)
+{
+    sysdb_searches++;
+    return __real_sysdb_getpwuid_with_views(mem_ctx, domain, uid, res);
+}
+
+int __real_sysdb_getgrgid_with_views(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     gid_t gid,
+                                     struct ldb_result **res);
+
+int __wrap_sysdb_getgrgid_with_views(TALLOC_CTX *mem_ctx,
+                                     struct sss_domain_info *domain,
+                                     gid_t gid,
+                                     struct ldb_result **res)
+{
+    sysdb_searches++;
+    return __real_sysdb_getgrgid_with_views(mem_ctx, domain, gid, res);
+}
+
+struct lru_test_ctx {
+    struct sss_test_ctx *tctx;
+    struct resp_lru *lru;
+};
+
+static void store_user(struct sss_domain_info *dom, int idx,
+                       const char *shell, time_t now)
+{
+    char *name;
+    errno_t ret;
+
+    name = talloc_asprintf(NULL, "user%d", idx);
+    assert_non_null(name);
+
+    ret = sysdb_store_user(dom, name, NULL, TEST_UID_BASE + idx, TEST_GID,
+                           NULL, "/home/user", shell, NULL, NULL, NULL,
+                           600, now);
+    assert_int_equal(ret, EOK);
+
+    talloc_free(name);
+}
+
+static int lru_test_setup(void **state)
+{
+    struct lru_test_ctx *test_ctx;
+    errno_t ret;
+    int i;
+
+    test_ctx = talloc_zero(NULL, struct lru_test_ctx);
+    assert_non_null(test_ctx);
+
+    test_ctx->tctx = create_dom_test_ctx(test_ctx, TESTS_PATH, TEST_CONF_DB,
+                                         TEST_DOM_NAME, TEST_ID_PROVIDER,
+                                         NULL);
+    assert_non_null(test_ctx->tctx);
+
+    for (i = 0; i < TEST_USERS; i++) {
+        store_user(test_ctx->tctx->dom, i, "/bin/sh", 0);
+    }
+
+    ret = sysdb_store_group(test_ctx->tctx->dom, "group", TEST_GID, NULL,
+                            600, 0);
+    assert_int_equal(ret, EOK);
+
+    ret = resp_lru_init(test_ctx, 1000, 60, &test_ctx->lru);
+    assert_int_equal(ret, EOK);
+    assert_non_null(test_ctx->lru);
+
+    sysdb_searches = 0;
+
+    *state = test_ctx;
+    return 0;
+}
+
+static int lru_test_teardown(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+
+    talloc_free(test_ctx);
+    return 0;
+}
+
+static const char *lookup_shell(struct lru_test_ctx *test_ctx,
+                                struct resp_lru *lru, const char *name)
+{
+    struct ldb_result *res;
+    const char *shell;
+    errno_t ret;
+
+    ret = resp_lru_getpwnam(test_ctx, lru, test_ctx->tctx->dom, name, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+
+    shell = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_SHELL, NULL);
+    assert_non_null(shell);
+
+    return shell;
+}
+
+static void test_resp_lru_hit(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+    struct resp_lru_stats stats;
+    struct ldb_result *res;
+    errno_t ret;
+
+    assert_string_equal(lookup_shell(test_ctx, test_ctx->lru, "user1"),
+                        "/bin/sh");
+    assert_string_equal(lookup_shell(test_ctx, test_ctx->lru, "user1"),
+                        "/bin/sh");
+    assert_int_equal(sysdb_searches, 1);
+
+    /* The result is a copy which can be modified by the caller */
+    ret = resp_lru_getpwuid(test_ctx, test_ctx->lru, test_ctx->tctx->dom,
+                            TEST_UID_BASE + 1, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    ldb_msg_remove_attr(res->msgs[0], SYSDB_SHELL);
+    talloc_free(res);
+
+    ret = resp_lru_getpwuid(test_ctx, test_ctx->lru, test_ctx->tctx->dom,
+                            TEST_UID_BASE + 1, &res);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(ldb_msg_find_attr_as_string(res->msgs[0],
+                                                    SYSDB_SHELL, NULL),
+                        "/bin/sh");
+    assert_int_equal(sysdb_searches, 2);
+
+    ret = resp_lru_getgrgid(test_ctx, test_ctx->lru, test_ctx->tctx->dom,
+                            TEST_GID, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(res->count, 1);
+    ret = resp_lru_getgrgid(test_ctx, test_ctx->lru, test_ctx->tctx->dom,
+                            TEST_GID, &res);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(sysdb_searches, 3);
+
+    resp_lru_get_stats(test_ctx->lru, &stats);
+    assert_int_equal(stats.hits, 3);
+    assert_int_equal(stats.misses, 3);
+    assert_int_equal(stats.count, 3);
+}
+
+static void test_resp_lru_missing(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+    struct ldb_result *res;
+    errno_t ret;
+    int i;
+
+    /* Misses are not cached, the negative cache is responsible for them */
+    for (i = 0; i < 2; i++) {
+        ret = resp_lru_getpwnam(test_ctx, test_ctx->lru, test_ctx->tctx->dom,
+                                "no_such_user", &res);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(res->count, 0);
+    }
+    assert_int_equal(sysdb_searches, 2);
+}
+
+static void test_resp_lru_invalidate(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+
+    assert_string_equal(lookup_shell(test_ctx, test_ctx->lru, "user2"),
+                        "/bin/sh");
+
+    store_user(test_ctx->tctx->dom, 2, "/bin/ksh", 0);
+
+    /* Not invalidated yet */
+    assert_string_equal(lookup_shell(test_ctx, test_ctx->lru, "user2"),
+                        "/bin/sh");
+
+    /* Other domains are not affected */
+    resp_lru_invalidate(test_ctx->lru, "other_domain");
+    assert_string_equal(lookup_shell(test_ctx, test_ctx->lru, "user2"),
+                        "/bin/sh");
+    assert_int_equal(sysdb_searches, 1);
+
+    resp_lru_invalidate(test_ctx->lru, TEST_DOM_NAME);
+    assert_string_equal(lookup_shell(test_ctx, test_ctx->lru, "user2"),
+                        "/bin/ksh");
+    assert_int_equal(sysdb_searches, 2);
+
+    resp_lru_invalidate(test_ctx->lru, NULL);
+    assert_string_equal(lookup_shell(test_ctx, test_ctx->lru, "user2"),
+                        "/bin/ksh");
+    assert_int_equal(sysdb_searches, 3);
+}
+
+static void test_resp_lru_expired(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+
+    /* The entry expired in the cache, it must be read again after the
+     * caller refreshes it */
+    store_user(test_ctx->tctx->dom, 3, "/bin/sh", time(NULL) - 1000);
+
+    lookup_shell(test_ctx, test_ctx->lru, "user3");
+    lookup_shell(test_ctx, test_ctx->lru, "user3");
+    assert_int_equal(sysdb_searches, 2);
+}
+
+static void test_resp_lru_evict(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+    struct resp_lru_stats stats;
+    struct resp_lru *lru;
+    errno_t ret;
+
+    ret = resp_lru_init(test_ctx, 2, 60, &lru);
+    assert_int_equal(ret, EOK);
+
+    lookup_shell(test_ctx, lru, "user1");
+    lookup_shell(test_ctx, lru, "user2");
+    /* user1 becomes the most recently used entry */
+    lookup_shell(test_ctx, lru, "user1");
+    lookup_shell(test_ctx, lru, "user3");
+    assert_int_equal(sysdb_searches, 3);
+
+    resp_lru_get_stats(lru, &stats);
+    assert_int_equal(stats.count, 2);
+
+    lookup_shell(test_ctx, lru, "user1");
+    assert_int_equal(sysdb_searches, 3);
+
+    lookup_shell(test_ctx, lru, "user2");
+    assert_int_equal(sysdb_searches, 4);
+}
+
+static void test_resp_lru_disabled(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+    struct resp_lru *lru;
+    errno_t ret;
+
+    ret = resp_lru_init(test_ctx, 0, 60, &lru);
+    assert_int_equal(ret, EOK);
+    assert_null(lru);
+
+    lookup_shell(test_ctx, lru, "user1");
+    lookup_shell(test_ctx, lru, "user1");
+    assert_int_equal(sysdb_searches, 2);
+}
+
+static void run_lookups(struct lru_test_ctx *test_ctx, struct resp_lru *lru,
+                        int lookups)
+{
+    struct ldb_result *res;
+    TALLOC_CTX *tmp_ctx;
+    errno_t ret;
+    int i;
+
+    for (i = 0; i < lookups; i++) {
+        tmp_ctx = talloc_new(NULL);
+        assert_non_null(tmp_ctx);
+
+        ret = resp_lru_getpwuid(tmp_ctx, lru, test_ctx->tctx->dom,
+                                TEST_UID_BASE + (i % TEST_USERS), &res);
+        assert_int_equal(ret, EOK);
+        assert_int_equal(res->count, 1);
+
+        talloc_free(tmp_ctx);
+    }
+}
+
+/* Repeated lookups of a hot set of users reach the cache database once
+ * per user */
+static void test_resp_lru_hot_set(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+
+    run_lookups(test_ctx, NULL, TEST_USERS * 10);
+    assert_int_equal(sysdb_searches, TEST_USERS * 10);
+
+    sysdb_searches = 0;
+    run_lookups(test_ctx, test_ctx->lru, TEST_USERS * 10);
+    assert_int_equal(sysdb_searches, TEST_USERS);
+}
+
+static double time_lookups(struct lru_test_ctx *test_ctx,
+                           struct resp_lru *lru)
+{
+    struct timeval start;
+    struct timeval end;
+
+    gettimeofday(&start, NULL);
+    run_lookups(test_ctx, lru, BENCH_LOOKUPS);
+    gettimeofday(&end, NULL);
+
+    return (end.tv_sec - start.tv_sec) * 1000.0
+                + (end.tv_usec - start.tv_usec) / 1000.0;
+}
+
+/* Not a functional test, prints how long 10000 lookups of a hot set of
+ * users take with and without the LRU */
+static void test_resp_lru_benchmark(void **state)
+{
+    struct lru_test_ctx *test_ctx = talloc_get_type(*state,
+                                                    struct lru_test_ctx);
+    double msec;
+
+    msec = time_lookups(test_ctx, NULL);
+    printf("%d lookups without LRU: %d ldb searches, %.2f ms\n",
+           BENCH_LOOKUPS, sysdb_searches, msec);
+
+    sysdb_searches = 0;
+    msec = time_lookups(test_ctx, test_ctx->lru);
+    printf("%d lookups with LRU: %d ldb searches, %.2f ms\n",
+           BENCH_LOOKUPS, sysdb_searches, msec);
+}
+
+int main(int argc, const char *argv[])
+{
+    int rv;
+    int no_cleanup = 0;
+    int benchmark = 0;
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        {"no-cleanup", 'n', POPT_ARG_NONE, &no_cleanup, 0,
+         _("Do not delete the test database after a test run"), NULL },
+        {"benchmark", 'b', POPT_ARG_NONE, &benchmark, 0,
+         _("Also time the lookups with and without the LRU"), NULL },
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_resp_lru_hit,
+                                        lru_test_setup, lru_test_teardown),
+        cmocka_unit_test_setup_teardown(test_resp_lru_missing,
+                                        lru_test_setup, lru_test_teardown),
+        cmocka_unit_test_setup_teardown(test_resp_lru_invalidate,
+                                        lru_test_setup, lru_test_teardown),
+        cmocka_unit_test_setup_teardown(test_resp_lru_expired,
+                                        lru_test_setup, lru_test_teardown),
+        cmocka_unit_test_setup_teardown(test_resp_lru_evict,
+                                        lru_test_setup, lru_test_teardown),
+        cmocka_unit_test_setup_teardown(test_resp_lru_disabled,
+                                        lru_test_setup, lru_test_teardown),
+        cmocka_unit_test_setup_teardown(test_resp_lru_hot_set,
+                                        lru_test_setup, lru_test_teardown),
+    };
+
+    /* too slow and too noisy for every make check */
+    const struct CMUnitTest bench_tests[] = {
+        cmocka_unit_test_setup_teardown(test_resp_lru_benchmark,
+                                        lru_test_setup, lru_test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can deside if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    /* Even though normally the tests should clean up after themselves
+     * they might not after a failed run. Remove the old db to be sure */
+    tests_set_cwd();
+    test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_SYSDB_FILE);
+    test_dom_suite_setup(TESTS_PATH);
+
+    rv = cmocka_run_group_tests(tests, NULL, NULL);
+    if (rv == 0 && benchmark) {
+        rv = cmocka_run_group_tests(bench_tests, NULL, NULL);
+    }
+    if (rv == 0 && !no_cleanup) {
+        test_dom_suite_cleanup(TESTS_PATH, TEST_CONF_DB, TEST_SYSDB_FILE);
+    }
+    return rv;
+}
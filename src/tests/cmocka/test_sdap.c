@@ -941,6 +941,80 @@ static void test_sdap_inherit_option_user(void **state)
     talloc_free(test_ctx->child_sdap_opts->user_map[SDAP_AT_USER_PRINC].name);
 }
 
+static void test_sdap_rootdse_capabilities_changed(void **state)
+{
+    TALLOC_CTX *tmp_ctx;
+    struct sysdb_attrs *old_rootdse;
+    struct sysdb_attrs *new_rootdse;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    old_rootdse = sysdb_new_attrs(tmp_ctx);
+    assert_non_null(old_rootdse);
+    new_rootdse = sysdb_new_attrs(tmp_ctx);
+    assert_non_null(new_rootdse);
+
+    ret = sysdb_attrs_add_string(old_rootdse, "supportedControl", "1.2.3");
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_string(old_rootdse, "supportedControl", "1.2.4");
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_string(old_rootdse, SDAP_IPA_LAST_USN, "100");
+    assert_int_equal(ret, EOK);
+
+    /* order of values does not matter, USN changes are not capabilities */
+    ret = sysdb_attrs_add_string(new_rootdse, "supportedControl", "1.2.4");
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_string(new_rootdse, "supportedControl", "1.2.3");
+    assert_int_equal(ret, EOK);
+    ret = sysdb_attrs_add_string(new_rootdse, SDAP_IPA_LAST_USN, "200");
+    assert_int_equal(ret, EOK);
+    assert_false(sdap_rootdse_capabilities_changed(old_rootdse, new_rootdse));
+
+    /* new capability */
+    ret = sysdb_attrs_add_string(new_rootdse, "supportedSASLMechanisms",
+                                 "GSSAPI");
+    assert_int_equal(ret, EOK);
+    assert_true(sdap_rootdse_capabilities_changed(old_rootdse, new_rootdse));
+    assert_true(sdap_rootdse_capabilities_changed(new_rootdse, old_rootdse));
+
+    talloc_free(tmp_ctx);
+}
+
+static void test_sdap_server_reinitialized_cached(void **state)
+{
+    struct sdap_server_opts current = { 0 };
+    struct sdap_server_opts srv_opts = { 0 };
+
+    current.server_id = discard_const("ldap://ldap.example.com");
+    current.supports_usn = true;
+    current.last_usn = 500;
+
+    srv_opts.server_id = discard_const("ldap://ldap.example.com");
+    srv_opts.supports_usn = true;
+    srv_opts.last_usn = 100;
+
+    /* reconnect using a cached rootDSE, its USN is older than the one
+     * raised by enumeration in the meantime */
+    srv_opts.last_usn_cached = true;
+    assert_false(sdap_server_reinitialized(&current, &srv_opts));
+
+    /* the USN read from the server went backwards */
+    srv_opts.last_usn_cached = false;
+    assert_true(sdap_server_reinitialized(&current, &srv_opts));
+
+    srv_opts.last_usn = 600;
+    assert_false(sdap_server_reinitialized(&current, &srv_opts));
+
+    /* another server */
+    srv_opts.last_usn = 100;
+    srv_opts.server_id = discard_const("ldap://ldap2.example.com");
+    assert_false(sdap_server_reinitialized(&current, &srv_opts));
+
+    assert_false(sdap_server_reinitialized(NULL, &srv_opts));
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -1008,6 +1082,10 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_sdap_inherit_option_user,
                                         test_sdap_inherit_option_setup,
                                         test_sdap_inherit_option_teardown),
+
+        /* rootDSE cache tests */
+        cmocka_unit_test(test_sdap_rootdse_capabilities_changed),
+        cmocka_unit_test(test_sdap_server_reinitialized_cached),
     };
 
     /* Set debug level to invalid value so we can deside if -d 0 was used. */
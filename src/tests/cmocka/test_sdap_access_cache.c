@@ -0,0 +1,300 @@
+/*
+    SSSD
+
+    LDAP access control decision cache tests
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <cmocka.h>
+#include <popt.h>
+
+#include "tests/cmocka/common_mock.h"
+#include "providers/ldap/ldap_opts.h"
+#include "providers/ldap/sdap_access.h"
+
+struct access_cache_test_ctx {
+    struct dp_option *opts;
+    struct sss_domain_info *dom;
+    struct sdap_access_cache *cache;
+};
+
+static bool test_offline;
+
+bool be_is_offline(struct be_ctx *ctx)
+{
+    return test_offline;
+}
+
+static void access_cache_test_init(struct access_cache_test_ctx *test_ctx,
+                                   int timeout, int lockout_timeout)
+{
+    errno_t ret;
+
+    ret = dp_opt_set_int(test_ctx->opts, SDAP_ACCESS_CACHE_TIMEOUT, timeout);
+    assert_int_equal(ret, EOK);
+    ret = dp_opt_set_int(test_ctx->opts, SDAP_ACCESS_LOCKOUT_CACHE_TIMEOUT,
+                         lockout_timeout);
+    assert_int_equal(ret, EOK);
+
+    ret = sdap_access_cache_init(test_ctx, test_ctx->opts, &test_ctx->cache);
+    assert_int_equal(ret, EOK);
+}
+
+static int access_cache_test_setup(void **state)
+{
+    struct access_cache_test_ctx *test_ctx;
+    errno_t ret;
+
+    assert_true(leak_check_setup());
+
+    test_ctx = talloc_zero(global_talloc_context,
+                           struct access_cache_test_ctx);
+    assert_non_null(test_ctx);
+
+    ret = dp_copy_defaults(test_ctx, default_basic_opts,
+                           SDAP_OPTS_BASIC, &test_ctx->opts);
+    assert_int_equal(ret, EOK);
+
+    test_ctx->dom = talloc_zero(test_ctx, struct sss_domain_info);
+    assert_non_null(test_ctx->dom);
+    test_ctx->dom->name = talloc_strdup(test_ctx->dom, "LDAP");
+    assert_non_null(test_ctx->dom->name);
+    test_ctx->dom->case_sensitive = true;
+
+    test_offline = false;
+
+    check_leaks_push(test_ctx);
+    *state = test_ctx;
+    return 0;
+}
+
+static int access_cache_test_teardown(void **state)
+{
+    struct access_cache_test_ctx *test_ctx =
+            talloc_get_type_abort(*state, struct access_cache_test_ctx);
+
+    talloc_zfree(test_ctx->cache);
+    assert_true(check_leaks_pop(test_ctx));
+    talloc_free(test_ctx);
+    assert_true(leak_check_teardown());
+    return 0;
+}
+
+void test_access_cache_disabled(void **state)
+{
+    struct access_cache_test_ctx *test_ctx =
+            talloc_get_type_abort(*state, struct access_cache_test_ctx);
+    errno_t ret;
+
+    access_cache_test_init(test_ctx, 0, 0);
+    assert_null(test_ctx->cache);
+
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "alice", LDAP_ACCESS_FILTER, EOK);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ENOENT);
+}
+
+void test_access_cache_hit(void **state)
+{
+    struct access_cache_test_ctx *test_ctx =
+            talloc_get_type_abort(*state, struct access_cache_test_ctx);
+    errno_t ret;
+
+    access_cache_test_init(test_ctx, 60, 0);
+    assert_non_null(test_ctx->cache);
+
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ENOENT);
+
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "alice", LDAP_ACCESS_FILTER, EOK);
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "bob", LDAP_ACCESS_FILTER, ERR_ACCESS_DENIED);
+    /* errors are not decisions */
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "carol", LDAP_ACCESS_FILTER, EIO);
+
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, EOK);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "bob", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ERR_ACCESS_DENIED);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "carol", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ENOENT);
+
+    /* the lockout decisions are not cached */
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "alice", LDAP_ACCESS_PPOLICY, EOK);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_PPOLICY);
+    assert_int_equal(ret, ENOENT);
+
+    /* a decision is replaced by the next one */
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "alice", LDAP_ACCESS_FILTER, ERR_ACCESS_DENIED);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ERR_ACCESS_DENIED);
+}
+
+void test_access_cache_case(void **state)
+{
+    struct access_cache_test_ctx *test_ctx =
+            talloc_get_type_abort(*state, struct access_cache_test_ctx);
+    errno_t ret;
+
+    access_cache_test_init(test_ctx, 60, 0);
+
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "Alice", LDAP_ACCESS_FILTER, EOK);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ENOENT);
+
+    test_ctx->dom->case_sensitive = false;
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "Alice", LDAP_ACCESS_FILTER, ERR_ACCESS_DENIED);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ERR_ACCESS_DENIED);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "ALICE", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ERR_ACCESS_DENIED);
+}
+
+void test_access_cache_offline(void **state)
+{
+    struct access_cache_test_ctx *test_ctx =
+            talloc_get_type_abort(*state, struct access_cache_test_ctx);
+    errno_t ret;
+
+    access_cache_test_init(test_ctx, 60, 60);
+
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "alice", LDAP_ACCESS_FILTER, ERR_ACCESS_DENIED);
+
+    /* offline the check must not be answered from memory */
+    test_offline = true;
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ENOENT);
+
+    /* and the offline decisions are not kept */
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "bob", LDAP_ACCESS_LOCKOUT, EOK);
+
+    test_offline = false;
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "bob", LDAP_ACCESS_LOCKOUT);
+    assert_int_equal(ret, ENOENT);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, ERR_ACCESS_DENIED);
+}
+
+void test_access_cache_expire(void **state)
+{
+    struct access_cache_test_ctx *test_ctx =
+            talloc_get_type_abort(*state, struct access_cache_test_ctx);
+    errno_t ret;
+
+    /* lockout decisions have their own, shorter lifetime */
+    access_cache_test_init(test_ctx, 60, 1);
+
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "alice", LDAP_ACCESS_FILTER, EOK);
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "alice", LDAP_ACCESS_LOCKOUT, EOK);
+    sdap_access_cache_store(test_ctx->cache, NULL, test_ctx->dom,
+                            "alice", LDAP_ACCESS_PPOLICY, ERR_ACCESS_DENIED);
+
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_LOCKOUT);
+    assert_int_equal(ret, EOK);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_PPOLICY);
+    assert_int_equal(ret, ERR_ACCESS_DENIED);
+
+    sleep(2);
+
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_LOCKOUT);
+    assert_int_equal(ret, ENOENT);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_PPOLICY);
+    assert_int_equal(ret, ENOENT);
+    ret = sdap_access_cache_lookup(test_ctx->cache, NULL, test_ctx->dom,
+                                   "alice", LDAP_ACCESS_FILTER);
+    assert_int_equal(ret, EOK);
+}
+
+int main(int argc, const char *argv[])
+{
+    poptContext pc;
+    int opt;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        SSSD_DEBUG_OPTS
+        POPT_TABLEEND
+    };
+
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_access_cache_disabled,
+                                        access_cache_test_setup,
+                                        access_cache_test_teardown),
+        cmocka_unit_test_setup_teardown(test_access_cache_hit,
+                                        access_cache_test_setup,
+                                        access_cache_test_teardown),
+        cmocka_unit_test_setup_teardown(test_access_cache_case,
+                                        access_cache_test_setup,
+                                        access_cache_test_teardown),
+        cmocka_unit_test_setup_teardown(test_access_cache_offline,
+                                        access_cache_test_setup,
+                                        access_cache_test_teardown),
+        cmocka_unit_test_setup_teardown(test_access_cache_expire,
+                                        access_cache_test_setup,
+                                        access_cache_test_teardown),
+    };
+
+    /* Set debug level to invalid value so we can deside if -d 0 was used. */
+    debug_level = SSSDBG_INVALID;
+
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((opt = poptGetNextOpt(pc)) != -1) {
+        switch(opt) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(opt));
+            poptPrintUsage(pc, stderr, 0);
+            return 1;
+        }
+    }
+    poptFreeContext(pc);
+
+    DEBUG_CLI_INIT(debug_level);
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -428,6 +428,126 @@ void test_sysdb_invalidate_overrides(void **state)
     assert_null(ldb_msg_find_attr_as_string(msg, SYSDB_OVERRIDE_DN, NULL));
 }
 
+#define TEST_GROUP_NAME "test_group"
+#define TEST_GROUP_GID 7000
+#define TEST_NESTED_GROUP_NAME "test_nested_group"
+#define TEST_NESTED_GROUP_GID 7001
+#define TEST_MEMBER_COUNT 40
+
+void test_sysdb_add_group_member_overrides_bulk(void **state)
+{
+    int ret;
+    size_t c;
+    char *name;
+    char *anchor;
+    struct ldb_message *msg;
+    struct ldb_message_element *el;
+    struct sysdb_attrs *attrs;
+    const char *group_attrs[] = { SYSDB_NAME, SYSDB_MEMBER, NULL };
+    bool found_override = false;
+    bool found_orig = false;
+
+    struct sysdb_test_ctx *test_ctx = talloc_get_type_abort(*state,
+                                                         struct sysdb_test_ctx);
+
+    test_ctx->domain->mpg = false;
+    test_ctx->domain->has_views = true;
+    test_ctx->domain->view_name = discard_const(TEST_VIEW_NAME);
+
+    ret = sss_names_init(test_ctx, test_ctx->confdb, test_ctx->domain->name,
+                         &test_ctx->domain->names);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_update_view_name(test_ctx->domain->sysdb, TEST_VIEW_NAME);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_group(test_ctx->domain, TEST_GROUP_NAME, TEST_GROUP_GID,
+                            NULL, 0, 0);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_store_group(test_ctx->domain, TEST_NESTED_GROUP_NAME,
+                            TEST_NESTED_GROUP_GID, NULL, 0, 0);
+    assert_int_equal(ret, EOK);
+
+    /* Every other member has an override with a different name */
+    for (c = 0; c < TEST_MEMBER_COUNT; c++) {
+        name = talloc_asprintf(test_ctx, "member_%zu", c);
+        assert_non_null(name);
+
+        ret = sysdb_store_user(test_ctx->domain, name, NULL,
+                               TEST_USER_UID + c, TEST_USER_GID, NULL,
+                               NULL, NULL, NULL, NULL, NULL, 0, 0);
+        assert_int_equal(ret, EOK);
+
+        ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, name,
+                                        NULL, &msg);
+        assert_int_equal(ret, EOK);
+
+        attrs = NULL;
+        if (c % 2 == 0) {
+            attrs = sysdb_new_attrs(test_ctx);
+            assert_non_null(attrs);
+
+            anchor = talloc_asprintf(attrs, TEST_ANCHOR_PREFIX "%zu", c);
+            assert_non_null(anchor);
+            ret = sysdb_attrs_add_string(attrs, SYSDB_OVERRIDE_ANCHOR_UUID,
+                                         anchor);
+            assert_int_equal(ret, EOK);
+
+            ret = sysdb_attrs_add_string(attrs, SYSDB_NAME,
+                                         talloc_asprintf(attrs, "ov_%s", name));
+            assert_int_equal(ret, EOK);
+        }
+
+        ret = sysdb_store_override(test_ctx->domain, TEST_VIEW_NAME,
+                                   SYSDB_MEMBER_USER, attrs, msg->dn);
+        assert_int_equal(ret, EOK);
+
+        ret = sysdb_add_group_member(test_ctx->domain, TEST_GROUP_NAME, name,
+                                     SYSDB_MEMBER_USER, false);
+        assert_int_equal(ret, EOK);
+    }
+
+    /* A member of a nested group must not be listed */
+    ret = sysdb_store_user(test_ctx->domain, TEST_USER_NAME, NULL,
+                           TEST_USER_UID + TEST_MEMBER_COUNT, TEST_USER_GID,
+                           NULL, NULL, NULL, NULL, NULL, NULL, 0, 0);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_add_group_member(test_ctx->domain, TEST_NESTED_GROUP_NAME,
+                                 TEST_USER_NAME, SYSDB_MEMBER_USER, false);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_add_group_member(test_ctx->domain, TEST_GROUP_NAME,
+                                 TEST_NESTED_GROUP_NAME, SYSDB_MEMBER_GROUP,
+                                 false);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_search_group_by_name(test_ctx, test_ctx->domain,
+                                     TEST_GROUP_NAME, group_attrs, &msg);
+    assert_int_equal(ret, EOK);
+
+    ret = sysdb_add_group_member_overrides(test_ctx->domain, msg);
+    assert_int_equal(ret, EOK);
+
+    el = ldb_msg_find_element(msg, OVERRIDE_PREFIX SYSDB_MEMBERUID);
+    assert_non_null(el);
+    assert_int_equal(el->num_values, TEST_MEMBER_COUNT);
+
+    for (c = 0; c < el->num_values; c++) {
+        assert_int_not_equal(ldb_val_string_cmp(&el->values[c],
+                                                TEST_USER_NAME), 0);
+        if (ldb_val_string_cmp(&el->values[c], "ov_member_0") == 0) {
+            found_override = true;
+        }
+        if (ldb_val_string_cmp(&el->values[c], "member_1") == 0) {
+            found_orig = true;
+        }
+    }
+    assert_true(found_override);
+    assert_true(found_orig);
+}
+
 int main(int argc, const char *argv[])
 {
     int rv;
@@ -453,6 +573,8 @@ int main(int argc, const char *argv[])
                                         test_sysdb_setup, test_sysdb_teardown),
         cmocka_unit_test_setup_teardown(test_sysdb_invalidate_overrides,
                                         test_sysdb_setup, test_sysdb_teardown),
+        cmocka_unit_test_setup_teardown(test_sysdb_add_group_member_overrides_bulk,
+                                        test_sysdb_setup, test_sysdb_teardown),
     };
 
     /* Set debug level to invalid value so we can deside if -d 0 was used. */
@@ -23,9 +23,13 @@
 #define _GNU_SOURCE
 #include <stdio.h>
 #include <popt.h>
+#include <security/pam_appl.h>
 
 #include "tests/cmocka/common_mock.h"
 #include "util/sss_nss.h"
+#include "util/sss_stats.h"
+#include "providers/data_provider.h"
+#include "providers/dp_fastpath.h"
 #include "test_utils.h"
 
 #define TESTS_PATH "tests_utils"
@@ -1081,6 +1085,255 @@ void test_fix_domain_in_name_list(void **state)
     talloc_free(dom);
 }
 
+void test_sss_stats_counters(void **state)
+{
+    char *text;
+    int ret;
+
+    sss_stats_reset();
+
+    sss_stats_count("test.counter", 3);
+    sss_stats_count("test.counter", 2);
+    sss_stats_gauge_add("test.gauge", 2);
+    sss_stats_gauge_add("test.gauge", -1);
+
+    assert_int_equal(sss_stats_get_value("test.counter"), 5);
+    assert_int_equal(sss_stats_get_value("test.gauge"), 1);
+    assert_int_equal(sss_stats_get_value("test.missing"), 0);
+
+    /* the name is already used by a counter */
+    sss_stats_gauge_add("test.counter", 10);
+    assert_int_equal(sss_stats_get_value("test.counter"), 5);
+
+    ret = sss_stats_dump(NULL, &text);
+    assert_int_equal(ret, EOK);
+    assert_string_equal(text, "counter test.counter 5\n"
+                              "gauge test.gauge 1\n");
+    talloc_free(text);
+
+    sss_stats_reset();
+    assert_int_equal(sss_stats_get_value("test.counter"), 0);
+}
+
+void test_sss_stats_histogram(void **state)
+{
+    struct sss_stats_summary s;
+    uint64_t i;
+    int ret;
+
+    sss_stats_reset();
+
+    ret = sss_stats_get_summary("test.latency", &s);
+    assert_int_equal(ret, ENOENT);
+
+    for (i = 1; i <= 10000; i++) {
+        sss_stats_record("test.latency", i);
+    }
+
+    ret = sss_stats_get_summary("test.latency", &s);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(s.count, 10000);
+    assert_int_equal(s.sum, 50005000);
+    assert_int_equal(s.min, 1);
+    assert_int_equal(s.max, 10000);
+
+    /* percentiles are exact up to the bucket width of 1/16 */
+    assert_true(s.p50 >= 5000 && s.p50 <= 5000 + 5000 / 16);
+    assert_true(s.p90 >= 9000 && s.p90 <= 9000 + 9000 / 16);
+    assert_true(s.p99 >= 9900 && s.p99 <= 10000);
+    assert_true(s.p999 >= 9990 && s.p999 <= 10000);
+
+    /* small values are exact */
+    sss_stats_record("test.small", 7);
+    sss_stats_record("test.small", 7);
+    ret = sss_stats_get_summary("test.small", &s);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(s.p50, 7);
+    assert_int_equal(s.p999, 7);
+
+    sss_stats_reset();
+}
+
+void test_dp_fastpath_codec(void **state)
+{
+    struct dp_fastpath_account_req ar = { 0x1001, 1, "name=foo", "dom" };
+    struct dp_fastpath_reply reply = { 3, DP_FASTPATH_REPLY_INVALIDATE, 5,
+                                       "error" };
+    struct dp_fastpath_account_req ar2;
+    struct dp_fastpath_reply reply2;
+    struct dp_fastpath_hdr hdr;
+    TALLOC_CTX *tmp_ctx;
+    uint8_t *frame;
+    size_t len;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    ret = dp_fastpath_encode_account_req(tmp_ctx, 7, &ar, &frame, &len);
+    assert_int_equal(ret, EOK);
+
+    ret = dp_fastpath_decode_hdr(frame, DP_FASTPATH_HDR_LEN - 1, &hdr);
+    assert_int_equal(ret, EAGAIN);
+
+    ret = dp_fastpath_decode_hdr(frame, len, &hdr);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(hdr.method, DP_FASTPATH_GET_ACCOUNT_INFO);
+    assert_int_equal(hdr.serial, 7);
+    assert_int_equal(hdr.len, len - DP_FASTPATH_HDR_LEN);
+
+    ret = dp_fastpath_decode_account_req(tmp_ctx, frame + DP_FASTPATH_HDR_LEN,
+                                         hdr.len, &ar2);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(ar2.entry_type, 0x1001);
+    assert_int_equal(ar2.attr_type, 1);
+    assert_string_equal(ar2.filter, "name=foo");
+    assert_string_equal(ar2.domain, "dom");
+
+    /* truncated body */
+    ret = dp_fastpath_decode_account_req(tmp_ctx, frame + DP_FASTPATH_HDR_LEN,
+                                         hdr.len - 1, &ar2);
+    assert_int_equal(ret, EINVAL);
+
+    ret = dp_fastpath_encode_reply(tmp_ctx, 9, &reply, &frame, &len);
+    assert_int_equal(ret, EOK);
+
+    ret = dp_fastpath_decode_hdr(frame, len, &hdr);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(hdr.method, DP_FASTPATH_REPLY);
+
+    ret = dp_fastpath_decode_reply(tmp_ctx, frame + DP_FASTPATH_HDR_LEN,
+                                   hdr.len, &reply2);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(reply2.err_maj, 3);
+    assert_int_equal(reply2.flags, DP_FASTPATH_REPLY_INVALIDATE);
+    assert_int_equal(reply2.err_min, 5);
+    assert_string_equal(reply2.err_msg, "error");
+
+    /* strings must not contain zero bytes */
+    frame[len - 1] = '\0';
+    ret = dp_fastpath_decode_reply(tmp_ctx, frame + DP_FASTPATH_HDR_LEN,
+                                   hdr.len, &reply2);
+    assert_int_equal(ret, EINVAL);
+
+    /* unknown version */
+    frame[4] = 0xff;
+    ret = dp_fastpath_decode_hdr(frame, len, &hdr);
+    assert_int_equal(ret, EBADMSG);
+
+    talloc_free(tmp_ctx);
+}
+
+void test_dp_fastpath_pam_codec(void **state)
+{
+    struct pam_data *pd;
+    struct pam_data *pd2;
+    struct response_data *resp;
+    struct dp_fastpath_hdr hdr;
+    TALLOC_CTX *tmp_ctx;
+    const char *pwd;
+    size_t pwd_len;
+    uint8_t *frame;
+    size_t len;
+    int ret;
+
+    tmp_ctx = talloc_new(NULL);
+    assert_non_null(tmp_ctx);
+
+    pd = create_pam_data(tmp_ctx);
+    assert_non_null(pd);
+    pd->cmd = SSS_PAM_AUTHENTICATE;
+    pd->priv = 1;
+    pd->cli_pid = 42;
+    pd->user = talloc_strdup(pd, "user");
+    pd->domain = talloc_strdup(pd, "dom");
+    pd->service = talloc_strdup(pd, "login");
+    pd->rhost = talloc_strdup(pd, "host");
+    ret = sss_authtok_set_password(pd->authtok, "secret", 0);
+    assert_int_equal(ret, EOK);
+
+    ret = dp_fastpath_encode_pam_req(tmp_ctx, 11, pd, &frame, &len);
+    assert_int_equal(ret, EOK);
+
+    ret = dp_fastpath_decode_hdr(frame, len, &hdr);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(hdr.method, DP_FASTPATH_PAM_HANDLER);
+    assert_int_equal(hdr.serial, 11);
+
+    ret = dp_fastpath_decode_pam_req(tmp_ctx, frame + DP_FASTPATH_HDR_LEN,
+                                     hdr.len, &pd2);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(pd2->cmd, SSS_PAM_AUTHENTICATE);
+    assert_int_equal(pd2->priv, 1);
+    assert_int_equal(pd2->cli_pid, 42);
+    assert_string_equal(pd2->user, "user");
+    assert_string_equal(pd2->domain, "dom");
+    assert_string_equal(pd2->service, "login");
+    /* unset strings are sent as empty ones, like over D-Bus */
+    assert_string_equal(pd2->tty, "");
+    assert_string_equal(pd2->ruser, "");
+    assert_string_equal(pd2->rhost, "host");
+
+    ret = sss_authtok_get_password(pd2->authtok, &pwd, &pwd_len);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(pwd_len, 6);
+    assert_string_equal(pwd, "secret");
+    assert_int_equal(sss_authtok_get_type(pd2->newauthtok),
+                     SSS_AUTHTOK_TYPE_EMPTY);
+
+    /* truncated body */
+    ret = dp_fastpath_decode_pam_req(tmp_ctx, frame + DP_FASTPATH_HDR_LEN,
+                                     hdr.len - 1, &pd2);
+    assert_int_equal(ret, EINVAL);
+
+    /* the user is mandatory */
+    pd->user = NULL;
+    ret = dp_fastpath_encode_pam_req(tmp_ctx, 12, pd, &frame, &len);
+    assert_int_equal(ret, EINVAL);
+
+    pd->pam_status = PAM_AUTH_ERR;
+    ret = pam_add_response(pd, SSS_PAM_USER_INFO, 3, (const uint8_t *)"a\0b");
+    assert_int_equal(ret, EOK);
+    ret = pam_add_response(pd, SSS_PAM_DOMAIN_NAME, 4,
+                           (const uint8_t *)"dom");
+    assert_int_equal(ret, EOK);
+
+    ret = dp_fastpath_encode_pam_reply(tmp_ctx, 13, pd, &frame, &len);
+    assert_int_equal(ret, EOK);
+
+    ret = dp_fastpath_decode_hdr(frame, len, &hdr);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(hdr.method, DP_FASTPATH_PAM_REPLY);
+
+    pd2 = create_pam_data(tmp_ctx);
+    assert_non_null(pd2);
+    ret = dp_fastpath_decode_pam_reply(frame + DP_FASTPATH_HDR_LEN, hdr.len,
+                                       pd2);
+    assert_int_equal(ret, EOK);
+    assert_int_equal(pd2->pam_status, PAM_AUTH_ERR);
+
+    /* the responses end up in the same order as with
+     * dp_unpack_pam_response() */
+    resp = pd2->resp_list;
+    assert_non_null(resp);
+    assert_int_equal(resp->type, SSS_PAM_USER_INFO);
+    assert_int_equal(resp->len, 3);
+    assert_memory_equal(resp->data, "a\0b", 3);
+    resp = resp->next;
+    assert_non_null(resp);
+    assert_int_equal(resp->type, SSS_PAM_DOMAIN_NAME);
+    assert_int_equal(resp->len, 4);
+    assert_string_equal((const char *)resp->data, "dom");
+    assert_null(resp->next);
+
+    /* truncated body */
+    ret = dp_fastpath_decode_pam_reply(frame + DP_FASTPATH_HDR_LEN,
+                                       hdr.len - 1, pd2);
+    assert_int_equal(ret, EINVAL);
+
+    talloc_free(tmp_ctx);
+}
+
 int main(int argc, const char *argv[])
 {
     poptContext pc;
@@ -1136,6 +1389,10 @@ int main(int argc, const char *argv[])
         cmocka_unit_test_setup_teardown(test_fix_domain_in_name_list,
                                         confdb_test_setup,
                                         confdb_test_teardown),
+        cmocka_unit_test(test_sss_stats_counters),
+        cmocka_unit_test(test_sss_stats_histogram),
+        cmocka_unit_test(test_dp_fastpath_codec),
+        cmocka_unit_test(test_dp_fastpath_pam_codec),
     };
 
     /* Set debug level to invalid value so we can deside if -d 0 was used. */
@@ -651,6 +651,159 @@ START_TEST(test_debug_is_set_false)
 }
 END_TEST
 
+static char *test_helper_read_file(TALLOC_CTX *mem_ctx, FILE *file)
+{
+    char *content;
+    long filesize;
+    size_t fsize;
+
+    fail_if(fseek(file, 0, SEEK_END) == -1, "fseek failed");
+    filesize = ftell(file);
+    fail_if(filesize == -1, "ftell failed");
+    rewind(file);
+
+    content = talloc_array(mem_ctx, char, filesize + 1);
+    fail_if(content == NULL, "talloc_array failed");
+    fsize = fread(content, sizeof(char), filesize, file);
+    fail_unless(fsize == filesize, "fread failed");
+    content[fsize] = '\0';
+
+    return content;
+}
+
+START_TEST(test_debug_ring)
+{
+    TALLOC_CTX *tmp_ctx;
+    char filename[24] = {'\0'};
+    char filename_copy[24] = {'\0'};
+    mode_t old_umask;
+    FILE *file;
+    char *content;
+    char *expected;
+    char *long_str;
+    int fd;
+    int ret;
+    int i;
+
+    tmp_ctx = talloc_new(NULL);
+    fail_if(tmp_ctx == NULL, "talloc_new failed");
+
+    strncpy(filename, "sssd_debug_tests.XXXXXX", 24);
+
+    old_umask = umask(077);
+    fd = mkstemp(filename);
+    umask(old_umask);
+    fail_if(fd == -1, "mkstemp failed");
+
+    file = fdopen(fd, "r");
+    fail_if(file == NULL, "fdopen failed");
+
+    ret = set_debug_file_from_fd(fd);
+    fail_unless(ret == EOK, "set_debug_file_from_fd failed");
+
+    debug_timestamps = 0;
+    debug_microseconds = 0;
+    debug_to_file = 1;
+    debug_prg_name = "sssd";
+    debug_level = SSSDBG_OP_FAILURE;
+    debug_ring_level = SSSDBG_TRACE_FUNC;
+
+    ret = debug_ring_init(1024);
+    fail_unless(ret == EINVAL, "Too small buffer accepted");
+
+    ret = debug_ring_init(16 * 1024);
+    fail_unless(ret == EOK, "debug_ring_init failed");
+
+    DEBUG(SSSDBG_OP_FAILURE, "buffered message\n");
+    DEBUG(SSSDBG_TRACE_FUNC, "trace message\n");
+    DEBUG(SSSDBG_TRACE_ALL, "ignored message\n");
+
+    content = test_helper_read_file(tmp_ctx, file);
+    fail_unless(content[0] == '\0', "Message written without flush");
+
+    debug_ring_flush();
+    content = test_helper_read_file(tmp_ctx, file);
+    fail_unless(strcmp(content, "[sssd] [test_debug_ring] (0x0040): "
+                                "buffered message\n") == 0,
+                "Unexpected log content [%s]", content);
+
+    /* critical messages are written immediately */
+    DEBUG(SSSDBG_CRIT_FAILURE, "critical message\n");
+    content = test_helper_read_file(tmp_ctx, file);
+    fail_if(strstr(content, "critical message") == NULL,
+            "Critical message was not written");
+    fail_if(strstr(content, "trace message") != NULL,
+            "Trace message was written");
+
+    debug_ring_dump("test");
+    content = test_helper_read_file(tmp_ctx, file);
+    fail_if(strstr(content, "(0x0400): trace message\n") == NULL,
+            "Trace message missing in the dump");
+    fail_if(strstr(content, "ignored message") != NULL,
+            "Message of an unset level was kept");
+
+    /* the arguments are stored and formatted only when dumped */
+    strncpy(filename_copy, filename, 24);
+    DEBUG(SSSDBG_TRACE_FUNC, "args [%d][%5u][%-4s][%zu][%#.4x][%c][%s]\n",
+          -1, 7u, "ab", (size_t)3, 0x40, 'z', filename_copy);
+    memset(filename_copy, 'x', 23);
+    debug_ring_dump("test");
+    content = test_helper_read_file(tmp_ctx, file);
+    expected = talloc_asprintf(tmp_ctx, "[sssd] [test_debug_ring] (0x0400): "
+                               "args [-1][    7][ab  ][3][0x0040][z][%s]\n",
+                               filename);
+    fail_if(expected == NULL, "talloc_asprintf failed");
+    fail_if(strstr(content, expected) == NULL,
+            "Traced message not formatted correctly [%s]", content);
+
+    /* messages are dumped only once */
+    debug_ring_dump("test");
+    fail_unless(strlen(test_helper_read_file(tmp_ctx, file))
+                    == strlen(content),
+                "Messages were dumped again");
+
+    /* short and char values are converted as by printf() */
+    DEBUG(SSSDBG_TRACE_FUNC, "short [%hd][%hu][%hhd][%hhx]\n",
+          70000, 70000u, 300, -1);
+    debug_ring_dump("test");
+    content = test_helper_read_file(tmp_ctx, file);
+    fail_if(strstr(content, "short [4464][4464][44][ff]\n") == NULL,
+            "Short arguments not formatted correctly [%s]", content);
+
+    /* more string arguments than fit into the record, the message is
+     * formatted right away */
+    long_str = talloc_zero_array(tmp_ctx, char, 300);
+    fail_if(long_str == NULL, "talloc_zero_array failed");
+    memset(long_str, 'a', 299);
+    DEBUG(SSSDBG_TRACE_FUNC, "strings [%s][%s][%s][%s][%s][%s][end]\n",
+          long_str, long_str, long_str, long_str, long_str, long_str);
+    debug_ring_dump("test");
+    content = test_helper_read_file(tmp_ctx, file);
+    expected = talloc_asprintf(tmp_ctx, "[%s][end]\n", long_str);
+    fail_if(expected == NULL, "talloc_asprintf failed");
+    fail_if(strstr(content, expected) == NULL,
+            "Message with long strings not formatted correctly [%s]",
+            content);
+
+    /* old messages are overwritten, nothing is lost */
+    for (i = 0; i < 1000; i++) {
+        DEBUG(SSSDBG_OP_FAILURE, "message %d\n", i);
+    }
+    debug_ring_flush();
+    content = test_helper_read_file(tmp_ctx, file);
+    fail_if(strstr(content, "(0x0040): message 0\n") == NULL,
+            "First message is missing");
+    fail_if(strstr(content, "(0x0040): message 999\n") == NULL,
+            "Last message is missing");
+    fail_if(strstr(content, "dropped") != NULL,
+            "Messages were dropped");
+
+    fclose(file);
+    remove(filename);
+    talloc_free(tmp_ctx);
+}
+END_TEST
+
 Suite *debug_suite(void)
 {
     Suite *s = suite_create("debug");
@@ -667,6 +820,7 @@ Suite *debug_suite(void)
     tcase_add_test(tc_debug, test_debug_is_notset_timestamp_microseconds);
     tcase_add_test(tc_debug, test_debug_is_set_true);
     tcase_add_test(tc_debug, test_debug_is_set_false);
+    tcase_add_test(tc_debug, test_debug_ring);
     tcase_set_timeout(tc_debug, 60);
 
     suite_add_tcase(s, tc_debug);
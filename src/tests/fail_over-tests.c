@@ -44,6 +44,7 @@ struct test_ctx {
     struct tevent_context *ev;
     struct resolv_ctx *resolv;
     struct fo_ctx *fo_ctx;
+    struct fo_server *last_server;
     int tasks;
 };
 
@@ -57,7 +58,7 @@ struct task {
 };
 
 static struct test_ctx *
-setup_test(void)
+setup_test_with_policy(enum fo_policy policy, time_t probe_interval)
 {
     struct test_ctx *ctx;
     struct fo_options fopts;
@@ -81,6 +82,8 @@ setup_test(void)
     memset(&fopts, 0, sizeof(fopts));
     fopts.retry_timeout = 30;
     fopts.family_order  = IPV4_FIRST;
+    fopts.policy = policy;
+    fopts.probe_interval = probe_interval;
 
     ctx->fo_ctx = fo_context_init(ctx, &fopts);
     if (ctx->fo_ctx == NULL) {
@@ -91,6 +94,12 @@ setup_test(void)
     return ctx;
 }
 
+static struct test_ctx *
+setup_test(void)
+{
+    return setup_test_with_policy(FO_POLICY_ORDERED, 0);
+}
+
 static void
 test_loop(struct test_ctx *data)
 {
@@ -161,6 +170,7 @@ test_resolve_service_callback(struct tevent_req *req)
     if (recv_status != EOK)
         return;
     fail_if(server == NULL);
+    task->test_ctx->last_server = server;
     port = fo_get_server_port(server);
     fail_if(port != task->port, "%s: Expected port %d, got %d", task->location,
             task->port, port);
@@ -184,12 +194,14 @@ test_resolve_service_callback(struct tevent_req *req)
 }
 
 #define get_request(a, b, c, d, e, f) \
-       _get_request(a, b, c, d, e, f, __location__)
+       _get_request(a, b, c, d, e, f, false, __location__)
+#define get_standby_request(a, b, c, d) \
+       _get_request(a, b, c, d, -1, -1, true, __location__)
 
 static void
 _get_request(struct test_ctx *test_ctx, struct fo_service *service,
              int expected_recv, int expected_port, int new_port_status,
-             int new_server_status, const char *location)
+             int new_server_status, bool standby, const char *location)
 {
     struct tevent_req *req;
     struct task *task;
@@ -205,9 +217,15 @@ _get_request(struct test_ctx *test_ctx, struct fo_service *service,
     task->location = location;
     test_ctx->tasks++;
 
-    req = fo_resolve_service_send(test_ctx, test_ctx->ev,
-                                  test_ctx->resolv,
-                                  test_ctx->fo_ctx, service);
+    if (standby) {
+        req = fo_resolve_standby_service_send(test_ctx, test_ctx->ev,
+                                              test_ctx->resolv,
+                                              test_ctx->fo_ctx, service);
+    } else {
+        req = fo_resolve_service_send(test_ctx, test_ctx->ev,
+                                      test_ctx->resolv,
+                                      test_ctx->fo_ctx, service);
+    }
     fail_if(req == NULL, "%s: fo_resolve_service_send() failed", location);
 
     tevent_req_set_callback(req, test_resolve_service_callback, task);
@@ -257,6 +275,137 @@ START_TEST(test_fo_resolve_service)
 }
 END_TEST
 
+START_TEST(test_fo_latency_policy)
+{
+    struct test_ctx *ctx;
+    struct fo_service *service;
+    struct fo_server *slow;
+    struct fo_server *fast;
+    int i;
+
+    ctx = setup_test_with_policy(FO_POLICY_LATENCY, 0);
+    fail_if(ctx == NULL);
+
+    fail_if(fo_new_service(ctx->fo_ctx, "ldap", NULL, &service) != EOK);
+    fail_if(fo_add_server(service, "localhost", 389, NULL, true) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", 390, NULL, true) != EOK);
+
+    /* Nothing is measured yet, the configured order is used */
+    get_request(ctx, service, EOK, 389, PORT_WORKING, -1);
+    slow = ctx->last_server;
+    fail_if(fo_get_server_rtt(slow) != 0);
+    for (i = 0; i < 3; i++) {
+        fo_set_server_rtt(slow, FO_RTT_OPERATION, 50000);
+    }
+    fail_if(fo_get_server_rtt(slow) != 50000);
+
+    /* The other server was not measured, keep the current one */
+    get_request(ctx, service, EOK, 389, -1, -1);
+
+    get_request(ctx, service, EOK, 389, PORT_NOT_WORKING, -1);
+    get_request(ctx, service, EOK, 390, PORT_WORKING, -1);
+    fast = ctx->last_server;
+    for (i = 0; i < 3; i++) {
+        fo_set_server_rtt(fast, FO_RTT_OPERATION, 10000);
+    }
+    fo_set_port_status(slow, PORT_NEUTRAL);
+
+    /* The current server is the faster one */
+    get_request(ctx, service, EOK, 390, -1, -1);
+
+    /* The current server gets significantly slower, switch */
+    for (i = 0; i < 10; i++) {
+        fo_set_server_rtt(fast, FO_RTT_OPERATION, 500000);
+    }
+    fail_if(fo_get_server_rtt(fast) <= 2 * fo_get_server_rtt(slow));
+    get_request(ctx, service, EOK, 389, PORT_WORKING, -1);
+
+    talloc_free(ctx);
+}
+END_TEST
+
+START_TEST(test_fo_latency_probe)
+{
+    struct test_ctx *ctx;
+    struct fo_service *service;
+    struct fo_server *current;
+    struct fo_server *probed;
+    int i;
+
+    ctx = setup_test_with_policy(FO_POLICY_LATENCY, 2);
+    fail_if(ctx == NULL);
+
+    fail_if(fo_new_service(ctx->fo_ctx, "ldap", NULL, &service) != EOK);
+    fail_if(fo_add_server(service, "localhost", 389, NULL, true) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", 390, NULL, true) != EOK);
+
+    get_request(ctx, service, EOK, 389, PORT_WORKING, -1);
+    current = ctx->last_server;
+    for (i = 0; i < 5; i++) {
+        fo_set_server_rtt(current, FO_RTT_OPERATION, 10000);
+    }
+
+    /* Once the probe interval passes, the other server is tried */
+    sleep(2);
+    get_request(ctx, service, EOK, 390, PORT_WORKING, -1);
+    probed = ctx->last_server;
+
+    /* A single fast sample must not make it the active server */
+    fo_set_server_rtt(probed, FO_RTT_OPERATION, 1000);
+    get_request(ctx, service, EOK, 389, -1, -1);
+    get_request(ctx, service, EOK, 389, -1, -1);
+
+    /* It is switched to once it is consistently faster */
+    for (i = 0; i < 3; i++) {
+        fo_set_server_rtt(probed, FO_RTT_OPERATION, 1000);
+    }
+    get_request(ctx, service, EOK, 390, PORT_WORKING, -1);
+
+    /* and is kept as the active server from now on */
+    get_request(ctx, service, EOK, 390, -1, -1);
+
+    talloc_free(ctx);
+}
+END_TEST
+
+START_TEST(test_fo_resolve_standby)
+{
+    struct test_ctx *ctx;
+    struct fo_service *service;
+    struct fo_server *active;
+
+    ctx = setup_test();
+    fail_if(ctx == NULL);
+
+    fail_if(fo_new_service(ctx->fo_ctx, "ldap", NULL, &service) != EOK);
+    fail_if(fo_add_server(service, "localhost", 389, NULL, true) != EOK);
+    fail_if(fo_add_server(service, "127.0.0.1", 390, NULL, true) != EOK);
+
+    /* There is no active server to stand by for yet */
+    get_standby_request(ctx, service, ENOENT, 0);
+
+    get_request(ctx, service, EOK, 389, PORT_WORKING, -1);
+    active = ctx->last_server;
+
+    /* The standby server is never the active one */
+    get_standby_request(ctx, service, EOK, 390);
+    fail_if(ctx->last_server == active);
+    get_standby_request(ctx, service, EOK, 390);
+
+    /* and resolving it does not change the active server */
+    get_request(ctx, service, EOK, 389, -1, -1);
+    fail_if(ctx->last_server != active);
+
+    /* Without another working server there is no standby */
+    get_standby_request(ctx, service, EOK, 390);
+    fo_set_port_status(ctx->last_server, PORT_NOT_WORKING);
+    get_standby_request(ctx, service, ENOENT, 0);
+    get_request(ctx, service, EOK, 389, -1, -1);
+
+    talloc_free(ctx);
+}
+END_TEST
+
 Suite *
 create_suite(void)
 {
@@ -268,6 +417,9 @@ create_suite(void)
     /* Do some testing */
     tcase_add_test(tc, test_fo_new_service);
     tcase_add_test(tc, test_fo_resolve_service);
+    tcase_add_test(tc, test_fo_latency_policy);
+    tcase_add_test(tc, test_fo_latency_probe);
+    tcase_add_test(tc, test_fo_resolve_standby);
     if (use_net_test) {
     }
     /* Add all test cases to the test suite */
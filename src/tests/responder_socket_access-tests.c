@@ -23,6 +23,8 @@
 #include <popt.h>
 #include <check.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
 
 #include "tests/common.h"
 #include "responder/common/responder.h"
@@ -122,6 +124,81 @@ START_TEST(check_allowed_uids_test)
 }
 END_TEST
 
+static int connect_pipe(const char *sock_name)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_name, sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* The NSS workers inherit the listening socket from the monitor, each
+ * connection must be accepted by exactly one of them and the others must
+ * not block in accept(). */
+START_TEST(shared_pipe_fd_test)
+{
+    int ret;
+    char dir[] = "responder_socket_access-XXXXXX";
+    char *sock_name;
+    int main_fd;
+    int worker_fd;
+    int cli_fd;
+    int srv_fd;
+
+    fail_unless(mkdtemp(dir) != NULL, "mkdtemp failed.");
+    sock_name = talloc_asprintf(global_talloc_context, "%s/nss", dir);
+    fail_unless(sock_name != NULL, "talloc_asprintf failed.");
+
+    ret = create_pipe_fd(sock_name, &main_fd, 0111);
+    fail_unless(ret == EOK, "create_pipe_fd failed [%d][%s].",
+                ret, strerror(ret));
+
+    /* same open file description as the one passed with --socket-fd */
+    worker_fd = dup(main_fd);
+    fail_unless(worker_fd != -1, "dup failed.");
+
+    cli_fd = connect_pipe(sock_name);
+    fail_unless(cli_fd != -1, "connect failed.");
+
+    srv_fd = accept(main_fd, NULL, NULL);
+    fail_unless(srv_fd != -1, "accept failed [%d].", errno);
+    close(srv_fd);
+
+    srv_fd = accept(worker_fd, NULL, NULL);
+    fail_unless(srv_fd == -1 && (errno == EAGAIN || errno == EWOULDBLOCK),
+                "Connection was accepted twice.");
+    close(cli_fd);
+
+    cli_fd = connect_pipe(sock_name);
+    fail_unless(cli_fd != -1, "connect failed.");
+
+    srv_fd = accept(worker_fd, NULL, NULL);
+    fail_unless(srv_fd != -1, "accept in the worker failed [%d].", errno);
+    close(srv_fd);
+    close(cli_fd);
+
+    close(worker_fd);
+    close(main_fd);
+    unlink(sock_name);
+    rmdir(dir);
+    talloc_free(sock_name);
+}
+END_TEST
+
 Suite *responder_test_suite(void)
 {
     Suite *s = suite_create ("Responder socket access");
@@ -130,6 +207,7 @@ Suite *responder_test_suite(void)
 
     tcase_add_test(tc_utils, resp_str_to_array_test);
     tcase_add_test(tc_utils, check_allowed_uids_test);
+    tcase_add_test(tc_utils, shared_pipe_fd_test);
 
     suite_add_tcase(s, tc_utils);
 
@@ -31,6 +31,7 @@
 #include "db/sysdb_private.h"
 #include "db/sysdb_services.h"
 #include "db/sysdb_autofs.h"
+#include "util/sss_stats.h"
 #include "tests/common.h"
 
 #define TESTS_PATH "tests_sysdb"
@@ -1978,6 +1979,63 @@ START_TEST (test_sysdb_cached_authentication)
 }
 END_TEST
 
+START_TEST (test_sysdb_cached_authentication_rounds_verifier)
+{
+    struct sysdb_test_ctx *test_ctx;
+    const char *attrs[] = { SYSDB_CACHEDPWD, NULL };
+    struct ldb_message *msg;
+    const char *hash;
+    const char *username;
+    const char *val[2] = { NULL, NULL };
+    time_t expire_date;
+    time_t delayed_until;
+    int i;
+    int ret;
+
+    ret = setup_sysdb_tests(&test_ctx);
+    fail_unless(ret == EOK, "Could not set up the test");
+
+    username = talloc_asprintf(test_ctx, "testuser%d", _i);
+    fail_unless(username != NULL, "talloc_asprintf failed.");
+
+    val[0] = "60";
+    ret = confdb_add_param(test_ctx->confdb, true, CONFDB_PAM_CONF_ENTRY,
+                           CONFDB_PAM_VERIFIER_TIMEOUT, val);
+    fail_unless(ret == EOK, "confdb_add_param failed.");
+
+    test_ctx->domain->cache_credentials_rounds = 1000;
+    ret = sysdb_cache_password(test_ctx->domain, username, username);
+    fail_unless(ret == EOK, "sysdb_cache_password request failed [%d].", ret);
+
+    ret = sysdb_search_user_by_name(test_ctx, test_ctx->domain, username,
+                                    attrs, &msg);
+    fail_unless(ret == EOK, "sysdb_search_user_by_name failed [%d].", ret);
+    hash = ldb_msg_find_attr_as_string(msg, SYSDB_CACHEDPWD, NULL);
+    fail_unless(hash != NULL && strncmp(hash, "$6$rounds=1000$", 15) == 0,
+                "Unexpected password hash [%s].", hash);
+
+    /* the second attempt is answered by the verifier cache */
+    for (i = 0; i < 2; i++) {
+        ret = sysdb_cache_auth(test_ctx->domain, username, username,
+                               test_ctx->confdb, false,
+                               &expire_date, &delayed_until);
+        fail_unless(ret == EOK, "sysdb_cache_auth failed [%d].", ret);
+    }
+
+    ret = sysdb_cache_auth(test_ctx->domain, username, "abc",
+                           test_ctx->confdb, false,
+                           &expire_date, &delayed_until);
+    fail_unless(ret == ERR_AUTH_FAILED, "sysdb_cache_auth returned [%d].", ret);
+
+    ret = sysdb_cache_auth(test_ctx->domain, username, username,
+                           test_ctx->confdb, false,
+                           &expire_date, &delayed_until);
+    fail_unless(ret == EOK, "sysdb_cache_auth failed [%d].", ret);
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST (test_sysdb_prepare_asq_test_user)
 {
     struct sysdb_test_ctx *test_ctx;
@@ -5939,6 +5997,488 @@ START_TEST(test_upn_dup)
 }
 END_TEST
 
+#define BATCH_USER_BASE_UID 40000
+#define BATCH_USER_COUNT 100
+
+struct batch_test_ctx {
+    struct sysdb_test_ctx *test_ctx;
+    size_t stored;
+    size_t fail_at;
+};
+
+static errno_t batch_test_store_user(size_t idx, void *pvt)
+{
+    struct batch_test_ctx *bctx = talloc_get_type(pvt, struct batch_test_ctx);
+    const char *name;
+    errno_t ret;
+
+    if (idx == bctx->fail_at) {
+        return EIO;
+    }
+
+    name = talloc_asprintf(bctx, "batchuser%zu", idx);
+    if (name == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sysdb_store_user(bctx->test_ctx->domain, name, NULL,
+                           BATCH_USER_BASE_UID + idx, 0, name, "/", "/bin/sh",
+                           NULL, NULL, NULL, -1, 0);
+    if (ret == EOK) {
+        bctx->stored++;
+    }
+
+    return ret;
+}
+
+static size_t batch_test_count_users(struct sysdb_test_ctx *test_ctx)
+{
+    struct ldb_message **msgs;
+    size_t count;
+    errno_t ret;
+
+    ret = sysdb_search_users(test_ctx, test_ctx->domain,
+                             "("SYSDB_NAME"=batchuser*)", NULL, &count, &msgs);
+    if (ret == ENOENT) {
+        return 0;
+    }
+    fail_unless(ret == EOK, "sysdb_search_users failed [%d]", ret);
+    talloc_free(msgs);
+
+    return count;
+}
+
+START_TEST(test_sysdb_batch_write)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct batch_test_ctx *bctx;
+    struct sysdb_batch *batch;
+    int ret;
+
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+
+    bctx = talloc_zero(test_ctx, struct batch_test_ctx);
+    fail_if(bctx == NULL, "talloc_zero failed");
+    bctx->test_ctx = test_ctx;
+    bctx->fail_at = BATCH_USER_COUNT;
+
+    ret = sysdb_batch_create(test_ctx, test_ctx->sysdb, 1000, &batch);
+    fail_unless(ret == EOK, "sysdb_batch_create failed [%d]", ret);
+
+    ret = sysdb_batch_write(batch, BATCH_USER_COUNT,
+                            batch_test_store_user, bctx);
+    fail_unless(ret == EOK, "sysdb_batch_write failed [%d]", ret);
+    fail_unless(sysdb_batch_written(batch) == BATCH_USER_COUNT,
+                "Expected %d written entries, got %zu",
+                BATCH_USER_COUNT, sysdb_batch_written(batch));
+    fail_unless(batch_test_count_users(test_ctx) == BATCH_USER_COUNT,
+                "Not all users were stored");
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
+START_TEST(test_sysdb_batch_write_error)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct batch_test_ctx *bctx;
+    struct sysdb_batch *batch;
+    size_t count;
+    int ret;
+
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+
+    bctx = talloc_zero(test_ctx, struct batch_test_ctx);
+    fail_if(bctx == NULL, "talloc_zero failed");
+    bctx->test_ctx = test_ctx;
+    bctx->fail_at = BATCH_USER_COUNT / 2;
+
+    /* without a time limit everything is written in one transaction */
+    ret = sysdb_batch_create(test_ctx, test_ctx->sysdb, 0, &batch);
+    fail_unless(ret == EOK, "sysdb_batch_create failed [%d]", ret);
+
+    ret = sysdb_batch_write(batch, BATCH_USER_COUNT,
+                            batch_test_store_user, bctx);
+    fail_unless(ret == EIO, "Expected EIO, got [%d]", ret);
+    fail_unless(bctx->stored == BATCH_USER_COUNT / 2,
+                "Expected %d stored users, got %zu",
+                BATCH_USER_COUNT / 2, bctx->stored);
+
+    /* freeing the batch cancels the open transaction */
+    talloc_free(batch);
+    count = batch_test_count_users(test_ctx);
+    fail_unless(count == 0, "Expected no users, got %zu", count);
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
+START_TEST(test_sysdb_batch_nested)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct batch_test_ctx *bctx;
+    struct sysdb_batch *batch;
+    int ret;
+
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+
+    bctx = talloc_zero(test_ctx, struct batch_test_ctx);
+    fail_if(bctx == NULL, "talloc_zero failed");
+    bctx->test_ctx = test_ctx;
+    bctx->fail_at = BATCH_USER_COUNT;
+
+    ret = sysdb_transaction_start(test_ctx->sysdb);
+    fail_unless(ret == EOK, "sysdb_transaction_start failed [%d]", ret);
+
+    /* nothing may be committed within the transaction of the caller */
+    ret = sysdb_batch_create(test_ctx, test_ctx->sysdb, 1, &batch);
+    fail_unless(ret == EOK, "sysdb_batch_create failed [%d]", ret);
+
+    ret = sysdb_batch_write(batch, BATCH_USER_COUNT,
+                            batch_test_store_user, bctx);
+    fail_unless(ret == EOK, "sysdb_batch_write failed [%d]", ret);
+
+    ret = sysdb_transaction_cancel(test_ctx->sysdb);
+    fail_unless(ret == EOK, "sysdb_transaction_cancel failed [%d]", ret);
+
+    fail_unless(batch_test_count_users(test_ctx) == 0,
+                "The batch committed the transaction of the caller");
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
+static void batch_test_write_done(struct tevent_req *req)
+{
+    bool *done = tevent_req_callback_data(req, bool);
+    errno_t ret;
+
+    ret = sysdb_batch_write_recv(req);
+    talloc_free(req);
+    fail_unless(ret == EOK, "sysdb_batch_write_recv failed [%d]", ret);
+
+    *done = true;
+}
+
+START_TEST(test_sysdb_batch_write_send)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct batch_test_ctx *bctx;
+    struct sysdb_batch *batch;
+    struct tevent_req *req;
+    bool done = false;
+    int ret;
+
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+
+    bctx = talloc_zero(test_ctx, struct batch_test_ctx);
+    fail_if(bctx == NULL, "talloc_zero failed");
+    bctx->test_ctx = test_ctx;
+    bctx->fail_at = BATCH_USER_COUNT;
+
+    ret = sysdb_batch_create(test_ctx, test_ctx->sysdb, 1, &batch);
+    fail_unless(ret == EOK, "sysdb_batch_create failed [%d]", ret);
+
+    req = sysdb_batch_write_send(test_ctx, test_ctx->ev, batch,
+                                 BATCH_USER_COUNT, batch_test_store_user,
+                                 bctx);
+    fail_if(req == NULL, "sysdb_batch_write_send failed");
+    tevent_req_set_callback(req, batch_test_write_done, &done);
+
+    while (!done) {
+        tevent_loop_once(test_ctx->ev);
+    }
+
+    fail_unless(sysdb_batch_written(batch) == BATCH_USER_COUNT,
+                "Expected %d written entries, got %zu",
+                BATCH_USER_COUNT, sysdb_batch_written(batch));
+    fail_unless(batch_test_count_users(test_ctx) == BATCH_USER_COUNT,
+                "Not all users were stored");
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
+static void snapshot_changed_cb(void *pvt)
+{
+    int *changes = talloc_get_type(pvt, int);
+
+    (*changes)++;
+}
+
+START_TEST(test_sysdb_snapshot)
+{
+    struct sysdb_test_ctx *test_ctx;
+    struct sysdb_attrs *attrs;
+    struct ldb_result *res;
+    const char *str;
+    int64_t hits;
+    bool written;
+    int *changes;
+    int ret;
+
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+
+    /* groups of MPG domains are always read from the cache */
+    test_ctx->domain->mpg = false;
+
+    ret = sysdb_store_user(test_ctx->domain, "snapuser", "x", 27001, 0,
+                           "Snapshot User", "/home/snapuser", "/bin/bash",
+                           NULL, NULL, NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_user failed [%d]", ret);
+
+    ret = sysdb_store_group(test_ctx->domain, "snapgroup", 27001,
+                            NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_group failed [%d]", ret);
+
+    ret = sysdb_add_group_member(test_ctx->domain, "snapgroup", "snapuser",
+                                 SYSDB_MEMBER_USER, false);
+    fail_unless(ret == EOK, "sysdb_add_group_member failed [%d]", ret);
+
+    ret = sysdb_snapshot_update(test_ctx->sysdb, &written);
+    fail_unless(ret == EOK, "sysdb_snapshot_update failed [%d]", ret);
+    fail_unless(written, "Snapshot was not written");
+
+    ret = sysdb_snapshot_update(test_ctx->sysdb, &written);
+    fail_unless(ret == EOK, "sysdb_snapshot_update failed [%d]", ret);
+    fail_if(written, "Unchanged cache was written again");
+
+    hits = sss_stats_get_value("sysdb.snapshot.hits");
+
+    ret = sysdb_getpwnam(test_ctx, test_ctx->domain, "snapuser", &res);
+    fail_unless(ret == EOK && res->count == 1, "sysdb_getpwnam failed");
+    str = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_GECOS, NULL);
+    fail_unless(str != NULL && strcmp(str, "Snapshot User") == 0,
+                "Unexpected gecos [%s]", str);
+
+    ret = sysdb_getpwuid(test_ctx, test_ctx->domain, 27001, &res);
+    fail_unless(ret == EOK && res->count == 1, "sysdb_getpwuid failed");
+    str = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_NAME, NULL);
+    fail_unless(str != NULL && strcmp(str, "snapuser") == 0,
+                "Unexpected name [%s]", str);
+
+    ret = sysdb_getgrgid(test_ctx, test_ctx->domain, 27001, &res);
+    fail_unless(ret == EOK && res->count == 1, "sysdb_getgrgid failed");
+    str = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_NAME, NULL);
+    fail_unless(str != NULL && strcmp(str, "snapgroup") == 0,
+                "Unexpected name [%s]", str);
+
+    ret = sysdb_initgroups(test_ctx, test_ctx->domain, "snapuser", &res);
+    fail_unless(ret == EOK && res->count == 2, "sysdb_initgroups failed");
+    fail_unless(ldb_msg_find_attr_as_uint64(res->msgs[1],
+                                            SYSDB_GIDNUM, 0) == 27001,
+                "Unexpected group in initgroups result");
+
+    fail_unless(sss_stats_get_value("sysdb.snapshot.hits") == hits + 4,
+                "Lookups were not served from the snapshot");
+
+    changes = talloc_zero(test_ctx, int);
+    fail_if(changes == NULL, "talloc_zero failed");
+    ret = sysdb_snapshot_set_changed_cb(test_ctx->sysdb, snapshot_changed_cb,
+                                        changes);
+    fail_unless(ret == EOK, "sysdb_snapshot_set_changed_cb failed [%d]", ret);
+
+    /* a changed entry is read from ldb, the others from the snapshot */
+    attrs = sysdb_new_attrs(test_ctx);
+    fail_if(attrs == NULL, "sysdb_new_attrs failed");
+    ret = sysdb_attrs_add_string(attrs, SYSDB_GECOS, "Changed User");
+    fail_unless(ret == EOK, "sysdb_attrs_add_string failed [%d]", ret);
+    ret = sysdb_set_user_attr(test_ctx->domain, "snapuser", attrs,
+                              SYSDB_MOD_REP);
+    fail_unless(ret == EOK, "sysdb_set_user_attr failed [%d]", ret);
+
+    hits = sss_stats_get_value("sysdb.snapshot.hits");
+    ret = sysdb_getpwnam(test_ctx, test_ctx->domain, "snapuser", &res);
+    fail_unless(ret == EOK && res->count == 1, "sysdb_getpwnam failed");
+    str = ldb_msg_find_attr_as_string(res->msgs[0], SYSDB_GECOS, NULL);
+    fail_unless(str != NULL && strcmp(str, "Changed User") == 0,
+                "Stale gecos [%s]", str);
+    fail_unless(sss_stats_get_value("sysdb.snapshot.hits") == hits,
+                "Stale snapshot was used");
+    fail_unless(*changes == 1, "The change was not reported");
+
+    ret = sysdb_getgrgid(test_ctx, test_ctx->domain, 27001, &res);
+    fail_unless(ret == EOK && res->count == 1, "sysdb_getgrgid failed");
+    fail_unless(sss_stats_get_value("sysdb.snapshot.hits") == hits + 1,
+                "Unchanged group was not served from the snapshot");
+
+    /* a change of the memberships affects all groups */
+    ret = sysdb_store_group(test_ctx->domain, "snapgroup2", 27002,
+                            NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_group failed [%d]", ret);
+
+    ret = sysdb_add_group_member(test_ctx->domain, "snapgroup2", "snapuser",
+                                 SYSDB_MEMBER_USER, false);
+    fail_unless(ret == EOK, "sysdb_add_group_member failed [%d]", ret);
+
+    hits = sss_stats_get_value("sysdb.snapshot.hits");
+    ret = sysdb_getgrgid(test_ctx, test_ctx->domain, 27001, &res);
+    fail_unless(ret == EOK && res->count == 1, "sysdb_getgrgid failed");
+    ret = sysdb_initgroups(test_ctx, test_ctx->domain, "snapuser", &res);
+    fail_unless(ret == EOK && res->count == 3, "sysdb_initgroups failed");
+    fail_unless(sss_stats_get_value("sysdb.snapshot.hits") == hits,
+                "Stale snapshot was used");
+
+    /* the next snapshot is current again */
+    ret = sysdb_snapshot_update(test_ctx->sysdb, &written);
+    fail_unless(ret == EOK && written, "sysdb_snapshot_update failed [%d]",
+                ret);
+
+    ret = sysdb_initgroups(test_ctx, test_ctx->domain, "snapuser", &res);
+    fail_unless(ret == EOK && res->count == 3, "sysdb_initgroups failed");
+    fail_unless(sss_stats_get_value("sysdb.snapshot.hits") == hits + 1,
+                "Lookup was not served from the new snapshot");
+
+    ret = sysdb_snapshot_set_changed_cb(test_ctx->sysdb, NULL, NULL);
+    fail_unless(ret == EOK, "sysdb_snapshot_set_changed_cb failed [%d]", ret);
+
+    ret = sysdb_snapshot_remove(test_ctx->sysdb);
+    fail_unless(ret == EOK, "sysdb_snapshot_remove failed [%d]", ret);
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
+static void members_index_check(struct sysdb_test_ctx *test_ctx,
+                                 unsigned int count, gid_t *gids)
+{
+    struct ldb_result *res;
+    gid_t gid;
+    unsigned int i;
+    unsigned int j;
+    int ret;
+
+    ret = sysdb_initgroups(test_ctx, test_ctx->domain, "idxuser", &res);
+    fail_unless(ret == EOK, "sysdb_initgroups failed [%d]", ret);
+    fail_unless(res->count == count + 1,
+                "Expected %u groups, got %u", count, res->count - 1);
+
+    for (i = 0; i < count; i++) {
+        for (j = 1; j < res->count; j++) {
+            gid = ldb_msg_find_attr_as_uint(res->msgs[j], SYSDB_GIDNUM, 0);
+            if (gid == gids[i]) {
+                break;
+            }
+        }
+        fail_if(j == res->count, "Group %u is missing", gids[i]);
+    }
+
+    talloc_free(res);
+}
+
+START_TEST(test_sysdb_members_index)
+{
+    struct sysdb_test_ctx *test_ctx;
+    gid_t nested[] = { 27101, 27102, 27103 };
+    gid_t direct[] = { 27101 };
+    gid_t moved[] = { 27101, 27103 };
+    int64_t builds;
+    int64_t hits;
+    int ret;
+
+    ret = setup_sysdb_tests(&test_ctx);
+    if (ret != EOK) {
+        fail("Could not set up the test");
+        return;
+    }
+
+    ret = sysdb_store_user(test_ctx->domain, "idxuser", "x", 27100, 0,
+                           "Index User", "/home/idxuser", "/bin/bash",
+                           NULL, NULL, NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_user failed [%d]", ret);
+
+    ret = sysdb_store_group(test_ctx->domain, "idxgroup1", 27101,
+                            NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_group failed [%d]", ret);
+    ret = sysdb_store_group(test_ctx->domain, "idxgroup2", 27102,
+                            NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_group failed [%d]", ret);
+    ret = sysdb_store_group(test_ctx->domain, "idxgroup3", 27103,
+                            NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_group failed [%d]", ret);
+
+    /* idxuser -> idxgroup1 -> idxgroup2 -> idxgroup3 */
+    ret = sysdb_add_group_member(test_ctx->domain, "idxgroup1", "idxuser",
+                                 SYSDB_MEMBER_USER, false);
+    fail_unless(ret == EOK, "sysdb_add_group_member failed [%d]", ret);
+    ret = sysdb_add_group_member(test_ctx->domain, "idxgroup2", "idxgroup1",
+                                 SYSDB_MEMBER_GROUP, false);
+    fail_unless(ret == EOK, "sysdb_add_group_member failed [%d]", ret);
+    ret = sysdb_add_group_member(test_ctx->domain, "idxgroup3", "idxgroup2",
+                                 SYSDB_MEMBER_GROUP, false);
+    fail_unless(ret == EOK, "sysdb_add_group_member failed [%d]", ret);
+
+    builds = sss_stats_get_value("sysdb.members_index.builds");
+    hits = sss_stats_get_value("sysdb.members_index.hits");
+
+    members_index_check(test_ctx, 3, nested);
+    fail_unless(sss_stats_get_value("sysdb.members_index.builds")
+                    == builds + 1, "The index was not built");
+
+    /* changes of the members are applied to the index */
+    ret = sysdb_remove_group_member(test_ctx->domain, "idxgroup2",
+                                    "idxgroup1", SYSDB_MEMBER_GROUP, false);
+    fail_unless(ret == EOK, "sysdb_remove_group_member failed [%d]", ret);
+    members_index_check(test_ctx, 1, direct);
+
+    ret = sysdb_add_group_member(test_ctx->domain, "idxgroup3", "idxgroup1",
+                                 SYSDB_MEMBER_GROUP, false);
+    fail_unless(ret == EOK, "sysdb_add_group_member failed [%d]", ret);
+    members_index_check(test_ctx, 2, moved);
+
+    fail_unless(sss_stats_get_value("sysdb.members_index.builds")
+                    == builds + 1, "The index was built again");
+    fail_unless(sss_stats_get_value("sysdb.members_index.hits") == hits + 3,
+                "Lookups were not served from the index");
+
+    /* adding a member which is already there changes nothing */
+    ret = sysdb_add_group_member(test_ctx->domain, "idxgroup1", "idxuser",
+                                 SYSDB_MEMBER_USER, false);
+    fail_unless(ret == EEXIST, "sysdb_add_group_member returned [%d]", ret);
+
+    /* writes which do not change the groups keep the index */
+    ret = sysdb_store_user(test_ctx->domain, "idxuser", "x", 27100, 0,
+                           "Index User", "/home/idxuser", "/bin/sh",
+                           NULL, NULL, NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_user failed [%d]", ret);
+    members_index_check(test_ctx, 2, moved);
+    fail_unless(sss_stats_get_value("sysdb.members_index.hits") == hits + 4,
+                "The index was not used after a write of a user");
+    fail_unless(sss_stats_get_value("sysdb.members_index.builds")
+                    == builds + 1, "The index was built again");
+
+    /* any other change of the groups makes the lookups use memberOf */
+    ret = sysdb_store_group(test_ctx->domain, "idxgroup4", 27104,
+                            NULL, -1, 0);
+    fail_unless(ret == EOK, "sysdb_store_group failed [%d]", ret);
+    members_index_check(test_ctx, 2, moved);
+    fail_unless(sss_stats_get_value("sysdb.members_index.hits") == hits + 4,
+                "Out of date index was used");
+
+    talloc_free(test_ctx);
+}
+END_TEST
+
 START_TEST(test_gpo_store_retrieve)
 {
     struct sysdb_test_ctx *test_ctx;
@@ -6255,6 +6795,9 @@ Suite *create_sysdb_suite(void)
     tcase_add_loop_test(tc_sysdb, test_sysdb_cached_authentication_wrong_password,
                         27010, 27011);
     tcase_add_loop_test(tc_sysdb, test_sysdb_cached_authentication, 27010, 27011);
+    tcase_add_loop_test(tc_sysdb,
+                        test_sysdb_cached_authentication_rounds_verifier,
+                        27011, 27012);
 
     /* ASQ search test */
     tcase_add_loop_test(tc_sysdb, test_sysdb_prepare_asq_test_user, 28011, 28020);
@@ -6539,6 +7082,21 @@ Suite *create_sysdb_suite(void)
 
     suite_add_tcase(s, tc_upn);
 
+    TCase *tc_batch = tcase_create("SYSDB write batch tests");
+    tcase_add_test(tc_batch, test_sysdb_batch_write);
+    tcase_add_test(tc_batch, test_sysdb_batch_write_error);
+    tcase_add_test(tc_batch, test_sysdb_batch_nested);
+    tcase_add_test(tc_batch, test_sysdb_batch_write_send);
+    suite_add_tcase(s, tc_batch);
+
+    TCase *tc_snapshot = tcase_create("SYSDB snapshot tests");
+    tcase_add_test(tc_snapshot, test_sysdb_snapshot);
+    suite_add_tcase(s, tc_snapshot);
+
+    TCase *tc_members_index = tcase_create("SYSDB membership index tests");
+    tcase_add_test(tc_members_index, test_sysdb_members_index);
+    suite_add_tcase(s, tc_members_index);
+
     TCase *tc_gpo = tcase_create("SYSDB GPO tests");
     tcase_add_test(tc_gpo, test_gpo_store_retrieve);
     tcase_add_test(tc_gpo, test_gpo_replace);
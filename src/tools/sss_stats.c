@@ -0,0 +1,203 @@
+/*
+    SSSD
+
+    sss_stats - Print the statistics of the running SSSD services
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <talloc.h>
+#include <popt.h>
+#include <dbus/dbus.h>
+
+#include "config.h"
+#include "util/util.h"
+#include "tools/tools_util.h"
+#include "monitor/monitor_interfaces.h"
+
+/* the monitor has to ask all services, give it some more time than it
+ * gives to each of them */
+#define SSS_STATS_TIMEOUT_MS 30000
+
+static errno_t get_stats(TALLOC_CTX *mem_ctx, char **_stats)
+{
+    DBusConnection *conn = NULL;
+    DBusMessage *msg = NULL;
+    DBusMessage *reply = NULL;
+    DBusError dbus_error;
+    const char *stats;
+    char *address;
+    dbus_bool_t dbret;
+    errno_t ret;
+
+    dbus_error_init(&dbus_error);
+
+    ret = monitor_get_sbus_address(mem_ctx, &address);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Could not locate monitor address.\n");
+        return ret;
+    }
+
+    conn = dbus_connection_open_private(address, &dbus_error);
+    if (conn == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to connect to %s: %s\n",
+              address, dbus_error.message);
+        ret = EIO;
+        goto done;
+    }
+
+    msg = dbus_message_new_method_call(NULL, MON_SRV_PATH, MON_SRV_IFACE,
+                                       MON_SRV_IFACE_GETSTATS);
+    if (msg == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    reply = dbus_connection_send_with_reply_and_block(conn, msg,
+                                                      SSS_STATS_TIMEOUT_MS,
+                                                      &dbus_error);
+    if (reply == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to get statistics: %s\n",
+              dbus_error.message);
+        ret = EIO;
+        goto done;
+    }
+
+    dbret = dbus_message_get_args(reply, &dbus_error,
+                                  DBUS_TYPE_STRING, &stats,
+                                  DBUS_TYPE_INVALID);
+    if (!dbret) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "Unable to parse reply: %s\n",
+              dbus_error.message);
+        ret = EIO;
+        goto done;
+    }
+
+    *_stats = talloc_strdup(mem_ctx, stats);
+    if (*_stats == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = EOK;
+
+done:
+    if (dbus_error_is_set(&dbus_error)) {
+        dbus_error_free(&dbus_error);
+    }
+    if (reply != NULL) {
+        dbus_message_unref(reply);
+    }
+    if (msg != NULL) {
+        dbus_message_unref(msg);
+    }
+    if (conn != NULL) {
+        dbus_connection_close(conn);
+        dbus_connection_unref(conn);
+    }
+    talloc_free(address);
+    return ret;
+}
+
+/* Prints only the [service] sections named service */
+static void print_stats(const char *stats, const char *service)
+{
+    const char *line;
+    const char *end;
+    size_t len;
+    bool print = (service == NULL);
+
+    for (line = stats; *line != '\0'; line = end) {
+        end = strchr(line, '\n');
+        end = (end == NULL) ? line + strlen(line) : end + 1;
+        len = end - line;
+
+        if (service != NULL && line[0] == '[') {
+            print = (len == strlen(service) + 3
+                     && strncmp(line + 1, service, len - 3) == 0
+                     && line[len - 2] == ']');
+        }
+
+        if (print) {
+            fwrite(line, 1, len, stdout);
+        }
+    }
+}
+
+int main(int argc, const char **argv)
+{
+    int ret;
+    int pc_debug = SSSDBG_DEFAULT;
+    const char *pc_service = NULL;
+    char *stats = NULL;
+    TALLOC_CTX *tmp_ctx = NULL;
+    struct poptOption long_options[] = {
+        POPT_AUTOHELP
+        {"debug", '\0', POPT_ARG_INT | POPT_ARGFLAG_DOC_HIDDEN, &pc_debug,
+            0, _("The debug level to run with"), NULL },
+        {"service", 's', POPT_ARG_STRING, &pc_service,
+            0, _("Only print the statistics of this service"), NULL },
+        POPT_TABLEEND
+    };
+    poptContext pc = NULL;
+
+    debug_prg_name = argv[0];
+
+    /* parse parameters */
+    pc = poptGetContext(argv[0], argc, argv, long_options, 0);
+    while((ret = poptGetNextOpt(pc)) != -1) {
+        switch(ret) {
+        default:
+            fprintf(stderr, "\nInvalid option %s: %s\n\n",
+                    poptBadOption(pc, 0), poptStrerror(ret));
+            poptPrintUsage(pc, stderr, 0);
+            ret = EXIT_FAILURE;
+            goto fini;
+        }
+    }
+    DEBUG_CLI_INIT(pc_debug);
+
+    if (poptGetArg(pc)) {
+        BAD_POPT_PARAMS(pc, _("Unexpected argument\n"), ret, fini);
+    }
+
+    CHECK_ROOT(ret, debug_prg_name);
+
+    tmp_ctx = talloc_new(NULL);
+    if (tmp_ctx == NULL) {
+        DEBUG(SSSDBG_CRIT_FAILURE, "talloc_new() failed\n");
+        ret = EXIT_FAILURE;
+        goto fini;
+    }
+
+    ret = get_stats(tmp_ctx, &stats);
+    if (ret != EOK) {
+        ERROR("Could not get the statistics. Is sssd running?\n");
+        ret = EXIT_FAILURE;
+        goto fini;
+    }
+
+    print_stats(stats, pc_service);
+    ret = EXIT_SUCCESS;
+
+fini:
+    poptFreeContext(pc);
+    talloc_free(tmp_ctx);
+    return ret;
+}
@@ -0,0 +1,290 @@
+/*
+    SSSD
+
+    auth_verifier.c - In-memory cache of recently verified passwords
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/mman.h>
+
+#include "util/util.h"
+#include "util/crypto/sss_crypto.h"
+#include "util/auth_verifier.h"
+
+#define AUTH_VERIFIER_SLOTS 256
+#define AUTH_VERIFIER_KEY_LEN 64
+
+struct auth_verifier_entry {
+    uint8_t id[SSS_SHA1_LENGTH];
+    uint8_t verifier[SSS_SHA1_LENGTH];
+    time_t expire;
+};
+
+/* Lives in a single locked anonymous mapping */
+struct auth_verifier_store {
+    uint8_t key[AUTH_VERIFIER_KEY_LEN];
+    struct auth_verifier_entry entries[AUTH_VERIFIER_SLOTS];
+};
+
+static struct auth_verifier_store *verifier_store;
+static bool verifier_disabled;
+
+static errno_t auth_verifier_init(void)
+{
+    struct auth_verifier_store *store;
+    errno_t ret;
+
+    if (verifier_store != NULL) {
+        return EOK;
+    }
+
+    if (verifier_disabled) {
+        return EPERM;
+    }
+
+    store = mmap(NULL, sizeof(struct auth_verifier_store),
+                 PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (store == MAP_FAILED) {
+        ret = errno;
+        DEBUG(SSSDBG_OP_FAILURE, "mmap failed [%d]: %s\n", ret, strerror(ret));
+        goto fail;
+    }
+
+    if (mlock(store, sizeof(struct auth_verifier_store)) != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Unable to lock memory [%d]: %s, the password verifier cache "
+              "is disabled\n", ret, strerror(ret));
+        munmap(store, sizeof(struct auth_verifier_store));
+        goto fail;
+    }
+
+#ifdef MADV_DONTDUMP
+    /* keep the key out of core dumps */
+    if (madvise(store, sizeof(struct auth_verifier_store),
+                MADV_DONTDUMP) != 0) {
+        ret = errno;
+        DEBUG(SSSDBG_TRACE_FUNC, "madvise failed [%d]: %s\n",
+              ret, strerror(ret));
+    }
+#endif
+
+    ret = sss_generate_random_bytes(store->key, AUTH_VERIFIER_KEY_LEN);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_OP_FAILURE, "Unable to generate verifier key\n");
+        safezero(store, sizeof(struct auth_verifier_store));
+        munlock(store, sizeof(struct auth_verifier_store));
+        munmap(store, sizeof(struct auth_verifier_store));
+        goto fail;
+    }
+
+    verifier_store = store;
+    return EOK;
+
+fail:
+    verifier_disabled = true;
+    return EPERM;
+}
+
+static errno_t auth_verifier_id(const char *domain, const char *name,
+                                uint8_t *id)
+{
+    char *data;
+    errno_t ret;
+
+    data = talloc_asprintf(NULL, "%zu:%s%s", strlen(domain), domain, name);
+    if (data == NULL) {
+        return ENOMEM;
+    }
+
+    ret = sss_hmac_sha1(verifier_store->key, AUTH_VERIFIER_KEY_LEN,
+                        (const unsigned char *) data, strlen(data), id);
+    talloc_free(data);
+    return ret;
+}
+
+/* HMAC(HMAC(key, password), domain || name || hash) so that the password
+ * does not have to be copied anywhere */
+static errno_t auth_verifier_compute(const char *domain, const char *name,
+                                     const char *hash, const char *password,
+                                     uint8_t *verifier)
+{
+    uint8_t pwkey[SSS_SHA1_LENGTH];
+    char *data;
+    errno_t ret;
+
+    ret = sss_hmac_sha1(verifier_store->key, AUTH_VERIFIER_KEY_LEN,
+                        (const unsigned char *) password, strlen(password),
+                        pwkey);
+    if (ret != EOK) {
+        goto done;
+    }
+
+    data = talloc_asprintf(NULL, "%zu:%s%zu:%s%s", strlen(domain), domain,
+                           strlen(name), name, hash);
+    if (data == NULL) {
+        ret = ENOMEM;
+        goto done;
+    }
+
+    ret = sss_hmac_sha1(pwkey, sizeof(pwkey),
+                        (const unsigned char *) data, strlen(data), verifier);
+    talloc_free(data);
+
+done:
+    safezero(pwkey, sizeof(pwkey));
+    return ret;
+}
+
+/* constant time comparison */
+static bool auth_verifier_equal(const uint8_t *a, const uint8_t *b)
+{
+    uint8_t diff = 0;
+    size_t i;
+
+    for (i = 0; i < SSS_SHA1_LENGTH; i++) {
+        diff |= a[i] ^ b[i];
+    }
+
+    return diff == 0;
+}
+
+static struct auth_verifier_entry *auth_verifier_find(const uint8_t *id)
+{
+    size_t i;
+
+    for (i = 0; i < AUTH_VERIFIER_SLOTS; i++) {
+        if (verifier_store->entries[i].expire != 0
+                && memcmp(verifier_store->entries[i].id, id,
+                          SSS_SHA1_LENGTH) == 0) {
+            return &verifier_store->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+bool sss_auth_verifier_check(const char *domain, const char *name,
+                             const char *hash, const char *password)
+{
+    struct auth_verifier_entry *entry;
+    uint8_t id[SSS_SHA1_LENGTH];
+    uint8_t verifier[SSS_SHA1_LENGTH];
+    bool match = false;
+    errno_t ret;
+
+    if (verifier_store == NULL || domain == NULL || name == NULL
+            || hash == NULL || password == NULL) {
+        return false;
+    }
+
+    ret = auth_verifier_id(domain, name, id);
+    if (ret != EOK) {
+        return false;
+    }
+
+    entry = auth_verifier_find(id);
+    if (entry == NULL) {
+        return false;
+    }
+
+    if (entry->expire < time(NULL)) {
+        safezero(entry, sizeof(struct auth_verifier_entry));
+        return false;
+    }
+
+    ret = auth_verifier_compute(domain, name, hash, password, verifier);
+    if (ret == EOK) {
+        match = auth_verifier_equal(entry->verifier, verifier);
+    }
+
+    safezero(verifier, sizeof(verifier));
+    return match;
+}
+
+void sss_auth_verifier_add(const char *domain, const char *name,
+                           const char *hash, const char *password,
+                           time_t ttl)
+{
+    struct auth_verifier_entry *entry;
+    uint8_t id[SSS_SHA1_LENGTH];
+    time_t now;
+    size_t i;
+    errno_t ret;
+
+    if (ttl <= 0 || domain == NULL || name == NULL
+            || hash == NULL || password == NULL) {
+        return;
+    }
+
+    ret = auth_verifier_init();
+    if (ret != EOK) {
+        return;
+    }
+
+    ret = auth_verifier_id(domain, name, id);
+    if (ret != EOK) {
+        return;
+    }
+
+    entry = auth_verifier_find(id);
+    if (entry == NULL) {
+        /* take a free or expired slot, or the one closest to expiration */
+        now = time(NULL);
+        entry = &verifier_store->entries[0];
+        for (i = 0; i < AUTH_VERIFIER_SLOTS; i++) {
+            if (verifier_store->entries[i].expire < now) {
+                entry = &verifier_store->entries[i];
+                break;
+            }
+
+            if (verifier_store->entries[i].expire < entry->expire) {
+                entry = &verifier_store->entries[i];
+            }
+        }
+    }
+
+    ret = auth_verifier_compute(domain, name, hash, password, entry->verifier);
+    if (ret != EOK) {
+        safezero(entry, sizeof(struct auth_verifier_entry));
+        return;
+    }
+
+    memcpy(entry->id, id, SSS_SHA1_LENGTH);
+    entry->expire = time(NULL) + ttl;
+}
+
+void sss_auth_verifier_remove(const char *domain, const char *name)
+{
+    struct auth_verifier_entry *entry;
+    uint8_t id[SSS_SHA1_LENGTH];
+    errno_t ret;
+
+    if (verifier_store == NULL || domain == NULL || name == NULL) {
+        return;
+    }
+
+    ret = auth_verifier_id(domain, name, id);
+    if (ret != EOK) {
+        return;
+    }
+
+    entry = auth_verifier_find(id);
+    if (entry != NULL) {
+        safezero(entry, sizeof(struct auth_verifier_entry));
+    }
+}
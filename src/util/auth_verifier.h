@@ -0,0 +1,48 @@
+/*
+    SSSD
+
+    auth_verifier.h - In-memory cache of recently verified passwords
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __AUTH_VERIFIER_H__
+#define __AUTH_VERIFIER_H__
+
+#include "util/util.h"
+
+/* The verifier cache remembers a keyed HMAC of passwords which were
+ * successfully checked against the cached password hash of a user, so that
+ * repeated cached authentications do not have to recompute the expensive
+ * hash. The HMAC key and the entries are kept in locked memory of the
+ * process and are never written anywhere. Each entry is bound to the
+ * cached password hash, so re-caching the password invalidates it. */
+
+/* Returns true if password was verified against hash for the user of the
+ * domain within the lifetime of the entry. */
+bool sss_auth_verifier_check(const char *domain, const char *name,
+                             const char *hash, const char *password);
+
+/* Remember that password matches hash for ttl seconds. If locked memory is
+ * not available, nothing is cached. */
+void sss_auth_verifier_add(const char *domain, const char *name,
+                           const char *hash, const char *password,
+                           time_t ttl);
+
+/* Forget the entry of the user, e.g. after a failed authentication. */
+void sss_auth_verifier_remove(const char *domain, const char *name);
+
+#endif /* __AUTH_VERIFIER_H__ */
@@ -23,6 +23,7 @@
 #include "util/crypto/sss_crypto.h"
 
 #include <openssl/evp.h>
+#include <openssl/rand.h>
 
 #define HMAC_SHA1_BLOCKSIZE 64
 
@@ -85,3 +86,12 @@ done:
     EVP_MD_CTX_cleanup(&ctx);
     return ret;
 }
+
+int sss_generate_random_bytes(uint8_t *buf, size_t size)
+{
+    if (RAND_bytes(buf, size) != 1) {
+        return EIO;
+    }
+
+    return EOK;
+}
@@ -28,6 +28,7 @@
 #include "util/crypto/nss/nss_util.h"
 
 #include <sechash.h>
+#include <pk11func.h>
 
 #define HMAC_SHA1_BLOCKSIZE 64
 
@@ -88,3 +89,20 @@ int sss_hmac_sha1(const unsigned char *key,
 
     return EOK;
 }
+
+int sss_generate_random_bytes(uint8_t *buf, size_t size)
+{
+    int ret;
+
+    ret = nspr_nss_init();
+    if (ret != EOK) {
+        return EIO;
+    }
+
+    ret = PK11_GenerateRandom(buf, size);
+    if (ret != SECSuccess) {
+        return EIO;
+    }
+
+    return EOK;
+}
@@ -27,6 +27,9 @@ int sss_hmac_sha1(const unsigned char *key,
                   size_t in_len,
                   unsigned char *out);
 
+/* fill buf with size bytes from the cryptographic random generator */
+int sss_generate_random_bytes(uint8_t *buf, size_t size);
+
 int sss_password_encrypt(TALLOC_CTX *mem_ctx, const char *password, int plen,
                          enum obfmethod meth, char **obfpwd);
 
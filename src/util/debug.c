@@ -29,6 +29,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 
 #ifdef WITH_JOURNALD
 #include <systemd/sd-journal.h>
@@ -36,6 +37,14 @@
 
 #include "util/util.h"
 
+#ifndef MIN
+#define MIN(a, b)  (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b)  (((a) > (b)) ? (a) : (b))
+#endif
+
 const char *debug_prg_name = "sssd";
 
 int debug_level = SSSDBG_UNRESOLVED;
@@ -45,6 +54,64 @@ int debug_to_file = 0;
 int debug_to_stderr = 0;
 const char *debug_log_file = "sssd";
 FILE *debug_file = NULL;
+int debug_ring_level = 0;
+
+/* Buffered logging
+ *
+ * The ring consists of records with a small header followed by the
+ * formatted message. The positions only ever grow, their value modulo the
+ * size of the ring is the offset in the buffer. Records never wrap around
+ * the end of the buffer, the space left at the end is filled with a padding
+ * record instead.
+ *
+ * tail <= flushed <= head
+ *   - records before tail were overwritten
+ *   - records between tail and flushed were already written to the log
+ *     or are only kept for debug_ring_dump()
+ *   - records between flushed and head are waiting to be written
+ *
+ * Messages which are only kept in memory are not formatted. Their record
+ * holds the format string, the time and a copy of the arguments instead
+ * (see struct debug_trace_rec) and they are formatted by debug_ring_dump()
+ * if ever. This keeps tracing of the verbose levels cheap.
+ *
+ * SSSD processes are single threaded, so no locking is needed. */
+#define DEBUG_RING_TO_FILE 0x0001
+#define DEBUG_RING_PAD     0x0002
+#define DEBUG_RING_TRACE   0x0004
+
+/* Longer messages are truncated */
+#define DEBUG_RING_MAX_LINE 4096
+#define DEBUG_RING_IOV 64
+
+/* Messages with more arguments are formatted right away, longer string
+ * arguments are truncated */
+#define DEBUG_TRACE_MAX_ARGS 16
+#define DEBUG_TRACE_MAX_STR 256
+#define DEBUG_TRACE_MAX_STRS 1024
+#define DEBUG_TRACE_NULL_STR UINT32_MAX
+
+struct debug_ring_rec {
+    uint32_t len;
+    uint16_t text_len;
+    uint16_t flags;
+    char text[];
+};
+
+static struct debug_ring {
+    char *buf;
+    size_t size;
+
+    uint64_t head;
+    uint64_t flushed;
+    uint64_t tail;
+    uint64_t dumped;
+
+    uint64_t dropped;
+
+    void (*notify)(void *pvt);
+    void *notify_pvt;
+} debug_ring;
 
 errno_t set_debug_file_from_fd(const int fd)
 {
@@ -115,6 +182,793 @@ static void debug_fflush(void)
     fflush(debug_file ? debug_file : stderr);
 }
 
+/* The formatted timestamp only changes once a second */
+static const char *debug_timestamp(time_t sec)
+{
+    static time_t cached_sec = -1;
+    static char datetime[32];
+    struct tm *tm;
+    int year;
+
+    if (sec != cached_sec) {
+        tm = localtime(&sec);
+        year = tm->tm_year + 1900;
+        /* get date time without year */
+        memcpy(datetime, ctime(&sec), 19);
+        snprintf(datetime + 19, sizeof(datetime) - 19, " %d", year);
+        cached_sec = sec;
+    }
+
+    return datetime;
+}
+
+/* tv is the time of the message, NULL for now */
+static int debug_format_prefix(char *buf, size_t size,
+                               const struct timeval *tv,
+                               const char *function, int level)
+{
+    struct timeval now;
+    char datetime[20];
+    const char *ts;
+
+    if (debug_timestamps) {
+        if (tv == NULL) {
+            gettimeofday(&now, NULL);
+            tv = &now;
+        }
+        ts = debug_timestamp(tv->tv_sec);
+        if (debug_microseconds) {
+            /* the microseconds go between time and year */
+            memcpy(datetime, ts, 19);
+            datetime[19] = '\0';
+            return snprintf(buf, size, "(%s:%.6ld%s) [%s] [%s] (%#.4x): ",
+                            datetime, (long)tv->tv_usec, ts + 19,
+                            debug_prg_name, function, level);
+        } else {
+            return snprintf(buf, size, "(%s) [%s] [%s] (%#.4x): ",
+                            ts, debug_prg_name, function, level);
+        }
+    }
+
+    return snprintf(buf, size, "[%s] [%s] (%#.4x): ",
+                    debug_prg_name, function, level);
+}
+
+static void debug_write_all(struct iovec *iov, int iovcnt)
+{
+    int fd = fileno(debug_file ? debug_file : stderr);
+    ssize_t written;
+
+    while (iovcnt > 0) {
+        written = writev(fd, iov, iovcnt);
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* nowhere to report it */
+            return;
+        }
+
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+errno_t debug_ring_init(size_t size)
+{
+    static bool registered = false;
+    char *buf;
+
+    size = size & ~(size_t)(sizeof(uint64_t) - 1);
+    if (size < 2 * DEBUG_RING_MAX_LINE) {
+        return EINVAL;
+    }
+
+    buf = malloc(size);
+    if (buf == NULL) {
+        return ENOMEM;
+    }
+
+    debug_ring_flush();
+    free(debug_ring.buf);
+
+    debug_ring.buf = buf;
+    debug_ring.size = size;
+    debug_ring.head = 0;
+    debug_ring.flushed = 0;
+    debug_ring.tail = 0;
+    debug_ring.dumped = 0;
+
+    if (!registered) {
+        atexit(debug_ring_flush);
+        registered = true;
+    }
+
+    return EOK;
+}
+
+void debug_ring_set_notify(void (*fn)(void *pvt), void *pvt)
+{
+    debug_ring.notify = fn;
+    debug_ring.notify_pvt = pvt;
+}
+
+static struct debug_ring_rec *debug_ring_rec_at(uint64_t pos)
+{
+    return (struct debug_ring_rec *)(debug_ring.buf + pos % debug_ring.size);
+}
+
+/* Returns NULL if the record would overwrite messages which were not
+ * written to the log yet */
+static struct debug_ring_rec *debug_ring_try_reserve(uint32_t len)
+{
+    struct debug_ring_rec *rec;
+    size_t offset;
+    size_t pad;
+
+    len = (len + sizeof(uint64_t) - 1) & ~(uint32_t)(sizeof(uint64_t) - 1);
+
+    offset = debug_ring.head % debug_ring.size;
+    pad = offset + len > debug_ring.size ? debug_ring.size - offset : 0;
+
+    while (debug_ring.head + pad + len - debug_ring.tail > debug_ring.size) {
+        if (debug_ring.tail >= debug_ring.flushed) {
+            return NULL;
+        }
+        debug_ring.tail += debug_ring_rec_at(debug_ring.tail)->len;
+    }
+
+    if (pad > 0) {
+        rec = debug_ring_rec_at(debug_ring.head);
+        rec->len = pad;
+        rec->text_len = 0;
+        rec->flags = DEBUG_RING_PAD;
+        debug_ring.head += pad;
+    }
+
+    rec = debug_ring_rec_at(debug_ring.head);
+    rec->len = len;
+    debug_ring.head += len;
+
+    return rec;
+}
+
+static struct debug_ring_rec *debug_ring_reserve(uint32_t len, bool to_file)
+{
+    struct debug_ring_rec *rec;
+    bool pending;
+
+    pending = (debug_ring.flushed < debug_ring.head);
+
+    rec = debug_ring_try_reserve(len);
+    if (rec == NULL) {
+        /* make room by writing out what is waiting */
+        debug_ring_flush();
+        pending = false;
+        rec = debug_ring_try_reserve(len);
+    }
+    if (rec == NULL) {
+        debug_ring.dropped++;
+        return NULL;
+    }
+
+    if (!to_file && !pending) {
+        /* nothing to write, the record may be overwritten right away */
+        debug_ring.flushed = debug_ring.head;
+    }
+
+    return rec;
+}
+
+union debug_trace_arg {
+    long long i;
+    unsigned long long u;
+    double d;
+    const void *p;
+    uint32_t s;     /* offset of the copy in the strings, or
+                     * DEBUG_TRACE_NULL_STR */
+};
+
+/* Payload of the DEBUG_RING_TRACE records */
+struct debug_trace_rec {
+    struct timeval tv;
+    const char *function;
+    const char *format;
+    int level;
+    uint32_t num_args;
+    union debug_trace_arg args[];
+    /* followed by the copied strings */
+};
+
+enum debug_trace_type {
+    DEBUG_TRACE_LITERAL,
+    DEBUG_TRACE_INT,
+    DEBUG_TRACE_UINT,
+    DEBUG_TRACE_DOUBLE,
+    DEBUG_TRACE_PTR,
+    DEBUG_TRACE_STR
+};
+
+struct debug_trace_spec {
+    enum debug_trace_type type;
+    int num_stars;
+    /* where the length modifier would start */
+    const char *length;
+    /* normalized length modifier: 'H' hh, 'h', 'l', 'L' ll, 'j', 'z', 't'
+     * or '\0' */
+    char mod;
+    char conv;
+};
+
+/* Parses the conversion starting with the '%' at p, returns the position
+ * after it or NULL if it cannot be stored without formatting it */
+static const char *debug_trace_parse_spec(const char *p,
+                                          struct debug_trace_spec *spec)
+{
+    memset(spec, 0, sizeof(struct debug_trace_spec));
+    p++;
+
+    if (*p == '%') {
+        spec->type = DEBUG_TRACE_LITERAL;
+        spec->conv = '%';
+        return p + 1;
+    }
+
+    while (*p != '\0' && strchr("-+ #0'", *p) != NULL) p++;
+
+    if (*p == '*') {
+        spec->num_stars++;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') p++;
+    }
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->num_stars++;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') p++;
+        }
+    }
+
+    spec->length = p;
+    switch (*p) {
+    case 'h':
+        p++;
+        spec->mod = 'h';
+        if (*p == 'h') {
+            p++;
+            spec->mod = 'H';
+        }
+        break;
+    case 'l':
+        p++;
+        spec->mod = 'l';
+        if (*p == 'l') {
+            p++;
+            spec->mod = 'L';
+        }
+        break;
+    case 'q':
+        p++;
+        spec->mod = 'L';
+        break;
+    case 'j':
+    case 'z':
+    case 't':
+        spec->mod = *p;
+        p++;
+        break;
+    default:
+        break;
+    }
+
+    spec->conv = *p;
+    switch (*p) {
+    case 'd':
+    case 'i':
+        spec->type = DEBUG_TRACE_INT;
+        break;
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+        spec->type = DEBUG_TRACE_UINT;
+        break;
+    case 'c':
+        if (spec->mod != '\0') return NULL;
+        spec->type = DEBUG_TRACE_INT;
+        break;
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        if (spec->mod != '\0' && spec->mod != 'l') return NULL;
+        spec->type = DEBUG_TRACE_DOUBLE;
+        break;
+    case 'p':
+        if (spec->mod != '\0') return NULL;
+        spec->type = DEBUG_TRACE_PTR;
+        break;
+    case 's':
+        if (spec->mod != '\0') return NULL;
+        spec->type = DEBUG_TRACE_STR;
+        break;
+    default:
+        /* wide characters, %n, %m, ... */
+        return NULL;
+    }
+
+    return p + 1;
+}
+
+static long long debug_trace_get_int(char mod, va_list *ap)
+{
+    switch (mod) {
+    case 'l':
+        return va_arg(*ap, long);
+    case 'L':
+        return va_arg(*ap, long long);
+    case 'j':
+        return va_arg(*ap, intmax_t);
+    case 'z':
+        return va_arg(*ap, ssize_t);
+    case 't':
+        return va_arg(*ap, ptrdiff_t);
+    default:
+        /* char and short are promoted */
+        return va_arg(*ap, int);
+    }
+}
+
+static unsigned long long debug_trace_get_uint(char mod, va_list *ap)
+{
+    switch (mod) {
+    case 'l':
+        return va_arg(*ap, unsigned long);
+    case 'L':
+        return va_arg(*ap, unsigned long long);
+    case 'j':
+        return va_arg(*ap, uintmax_t);
+    case 'z':
+        return va_arg(*ap, size_t);
+    case 't':
+        return va_arg(*ap, ptrdiff_t);
+    default:
+        return va_arg(*ap, unsigned int);
+    }
+}
+
+/* Returns EINVAL if the message has to be formatted instead */
+static errno_t debug_ring_add_trace(const char *function, int level,
+                                    const char *format, va_list *ap)
+{
+    union debug_trace_arg args[DEBUG_TRACE_MAX_ARGS];
+    char strs[DEBUG_TRACE_MAX_STRS];
+    struct debug_trace_spec spec;
+    struct debug_trace_rec *trace;
+    struct debug_ring_rec *rec;
+    const char *p;
+    const char *str;
+    size_t strs_len = 0;
+    size_t num_args = 0;
+    size_t len;
+    size_t size;
+    int i;
+
+    for (p = strchr(format, '%'); p != NULL; p = strchr(p, '%')) {
+        p = debug_trace_parse_spec(p, &spec);
+        if (p == NULL) {
+            return EINVAL;
+        }
+
+        if (spec.type == DEBUG_TRACE_LITERAL) {
+            continue;
+        }
+
+        if (num_args + spec.num_stars + 1 > DEBUG_TRACE_MAX_ARGS) {
+            return EINVAL;
+        }
+
+        for (i = 0; i < spec.num_stars; i++) {
+            args[num_args].i = va_arg(*ap, int);
+            num_args++;
+        }
+
+        switch (spec.type) {
+        case DEBUG_TRACE_INT:
+            args[num_args].i = debug_trace_get_int(spec.mod, ap);
+            break;
+        case DEBUG_TRACE_UINT:
+            args[num_args].u = debug_trace_get_uint(spec.mod, ap);
+            break;
+        case DEBUG_TRACE_DOUBLE:
+            args[num_args].d = va_arg(*ap, double);
+            break;
+        case DEBUG_TRACE_PTR:
+            args[num_args].p = va_arg(*ap, void *);
+            break;
+        case DEBUG_TRACE_STR:
+            /* the string might be gone when the message is dumped */
+            str = va_arg(*ap, const char *);
+            if (str == NULL) {
+                args[num_args].s = DEBUG_TRACE_NULL_STR;
+                break;
+            }
+            if (strs_len >= sizeof(strs)) {
+                /* no space left for the string */
+                return EINVAL;
+            }
+            len = strnlen(str, DEBUG_TRACE_MAX_STR - 1);
+            if (len + 1 > sizeof(strs) - strs_len) {
+                len = sizeof(strs) - strs_len - 1;
+            }
+            memcpy(strs + strs_len, str, len);
+            strs[strs_len + len] = '\0';
+            args[num_args].s = strs_len;
+            strs_len += len + 1;
+            break;
+        case DEBUG_TRACE_LITERAL:
+            break;
+        }
+        num_args++;
+    }
+
+    size = sizeof(struct debug_trace_rec)
+           + num_args * sizeof(union debug_trace_arg) + strs_len;
+
+    rec = debug_ring_reserve(sizeof(struct debug_ring_rec) + size, false);
+    if (rec == NULL) {
+        return EOK;
+    }
+    rec->text_len = size;
+    rec->flags = DEBUG_RING_TRACE;
+
+    trace = (struct debug_trace_rec *)rec->text;
+    if (debug_timestamps) {
+        gettimeofday(&trace->tv, NULL);
+    } else {
+        memset(&trace->tv, 0, sizeof(struct timeval));
+    }
+    trace->function = function;
+    trace->format = format;
+    trace->level = level;
+    trace->num_args = num_args;
+    memcpy(trace->args, args, num_args * sizeof(union debug_trace_arg));
+    memcpy(&trace->args[num_args], strs, strs_len);
+
+    return EOK;
+}
+
+/* Formats a DEBUG_RING_TRACE record, returns the length of the line */
+static size_t debug_trace_format(struct debug_trace_rec *trace,
+                                 char *line, size_t size)
+{
+    struct debug_trace_spec spec;
+    union debug_trace_arg *arg = trace->args;
+    const char *strs = (const char *)&trace->args[trace->num_args];
+    const char *p;
+    const char *next;
+    char fmt[64];
+    size_t flen;
+    size_t used;
+    int ret;
+
+    ret = debug_format_prefix(line, size, &trace->tv, trace->function,
+                              trace->level);
+    if (ret < 0) {
+        return 0;
+    }
+    used = ret;
+
+    for (p = trace->format; *p != '\0' && used + 1 < size; p = next) {
+        if (*p != '%') {
+            next = strchr(p, '%');
+            if (next == NULL) {
+                next = p + strlen(p);
+            }
+            flen = MIN((size_t)(next - p), size - used - 1);
+            memcpy(line + used, p, flen);
+            used += flen;
+            continue;
+        }
+
+        next = debug_trace_parse_spec(p, &spec);
+        if (next == NULL) {
+            /* cannot happen, the record would not have been stored */
+            break;
+        }
+
+        if (spec.type == DEBUG_TRACE_LITERAL) {
+            line[used] = '%';
+            used++;
+            continue;
+        }
+
+        /* flags, width and precision with '*' replaced by the value */
+        flen = 0;
+        for (; p < spec.length && flen < sizeof(fmt) - 16; p++) {
+            if (*p == '*') {
+                ret = snprintf(fmt + flen, sizeof(fmt) - flen - 16,
+                               "%d", (int)arg->i);
+                flen += ret > 0 ? ret : 0;
+                arg++;
+            } else {
+                fmt[flen] = *p;
+                flen++;
+            }
+        }
+
+        /* the values are stored with the widest type, short and char values
+         * keep their modifier and are passed as int so that they are
+         * converted the same way as by printf() */
+        if ((spec.type == DEBUG_TRACE_INT || spec.type == DEBUG_TRACE_UINT)
+                && spec.conv != 'c') {
+            if (spec.mod == 'h' || spec.mod == 'H') {
+                fmt[flen++] = 'h';
+                if (spec.mod == 'H') {
+                    fmt[flen++] = 'h';
+                }
+            } else {
+                fmt[flen++] = 'l';
+                fmt[flen++] = 'l';
+            }
+        }
+        fmt[flen++] = spec.conv;
+        fmt[flen] = '\0';
+
+        switch (spec.type) {
+        case DEBUG_TRACE_INT:
+            if (spec.conv == 'c' || spec.mod == 'h' || spec.mod == 'H') {
+                ret = snprintf(line + used, size - used, fmt, (int)arg->i);
+            } else {
+                ret = snprintf(line + used, size - used, fmt, arg->i);
+            }
+            break;
+        case DEBUG_TRACE_UINT:
+            if (spec.mod == 'h' || spec.mod == 'H') {
+                ret = snprintf(line + used, size - used, fmt,
+                               (unsigned int)arg->u);
+            } else {
+                ret = snprintf(line + used, size - used, fmt, arg->u);
+            }
+            break;
+        case DEBUG_TRACE_DOUBLE:
+            ret = snprintf(line + used, size - used, fmt, arg->d);
+            break;
+        case DEBUG_TRACE_PTR:
+            ret = snprintf(line + used, size - used, fmt, arg->p);
+            break;
+        case DEBUG_TRACE_STR:
+            ret = snprintf(line + used, size - used, fmt,
+                           arg->s == DEBUG_TRACE_NULL_STR ? "(null)"
+                                                          : strs + arg->s);
+            break;
+        case DEBUG_TRACE_LITERAL:
+            ret = 0;
+            break;
+        }
+        arg++;
+
+        if (ret < 0) {
+            break;
+        }
+        used = MIN(used + ret, size - 1);
+    }
+
+    if (used + 1 >= size) {
+        /* truncated, keep the line terminated */
+        used = size - 1;
+        line[used - 1] = '\n';
+    }
+    line[used] = '\0';
+
+    return used;
+}
+
+static void debug_ring_add_line(const char *function, int level,
+                                bool to_file, const char *format, va_list ap)
+{
+    char line[DEBUG_RING_MAX_LINE];
+    struct debug_ring_rec *rec;
+    int plen;
+    int mlen;
+
+    plen = debug_format_prefix(line, sizeof(line), NULL, function, level);
+    if (plen < 0) {
+        return;
+    }
+    if ((size_t)plen >= sizeof(line)) {
+        plen = sizeof(line) - 1;
+    }
+
+    mlen = vsnprintf(line + plen, sizeof(line) - plen, format, ap);
+    if (mlen < 0) {
+        return;
+    }
+    if ((size_t)mlen >= sizeof(line) - plen) {
+        /* truncated, keep the line terminated */
+        mlen = sizeof(line) - plen - 1;
+        line[plen + mlen - 1] = '\n';
+    }
+
+    rec = debug_ring_reserve(sizeof(struct debug_ring_rec) + plen + mlen,
+                             to_file);
+    if (rec == NULL) {
+        return;
+    }
+
+    rec->text_len = plen + mlen;
+    rec->flags = to_file ? DEBUG_RING_TO_FILE : 0;
+    memcpy(rec->text, line, plen + mlen);
+
+    if (!to_file) {
+        return;
+    }
+
+    if (level & (SSSDBG_FATAL_FAILURE | SSSDBG_CRIT_FAILURE)) {
+        /* the process might be about to go away */
+        debug_ring_flush();
+    } else if (debug_ring.head - debug_ring.flushed > debug_ring.size / 2) {
+        debug_ring_flush();
+    } else if (debug_ring.notify != NULL) {
+        debug_ring.notify(debug_ring.notify_pvt);
+    }
+}
+
+static void debug_ring_add(const char *function, int level, bool to_file,
+                           const char *format, va_list ap)
+{
+    va_list ap_trace;
+    errno_t ret;
+
+    if (!to_file) {
+        va_copy(ap_trace, ap);
+        ret = debug_ring_add_trace(function, level, format, &ap_trace);
+        va_end(ap_trace);
+        if (ret == EOK) {
+            return;
+        }
+        /* the arguments cannot be stored, format the message now */
+    }
+
+    debug_ring_add_line(function, level, to_file, format, ap);
+}
+
+void debug_ring_flush(void)
+{
+    struct iovec iov[DEBUG_RING_IOV];
+    struct debug_ring_rec *rec;
+    char msg[128];
+    int n = 0;
+
+    if (debug_ring.buf == NULL) {
+        return;
+    }
+
+    while (debug_ring.flushed < debug_ring.head) {
+        rec = debug_ring_rec_at(debug_ring.flushed);
+        if (rec->flags & DEBUG_RING_TO_FILE) {
+            iov[n].iov_base = rec->text;
+            iov[n].iov_len = rec->text_len;
+            n++;
+        }
+        debug_ring.flushed += rec->len;
+
+        if (n == DEBUG_RING_IOV) {
+            debug_write_all(iov, n);
+            n = 0;
+        }
+    }
+
+    if (debug_ring.dropped > 0 && n < DEBUG_RING_IOV) {
+        iov[n].iov_base = msg;
+        iov[n].iov_len = snprintf(msg, sizeof(msg),
+                                  "[%s] [%s]: %"PRIu64" debug messages "
+                                  "dropped, the debug buffer was full\n",
+                                  debug_prg_name, __FUNCTION__,
+                                  debug_ring.dropped);
+        n++;
+        debug_ring.dropped = 0;
+    }
+
+    if (n > 0) {
+        debug_write_all(iov, n);
+    }
+}
+
+struct debug_dump_buf {
+    char data[8192];
+    size_t used;
+};
+
+static void debug_dump_write(struct debug_dump_buf *out,
+                             const char *text, size_t len)
+{
+    struct iovec iov;
+
+    if (out->used + len > sizeof(out->data)) {
+        iov.iov_base = out->data;
+        iov.iov_len = out->used;
+        debug_write_all(&iov, 1);
+        out->used = 0;
+    }
+
+    memcpy(out->data + out->used, text, len);
+    out->used += len;
+}
+
+void debug_ring_dump(const char *reason)
+{
+    struct debug_dump_buf out;
+    struct debug_ring_rec *rec;
+    struct iovec iov;
+    char line[DEBUG_RING_MAX_LINE];
+    uint64_t pos;
+    size_t len;
+    bool found = false;
+
+    if (debug_ring.buf == NULL) {
+        return;
+    }
+
+    debug_ring_flush();
+
+    /* Only the messages which are not in the log yet and were not dumped
+     * before are written */
+    out.used = 0;
+    pos = MAX(debug_ring.tail, debug_ring.dumped);
+    for (; pos < debug_ring.head; pos += rec->len) {
+        rec = debug_ring_rec_at(pos);
+        if (rec->flags & (DEBUG_RING_PAD | DEBUG_RING_TO_FILE)) {
+            continue;
+        }
+
+        if (!found) {
+            len = snprintf(line, sizeof(line),
+                           "[%s] ---- begin of debug buffer dump (%s) ----\n",
+                           debug_prg_name, reason);
+            debug_dump_write(&out, line, MIN(len, sizeof(line) - 1));
+            found = true;
+        }
+
+        if (rec->flags & DEBUG_RING_TRACE) {
+            len = debug_trace_format((struct debug_trace_rec *)rec->text,
+                                     line, sizeof(line));
+            debug_dump_write(&out, line, len);
+        } else {
+            debug_dump_write(&out, rec->text, rec->text_len);
+        }
+    }
+    debug_ring.dumped = debug_ring.head;
+
+    if (!found) {
+        return;
+    }
+
+    len = snprintf(line, sizeof(line),
+                   "[%s] ---- end of debug buffer dump ----\n",
+                   debug_prg_name);
+    debug_dump_write(&out, line, MIN(len, sizeof(line) - 1));
+
+    iov.iov_base = out.data;
+    iov.iov_len = out.used;
+    debug_write_all(&iov, 1);
+}
+
 static void debug_vprintf(const char *format, va_list ap)
 {
     vfprintf(debug_file ? debug_file : stderr, format, ap);
@@ -204,16 +1058,23 @@ void debug_fn(const char *file,
               const char *format, ...)
 {
     va_list ap;
-    struct timeval tv;
-    struct tm *tm;
-    char datetime[20];
-    int year;
+    char prefix[256];
+    bool to_file;
 
 #ifdef WITH_JOURNALD
     errno_t ret;
     va_list ap_fallback;
+#endif
+
+    /* the message might be wanted for the debug buffer only */
+    to_file = DEBUG_LEVEL_IS_SET(level);
 
+#ifdef WITH_JOURNALD
     if (!debug_file && !debug_to_stderr) {
+        if (!to_file) {
+            return;
+        }
+
         /* If we are not outputting logs to files, we should be sending them
          * to journald.
          * NOTE: on modern systems, this is where stdout/stderr will end up
@@ -235,28 +1096,20 @@ void debug_fn(const char *file,
     }
 #endif
 
-    if (debug_timestamps) {
-        gettimeofday(&tv, NULL);
-        tm = localtime(&tv.tv_sec);
-        year = tm->tm_year + 1900;
-        /* get date time without year */
-        memcpy(datetime, ctime(&tv.tv_sec), 19);
-        datetime[19] = '\0';
-        if (debug_microseconds) {
-            debug_printf("(%s:%.6ld %d) [%s] [%s] (%#.4x): ",
-                         datetime, tv.tv_usec,
-                         year, debug_prg_name,
-                         function, level);
-        } else {
-            debug_printf("(%s %d) [%s] [%s] (%#.4x): ",
-                         datetime, year,
-                         debug_prg_name, function, level);
-        }
-    } else {
-        debug_printf("[%s] [%s] (%#.4x): ",
-                     debug_prg_name, function, level);
+    if (debug_ring.buf != NULL) {
+        va_start(ap, format);
+        debug_ring_add(function, level, to_file, format, ap);
+        va_end(ap);
+        return;
+    }
+
+    if (!to_file) {
+        return;
     }
 
+    debug_format_prefix(prefix, sizeof(prefix), NULL, function, level);
+    debug_printf("%s", prefix);
+
     va_start(ap, format);
     debug_vprintf(format, ap);
     va_end(ap);
@@ -351,7 +1204,10 @@ int open_debug_file_ex(const char *filename, FILE **filep, bool want_cloexec)
         return ENOMEM;
     }
 
-    if (debug_file && !filep) fclose(debug_file);
+    if (debug_file && !filep) {
+        debug_ring_flush();
+        fclose(debug_file);
+    }
 
     old_umask = umask(0177);
     errno = 0;
@@ -397,6 +1253,8 @@ int rotate_debug_files(void)
 
     if (!debug_to_file) return EOK;
 
+    debug_ring_flush();
+
     do {
         error = 0;
         ret = fclose(debug_file);
@@ -79,12 +79,21 @@ typedef uint32_t rel_ptr_t;
 
 
 #define SSS_MC_MAJOR_VNO    1
-#define SSS_MC_MINOR_VNO    0
+#define SSS_MC_MINOR_VNO    1
 
 #define SSS_MC_HEADER_UNINIT    0   /* after ftruncate or before reset */
 #define SSS_MC_HEADER_ALIVE     1   /* current and in use */
 #define SSS_MC_HEADER_RECYCLED  2   /* file was recycled, reopen asap */
 
+/* Negative records tell the clients that sssd does not know the requested
+ * name or id. They carry the same data as regular records with an empty
+ * string set and are chained with the same hash twice. */
+#define SSS_MC_REC_NEG_NAME     0x00000001  /* no entry with this name */
+#define SSS_MC_REC_NEG_ID       0x00000002  /* no entry with this id */
+#define SSS_MC_REC_NEGATIVE     (SSS_MC_REC_NEG_NAME | SSS_MC_REC_NEG_ID)
+#define SSS_MC_REC_SID_BY_ID    0x00000004  /* the sid record is the answer
+                                             * for a lookup by its id */
+
 #pragma pack(1)
 struct sss_mc_header {
     uint32_t b1;            /* barrier 1 */
@@ -112,7 +121,7 @@ struct sss_mc_rec {
                             /* next2 is related to hash2 */
     uint32_t hash1;         /* val of first hash (usually name of record) */
     uint32_t hash2;         /* val of second hash (usually id of record) */
-    uint32_t padding;       /* padding & reserved for future changes */
+    uint32_t flags;         /* SSS_MC_REC_* flags, 0 for regular records */
     uint32_t b2;            /* barrier 2 - 32 bytes mark, fits a slot */
     char data[0];
 };
@@ -136,6 +145,15 @@ struct sss_mc_grp_data {
                              * string is zero terminated ordered as follows:
                              * name, passwd, member1, member2, ... */
 };
+struct sss_mc_sid_data {
+    rel_ptr_t sid;          /* ptr to sid string, rel. to struct base addr */
+    uint32_t id;
+    uint32_t type;          /* enum sss_id_type */
+    uint32_t strs_len;      /* length of strs */
+    char strs[0];           /* concatenation of all sid strings, each
+                             * string is zero terminated ordered as follows:
+                             * sid, fully qualified name (empty if unknown) */
+};
 #pragma pack()
 
 
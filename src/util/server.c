@@ -417,6 +417,133 @@ errno_t server_common_rotate_logs(struct confdb_ctx *confdb,
     return EOK;
 }
 
+/* Buffered debug messages are written to the log at most this often */
+#define DEBUG_FLUSH_INTERVAL_MSEC 100
+
+struct debug_flush_ctx {
+    struct tevent_context *ev;
+    struct tevent_timer *te;
+};
+
+static void server_debug_flush_handler(struct tevent_context *ev,
+                                       struct tevent_timer *te,
+                                       struct timeval current_time,
+                                       void *private_data)
+{
+    struct debug_flush_ctx *fctx =
+            talloc_get_type(private_data, struct debug_flush_ctx);
+
+    fctx->te = NULL;
+    debug_ring_flush();
+}
+
+static void server_debug_schedule_flush(void *pvt)
+{
+    struct debug_flush_ctx *fctx = talloc_get_type(pvt,
+                                                   struct debug_flush_ctx);
+    struct timeval tv;
+
+    if (fctx->te != NULL) {
+        return;
+    }
+
+    tv = tevent_timeval_current_ofs(0, DEBUG_FLUSH_INTERVAL_MSEC * 1000);
+    fctx->te = tevent_add_timer(fctx->ev, fctx, tv,
+                                server_debug_flush_handler, fctx);
+    if (fctx->te == NULL) {
+        /* better slow than lost */
+        debug_ring_flush();
+    }
+}
+
+static int debug_flush_ctx_destructor(struct debug_flush_ctx *fctx)
+{
+    debug_ring_set_notify(NULL, NULL);
+    debug_ring_flush();
+    return 0;
+}
+
+static void te_server_debug_dump(struct tevent_context *ev,
+                                 struct tevent_signal *se,
+                                 int signum,
+                                 int count,
+                                 void *siginfo,
+                                 void *private_data)
+{
+    debug_ring_dump("signal");
+}
+
+static errno_t server_setup_debug_buffer(struct main_context *ctx,
+                                         const char *conf_entry)
+{
+    struct debug_flush_ctx *fctx;
+    struct tevent_signal *tes;
+    int buffer_size;
+    int buffer_level;
+    errno_t ret;
+
+    ret = confdb_get_int(ctx->confdb_ctx, conf_entry,
+                         CONFDB_SERVICE_DEBUG_BUFFER_SIZE, 0, &buffer_size);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error reading from confdb (%d) [%s]\n",
+                                     ret, strerror(ret));
+        return ret;
+    }
+
+    if (buffer_size <= 0) {
+        return EOK;
+    }
+
+    ret = confdb_get_int(ctx->confdb_ctx, conf_entry,
+                         CONFDB_SERVICE_DEBUG_BUFFER_LEVEL, 0, &buffer_level);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error reading from confdb (%d) [%s]\n",
+                                     ret, strerror(ret));
+        return ret;
+    }
+
+    fctx = talloc_zero(ctx, struct debug_flush_ctx);
+    if (fctx == NULL) {
+        return ENOMEM;
+    }
+    fctx->ev = ctx->event_ctx;
+
+    ret = debug_ring_init((size_t)buffer_size * 1024);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_CRIT_FAILURE,
+              "Cannot set up a debug buffer of %d KiB [%d]: %s, "
+              "debug messages are not buffered\n",
+              buffer_size, ret, sss_strerror(ret));
+        talloc_free(fctx);
+        return EOK;
+    }
+
+    debug_ring_set_notify(server_debug_schedule_flush, fctx);
+    talloc_set_destructor(fctx, debug_flush_ctx_destructor);
+
+    if (buffer_level > 0) {
+        debug_ring_level = debug_convert_old_level(buffer_level);
+    }
+
+#ifdef SIGRTMIN
+    /* SIGUSR1 and SIGUSR2 are already taken by the monitor and the back
+     * ends */
+    BlockSignals(false, SIGRTMIN);
+    tes = tevent_add_signal(ctx->event_ctx, fctx, SIGRTMIN, 0,
+                            te_server_debug_dump, NULL);
+    if (tes == NULL) {
+        DEBUG(SSSDBG_MINOR_FAILURE,
+              "Cannot set up the signal handler for debug buffer dumps\n");
+    }
+#endif
+
+    DEBUG(SSSDBG_CONF_SETTINGS,
+          "Debug messages are buffered in %d KiB, buffer level %#.4x\n",
+          buffer_size, debug_ring_level);
+
+    return EOK;
+}
+
 static const char *get_db_path(void)
 {
 #ifdef UNIT_TESTING
@@ -638,6 +765,13 @@ int server_setup(const char *name, int flags,
         }
     }
 
+    ret = server_setup_debug_buffer(ctx, conf_entry);
+    if (ret != EOK) {
+        DEBUG(SSSDBG_FATAL_FAILURE, "Error setting up debug buffer (%d) "
+                                     "[%s]\n", ret, strerror(ret));
+        return ret;
+    }
+
     sss_log(SSS_LOG_INFO, "Starting up");
 
     DEBUG(SSSDBG_TRACE_FUNC, "CONFDB: %s\n", conf_db);
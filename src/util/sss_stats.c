@@ -0,0 +1,359 @@
+/*
+    SSSD
+
+    sss_stats.c - Per-process counters and latency histograms
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/util.h"
+#include "util/murmurhash3.h"
+#include "util/sss_stats.h"
+
+/* The histograms use the same log-linear layout as HdrHistogram: values
+ * below 2 * SUB_COUNT have a bucket each, every higher power of two is split
+ * into SUB_COUNT buckets of equal width. The bucket index is then computed
+ * from the position of the highest bit and the SUB_BITS bits below it. */
+#define SSS_STATS_SUB_BITS 4
+#define SSS_STATS_SUB_COUNT (1 << SSS_STATS_SUB_BITS)
+#define SSS_STATS_MAX_BITS 40
+#define SSS_STATS_MAX_VALUE ((UINT64_C(1) << SSS_STATS_MAX_BITS) - 1)
+#define SSS_STATS_BUCKETS \
+    ((SSS_STATS_MAX_BITS - SSS_STATS_SUB_BITS + 1) * SSS_STATS_SUB_COUNT)
+
+/* twice the number of metrics to keep the probe sequences short */
+#define SSS_STATS_TABLE_SIZE (2 * SSS_STATS_MAX_METRICS)
+
+enum sss_stats_type {
+    SSS_STATS_COUNTER,
+    SSS_STATS_GAUGE,
+    SSS_STATS_HISTOGRAM
+};
+
+struct sss_stats_hist {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t buckets[SSS_STATS_BUCKETS];
+};
+
+struct sss_stats_metric {
+    char *name;
+    enum sss_stats_type type;
+    int64_t value;
+    struct sss_stats_hist *hist;
+};
+
+static struct sss_stats_metric sss_stats_table[SSS_STATS_TABLE_SIZE];
+static size_t sss_stats_num_metrics;
+
+static struct sss_stats_metric *sss_stats_find(const char *name,
+                                               enum sss_stats_type type,
+                                               bool create)
+{
+    struct sss_stats_metric *metric;
+    size_t len;
+    uint32_t i;
+    uint32_t n;
+
+    if (name == NULL) {
+        return NULL;
+    }
+
+    len = strlen(name);
+    i = murmurhash3(name, len, 0) % SSS_STATS_TABLE_SIZE;
+
+    for (n = 0; n < SSS_STATS_TABLE_SIZE; n++) {
+        metric = &sss_stats_table[(i + n) % SSS_STATS_TABLE_SIZE];
+        if (metric->name == NULL) {
+            break;
+        }
+        if (strcmp(metric->name, name) == 0) {
+            return metric->type == type ? metric : NULL;
+        }
+    }
+
+    if (!create || n == SSS_STATS_TABLE_SIZE
+            || sss_stats_num_metrics >= SSS_STATS_MAX_METRICS) {
+        return NULL;
+    }
+
+    if (type == SSS_STATS_HISTOGRAM) {
+        metric->hist = calloc(1, sizeof(struct sss_stats_hist));
+        if (metric->hist == NULL) {
+            return NULL;
+        }
+    }
+
+    metric->name = strdup(name);
+    if (metric->name == NULL) {
+        free(metric->hist);
+        metric->hist = NULL;
+        return NULL;
+    }
+    metric->type = type;
+    metric->value = 0;
+    sss_stats_num_metrics++;
+
+    return metric;
+}
+
+void sss_stats_count(const char *name, uint64_t n)
+{
+    struct sss_stats_metric *metric;
+
+    metric = sss_stats_find(name, SSS_STATS_COUNTER, true);
+    if (metric != NULL) {
+        metric->value += n;
+    }
+}
+
+void sss_stats_gauge_add(const char *name, int64_t delta)
+{
+    struct sss_stats_metric *metric;
+
+    metric = sss_stats_find(name, SSS_STATS_GAUGE, true);
+    if (metric != NULL) {
+        metric->value += delta;
+    }
+}
+
+static size_t sss_stats_bucket(uint64_t value)
+{
+    unsigned int shift;
+
+    if (value < 2 * SSS_STATS_SUB_COUNT) {
+        return value;
+    }
+
+    shift = 63 - __builtin_clzll(value) - SSS_STATS_SUB_BITS;
+    return (shift + 1) * SSS_STATS_SUB_COUNT
+           + (value >> shift) - SSS_STATS_SUB_COUNT;
+}
+
+/* Highest value which falls into the bucket */
+static uint64_t sss_stats_bucket_value(size_t bucket)
+{
+    unsigned int shift;
+    uint64_t sub;
+
+    if (bucket < 2 * SSS_STATS_SUB_COUNT) {
+        return bucket;
+    }
+
+    shift = bucket / SSS_STATS_SUB_COUNT - 1;
+    sub = bucket % SSS_STATS_SUB_COUNT;
+    return ((SSS_STATS_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+void sss_stats_record(const char *name, uint64_t usec)
+{
+    struct sss_stats_metric *metric;
+    struct sss_stats_hist *hist;
+
+    metric = sss_stats_find(name, SSS_STATS_HISTOGRAM, true);
+    if (metric == NULL) {
+        return;
+    }
+    hist = metric->hist;
+
+    if (usec > SSS_STATS_MAX_VALUE) {
+        usec = SSS_STATS_MAX_VALUE;
+    }
+
+    if (hist->count == 0 || usec < hist->min) {
+        hist->min = usec;
+    }
+    if (usec > hist->max) {
+        hist->max = usec;
+    }
+    hist->count++;
+    hist->sum += usec;
+    hist->buckets[sss_stats_bucket(usec)]++;
+}
+
+void sss_stats_record_since(const char *name, const struct timeval *start)
+{
+    struct timeval now;
+    int64_t usec;
+
+    gettimeofday(&now, NULL);
+    usec = (now.tv_sec - start->tv_sec) * 1000000LL
+           + (now.tv_usec - start->tv_usec);
+
+    /* the clock was set back */
+    if (usec < 0) {
+        usec = 0;
+    }
+
+    sss_stats_record(name, usec);
+}
+
+static uint64_t sss_stats_percentile(struct sss_stats_hist *hist,
+                                     unsigned int permille)
+{
+    uint64_t rank;
+    uint64_t seen = 0;
+    uint64_t value;
+    size_t i;
+
+    /* the smallest value such that permille of the values are equal to or
+     * lower than it */
+    rank = (hist->count * permille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    for (i = 0; i < SSS_STATS_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            break;
+        }
+    }
+
+    /* the bucket may be wider than the range of recorded values */
+    value = sss_stats_bucket_value(i);
+    if (value > hist->max) {
+        value = hist->max;
+    }
+    if (value < hist->min) {
+        value = hist->min;
+    }
+
+    return value;
+}
+
+static void sss_stats_summarize(struct sss_stats_hist *hist,
+                                struct sss_stats_summary *summary)
+{
+    summary->count = hist->count;
+    summary->sum = hist->sum;
+    summary->min = hist->min;
+    summary->max = hist->max;
+    summary->p50 = sss_stats_percentile(hist, 500);
+    summary->p90 = sss_stats_percentile(hist, 900);
+    summary->p99 = sss_stats_percentile(hist, 990);
+    summary->p999 = sss_stats_percentile(hist, 999);
+}
+
+errno_t sss_stats_get_summary(const char *name,
+                              struct sss_stats_summary *summary)
+{
+    struct sss_stats_metric *metric;
+
+    metric = sss_stats_find(name, SSS_STATS_HISTOGRAM, false);
+    if (metric == NULL || metric->hist->count == 0) {
+        return ENOENT;
+    }
+
+    sss_stats_summarize(metric->hist, summary);
+    return EOK;
+}
+
+int64_t sss_stats_get_value(const char *name)
+{
+    struct sss_stats_metric *metric;
+
+    metric = sss_stats_find(name, SSS_STATS_COUNTER, false);
+    if (metric == NULL) {
+        metric = sss_stats_find(name, SSS_STATS_GAUGE, false);
+    }
+
+    return metric == NULL ? 0 : metric->value;
+}
+
+static int sss_stats_metric_cmp(const void *a, const void *b)
+{
+    const struct sss_stats_metric *m1 = *(struct sss_stats_metric * const *)a;
+    const struct sss_stats_metric *m2 = *(struct sss_stats_metric * const *)b;
+
+    return strcmp(m1->name, m2->name);
+}
+
+errno_t sss_stats_dump(TALLOC_CTX *mem_ctx, char **_text)
+{
+    struct sss_stats_metric *metrics[SSS_STATS_MAX_METRICS];
+    struct sss_stats_summary s;
+    size_t num = 0;
+    char *text;
+    size_t i;
+
+    for (i = 0; i < SSS_STATS_TABLE_SIZE; i++) {
+        if (sss_stats_table[i].name != NULL) {
+            metrics[num++] = &sss_stats_table[i];
+        }
+    }
+    qsort(metrics, num, sizeof(struct sss_stats_metric *),
+          sss_stats_metric_cmp);
+
+    text = talloc_strdup(mem_ctx, "");
+    if (text == NULL) {
+        return ENOMEM;
+    }
+
+    for (i = 0; i < num && text != NULL; i++) {
+        switch (metrics[i]->type) {
+        case SSS_STATS_COUNTER:
+            text = talloc_asprintf_append(text, "counter %s %"PRIi64"\n",
+                                          metrics[i]->name,
+                                          metrics[i]->value);
+            break;
+        case SSS_STATS_GAUGE:
+            text = talloc_asprintf_append(text, "gauge %s %"PRIi64"\n",
+                                          metrics[i]->name,
+                                          metrics[i]->value);
+            break;
+        case SSS_STATS_HISTOGRAM:
+            if (metrics[i]->hist->count == 0) {
+                continue;
+            }
+            sss_stats_summarize(metrics[i]->hist, &s);
+            text = talloc_asprintf_append(text, "histogram %s "
+                                          "count=%"PRIu64" sum=%"PRIu64" "
+                                          "min=%"PRIu64" p50=%"PRIu64" "
+                                          "p90=%"PRIu64" p99=%"PRIu64" "
+                                          "p99.9=%"PRIu64" max=%"PRIu64"\n",
+                                          metrics[i]->name, s.count, s.sum,
+                                          s.min, s.p50, s.p90, s.p99, s.p999,
+                                          s.max);
+            break;
+        }
+    }
+
+    if (text == NULL) {
+        return ENOMEM;
+    }
+
+    *_text = text;
+    return EOK;
+}
+
+void sss_stats_reset(void)
+{
+    size_t i;
+
+    for (i = 0; i < SSS_STATS_TABLE_SIZE; i++) {
+        free(sss_stats_table[i].name);
+        free(sss_stats_table[i].hist);
+    }
+
+    memset(sss_stats_table, 0, sizeof(sss_stats_table));
+    sss_stats_num_metrics = 0;
+}
@@ -0,0 +1,76 @@
+/*
+    SSSD
+
+    sss_stats.h - Per-process counters and latency histograms
+
+    Copyright (C) 2026 Red Hat
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SSS_STATS_H__
+#define __SSS_STATS_H__
+
+#include <sys/time.h>
+
+#include "util/util.h"
+
+/* Metrics are identified by a name and created on first use. Counters only
+ * grow, gauges can go up and down (e.g. the number of requests in flight)
+ * and histograms record latencies in microseconds with a relative error of
+ * at most 1/16 of the recorded value.
+ *
+ * The metrics live in static memory of the process, no locking is done as
+ * every SSSD process runs a single event loop. If the table is full, new
+ * metrics are silently ignored. */
+
+#define SSS_STATS_MAX_METRICS 256
+
+void sss_stats_count(const char *name, uint64_t n);
+
+void sss_stats_gauge_add(const char *name, int64_t delta);
+
+void sss_stats_record(const char *name, uint64_t usec);
+
+/* Records the time elapsed since start. */
+void sss_stats_record_since(const char *name, const struct timeval *start);
+
+struct sss_stats_summary {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+/* Returns ENOENT if the histogram was never recorded. */
+errno_t sss_stats_get_summary(const char *name,
+                              struct sss_stats_summary *summary);
+
+/* Returns the value of a counter or gauge, 0 if it does not exist. */
+int64_t sss_stats_get_value(const char *name);
+
+/* Formats all metrics, one per line:
+ *   counter <name> <value>
+ *   gauge <name> <value>
+ *   histogram <name> count=N sum=S min=M p50=.. p90=.. p99=.. p99.9=.. max=X
+ * Histogram values are in microseconds. */
+errno_t sss_stats_dump(TALLOC_CTX *mem_ctx, char **_text);
+
+void sss_stats_reset(void);
+
+#endif /* __SSS_STATS_H__ */
@@ -72,6 +72,8 @@ static int sss_names_ctx_destructor(struct sss_names_ctx *snctx)
                          "((?P<name>[^@]+)@(?P<domain>.+$))|" \
                          "(^(?P<name>[^@\\\\]+)$))"
 
+#define SSS_DEFAULT_RE "(?P<name>[^@]+)@?(?P<domain>[^@]*$)"
+
 static errno_t get_id_provider_default_re(TALLOC_CTX *mem_ctx,
                                           struct confdb_ctx *cdb,
                                           const char *conf_path,
@@ -128,9 +130,120 @@ done:
 #endif
 }
 
+/* Arguments of the fq format: name, domain name, flat domain name */
+#define SSS_FQ_ARGS 3
+
+struct sss_fq_piece {
+    const char *str;        /* literal text, NULL for an argument */
+    size_t len;
+    int arg;
+};
+
+struct sss_fq_plan {
+    size_t count;
+    struct sss_fq_piece *pieces;
+};
+
+/* Splits the format into literals and plain %s or %N$s fields once, so that
+ * formatting a name is a sequence of copies. Returns EINVAL for formats
+ * which need safe_format_string() for the field widths and flags. */
+static errno_t sss_fq_plan_compile(TALLOC_CTX *mem_ctx, const char *fq_fmt,
+                                   struct sss_fq_plan **_plan)
+{
+    struct sss_fq_plan *plan;
+    struct sss_fq_piece *piece;
+    const char *cp = fq_fmt;
+    int next_arg = 0;
+    size_t len;
+
+    plan = talloc_zero(mem_ctx, struct sss_fq_plan);
+    if (plan == NULL) {
+        return ENOMEM;
+    }
+
+    /* each piece covers at least one character of the format */
+    plan->pieces = talloc_zero_array(plan, struct sss_fq_piece,
+                                     strlen(fq_fmt) + 1);
+    if (plan->pieces == NULL) {
+        talloc_free(plan);
+        return ENOMEM;
+    }
+
+    while (*cp != '\0') {
+        piece = &plan->pieces[plan->count];
+
+        if (*cp != '%') {
+            len = strcspn(cp, "%");
+            piece->str = cp;
+            piece->len = len;
+            cp += len;
+        } else if (cp[1] == '%') {
+            piece->str = cp;
+            piece->len = 1;
+            cp += 2;
+        } else if (cp[1] == 's') {
+            if (next_arg == SSS_FQ_ARGS) {
+                goto fail;
+            }
+            piece->arg = next_arg++;
+            cp += 2;
+        } else if (cp[1] >= '1' && cp[1] <= '0' + SSS_FQ_ARGS
+                       && cp[2] == '$' && cp[3] == 's') {
+            piece->arg = cp[1] - '1';
+            cp += 4;
+        } else {
+            goto fail;
+        }
+
+        plan->count++;
+    }
+
+    *_plan = plan;
+    return EOK;
+
+fail:
+    talloc_free(plan);
+    return EINVAL;
+}
+
+/* Same semantics as snprintf(), returns the length of the whole name */
+static int sss_fq_plan_format(struct sss_fq_plan *plan, char *str, size_t size,
+                              const char *args[SSS_FQ_ARGS])
+{
+    struct sss_fq_piece *piece;
+    const char *src;
+    size_t total = 0;
+    size_t len;
+    size_t i;
+
+    for (i = 0; i < plan->count; i++) {
+        piece = &plan->pieces[i];
+        if (piece->str != NULL) {
+            src = piece->str;
+            len = piece->len;
+        } else {
+            src = args[piece->arg] != NULL ? args[piece->arg] : "";
+            len = strlen(src);
+        }
+
+        if (total < size) {
+            memcpy(str + total, src,
+                   (size - total > len) ? len : size - total);
+        }
+        total += len;
+    }
+
+    if (size > 0) {
+        str[(total < size) ? total : size - 1] = '\0';
+    }
+
+    return total;
+}
+
 static errno_t sss_fqnames_init(struct sss_names_ctx *nctx, const char *fq_fmt)
 {
     char *fq;
+    errno_t ret;
 
     nctx->fq_fmt = talloc_strdup(nctx, fq_fmt);
     if (nctx->fq_fmt == NULL) {
@@ -139,6 +252,15 @@ static errno_t sss_fqnames_init(struct sss_names_ctx *nctx, const char *fq_fmt)
 
     DEBUG(SSSDBG_CONF_SETTINGS, "Using fq format [%s].\n", nctx->fq_fmt);
 
+    ret = sss_fq_plan_compile(nctx, nctx->fq_fmt, &nctx->fq_plan);
+    if (ret == EINVAL) {
+        DEBUG(SSSDBG_TRACE_FUNC,
+              "The fq format needs the full formatter [%s]\n", nctx->fq_fmt);
+        nctx->fq_plan = NULL;
+    } else if (ret != EOK) {
+        return ret;
+    }
+
     /* Fail if the name specifier is missing, or if the format is
      * invalid */
     fq = sss_tc_fqname2 (nctx, nctx, "unused.example.com", "unused", "the-test-user");
@@ -177,6 +299,12 @@ int sss_names_init_from_args(TALLOC_CTX *mem_ctx, const char *re_pattern,
 
     DEBUG(SSSDBG_CONF_SETTINGS, "Using re [%s].\n", ctx->re_pattern);
 
+    if (strcmp(ctx->re_pattern, SSS_DEFAULT_RE) == 0) {
+        ctx->builtin_re = SSS_NAMES_RE_DEFAULT;
+    } else if (strcmp(ctx->re_pattern, IPA_AD_DEFAULT_RE) == 0) {
+        ctx->builtin_re = SSS_NAMES_RE_IPA_AD;
+    }
+
     ret = sss_fqnames_init(ctx, fq_fmt);
     if (ret != EOK) {
         DEBUG(SSSDBG_OP_FAILURE, "Could not check the FQ names format"
@@ -249,8 +377,7 @@ int sss_names_init(TALLOC_CTX *mem_ctx, struct confdb_ctx *cdb,
     }
 
     if (!re_pattern) {
-        re_pattern = talloc_strdup(tmpctx,
-                                   "(?P<name>[^@]+)@?(?P<domain>[^@]*$)");
+        re_pattern = talloc_strdup(tmpctx, SSS_DEFAULT_RE);
         if (!re_pattern) {
             ret = ENOMEM;
             goto done;
@@ -295,6 +422,80 @@ done:
     return ret;
 }
 
+/* Splits the name like the built-in expressions would. Returns EAGAIN for
+ * inputs in unusual forms, e.g. with several separators, which are left to
+ * pcre. */
+static errno_t sss_parse_name_builtin(enum sss_names_re builtin_re,
+                                      const char *orig, size_t origlen,
+                                      size_t *_name_start, size_t *_name_len,
+                                      size_t *_dom_start, size_t *_dom_len)
+{
+    const char *at;
+    const char *bs;
+
+    /* '$' also matches before a trailing newline and '.' does not match
+     * a newline, leave such names to pcre */
+    if (origlen == 0 || memchr(orig, '\n', origlen) != NULL) {
+        return EAGAIN;
+    }
+
+    at = strchr(orig, '@');
+
+    switch (builtin_re) {
+    case SSS_NAMES_RE_DEFAULT:
+        /* name[@domain] */
+        if (at == NULL) {
+            *_name_start = 0;
+            *_name_len = origlen;
+            *_dom_start = origlen;
+            *_dom_len = 0;
+            return EOK;
+        }
+
+        if (at == orig || strchr(at + 1, '@') != NULL) {
+            return EAGAIN;
+        }
+        break;
+
+    case SSS_NAMES_RE_IPA_AD:
+        /* DOMAIN\name, name@domain or name */
+        bs = strchr(orig, '\\');
+        if (bs != NULL) {
+            if (bs == orig || bs == orig + origlen - 1) {
+                return EAGAIN;
+            }
+
+            *_dom_start = 0;
+            *_dom_len = bs - orig;
+            *_name_start = *_dom_len + 1;
+            *_name_len = origlen - *_name_start;
+            return EOK;
+        }
+
+        if (at == NULL) {
+            *_name_start = 0;
+            *_name_len = origlen;
+            *_dom_start = origlen;
+            *_dom_len = 0;
+            return EOK;
+        }
+
+        if (at == orig || at == orig + origlen - 1) {
+            return EAGAIN;
+        }
+        break;
+
+    default:
+        return EAGAIN;
+    }
+
+    *_name_start = 0;
+    *_name_len = at - orig;
+    *_dom_start = *_name_len + 1;
+    *_dom_len = origlen - *_dom_start;
+    return EOK;
+}
+
 int sss_parse_name(TALLOC_CTX *memctx,
                    struct sss_names_ctx *snctx,
                    const char *orig, char **_domain, char **_name)
@@ -304,9 +505,40 @@ int sss_parse_name(TALLOC_CTX *memctx,
     int ovec[30];
     int origlen;
     int ret, strnum;
+    size_t name_start;
+    size_t name_len;
+    size_t dom_start;
+    size_t dom_len;
 
     origlen = strlen(orig);
 
+    if (snctx->builtin_re != SSS_NAMES_RE_CUSTOM) {
+        ret = sss_parse_name_builtin(snctx->builtin_re, orig, origlen,
+                                     &name_start, &name_len,
+                                     &dom_start, &dom_len);
+        if (ret == EOK) {
+            if (_name != NULL) {
+                *_name = talloc_strndup(memctx, orig + name_start, name_len);
+                if (*_name == NULL) return ENOMEM;
+            }
+
+            if (_domain != NULL) {
+                if (dom_len == 0) {
+                    *_domain = NULL;
+                } else {
+                    *_domain = talloc_strndup(memctx, orig + dom_start,
+                                              dom_len);
+                    if (*_domain == NULL) {
+                        if (_name != NULL) talloc_zfree(*_name);
+                        return ENOMEM;
+                    }
+                }
+            }
+
+            return EOK;
+        }
+    }
+
     ret = pcre_exec(re, NULL, orig, origlen, 0, PCRE_NOTEMPTY, ovec, 30);
     if (ret == PCRE_ERROR_NOMATCH) {
         return ERR_REGEX_NOMATCH;
@@ -613,9 +845,22 @@ sss_tc_fqname2(TALLOC_CTX *mem_ctx, struct sss_names_ctx *nctx,
 {
     const char *args[] = { name, domain_name, flat_dom_name, NULL };
     char *output;
+    int len;
 
     if (nctx == NULL) return NULL;
 
+    if (nctx->fq_plan != NULL) {
+        len = sss_fq_plan_format(nctx->fq_plan, NULL, 0, args);
+        output = talloc_size(mem_ctx, len + 1);
+        if (output == NULL) {
+            errno = ENOMEM;
+            return NULL;
+        }
+
+        sss_fq_plan_format(nctx->fq_plan, output, len + 1, args);
+        return output;
+    }
+
     output = talloc_strdup(mem_ctx, "");
     if (safe_format_string_cb(safe_talloc_callback, &output, nctx->fq_fmt, args, 3) < 0)
         output = NULL;
@@ -628,8 +873,18 @@ int
 sss_fqname(char *str, size_t size, struct sss_names_ctx *nctx,
            struct sss_domain_info *domain, const char *name)
 {
+    const char *args[SSS_FQ_ARGS];
+
     if (domain == NULL || nctx == NULL) return -EINVAL;
 
+    if (nctx->fq_plan != NULL) {
+        args[0] = name;
+        args[1] = domain->name;
+        args[2] = calc_flat_name(domain);
+
+        return sss_fq_plan_format(nctx->fq_plan, str, size, args);
+    }
+
     return safe_format_string(str, size, nctx->fq_fmt,
                               name, domain->name, calc_flat_name (domain), NULL);
 }
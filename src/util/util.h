@@ -70,6 +70,7 @@ extern int debug_microseconds;
 extern int debug_to_file;
 extern int debug_to_stderr;
 extern const char *debug_log_file;
+extern int debug_ring_level;
 void debug_fn(const char *file,
               long line,
               const char *function,
@@ -78,6 +79,20 @@ void debug_fn(const char *file,
 int debug_convert_old_level(int old_level);
 errno_t set_debug_file_from_fd(const int fd);
 
+/* Buffered logging. Debug messages are formatted into an in-memory ring of
+ * the given size and written to the log in batches by debug_ring_flush().
+ * The notify function is called for each message waiting to be written,
+ * it is expected to schedule a flush.
+ *
+ * Messages with a level in debug_ring_level but not in debug_level are only
+ * traced in the ring without being formatted. debug_ring_dump() writes the
+ * traced messages which were not dumped yet to the log, it is called when
+ * a request fails. */
+errno_t debug_ring_init(size_t size);
+void debug_ring_set_notify(void (*fn)(void *pvt), void *pvt);
+void debug_ring_flush(void);
+void debug_ring_dump(const char *reason);
+
 #define SSS_DOM_ENV           "_SSS_DOM"
 
 #define SSSDBG_FATAL_FAILURE  0x0010   /* level 0 */
@@ -133,11 +148,19 @@ errno_t set_debug_file_from_fd(const int fd);
 } while (0)
 
 /** \def DEBUG_IS_SET(level)
+    \brief checks whether level is set in debug_level or debug_ring_level
+
+    \param level the debug level, please use one of the SSSDBG*_ macros
+*/
+#define DEBUG_IS_SET(level) (DEBUG_LEVEL_IS_SET(level) || \
+                             debug_ring_level & (level))
+
+/** \def DEBUG_LEVEL_IS_SET(level)
     \brief checks whether level is set in debug_level
 
     \param level the debug level, please use one of the SSSDBG*_ macros
 */
-#define DEBUG_IS_SET(level) (debug_level & (level) || \
+#define DEBUG_LEVEL_IS_SET(level) (debug_level & (level) || \
                             (debug_level == SSSDBG_UNRESOLVED && \
                                             (level & (SSSDBG_FATAL_FAILURE | \
                                                       SSSDBG_CRIT_FAILURE))))
@@ -277,11 +300,26 @@ int password_destructor(void *memctx);
 /* from usertools.c */
 char *get_uppercase_realm(TALLOC_CTX *memctx, const char *name);
 
+/* The built-in expressions are matched without pcre for the common forms
+ * of names */
+enum sss_names_re {
+    SSS_NAMES_RE_CUSTOM = 0,
+    SSS_NAMES_RE_DEFAULT,
+    SSS_NAMES_RE_IPA_AD
+};
+
+struct sss_fq_plan;
+
 struct sss_names_ctx {
     char *re_pattern;
     char *fq_fmt;
 
     pcre *re;
+
+    enum sss_names_re builtin_re;
+    /* fq_fmt split into literals and arguments, NULL if fq_fmt uses
+     * field widths, precisions or flags */
+    struct sss_fq_plan *fq_plan;
 };
 
 /* initialize sss_names_ctx directly from arguments */